@@ -0,0 +1,48 @@
+//
+//  CurveFitAdditions.swift
+//  DrawKitSwift
+//
+//  Copyright © 2026 DrawKit. All rights reserved.
+//
+
+import DKDrawKit.CurveFit
+
+extension NSBezierPath {
+	/// Fits the sample points with bezier curves, as `DKCurveFitPath` does for a flattened path,
+	/// but taking the samples directly from the array's contiguous storage - no intermediate path
+	/// is built and no point is boxed. Fewer than three points are returned as a straight polyline.
+	/// - parameter points: The sample points to fit, in order.
+	/// - parameter epsilon: The fitting tolerance.
+	/// - returns: A path of fitted curve segments.
+	public class func curveFitted(points: [NSPoint], epsilon: CGFloat) -> NSBezierPath {
+		return __DKCurveFitPoints(points, points.count, epsilon)
+	}
+
+	/// Creates a polyline path connecting the points in order, handing the array's contiguous
+	/// storage straight to AppKit rather than appending element by element.
+	/// - parameter points: The points to connect.
+	/// - parameter closed: Whether to close the path back to the first point.
+	public convenience init(polylineWithPoints points: [NSPoint], closed: Bool = false) {
+		self.init()
+		guard !points.isEmpty else {
+			return
+		}
+		points.withUnsafeBufferPointer { (buf) -> Void in
+			move(to: buf[0])
+			if buf.count > 1 {
+				appendPoints(UnsafeMutablePointer(mutating: buf.baseAddress! + 1), count: buf.count - 1)
+			}
+		}
+		if closed {
+			close()
+		}
+	}
+}
+
+extension DKIncrementalCurveFitter {
+	/// Appends a contiguous run of samples; equivalent to adding each point in turn with
+	/// `addPoint(_:)`, including the deduplication and incremental commits.
+	public func add(points: [NSPoint]) {
+		__addPoints(points, count: points.count)
+	}
+}
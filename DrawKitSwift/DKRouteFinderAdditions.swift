@@ -10,19 +10,37 @@ import DKDrawKit.DKRouteFinder
 
 
 extension DKRouteFinder {
-	
+
 	public convenience init?(arrayOfPoints: [NSPoint]) {
-		let arrayOFObjects = arrayOfPoints.map({NSValue(point: $0)})
-		self.init(__arrayOfPoints: arrayOFObjects)
+		// the array's contiguous storage is handed straight to the C-array entry point -
+		// no NSValue is ever created
+		self.init(__points: arrayOfPoints, count: arrayOfPoints.count)
+	}
+
+	/// Creates a route finder directly from a buffer of points, for callers that already hold
+	/// their data outside an `Array`. Fails for fewer than four points, as the array form does.
+	public convenience init?(points: UnsafeBufferPointer<NSPoint>) {
+		guard let base = points.baseAddress else {
+			return nil
+		}
+		self.init(__points: base, count: points.count)
 	}
-	
+
 	/// Returns the original points reordered into the shortest route.
 	public func shortestRoute() -> [NSPoint] {
-		return __shortestRoute().map({$0.pointValue})
+		var route = [NSPoint](repeating: .zero, count: pointCount)
+		route.withUnsafeMutableBufferPointer { (buf) -> Void in
+			__getShortestRoutePoints(buf.baseAddress!)
+		}
+		return route
 	}
-	
+
 	/// Returns a list of integers which specifies the shortest route between the original points.
 	public func shortestRouteOrder() -> [Int] {
-		return __shortestRouteOrder().map({$0.intValue})
+		var order = [Int](repeating: 0, count: pointCount)
+		order.withUnsafeMutableBufferPointer { (buf) -> Void in
+			__getShortestRouteOrder(buf.baseAddress!)
+		}
+		return order
 	}
 }
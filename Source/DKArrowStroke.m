@@ -441,20 +441,21 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 
 	NSBezierPath* shaft = inPath; // shaft of the arrow will become the new path
 
-	if (trimStart > 0.0)
-		shaft = [shaft bezierPathByTrimmingFromLength:trimStart];
+	// both end trims happen in one walk over the path rather than one rebuild per end
 
-	if (trimEnd > 0.0)
-		shaft = [shaft bezierPathByTrimmingToLength:[shaft length] - trimEnd];
+	if (trimStart > 0.0 || trimEnd > 0.0)
+		shaft = [shaft bezierPathByTrimmingFromLength:trimStart
+											 toLength:[shaft length] - trimStart - trimEnd];
 
 	// check that the path hasn't been trimmed to nothing
 
 	if (shaft == nil || [shaft elementCount] < 2 || [shaft length] <= 0.0)
 		return nil;
 
-	// copy the path at this point for use with later dimensioning text calculation
+	// copy the path at this point for use with later dimensioning text calculation. The copy is only
+	// needed within this render, so a recycled scratch path avoids the per-frame allocation
 
-	NSBezierPath* shaftCopy = [shaft copy];
+	NSBezierPath* shaftCopy = [DKRasterizer scratchPathWithPath:shaft];
 
 	// if the dimensioning options are for the dim text to be applied in line, a section of sufficient
 	// length needs to be knocked out of the middle of the path
@@ -466,6 +467,12 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 		shaft = [shaft bezierPathByTrimmingFromCentre:dimWidth + padding];
 	}
 
+	// the shaft is about to take on stroke attributes - if it is still the caller's path, switch to
+	// a scratch copy rather than mutating it
+
+	if (shaft == inPath)
+		shaft = [DKRasterizer scratchPathWithPath:inPath];
+
 	[shaft setLineWidth:[self width]];
 	[shaft setLineCapStyle:[self lineCapStyle]];
 	[shaft setLineJoinStyle:[self lineJoinStyle]];
@@ -798,6 +805,14 @@ NSString* const kDKDimensionUnitsKey = @"DKDimensionUnits";
 	}
 }
 
+- (BOOL)perturbsContextState
+{
+	// unlike DKStroke, the shadow is set directly on the context here without bracketing, relying
+	// on the containing group to restore it - so the group must keep its save/restore in place
+
+	return YES;
+}
+
 #pragma mark -
 #pragma mark As part of NSCoding Protocol
 
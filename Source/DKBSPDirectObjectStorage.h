@@ -26,12 +26,22 @@ NS_ASSUME_NONNULL_BEGIN
 	NSUInteger mTreeDepth;
 	NSUInteger mLastItemCount;
 	BOOL mAutoRebuild;
+	NSUInteger mConcurrentQueryThreshold;
 }
 
 - (void)setTreeDepth:(NSUInteger)aDepth;
 - (DKBSPDirectTree*)tree;
 - (NSBezierPath*)debugStorageDivisions;
 
+/** @brief Object count above which rect queries are performed concurrently.
+
+ When the storage holds at least this many objects, \c -objectsIntersectingRect:inView:options: splits the query
+ rect into vertical strips and descends the tree on multiple threads, merging the per-strip results before the
+ usual Z-sort. Below the threshold (or when set to 0, the default) the serial path is used, since the fork/join
+ overhead only pays off for dense layers.
+*/
+@property (nonatomic) NSUInteger concurrentQueryThreshold;
+
 @end
 
 #pragma mark -
@@ -58,6 +68,15 @@ NS_ASSUME_NONNULL_BEGIN
 - (nullable NSMutableArray*)objectsIntersectingRect:(NSRect)rect;
 - (nullable NSMutableArray*)objectsIntersectingPoint:(NSPoint)point;
 
+/** @brief As -objectsIntersectingRect:, but descends the tree from several threads at once.
+
+ The rect is split into one vertical strip per active core and each strip is searched concurrently via
+ \c dispatch_apply using the reentrant traversal, with each object claimed by exactly one strip so no locking or
+ marking is needed. Returns a freshly allocated array (unsorted; callers wanting Z-order must sort), unlike the
+ serial queries which return the tree's own reusable array. The tree must not be mutated during the call.
+*/
+- (nullable NSMutableArray*)concurrentObjectsIntersectingRect:(NSRect)rect;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -58,12 +58,26 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	return mTree;
 }
 
+@synthesize concurrentQueryThreshold = mConcurrentQueryThreshold;
+
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
 #pragma unused(options)
 
 	NSMutableArray* results;
 
+	if (mConcurrentQueryThreshold > 0 && [self countOfObjects] >= mConcurrentQueryThreshold) {
+		// dense layer - fan the query out across cores. The concurrent path doesn't use the view's update rects
+		// or the marked flags, so no unmarking is needed and the result is a fresh array.
+
+		results = [mTree concurrentObjectsIntersectingRect:aRect];
+
+		if ((options & kDKZOrderMayBeRelaxed) == 0)
+			[self sortObjectsByZ:results];
+
+		return results;
+	}
+
 	if (aView) {
 		const NSRect* rects;
 		NSInteger count;
@@ -241,6 +255,24 @@ static inline NSUInteger depthForObjectCount(NSUInteger n)
 	}
 }
 
+- (void)moveObjectsAtIndexes:(NSIndexSet*)set toIndex:(NSUInteger)indx
+{
+	[super moveObjectsAtIndexes:set
+						toIndex:indx];
+
+	// the tree holds the objects directly, so the only repair needed is one renumbering
+	// pass from the lowest affected position
+
+	if ([set count] > 0)
+		[self renumberObjectsFromIndex:MIN([set firstIndex], indx)];
+}
+
+- (void)applyObjectOrdering:(NSArray*)orderedObjects
+{
+	[super applyObjectOrdering:orderedObjects];
+	[self renumberObjectsFromIndex:0];
+}
+
 - (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
 {
 	[mTree removeItem:obj
@@ -557,6 +589,70 @@ static void unmarkFunc(const void* value, void* context)
 	return mObjectCount;
 }
 
+- (NSMutableArray*)concurrentObjectsIntersectingRect:(NSRect)rect
+{
+	if ([mNodes count] == 0)
+		return nil;
+
+	NSUInteger nStrips = MIN((NSUInteger)[[NSProcessInfo processInfo] activeProcessorCount], (NSUInteger)16);
+
+	if (nStrips < 1)
+		nStrips = 1;
+
+	CGFloat stripWidth = NSWidth(rect) / (CGFloat)nStrips;
+
+	// one result set per strip; each worker touches only its own, so no synchronisation is required. Sets are
+	// used because an object spanning several leaves within one strip would otherwise be accumulated repeatedly
+	// (the serial path handles this with the marked flag, which is not thread safe).
+
+	NSMutableArray* buckets = [NSMutableArray arrayWithCapacity:nStrips];
+	NSUInteger i;
+
+	for (i = 0; i < nStrips; ++i)
+		[buckets addObject:[NSMutableSet set]];
+
+	dispatch_apply(nStrips, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t stripIndex) {
+		NSRect strip = NSMakeRect(NSMinX(rect) + stripWidth * stripIndex, NSMinY(rect), stripWidth, NSHeight(rect));
+
+		if (stripIndex == nStrips - 1)
+			strip.size.width = NSMaxX(rect) - NSMinX(strip); // last strip absorbs any rounding
+
+		NSMutableSet* found = [buckets objectAtIndex:stripIndex];
+
+		[self searchWithRect:strip
+				  usingBlock:^(id leaf) {
+					  for (id<DKStorableObject> anObject in leaf) {
+						  if (![anObject visible])
+							  continue;
+
+						  NSRect bounds = [anObject bounds];
+
+						  if (!NSIntersectsRect(bounds, rect))
+							  continue;
+
+						  // each object is claimed by exactly one strip - the one containing its clamped origin -
+						  // so objects straddling a strip boundary are returned once
+
+						  CGFloat ownerX = MAX(NSMinX(bounds), NSMinX(rect));
+						  NSUInteger owner = (stripWidth > 0.0) ? (NSUInteger)((ownerX - NSMinX(rect)) / stripWidth) : 0;
+
+						  if (owner >= nStrips)
+							  owner = nStrips - 1;
+
+						  if (owner == stripIndex)
+							  [found addObject:anObject];
+					  }
+				  }];
+	});
+
+	NSMutableArray* results = [NSMutableArray array];
+
+	for (NSSet* bucket in buckets)
+		[results addObjectsFromArray:[bucket allObjects]];
+
+	return results;
+}
+
 #pragma mark -
 #pragma mark - as a DKBSPIndexTree
 
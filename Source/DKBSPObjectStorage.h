@@ -36,11 +36,67 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
 	DKBSPIndexTree* mTree;
 	NSUInteger mTreeDepth;
 	NSUInteger mLastItemCount;
+	BOOL mUsesFlatIndexBuffers;
+	BOOL mUsesIncrementalRebalancing;
+	BOOL mRebuildScheduled;
+	BOOL mAutoTunesDepth;
+	NSInteger mDepthBias; // learned depth adjustment applied on top of the object-count heuristic
+	NSUInteger mTuneSampleCount; // queries sampled since the last tuning evaluation
+	NSUInteger mTuneCandidateAccum; // total candidates handed back over those queries
 }
 
 - (void)setTreeDepth:(NSUInteger)aDepth;
 - (id)tree;
 
+/** @brief Returns a compact archive of the spatial index, suitable for saving with the document.
+
+ The archive records the tree's canvas size and depth together with the leaf index buffers and a cheap
+ checksum over the stored objects' bounds. The partitioning itself is fully determined by the canvas
+ size and depth, so it is not stored. Returns \c nil if no tree has been built yet.
+*/
+- (nullable NSData*)archivedSpatialIndexData;
+
+/** @brief Rebuilds the spatial index from an archive previously returned by <code>-archivedSpatialIndexData</code>.
+
+ The archive is validated against the objects currently stored - if its checksum does not match (the
+ objects have changed since the archive was made, or it belongs to a different document) the index is
+ left alone and \c NO is returned, in which case the tree is rebuilt by insertion as usual. On success
+ spatial queries are warm immediately, without re-inserting every object.
+*/
+- (BOOL)adoptSpatialIndexData:(NSData*)data;
+
+/** @brief Whether the tree's leaves are flat C index buffers instead of NSMutableIndexSets.
+
+ When YES, the storage builds a DKBSPFlatIndexTree, whose leaves are contiguous sorted index buffers unioned by
+ merging, so \c -objectsIntersectingRect:inView:options: never allocates Foundation collection objects on the
+ query path. Defaults to NO, which retains the original index set backed tree. Changing this rebuilds the tree.
+*/
+@property (nonatomic) BOOL usesFlatIndexBuffers;
+
+/** @brief Whether tree maintenance is performed incrementally rather than by synchronous full rebuilds.
+
+ Normally, when the object count drifts far enough that a different tree depth would be optimal, the entire tree
+ is rebuilt on the spot, which can stall editing in very large documents. When this is YES, individual edits only
+ ever adjust the affected indexes, and the re-partitioning to the new depth is coalesced and deferred to the end
+ of the current event cycle, so the cost of any single edit stays bounded regardless of document size. Bulk
+ insertions and removals likewise patch the affected index ranges instead of reloading the whole tree.
+ Defaults to NO.
+*/
+@property (nonatomic) BOOL usesIncrementalRebalancing;
+
+/** @brief Whether the storage tunes its tree depth from observed query behaviour.
+
+ The object-count heuristic picks a reasonable starting depth, but the best depth also depends on how
+ the document is actually used - tightly clustered objects want a finer partition than the count alone
+ suggests, sparse ones a coarser one. When this is YES (and the depth has not been pinned with
+ <code>-setTreeDepth:</code>), the storage samples the candidate count of each spatial query and,
+ once per sample window, nudges a depth bias up when typical queries return a large share of the
+ document (under-partitioned) or down when the leaves vastly outnumber the objects (over-partitioned,
+ so inserts and moves touch many near-empty leaves for no query benefit). Each adjustment is applied
+ through the deferred rebalance, so re-partitioning happens at idle, never mid-edit. Defaults to NO.
+*/
+@property (nonatomic) BOOL autoTunesDepth;
+
 @end
 
 #pragma mark -
@@ -78,16 +134,91 @@ typedef NS_ENUM(NSInteger, DKBSPOperation) {
 - (void)insertItemIndex:(NSUInteger)idx withRect:(NSRect)rect;
 - (void)removeItemIndex:(NSUInteger)idx withRect:(NSRect)rect;
 
+/** @brief Updates an item's leaf membership for a bounds change.
+
+ Descends the tree once with both rects, sharing the traversal where they fall the same way, and
+ modifies only the leaves the item is entering or leaving. Equivalent to a remove-and-reinsert but
+ linear in the number of changed leaves, so the per-frame updates of a drag are near-free.
+ \c oldRect must be the rect the item was last inserted or moved with.
+ */
+- (void)moveItemIndex:(NSUInteger)idx fromRect:(NSRect)oldRect toRect:(NSRect)newRect;
+
 - (nullable NSIndexSet*)itemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count;
 - (nullable NSIndexSet*)itemsIntersectingRect:(NSRect)rect;
 - (nullable NSIndexSet*)itemsIntersectingPoint:(NSPoint)point;
 
 - (void)shiftIndexesStartingAtIndex:(NSUInteger)startIndex by:(NSInteger)delta;
 
+/** @brief Serializes the per-leaf index buffers to data (leaf count, then each leaf's sorted indexes). */
+- (NSData*)leafIndexArchive;
+
+/** @brief Refills the (empty) leaves from data produced by <code>-leafIndexArchive</code>.
+
+ The tree must already have been built with the same depth the archive was made at. Returns \c NO if
+ the data is malformed or the leaf count does not match, in which case the tree should be discarded.
+*/
+- (BOOL)restoreLeafIndexesFromArchive:(NSData*)data;
+
+/** @brief Calls \c block once for every leaf whose partition intersects \c rect.
+
+ Unlike the -itemsIntersecting... methods this traversal keeps no state in the tree, so it is reentrant and may be
+ run from several threads at once provided the tree is not mutated while any traversal is in flight. Subclasses
+ use this to build concurrent queries on top of the shared partitioning.
+*/
+- (void)searchWithRect:(NSRect)rect usingBlock:(void(NS_NOESCAPE ^)(id leaf))block;
+
 - (NSBezierPath*)debugStorageDivisions;
 
 @end
 
+#pragma mark -
+
+/** @brief leaf object for DKBSPFlatIndexTree; a contiguous sorted buffer of item indexes.
+
+ this replaces NSMutableIndexSet at the leaves. Indexes are kept in a malloc'ed uint32 array in ascending order,
+ so a leaf can be unioned into a query result by a straightforward merge without creating any intermediate objects.
+ It implements the same primitive selectors the tree uses on its leaves (-addIndex:, -removeIndex: and
+ -shiftIndexesStartingAtIndex:by:) so the insertion/removal machinery is shared with the index set case.
+*/
+@interface DKBSPIndexBuffer : NSObject {
+@public
+	uint32_t* mIndexes;
+	NSUInteger mCount;
+	NSUInteger mCapacity;
+}
+
+@property (readonly) NSUInteger count;
+
+- (const uint32_t*)indexes;
+- (void)addIndex:(NSUInteger)indx;
+- (void)removeIndex:(NSUInteger)indx;
+- (void)shiftIndexesStartingAtIndex:(NSUInteger)startIndex by:(NSInteger)delta;
+- (void)removeAllIndexes;
+
+@end
+
+#pragma mark -
+
+/** @brief variant of DKBSPIndexTree whose leaves are flat sorted index buffers (DKBSPIndexBuffer).
+
+ query results are accumulated by merging leaf buffers into a reusable result buffer, so no index sets (or any
+ other Foundation collections) are touched while searching. The inherited -itemsIntersecting... methods still
+ return an index set for compatibility; clients on a hot path should call the -flatItems... variants, which
+ expose the raw sorted buffer directly. The buffer remains valid until the next query or tree mutation.
+*/
+@interface DKBSPFlatIndexTree : DKBSPIndexTree {
+@protected
+	uint32_t* mResultBuf;
+	uint32_t* mMergeScratch;
+	NSUInteger mResultCount;
+	NSUInteger mResultCapacity;
+}
+
+- (NSUInteger)flatItemsIntersectingRect:(NSRect)rect results:(const uint32_t* _Nullable* _Nonnull)results;
+- (NSUInteger)flatItemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count results:(const uint32_t* _Nullable* _Nonnull)results;
+
+@end
+
 #define kDKBSPSlack 48
 #define kDKMinimumDepth 10U
 #define kDKMaximumDepth 0U // set 0 for no limit
@@ -5,6 +5,10 @@
 */
 
 #import "DKBSPObjectStorage.h"
+#import "DKDrawKitMacros.h"
+#import "DKEventRingLog.h"
+#import "DKPerformanceCounters.h"
+#import "DKDrawableObject.h"
 #import "LogEvent.h"
 
 // utility functions:
@@ -19,11 +23,37 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	return (nodeIndex << 1) + 1;
 }
 
+// header of the spatial index archive (see -archivedSpatialIndexData). The partitioning is fully
+// determined by the canvas size and depth, so only those and the leaf contents need to be stored.
+
+#define kDKSpatialIndexArchiveVersion 1
+
+// depth auto-tuning: evaluate once per window of sampled queries; the learned bias is clamped so a
+// burst of unusual queries can never run the depth away from the count-derived baseline
+
+#define kDKDepthTuneSampleWindow 64
+#define kDKDepthBiasMin (-2)
+#define kDKDepthBiasMax 3
+
+typedef struct {
+	uint32_t version;
+	uint32_t depth;
+	Float64 canvasWidth;
+	Float64 canvasHeight;
+	uint64_t checksum;
+} DKSpatialIndexHeader;
+
 @interface DKBSPObjectStorage ()
 
 - (void)setDepthAndLoadTree:(NSUInteger)aDepth;
 - (void)loadBSPTree;
 - (BOOL)checkForTreeRebuild;
+- (Class)treeClass;
+- (void)scheduleDeferredRebalance;
+- (void)rebalanceTree;
+- (NSUInteger)spatialIndexChecksum;
+- (NSUInteger)dynamicTreeDepth;
+- (void)recordQuerySample:(NSUInteger)candidateCount;
 
 @end
 
@@ -50,10 +80,149 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	return mTree;
 }
 
+@synthesize usesFlatIndexBuffers = mUsesFlatIndexBuffers;
+
+- (void)setUsesFlatIndexBuffers:(BOOL)flat
+{
+	if (flat != mUsesFlatIndexBuffers) {
+		mUsesFlatIndexBuffers = flat;
+
+		// rebuild the tree with the appropriate leaf representation. If no tree exists yet, -setCanvasSize: will pick
+		// up the flag when it is first built.
+
+		if (mTree) {
+			NSSize size = [mTree canvasSize];
+			NSUInteger depth = (mTreeDepth == 0 ? [self dynamicTreeDepth] : mTreeDepth);
+
+			mTree = [[[self treeClass] alloc] initWithCanvasSize:size
+														   depth:depth];
+			[self loadBSPTree];
+		}
+	}
+}
+
+- (Class)treeClass
+{
+	return mUsesFlatIndexBuffers ? [DKBSPFlatIndexTree class] : [DKBSPIndexTree class];
+}
+
+@synthesize usesIncrementalRebalancing = mUsesIncrementalRebalancing;
+@synthesize autoTunesDepth = mAutoTunesDepth;
+
+- (NSUInteger)dynamicTreeDepth
+{
+	// the object-count heuristic plus the learned bias. The bias only participates while auto-tuning
+	// is on, and the result never drops below the minimum depth.
+
+	NSInteger depth = (NSInteger)MAX(depthForObjectCount([self countOfObjects]), kDKMinimumDepth);
+
+	if (mAutoTunesDepth)
+		depth += mDepthBias;
+
+	return (NSUInteger)MAX(depth, (NSInteger)kDKMinimumDepth);
+}
+
+- (void)recordQuerySample:(NSUInteger)candidateCount
+{
+	// accumulates the candidate counts the tree hands back and, once per window, decides whether the
+	// partitioning is pulling its weight. Adjustments go through the deferred rebalance so the
+	// re-partition happens when the run loop next goes idle, never in the middle of a query or edit.
+
+	mTuneCandidateAccum += candidateCount;
+
+	if (++mTuneSampleCount < kDKDepthTuneSampleWindow)
+		return;
+
+	NSUInteger avgCandidates = mTuneCandidateAccum / mTuneSampleCount;
+	NSUInteger count = [self countOfObjects];
+	NSUInteger leaves = [mTree countOfLeaves];
+
+	mTuneSampleCount = 0;
+	mTuneCandidateAccum = 0;
+
+	// a typical query returning a large share of the document means the leaves are too coarse to
+	// discriminate - go deeper. Leaves vastly outnumbering the objects means inserts and moves touch
+	// many near-empty leaves for no query benefit - go shallower.
+
+	if (avgCandidates > MAX((NSUInteger)kDKBSPSlack, count / 8)) {
+		if (mDepthBias < kDKDepthBiasMax) {
+			++mDepthBias;
+			[self scheduleDeferredRebalance];
+		}
+	} else if (leaves > (4 * MAX(count, 1U)) && mDepthBias > kDKDepthBiasMin) {
+		--mDepthBias;
+		[self scheduleDeferredRebalance];
+	}
+}
+
+- (void)scheduleDeferredRebalance
+{
+	// coalesces any number of rebuild triggers within one event cycle into a single re-partition performed
+	// when the run loop next goes idle
+
+	if (!mRebuildScheduled) {
+		mRebuildScheduled = YES;
+		[self performSelector:@selector(rebalanceTree)
+				   withObject:nil
+				   afterDelay:0.0];
+	}
+}
+
+- (void)rebalanceTree
+{
+	mRebuildScheduled = NO;
+
+	NSUInteger depth = [self dynamicTreeDepth];
+
+	[mTree setDepth:depth];
+	[self loadBSPTree];
+}
+
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
 #pragma unused(options)
 
+	if (mUsesFlatIndexBuffers && [mTree isKindOfClass:[DKBSPFlatIndexTree class]]) {
+		// fast path - iterates the raw sorted index buffer returned by the tree, so nothing is allocated until
+		// the (unavoidable) result array. Indexes are ascending so Z-order is preserved as for the normal path.
+
+		DKBSPFlatIndexTree* tree = (DKBSPFlatIndexTree*)mTree;
+		const uint32_t* items = NULL;
+		NSUInteger itemCount;
+
+		if (aView) {
+			const NSRect* rects;
+			NSInteger count;
+
+			[aView getRectsBeingDrawn:&rects
+								count:&count];
+			itemCount = [tree flatItemsIntersectingRects:rects
+												   count:count
+												 results:&items];
+		} else
+			itemCount = [tree flatItemsIntersectingRect:aRect
+												results:&items];
+
+		if (mAutoTunesDepth)
+			[self recordQuerySample:itemCount];
+
+		NSMutableArray* array = [NSMutableArray arrayWithCapacity:itemCount];
+		NSArray* allObjects = [self objects];
+		NSUInteger i;
+
+		for (i = 0; i < itemCount; ++i) {
+			id<DKStorableObject> obj = [allObjects objectAtIndex:items[i]];
+
+			if (aView) {
+				if ([aView needsToDrawRect:DKDrawableObjectBounds((DKDrawableObject*)obj)] && [(DKDrawableObject*)obj intersectsOrientedBounds:aRect])
+					[array addObject:obj];
+			} else if (NSIntersectsRect(aRect, DKDrawableObjectBounds((DKDrawableObject*)obj)) && [(DKDrawableObject*)obj intersectsOrientedBounds:aRect])
+				[array addObject:obj];
+		}
+
+		return array;
+	}
+
 	NSIndexSet* indexes;
 
 	if (aView) {
@@ -67,6 +236,9 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	} else
 		indexes = [mTree itemsIntersectingRect:aRect];
 
+	if (mAutoTunesDepth)
+		[self recordQuerySample:[indexes count]];
+
 	// ignore the options flags for now
 	// weed out any false positives which we don't need to draw. This is fairly common when the depth is low and the canvas isn't
 	// very finely divided. As depth increases this effect is diminished
@@ -75,10 +247,10 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 	for (id<DKStorableObject> obj in [[self objects] objectsAtIndexes:indexes]) {
 		if (aView) {
-			if ([aView needsToDrawRect:[obj bounds]]) {
+			if ([aView needsToDrawRect:DKDrawableObjectBounds((DKDrawableObject*)obj)] && [(DKDrawableObject*)obj intersectsOrientedBounds:aRect]) {
 				[array addObject:obj];
 			}
-		} else if (NSIntersectsRect(aRect, [obj bounds])) {
+		} else if (NSIntersectsRect(aRect, DKDrawableObjectBounds((DKDrawableObject*)obj)) && [(DKDrawableObject*)obj intersectsOrientedBounds:aRect]) {
 			[array addObject:obj];
 		}
 	}
@@ -97,7 +269,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	NSMutableArray* array = [NSMutableArray array];
 
 	for (id<DKStorableObject> obj in [[self objects] objectsAtIndexes:indexes]) {
-		if (NSPointInRect(aPoint, [obj bounds]))
+		if (NSPointInRect(aPoint, DKDrawableObjectBounds((DKDrawableObject*)obj)))
 			[array addObject:obj];
 	}
 
@@ -163,6 +335,33 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	[super insertObjects:objs
 			   atIndexes:set];
 
+	if (mUsesIncrementalRebalancing) {
+		// patch only the affected index ranges instead of reloading the whole tree. The set contains the final
+		// positions in ascending order, matching NSMutableArray's insertion semantics. Shifting is coalesced
+		// per contiguous range - one pass over the leaves per range, not one per object - which is what makes
+		// bulk imports (which append one large range) cheap on the storage side.
+
+		[set enumerateRangesUsingBlock:^(NSRange range, BOOL* stop) {
+#pragma unused(stop)
+			[mTree shiftIndexesStartingAtIndex:range.location
+											by:(NSInteger)range.length];
+		}];
+
+		__block NSUInteger k = 0;
+
+		[set enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) {
+#pragma unused(stop)
+			id<DKStorableObject> obj = [objs objectAtIndex:k++];
+
+			if ([obj visible])
+				[mTree insertItemIndex:idx
+							  withRect:[obj bounds]];
+		}];
+
+		[self checkForTreeRebuild];
+		return;
+	}
+
 	if (![self checkForTreeRebuild])
 		[self setDepthAndLoadTree:mTreeDepth];
 }
@@ -171,6 +370,23 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 {
 	// this may be expensive, as it rebuilds the entire tree due to the extensive renumbering of items
 
+	if (mUsesIncrementalRebalancing) {
+		// patch the tree before the array is renumbered; enumerating ranges in reverse keeps the remaining
+		// indexes valid. A left shift drops any indexes within the vacated span, so one pass per contiguous
+		// range both removes that range's items from the leaves and renumbers everything above it.
+
+		[set enumerateRangesWithOptions:NSEnumerationReverse
+							 usingBlock:^(NSRange range, BOOL* stop) {
+#pragma unused(stop)
+								 [mTree shiftIndexesStartingAtIndex:NSMaxRange(range)
+																 by:-(NSInteger)range.length];
+							 }];
+
+		[super removeObjectsAtIndexes:set];
+		[self checkForTreeRebuild];
+		return;
+	}
+
 	[super removeObjectsAtIndexes:set];
 
 	if (![self checkForTreeRebuild])
@@ -199,16 +415,36 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	}
 }
 
+- (void)moveObjectsAtIndexes:(NSIndexSet*)set toIndex:(NSUInteger)indx
+{
+	[super moveObjectsAtIndexes:set
+						toIndex:indx];
+
+	// a batch reorder renumbers most items, so one full reload of the tree is cheaper
+	// than patching indexes per object
+
+	if ([set count] > 0)
+		[self loadBSPTree];
+}
+
+- (void)applyObjectOrdering:(NSArray*)orderedObjects
+{
+	[super applyObjectOrdering:orderedObjects];
+	[self loadBSPTree];
+}
+
 - (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
 {
 	// n.b. only called if the bounds has actually changed, so we don't need to test that again
 
 	NSUInteger indx = [self indexOfObject:obj];
 	if ([obj visible]) {
-		[mTree removeItemIndex:indx
-					  withRect:oldBounds];
-		[mTree insertItemIndex:indx
-					  withRect:[obj bounds]];
+		// differential update - only leaves the object is entering or leaving are touched,
+		// which for the small bounds changes of a drag is typically none or very few
+
+		[mTree moveItemIndex:indx
+					fromRect:oldBounds
+					  toRect:[obj bounds]];
 	}
 }
 
@@ -230,16 +466,16 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	// is first created, and whenever the canvas size changes.
 
 	if (!NSEqualSizes(size, [mTree canvasSize])) {
-		NSUInteger depth = (mTreeDepth == 0 ? depthForObjectCount([self countOfObjects]) : mTreeDepth);
-		mTree = [[DKBSPIndexTree alloc] initWithCanvasSize:size
-													 depth:MAX(depth, kDKMinimumDepth)];
+		NSUInteger depth = (mTreeDepth == 0 ? [self dynamicTreeDepth] : mTreeDepth);
+		mTree = [[[self treeClass] alloc] initWithCanvasSize:size
+													   depth:MAX(depth, kDKMinimumDepth)];
 		[self loadBSPTree];
 	}
 }
 
 - (void)setDepthAndLoadTree:(NSUInteger)aDepth
 {
-	NSUInteger depth = (aDepth == 0 ? MAX(depthForObjectCount([self countOfObjects]), kDKMinimumDepth) : aDepth);
+	NSUInteger depth = (aDepth == 0 ? [self dynamicTreeDepth] : aDepth);
 
 	[mTree setDepth:MAX(depth, kDKMinimumDepth)];
 	[self loadBSPTree];
@@ -277,7 +513,15 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		if ([mTree countOfLeaves] == 0 || (oldDepth != neuDepth && ABS((NSInteger)mLastItemCount - (NSInteger)[self countOfObjects]) > kDKBSPSlack)) {
 			// sufficient cause to rebuild the tree
 
-			[mTree setDepth:neuDepth];
+			if (mUsesIncrementalRebalancing && [mTree countOfLeaves] > 0) {
+				// defer the re-partition; the current edit proceeds with the cheap per-index update against
+				// the existing (merely suboptimal) tree
+
+				[self scheduleDeferredRebalance];
+				return NO;
+			}
+
+			[mTree setDepth:[self dynamicTreeDepth]];
 			[self loadBSPTree];
 			return YES;
 		}
@@ -286,6 +530,80 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	return NO;
 }
 
+#pragma mark -
+#pragma mark - persisting the spatial index
+
+- (NSUInteger)spatialIndexChecksum
+{
+	// cheap structural checksum over the stored objects' bounds, used to validate an archived spatial
+	// index against the objects it was built from. Only visible objects participate, matching what the
+	// tree actually indexes.
+
+	NSUInteger cs = [self countOfObjects];
+
+	for (id<DKStorableObject> obj in [self objects]) {
+		if ([obj visible]) {
+			NSRect b = [obj bounds];
+
+			cs = (cs << 5) | (cs >> ((sizeof(NSUInteger) * 8) - 5));
+			cs ^= (NSUInteger)lround(b.origin.x) ^ ((NSUInteger)lround(b.origin.y) << 8) ^ ((NSUInteger)lround(b.size.width) << 16) ^ ((NSUInteger)lround(b.size.height) << 24);
+		}
+	}
+
+	return cs;
+}
+
+- (NSData*)archivedSpatialIndexData
+{
+	if (mTree == nil || [mTree countOfLeaves] == 0)
+		return nil;
+
+	DKSpatialIndexHeader hdr;
+
+	hdr.version = kDKSpatialIndexArchiveVersion;
+	hdr.depth = (uint32_t)lround(log2((CGFloat)[mTree countOfLeaves]));
+	hdr.canvasWidth = [mTree canvasSize].width;
+	hdr.canvasHeight = [mTree canvasSize].height;
+	hdr.checksum = [self spatialIndexChecksum];
+
+	NSMutableData* data = [NSMutableData dataWithBytes:&hdr
+												length:sizeof(hdr)];
+	[data appendData:[mTree leafIndexArchive]];
+
+	return data;
+}
+
+- (BOOL)adoptSpatialIndexData:(NSData*)data
+{
+	if ([data length] < sizeof(DKSpatialIndexHeader))
+		return NO;
+
+	DKSpatialIndexHeader hdr;
+	memcpy(&hdr, [data bytes], sizeof(hdr));
+
+	if (hdr.version != kDKSpatialIndexArchiveVersion)
+		return NO;
+
+	if (hdr.checksum != (uint64_t)[self spatialIndexChecksum])
+		return NO;
+
+	// the tree is rebuilt into a temporary so that a malformed archive cannot leave a half-filled
+	// index behind - on any failure the existing state is untouched
+
+	DKBSPIndexTree* tree = [[[self treeClass] alloc] initWithCanvasSize:NSMakeSize(hdr.canvasWidth, hdr.canvasHeight)
+																  depth:hdr.depth];
+
+	if (![tree restoreLeafIndexesFromArchive:[data subdataWithRange:NSMakeRange(sizeof(hdr), [data length] - sizeof(hdr))]])
+		return NO;
+
+	mTree = tree;
+	mLastItemCount = [self countOfObjects];
+
+	LogEvent_(kInfoEvent, @"%@ adopted archived spatial index, depth = %u, leaves = %lu", self, hdr.depth, (unsigned long)[mTree countOfLeaves]);
+
+	return YES;
+}
+
 #pragma mark -
 #pragma mark - as implementor of the NSCoding protocol
 
@@ -304,6 +622,13 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 #pragma mark -
 #pragma mark - as a NSObject
 
+- (void)dealloc
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self
+											 selector:@selector(rebalanceTree)
+											   object:nil];
+}
+
 @end
 
 #pragma mark -
@@ -359,6 +684,7 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 
 - (void)partition:(NSRect)rect depth:(NSUInteger)depth index:(NSUInteger)indx;
 - (void)recursivelySearchWithRect:(NSRect)rect index:(NSUInteger)indx;
+- (void)recursivelyMoveIndex:(NSUInteger)idx fromRect:(NSRect)oldRect toRect:(NSRect)newRect nodeIndex:(NSUInteger)indx hasOld:(BOOL)hasOld hasNew:(BOOL)hasNew;
 - (void)recursivelySearchWithPoint:(NSPoint)pt index:(NSUInteger)indx;
 - (void)operateOnLeaf:(id)leaf;
 - (void)removeNodesAndLeaves;
@@ -451,6 +777,24 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	[self removeIndex:idx];
 }
 
+- (void)moveItemIndex:(NSUInteger)idx fromRect:(NSRect)oldRect toRect:(NSRect)newRect
+{
+	// differential update for a bounds change: one descent carries both rects, shared for as long
+	// as they fall the same way, and only leaves the item is entering or leaving are modified.
+	// For the small per-frame moves of a drag the two leaf sets are nearly identical, so this
+	// touches a handful of leaves where remove-and-reinsert scanned every leaf in the tree.
+
+	if ([mNodes count] == 0)
+		return;
+
+	[self recursivelyMoveIndex:idx
+					  fromRect:oldRect
+						toRect:newRect
+					 nodeIndex:0
+						hasOld:YES
+						hasNew:YES];
+}
+
 - (NSIndexSet*)itemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count
 {
 	// this may be used in conjunction with NSView's -getRectsBeingDrawn:count: to find those objects that intersect the non-rectangular update region.
@@ -458,6 +802,10 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	if ([mNodes count] == 0)
 		return nil;
 
+	DK_SIGNPOST_BEGIN("DKBSPIndexTree query", self, "rects=%lu", (unsigned long)count);
+
+	uint64_t queryStart = DKPerfTimeNow();
+
 	mOp = kDKOperationAccumulate;
 	[mResults removeAllIndexes];
 
@@ -467,6 +815,11 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 		[self recursivelySearchWithRect:rects[i]
 								  index:0];
 
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryCount, 1);
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryNanos, DKPerfTimeSince(queryStart));
+
+	DK_SIGNPOST_END("DKBSPIndexTree query", self, "hits=%lu", (unsigned long)[mResults count]);
+
 	return mResults;
 }
 
@@ -475,11 +828,22 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	if ([mNodes count] == 0)
 		return nil;
 
+	DK_SIGNPOST_BEGIN("DKBSPIndexTree query", self, "rect={{%g,%g},{%g,%g}}", rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+
+	uint64_t queryStart = DKPerfTimeNow();
+
 	mOp = kDKOperationAccumulate;
 	[mResults removeAllIndexes];
 
 	[self recursivelySearchWithRect:rect
 							  index:0];
+
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryCount, 1);
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryNanos, DKPerfTimeSince(queryStart));
+	DKEventLog_(kDKEventLogCategorySpatial, kDKEventLogCodeSpatialQuery, DKPerfTimeSince(queryStart), [mResults count]);
+
+	DK_SIGNPOST_END("DKBSPIndexTree query", self, "hits=%lu", (unsigned long)[mResults count]);
+
 	return mResults;
 }
 
@@ -488,11 +852,21 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 	if ([mNodes count] == 0)
 		return nil;
 
+	DK_SIGNPOST_BEGIN("DKBSPIndexTree query", self, "point={%g,%g}", point.x, point.y);
+
+	uint64_t queryStart = DKPerfTimeNow();
+
 	mOp = kDKOperationAccumulate;
 	[mResults removeAllIndexes];
 
 	[self recursivelySearchWithPoint:point
 							   index:0];
+
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryCount, 1);
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryNanos, DKPerfTimeSince(queryStart));
+
+	DK_SIGNPOST_END("DKBSPIndexTree query", self, "hits=%lu", (unsigned long)[mResults count]);
+
 	return mResults;
 }
 
@@ -511,6 +885,93 @@ static inline NSUInteger childNodeAtIndex(NSUInteger nodeIndex)
 										  by:delta];
 }
 
+- (NSData*)leafIndexArchive
+{
+	// serializes the leaf contents only - the node structure is regenerated from the canvas size and
+	// depth when the archive is restored. Works for either leaf representation; indexes are written
+	// in ascending order in both cases.
+
+	NSMutableData* data = [NSMutableData data];
+	uint64_t leafCount = [mLeaves count];
+
+	[data appendBytes:&leafCount
+			   length:sizeof(leafCount)];
+
+	for (id leaf in mLeaves) {
+		if ([leaf isKindOfClass:[DKBSPIndexBuffer class]]) {
+			DKBSPIndexBuffer* buf = (DKBSPIndexBuffer*)leaf;
+			uint64_t n = [buf count];
+
+			[data appendBytes:&n
+					   length:sizeof(n)];
+			[data appendBytes:[buf indexes]
+					   length:(NSUInteger)n * sizeof(uint32_t)];
+		} else {
+			NSIndexSet* set = (NSIndexSet*)leaf;
+			uint64_t n = [set count];
+
+			[data appendBytes:&n
+					   length:sizeof(n)];
+			[set enumerateIndexesUsingBlock:^(NSUInteger idx, BOOL* stop) {
+#pragma unused(stop)
+				uint32_t v = (uint32_t)idx;
+
+				[data appendBytes:&v
+						   length:sizeof(v)];
+			}];
+		}
+	}
+
+	return data;
+}
+
+- (BOOL)restoreLeafIndexesFromArchive:(NSData*)data
+{
+	const uint8_t* p = [data bytes];
+	NSUInteger remaining = [data length];
+	uint64_t leafCount;
+
+	if (remaining < sizeof(leafCount))
+		return NO;
+
+	memcpy(&leafCount, p, sizeof(leafCount));
+	p += sizeof(leafCount);
+	remaining -= sizeof(leafCount);
+
+	if (leafCount != (uint64_t)[mLeaves count])
+		return NO;
+
+	for (id leaf in mLeaves) {
+		uint64_t n;
+
+		if (remaining < sizeof(n))
+			return NO;
+
+		memcpy(&n, p, sizeof(n));
+		p += sizeof(n);
+		remaining -= sizeof(n);
+
+		if (remaining < (NSUInteger)n * sizeof(uint32_t))
+			return NO;
+
+		// both leaf representations implement -addIndex:, and ascending insertion is the cheap case
+		// for each of them
+
+		uint64_t i;
+		uint32_t v;
+
+		for (i = 0; i < n; ++i) {
+			memcpy(&v, p, sizeof(v));
+			p += sizeof(v);
+			[leaf addIndex:v];
+		}
+
+		remaining -= (NSUInteger)n * sizeof(uint32_t);
+	}
+
+	return remaining == 0;
+}
+
 - (NSBezierPath*)debugStorageDivisions
 {
 	// returns a path consisting of all the BSP rect divisions
@@ -655,6 +1116,129 @@ static NSUInteger sLeafCount = 0;
 	}
 }
 
+- (void)recursivelyMoveIndex:(NSUInteger)idx fromRect:(NSRect)oldRect toRect:(NSRect)newRect nodeIndex:(NSUInteger)indx hasOld:(BOOL)hasOld hasNew:(BOOL)hasNew
+{
+	// the child predicates mirror -recursivelySearchWithRect:index: exactly: the low child is
+	// entered when the rect's min ordinate is below the split, the high child when its max
+	// ordinate reaches it
+
+	DKBSPNode* node = [mNodes objectAtIndex:indx];
+	NSUInteger subnode = childNodeAtIndex(indx);
+
+	switch (node->mType) {
+	case kNodeLeaf: {
+		id leaf = [mLeaves objectAtIndex:node->u.mIndex];
+
+		if (hasOld && !hasNew)
+			[leaf removeIndex:idx];
+		else if (hasNew && !hasOld)
+			[leaf addIndex:idx];
+	} break;
+
+	case kNodeHorizontal: {
+		BOOL oldLo = hasOld && NSMinY(oldRect) < node->u.mOffset;
+		BOOL oldHi = hasOld && NSMaxY(oldRect) >= node->u.mOffset;
+		BOOL newLo = hasNew && NSMinY(newRect) < node->u.mOffset;
+		BOOL newHi = hasNew && NSMaxY(newRect) >= node->u.mOffset;
+
+		if (oldLo || newLo)
+			[self recursivelyMoveIndex:idx
+							  fromRect:oldRect
+								toRect:newRect
+							 nodeIndex:subnode
+								hasOld:oldLo
+								hasNew:newLo];
+		if (oldHi || newHi)
+			[self recursivelyMoveIndex:idx
+							  fromRect:oldRect
+								toRect:newRect
+							 nodeIndex:subnode + 1
+								hasOld:oldHi
+								hasNew:newHi];
+	} break;
+
+	case kNodeVertical: {
+		BOOL oldLo = hasOld && NSMinX(oldRect) < node->u.mOffset;
+		BOOL oldHi = hasOld && NSMaxX(oldRect) >= node->u.mOffset;
+		BOOL newLo = hasNew && NSMinX(newRect) < node->u.mOffset;
+		BOOL newHi = hasNew && NSMaxX(newRect) >= node->u.mOffset;
+
+		if (oldLo || newLo)
+			[self recursivelyMoveIndex:idx
+							  fromRect:oldRect
+								toRect:newRect
+							 nodeIndex:subnode
+								hasOld:oldLo
+								hasNew:newLo];
+		if (oldHi || newHi)
+			[self recursivelyMoveIndex:idx
+							  fromRect:oldRect
+								toRect:newRect
+							 nodeIndex:subnode + 1
+								hasOld:oldHi
+								hasNew:newHi];
+	} break;
+
+	default:
+		break;
+	}
+}
+
+- (void)searchWithRect:(NSRect)rect usingBlock:(void (NS_NOESCAPE ^)(id))block
+{
+	if ([mNodes count] > 0)
+		[self searchWithRect:rect
+					   index:0
+				  usingBlock:block];
+}
+
+- (void)searchWithRect:(NSRect)rect index:(NSUInteger)indx usingBlock:(void (NS_NOESCAPE ^)(id))block
+{
+	// stateless counterpart of -recursivelySearchWithRect:index: - safe for concurrent read-only traversal
+
+	DKBSPNode* node = [mNodes objectAtIndex:indx];
+	NSUInteger subnode = childNodeAtIndex(indx);
+
+	switch (node->mType) {
+	case kNodeHorizontal:
+		if (NSMinY(rect) < node->u.mOffset) {
+			[self searchWithRect:rect
+						   index:subnode
+					  usingBlock:block];
+			if (NSMaxY(rect) >= node->u.mOffset)
+				[self searchWithRect:rect
+							   index:subnode + 1
+						  usingBlock:block];
+		} else
+			[self searchWithRect:rect
+						   index:subnode + 1
+					  usingBlock:block];
+		break;
+
+	case kNodeVertical:
+		if (NSMinX(rect) < node->u.mOffset) {
+			[self searchWithRect:rect
+						   index:subnode
+					  usingBlock:block];
+			if (NSMaxX(rect) >= node->u.mOffset)
+				[self searchWithRect:rect
+							   index:subnode + 1
+						  usingBlock:block];
+		} else
+			[self searchWithRect:rect
+						   index:subnode + 1
+					  usingBlock:block];
+		break;
+
+	case kNodeLeaf:
+		block([mLeaves objectAtIndex:node->u.mIndex]);
+		break;
+
+	default:
+		break;
+	}
+}
+
 - (void)recursivelySearchWithPoint:(NSPoint)pt index:(NSUInteger)indx
 {
 	DKBSPNode* node = [mNodes objectAtIndex:indx];
@@ -744,3 +1328,277 @@ static NSUInteger sLeafCount = 0;
 }
 
 @end
+
+#pragma mark -
+
+@implementation DKBSPIndexBuffer
+
+@synthesize count = mCount;
+
+- (const uint32_t*)indexes
+{
+	return mIndexes;
+}
+
+- (void)growToCapacity:(NSUInteger)newCapacity
+{
+	if (newCapacity > mCapacity) {
+		mCapacity = MAX(newCapacity, mCapacity * 2);
+		if (mCapacity < 16)
+			mCapacity = 16;
+		mIndexes = (uint32_t*)reallocf(mIndexes, mCapacity * sizeof(uint32_t));
+	}
+}
+
+- (NSUInteger)lowerBoundOfIndex:(uint32_t)indx
+{
+	// binary search; returns the position of the first stored index >= <indx>
+
+	NSUInteger lo = 0, hi = mCount;
+
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) >> 1;
+
+		if (mIndexes[mid] < indx)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+- (void)addIndex:(NSUInteger)indx
+{
+	NSUInteger pos = [self lowerBoundOfIndex:(uint32_t)indx];
+
+	if (pos < mCount && mIndexes[pos] == (uint32_t)indx)
+		return; // already present
+
+	[self growToCapacity:mCount + 1];
+	memmove(&mIndexes[pos + 1], &mIndexes[pos], (mCount - pos) * sizeof(uint32_t));
+	mIndexes[pos] = (uint32_t)indx;
+	++mCount;
+}
+
+- (void)removeIndex:(NSUInteger)indx
+{
+	NSUInteger pos = [self lowerBoundOfIndex:(uint32_t)indx];
+
+	if (pos < mCount && mIndexes[pos] == (uint32_t)indx) {
+		memmove(&mIndexes[pos], &mIndexes[pos + 1], (mCount - pos - 1) * sizeof(uint32_t));
+		--mCount;
+	}
+}
+
+- (void)shiftIndexesStartingAtIndex:(NSUInteger)startIndex by:(NSInteger)delta
+{
+	// mirrors NSMutableIndexSet's method of the same name. As the buffer is sorted, shifting preserves the ordering
+	// so the indexes can be adjusted in place.
+
+	NSUInteger pos = [self lowerBoundOfIndex:(uint32_t)startIndex];
+
+	if (delta < 0) {
+		// a left shift deletes any indexes within the span being vacated - the range of length
+		// |delta| preceding startIndex - exactly as NSMutableIndexSet does
+
+		NSUInteger span = (NSUInteger)(-delta);
+		NSUInteger floorIndex = (startIndex > span) ? startIndex - span : 0;
+		NSUInteger first = [self lowerBoundOfIndex:(uint32_t)floorIndex];
+
+		if (pos > first) {
+			memmove(&mIndexes[first], &mIndexes[pos], (mCount - pos) * sizeof(uint32_t));
+			mCount -= (pos - first);
+			pos = first;
+		}
+	}
+
+	NSUInteger i;
+
+	for (i = pos; i < mCount; ++i)
+		mIndexes[i] = (uint32_t)((NSInteger)mIndexes[i] + delta);
+}
+
+- (void)removeAllIndexes
+{
+	mCount = 0;
+}
+
+- (void)dealloc
+{
+	if (mIndexes)
+		free(mIndexes);
+}
+
+- (NSString*)description
+{
+	return [NSString stringWithFormat:@"<%@ %p>, %lu indexes", NSStringFromClass([self class]), self, (unsigned long)mCount];
+}
+
+@end
+
+#pragma mark -
+
+@implementation DKBSPFlatIndexTree
+
++ (Class)leafClass
+{
+	return [DKBSPIndexBuffer class];
+}
+
+- (NSUInteger)flatItemsIntersectingRect:(NSRect)rect results:(const uint32_t**)results
+{
+	return [self flatItemsIntersectingRects:&rect
+									  count:1
+									results:results];
+}
+
+- (NSUInteger)flatItemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count results:(const uint32_t**)results
+{
+	NSAssert(results != NULL, @"results pointer cannot be NULL");
+
+	*results = NULL;
+	mResultCount = 0;
+
+	if ([mNodes count] == 0)
+		return 0;
+
+	DK_SIGNPOST_BEGIN("DKBSPIndexTree query", self, "rects=%lu", (unsigned long)count);
+
+	uint64_t queryStart = DKPerfTimeNow();
+
+	mOp = kDKOperationAccumulate;
+
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i)
+		[self recursivelySearchWithRect:rects[i]
+								  index:0];
+
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryCount, 1);
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryNanos, DKPerfTimeSince(queryStart));
+	DKEventLog_(kDKEventLogCategorySpatial, kDKEventLogCodeSpatialQuery, DKPerfTimeSince(queryStart), mResultCount);
+
+	DK_SIGNPOST_END("DKBSPIndexTree query", self, "hits=%lu", (unsigned long)mResultCount);
+
+	*results = mResultBuf;
+	return mResultCount;
+}
+
+- (void)operateOnLeaf:(id)leaf
+{
+	// accumulation merges the leaf's sorted buffer with the (sorted) results gathered so far; insertion and
+	// deletion are handled by the superclass, whose leaf selectors DKBSPIndexBuffer also implements.
+
+	if (mOp != kDKOperationAccumulate) {
+		[super operateOnLeaf:leaf];
+		return;
+	}
+
+	DKBSPIndexBuffer* buf = (DKBSPIndexBuffer*)leaf;
+	NSUInteger leafCount = buf->mCount;
+
+	if (leafCount == 0)
+		return;
+
+	NSUInteger need = mResultCount + leafCount;
+
+	if (need > mResultCapacity) {
+		mResultCapacity = MAX(need, mResultCapacity * 2);
+		if (mResultCapacity < 64)
+			mResultCapacity = 64;
+		mResultBuf = (uint32_t*)reallocf(mResultBuf, mResultCapacity * sizeof(uint32_t));
+		mMergeScratch = (uint32_t*)reallocf(mMergeScratch, mResultCapacity * sizeof(uint32_t));
+	}
+
+	// classic set-union by merge, skipping duplicates
+
+	const uint32_t* a = mResultBuf;
+	const uint32_t* b = buf->mIndexes;
+	uint32_t* out = mMergeScratch;
+	NSUInteger ia = 0, ib = 0, n = 0;
+
+	while (ia < mResultCount && ib < leafCount) {
+		if (a[ia] < b[ib])
+			out[n++] = a[ia++];
+		else if (a[ia] > b[ib])
+			out[n++] = b[ib++];
+		else {
+			out[n++] = a[ia++];
+			++ib;
+		}
+	}
+
+	while (ia < mResultCount)
+		out[n++] = a[ia++];
+
+	while (ib < leafCount)
+		out[n++] = b[ib++];
+
+	// swap the scratch and result buffers rather than copying back
+
+	uint32_t* temp = mResultBuf;
+	mResultBuf = mMergeScratch;
+	mMergeScratch = temp;
+	mResultCount = n;
+}
+
+- (NSIndexSet*)itemsIntersectingRects:(const NSRect*)rects count:(NSUInteger)count
+{
+	// compatibility with clients expecting an index set; hot paths should prefer the -flatItems... forms
+
+	const uint32_t* items;
+	NSUInteger n = [self flatItemsIntersectingRects:rects
+											  count:count
+											results:&items];
+
+	[mResults removeAllIndexes];
+
+	NSUInteger i;
+
+	for (i = 0; i < n; ++i)
+		[mResults addIndex:items[i]];
+
+	return mResults;
+}
+
+- (NSIndexSet*)itemsIntersectingRect:(NSRect)rect
+{
+	return [self itemsIntersectingRects:&rect
+								  count:1];
+}
+
+- (NSIndexSet*)itemsIntersectingPoint:(NSPoint)point
+{
+	if ([mNodes count] == 0)
+		return nil;
+
+	uint64_t queryStart = DKPerfTimeNow();
+
+	mResultCount = 0;
+	mOp = kDKOperationAccumulate;
+	[self recursivelySearchWithPoint:point
+							   index:0];
+
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryCount, 1);
+	DKPerfCounterAdd(&gDKPerfCounters.spatialQueryNanos, DKPerfTimeSince(queryStart));
+
+	[mResults removeAllIndexes];
+
+	NSUInteger i;
+
+	for (i = 0; i < mResultCount; ++i)
+		[mResults addIndex:mResultBuf[i]];
+
+	return mResults;
+}
+
+- (void)dealloc
+{
+	if (mResultBuf)
+		free(mResultBuf);
+	if (mMergeScratch)
+		free(mMergeScratch);
+}
+
+@end
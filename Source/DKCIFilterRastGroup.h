@@ -7,6 +7,8 @@
 #import <Cocoa/Cocoa.h>
 #import "DKRastGroup.h"
 
+@class CIContext;
+
 NS_ASSUME_NONNULL_BEGIN
 
 /** @brief Captures the output of its contained renderers in an image
@@ -19,10 +21,29 @@ NS_ASSUME_NONNULL_BEGIN
 	NSString* m_filter;
 	NSDictionary<NSString*, id>* m_arguments;
 	NSImage* m_cache;
+	NSString* m_cacheKey; // validity key for m_cache - filter, arguments, geometry and style timestamp
 }
 
 + (instancetype)effectGroupWithFilter:(NSString*)filter;
 
+/** @brief The framework-wide Core Image context used for all filter rendering.
+
+ Each \c NSGraphicsContext lazily creates a private \c CIContext on first use, and the filter capture
+ here runs inside a fresh offscreen focus lock, so without sharing every filtered draw paid context
+ creation - and the first draw per filter paid shader compilation - over again. All filter output is
+ rendered through this one context instead.
+ */
++ (CIContext*)sharedCIContext;
+
+/** @brief Precompiles the named Core Image filters in the background.
+
+ Pushes each named filter through the shared context once against a tiny scratch image on a
+ low-priority queue, forcing shader compilation off the main thread so the first real draw does not
+ hitch. Filters are warmed automatically as styles naming them are set up or decoded; call this
+ directly to warm additional filters ahead of need. Names already warmed are skipped.
+ */
++ (void)warmUpFiltersNamed:(NSArray<NSString*>*)filterNames;
+
 @property (nonatomic, copy) NSString* filter;
 
 @property (copy, nullable) NSDictionary<NSString*, id>* arguments;
@@ -6,7 +6,9 @@
 
 #import "DKCIFilterRastGroup.h"
 
+#import "DKDiskRenderCache.h"
 #import "DKDrawableObject.h"
+#import "DKStyle.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
 #import "NSDictionary+DeepCopy.h"
@@ -24,6 +26,76 @@
 	return fg;
 }
 
++ (CIContext*)sharedCIContext
+{
+	static CIContext* sSharedContext = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		CGColorSpaceRef space = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+
+		sSharedContext = [CIContext contextWithOptions:@{ kCIContextWorkingColorSpace: (__bridge id)space,
+			kCIContextOutputColorSpace: (__bridge id)space }];
+		CGColorSpaceRelease(space);
+	});
+
+	return sSharedContext;
+}
+
++ (void)warmUpFiltersNamed:(NSArray<NSString*>*)filterNames
+{
+	static NSMutableSet* sWarmedFilters = nil;
+	static dispatch_queue_t sWarmUpQueue = NULL;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sWarmedFilters = [[NSMutableSet alloc] init];
+		sWarmUpQueue = dispatch_queue_create("net.apptree.drawkit.cifilterwarmup", DISPATCH_QUEUE_SERIAL);
+		dispatch_set_target_queue(sWarmUpQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+	});
+
+	for (NSString* name in filterNames) {
+		dispatch_async(sWarmUpQueue, ^{
+			if ([sWarmedFilters containsObject:name])
+				return;
+
+			[sWarmedFilters addObject:name];
+
+			@autoreleasepool {
+				@try {
+					CIFilter* filter = [CIFilter filterWithName:name];
+
+					if (filter == nil)
+						return;
+
+					[filter setDefaults];
+
+					if ([[filter inputKeys] containsObject:@"inputImage"]) {
+						CIImage* scratch = [CIImage imageWithColor:[CIColor colorWithRed:0.5
+																				   green:0.5
+																					blue:0.5]];
+						[filter setValue:[scratch imageByCroppingToRect:CGRectMake(0, 0, 16, 16)]
+								  forKey:@"inputImage"];
+					}
+
+					CIImage* output = [filter valueForKey:@"outputImage"];
+
+					if (output != nil) {
+						CGImageRef img = [[self sharedCIContext] createCGImage:output
+																	  fromRect:CGRectMake(0, 0, 16, 16)];
+						CGImageRelease(img);
+
+						LogEvent_(kInfoEvent, @"warmed up CI filter: %@", name);
+					}
+				}
+				@catch (NSException* e) {
+					LogEvent_(kWheneverEvent, @"exception during warm-up of CI filter %@: %@", name, e);
+				}
+			}
+		});
+	}
+}
+
 #pragma mark -
 - (void)setFilter:(NSString*)filter
 {
@@ -33,6 +105,12 @@
 		m_filter = [filter copy];
 
 		[self invalidateCache];
+
+		// kick off background shader compilation so the first draw doesn't hitch. Since decoding
+		// a document's styles passes through here, existing documents warm their filters on open
+
+		if (filter != nil)
+			[DKCIFilterRastGroup warmUpFiltersNamed:@[filter]];
 	}
 }
 
@@ -43,6 +121,7 @@
 - (void)invalidateCache
 {
 	m_cache = nil;
+	m_cacheKey = nil;
 }
 
 #pragma mark -
@@ -102,9 +181,47 @@
 
 	NSRect imgRect = NSInsetRect(br, -extra.width, -extra.height);
 
-	if (m_cache) {
+	// the filtered output is cached and simply composited on subsequent draws, so the capture and Core Image
+	// round-trip are only paid when something that affects the result changes. The key folds in the filter and
+	// its arguments, the captured geometry and the owning style's modification timestamp - the style bumps the
+	// timestamp on any change to its component rasterizers, which covers edits to the group's content.
+
+	NSTimeInterval styleModTime = 0.0;
+	DKRastGroup* root = [self root];
+
+	if ([root isKindOfClass:[DKStyle class]])
+		styleModTime = [(DKStyle*)root lastModificationTimestamp];
+
+	NSString* cacheKey = [NSString stringWithFormat:@"%@.%lu.%f.%.1f.%.1f.%.3f.%.3f", [self filter], (unsigned long)[[[self arguments] description] hash], styleModTime, imgRect.size.width, imgRect.size.height, [object offset].width, [object offset].height];
+
+	NSRect fr = NSZeroRect;
+	fr.size = imgRect.size;
+
+	// the filter may spill its output up to CIIMAGE_PADDING beyond the captured rect (see NSBitmapImageRep
+	// (CoreImage)), so the cached canvas is padded by the same amount to preserve the spill
+
+	NSRect padRect = NSInsetRect(fr, -CIIMAGE_PADDING, -CIIMAGE_PADDING);
+
+	// a previous launch may have banked this output on disk. The fingerprint extends the in-memory
+	// key with the path's length and element count, tightening the match to the actual captured
+	// geometry rather than just its bounding size.
+
+	NSString* fingerprint = [NSString stringWithFormat:@"DKCIFilterRastGroup.%@.%.1f.%ld", cacheKey, [path length], (long)[path elementCount]];
 
-	} else {
+	if (m_cache == nil || ![cacheKey isEqualToString:m_cacheKey]) {
+		NSData* banked = [[DKDiskRenderCache sharedCache] dataForFingerprint:fingerprint];
+
+		if (banked != nil) {
+			NSImage* restored = [[NSImage alloc] initWithData:banked];
+
+			if (restored != nil) {
+				m_cache = restored;
+				m_cacheKey = [cacheKey copy];
+			}
+		}
+	}
+
+	if (m_cache == nil || ![cacheKey isEqualToString:m_cacheKey]) {
 		NSImage* image = [[NSImage alloc] initWithSize:imgRect.size];
 
 		NSAffineTransform* tfm = [NSAffineTransform transform];
@@ -123,26 +240,7 @@
 
 		[image unlockFocus];
 
-		// captured, now render it back to the drawing, applying the filter
-
-		NSRect fr = NSZeroRect;
-		fr.size = imgRect.size;
-
-		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-			switch ([self clipping])
-		{
-		default:
-		case kDKClippingNone:
-			break;
-
-		case kDKClippingInsidePath:
-			[path addClip];
-			break;
-
-		case kDKClippingOutsidePath:
-			[path addInverseClip];
-			break;
-		}
+		// captured, now apply the filter once into the cache image
 
 		NSArray* inputKeys = [[CIFilter filterWithName:[self filter]] inputKeys];
 
@@ -166,13 +264,56 @@
 					 forKey:@"inputCenter"];
 		}
 
-		[image drawInRect:imgRect
+		NSImage* output = [[NSImage alloc] initWithSize:padRect.size];
+
+		[output lockFocusFlipped:YES];
+		[image drawInRect:NSMakeRect(CIIMAGE_PADDING, CIIMAGE_PADDING, fr.size.width, fr.size.height)
 				   fromRect:fr
 			coreImageFilter:[self filter]
 				  arguments:args];
+		[output unlockFocus];
+
+		m_cache = output;
+		m_cacheKey = [cacheKey copy];
 
-		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+		// bank the output for the next launch. The PNG encode is paid once here, alongside the far
+		// larger Core Image cost it saves next time; the disk write itself is asynchronous.
+
+		NSBitmapImageRep* rep = [NSBitmapImageRep imageRepWithData:[output TIFFRepresentation]];
+		NSData* png = [rep representationUsingType:NSPNGFileType
+										properties:@{}];
+
+		if (png != nil)
+			[[DKDiskRenderCache sharedCache] storeData:png
+										forFingerprint:fingerprint];
 	}
+
+	// composite the cached output back to the drawing
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+		switch ([self clipping])
+	{
+	default:
+	case kDKClippingNone:
+		break;
+
+	case kDKClippingInsidePath:
+		[path addClip];
+		break;
+
+	case kDKClippingOutsidePath:
+		[path addInverseClip];
+		break;
+	}
+
+	[m_cache drawInRect:NSInsetRect(imgRect, -CIIMAGE_PADDING, -CIIMAGE_PADDING)
+			   fromRect:NSMakeRect(0, 0, padRect.size.width, padRect.size.height)
+			  operation:NSCompositeSourceOver
+			   fraction:1.0
+		 respectFlipped:YES
+				  hints:nil];
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 }
 
 #pragma mark -
@@ -284,6 +425,35 @@
 @end
 
 #pragma mark -
+
+/** renders \c image into \c destRect of the current context via the framework's shared CIContext.
+ Rendering goes through \c createCGImage:fromRect: rather than the per-NSGraphicsContext CIContext,
+ so every draw - including captures inside offscreen focus locks - reuses the same compiled shaders.
+ */
+static void DKDrawCIImageInRect(CIImage* image, NSRect destRect, NSRect fromRect)
+{
+	CGImageRef img = [[DKCIFilterRastGroup sharedCIContext] createCGImage:image
+																 fromRect:NSRectToCGRect(fromRect)];
+
+	if (img != NULL) {
+		CGContextRef port = [[NSGraphicsContext currentContext] graphicsPort];
+
+		CGContextSaveGState(port);
+
+		// CGContextDrawImage has no notion of flipped coordinates, so mirror about the
+		// destination rect's centreline when the context is flipped
+
+		if ([[NSGraphicsContext currentContext] isFlipped]) {
+			CGContextTranslateCTM(port, 0.0, NSMinY(destRect) + NSMaxY(destRect));
+			CGContextScaleCTM(port, 1.0, -1.0);
+		}
+
+		CGContextDrawImage(port, NSRectToCGRect(destRect), img);
+		CGContextRestoreGState(port);
+		CGImageRelease(img);
+	}
+}
+
 @implementation NSBitmapImageRep (CoreImage)
 #pragma mark As an NSBitmapImageRep
 - (void)drawAtPoint:(NSPoint)point fromRect:(NSRect)fromRect coreImageFilter:(NSString*)filterName arguments:(NSDictionary*)arguments
@@ -291,7 +461,6 @@
 	CIFilter* filter;
 	CIImage* before;
 	CIImage* after;
-	CIContext* ciContext;
 
 	@autoreleasepool {
 		before = nil;
@@ -322,10 +491,7 @@
 					point.y -= CIIMAGE_PADDING;
 				}
 
-				ciContext = [[NSGraphicsContext currentContext] CIContext];
-				[ciContext drawImage:after
-							 atPoint:NSPointToCGPoint(point)
-							fromRect:NSRectToCGRect(fromRect)];
+				DKDrawCIImageInRect(after, NSMakeRect(point.x, point.y, fromRect.size.width, fromRect.size.height), fromRect);
 			}
 		}
 		@catch (NSException* e) {
@@ -342,7 +508,6 @@
 	CIFilter* filter;
 	CIImage* before = nil;
 	CIImage* after;
-	CIContext* ciContext;
 
 	@autoreleasepool {
 		@try {
@@ -373,10 +538,7 @@
 					inrect.size.height += CIIMAGE_PADDING * 2.0;
 				}
 
-				ciContext = [[NSGraphicsContext currentContext] CIContext];
-				[ciContext drawImage:after
-							  inRect:NSRectToCGRect(inrect)
-							fromRect:NSRectToCGRect(fromRect)];
+				DKDrawCIImageInRect(after, inrect, fromRect);
 			}
 		} @catch (NSException* e) {
 			LogEvent_(kWheneverEvent, @"exception encountered during core image filtering: %@", e);
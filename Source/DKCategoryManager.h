@@ -58,6 +58,8 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
 	NSUInteger m_maxRecentlyUsedItems;
 	NSMutableArray<DKCategoryManagerMenuInfo*>* mMenusList;
 	BOOL mRecentlyAddedEnabled;
+	NSMutableDictionary<DKCategoryName, NSArray<NSString*>*>* mSortedKeyCache; // lazily built sorted key lists per category
+	NSArray<DKCategoryName>* mSortedCategoriesCache; // lazily built sorted list of category names
 }
 
 /** @brief Returns a new category manager object
@@ -134,6 +136,19 @@ typedef NS_OPTIONS(NSUInteger, DKCatManagerMergeOptions) {
  */
 - (void)addObject:(ObjectType)obj forKey:(NSString*)name toCategories:(nullable NSArray<DKCategoryName>*)catNames createCategories:(BOOL)cg;
 
+/** @brief Add a batch of objects to the container in one operation.
+
+ Equivalent to calling -addObject:forKey:toCategory:createCategory: once per object, but the category
+ membership, the cached sorted views and any managed menus are updated once for the whole batch, and a
+ single will/did-add notification pair brackets the operation. Use this when bulk-populating a registry,
+ for example at application startup - adding objects one at a time rescans the category per object added.
+ @param objects The objects to add.
+ @param keys The objects' keys - must contain exactly one key per object.
+ @param catName The name of the category to add them to, or \c nil for defaults only.
+ @param cg \c YES to create the category if it doesn't exist. \c NO not to do so.
+ */
+- (void)addObjects:(NSArray<ObjectType>*)objects forKeys:(NSArray<NSString*>*)keys toCategory:(nullable DKCategoryName)catName createCategory:(BOOL)cg;
+
 /** @brief Remove an object from the container.
 
  After this, the key will not be found in any category or either list.
@@ -79,6 +79,11 @@ enum {
 
 - (nullable DKCategoryManagerMenuInfo*)findInfoForMenu:(NSMenu*)aMenu;
 
+/** invalidates the lazily built sorted views. Passing a category name drops just that category's
+ sorted key list; passing nil drops all of them along with the sorted list of category names.
+ */
+- (void)invalidateSortedViewsForCategory:(nullable NSString*)catName;
+
 @end
 
 #pragma mark -
@@ -264,6 +269,76 @@ static id sDearchivingHelper = nil;
 														object:self];
 }
 
+- (void)addObjects:(NSArray*)objects forKeys:(NSArray*)keys toCategory:(NSString*)catName createCategory:(BOOL)cg
+{
+	NSAssert(objects != nil, @"objects cannot be nil");
+	NSAssert(keys != nil, @"keys cannot be nil");
+	NSAssert([objects count] == [keys count], @"there must be exactly one key per object");
+
+	if ([keys count] == 0)
+		return;
+
+	// adding one at a time rescans the category membership and resorts the cached views for every
+	// object, which is quadratic for large batches. Here the master list and the category arrays are
+	// each updated in a single pass and the sorted views invalidated once; the menus then pick the
+	// keys up against the final, settled state so each key's insertion point is found at most once.
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerWillAddObject
+														object:self];
+
+	NSUInteger i;
+
+	for (i = 0; i < [keys count]; ++i) {
+		NSString* name = [keys objectAtIndex:i];
+
+		NSAssert([name length] > 0, @"key cannot be empty");
+
+		[m_masterList setObject:[objects objectAtIndex:i]
+						 forKey:[name lowercaseString]];
+		[self addKey:name
+			toRecentList:kDKListRecentlyAdded];
+	}
+
+	if (catName != nil && cg)
+		[self addCategory:catName];
+
+	// merge the keys into the category arrays in one pass, using a set for the membership test
+
+	NSArray* targetCategories = (catName != nil) ? @[catName, kDKDefaultCategoryName] : @[kDKDefaultCategoryName];
+	NSMutableOrderedSet* addedKeys = [NSMutableOrderedSet orderedSetWithCapacity:[keys count]];
+
+	for (NSString* cat in targetCategories) {
+		NSMutableArray* ga = [m_categories objectForKey:cat];
+
+		if (ga == nil)
+			continue;
+
+		NSMutableSet* existing = [NSMutableSet setWithArray:ga];
+
+		for (NSString* name in keys) {
+			if (![existing containsObject:name]) {
+				[ga addObject:name];
+				[existing addObject:name];
+				[addedKeys addObject:name];
+			}
+		}
+
+		[self invalidateSortedViewsForCategory:cat];
+	}
+
+	// bring any managed menus up to date. No category mutation happens during this loop, so the
+	// sorted views consulted for the insertion points are built once and reused for the whole batch.
+
+	if ([mMenusList count] > 0) {
+		for (NSString* name in addedKeys)
+			[mMenusList makeObjectsPerformSelector:@selector(addKey:)
+										withObject:name];
+	}
+
+	[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidAddObject
+														object:self];
+}
+
 - (void)removeObjectForKey:(NSString*)key
 {
 	// remove this key from any/all categories and lists
@@ -510,7 +585,22 @@ static id sDearchivingHelper = nil;
 
 - (NSArray*)allSortedKeysInCategory:(NSString*)catName
 {
-	return [[self allKeysInCategory:catName] sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)];
+	// the sorted list is built lazily and cached until the category next changes, so repeated accesses
+	// (menu maintenance, UI tables, bulk registration) only pay for the sort once per change.
+
+	NSArray* sorted = [mSortedKeyCache objectForKey:catName];
+
+	if (sorted == nil) {
+		sorted = [[self allKeysInCategory:catName] sortedArrayUsingSelector:@selector(caseInsensitiveCompare:)];
+
+		// the recents lists mutate without going through the category funnels, so they are never cached
+
+		if (sorted != nil && ![catName isEqualToString:kDKRecentlyAddedUserString] && ![catName isEqualToString:kDKRecentlyUsedUserString])
+			[mSortedKeyCache setObject:sorted
+								forKey:catName];
+	}
+
+	return sorted;
 }
 
 - (NSArray*)allSortedNamesInCategory:(NSString*)catName
@@ -566,6 +656,7 @@ static id sDearchivingHelper = nil;
 														  userInfo:info];
 		[m_categories setObject:cat
 						 forKey:catName];
+		[self invalidateSortedViewsForCategory:nil];
 
 		// inform any menus of the new category
 
@@ -594,6 +685,7 @@ static id sDearchivingHelper = nil;
 															object:self
 														  userInfo:info];
 		[m_categories removeObjectForKey:catName];
+		[self invalidateSortedViewsForCategory:nil];
 
 		// inform menus that category has gone
 
@@ -616,6 +708,7 @@ static id sDearchivingHelper = nil;
 
 		[m_categories setObject:gs
 						 forKey:newname];
+		[self invalidateSortedViewsForCategory:nil];
 
 		// update menu item title:
 
@@ -635,6 +728,7 @@ static id sDearchivingHelper = nil;
 	[m_categories removeAllObjects];
 	[m_recentlyUsed removeAllObjects];
 	[m_recentlyAdded removeAllObjects];
+	[self invalidateSortedViewsForCategory:nil];
 
 	[mMenusList makeObjectsPerformSelector:@selector(removeAll)];
 }
@@ -668,6 +762,7 @@ static id sDearchivingHelper = nil;
 
 	if (![ga containsObject:key]) {
 		[ga addObject:key];
+		[self invalidateSortedViewsForCategory:catName];
 
 		// update menus
 
@@ -706,6 +801,7 @@ static id sDearchivingHelper = nil;
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerWillRemoveKeyFromCategory
 															object:self];
 		[ga removeObject:key];
+		[self invalidateSortedViewsForCategory:catName];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKCategoryManagerDidRemoveKeyFromCategory
 															object:self];
 	}
@@ -778,7 +874,20 @@ static id sDearchivingHelper = nil;
 
 - (NSArray*)allCategories
 {
-	return [[m_categories allKeys] sortedArrayUsingSelector:@selector(localisedCaseInsensitiveNumericCompare:)];
+	if (mSortedCategoriesCache == nil)
+		mSortedCategoriesCache = [[m_categories allKeys] sortedArrayUsingSelector:@selector(localisedCaseInsensitiveNumericCompare:)];
+
+	return mSortedCategoriesCache;
+}
+
+- (void)invalidateSortedViewsForCategory:(NSString*)catName
+{
+	if (catName != nil)
+		[mSortedKeyCache removeObjectForKey:catName];
+	else {
+		[mSortedKeyCache removeAllObjects];
+		mSortedCategoriesCache = nil;
+	}
 }
 
 - (NSUInteger)countOfCategories
@@ -983,6 +1092,7 @@ static id sDearchivingHelper = nil;
 		[m_categories setDictionary:newCM->m_categories];
 		[m_recentlyUsed setArray:newCM->m_recentlyUsed];
 		[m_recentlyAdded setArray:newCM->m_recentlyAdded];
+		[self invalidateSortedViewsForCategory:nil];
 
 		// TODO: deal with menus
 
@@ -1136,6 +1246,7 @@ static id sDearchivingHelper = nil;
 		m_recentlyAdded = [[NSMutableArray alloc] init];
 		m_recentlyUsed = [[NSMutableArray alloc] init];
 		mMenusList = [[NSMutableArray alloc] init];
+		mSortedKeyCache = [[NSMutableDictionary alloc] init];
 		mRecentlyAddedEnabled = YES;
 		m_maxRecentlyAddedItems = kDKDefaultMaxRecentArraySize;
 		m_maxRecentlyUsedItems = kDKDefaultMaxRecentArraySize;
@@ -1185,6 +1296,7 @@ static id sDearchivingHelper = nil;
 		mRecentlyAddedEnabled = YES;
 
 		mMenusList = [[NSMutableArray alloc] init];
+		mSortedKeyCache = [[NSMutableDictionary alloc] init];
 
 		if (m_masterList == nil
 			|| m_categories == nil
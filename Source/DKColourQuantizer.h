@@ -55,18 +55,28 @@ typedef struct _rgb_triple {
 	CGFloat b;
 } rgb_triple;
 
+struct _DKNodePoolBlock;
+
 /** @brief octree quantizer which does a much better job than DKColourQuantizer
- 
+
  This code is mostly a port of CQuantizer © 1996-1997 Jeff Prosise
+
+ Analysis histograms the image into a 5-bit-per-channel colour cube first (in parallel strips for
+ meshed 8-bit bitmaps), then feeds the populated cube cells into the octree, so the tree insertion
+ cost scales with the number of distinct colours rather than the number of pixels. Octree nodes are
+ pool-allocated in blocks and recycled through a free list.
  */
 @interface DKOctreeQuantizer : DKColourQuantizer {
 	NODE* m_pTree;
 	NSUInteger m_nLeafCount;
 	NODE* m_pReducibleNodes[9];
 	NSUInteger m_nOutputMaxColors;
+	struct _DKNodePoolBlock* _Nullable m_nodeBlocks; // chunked NODE allocations
+	NODE* _Nullable m_freeNodes; // recycled nodes, threaded through pNext
 }
 
 - (void)addNode:(NODE* _Nullable* _Nonnull)ppNode colour:(NSUInteger[_Nonnull 4])rgb level:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE* _Nonnull* _Nonnull)redNodes;
+- (void)addNode:(NODE* _Nullable* _Nonnull)ppNode colour:(const NSUInteger[_Nonnull 4])rgb pixelCount:(NSUInteger)count channelSums:(const NSUInteger[_Nonnull 4])sums level:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE* _Nonnull* _Nonnull)redNodes;
 - (nullable NODE*)createNodeAtLevel:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE* _Nonnull* _Nonnull)redNodes;
 - (void)reduceTreeLeafCount:(NSUInteger*)leafCount reducibleNodes:(NODE* _Nonnull* _Nonnull)redNodes;
 - (void)deleteTree:(NODE* _Nonnull* _Nullable)ppNode;
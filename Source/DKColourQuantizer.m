@@ -8,6 +8,7 @@
 
 #import "DKDrawKitMacros.h"
 #import "LogEvent.h"
+#import "NSColor+DKAdditions.h"
 
 // colour mapping macros rgb->index->rgb. Note that these only do the most primitive colour mapping which is bit truncation and concatenation.
 // TODO: try the same using a YUV colourspace???
@@ -176,12 +177,87 @@ static inline void indexToRGB_332(NSUInteger i, NSUInteger rgb[3])
 
 #pragma mark -
 
+// the histogram pass bins pixels into a fixed 5-bit-per-channel colour cube before any octree work
+// is done. Each strip of the image fills its own cube on a worker thread; the cubes are then summed
+// and only the populated cells - at most 32768, typically far fewer - are inserted into the tree.
+
+#define kDKHistogramBits 5
+#define kDKHistogramBins (1 << (kDKHistogramBits * 3))
+
+typedef struct {
+	uint64_t count; // number of pixels falling in this cell
+	uint64_t red, green, blue, alpha; // channel sums over those pixels (rgb in 16-bit fixed-point linear light)
+} DKHistogramBin;
+
+// gamma-encoded samples are averaged in linear light - summing the encoded values directly skews the
+// palette toward dark, muddy averages wherever a cell spans a brightness range. With 8-bit samples
+// the conversion is a 256-entry table, built once with the batch converter; entries are held in
+// 16-bit fixed point so the integer bin and node sums are preserved. Alpha is linear and stays raw.
+
+#define kDKLinearFixedScale 65535
+
+static const uint64_t* DKByteToLinearTable(void)
+{
+	static uint64_t sTable[256];
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		float comps[256];
+		NSInteger i;
+
+		for (i = 0; i < 256; ++i)
+			comps[i] = (float)i / 255.0f;
+
+		DKColourBatchSRGBToLinear(comps, 256);
+
+		for (i = 0; i < 256; ++i)
+			sTable[i] = (uint64_t)lrintf(comps[i] * (float)kDKLinearFixedScale);
+	});
+
+	return sTable;
+}
+
+// octree nodes are allocated in blocks and recycled via a free list (threaded through pNext, which
+// is unused once a node leaves the reducible lists), replacing one calloc/free per node.
+
+#define kDKNodePoolBlockSize 256
+
+typedef struct _DKNodePoolBlock {
+	struct _DKNodePoolBlock* pNextBlock;
+	NODE nodes[kDKNodePoolBlockSize];
+} DKNodePoolBlock;
+
+@interface DKOctreeQuantizer ()
+
+- (NODE*)allocNode;
+- (void)recycleNode:(NODE*)node;
+- (void)addHistogram:(const DKHistogramBin*)bins;
+
+@end
+
 @implementation DKOctreeQuantizer
 
 static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
 
 - (void)addNode:(NODE* _Nullable* _Nonnull)ppNode colour:(NSUInteger[])rgb level:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE**)redNodes
 {
+	const uint64_t* toLinear = DKByteToLinearTable();
+	NSUInteger sums[4] = { toLinear[rgb[0] & 0xFF], toLinear[rgb[1] & 0xFF], toLinear[rgb[2] & 0xFF], rgb[3] };
+
+	[self addNode:ppNode
+				colour:rgb
+			pixelCount:1
+		   channelSums:sums
+				 level:level
+			 leafCount:leafCount
+		reducibleNodes:redNodes];
+}
+
+- (void)addNode:(NODE* _Nullable* _Nonnull)ppNode colour:(const NSUInteger[])rgb pixelCount:(NSUInteger)count channelSums:(const NSUInteger[])sums level:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE**)redNodes
+{
+	// as addNode:colour:..., but accounts for <count> pixels at once whose channel totals are given
+	// by <sums>. <rgb> is the representative colour used to steer the descent. This is what lets a
+	// whole histogram cell enter the tree as a single insertion.
 
 	// If the node doesn't exist, create it.
 
@@ -200,11 +276,11 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 	// Update color	information	if it's	a leaf node.
 
 	if ((*ppNode)->bIsLeaf) {
-		(*ppNode)->nPixelCount++;
-		(*ppNode)->nRedSum += rgb[0];
-		(*ppNode)->nGreenSum += rgb[1];
-		(*ppNode)->nBlueSum += rgb[2];
-		(*ppNode)->nAlphaSum += rgb[3];
+		(*ppNode)->nPixelCount += count;
+		(*ppNode)->nRedSum += sums[0];
+		(*ppNode)->nGreenSum += sums[1];
+		(*ppNode)->nBlueSum += sums[2];
+		(*ppNode)->nAlphaSum += sums[3];
 	} else {
 		// Recurse a level deeper if the node is not a leaf.
 
@@ -213,15 +289,49 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 
 		[self addNode:&((*ppNode)->pChild[nIndex])
 					  colour:rgb
+				  pixelCount:count
+				 channelSums:sums
 					 level:level + 1
 				 leafCount:leafCount
 			reducibleNodes:redNodes];
 	}
 }
 
+- (NODE*)allocNode
+{
+	if (m_freeNodes == NULL) {
+		DKNodePoolBlock* block = (DKNodePoolBlock*)calloc(1, sizeof(DKNodePoolBlock));
+
+		if (block == NULL)
+			return NULL;
+
+		block->pNextBlock = m_nodeBlocks;
+		m_nodeBlocks = block;
+
+		NSInteger i;
+
+		for (i = 0; i < kDKNodePoolBlockSize; ++i) {
+			block->nodes[i].pNext = m_freeNodes;
+			m_freeNodes = &block->nodes[i];
+		}
+	}
+
+	NODE* node = m_freeNodes;
+	m_freeNodes = node->pNext;
+	memset(node, 0, sizeof(NODE));
+
+	return node;
+}
+
+- (void)recycleNode:(NODE*)node
+{
+	node->pNext = m_freeNodes;
+	m_freeNodes = node;
+}
+
 - (NODE*)createNodeAtLevel:(NSUInteger)level leafCount:(NSUInteger*)leafCount reducibleNodes:(NODE**)redNodes
 {
-	NODE* pnode = (NODE*)calloc(1, sizeof(NODE));
+	NODE* pnode = [self allocNode];
 
 	if (pnode == NULL)
 		return NULL;
@@ -267,7 +377,7 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 			nAlphaSum += pnode->pChild[i]->nAlphaSum;
 			pnode->nPixelCount += pnode->pChild[i]->nPixelCount;
 
-			free(pnode->pChild[i]);
+			[self recycleNode:pnode->pChild[i]];
 			pnode->pChild[i] = NULL;
 
 			nChildren++;
@@ -292,7 +402,7 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 			[self deleteTree:&((*ppNode)->pChild[i])];
 	}
 
-	free(*ppNode);
+	[self recycleNode:*ppNode];
 	*ppNode = NULL;
 }
 
@@ -300,7 +410,10 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 {
 	if (pTree) {
 		if (pTree->bIsLeaf) {
-			CGFloat divs = ((CGFloat)(pTree->nPixelCount) * 255.0); //(float) m_maxColours);
+			// the sums are in fixed-point linear light, so this average is a linear-light value - the
+			// colour table converts the whole palette back to sRGB in one batch
+
+			CGFloat divs = ((CGFloat)(pTree->nPixelCount) * (CGFloat)kDKLinearFixedScale);
 
 			rgb[*pindex].r = (CGFloat)(pTree->nRedSum) / divs;
 			rgb[*pindex].g = (CGFloat)(pTree->nGreenSum) / divs;
@@ -343,27 +456,133 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 #pragma mark As a DKColourQuantizer
 - (void)analyse:(NSBitmapImageRep*)rep
 {
-	NSInteger i, j;
-	NSUInteger rgb[4];
+	// histogram the image into the 5-bit colour cube, then insert the populated cells into the octree.
+	// meshed 8-bit bitmaps are read directly from the sample buffer in parallel strips; anything more
+	// exotic falls back to getPixel:atX:y: a pixel at a time, but still only touches the tree once
+	// per distinct cell.
 
 	[m_cTable removeAllObjects];
 
-	for (i = 0; i < m_imageSize.height; ++i) {
-		for (j = 0; j < m_imageSize.width; ++j) {
-			[rep getPixel:rgb
-					  atX:j
-						y:i];
-
-			[self addNode:&m_pTree
-						colour:rgb
-						 level:0
-					 leafCount:&m_nLeafCount
-				reducibleNodes:m_pReducibleNodes];
-
-			while (m_nLeafCount > m_maxColours)
-				[self reduceTreeLeafCount:&m_nLeafCount
-						   reducibleNodes:m_pReducibleNodes];
+	NSInteger width = [rep pixelsWide];
+	NSInteger height = [rep pixelsHigh];
+
+	if (width < 1 || height < 1)
+		return;
+
+	DKHistogramBin* bins;
+
+	BOOL directAccess = ![rep isPlanar]
+		&& [rep bitsPerSample] == 8
+		&& ([rep bitmapFormat] & (NSBitmapFormatAlphaFirst | NSBitmapFormatFloatingPointSamples)) == 0
+		&& ([rep samplesPerPixel] == 3 || [rep samplesPerPixel] == 4)
+		&& [rep bitmapData] != NULL;
+
+	if (directAccess) {
+		NSUInteger nStrips = MIN((NSUInteger)[[NSProcessInfo processInfo] activeProcessorCount], (NSUInteger)height);
+		NSInteger rowsPerStrip = (height + nStrips - 1) / nStrips;
+		const unsigned char* data = [rep bitmapData];
+		NSInteger bytesPerRow = [rep bytesPerRow];
+		NSInteger spp = [rep samplesPerPixel];
+
+		bins = (DKHistogramBin*)calloc(nStrips * kDKHistogramBins, sizeof(DKHistogramBin));
+
+		dispatch_apply(nStrips, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t stripIndex) {
+			DKHistogramBin* stripBins = bins + (stripIndex * kDKHistogramBins);
+			const uint64_t* toLinear = DKByteToLinearTable();
+			NSInteger firstRow = stripIndex * rowsPerStrip;
+			NSInteger lastRow = MIN(firstRow + rowsPerStrip, height);
+			NSInteger x, y;
+
+			for (y = firstRow; y < lastRow; ++y) {
+				const unsigned char* p = data + (y * bytesPerRow);
+
+				for (x = 0; x < width; ++x, p += spp) {
+					unsigned r = p[0], g = p[1], b = p[2];
+					unsigned a = (spp == 4) ? p[3] : 0xFF;
+					DKHistogramBin* bin = &stripBins[((r >> 3) << 10) | ((g >> 3) << 5) | (b >> 3)];
+
+					bin->count++;
+					bin->red += toLinear[r];
+					bin->green += toLinear[g];
+					bin->blue += toLinear[b];
+					bin->alpha += a;
+				}
+			}
+		});
+
+		// reduce the per-strip cubes into the first
+
+		NSUInteger s;
+		NSInteger k;
+
+		for (s = 1; s < nStrips; ++s) {
+			const DKHistogramBin* stripBins = bins + (s * kDKHistogramBins);
+
+			for (k = 0; k < kDKHistogramBins; ++k) {
+				if (stripBins[k].count != 0) {
+					bins[k].count += stripBins[k].count;
+					bins[k].red += stripBins[k].red;
+					bins[k].green += stripBins[k].green;
+					bins[k].blue += stripBins[k].blue;
+					bins[k].alpha += stripBins[k].alpha;
+				}
+			}
 		}
+	} else {
+		const uint64_t* toLinear = DKByteToLinearTable();
+		NSInteger x, y;
+		NSUInteger rgb[4];
+
+		bins = (DKHistogramBin*)calloc(kDKHistogramBins, sizeof(DKHistogramBin));
+
+		for (y = 0; y < height; ++y) {
+			for (x = 0; x < width; ++x) {
+				[rep getPixel:rgb
+						  atX:x
+							y:y];
+
+				DKHistogramBin* bin = &bins[((rgb[0] >> 3) << 10) | ((rgb[1] >> 3) << 5) | (rgb[2] >> 3)];
+
+				bin->count++;
+				bin->red += toLinear[rgb[0] & 0xFF];
+				bin->green += toLinear[rgb[1] & 0xFF];
+				bin->blue += toLinear[rgb[2] & 0xFF];
+				bin->alpha += rgb[3];
+			}
+		}
+	}
+
+	[self addHistogram:bins];
+	free(bins);
+}
+
+- (void)addHistogram:(const DKHistogramBin*)bins
+{
+	// inserts every populated cell of the colour cube into the octree as a single weighted addition.
+	// the cell centre steers the descent; the accumulated channel sums keep the palette averages
+	// faithful to the actual pixels.
+
+	NSInteger k;
+
+	for (k = 0; k < kDKHistogramBins; ++k) {
+		if (bins[k].count == 0)
+			continue;
+
+		NSUInteger r5 = (k >> 10) & 0x1F, g5 = (k >> 5) & 0x1F, b5 = k & 0x1F;
+		NSUInteger rgb[4] = { (r5 << 3) | (r5 >> 2), (g5 << 3) | (g5 >> 2), (b5 << 3) | (b5 >> 2), 0xFF };
+		NSUInteger sums[4] = { bins[k].red, bins[k].green, bins[k].blue, bins[k].alpha };
+
+		[self addNode:&m_pTree
+					colour:rgb
+				pixelCount:bins[k].count
+			   channelSums:sums
+					 level:0
+				 leafCount:&m_nLeafCount
+			reducibleNodes:m_pReducibleNodes];
+
+		while (m_nLeafCount > m_maxColours)
+			[self reduceTreeLeafCount:&m_nLeafCount
+					   reducibleNodes:m_pReducibleNodes];
 	}
 }
 
@@ -381,16 +600,28 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 					  index:&indx
 					 colour:rgb];
 
-		// loop over the list and convert to NSColors
+		// the averages are linear light - encode the whole palette back to sRGB in one batch, then
+		// convert to NSColors
+
+		float* comps = (float*)malloc(indx * 3 * sizeof(float));
+
+		for (i = 0; i < indx; ++i) {
+			comps[i * 3] = (float)rgb[i].r;
+			comps[i * 3 + 1] = (float)rgb[i].g;
+			comps[i * 3 + 2] = (float)rgb[i].b;
+		}
+
+		DKColourBatchLinearToSRGB(comps, indx * 3);
 
 		for (i = 0; i < indx; ++i) {
-			colour = [NSColor colorWithCalibratedRed:rgb[i].r
-											   green:rgb[i].g
-												blue:rgb[i].b
+			colour = [NSColor colorWithCalibratedRed:comps[i * 3]
+											   green:comps[i * 3 + 1]
+												blue:comps[i * 3 + 2]
 											   alpha:1.0];
 			[m_cTable addObject:colour];
 		}
 
+		free(comps);
 		free(rgb);
 	}
 
@@ -445,6 +676,14 @@ static const NSUInteger mask[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x
 	if (m_pTree != NULL) {
 		[self deleteTree:&m_pTree];
 	}
+
+	DKNodePoolBlock* block = m_nodeBlocks;
+
+	while (block != NULL) {
+		DKNodePoolBlock* next = block->pNextBlock;
+		free(block);
+		block = next;
+	}
 }
 
 @end
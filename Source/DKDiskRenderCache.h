@@ -0,0 +1,78 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Disk-backed cache for expensive render output that survives across launches.
+
+ Heavyweight rasterizers (roughened stroke outlines, Core Image filter output, swept angle gradient
+ bitmaps) produce results that are deterministic functions of their parameters, yet historically were
+ recomputed from scratch on every launch. This cache banks such results in the user's caches directory,
+ content-addressed by a fingerprint string that the producer builds from everything the output depends
+ on - the same discipline as the in-memory cache keys, extended with a stable prefix per producer.
+
+ Reads are synchronous (a small file read, on the same order as the blit that follows); writes and
+ housekeeping run on a background queue so the render path never waits on disk. The directory is
+ size-capped: when it outgrows the limit, the least recently used entries are removed, with reads
+ refreshing an entry's modification date to keep live documents' artwork resident.
+
+ Fingerprints must capture every input that affects the bytes produced. Nondeterministic output
+ (anything drawing unseeded random numbers) must not be stored here at all.
+*/
+@interface DKDiskRenderCache : NSObject {
+@private
+	NSString* mCachePath; /**< the cache directory */
+	dispatch_queue_t mQueue; /**< serial queue for writes and pruning */
+	unsigned long long mApproxBytes; /**< running estimate of the directory size, maintained on mQueue */
+	BOOL mPruneScheduled; /**< YES while a prune pass is queued */
+}
+
+/** @brief The shared cache instance. */
++ (DKDiskRenderCache*)sharedCache;
+
+/** @brief Returns the stored data for the fingerprint, or \c nil if not present.
+ @param fingerprint the producer's fingerprint string
+ @return the data as stored, or \c nil
+ */
+- (nullable NSData*)dataForFingerprint:(NSString*)fingerprint;
+
+/** @brief Stores data under the fingerprint, replacing any previous entry.
+
+ The write happens in the background; the call returns immediately.
+ @param data the data to store
+ @param fingerprint the producer's fingerprint string
+ */
+- (void)storeData:(NSData*)data forFingerprint:(NSString*)fingerprint;
+
+/** @brief Convenience for cached path geometry - unarchives a stored bezier path.
+ @param fingerprint the producer's fingerprint string
+ @return the path, or \c nil if not present or unreadable
+ */
+- (nullable NSBezierPath*)bezierPathForFingerprint:(NSString*)fingerprint;
+
+/** @brief Convenience for cached path geometry - archives and stores a bezier path. */
+- (void)storeBezierPath:(NSBezierPath*)path forFingerprint:(NSString*)fingerprint;
+
+/** @brief Convenience for cached bitmaps - decodes a stored image.
+ @param fingerprint the producer's fingerprint string
+ @return a retained image which the caller must release, or \c NULL if not present
+ */
+- (nullable CGImageRef)newImageForFingerprint:(NSString*)fingerprint CF_RETURNS_RETAINED;
+
+/** @brief Convenience for cached bitmaps - encodes the image as PNG and stores it. */
+- (void)storeImage:(CGImageRef)image forFingerprint:(NSString*)fingerprint;
+
+/** @brief Removes every entry. Mainly for tests and troubleshooting. */
+- (void)removeAllEntries;
+
+@end
+
+/// directory size at which the least recently used entries start being evicted
+#define kDKDiskRenderCacheByteLimit (64ull * 1024ull * 1024ull)
+
+NS_ASSUME_NONNULL_END
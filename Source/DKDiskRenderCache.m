@@ -0,0 +1,260 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKDiskRenderCache.h"
+#import "DKImageDataManager.h"
+#import "LogEvent.h"
+
+static NSString* const kDKDiskRenderCacheDirectoryName = @"DKRenderCache";
+static NSString* const kDKDiskRenderCacheFileExtension = @"dkrc";
+
+// entries are evicted down to this fraction of the byte limit, so pruning doesn't run on every write
+// once the cache hovers near the cap
+
+static const double kDKDiskRenderCachePruneTargetFraction = 0.75;
+
+@implementation DKDiskRenderCache
+
++ (DKDiskRenderCache*)sharedCache
+{
+	static DKDiskRenderCache* sCache = nil;
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		sCache = [[DKDiskRenderCache alloc] init];
+	});
+
+	return sCache;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self != nil) {
+		NSString* base = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+		NSString* bundleID = [[NSBundle mainBundle] bundleIdentifier];
+
+		if (bundleID == nil)
+			bundleID = @"DrawKit";
+
+		mCachePath = [[base stringByAppendingPathComponent:bundleID] stringByAppendingPathComponent:kDKDiskRenderCacheDirectoryName];
+		mQueue = dispatch_queue_create("net.apptree.drawkit.diskrendercache", DISPATCH_QUEUE_SERIAL);
+
+		[[NSFileManager defaultManager] createDirectoryAtPath:mCachePath
+								  withIntermediateDirectories:YES
+												   attributes:nil
+														error:NULL];
+
+		// take stock of what previous launches left behind, and trim if they overshot
+
+		dispatch_async(mQueue, ^{
+			mApproxBytes = [self queue_directorySize];
+
+			if (mApproxBytes > kDKDiskRenderCacheByteLimit)
+				[self queue_prune];
+		});
+	}
+	return self;
+}
+
+#pragma mark -
+
+- (NSString*)pathForFingerprint:(NSString*)fingerprint
+{
+	// content addressing - the digest of the fingerprint is the filename, so distinct inputs can
+	// never collide on disk and the fingerprint's length and content are unconstrained
+
+	NSString* name = [[fingerprint dataUsingEncoding:NSUTF8StringEncoding] sha256String];
+
+	return [[mCachePath stringByAppendingPathComponent:name] stringByAppendingPathExtension:kDKDiskRenderCacheFileExtension];
+}
+
+- (NSData*)dataForFingerprint:(NSString*)fingerprint
+{
+	NSString* path = [self pathForFingerprint:fingerprint];
+	NSData* data = [NSData dataWithContentsOfFile:path];
+
+	if (data != nil) {
+		// refresh the modification date so LRU pruning sees this entry as live
+
+		dispatch_async(mQueue, ^{
+			[[NSFileManager defaultManager] setAttributes:@{ NSFileModificationDate: [NSDate date] }
+											 ofItemAtPath:path
+													error:NULL];
+		});
+	}
+
+	return data;
+}
+
+- (void)storeData:(NSData*)data forFingerprint:(NSString*)fingerprint
+{
+	NSAssert(data != nil, @"cannot store nil data in the render cache");
+
+	NSString* path = [self pathForFingerprint:fingerprint];
+
+	dispatch_async(mQueue, ^{
+		if ([data writeToFile:path
+				   atomically:YES]) {
+			mApproxBytes += [data length];
+
+			if (mApproxBytes > kDKDiskRenderCacheByteLimit && !mPruneScheduled) {
+				mPruneScheduled = YES;
+				dispatch_async(mQueue, ^{
+					[self queue_prune];
+				});
+			}
+		}
+	});
+}
+
+#pragma mark -
+
+- (NSBezierPath*)bezierPathForFingerprint:(NSString*)fingerprint
+{
+	NSData* data = [self dataForFingerprint:fingerprint];
+
+	if (data == nil)
+		return nil;
+
+	// treat a damaged or stale-format entry as a plain miss
+
+	@try {
+		id obj = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+
+		if ([obj isKindOfClass:[NSBezierPath class]])
+			return obj;
+	}
+	@catch (NSException* e) {
+		LogEvent_(kWheneverEvent, @"discarding unreadable render cache entry: %@", e);
+	}
+
+	return nil;
+}
+
+- (void)storeBezierPath:(NSBezierPath*)path forFingerprint:(NSString*)fingerprint
+{
+	NSData* data = [NSKeyedArchiver archivedDataWithRootObject:path];
+
+	if (data != nil)
+		[self storeData:data
+			 forFingerprint:fingerprint];
+}
+
+- (CGImageRef)newImageForFingerprint:(NSString*)fingerprint
+{
+	NSData* data = [self dataForFingerprint:fingerprint];
+
+	if (data == nil)
+		return NULL;
+
+	CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+
+	if (source == NULL)
+		return NULL;
+
+	CGImageRef image = CGImageSourceCreateImageAtIndex(source, 0, NULL);
+	CFRelease(source);
+
+	return image;
+}
+
+- (void)storeImage:(CGImageRef)image forFingerprint:(NSString*)fingerprint
+{
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGImageDestinationRef destRef = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)data, kUTTypePNG, 1, NULL);
+
+	if (destRef == NULL)
+		return;
+
+	CGImageDestinationAddImage(destRef, image, NULL);
+
+	BOOL result = CGImageDestinationFinalize(destRef);
+	CFRelease(destRef);
+
+	if (result)
+		[self storeData:data
+			 forFingerprint:fingerprint];
+}
+
+#pragma mark -
+
+- (void)removeAllEntries
+{
+	dispatch_sync(mQueue, ^{
+		for (NSString* name in [[NSFileManager defaultManager] contentsOfDirectoryAtPath:mCachePath
+																				   error:NULL])
+			[[NSFileManager defaultManager] removeItemAtPath:[mCachePath stringByAppendingPathComponent:name]
+													   error:NULL];
+
+		mApproxBytes = 0;
+	});
+}
+
+#pragma mark -
+#pragma mark - housekeeping, on mQueue only
+
+- (unsigned long long)queue_directorySize
+{
+	unsigned long long total = 0;
+	NSFileManager* fm = [NSFileManager defaultManager];
+
+	for (NSString* name in [fm contentsOfDirectoryAtPath:mCachePath
+												   error:NULL])
+		total += [[fm attributesOfItemAtPath:[mCachePath stringByAppendingPathComponent:name]
+									   error:NULL] fileSize];
+
+	return total;
+}
+
+- (void)queue_prune
+{
+	mPruneScheduled = NO;
+
+	NSFileManager* fm = [NSFileManager defaultManager];
+	NSMutableArray* entries = [NSMutableArray array];
+	unsigned long long total = 0;
+
+	for (NSString* name in [fm contentsOfDirectoryAtPath:mCachePath
+												   error:NULL]) {
+		NSString* path = [mCachePath stringByAppendingPathComponent:name];
+		NSDictionary* attrs = [fm attributesOfItemAtPath:path
+												   error:NULL];
+
+		if (attrs != nil) {
+			total += [attrs fileSize];
+			[entries addObject:@{ @"path": path,
+				@"size": @([attrs fileSize]),
+				@"date": [attrs fileModificationDate] ?: [NSDate distantPast] }];
+		}
+	}
+
+	mApproxBytes = total;
+
+	if (total <= kDKDiskRenderCacheByteLimit)
+		return;
+
+	// oldest first - reads refresh the modification date, so this is LRU order
+
+	[entries sortUsingComparator:^NSComparisonResult(NSDictionary* a, NSDictionary* b) {
+		return [a[@"date"] compare:b[@"date"]];
+	}];
+
+	unsigned long long target = (unsigned long long)(kDKDiskRenderCacheByteLimit * kDKDiskRenderCachePruneTargetFraction);
+
+	for (NSDictionary* entry in entries) {
+		if (mApproxBytes <= target)
+			break;
+
+		if ([fm removeItemAtPath:entry[@"path"]
+						   error:NULL])
+			mApproxBytes -= [entry[@"size"] unsignedLongLongValue];
+	}
+
+	LogEvent_(kInfoEvent, @"render cache pruned to %llu bytes", mApproxBytes);
+}
+
+@end
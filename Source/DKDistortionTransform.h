@@ -20,6 +20,10 @@ can be used in a similar way.
 @interface DKDistortionTransform : NSObject <NSCoding, NSCopying> {
 	NSPoint m_q[4];
 	BOOL m_inverted;
+	NSBezierPath* mCachedSourcePath; // the path last given to -transformBezierPath:, for cache validation
+	NSBezierPath* mCachedResultPath; // its distorted output, reusable until the envelope changes
+	NSInteger mCachedSourceElements; // element count of the cached source, guards against in-place edits
+	NSRect mCachedSourceBounds; // control point bounds of the cached source, same purpose
 }
 
 + (DKDistortionTransform*)transformWithInitialRect:(NSRect)rect;
@@ -41,6 +45,13 @@ can be used in a similar way.
 - (void)invert;
 
 - (NSPoint)transformPoint:(NSPoint)p fromRect:(NSRect)rect;
+
+/** @brief Returns a distorted copy of the path.
+
+ The distorted output is cached and reused while the envelope's control points and the input path are
+ unchanged, so repeatedly redrawing a static distorted shape costs a path copy rather than a
+ perspective mapping of every control point.
+ */
 - (NSBezierPath*)transformBezierPath:(NSBezierPath*)path;
 
 @end
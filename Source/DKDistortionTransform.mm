@@ -84,12 +84,21 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 }
 
 #pragma mark -
+
+/** @brief Discards any cached distorted path; called by every mutation of the envelope. */
+- (void)invalidateCache
+{
+	mCachedSourcePath = nil;
+	mCachedResultPath = nil;
+}
+
 - (void)setEnvelopePoints:(in const NSPoint[4])points
 {
 	m_q[0] = points[0];
 	m_q[1] = points[1];
 	m_q[2] = points[2];
 	m_q[3] = points[3];
+	[self invalidateCache];
 }
 
 - (void)getEnvelopePoints:(out NSPoint[4])points
@@ -124,6 +133,7 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 	m_q[1].y += dy;
 	m_q[2].y += dy;
 	m_q[3].y += dy;
+	[self invalidateCache];
 }
 
 - (void)shearHorizontallyBy:(CGFloat)dx
@@ -132,6 +142,7 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 	m_q[1].x += dx;
 	m_q[2].x -= dx;
 	m_q[3].x -= dx;
+	[self invalidateCache];
 }
 
 - (void)shearVerticallyBy:(CGFloat)dy
@@ -140,6 +151,7 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 	m_q[3].y -= dy;
 	m_q[1].y += dy;
 	m_q[2].y += dy;
+	[self invalidateCache];
 }
 
 - (void)differentialPerspectiveBy:(CGFloat)delta
@@ -148,12 +160,14 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 	m_q[1].y -= delta;
 	m_q[2].y += delta;
 	m_q[3].y -= delta;
+	[self invalidateCache];
 }
 
 #pragma mark -
 - (void)invert
 {
 	m_inverted = !m_inverted;
+	[self invalidateCache];
 }
 
 #pragma mark -
@@ -214,15 +228,23 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 {
 	// transforms every point in the path, making a new path
 
-	NSBezierPath* newPath = [path copy];
 	NSPoint ap[3];
 	NSBezierPathElement elem;
 	NSInteger i, ec;
 	NSRect bounds = [path controlPointBounds];
 
-	[newPath removeAllPoints];
 	ec = [path elementCount];
 
+	// if the envelope hasn't changed since the last call and the same path is being distorted again, the
+	// previous result is still valid and the expensive per-point perspective mapping can be skipped. The
+	// element count and control point bounds guard against the path having been edited in place.
+
+	if (path == mCachedSourcePath && mCachedResultPath != nil && ec == mCachedSourceElements && NSEqualRects(bounds, mCachedSourceBounds))
+		return [mCachedResultPath copy];
+
+	NSBezierPath* newPath = [path copy];
+	[newPath removeAllPoints];
+
 	for (i = 0; i < ec; ++i) {
 		elem = [path elementAtIndex:i
 				   associatedPoints:ap];
@@ -261,6 +283,11 @@ static NSPoint Map(NSPoint inPoint, NSSize sourceSize, NSPoint quad[4])
 		}
 	}
 
+	mCachedSourcePath = path;
+	mCachedResultPath = [newPath copy];
+	mCachedSourceElements = ec;
+	mCachedSourceBounds = bounds;
+
 	return newPath;
 }
 
@@ -35,6 +35,50 @@
 		[NSGraphicsContext restoreGraphicsState]; \
 	}
 
+// hot-path instrumentation
+//
+// When DK_SIGNPOSTS_ENABLED is defined non-zero (e.g. via OTHER_CFLAGS=-DDK_SIGNPOSTS_ENABLED=1), the macros
+// below emit os_signpost intervals and events that show up in Instruments' "Points of Interest" track, so a
+// live deployment can be profiled by simply attaching Instruments - no custom logging build required. By
+// default the macros compile away to nothing, so instrumented code pays no cost in normal builds.
+//
+// <name> must be a string literal. <obj> is any object identifying the interval - nested or concurrent
+// intervals sharing a name (e.g. layers within layer groups) pair up correctly as long as each passes a
+// distinct object. Trailing arguments are an optional os_log format string and its values.
+
+#ifndef DK_SIGNPOSTS_ENABLED
+#define DK_SIGNPOSTS_ENABLED 0
+#endif
+
+#if DK_SIGNPOSTS_ENABLED
+
+#include <os/signpost.h>
+#include <dispatch/dispatch.h>
+
+static inline os_log_t DKSignpostLog(void)
+{
+	static os_log_t sLog;
+	static dispatch_once_t sOnce;
+	dispatch_once(&sOnce, ^{
+		sLog = os_log_create("io.github.drawkit", OS_LOG_CATEGORY_POINTS_OF_INTEREST);
+	});
+	return sLog;
+}
+
+#define DK_SIGNPOST_ID_FOR(obj) os_signpost_id_make_with_pointer(DKSignpostLog(), (__bridge const void*)(obj))
+
+#define DK_SIGNPOST_BEGIN(name, obj, ...) os_signpost_interval_begin(DKSignpostLog(), DK_SIGNPOST_ID_FOR(obj), name, ##__VA_ARGS__)
+#define DK_SIGNPOST_END(name, obj, ...) os_signpost_interval_end(DKSignpostLog(), DK_SIGNPOST_ID_FOR(obj), name, ##__VA_ARGS__)
+#define DK_SIGNPOST_EVENT(name, obj, ...) os_signpost_event_emit(DKSignpostLog(), DK_SIGNPOST_ID_FOR(obj), name, ##__VA_ARGS__)
+
+#else
+
+#define DK_SIGNPOST_BEGIN(name, obj, ...) ((void)0)
+#define DK_SIGNPOST_END(name, obj, ...) ((void)0)
+#define DK_SIGNPOST_EVENT(name, obj, ...) ((void)0)
+
+#endif
+
 // 64-bit float macros
 // Deprecated, do not use:
 // instead, use double values with tgmath header included
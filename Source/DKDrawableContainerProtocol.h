@@ -28,6 +28,14 @@ NS_ASSUME_NONNULL_BEGIN
 - (DKMetadataItem*)metadataItemForKey:(NSString*)key;
 - (id)metadataObjectForKey:(NSString*)key;
 
+/** @brief Informs the container that one of its objects changed in a way that may affect its bounds.
+
+ Containers that cache an aggregation of their contents (such as DKShapeGroup, which derives its extra
+ space requirement from all of its children) implement this to mark the aggregate dirty. The dirty flag
+ should be propagated to the container's own container in turn, so that nested groups invalidate each
+ enclosing level exactly once instead of re-aggregating on every query. */
+- (void)drawableDidChangeBounds:(DKDrawableObject*)obj;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -31,6 +31,14 @@ typedef NS_ENUM(NSInteger, DKMetadataSchema) {
 
 @property (class) BOOL metadataChangesAreUndoable;
 
+/** When set, newly created metadata stores use a shared-schema representation: the keys are interned in a table shared by
+ all objects in the same layer and each object holds only a compact array of values indexed by the table's slots. Copies
+ share the value array until first mutation. For layers where many objects carry the same few keys this removes the
+ duplicated key strings and per-object dictionary overhead. The mode only affects objects whose metadata is created while
+ it is on; existing stores are left as they are, and the representation is private to the existing metadata API.
+ */
+@property (class) BOOL metadataStorageIsShared;
+
 - (void)addMetadata:(NSDictionary<NSString*, id>*)dict;
 - (void)setMetadata:(NSDictionary<NSString*, DKMetadataItem*>*)dict NS_REFINED_FOR_SWIFT;
 - (nullable NSMutableDictionary<NSString*, DKMetadataItem*>*)metadata NS_REFINED_FOR_SWIFT;
@@ -82,11 +90,29 @@ typedef NS_ENUM(NSInteger, DKMetadataSchema) {
 - (NSSize)sizeForKey:(NSString*)key;
 
 - (void)updateMetadataKeys;
+
+/** @brief Returns the user info as it should be written to an archive.
+
+ When compact metadata archiving is enabled (see DKMetadataItem) and the metadata dictionary can be
+ represented, this returns a copy of the user info with the items dictionary replaced by a single compact
+ data blob, which <code>-updateMetadataKeys</code> reconstitutes on dearchiving. Otherwise the user info is
+ returned unchanged.
+ */
+- (nullable NSDictionary*)userInfoForArchiving;
 @property (readonly) NSUInteger metadataChecksum;
 
 - (void)metadataWillChangeKey:(nullable NSString*)key;
 - (void)metadataDidChangeKey:(nullable NSString*)key;
 
+/** @brief Whether a change to the given metadata key can alter the object's appearance
+
+ Metadata only reaches pixels through text substitution, so this checks whether any text adornment in
+ the object's style references <code>key</code> (\c nil means any key). Metadata writes that do not
+ affect display skip the visual invalidation entirely and are reported only through the coalesced
+ \c kDKMetadataChangesDidOccurNotification at the end of the runloop turn.
+ */
+- (BOOL)metadataKeyAffectsDisplay:(nullable NSString*)key;
+
 @end
 
 /** deprecated methods - avoid using anonymous objects with metadata - wrap values in DKMetadataItem objects and use
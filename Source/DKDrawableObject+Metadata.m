@@ -5,6 +5,10 @@
 */
 
 #import "DKDrawableObject+Metadata.h"
+#import "DKLayer.h"
+#import "DKStyle.h"
+#import "DKTextAdornment.h"
+#import "DKTextSubstitutor.h"
 #import "DKUndoManager.h"
 #import "LogEvent.h"
 
@@ -12,10 +16,234 @@ NSString* const kDKMetaDataUserInfoKey = @"kDKMetaDataUserInfoKey";
 NSString* const kDKMetaDataUserInfo107OrLaterKey = @"kDKMetaDataUserInfo107OrLaterKey";
 NSString* const kDKMetadataWillChangeNotification = @"kDKMetadataWillChangeNotification";
 NSString* const kDKMetadataDidChangeNotification = @"kDKMetadataDidChangeNotification";
+NSString* const kDKMetadataChangesDidOccurNotification = @"kDKMetadataChangesDidOccurNotification";
 NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUndoable";
 
 #define USE_107_OR_LATER_SCHEMA 1
 
+#pragma mark -
+
+/** maps metadata keys to slot indices, shared by all objects in the same layer. The table only ever grows, so a slot
+ index, once issued, remains valid for the table's lifetime and can be used to index the per-object value arrays.
+*/
+@interface DKMetadataKeyTable : NSObject {
+@private
+	NSMutableDictionary<NSString*, NSNumber*>* mSlots;
+	NSMutableArray<NSString*>* mKeys;
+}
+
++ (DKMetadataKeyTable*)keyTableForLayer:(DKLayer*)layer;
+- (NSUInteger)slotForKey:(NSString*)key createIfNeeded:(BOOL)create;
+- (NSString*)keyForSlot:(NSUInteger)slot;
+
+@end
+
+@implementation DKMetadataKeyTable
+
++ (DKMetadataKeyTable*)keyTableForLayer:(DKLayer*)layer
+{
+	// one table per layer, created on demand. The tables are not retained beyond the life of their layer; objects that
+	// have no layer yet (or none at all) share a common table.
+
+	static NSMapTable<DKLayer*, DKMetadataKeyTable*>* sLayerTables = nil;
+	static DKMetadataKeyTable* sOrphanTable = nil;
+
+	if (layer == nil) {
+		if (sOrphanTable == nil)
+			sOrphanTable = [[DKMetadataKeyTable alloc] init];
+
+		return sOrphanTable;
+	}
+
+	if (sLayerTables == nil)
+		sLayerTables = [NSMapTable weakToStrongObjectsMapTable];
+
+	DKMetadataKeyTable* table = [sLayerTables objectForKey:layer];
+
+	if (table == nil) {
+		table = [[DKMetadataKeyTable alloc] init];
+		[sLayerTables setObject:table
+						 forKey:layer];
+	}
+
+	return table;
+}
+
+- (instancetype)init
+{
+	self = [super init];
+	if (self) {
+		mSlots = [[NSMutableDictionary alloc] init];
+		mKeys = [[NSMutableArray alloc] init];
+	}
+
+	return self;
+}
+
+- (NSUInteger)slotForKey:(NSString*)key createIfNeeded:(BOOL)create
+{
+	NSNumber* slot = [mSlots objectForKey:key];
+
+	if (slot == nil) {
+		if (!create)
+			return NSNotFound;
+
+		key = [key copy];
+		slot = @([mKeys count]);
+		[mKeys addObject:key];
+		[mSlots setObject:slot
+				   forKey:key];
+	}
+
+	return [slot unsignedIntegerValue];
+}
+
+- (NSString*)keyForSlot:(NSUInteger)slot
+{
+	return [mKeys objectAtIndex:slot];
+}
+
+@end
+
+#pragma mark -
+
+/** a dictionary whose keys live in a shared DKMetadataKeyTable, storing per-object values in a compact array indexed by
+ the table's slots. Mutable copies share the value array until either side is first mutated. Archives as a plain
+ dictionary so files are unaffected by the representation.
+*/
+@interface DKMetadataStorage : NSMutableDictionary {
+@private
+	DKMetadataKeyTable* mKeyTable;
+	NSMutableArray* mValues;
+	BOOL mOwnsValues;
+}
+
+- (instancetype)initWithKeyTable:(DKMetadataKeyTable*)table;
+
+@end
+
+@implementation DKMetadataStorage
+
+- (instancetype)initWithKeyTable:(DKMetadataKeyTable*)table
+{
+	NSAssert(table != nil, @"metadata storage requires a key table");
+
+	self = [super init];
+	if (self) {
+		mKeyTable = table;
+		mValues = [[NSMutableArray alloc] init];
+		mOwnsValues = YES;
+	}
+
+	return self;
+}
+
+- (void)ensureIndividualValues
+{
+	// copy-on-write: a value array shared with a copy is duplicated on the first mutation of either side
+
+	if (!mOwnsValues) {
+		mValues = [mValues mutableCopy];
+		mOwnsValues = YES;
+	}
+}
+
+#pragma mark As an NSDictionary
+
+- (NSUInteger)count
+{
+	NSUInteger total = 0;
+
+	for (id value in mValues) {
+		if (value != [NSNull null])
+			++total;
+	}
+
+	return total;
+}
+
+- (id)objectForKey:(id)key
+{
+	NSUInteger slot = [mKeyTable slotForKey:key
+							 createIfNeeded:NO];
+
+	if (slot == NSNotFound || slot >= [mValues count])
+		return nil;
+
+	id value = [mValues objectAtIndex:slot];
+	return (value == [NSNull null]) ? nil : value;
+}
+
+- (NSEnumerator*)keyEnumerator
+{
+	NSMutableArray* presentKeys = [NSMutableArray arrayWithCapacity:[mValues count]];
+
+	[mValues enumerateObjectsUsingBlock:^(id value, NSUInteger slot, BOOL* stop) {
+#pragma unused(stop)
+		if (value != [NSNull null])
+			[presentKeys addObject:[mKeyTable keyForSlot:slot]];
+	}];
+
+	return [presentKeys objectEnumerator];
+}
+
+#pragma mark As an NSMutableDictionary
+
+- (void)setObject:(id)object forKey:(id<NSCopying>)key
+{
+	NSAssert(object != nil, @"cannot store nil in metadata storage");
+
+	[self ensureIndividualValues];
+
+	NSUInteger slot = [mKeyTable slotForKey:(NSString*)key
+							 createIfNeeded:YES];
+
+	while ([mValues count] <= slot)
+		[mValues addObject:[NSNull null]];
+
+	[mValues replaceObjectAtIndex:slot
+					   withObject:object];
+}
+
+- (void)removeObjectForKey:(id)key
+{
+	NSUInteger slot = [mKeyTable slotForKey:key
+							 createIfNeeded:NO];
+
+	if (slot != NSNotFound && slot < [mValues count]) {
+		[self ensureIndividualValues];
+		[mValues replaceObjectAtIndex:slot
+						   withObject:[NSNull null]];
+	}
+}
+
+#pragma mark As an NSObject
+
+- (id)mutableCopyWithZone:(NSZone*)zone
+{
+#pragma unused(zone)
+	DKMetadataStorage* copy = [[DKMetadataStorage alloc] initWithKeyTable:mKeyTable];
+
+	copy->mValues = mValues;
+	copy->mOwnsValues = NO;
+	mOwnsValues = NO;
+
+	return copy;
+}
+
+- (Class)classForCoder
+{
+	// archives as an ordinary dictionary, so files do not depend on the storage representation
+
+	return [NSMutableDictionary class];
+}
+
+@end
+
+#pragma mark -
+
+static BOOL sMetadataStorageIsShared = NO;
+
 @implementation DKDrawableObject (Metadata)
 #pragma mark As a DKDrawableObject
 
@@ -30,6 +258,16 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	return ![[NSUserDefaults standardUserDefaults] boolForKey:kDKUndoableChangesUserDefaultsKey];
 }
 
++ (void)setMetadataStorageIsShared:(BOOL)shared
+{
+	sMetadataStorageIsShared = shared;
+}
+
++ (BOOL)metadataStorageIsShared
+{
+	return sMetadataStorageIsShared;
+}
+
 - (NSMutableDictionary*)metadata
 {
 #if USE_107_OR_LATER_SCHEMA
@@ -47,11 +285,21 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 - (void)setupMetadata
 {
 	if ([self metadata] == nil && ![self locked]) {
+		// in the shared storage mode the new store interns its keys in the layer's table and keeps only a compact
+		// value array per object - see DKMetadataStorage above. Otherwise a conventional dictionary is used.
+
+		NSMutableDictionary* store;
+
+		if ([[self class] metadataStorageIsShared])
+			store = [[DKMetadataStorage alloc] initWithKeyTable:[DKMetadataKeyTable keyTableForLayer:[self layer]]];
+		else
+			store = [NSMutableDictionary dictionary];
+
 #if USE_107_OR_LATER_SCHEMA
-		[self setUserInfoObject:[NSMutableDictionary dictionary]
+		[self setUserInfoObject:store
 						 forKey:kDKMetaDataUserInfo107OrLaterKey];
 #else
-		[self setUserInfoObject:[NSMutableDictionary dictionary]
+		[self setUserInfoObject:store
 						 forKey:kDKMetaDataUserInfoKey];
 #endif
 	}
@@ -99,7 +347,9 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 		[[self metadata] setObject:item
 							forKey:[key lowercaseString]];
 
-		[self notifyVisualChange];
+		if ([self metadataKeyAffectsDisplay:key])
+			[self notifyVisualChange];
+
 		[self metadataDidChangeKey:key];
 	}
 }
@@ -151,6 +401,11 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	// item doesn't exist already.
 
 	if (![self locked]) {
+		// as the item itself is mutated, detach any shared user info before looking it up so that the
+		// change is made to this object's private copy of the item
+
+		[self detachSharedUserInfo];
+
 		DKMetadataItem* item = [self metadataItemForKey:key];
 
 		if (item) {
@@ -160,7 +415,9 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 			[self metadataWillChangeKey:key];
 			[item setValue:value];
-			[self notifyVisualChange];
+			if ([self metadataKeyAffectsDisplay:key])
+				[self notifyVisualChange];
+
 			[self metadataDidChangeKey:key];
 		}
 	}
@@ -172,6 +429,11 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	// query an item to see if a type change would be lossy before calling this if necessary.
 
 	if (![self locked]) {
+		// as with -setMetadataItemValue:forKey:, the item is mutated in place so any shared user info
+		// must be detached before the item is looked up
+
+		[self detachSharedUserInfo];
+
 		DKMetadataItem* item = [self metadataItemForKey:key];
 
 		if (item) {
@@ -185,7 +447,9 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 			[self metadataWillChangeKey:key];
 			[item setType:type];
-			[self notifyVisualChange];
+			if ([self metadataKeyAffectsDisplay:key])
+				[self notifyVisualChange];
+
 			[self metadataDidChangeKey:key];
 		}
 	}
@@ -438,6 +702,28 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	// this (misnamed) method is reposible for migrating the metadata to the latest schema. It is called afer dearchiving the object's
 	// metadata.
 
+	// the migration mutates the user info directly, so it must own a private copy
+
+	[self detachSharedUserInfo];
+
+	// metadata written by the compact archiving fast path arrives as a single data blob - reconstitute the
+	// items dictionary before anything looks for it. See -userInfoForArchiving.
+
+	id stored = [self userInfoObjectForKey:kDKMetaDataUserInfo107OrLaterKey];
+
+	if ([stored isKindOfClass:[NSData class]]) {
+		NSMutableDictionary* itemDict = [DKMetadataItem metadataItemDictionaryWithCompactData:(NSData*)stored];
+
+		if (itemDict == nil) {
+			LogEvent_(kWheneverEvent, @"malformed compact metadata blob - discarding");
+			itemDict = [NSMutableDictionary dictionary];
+		}
+
+		[self setUserInfoObject:itemDict
+						 forKey:kDKMetaDataUserInfo107OrLaterKey];
+		return;
+	}
+
 	// which schema is the object using? It will be one of three possible
 
 	DKMetadataSchema schema = [self schema];
@@ -492,6 +778,33 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 #endif
 }
 
+- (NSDictionary*)userInfoForArchiving
+{
+	// returns the user info as it should be written to an archive. Keyed-archiving each metadata item as a
+	// separate object dominates the time taken to dearchive metadata-heavy files, so when the compact fast
+	// path is in force the items dictionary is replaced by a single blob. Dictionaries the compact format
+	// cannot carry, and the case where the option is off, archive conventionally as before.
+
+	NSDictionary* userInfo = [self userInfo];
+
+#if USE_107_OR_LATER_SCHEMA
+	NSDictionary* meta = [self metadata];
+
+	if (userInfo != nil && meta != nil && [DKMetadataItem compactArchivingEnabled]) {
+		NSData* blob = [DKMetadataItem compactDataWithMetadataItemDictionary:meta];
+
+		if (blob != nil) {
+			NSMutableDictionary* infoCopy = [userInfo mutableCopy];
+			[infoCopy setObject:blob
+						 forKey:kDKMetaDataUserInfo107OrLaterKey];
+			return infoCopy;
+		}
+	}
+#endif
+
+	return userInfo;
+}
+
 - (NSUInteger)metadataChecksum
 {
 	// returns a number that is derived from the content of the metadata. If it changes, it means the metadata changed in some way. Don't interpret or store
@@ -520,6 +833,11 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 
 - (void)metadataWillChangeKey:(NSString*)key
 {
+	// the metadata lives within the user info, which may be shared with a copy of the object until
+	// one of them is mutated - make sure this object owns a private copy before the change goes ahead
+
+	[self detachSharedUserInfo];
+
 	NSDictionary* userInfo = nil;
 	if (key)
 		userInfo = @{ @"key": [key lowercaseString] };
@@ -536,6 +854,40 @@ NSString* const kDKUndoableChangesUserDefaultsKey = @"DKMetadataChangesAreNotUnd
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataDidChangeNotification
 														object:self
 													  userInfo:userInfo];
+
+	// also queue the coalesced per-turn notification - a burst of writes to this object produces just
+	// one of these, delivered when the runloop next idles
+
+	[[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:kDKMetadataChangesDidOccurNotification
+																						  object:self]
+											   postingStyle:NSPostASAP
+											   coalesceMask:NSNotificationCoalescingOnName | NSNotificationCoalescingOnSender
+												   forModes:nil];
+}
+
+- (BOOL)metadataKeyAffectsDisplay:(NSString*)key
+{
+	// metadata only reaches pixels through text substitution, so a write can only require a redraw if a
+	// text adornment in the object's style actually references the changed key. A nil key means a
+	// wholesale change, which is display-affecting if any substitution key exists at all.
+
+	NSArray* adornments = [[self style] renderersOfClass:[DKTextAdornment class]];
+
+	for (DKTextAdornment* ta in adornments) {
+		NSArray<NSString*>* subKeys = [[ta textSubstitutor] allKeys];
+
+		if (key == nil) {
+			if ([subKeys count] > 0)
+				return YES;
+		} else {
+			for (NSString* subKey in subKeys) {
+				if ([subKey caseInsensitiveCompare:key] == NSOrderedSame)
+					return YES;
+			}
+		}
+	}
+
+	return NO;
 }
 
 @end
@@ -646,7 +998,9 @@ NSString* const kDKPrivateShapeOriginalText = @"Original Text";
 		[self metadataWillChangeKey:key];
 		[[self metadata] setObject:obj
 							forKey:[key lowercaseString]];
-		[self notifyVisualChange];
+		if ([self metadataKeyAffectsDisplay:key])
+			[self notifyVisualChange];
+
 		[self metadataDidChangeKey:key];
 	}
 }
@@ -14,6 +14,15 @@ NS_ASSUME_NONNULL_BEGIN
 
 @class DKObjectOwnerLayer, DKStyle, DKDrawing, DKDrawingTool, DKShapeGroup;
 
+/** @brief An object's geometric properties gathered into one value, applied as a single transaction by <code>-applyGeometry:</code>.
+ */
+typedef struct DKDrawableGeometry {
+	NSPoint location; //!< location within the drawing
+	CGFloat angle; //!< angle in radians
+	NSSize size; //!< size, invariant with angle
+	NSSize offset; //!< relative offset of the anchor point
+} DKDrawableGeometry;
+
 /** @brief This object is responsible for the visual representation of the selection as well as any content.
 
  A drawable object is owned by a <code>DKObjectDrawingLayer</code>, which is responsible for drawing it when required and handling
@@ -38,6 +47,7 @@ NS_ASSUME_NONNULL_BEGIN
 	DKStyle* m_style; // the drawing style attached
 	__weak id<DKObjectStorage> mStorageRef; // ref to the object's storage (DKStorableObject protocol)
 	NSMutableDictionary* mUserInfo; // user info including metadata is stored in this dictionary
+	BOOL mUserInfoShared; // YES while the user info is shared with a copy of the object (copy-on-write)
 	NSSize m_mouseOffset; // used to track where mouse was relative to bounds
 	NSUInteger mZIndex; // used by the DKStorableObject protocol
 	BOOL m_visible; // YES if visible
@@ -50,6 +60,16 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL mGhosted; // YES if object is drawn ghosted
 	BOOL mIsHitTesting; // YES when drawContent is called for the purposes of hit-testing
 	NSMutableDictionary* mRenderingCache; // a dictionary to support general caching by renderers
+	CGPathRef mCachedQuartzPath; // cached CGPath conversion of the rendering path, rebuilt after a visual change
+	int8_t* mHitTestMaskBits; // coarse signed-distance raster used to answer hit tests without drawing
+	NSUInteger mHitTestMaskWidth; // mask dimensions in cells
+	NSUInteger mHitTestMaskHeight;
+	NSRect mHitTestMaskBounds; // the bounds the mask was built for
+	NSString* mUniqueKey; // stable identity for the object, assigned lazily and archived
+	NSUInteger mChangeSequence; // global sequence number of this object's most recent visual change
+@package
+	NSRect mCachedBounds; // memoized result of -bounds, refilled lazily by -cachedBounds
+	BOOL mCachedBoundsValid; // cleared by -notifyVisualChange; while set, mCachedBounds may be read directly
 @protected
 	BOOL m_showBBox : 1; // debugging - display the object's bounding box
 	BOOL m_clipToBBox : 1; // debugging - force clip region to the bbox
@@ -212,6 +232,30 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly) NSUInteger indexInContainer;
 
+/** @}
+ @name Identity And Change Tracking
+ @{ */
+
+/** @brief A key that uniquely identifies this object for its entire lifetime.
+
+ The key is assigned (from DKUniqueID) the first time it is asked for and is archived with the
+ object, so the same object keeps the same key across save/load cycles. Copies receive their own
+ keys. Incremental (journalled) saving uses this to associate change records with objects.
+ */
+@property (readonly, copy) NSString* uniqueKey;
+
+/** @brief The global change sequence number at the time of this object's most recent visual change.
+
+ Every call to \c -notifyVisualChange stamps the object from a single monotonically increasing
+ counter, so a client can record \c +currentChangeSequence at one moment and later find everything
+ that changed since by comparing against this value. Not archived.
+ */
+@property (readonly) NSUInteger changeSequence;
+
+/** @brief The most recently issued change sequence number across all drawable objects.
+ */
+@property (class, readonly) NSUInteger currentChangeSequence;
+
 /** @}
  @name State
  @{ */
@@ -384,6 +428,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)drawSelectionPath:(NSBezierPath*)path;
 
+/** @brief The rects that must be repainted to add or remove this object's selection highlight.
+
+ Used by the owning layer to invalidate only the selection visuals when the selection changes, rather
+ than the object's full bounds (which include the style's extra space). The default returns the bounds
+ as a single rect, which is always safe; subclasses whose selected state draws only a frame and handles
+ return the individual strips and handle rects, so that changing the selection of many objects repaints
+ only those pixels.
+ */
+- (NSArray<NSValue*>*)selectionHighlightRefreshRects;
+
 /** @}
  @name Refresh Notifiers
  @{ */
@@ -441,6 +495,17 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setNeedsDisplayInRects:(NSSet<NSValue*>*)setOfRects withExtraPadding:(NSSize)padding;
 
 - (nullable NSBezierPath*)renderingPath;
+
+/** @brief Returns an immutable Quartz path equivalent to -renderingPath, cached across redraws.
+
+ The conversion from NSBezierPath to CGPath re-walks every element, which dominates rendering time for
+ very large paths. The result of the first call is retained and handed back on subsequent calls until the
+ object signals a visual change (-notifyVisualChange or -invalidateRenderingCache), so steady-state
+ redraws pass Quartz a prebuilt path. The returned path is owned by the object - retain it if it needs
+ to outlive the object's next visual change.
+ */
+@property (readonly, nullable) CGPathRef quartzPath CF_RETURNS_NOT_RETAINED;
+
 @property (readonly) BOOL useLowQualityDrawing;
 
 /** @brief Return a number that changes when any aspect of the geometry changes. This can be used to detect
@@ -485,10 +550,14 @@ NS_ASSUME_NONNULL_BEGIN
 @property (nonatomic, copy, nullable) DKStyle* style;
 
 /** @brief Called when the attached style is about to change.
+
+ Invoked directly by the style on each of its clients; the note's object is the style.
  */
 - (void)styleWillChange:(NSNotification*)note;
 
 /** @brief Called just after the attached style has changed.
+
+ Invoked directly by the style on each of its clients; the note's object is the style.
  */
 - (void)styleDidChange:(NSNotification*)note;
 
@@ -617,6 +686,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)resetOffset;
 
+/** @}
+ @name Geometry Transactions
+ @{ */
+
+/** @brief The object's location, angle, size and offset gathered into one value, suitable for passing back to <code>-applyGeometry:</code>. */
+@property (readonly) DKDrawableGeometry geometry;
+
+/** @brief Sets any combination of location, angle, size and offset as one transaction.
+
+ Unchanged fields are ignored, so callers typically start from \c -geometry and alter what they
+ need. Subclasses that can coalesce the separate setters' work override this to perform a single
+ invalidation/undo/notification cycle (see DKDrawableShape); the base implementation simply applies
+ the properties individually. Tools that update several properties per event should prefer this
+ over consecutive setter calls.
+ */
+- (void)applyGeometry:(DKDrawableGeometry)geom;
+
 /** @}
  @name Path Transforms
  @{ */
@@ -656,6 +742,17 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly) NSRect bounds;
 
+/** @brief Returns the bounds, memoized between visual changes.
+
+ Most subclasses recompute \c -bounds from the path and style geometry (e.g. <code>-extraSpaceNeeded</code>)
+ on every call, and it is queried several times per object per frame by culling, hit testing and
+ invalidation. This fills a cached slot from \c -bounds on the first call after a visual change and
+ returns the slot thereafter; \c -notifyVisualChange invalidates it. The inline function
+ \c DKDrawableObjectBounds reads the slot without even a message send when it is valid.
+ @return the full bounds of the object
+ */
+@property (readonly) NSRect cachedBounds;
+
 /** @brief Returns the visually apparent bounds
 
  This bounds is intended for use when aligning objects to each other or to guides, etc. By default
@@ -820,14 +917,54 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** @brief Test whether the object intersects a given rectangle.
 
- Used for selecting using a marquee, and other things. The default hit tests by rendering the object
- into a special 1-byte bitmap and testing its alpha channel - this is fast and efficient and in most
- simple cases doesn't need to be overridden.
+ Used for selecting using a marquee, and other things. The test is a cheap-first cascade: the memoized
+ axis-aligned bounds (see <code>-cachedBounds</code>), then <code>-intersectsOrientedBounds:</code> for
+ rotated subclasses, and only if neither tier can decide, the precise render-based test - each tier
+ exiting early. In most simple cases none of this needs to be overridden.
  @param rect The rect to test against.
  @return \c YES if the object intersects the rect, \c NO otherwise.
  */
 - (BOOL)intersectsRect:(NSRect)rect;
 
+/** @brief Middle tier of the \c -intersectsRect: cascade.
+
+ Called only after the rect has hit the axis-aligned bounds without fully enclosing them. Subclasses
+ whose geometry is rotated (e.g. <code>DKDrawableShape</code>) override this to reject against their
+ oriented bounding box, which for a rotated object is much tighter than the axis-aligned bounds and far
+ cheaper than the render-based path test. Must be conservative: return \c NO only when the precise test
+ cannot possibly hit. The default returns \c YES (undecided), as the base class has no rotation.
+ @param rect The rect to test against.
+ @return \c NO if the rect definitely misses the object, \c YES to defer to the precise test.
+ */
+- (BOOL)intersectsOrientedBounds:(NSRect)rect;
+
+/** @brief Supplies a conservative oriented culling box for the storage mirror.
+
+ The box is centred on the middle of <code>-bounds</code>; \c cosine and \c sine give its local x-axis
+ direction and \c uExtent / \c vExtent the half extents along and perpendicular to it. The extents are
+ inflated so that the box is guaranteed to contain everything the axis-aligned bounds contain beyond
+ the raw geometry (style extra space, selection knobs), which keeps a rejection against the box safe.
+ Returns \c NO when the axis-aligned bounds are already tight - no rotation, or a transient state the
+ box cannot conservatively describe - in which case the caller should cull on the bounds alone. The
+ base class always returns \c NO; \c DKDrawableShape overrides using its maintained angle and size.
+ @return \c YES if an oriented box was supplied
+ */
+- (BOOL)getOrientedCullingBoxCosine:(CGFloat*)cosine sine:(CGFloat*)sine uExtent:(CGFloat*)uExtent vExtent:(CGFloat*)vExtent;
+
+/** @brief Returns the running counters for the \c -intersectsRect: cascade.
+
+ Keys are <code>coarseRejects</code>, <code>coarseAccepts</code>, <code>orientedRejects</code>,
+ <code>pathTests</code> and <code>pathHits</code>; values accumulate across all objects since launch or
+ the last <code>+resetCullTestCounters</code>. Intended for verifying cull rates in the field alongside
+ the signpost instrumentation - a healthy scene resolves the vast majority of tests in the first two tiers.
+ @return a dictionary of counter values
+ */
++ (NSDictionary<NSString*, NSNumber*>*)cullTestCounters;
+
+/** @brief Resets the \c -intersectsRect: cascade counters to zero.
+ */
++ (void)resetCullTestCounters;
+
 /** @brief Hit test the object.
 
  Part codes are private to the object class, except for \c 0 = nothing hit and \c -1 = entire object hit.
@@ -875,6 +1012,27 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)rectHitsPath:(NSRect)r;
 
+/** @brief Discards the coarse distance-field mask used to answer hit tests cheaply.
+
+ The mask is a small signed-distance raster derived from the object's drawn pixels, built lazily the first time a hit
+ test needs it and consulted by \c -rectHitsPath: before the precise (and far more expensive) bitmap test - hover
+ tracking over objects that are not actually hit never touches a drawing context, and with
+ \c +setFastHitConfirmationEnabled: queries deep inside fat strokes are confirmed without one either. Called
+ automatically by \c -notifyVisualChange.
+ */
+- (void)invalidateHitTestMask;
+
+/** @brief Whether hit tests may be confirmed, as well as rejected, from the distance-field mask
+
+ Rejection from the mask is always on - it can never change results, only avoid work. Confirmation answers "well
+ within the drawn area" in O(1), which is a large win for hover tracking over fat multi-stroke styles, but treats the
+ whole drawn footprint as solid: with sparse fills such as wide-spaced hatching, points falling in gaps smaller than
+ a mask cell will register as hits. Off by default; appropriate for documents of solid-stroked content such as
+ schematics. The setting is persistent.
+ */
++ (void)setFastHitConfirmationEnabled:(BOOL)enable;
++ (BOOL)fastHitConfirmationEnabled;
+
 /** @brief Test a point against the offscreen bitmap representation of the shape
 
  Special case of the \crectHitsPath call, which is now the fastest way to perform this test.
@@ -1034,6 +1192,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)setUserInfoObject:(id)obj forKey:(NSString*)key;
 
+/** @brief Take a private copy of the user info if it is currently shared with a copy of the object.
+
+ Copying an object does not deep copy its user info up front - the original and the copy share the
+ dictionary until one of them mutates it (copy-on-write), which makes duplication of objects carrying
+ a lot of metadata cheap. All of the user info and metadata setters call this automatically; it only
+ needs to be called directly by code that mutates the dictionary returned by \c -userInfo in place.
+ */
+- (void)detachSharedUserInfo;
+
 /** @}
  @name Cache Management
  @{ */
@@ -1046,6 +1213,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)invalidateRenderingCache;
 
+/** @brief Discard the cached Quartz path, if any
+
+ Called automatically by -notifyVisualChange and -invalidateRenderingCache; the path is lazily rebuilt
+ by the next call to -quartzPath.
+ */
+- (void)invalidateQuartzPathCache;
+
 /** @brief Returns an image of the object representing its current appearance at 100% scale.
 
  This image is stored in the rendering cache. If the cache is empty the image is recreated. This
@@ -1116,6 +1290,17 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+/** @brief Nonvirtual fast path for <code>-cachedBounds</code>.
+
+ Reads the memoized bounds slot directly when it is valid, avoiding the message send as well as the
+ geometry recomputation. Intended for hot per-candidate loops inside the framework, such as the
+ storage classes' spatial queries - client code should use \c -bounds or \c -cachedBounds instead.
+ */
+NS_INLINE NSRect DKDrawableObjectBounds(DKDrawableObject* obj)
+{
+	return obj->mCachedBoundsValid ? obj->mCachedBounds : [obj cachedBounds];
+}
+
 /** @name Public Partcodes
  @brief Partcodes that are known to the layer - most are private to the drawable object class, but these are public.
  @{ */
@@ -15,11 +15,14 @@
 #import "DKObjectDrawingLayer+Alignment.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKPasteboardInfo.h"
+#import "DKPerformanceCounters.h"
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
+#import "DKUniqueID.h"
 #import "LogEvent.h"
 #import "NSAffineTransform+DKAdditions.h"
 #import "NSBezierPath+Combinatorial.h"
+#import "NSBezierPath+Geometry.h"
 #import "NSColor+DKAdditions.h"
 #import "NSDictionary+DeepCopy.h"
 
@@ -28,6 +31,8 @@
 #include <tgmath.h>
 #endif
 
+#include <stdatomic.h>
+
 #pragma mark Contants(Non - localized)
 NSString* const kDKDrawableDidChangeNotification = @"kDKDrawableDidChangeNotification";
 NSString* const kDKDrawableStyleWillBeDetachedNotification = @"kDKDrawableStyleWillBeDetachedNotification";
@@ -58,6 +63,17 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 	return ![[NSUserDefaults standardUserDefaults] boolForKey:kDKDragFeedbackEnabledPreferencesKey];
 }
 
++ (void)setFastHitConfirmationEnabled:(BOOL)enable
+{
+	[[NSUserDefaults standardUserDefaults] setBool:enable
+											forKey:@"DKDrawableObject_fastHitConfirmation"];
+}
+
++ (BOOL)fastHitConfirmationEnabled
+{
+	return [[NSUserDefaults standardUserDefaults] boolForKey:@"DKDrawableObject_fastHitConfirmation"];
+}
+
 + (void)setDisplaysSizeInfoWhenDragging:(BOOL)doesDisplay
 {
 	[[NSUserDefaults standardUserDefaults] setBool:!doesDisplay
@@ -99,6 +115,22 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 + (NSArray*)nativeObjectsFromPasteboard:(NSPasteboard*)pb
 {
+	// fast path: if the pasteboard was written by this process and the originating layer still owns it,
+	// the copied objects themselves are registered in memory - duplicate them directly instead of
+	// triggering the archive promise and dearchiving the result.
+
+	DKPasteboardInfo* info = [DKPasteboardInfo pasteboardInfoWithPasteboard:pb];
+	NSArray* local = [info localObjects];
+
+	if ([local count] > 0) {
+		NSMutableArray* copies = [NSMutableArray arrayWithCapacity:[local count]];
+
+		for (DKDrawableObject* obj in local)
+			[copies addObject:[obj copy]];
+
+		return copies;
+	}
+
 	NSData* pbdata = [pb dataForType:kDKDrawableObjectPasteboardType];
 	NSArray* objects = nil;
 
@@ -357,25 +389,13 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 {
 #pragma unused(aLayer)
 
-	// begin observing style changes
-
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(styleWillChange:)
-												 name:kDKStyleWillChangeNotification
-											   object:[self style]];
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(styleDidChange:)
-												 name:kDKStyleDidChangeNotification
-											   object:[self style]];
+	// style changes are delivered directly by the style to its attached clients, so no observation
+	// needs to be established here - the style already knows about us from -styleWasAttached:
 }
 
 - (void)objectWasRemovedFromLayer:(DKObjectOwnerLayer*)aLayer
 {
 #pragma unused(aLayer)
-
-	[[NSNotificationCenter defaultCenter] removeObserver:self
-													name:nil
-												  object:[self style]];
 }
 
 #pragma mark -
@@ -492,8 +512,43 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 	[path stroke];
 }
 
+- (NSArray<NSValue*>*)selectionHighlightRefreshRects
+{
+	// the bounds always cover whatever -drawSelectedState draws; subclasses return tighter rects
+
+	return @[[NSValue valueWithRect:[self bounds]]];
+}
+
+static NSUInteger s_changeSequence = 0;
+
+- (NSString*)uniqueKey
+{
+	if (mUniqueKey == nil)
+		mUniqueKey = [[DKUniqueID uniqueKey] copy];
+
+	return mUniqueKey;
+}
+
+@synthesize changeSequence = mChangeSequence;
+
++ (NSUInteger)currentChangeSequence
+{
+	return s_changeSequence;
+}
+
 - (void)notifyVisualChange
 {
+	mCachedBoundsValid = NO;
+	mChangeSequence = ++s_changeSequence;
+
+	[self invalidateQuartzPathCache];
+	[self invalidateHitTestMask];
+
+	// let a caching container (e.g. a group) know that any aggregate it keeps may now be stale
+
+	if ([[self container] respondsToSelector:@selector(drawableDidChangeBounds:)])
+		[[self container] drawableDidChangeBounds:self];
+
 	if ([self layer])
 		[[self layer] drawable:self
 			needsDisplayInRect:[self bounds]];
@@ -606,26 +661,8 @@ static NSDictionary<NSString*, Class>* s_interconversionTable = nil;
 
 		NSRect oldBounds = [self bounds];
 
-		// subscribe to change notifications from the style so we can refresh and undo changes
-
-		if (m_style)
-			[[NSNotificationCenter defaultCenter] removeObserver:self
-															name:nil
-														  object:m_style];
-
-		// adding observers is slow, noticeable when creating many objects at a time (for example when reading a file). To help, the observer
-		// is not added straight away unless we are already part of a layer. The observation will be established when the object is added to the layer.
-
-		if (newStyle && [self layer]) {
-			[[NSNotificationCenter defaultCenter] addObserver:self
-													 selector:@selector(styleWillChange:)
-														 name:kDKStyleWillChangeNotification
-													   object:newStyle];
-			[[NSNotificationCenter defaultCenter] addObserver:self
-													 selector:@selector(styleDidChange:)
-														 name:kDKStyleDidChangeNotification
-													   object:newStyle];
-		}
+		// no notification observation is set up here - the style delivers its change messages directly
+		// to the clients recorded by -styleWasAttached:/-styleWillBeRemoved: below
 
 		// set up the user info. If newStyle is nil, this will terminate the list after the old style
 
@@ -764,21 +801,89 @@ static NSRect s_oldBounds;
 
 #pragma mark -
 
+// running counters for the -intersectsRect: cascade, exposed via +cullTestCounters. Relaxed atomics so the
+// increments cost next to nothing and stay safe if culling ever runs off the main thread.
+
+static atomic_uint_fast64_t sCullCoarseRejects;
+static atomic_uint_fast64_t sCullCoarseAccepts;
+static atomic_uint_fast64_t sCullOrientedRejects;
+static atomic_uint_fast64_t sCullPathTests;
+static atomic_uint_fast64_t sCullPathHits;
+
++ (NSDictionary<NSString*, NSNumber*>*)cullTestCounters
+{
+	return @{ @"coarseRejects": @(atomic_load_explicit(&sCullCoarseRejects, memory_order_relaxed)),
+		@"coarseAccepts": @(atomic_load_explicit(&sCullCoarseAccepts, memory_order_relaxed)),
+		@"orientedRejects": @(atomic_load_explicit(&sCullOrientedRejects, memory_order_relaxed)),
+		@"pathTests": @(atomic_load_explicit(&sCullPathTests, memory_order_relaxed)),
+		@"pathHits": @(atomic_load_explicit(&sCullPathHits, memory_order_relaxed)) };
+}
+
++ (void)resetCullTestCounters
+{
+	atomic_store_explicit(&sCullCoarseRejects, 0, memory_order_relaxed);
+	atomic_store_explicit(&sCullCoarseAccepts, 0, memory_order_relaxed);
+	atomic_store_explicit(&sCullOrientedRejects, 0, memory_order_relaxed);
+	atomic_store_explicit(&sCullPathTests, 0, memory_order_relaxed);
+	atomic_store_explicit(&sCullPathHits, 0, memory_order_relaxed);
+}
+
 - (BOOL)intersectsRect:(NSRect)rect
 {
-	NSRect ir, br = [self bounds];
+	if (![self visible])
+		return NO; // invisible objects don't intersect anything
 
-	if ([self visible] && NSIntersectsRect(br, rect)) {
-		// if <rect> fully encloses the bounds, no further tests are needed and we can return YES immediately
+	// cheap-first cascade: memoized axis-aligned bounds, then the oriented box for rotated subclasses,
+	// and only when neither tier can decide, the expensive render-based path test
 
-		ir = NSIntersectionRect(rect, br);
+	NSRect ir, br = [self cachedBounds];
 
-		if (NSEqualRects(ir, br))
-			return YES;
-		else
-			return [self rectHitsPath:rect];
-	} else
-		return NO; // invisible objects don't intersect anything
+	if (!NSIntersectsRect(br, rect)) {
+		atomic_fetch_add_explicit(&sCullCoarseRejects, 1, memory_order_relaxed);
+		return NO;
+	}
+
+	// if <rect> fully encloses the bounds, no further tests are needed and we can return YES immediately
+
+	ir = NSIntersectionRect(rect, br);
+
+	if (NSEqualRects(ir, br)) {
+		atomic_fetch_add_explicit(&sCullCoarseAccepts, 1, memory_order_relaxed);
+		return YES;
+	}
+
+	if (![self intersectsOrientedBounds:rect]) {
+		atomic_fetch_add_explicit(&sCullOrientedRejects, 1, memory_order_relaxed);
+		return NO;
+	}
+
+	atomic_fetch_add_explicit(&sCullPathTests, 1, memory_order_relaxed);
+
+	BOOL hit = [self rectHitsPath:rect];
+
+	if (hit)
+		atomic_fetch_add_explicit(&sCullPathHits, 1, memory_order_relaxed);
+
+	return hit;
+}
+
+- (BOOL)intersectsOrientedBounds:(NSRect)rect
+{
+#pragma unused(rect)
+
+	// the base class has no concept of rotation, so the axis-aligned bounds already tested is the
+	// tightest box available - defer to the precise test
+
+	return YES;
+}
+
+- (BOOL)getOrientedCullingBoxCosine:(CGFloat*)cosine sine:(CGFloat*)sine uExtent:(CGFloat*)uExtent vExtent:(CGFloat*)vExtent
+{
+#pragma unused(cosine, sine, uExtent, vExtent)
+
+	// no rotation in the base class - the axis-aligned bounds are already tight
+
+	return NO;
 }
 
 - (void)setLocation:(NSPoint)p
@@ -834,6 +939,204 @@ static NSRect s_oldBounds;
 - (void)invalidateRenderingCache
 {
 	[mRenderingCache removeAllObjects];
+	[self invalidateQuartzPathCache];
+}
+
+- (void)invalidateQuartzPathCache
+{
+	if (mCachedQuartzPath != NULL) {
+		CGPathRelease(mCachedQuartzPath);
+		mCachedQuartzPath = NULL;
+	}
+}
+
+#define kDKHitTestMaskMaxDimension 64
+
+- (void)invalidateHitTestMask
+{
+	if (mHitTestMaskBits != NULL) {
+		free(mHitTestMaskBits);
+		mHitTestMaskBits = NULL;
+	}
+
+	mHitTestMaskWidth = mHitTestMaskHeight = 0;
+	mHitTestMaskBounds = NSZeroRect;
+}
+
+- (void)buildHitTestMask
+{
+	// renders the object once, at most 64 cells in its larger dimension, into an alpha-only raster. Non-zero cells mark
+	// where the object actually draws; -hitTestMaskMayContainRect: uses this to throw out misses without rendering.
+
+	[self invalidateHitTestMask];
+
+	NSRect br = [self bounds];
+
+	if (br.size.width <= 0.0 || br.size.height <= 0.0)
+		return;
+
+	CGFloat scale = MIN(1.0, kDKHitTestMaskMaxDimension / MAX(br.size.width, br.size.height));
+	NSUInteger width = MAX(1ul, (NSUInteger)ceil(br.size.width * scale));
+	NSUInteger height = MAX(1ul, (NSUInteger)ceil(br.size.height * scale));
+
+	uint8_t* bits = calloc(width * height, 1);
+
+	if (bits == NULL)
+		return;
+
+	CGContextRef bm = CGBitmapContextCreate(bits, width, height, 8, width, NULL, kCGImageAlphaOnly);
+
+	if (bm == NULL) {
+		free(bits);
+		return;
+	}
+
+	CGContextSetInterpolationQuality(bm, kCGInterpolationNone);
+	CGContextSetShouldAntialias(bm, NO);
+	CGContextSetShouldSmoothFonts(bm, NO);
+
+	NSGraphicsContext* bitmapContext = [NSGraphicsContext graphicsContextWithGraphicsPort:bm
+																				  flipped:YES];
+	[bitmapContext setShouldAntialias:NO];
+
+	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+		[NSGraphicsContext setCurrentContext:bitmapContext];
+
+	mIsHitTesting = YES;
+
+	BOOL drawShadows = [DKStyle setWillDrawShadows:NO];
+	[self drawContentInRect:NSMakeRect(0, 0, width, height)
+				   fromRect:br
+				  withStyle:nil];
+	[DKStyle setWillDrawShadows:drawShadows];
+
+	mIsHitTesting = NO;
+
+	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+
+		CGContextRelease(bm);
+
+	// turn the occupancy raster into a small signed distance field by a two-pass city-block chamfer
+	// transform. Covered cells hold the distance to the nearest empty cell; empty cells hold minus the
+	// distance to the nearest covered cell. A point query can then both reject and confirm hits from a
+	// single cell read - see -hitTestMaskClassifyRect:.
+
+	int32_t* din = malloc(width * height * sizeof(int32_t));
+	int32_t* dout = malloc(width * height * sizeof(int32_t));
+	int8_t* field = malloc(width * height);
+
+	if (din == NULL || dout == NULL || field == NULL) {
+		free(din);
+		free(dout);
+		free(field);
+		free(bits);
+		return;
+	}
+
+	const int32_t farAway = (int32_t)(width + height + 2);
+	NSInteger w = (NSInteger)width, h = (NSInteger)height, row, col, i;
+
+	for (i = 0; i < w * h; ++i) {
+		din[i] = bits[i] ? farAway : 0;
+		dout[i] = bits[i] ? 0 : farAway;
+	}
+
+	// forward pass - cells outside the raster count as empty, since the object draws nothing there
+
+	for (row = 0; row < h; ++row) {
+		for (col = 0; col < w; ++col) {
+			i = row * w + col;
+
+			int32_t dinN = MIN((row > 0) ? din[i - w] : 0, (col > 0) ? din[i - 1] : 0);
+			int32_t doutN = MIN((row > 0) ? dout[i - w] : farAway, (col > 0) ? dout[i - 1] : farAway);
+
+			din[i] = MIN(din[i], dinN + 1);
+			dout[i] = MIN(dout[i], doutN + 1);
+		}
+	}
+
+	// backward pass
+
+	for (row = h - 1; row >= 0; --row) {
+		for (col = w - 1; col >= 0; --col) {
+			i = row * w + col;
+
+			int32_t dinN = MIN((row < h - 1) ? din[i + w] : 0, (col < w - 1) ? din[i + 1] : 0);
+			int32_t doutN = MIN((row < h - 1) ? dout[i + w] : farAway, (col < w - 1) ? dout[i + 1] : farAway);
+
+			din[i] = MIN(din[i], dinN + 1);
+			dout[i] = MIN(dout[i], doutN + 1);
+		}
+	}
+
+	for (i = 0; i < w * h; ++i)
+		field[i] = bits[i] ? (int8_t)MIN(din[i], 127) : (int8_t)-MIN(dout[i], 127);
+
+	free(din);
+	free(dout);
+	free(bits);
+
+	mHitTestMaskBits = field;
+	mHitTestMaskWidth = width;
+	mHitTestMaskHeight = height;
+	mHitTestMaskBounds = br;
+}
+
+- (NSInteger)hitTestMaskClassifyRect:(NSRect)r
+{
+	// O(1) query against the signed distance field: returns -1 when the precise test cannot possibly hit
+	// (nothing is drawn anywhere near the rect), +1 when it cannot possibly miss (the rect lies deep
+	// within drawn coverage), and 0 when only the precise test can decide. Both verdicts are conservative:
+	// the stored city-block distance is converted to a Euclidean bound and two cells of margin absorb the
+	// quantisation of the coarse raster, so anything marginal falls through to the precise test.
+
+	if (mHitTestMaskBits == NULL || !NSEqualRects(mHitTestMaskBounds, [self bounds]))
+		[self buildHitTestMask];
+
+	if (mHitTestMaskBits == NULL)
+		return 0;
+
+	CGFloat sx = (CGFloat)mHitTestMaskWidth / mHitTestMaskBounds.size.width;
+	CGFloat sy = (CGFloat)mHitTestMaskHeight / mHitTestMaskBounds.size.height;
+
+	NSInteger col = (NSInteger)floor((NSMidX(r) - NSMinX(mHitTestMaskBounds)) * sx);
+	NSInteger row = (NSInteger)floor((NSMidY(r) - NSMinY(mHitTestMaskBounds)) * sy);
+
+	col = MAX(0l, MIN(col, (NSInteger)mHitTestMaskWidth - 1));
+	row = MAX(0l, MIN(row, (NSInteger)mHitTestMaskHeight - 1));
+
+	NSInteger v = mHitTestMaskBits[row * (NSInteger)mHitTestMaskWidth + col];
+
+	// the rect's circumradius in cell units is what the distance must clear in either direction
+
+	CGFloat rc = 0.5 * hypot(r.size.width * sx, r.size.height * sy);
+	CGFloat clearance = rc * M_SQRT2 + 2.0;
+
+	if (v < 0 && (CGFloat)(-v) > clearance)
+		return -1;
+
+	if (v > 0 && (CGFloat)v > clearance)
+		return 1;
+
+	return 0;
+}
+
+- (BOOL)hitTestMaskMayContainRect:(NSRect)r
+{
+	return [self hitTestMaskClassifyRect:r] >= 0;
+}
+
+- (CGPathRef)quartzPath
+{
+	// converts -renderingPath once and hands the same immutable CGPath back until the next visual change
+
+	if (mCachedQuartzPath == NULL) {
+		DKPerfCounterAdd(&gDKPerfCounters.quartzPathCacheMisses, 1);
+		mCachedQuartzPath = [[self renderingPath] newQuartzPath];
+	} else
+		DKPerfCounterAdd(&gDKPerfCounters.quartzPathCacheHits, 1);
+
+	return mCachedQuartzPath;
 }
 
 - (NSImage*)cachedImage
@@ -867,6 +1170,32 @@ static NSRect s_oldBounds;
 {
 }
 
+#pragma mark -
+
+- (DKDrawableGeometry)geometry
+{
+	DKDrawableGeometry geom;
+
+	geom.location = [self location];
+	geom.angle = [self angle];
+	geom.size = [self size];
+	geom.offset = [self offset];
+
+	return geom;
+}
+
+- (void)applyGeometry:(DKDrawableGeometry)geom
+{
+	// the base class has no combined update path, so the properties are applied individually in the
+	// same order a caller would. Subclasses able to coalesce the invalidation/undo/notification
+	// cycles override this - see DKDrawableShape.
+
+	[self setLocation:geom.location];
+	[self setAngle:geom.angle];
+	[self setSize:geom.size];
+	[self setOffset:geom.offset];
+}
+
 - (NSAffineTransform*)transform
 {
 	return [NSAffineTransform transform];
@@ -1059,7 +1388,20 @@ static NSRect s_oldBounds;
 
 		if (NSEqualRects(ir, [self bounds]))
 			return YES;
-		else {
+
+		NSInteger verdict = [self hitTestMaskClassifyRect:ir];
+
+		if (verdict < 0) {
+			// the distance field shows nothing drawn anywhere near the rect, so the precise test cannot
+			// succeed - the common case when hover-tracking across a dense layer, and far cheaper than rendering
+
+			return NO;
+		} else if (verdict > 0 && [[self class] fastHitConfirmationEnabled]) {
+			// the rect lies deep within drawn coverage, so the precise test cannot fail. Opt-in because the
+			// field treats the drawn footprint as solid - see +setFastHitConfirmationEnabled:
+
+			return YES;
+		} else {
 			// this method scales the whole hit rect directly down into a 1x1 bitmap context - if it ends up opaque, it's hit. If transparent, it's not.
 			// this method suggested by Ken Ferry (Apple), as it avoids the need for writable access to NSBimapImageRep and so should
 			// perform best on most graphics architectures. This also doesn't require any style substitution.
@@ -1279,8 +1621,12 @@ static NSRect s_oldBounds;
 
 - (void)setUserInfo:(NSDictionary*)info
 {
-	if (mUserInfo == nil)
+	if (mUserInfo == nil || mUserInfoShared) {
+		// content is wholly replaced, so a shared dictionary is simply abandoned rather than deep copied
+
 		mUserInfo = [[NSMutableDictionary alloc] init];
+		mUserInfoShared = NO;
+	}
 
 	[mUserInfo setDictionary:info];
 	[self notifyStatusChange];
@@ -1288,6 +1634,8 @@ static NSRect s_oldBounds;
 
 - (void)addUserInfo:(NSDictionary*)info
 {
+	[self detachSharedUserInfo];
+
 	if (mUserInfo == nil)
 		mUserInfo = [[NSMutableDictionary alloc] init];
 
@@ -1302,6 +1650,22 @@ static NSRect s_oldBounds;
 	return mUserInfo;
 }
 
+- (void)detachSharedUserInfo
+{
+	// following a copy, the user info dictionary is shared between the original and the copy and both are
+	// flagged. Whichever side mutates its user info first calls this and takes a private deep copy, so the
+	// cost of copying the metadata is only paid if and when it is actually needed.
+
+	if (mUserInfoShared) {
+		mUserInfoShared = NO;
+
+		NSDictionary* ucopy = [mUserInfo deepCopy];
+
+		mUserInfo = [[NSMutableDictionary alloc] init];
+		[mUserInfo setDictionary:ucopy];
+	}
+}
+
 - (id)userInfoObjectForKey:(NSString*)key
 {
 	return [[self userInfo] objectForKey:key];
@@ -1312,6 +1676,8 @@ static NSRect s_oldBounds;
 	NSAssert(obj != nil, @"cannot add nil to the user info");
 	NSAssert(key != nil, @"user info key can't be nil");
 
+	[self detachSharedUserInfo];
+
 	if (mUserInfo == nil)
 		mUserInfo = [[NSMutableDictionary alloc] init];
 
@@ -1448,6 +1814,8 @@ static NSRect s_oldBounds;
 - (void)dealloc
 {
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[self invalidateQuartzPathCache];
+	[self invalidateHitTestMask];
 
 	if (m_style != nil) {
 		[m_style styleWillBeRemoved:self];
@@ -1484,7 +1852,7 @@ static NSRect s_oldBounds;
 							forKey:@"container"];
 	[coder encodeObject:[self style]
 				 forKey:@"style"];
-	[coder encodeObject:[self userInfo]
+	[coder encodeObject:[self userInfoForArchiving]
 				 forKey:@"userinfo"];
 
 	[coder encodeBool:[self visible]
@@ -1497,6 +1865,8 @@ static NSRect s_oldBounds;
 			   forKey:@"DKDrawable_ghosted"];
 	[coder encodeBool:[self locationLocked]
 			   forKey:@"DKDrawable_locationLocked"];
+	[coder encodeObject:[self uniqueKey]
+				 forKey:@"DKDrawable_uniqueKey"];
 }
 
 - (instancetype)initWithCoder:(NSCoder*)coder
@@ -1525,6 +1895,7 @@ static NSRect s_oldBounds;
 		m_snapEnable = YES;
 
 		[self setGhosted:[coder decodeBoolForKey:@"DKDrawable_ghosted"]];
+		mUniqueKey = [[coder decodeObjectForKey:@"DKDrawable_uniqueKey"] copy];
 
 		// lock and location lock is not set here, as it prevents subclasses from setting other properties when dearchiving
 		// see -awakeAfterUsingCoder:
@@ -1555,11 +1926,14 @@ static NSRect s_oldBounds;
 
 	[copy setGhosted:[self isGhosted]];
 
-	// gets a deep copy of the user info
+	// the user info (including any metadata) is shared copy-on-write: both objects keep the same
+	// dictionary and one takes a private deep copy only if and when it mutates it - see
+	// -detachSharedUserInfo. This makes duplicating objects that carry a lot of metadata cheap.
 
-	if ([self userInfo] != nil) {
-		NSDictionary* ucopy = [[self userInfo] deepCopy];
-		[copy setUserInfo:ucopy];
+	if (mUserInfo != nil) {
+		copy->mUserInfo = mUserInfo;
+		copy->mUserInfoShared = YES;
+		mUserInfoShared = YES;
 	}
 
 	return copy;
@@ -1662,6 +2036,16 @@ static NSRect s_oldBounds;
 	return NSZeroRect;
 }
 
+- (NSRect)cachedBounds
+{
+	if (!mCachedBoundsValid) {
+		mCachedBounds = [self bounds];
+		mCachedBoundsValid = YES;
+	}
+
+	return mCachedBounds;
+}
+
 - (NSSize)extraSpaceNeeded
 {
 	if ([self style])
@@ -51,9 +51,24 @@ typedef NS_ENUM(NSInteger, DKDrawablePathInsertType) {
 @private
 	NSBezierPath* m_path;
 	NSBezierPath* m_undoPath;
+	NSData* mUndoElementDelta; // sparse element-range undo record captured at mouse down on a partcode
 	DKDrawablePathCreationMode m_editPathMode;
 	CGFloat m_freehandEpsilon;
 	BOOL m_extending;
+	BOOL mPathShared; // YES while the path is shared with a copy of the object (copy-on-write)
+	NSSize mPathTranslation; // translation deferred while the path is shared; baked in by -detachSharedPath
+	NSMutableDictionary* mLODCache; // cached simplified paths per zoom bucket, rebuilt lazily after the path changes
+	NSBezierPath* mLODPath; // transient: substitute rendering path while drawing at low zoom
+	struct DKPathChunkRec* mChunks; // spatial chunk table for very large paths, lazily built - see -chunkedPathForRect:inView:
+	NSUInteger mChunkCount; // number of entries in mChunks
+	NSMutableDictionary* mPartcodeGrid; // control points bucketed into a uniform grid for fast partcode hit-testing
+	NSPoint mPartcodeGridOrigin; // grid origin (control point bounds origin at build time)
+	CGFloat mPartcodeGridCellSize; // grid cell side; queries with a larger tolerance fall back to the full scan
+	NSInteger mPartcodeGridCols; // number of cells across
+	NSPoint mLastPartcodeHitPoint; // deadband: last queried point...
+	NSInteger mLastPartcodeHit; // ...the answer it produced...
+	BOOL mLastPartcodeHitValid; // ...and whether it may be reused
+	BOOL mLastPartcodeHitPriority; // modifier state the memoized answer was computed under
 }
 
 // convenience constructors:
@@ -160,6 +175,24 @@ typedef NS_ENUM(NSInteger, DKDrawablePathInsertType) {
 - (NSBezierPath*)undoPath;
 - (void)clearUndoPath;
 
+/** @brief Captures a sparse undo record for an imminent drag of the given partcode.
+
+ Dragging a control point can only ever alter the points of a handful of elements (the edited element, its
+ immediate neighbours and - for closed subpaths - the elements either side of the loop join), so instead of
+ copying the entire path, this records just those elements' points by index. On very large paths this is a
+ thousand-fold smaller undo record per point-level edit. Falls back to \c -recordPathForUndo if the partcode
+ does not resolve to an element.
+ */
+- (void)recordElementDeltaForUndoWithPartcode:(NSInteger)pc;
+
+/** @brief Restores element points captured by <code>-recordElementDeltaForUndoWithPartcode:</code>.
+
+ Registers the current points of the same elements as the inverse delta before applying, so the method is
+ its own redo. Deltas are only valid while the path's element structure is unchanged; edits that add or
+ remove elements go through \c -setPath: and its full snapshot as before.
+ */
+- (void)applyPathElementDelta:(NSData*)delta;
+
 // modifying paths
 
 /** @brief Merges two paths by simply appending them
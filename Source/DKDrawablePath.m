@@ -7,6 +7,7 @@
 #import "DKDrawablePath.h"
 #import "CurveFit.h"
 #import "DKDrawing.h"
+#import "DKDrawingView.h"
 #import "DKKnob.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKShapeGroup.h"
@@ -25,8 +26,73 @@ NSString* const kDKPathOnPathHitDetectionPriorityDefaultsKey = @"kDKPathOnPathHi
 
 #pragma mark Static Vars
 static CGFloat sAngleConstraint = 0.261799387799; // 15 degrees
+static const CGFloat sMinimumHandleSpacing = 4.0; // screen pixels; below this on-path handles are decimated
 static NSColor* sInfoWindowColour = nil;
 
+// simplified level-of-detail rendering: paths with at least this many elements are rendered from a
+// cached simplified copy when the view is zoomed out - see -levelOfDetailPath
+
+#define kDKPathLODMinimumElements 256
+#define kDKPathLODMaximumBucket 8
+
+// partcode hit-testing: paths with at least this many elements bucket their control points into a
+// uniform grid so each hit test only examines the elements near the point - see -hitSelectedPart:
+
+#define kDKPathPartcodeGridMinimumElements 128
+
+// chunked rendering: truly massive paths (an imported contour can easily run to millions of
+// elements) are split into runs of consecutive elements with per-chunk bounds, so that drawing
+// and hit-testing only walk the elements near the rect in question - see -chunkedPathForRect:inView:
+
+#define kDKPathChunkMinimumElements 8192
+#define kDKPathChunkTargetElements 1024
+
+// per-chunk record. The ranges partition the path's element list in order; the bounds
+// conservatively cover every point (including control points) the chunk's elements reference.
+
+typedef struct DKPathChunkRec {
+	NSRange range; // element range covered by this chunk
+	NSRect bounds; // conservative bounds of all points the range references
+	NSPoint entryPoint; // current point in force just before the first element
+	NSPoint subpathStart; // start of the subpath in force just before the first element
+	BOOL startsSubpath; // YES when the first element is a moveto
+	BOOL included; // transient: relevance flag set per query by -chunkedPathForRect:inView:
+} DKPathChunkRec;
+
+// running extent used while building the table; seeded by the first point so that a degenerate
+// zero origin is never unioned in
+
+typedef struct DKPathChunkExtent {
+	CGFloat minX, minY, maxX, maxY;
+	BOOL seeded;
+} DKPathChunkExtent;
+
+static inline void dkChunkExtentAdd(DKPathChunkExtent* e, NSPoint p)
+{
+	if (!e->seeded) {
+		e->minX = e->maxX = p.x;
+		e->minY = e->maxY = p.y;
+		e->seeded = YES;
+	} else {
+		if (p.x < e->minX)
+			e->minX = p.x;
+		if (p.x > e->maxX)
+			e->maxX = p.x;
+		if (p.y < e->minY)
+			e->minY = p.y;
+		if (p.y > e->maxY)
+			e->maxY = p.y;
+	}
+}
+
+static inline NSRect dkChunkExtentRect(const DKPathChunkExtent* e)
+{
+	if (!e->seeded)
+		return NSZeroRect;
+
+	return NSMakeRect(e->minX, e->minY, e->maxX - e->minX, e->maxY - e->minY);
+}
+
 @interface DKSecretSelectorsDrawablePath : NSObject
 - (IBAction)convertToTrack:(id)sender;
 @end
@@ -36,6 +102,35 @@ static NSColor* sInfoWindowColour = nil;
 /**  */
 - (void)showLengthInfo:(CGFloat)dist atPoint:(NSPoint)p;
 
+/** take a private copy of the path if it is currently shared with a copy of the object */
+- (void)detachSharedPath;
+
+/** returns a simplified stand-in for the path appropriate to the current view scale, or nil if the
+ full-resolution path should be rendered */
+- (NSBezierPath*)levelOfDetailPath;
+
+/** rebuilds the path as straight segments lying within \c tolerance of the original, using
+ Douglas-Peucker reduction of the flattened path */
+- (NSBezierPath*)simplifiedPathWithTolerance:(CGFloat)tolerance;
+
+/** element indexes whose control points lie near <pt>, building the grid if needed, or nil if the
+ path is small enough that the full scan is already cheap */
+- (NSIndexSet*)partcodeGridCandidatesForPoint:(NSPoint)pt tolerance:(CGFloat)tol;
+
+/** drops the control point grid and the hit memo; called whenever the path geometry changes */
+- (void)invalidatePartcodeGrid;
+
+/** builds the chunk table from the current path if it is not already built */
+- (void)rebuildChunkTableIfNeeded;
+
+/** assembles a path containing only the chunks relevant to \c clipRect (tested with
+ <code>-needsToDrawRect:</code> when \c aView is given), or nil when chunking does not apply or
+ every chunk is relevant anyway */
+- (NSBezierPath*)chunkedPathForRect:(NSRect)clipRect inView:(NSView*)aView;
+
+/** frees the chunk table; called whenever the path geometry actually changes */
+- (void)invalidateChunkTable;
+
 @end
 
 #pragma mark -
@@ -190,23 +285,66 @@ static NSColor* sInfoWindowColour = nil;
 
 		[self notifyVisualChange];
 
+		// bake any deferred translation first so the undo snapshot records the true geometry
+
+		[self detachSharedPath];
+
 		NSBezierPath* oldPath = [m_path copy];
 		[[self undoManager] registerUndoWithTarget:self
 										  selector:@selector(setPath:)
 											object:oldPath];
 
 		m_path = path;
+		mPathShared = NO;
+		mLODCache = nil;
+		[self invalidatePartcodeGrid];
+		[self invalidateChunkTable];
 
 		[self notifyVisualChange];
 		[self notifyGeometryChange:oldBounds];
 	}
 }
 
+- (void)detachSharedPath
+{
+	// following a copy, the path instance is shared between the original and the copy and both are
+	// flagged - see -copyWithZone:. Operations that replace the path via -setPath: are safe with a
+	// shared instance, but anything editing the path in place must call this first so that the edit
+	// only affects this object.
+
+	if (mPathShared) {
+		mPathShared = NO;
+		m_path = [m_path copy];
+	}
+
+	// moves are deferred as a translation rather than applied to the (possibly shared) point data -
+	// see -setLocation:. Baking it in here moves the now-private path to its true position. Any
+	// simplified stand-ins were built at the old position, so they go too.
+
+	if (mPathTranslation.width != 0.0 || mPathTranslation.height != 0.0) {
+		NSAffineTransform* tfm = [NSAffineTransform transform];
+
+		[tfm translateXBy:mPathTranslation.width
+					  yBy:mPathTranslation.height];
+		[m_path transformUsingAffineTransform:tfm];
+		mPathTranslation = NSZeroSize;
+		mLODCache = nil;
+		[self invalidateChunkTable];
+	}
+}
+
 /** @brief Returns the object's current path
  @return the NSBezierPath
  */
 - (NSBezierPath*)path
 {
+	// callers of this method may edit or archive the result, so a translation deferred while the
+	// path was shared is baked in first. Read-only internal users (rendering, bounds, size) work
+	// from the stored path plus the deferred translation and never trigger this.
+
+	if (mPathTranslation.width != 0.0 || mPathTranslation.height != 0.0)
+		[self detachSharedPath];
+
 	return m_path;
 }
 
@@ -217,7 +355,10 @@ static NSColor* sInfoWindowColour = nil;
  @param knobs the knobs object that draws the handles on the path */
 - (void)drawControlPointsOfPath:(NSBezierPath*)path usingKnobs:(DKKnob*)knobs
 {
-	// draws the control points of the entire path using the knobs supplied.
+	// draws the control points of the entire path using the knobs supplied. For very dense paths the handles are
+	// virtualized: only elements whose points fall within the view's visible rect are materialized at all, and when
+	// the handle spacing drops below a few screen pixels only every Nth element grows handles - the selection path
+	// still shows the exact geometry. Both tests are skipped for paths that are small enough not to need them.
 
 	NSBezierPathElement et;
 	NSPoint ap[3];
@@ -227,10 +368,58 @@ static NSColor* sInfoWindowColour = nil;
 	NSInteger i, ec = [path elementCount];
 	lp = NSMakePoint(-1, -1);
 
+	DKDrawingView* cv = [DKDrawingView currentlyDrawingView]; // n.b. can be nil if drawing into image, etc
+	BOOL doCull = NO;
+	NSRect cullRect = NSZeroRect;
+	NSInteger stride = 1;
+
+	if (cv != nil) {
+		// inset negatively so a handle whose centre is just offscreen still draws its visible edge
+
+		NSSize ks = [knobs actualHandleSize];
+
+		cullRect = NSInsetRect([cv visibleRect], -(ks.width + 1.0), -(ks.height + 1.0));
+		doCull = !NSContainsRect(cullRect, [self bounds]);
+
+		// estimate the on-screen spacing of the on-path points from the bounds diagonal - a crude proxy,
+		// but plenty for deciding a decimation stride
+
+		CGFloat scale = [cv scale];
+		NSSize size = [self size];
+		CGFloat spacing = hypot(size.width, size.height) * scale / (CGFloat)MAX(ec, 1);
+
+		if (spacing > 0.0 && spacing < sMinimumHandleSpacing)
+			stride = (NSInteger)ceil(sMinimumHandleSpacing / spacing);
+	}
+
 	for (i = 0; i < ec; ++i) {
 		et = [path elementAtIndex:i
 				 associatedPoints:ap];
 
+		// skip (but track) elements that cannot contribute any visible handle
+
+		if (doCull || stride > 1) {
+			NSPoint ep = (et == NSCurveToBezierPathElement) ? ap[2] : ap[0];
+			BOOL skip = NO;
+
+			if (stride > 1 && (i % stride) != 0 && i != ec - 1)
+				skip = YES;
+
+			if (!skip && doCull) {
+				BOOL inside = NSPointInRect(ep, cullRect) || NSPointInRect(lp, cullRect);
+
+				if (!inside && et == NSCurveToBezierPathElement)
+					inside = NSPointInRect(ap[0], cullRect) || NSPointInRect(ap[1], cullRect);
+
+				skip = !inside;
+			}
+
+			if (skip) {
+				lp = ep;
+				continue;
+			}
+		}
+
 		if (et == NSCurveToBezierPathElement) {
 			// three points to draw, plus some bars. If the on-path point priority is set, draw on-path points on top,
 			// otherwise draw off-path points on top.
@@ -421,6 +610,117 @@ static NSColor* sInfoWindowColour = nil;
 
 #pragma mark -
 
+/// one captured element in a sparse undo record - the element's index and its associated points
+typedef struct {
+	NSInteger element;
+	NSPoint points[3];
+} DKPathElementSnapshot;
+
+/** captures the points of the given elements into a packed snapshot array. */
+static NSData* capturedElementPoints(NSBezierPath* path, NSIndexSet* elements)
+{
+	NSMutableData* data = [NSMutableData dataWithCapacity:[elements count] * sizeof(DKPathElementSnapshot)];
+	NSUInteger idx;
+
+	for (idx = [elements firstIndex]; idx != NSNotFound; idx = [elements indexGreaterThanIndex:idx]) {
+		DKPathElementSnapshot snap;
+
+		snap.element = (NSInteger)idx;
+		snap.points[0] = snap.points[1] = snap.points[2] = NSZeroPoint;
+		[path elementAtIndex:(NSInteger)idx
+			associatedPoints:snap.points];
+
+		[data appendBytes:&snap
+				   length:sizeof(snap)];
+	}
+
+	return data;
+}
+
+- (void)recordElementDeltaForUndoWithPartcode:(NSInteger)pc
+{
+	// a drag of a single partcode can only alter points in the edited element, its immediate neighbours and -
+	// for closed subpaths - the elements either side of the loop join (colinearity is maintained across the
+	// join, and the dangling moveto that closePath inserts shadows the loop's end point). The element
+	// structure never changes during a drag, so capturing those few elements' points by index is a complete
+	// record of everything the drag can touch, at a tiny fraction of the cost of copying the whole path.
+
+	NSBezierPath* path = [self path];
+	NSInteger ec = [path elementCount];
+	NSInteger element = elementIndexForPartcode(pc);
+
+	if (element < 0 || element >= ec) {
+		[self recordPathForUndo];
+		return;
+	}
+
+	NSInteger start = [path subpathStartingElementForElement:element];
+	NSInteger end = [path subpathEndingElementForElement:element];
+	NSMutableIndexSet* affected = [NSMutableIndexSet indexSet];
+
+	[affected addIndex:(NSUInteger)MAX(element - 1, 0)];
+	[affected addIndex:(NSUInteger)element];
+	[affected addIndex:(NSUInteger)MIN(element + 1, ec - 1)];
+
+	if (start >= 0 && start < ec) {
+		[affected addIndex:(NSUInteger)start];
+		[affected addIndex:(NSUInteger)MIN(start + 1, ec - 1)];
+	}
+
+	if (end >= 0 && end < ec) {
+		[affected addIndex:(NSUInteger)end];
+		[affected addIndex:(NSUInteger)MIN(end + 1, ec - 1)];
+	}
+
+	mUndoElementDelta = capturedElementPoints(path, affected);
+}
+
+- (void)applyPathElementDelta:(NSData*)delta
+{
+	const DKPathElementSnapshot* snaps = (const DKPathElementSnapshot*)[delta bytes];
+	NSUInteger count = [delta length] / sizeof(DKPathElementSnapshot);
+	NSInteger ec = [[self path] elementCount];
+	NSMutableIndexSet* elements = [NSMutableIndexSet indexSet];
+	NSUInteger i;
+
+	// the delta is only meaningful while the element structure is unchanged - anything that alters it goes
+	// through -setPath: whose full snapshots bracket this record on the undo stack, so by the time this is
+	// invoked the structure has been restored. The guard is belt and braces.
+
+	for (i = 0; i < count; ++i) {
+		if (snaps[i].element < 0 || snaps[i].element >= ec)
+			return;
+
+		[elements addIndex:(NSUInteger)snaps[i].element];
+	}
+
+	// capture the current points of the same elements first, so this method acts as its own inverse (redo)
+
+	[[self undoManager] registerUndoWithTarget:self
+									  selector:@selector(applyPathElementDelta:)
+										object:capturedElementPoints([self path], elements)];
+
+	NSRect oldBounds = [self bounds];
+
+	[self notifyVisualChange];
+	[self detachSharedPath];
+	mLODCache = nil;
+	[self invalidatePartcodeGrid];
+	[self invalidateChunkTable];
+
+	for (i = 0; i < count; ++i) {
+		DKPathElementSnapshot snap = snaps[i];
+
+		[m_path setAssociatedPoints:snap.points
+							atIndex:snap.element];
+	}
+
+	[self notifyGeometryChange:oldBounds];
+	[self notifyVisualChange];
+}
+
+#pragma mark -
+
 /** @brief Merges two paths by simply appending them
 
  This simply appends the part of the other object to this one and recomputes the bounds, etc.
@@ -1171,6 +1471,14 @@ finish:
 	[path moveToPoint:p];
 	[self setPath:path];
 
+#ifdef qUseCurveFit
+	// the fit state is maintained incrementally so that only the trailing part of the stroke is ever refitted,
+	// keeping the cost of each new sample constant however long the stroke gets
+
+	DKIncrementalCurveFitter* fitter = [[DKIncrementalCurveFitter alloc] initWithStartPoint:p
+																					epsilon:m_freehandEpsilon];
+#endif
+
 	while (loop) {
 		theEvent = [NSApp nextEventMatchingMask:mask
 									  untilDate:[NSDate distantFuture]
@@ -1194,7 +1502,8 @@ finish:
 			if (!NSEqualPoints(p, lastPoint)) {
 				[path lineToPoint:p];
 #ifdef qUseCurveFit
-				[self setPath:DKCurveFitPath(path, m_freehandEpsilon)];
+				[fitter addPoint:p];
+				[self setPath:[fitter fittedPath]];
 #else
 				[self invalidateCache];
 				[self notifyVisualChange];
@@ -1580,6 +1889,14 @@ finish:
 	if (pc < 4)
 		return;
 
+	// this edits the path in place, so make sure this object owns a private copy of it, and
+	// discard any simplified stand-ins built from the old geometry
+
+	[self detachSharedPath];
+	mLODCache = nil;
+	[self invalidatePartcodeGrid];
+	[self invalidateChunkTable];
+
 	BOOL option = (([evt modifierFlags] & NSAlternateKeyMask) != 0);
 	BOOL cmd = (([evt modifierFlags] & NSCommandKeyMask) != 0);
 
@@ -2068,6 +2385,92 @@ finish:
 	return r;
 }
 
+static CGFloat dkPerpendicularDistanceSquared(NSPoint p, NSPoint a, NSPoint b)
+{
+	CGFloat dx = b.x - a.x;
+	CGFloat dy = b.y - a.y;
+	CGFloat lenSq = (dx * dx) + (dy * dy);
+
+	if (lenSq <= 0.0) {
+		dx = p.x - a.x;
+		dy = p.y - a.y;
+
+		return (dx * dx) + (dy * dy);
+	} else {
+		CGFloat cross = ((p.x - a.x) * dy) - ((p.y - a.y) * dx);
+
+		return (cross * cross) / lenSq;
+	}
+}
+
+// iterative Douglas-Peucker - marks the points of the polyline that survive reduction at <tolerance>
+
+static void dkMarkPointsToKeep(const NSPoint* pts, NSUInteger count, CGFloat tolerance, BOOL* keep)
+{
+	typedef struct {
+		NSUInteger first, last;
+	} DKPointRange;
+
+	DKPointRange* stack = malloc(sizeof(DKPointRange) * count);
+	NSUInteger sp = 0;
+	CGFloat tolSq = tolerance * tolerance;
+
+	keep[0] = keep[count - 1] = YES;
+	stack[sp++] = (DKPointRange){ 0, count - 1 };
+
+	while (sp > 0) {
+		DKPointRange r = stack[--sp];
+
+		if ((r.last - r.first) < 2)
+			continue;
+
+		CGFloat maxDistSq = 0.0;
+		NSUInteger maxIndex = r.first, i;
+
+		for (i = r.first + 1; i < r.last; ++i) {
+			CGFloat d = dkPerpendicularDistanceSquared(pts[i], pts[r.first], pts[r.last]);
+
+			if (d > maxDistSq) {
+				maxDistSq = d;
+				maxIndex = i;
+			}
+		}
+
+		if (maxDistSq > tolSq) {
+			keep[maxIndex] = YES;
+			stack[sp++] = (DKPointRange){ r.first, maxIndex };
+			stack[sp++] = (DKPointRange){ maxIndex, r.last };
+		}
+	}
+
+	free(stack);
+}
+
+// appends the reduced polyline to <dest> as straight segments
+
+static void dkAppendSimplifiedPolyline(NSBezierPath* dest, const NSPoint* pts, NSUInteger count, CGFloat tolerance, BOOL closed)
+{
+	if (count < 2)
+		return;
+
+	BOOL* keep = calloc(count, sizeof(BOOL));
+	NSUInteger i;
+
+	dkMarkPointsToKeep(pts, count, tolerance, keep);
+
+	[dest moveToPoint:pts[0]];
+
+	for (i = 1; i < count; ++i) {
+		if (keep[i])
+			[dest lineToPoint:pts[i]];
+	}
+
+	if (closed)
+		[dest closePath];
+
+	free(keep);
+}
+
 /** @brief Draws the object
 
  When hit-testing, substitutes a style that is easier to hit
@@ -2086,8 +2489,112 @@ finish:
 										strokeColour:[NSColor blackColor]
 										 strokeWidth:strokeWidth];
 		[temp render:self];
-	} else
+	} else {
+		// when the view is zoomed out a dense path is rendered from a cached simplified stand-in -
+		// the detail dropped is below the size of a device pixel at that zoom
+
+		mLODPath = [self levelOfDetailPath];
+
+		// at full detail, a massive path is narrowed to just the chunks whose ink can reach the
+		// area actually being redrawn
+
+		if (mLODPath == nil) {
+			NSView* view = [self currentView];
+
+			if (view != nil)
+				mLODPath = [self chunkedPathForRect:[view visibleRect]
+											 inView:view];
+		}
+
 		[super drawContent];
+		mLODPath = nil;
+	}
+}
+
+- (NSBezierPath*)levelOfDetailPath
+{
+	// only worth considering for very dense paths that are not in the middle of being created -
+	// during interactive creation the path changes with every event and the cache would thrash
+
+	if ([self pathCreationMode] != kDKPathCreateModeEditExisting || [[self path] elementCount] < kDKPathLODMinimumElements)
+		return nil;
+
+	NSView* view = [self currentView];
+
+	if (![view isKindOfClass:[DKDrawingView class]])
+		return nil;
+
+	CGFloat scale = [(DKDrawingView*)view scale];
+
+	if (scale >= 1.0)
+		return nil;
+
+	// quantise the scale to power-of-two buckets so that a continuous zoom only ever generates a
+	// handful of simplified versions, each kept until the path next changes
+
+	NSUInteger bucket = MIN((NSUInteger)floor(log2(1.0 / scale)), (NSUInteger)kDKPathLODMaximumBucket);
+	NSNumber* key = @(bucket);
+	NSBezierPath* lod = [mLODCache objectForKey:key];
+
+	if (lod == nil) {
+		// the tolerance is half a drawing unit, scaled up for coarser buckets, so the detail that is
+		// dropped amounts to no more than about half a device pixel at the zooms the bucket serves
+
+		lod = [self simplifiedPathWithTolerance:0.5 * (CGFloat)(1ULL << bucket)];
+
+		if (mLODCache == nil)
+			mLODCache = [[NSMutableDictionary alloc] init];
+
+		[mLODCache setObject:lod
+					  forKey:key];
+	}
+
+	// if the reduction achieved nothing (the path genuinely has that much detail at this zoom),
+	// render the real thing
+
+	if ([lod elementCount] >= [[self path] elementCount])
+		return nil;
+
+	return lod;
+}
+
+- (NSBezierPath*)simplifiedPathWithTolerance:(CGFloat)tolerance
+{
+	NSBezierPath* flat = [[self path] copy];
+
+	[flat setFlatness:tolerance];
+	flat = [flat bezierPathByFlatteningPath];
+
+	NSBezierPath* simple = [NSBezierPath bezierPath];
+	NSInteger i, m = [flat elementCount];
+	NSPoint ap[3];
+	NSUInteger np = 0, capacity = 256;
+	NSPoint* pts = malloc(sizeof(NSPoint) * capacity);
+
+	for (i = 0; i < m; ++i) {
+		NSBezierPathElement elem = [flat elementAtIndex:i
+									   associatedPoints:ap];
+
+		if (elem == NSMoveToBezierPathElement || elem == NSClosePathBezierPathElement) {
+			// flush the subpath collected so far; a close ends its subpath with a closepath element
+
+			dkAppendSimplifiedPolyline(simple, pts, np, tolerance, elem == NSClosePathBezierPathElement);
+			np = 0;
+		}
+
+		if (elem == NSMoveToBezierPathElement || elem == NSLineToBezierPathElement) {
+			if (np == capacity) {
+				capacity <<= 1;
+				pts = realloc(pts, sizeof(NSPoint) * capacity);
+			}
+			pts[np++] = ap[0];
+		}
+	}
+
+	dkAppendSimplifiedPolyline(simple, pts, np, tolerance, NO);
+	free(pts);
+
+	return simple;
 }
 
 /** @brief Draws the seleciton highlight on the object when requested
@@ -2099,10 +2606,15 @@ finish:
 	@autoreleasepool {
 
 		NSBezierPath* path = [self renderingPath];
+		DKKnob* knobs = [[self layer] knobs];
 
 		[self drawSelectionPath:path];
-		[self drawControlPointsOfPath:path
-						   usingKnobs:[[self layer] knobs]];
+
+		// control points are decimated when the path is tiny on screen - the selection path shows the selection
+
+		if ([knobs shouldDrawHandlesForObjectOfSize:[self size]])
+			[self drawControlPointsOfPath:path
+							   usingKnobs:knobs];
 
 #ifdef qIncludeGraphicDebugging
 		if (m_showBBox)
@@ -2147,7 +2659,7 @@ finish:
 		// if we have a fill, test for path contains as well:
 
 		if ([[self style] hasFill] || [[self style] hasHatch]) {
-			if ([[self path] containsPoint:pt])
+			if ([[self path] containsPointUsingInteriorMap:pt])
 				return kDKDrawingEntireObjectPart;
 		}
 
@@ -2159,6 +2671,306 @@ finish:
 	return pc;
 }
 
+/** @brief Tests if a point hits the path
+
+ For a massive path, only the chunks whose ink can reach the point are rendered into the hit-test
+ bitmap; the superclass does the actual rendering test.
+ @param p a point
+ @return YES if the point hit something about the path, NO otherwise
+ */
+- (BOOL)pointHitsPath:(NSPoint)p
+{
+	mLODPath = [self chunkedPathForRect:NSMakeRect(p.x - 0.001, p.y - 0.001, 0.002, 0.002)
+								 inView:nil];
+
+	BOOL hit = [super pointHitsPath:p];
+	mLODPath = nil;
+
+	return hit;
+}
+
+- (NSIndexSet*)partcodeGridCandidatesForPoint:(NSPoint)pt tolerance:(CGFloat)tol
+{
+	NSBezierPath* path = [self path];
+	NSInteger ec = [path elementCount];
+
+	if (ec < kDKPathPartcodeGridMinimumElements)
+		return nil;
+
+	if (mPartcodeGrid == nil || tol > mPartcodeGridCellSize) {
+		// cells are comfortably larger than the tolerance, so a hit anywhere within tolerance of a
+		// control point always falls inside the 3x3 neighbourhood gathered below
+
+		mPartcodeGridCellSize = MAX(tol * 2.0, 32.0);
+		mPartcodeGridOrigin = [path controlPointBounds].origin;
+		mPartcodeGrid = [[NSMutableDictionary alloc] init];
+
+		NSPoint ap[3];
+		NSInteger i, j, pointCount;
+
+		for (i = 0; i < ec; ++i) {
+			NSBezierPathElement et = [path elementAtIndex:i
+										 associatedPoints:ap];
+
+			if (et == NSCurveToBezierPathElement)
+				pointCount = 3;
+			else if (et == NSClosePathBezierPathElement)
+				pointCount = 0;
+			else
+				pointCount = 1;
+
+			for (j = 0; j < pointCount; ++j) {
+				// cell coordinates are packed into a single key; the scan examines an element's own
+				// points at index <i> and its on-path point again at <i + 1>, so both indexes bucket
+
+				NSInteger col = (NSInteger)floor((ap[j].x - mPartcodeGridOrigin.x) / mPartcodeGridCellSize);
+				NSInteger row = (NSInteger)floor((ap[j].y - mPartcodeGridOrigin.y) / mPartcodeGridCellSize);
+				NSNumber* cellKey = @((row << 16) ^ (col & 0xFFFF));
+				NSMutableIndexSet* bucket = [mPartcodeGrid objectForKey:cellKey];
+
+				if (bucket == nil) {
+					bucket = [[NSMutableIndexSet alloc] init];
+					[mPartcodeGrid setObject:bucket
+									  forKey:cellKey];
+				}
+
+				[bucket addIndex:(NSUInteger)i];
+
+				if (i + 1 < ec)
+					[bucket addIndex:(NSUInteger)(i + 1)];
+			}
+		}
+	}
+
+	NSInteger col = (NSInteger)floor((pt.x - mPartcodeGridOrigin.x) / mPartcodeGridCellSize);
+	NSInteger row = (NSInteger)floor((pt.y - mPartcodeGridOrigin.y) / mPartcodeGridCellSize);
+	NSMutableIndexSet* candidates = [NSMutableIndexSet indexSet];
+	NSInteger dr, dc;
+
+	for (dr = -1; dr <= 1; ++dr) {
+		for (dc = -1; dc <= 1; ++dc) {
+			NSIndexSet* bucket = [mPartcodeGrid objectForKey:@(((row + dr) << 16) ^ ((col + dc) & 0xFFFF))];
+
+			if (bucket)
+				[candidates addIndexes:bucket];
+		}
+	}
+
+	return candidates;
+}
+
+- (void)invalidatePartcodeGrid
+{
+	mPartcodeGrid = nil;
+	mLastPartcodeHitValid = NO;
+}
+
+#pragma mark -
+
+- (void)rebuildChunkTableIfNeeded
+{
+	if (mChunks != NULL)
+		return;
+
+	NSInteger i, ec = [m_path elementCount];
+	NSPoint ap[3];
+	NSPoint cp = NSZeroPoint;
+	NSPoint spStart = NSZeroPoint;
+	DKPathChunkRec* chunk = NULL;
+	DKPathChunkExtent extent = { 0, 0, 0, 0, NO };
+
+	mChunkCount = 0;
+	mChunks = malloc((((NSUInteger)ec + kDKPathChunkTargetElements - 1) / kDKPathChunkTargetElements) * sizeof(DKPathChunkRec));
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement et = [m_path elementAtIndex:i
+									   associatedPoints:ap];
+
+		if (chunk == NULL || (NSUInteger)i - chunk->range.location >= kDKPathChunkTargetElements) {
+			if (chunk != NULL) {
+				chunk->range.length = (NSUInteger)i - chunk->range.location;
+				chunk->bounds = dkChunkExtentRect(&extent);
+			}
+
+			chunk = &mChunks[mChunkCount++];
+			chunk->range = NSMakeRange((NSUInteger)i, 0);
+			chunk->entryPoint = cp;
+			chunk->subpathStart = spStart;
+			chunk->startsSubpath = (et == NSMoveToBezierPathElement);
+			chunk->included = NO;
+
+			extent.seeded = NO;
+
+			// the chunk's first segment is drawn from the entry point, so its ink is part of
+			// the chunk's reach - unless the chunk opens a fresh subpath
+
+			if (!chunk->startsSubpath)
+				dkChunkExtentAdd(&extent, cp);
+		}
+
+		switch (et) {
+		case NSMoveToBezierPathElement:
+			dkChunkExtentAdd(&extent, ap[0]);
+			spStart = cp = ap[0];
+			break;
+
+		case NSLineToBezierPathElement:
+			dkChunkExtentAdd(&extent, ap[0]);
+			cp = ap[0];
+			break;
+
+		case NSCurveToBezierPathElement:
+			dkChunkExtentAdd(&extent, ap[0]);
+			dkChunkExtentAdd(&extent, ap[1]);
+			dkChunkExtentAdd(&extent, ap[2]);
+			cp = ap[2];
+			break;
+
+		case NSClosePathBezierPathElement:
+			// the implicit closing segment runs back to the subpath start
+			dkChunkExtentAdd(&extent, spStart);
+			cp = spStart;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	if (chunk != NULL) {
+		chunk->range.length = (NSUInteger)ec - chunk->range.location;
+		chunk->bounds = dkChunkExtentRect(&extent);
+	}
+}
+
+- (NSBezierPath*)chunkedPathForRect:(NSRect)clipRect inView:(NSView*)aView
+{
+	// only worth considering for truly massive finished paths - during interactive creation the
+	// table would be rebuilt on every event
+
+	if ([self pathCreationMode] != kDKPathCreateModeEditExisting || [m_path elementCount] < kDKPathChunkMinimumElements)
+		return nil;
+
+	// a fill or hatch is computed from the whole outline - rendering fragments of it would fill
+	// the wrong region, so chunking only applies to purely stroked content
+
+	if ([[self style] hasFill] || [[self style] hasHatch])
+		return nil;
+
+	// chunk bounds are in the path's local coordinates; inside a transformed group the rect being
+	// tested is not, so bail rather than cull wrongly
+
+	NSAffineTransform* ct = [self containerTransform];
+
+	if (ct != nil) {
+		NSAffineTransformStruct ts = [ct transformStruct];
+
+		if (ts.m11 != 1.0 || ts.m12 != 0.0 || ts.m21 != 0.0 || ts.m22 != 1.0 || ts.tX != 0.0 || ts.tY != 0.0)
+			return nil;
+	}
+
+	[self rebuildChunkTableIfNeeded];
+
+	if (mChunkCount < 2)
+		return nil;
+
+	// pad each chunk's bounds by the style's reach (plus slop for the enlarged hit-test stroke) so
+	// content whose geometry lies just outside the rect but whose ink reaches into it is kept. A
+	// deferred translation (see -setLocation:) is applied to the bounds here rather than the data.
+
+	NSSize es = [[self style] extraSpaceNeeded];
+	CGFloat padX = es.width + 2.0;
+	CGFloat padY = es.height + 2.0;
+	NSUInteger i, included = 0;
+
+	for (i = 0; i < mChunkCount; ++i) {
+		NSRect cb = NSOffsetRect(NSInsetRect(mChunks[i].bounds, -padX, -padY), mPathTranslation.width, mPathTranslation.height);
+
+		mChunks[i].included = aView ? [aView needsToDrawRect:cb] : NSIntersectsRect(cb, clipRect);
+
+		if (mChunks[i].included)
+			++included;
+	}
+
+	if (included == mChunkCount)
+		return nil; // everything is relevant - the stored path is already the right thing to draw
+
+	NSBezierPath* assembled = [NSBezierPath bezierPath];
+	NSPoint ap[3];
+	NSPoint spStart = NSZeroPoint;
+	BOOL needEntryMove = YES;
+	BOOL subpathStartAppended = NO;
+
+	for (i = 0; i < mChunkCount; ++i) {
+		if (!mChunks[i].included) {
+			needEntryMove = YES;
+			continue;
+		}
+
+		if (needEntryMove) {
+			spStart = mChunks[i].subpathStart;
+			subpathStartAppended = NO;
+
+			// a synthetic moveto re-establishes the current point after a gap, except when the
+			// chunk opens a subpath of its own
+
+			if (!mChunks[i].startsSubpath)
+				[assembled moveToPoint:mChunks[i].entryPoint];
+		}
+
+		NSUInteger e, last = NSMaxRange(mChunks[i].range);
+
+		for (e = mChunks[i].range.location; e < last; ++e) {
+			switch ([m_path elementAtIndex:(NSInteger)e
+						  associatedPoints:ap]) {
+			case NSMoveToBezierPathElement:
+				[assembled moveToPoint:ap[0]];
+				spStart = ap[0];
+				subpathStartAppended = YES;
+				break;
+
+			case NSLineToBezierPathElement:
+				[assembled lineToPoint:ap[0]];
+				break;
+
+			case NSCurveToBezierPathElement:
+				[assembled curveToPoint:ap[2]
+						  controlPoint1:ap[0]
+						  controlPoint2:ap[1]];
+				break;
+
+			case NSClosePathBezierPathElement:
+				// when the subpath's opening moveto fell in an excluded chunk, a real closepath
+				// would close back to the synthetic entry moveto instead, so draw the closing
+				// segment explicitly
+
+				if (subpathStartAppended)
+					[assembled closePath];
+				else
+					[assembled lineToPoint:spStart];
+				break;
+
+			default:
+				break;
+			}
+		}
+
+		needEntryMove = NO;
+	}
+
+	return assembled;
+}
+
+- (void)invalidateChunkTable
+{
+	if (mChunks != NULL) {
+		free(mChunks);
+		mChunks = NULL;
+	}
+
+	mChunkCount = 0;
+}
+
 /** @brief Determines the partcode hit by a given point
 
  Partcodes apart from 0 and -1 are private to this object
@@ -2179,9 +2991,25 @@ finish:
 	if ([[self class] defaultOnPathHitDetectionPriority])
 		commandKey = !commandKey;
 
-	pc = [[self path] partcodeHitByPoint:pt
-							   tolerance:tol
-				  prioritiseOnPathPoints:commandKey];
+	// deadband - pointer jitter smaller than a fraction of the knob size cannot change the answer,
+	// so the previous one is reused until the pointer genuinely moves or the path changes
+
+	if (!snap && mLastPartcodeHitValid && commandKey == mLastPartcodeHitPriority
+		&& fabs(pt.x - mLastPartcodeHitPoint.x) + fabs(pt.y - mLastPartcodeHitPoint.y) < tol * 0.25)
+		return mLastPartcodeHit;
+
+	NSIndexSet* candidates = [self partcodeGridCandidatesForPoint:pt
+														tolerance:tol];
+
+	if (candidates)
+		pc = [[self path] partcodeHitByPoint:pt
+								   tolerance:tol
+						   candidateElements:candidates
+					  prioritiseOnPathPoints:commandKey];
+	else
+		pc = [[self path] partcodeHitByPoint:pt
+								   tolerance:tol
+					  prioritiseOnPathPoints:commandKey];
 
 	// if snapping, ignore off-path points
 
@@ -2201,6 +3029,14 @@ finish:
 			}
 		}
 	}
+
+	if (!snap) {
+		mLastPartcodeHitPoint = pt;
+		mLastPartcodeHit = pc;
+		mLastPartcodeHitPriority = commandKey;
+		mLastPartcodeHitValid = YES;
+	}
+
 	return pc;
 }
 
@@ -2273,7 +3109,7 @@ finish:
 							 inPart:partcode
 							  event:evt];
 		else {
-			[self recordPathForUndo];
+			[self recordElementDeltaForUndoWithPartcode:partcode];
 			[self setMouseHasMovedSinceStartOfTracking:NO];
 		}
 	}
@@ -2326,13 +3162,22 @@ finish:
 					   inPart:partcode
 						event:evt];
 	else {
-		if ([self mouseHasMovedSinceStartOfTracking] && [self undoPath]) {
-			[[self undoManager] registerUndoWithTarget:self
-											  selector:@selector(setPath:)
-												object:[self undoPath]];
-			[[self undoManager] setActionName:NSLocalizedString(@"Change Path", @"undo string for change path")];
-			[self clearUndoPath];
+		if ([self mouseHasMovedSinceStartOfTracking]) {
+			if (mUndoElementDelta != nil) {
+				[[self undoManager] registerUndoWithTarget:self
+												  selector:@selector(applyPathElementDelta:)
+													object:mUndoElementDelta];
+				[[self undoManager] setActionName:NSLocalizedString(@"Change Path", @"undo string for change path")];
+			} else if ([self undoPath]) {
+				[[self undoManager] registerUndoWithTarget:self
+												  selector:@selector(setPath:)
+													object:[self undoPath]];
+				[[self undoManager] setActionName:NSLocalizedString(@"Change Path", @"undo string for change path")];
+				[self clearUndoPath];
+			}
 		}
+
+		mUndoElementDelta = nil;
 	}
 	[[self layer] hideInfoWindow];
 	[self notifyVisualChange];
@@ -2356,11 +3201,15 @@ finish:
 			[self notifyVisualChange];
 			[[[self undoManager] prepareWithInvocationTarget:self] setLocation:[self location]];
 
-			NSAffineTransform* tfm = [NSAffineTransform transform];
-			[tfm translateXBy:dx
-						  yBy:dy];
+			// the move is recorded as a deferred translation rather than applied to the point data.
+			// Flyweight clones made by duplication keep sharing one immutable path however they are
+			// arranged; the translation is baked in only if this object's path is actually edited
+			// (see -detachSharedPath). Rendering and bounds apply it on the fly.
+
+			mPathTranslation.width += dx;
+			mPathTranslation.height += dy;
 
-			[[self path] transformUsingAffineTransform:tfm];
+			[self invalidatePartcodeGrid];
 			[self notifyVisualChange];
 			[self notifyGeometryChange:oldBounds];
 		}
@@ -2420,18 +3269,30 @@ finish:
  */
 - (NSBezierPath*)renderingPath
 {
-	NSBezierPath* rPath = [[self path] copy];
+	NSBezierPath* rPath = [(mLODPath ? mLODPath : m_path) copy];
+
+	// a deferred translation is applied to the transient copy, leaving the shared path untouched
+
+	if (mPathTranslation.width != 0.0 || mPathTranslation.height != 0.0) {
+		NSAffineTransform* tfm = [NSAffineTransform transform];
+
+		[tfm translateXBy:mPathTranslation.width
+					  yBy:mPathTranslation.height];
+		[rPath transformUsingAffineTransform:tfm];
+	}
+
 	NSAffineTransform* parentTransform = [self containerTransform];
 
 	if (parentTransform)
 		rPath = [parentTransform transformBezierPath:rPath];
 
-	// if drawing is in low quality mode, set a coarse flatness value:
+	// if drawing is in low quality mode, set a coarse flatness value; either way the tolerance is
+	// scaled to the current view zoom so the on-screen error stays constant in device pixels
 
 	if ([[self drawing] lowRenderingQuality])
-		[rPath setFlatness:2.0];
+		[rPath setFlatness:[DKDrawingView flatnessForViewScale:2.0]];
 	else
-		[rPath setFlatness:0.5];
+		[rPath setFlatness:[DKDrawingView flatnessForViewScale:0.5]];
 
 	return rPath;
 }
@@ -2521,7 +3382,9 @@ finish:
  */
 - (NSSize)size
 {
-	return [[self path] bounds].size;
+	// a deferred translation does not change the size, so the stored path is read directly
+
+	return [m_path bounds].size;
 }
 
 /** @brief This object is being ungrouped from a group
@@ -2549,12 +3412,25 @@ finish:
 - (void)applyTransform:(NSAffineTransform*)transform
 {
 	[self notifyVisualChange];
+
+	// the transform mutates the point data, so a shared path must be made private first
+
+	[self detachSharedPath];
 	[[self path] transformUsingAffineTransform:transform];
+	[self invalidatePartcodeGrid];
+	[self invalidateChunkTable];
 	[self notifyVisualChange];
 }
 
 #pragma mark -
 #pragma mark As an NSObject
+- (void)dealloc
+{
+	// the chunk table is plain malloc'd storage, not managed by ARC
+
+	[self invalidateChunkTable];
+}
+
 - (instancetype)init
 {
 	return [self initWithStyle:[DKStyle styleWithFillColour:nil
@@ -2589,9 +3465,14 @@ finish:
 - (id)copyWithZone:(NSZone*)zone
 {
 	DKDrawablePath* copy = [super copyWithZone:zone];
-	NSBezierPath* pc = [[self path] copyWithZone:zone];
 
-	[copy setPath:pc];
+	// the path is shared copy-on-write: both objects keep the same instance and one takes a private
+	// copy only if and when it edits the path in place - see -detachSharedPath. Edits that replace
+	// the path via -setPath: (the vast majority) never need the copy at all.
+
+	[copy setPath:[self path]];
+	copy->mPathShared = YES;
+	mPathShared = YES;
 
 	[copy setPathCreationMode:[self pathCreationMode]];
 
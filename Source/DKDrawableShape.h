@@ -60,6 +60,12 @@ typedef NS_ENUM(NSInteger, DKShapeTransformOperation) {
 @protected
 	NSRect mBoundsCache; // cached value of the bounds
 	BOOL m_inRotateOp; // YES while a rotation drag is in progress
+	CGAffineTransform mTransformCache; // cached composed location/rotation/scale/offset matrix
+	BOOL mTransformCacheValid; // YES once the cache has been built at least once
+	NSPoint mTransformCacheLocation; // the inputs the cached matrix was composed from - the getter
+	CGFloat mTransformCacheAngle; // revalidates against these, so even direct ivar writes cannot
+	NSSize mTransformCacheSize; // leave a stale matrix behind
+	NSSize mTransformCacheOffset;
 }
 
 /** @brief Return which particular knobs are used by instances of this class.
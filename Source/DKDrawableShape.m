@@ -10,6 +10,7 @@
 #import "DKDrawablePath.h"
 #import "DKDrawableShape+Hotspots.h"
 #import "DKDrawing.h"
+#import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
 #import "DKGridLayer.h"
 #import "DKKnob.h"
@@ -35,6 +36,54 @@ static NSColor* sInfoWindowColour = nil;
 static NSInteger sKnobMask = kDKDrawableShapeAllKnobs;
 static NSSize sTempSavedOffset;
 
+#pragma mark Static Functions
+
+static BOOL QuadIntersectsRect(const NSPoint q[4], const NSRect r)
+{
+	// separating axis test between a convex quadrilateral and an axis-aligned rect. The rect's own axes
+	// are covered by testing the quad's bounding box; then each quad edge normal is tried in turn.
+
+	CGFloat minX = MIN(MIN(q[0].x, q[1].x), MIN(q[2].x, q[3].x));
+	CGFloat maxX = MAX(MAX(q[0].x, q[1].x), MAX(q[2].x, q[3].x));
+	CGFloat minY = MIN(MIN(q[0].y, q[1].y), MIN(q[2].y, q[3].y));
+	CGFloat maxY = MAX(MAX(q[0].y, q[1].y), MAX(q[2].y, q[3].y));
+
+	if (maxX < NSMinX(r) || minX > NSMaxX(r) || maxY < NSMinY(r) || minY > NSMaxY(r))
+		return NO;
+
+	NSInteger i, j;
+
+	for (i = 0; i < 4; ++i) {
+		NSPoint a = q[i];
+		NSPoint b = q[(i + 1) & 3];
+		CGFloat nx = a.y - b.y;
+		CGFloat ny = b.x - a.x;
+
+		CGFloat qMin = HUGE_VAL, qMax = -HUGE_VAL;
+
+		for (j = 0; j < 4; ++j) {
+			CGFloat d = q[j].x * nx + q[j].y * ny;
+			qMin = MIN(qMin, d);
+			qMax = MAX(qMax, d);
+		}
+
+		CGFloat rMin = HUGE_VAL, rMax = -HUGE_VAL;
+		CGFloat cx[2] = { NSMinX(r), NSMaxX(r) };
+		CGFloat cy[2] = { NSMinY(r), NSMaxY(r) };
+
+		for (j = 0; j < 4; ++j) {
+			CGFloat d = cx[j & 1] * nx + cy[j >> 1] * ny;
+			rMin = MIN(rMin, d);
+			rMax = MAX(rMax, d);
+		}
+
+		if (qMax < rMin || qMin > rMax)
+			return NO;
+	}
+
+	return YES;
+}
+
 @interface DKDrawableShape ()
 // private:
 
@@ -569,16 +618,19 @@ static NSSize sTempSavedOffset;
 		dy = p.y - [self location].y;
 		ka = [self knobAngleFromOrigin:knobPartCode];
 
-		// rotation
+		// rotation. The new angle is carried forward and applied together with the new size in a
+		// single geometry transaction below.
+
+		CGFloat newAngle = [self angle];
 
 		if (rotate)
-			[self setAngle:atan2(dy, dx) - ka];
+			newAngle = atan2(dy, dx) - ka;
 
 		// scaling
 
 		// normalise the mouse point by cancelling out any overall rotation.
 
-		CGFloat pa = atan2(dy, dx) - [self angle];
+		CGFloat pa = atan2(dy, dx) - newAngle;
 		CGFloat radius = hypot(dx, dy);
 		CGFloat ndx, ndy;
 
@@ -634,10 +686,16 @@ static NSSize sTempSavedOffset;
 
 		// protect against possible infinities if anchor point is placed at same edge as dragging point
 
-		if (isinf(scx) || isinf(scy) || isnan(scx) || isnan(scy))
+		if (isinf(scx) || isinf(scy) || isnan(scx) || isnan(scy)) {
+			[self setAngle:newAngle];
 			return;
+		}
+
+		DKDrawableGeometry geom = [self geometry];
 
-		[self setSize:NSMakeSize(scx, scy)];
+		geom.angle = newAngle;
+		geom.size = NSMakeSize(scx, scy);
+		[self applyGeometry:geom];
 	}
 }
 
@@ -645,22 +703,20 @@ static NSSize sTempSavedOffset;
 
 - (void)flipHorizontally
 {
-	NSSize ss = [self size];
-	ss.width *= -1.0;
-	[self setSize:ss];
+	DKDrawableGeometry geom = [self geometry];
 
-	CGFloat angle = [self angle];
-	[self setAngle:-angle];
+	geom.size.width *= -1.0;
+	geom.angle = -geom.angle;
+	[self applyGeometry:geom];
 }
 
 - (void)flipVertically
 {
-	NSSize ss = [self size];
-	ss.height *= -1.0;
-	[self setSize:ss];
+	DKDrawableGeometry geom = [self geometry];
 
-	CGFloat angle = [self angle];
-	[self setAngle:-angle];
+	geom.size.height *= -1.0;
+	geom.angle = -geom.angle;
+	[self applyGeometry:geom];
 }
 
 #pragma mark -
@@ -1627,6 +1683,96 @@ static NSSize sTempSavedOffset;
 	return mBoundsCache;
 }
 
+- (BOOL)intersectsOrientedBounds:(NSRect)rect
+{
+	// for a rotated shape the axis-aligned bounds can heavily overstate coverage, so many rects that hit
+	// the AABB miss the shape entirely. Testing against the oriented box - the shape's unit rect put
+	// through its transform - rejects those without the render-based path test. The query rect is
+	// expanded by the style's extra space (plus the same rotation allowance -bounds uses) so decoration
+	// drawn outside the box is still conservatively included.
+
+	CGFloat angle = [self angle];
+
+	if (angle == 0.0)
+		return YES; // unrotated - the box is axis-aligned and was already tested via the bounds
+
+	if ([self distortionTransform] != nil)
+		return YES; // a distorted path can extend outside the canonical unit rect, so the box is not conservative
+
+	NSSize as = [self extraSpaceNeeded];
+	CGFloat f = ABS(sin(angle)) * (MAX([[self style] maxStrokeWidth] * 0.5, 1.0) * 0.25);
+	NSRect qr = NSInsetRect(rect, -(as.width + f), -(as.height + f));
+
+	NSAffineTransform* tfm = [self transformIncludingParent];
+	NSPoint corners[4];
+
+	corners[0] = [tfm transformPoint:NSMakePoint(-0.5, -0.5)];
+	corners[1] = [tfm transformPoint:NSMakePoint(0.5, -0.5)];
+	corners[2] = [tfm transformPoint:NSMakePoint(0.5, 0.5)];
+	corners[3] = [tfm transformPoint:NSMakePoint(-0.5, 0.5)];
+
+	return QuadIntersectsRect(corners, qr);
+}
+
+- (BOOL)getOrientedCullingBoxCosine:(CGFloat*)cosine sine:(CGFloat*)sine uExtent:(CGFloat*)uExtent vExtent:(CGFloat*)vExtent
+{
+	CGFloat angle = [self angle];
+
+	if (angle == 0.0)
+		return NO; // unrotated - the axis-aligned bounds are tight
+
+	if ([self distortionTransform] != nil)
+		return NO; // a distorted path can extend outside the canonical unit rect
+
+	// the oriented box is the canonical unit rect put through the shape's transform. Rather than
+	// re-deriving the style and knob allowances, the margin is recovered from the actual bounds:
+	// whatever -bounds adds beyond the box's own axis-aligned extent is an axis-aligned margin, and
+	// folding it into the extents projected onto the box axes keeps the box conservative.
+
+	NSAffineTransform* tfm = [self transformIncludingParent];
+	NSPoint p0 = [tfm transformPoint:NSMakePoint(-0.5, -0.5)];
+	NSPoint p1 = [tfm transformPoint:NSMakePoint(0.5, -0.5)];
+	NSPoint p3 = [tfm transformPoint:NSMakePoint(-0.5, 0.5)];
+
+	CGFloat ux = p1.x - p0.x, uy = p1.y - p0.y;
+	CGFloat vx = p3.x - p0.x, vy = p3.y - p0.y;
+	CGFloat ulen = hypot(ux, uy), vlen = hypot(vx, vy);
+
+	if (ulen <= 0.0 || vlen <= 0.0)
+		return NO;
+
+	CGFloat cu = ux / ulen;
+	CGFloat su = uy / ulen;
+
+	if (su == 0.0)
+		return NO; // 180 degree rotation - still axis-aligned
+
+	// the margin recovery assumes the bounds are symmetric about the box centre; when they are not
+	// (e.g. the transient rotation knob is in the bounds) the box cannot describe them - fall back
+
+	NSRect br = [self bounds];
+	NSPoint centre = NSMakePoint((p1.x + p3.x) * 0.5, (p1.y + p3.y) * 0.5);
+
+	if (fabs(NSMidX(br) - centre.x) > 0.5 || fabs(NSMidY(br) - centre.y) > 0.5)
+		return NO;
+
+	CGFloat a0 = ulen * 0.5, b0 = vlen * 0.5;
+	CGFloat absC = fabs(cu), absS = fabs(su);
+	CGFloat mx = MAX(0.0, NSWidth(br) * 0.5 - (a0 * absC + b0 * absS));
+	CGFloat my = MAX(0.0, NSHeight(br) * 0.5 - (a0 * absS + b0 * absC));
+
+	*cosine = cu;
+	*sine = su;
+
+	// the extra 0.75 covers the up-to-half-point drift between the bounds centre (which the mirror
+	// test uses as the box centre) and the true box centre tolerated above
+
+	*uExtent = a0 + mx * absC + my * absS + 0.75;
+	*vExtent = b0 + mx * absS + my * absC + 0.75;
+
+	return YES;
+}
+
 /**
  For hit testing, uses thickened stroke if necessary to make hitting easier
  */
@@ -1674,37 +1820,74 @@ static NSSize sTempSavedOffset;
 				[pp transformUsingAffineTransform:[self transformIncludingParent]];
 				[self drawSelectionPath:pp];
 
-				// draw the knobs:
+				// draw the knobs, unless the shape is small enough on screen that handle decimation applies -
+				// the selection path drawn above is then sufficient to show the selection.
 				// n.b. drawKnob is a no-op for knobs not included by +knobMask
 
-				[self drawKnob:kDKDrawableShapeLeftHandle];
-				[self drawKnob:kDKDrawableShapeTopHandle];
-				[self drawKnob:kDKDrawableShapeRightHandle];
-				[self drawKnob:kDKDrawableShapeBottomHandle];
-				[self drawKnob:kDKDrawableShapeTopLeftHandle];
-				[self drawKnob:kDKDrawableShapeTopRightHandle];
-				[self drawKnob:kDKDrawableShapeBottomLeftHandle];
-				[self drawKnob:kDKDrawableShapeBottomRightHandle];
+				if ([[[self layer] knobs] shouldDrawHandlesForObjectOfSize:[self size]]) {
+					[self drawKnob:kDKDrawableShapeLeftHandle];
+					[self drawKnob:kDKDrawableShapeTopHandle];
+					[self drawKnob:kDKDrawableShapeRightHandle];
+					[self drawKnob:kDKDrawableShapeBottomHandle];
+					[self drawKnob:kDKDrawableShapeTopLeftHandle];
+					[self drawKnob:kDKDrawableShapeTopRightHandle];
+					[self drawKnob:kDKDrawableShapeBottomLeftHandle];
+					[self drawKnob:kDKDrawableShapeBottomRightHandle];
 
-				// the other knobs and any hotspots are not drawn when in a locked state
+					// the other knobs and any hotspots are not drawn when in a locked state
 
-				if (![self locked]) {
-					[self drawKnob:kDKDrawableShapeRotationHandle];
+					if (![self locked]) {
+						[self drawKnob:kDKDrawableShapeRotationHandle];
 
-					// draw the shape's origin target
+						// draw the shape's origin target
 
-					if (!m_hideOriginTarget)
-						[self drawKnob:kDKDrawableShapeOriginTarget];
+						if (!m_hideOriginTarget)
+							[self drawKnob:kDKDrawableShapeOriginTarget];
 
-					// draw the hotspots
+						// draw the hotspots
 
-					[self drawHotspotsInState:kDKHotspotStateOn];
+						[self drawHotspotsInState:kDKHotspotStateOn];
+					}
 				}
 			}
 		}
 	}
 }
 
+- (NSArray<NSValue*>*)selectionHighlightRefreshRects
+{
+	// the selected state draws the bounding frame plus handles, so for the common unrotated, undistorted
+	// case only the four edge strips (padded so they cover the knobs sitting on them) and the interior
+	// knobs need repainting. Rotated or distorted shapes, and special states, fall back to the whole
+	// bounds - their edges are diagonal, so axis-aligned cover would approach the full rect anyway.
+
+	if ([self angle] != 0.0 || [self distortionTransform] != nil || [self operationMode] != kDKShapeTransformStandard || m_inRotateOp || [[self hotspots] count] > 0)
+		return [super selectionHighlightRefreshRects];
+
+	NSRect tl = [self knobRect:kDKDrawableShapeTopLeftHandle];
+	NSRect frame = NSUnionRect(tl, [self knobRect:kDKDrawableShapeBottomRightHandle]);
+	CGFloat sw = NSWidth(tl);
+	CGFloat sh = NSHeight(tl);
+
+	NSMutableArray<NSValue*>* rects = [NSMutableArray arrayWithCapacity:6];
+
+	[rects addObject:[NSValue valueWithRect:NSMakeRect(NSMinX(frame), NSMinY(frame), NSWidth(frame), sh)]];
+	[rects addObject:[NSValue valueWithRect:NSMakeRect(NSMinX(frame), NSMaxY(frame) - sh, NSWidth(frame), sh)]];
+	[rects addObject:[NSValue valueWithRect:NSMakeRect(NSMinX(frame), NSMinY(frame), sw, NSHeight(frame))]];
+	[rects addObject:[NSValue valueWithRect:NSMakeRect(NSMaxX(frame) - sw, NSMinY(frame), sw, NSHeight(frame))]];
+
+	// the rotation knob and origin target sit away from the frame edges
+
+	if (![self locked]) {
+		[rects addObject:[NSValue valueWithRect:[self knobRect:kDKDrawableShapeRotationHandle]]];
+
+		if (!m_hideOriginTarget)
+			[rects addObject:[NSValue valueWithRect:[self knobRect:kDKDrawableShapeOriginTarget]]];
+	}
+
+	return rects;
+}
+
 /** @brief Hit test the point against the object
  @param pt the point to test
  @return the partcode hit
@@ -1718,8 +1901,17 @@ static NSSize sTempSavedOffset;
 		// the path might not contain it. However, the hit could be on the stroke or shadow so we need to test against
 		// the cached bitmap copy of the shape.
 
-		if (([[self style] hasFill] || [[self style] hasHatch]) && [[self transformedPath] containsPoint:pt])
-			return kDKDrawingEntireObjectPart;
+		if ([[self style] hasFill] || [[self style] hasHatch]) {
+			// the containment test is run against the stored path with the point mapped back
+			// through the shape's transform - the stored path is stable between edits so its
+			// cached interior map survives across clicks, where the transformed path would not
+
+			NSAffineTransform* xfm = [self transformIncludingParent];
+			[xfm invert];
+
+			if ([[self path] containsPointUsingInteriorMap:[xfm transformPoint:pt]])
+				return kDKDrawingEntireObjectPart;
+		}
 
 		if ([self pointHitsPath:pt])
 			return kDKDrawingEntireObjectPart;
@@ -2071,12 +2263,13 @@ static NSSize sTempSavedOffset;
 {
 	NSBezierPath* rPath = [self transformedPath];
 
-	// if drawing is in low quality mode, set a coarse flatness value:
+	// if drawing is in low quality mode, set a coarse flatness value; either way the tolerance is
+	// scaled to the current view zoom so the on-screen error stays constant in device pixels
 
 	if ([[self drawing] lowRenderingQuality])
-		[rPath setFlatness:2.0];
+		[rPath setFlatness:[DKDrawingView flatnessForViewScale:2.0]];
 	else
-		[rPath setFlatness:0.5];
+		[rPath setFlatness:[DKDrawingView flatnessForViewScale:0.5]];
 
 	return rPath;
 }
@@ -2130,21 +2323,49 @@ static NSSize sTempSavedOffset;
 - (NSAffineTransform*)transform
 {
 	// returns a transform which will transform a path at the origin to the correct location, scale and angle of this object.
+	// the composed matrix is cached and rebuilt only when the location, angle, size or offset has changed since the last
+	// call - this getter runs for every render and hit test, so the per-call trig and matrix composition were measurable.
+	// the cache validates by comparing those inputs rather than relying on the setters, so code that assigns the ivars
+	// directly (e.g. -setOffset:) cannot leave a stale matrix behind.
 
-	NSAffineTransform* xform = [NSAffineTransform transform];
+	NSPoint loc = [self location];
+	CGFloat angle = [self angle];
+	NSSize size = [self size];
+	NSSize offset = [self offset];
+
+	if (!mTransformCacheValid
+		|| !NSEqualPoints(loc, mTransformCacheLocation)
+		|| angle != mTransformCacheAngle
+		|| !NSEqualSizes(size, mTransformCacheSize)
+		|| !NSEqualSizes(offset, mTransformCacheOffset)) {
+		CGAffineTransform t = CGAffineTransformMakeTranslation(loc.x, loc.y);
+
+		t = CGAffineTransformRotate(t, angle);
+		t = CGAffineTransformScale(t, size.width, size.height);
+		t = CGAffineTransformTranslate(t, -offset.width, -offset.height);
+
+		mTransformCache = t;
+		mTransformCacheLocation = loc;
+		mTransformCacheAngle = angle;
+		mTransformCacheSize = size;
+		mTransformCacheOffset = offset;
+		mTransformCacheValid = YES;
+	}
 
-	[xform translateXBy:[self location].x
-					yBy:[self location].y];
-	[xform rotateByRadians:[self angle]];
+	// callers mutate the returned object (appending parent transforms and so on), so a fresh
+	// NSAffineTransform is always returned - only the composition is cached.
 
-	CGFloat sx = [self size].width;
-	CGFloat sy = [self size].height;
+	NSAffineTransform* xform = [NSAffineTransform transform];
+	NSAffineTransformStruct ts;
 
-	[xform scaleXBy:sx
-				yBy:sy];
-	[xform translateXBy:-[self offset].width
-					yBy:-[self offset].height];
+	ts.m11 = mTransformCache.a;
+	ts.m12 = mTransformCache.b;
+	ts.m21 = mTransformCache.c;
+	ts.m22 = mTransformCache.d;
+	ts.tX = mTransformCache.tx;
+	ts.tY = mTransformCache.ty;
 
+	[xform setTransformStruct:ts];
 	return xform;
 }
 
@@ -2259,6 +2480,67 @@ static NSSize sTempSavedOffset;
 	return m_offset;
 }
 
+/** @brief Sets any combination of location, angle, size and offset as one transaction
+
+ Performs the combined work of setLocation:, setAngle:, setSize: and setOffset: with a single
+ invalidation pair, one undo task, one storage update cycle and one geometry notification, where
+ the individual setters each pay the full cycle. Transform operations set several of these per
+ event, so this halves their per-event overhead. Field semantics match applying the setters in
+ the order location, angle, size, offset - in particular a changed offset compensates the
+ location so the shape does not move, exactly as setOffset: does.
+ @param geom the new geometry; unchanged fields are ignored
+ */
+- (void)applyGeometry:(DKDrawableGeometry)geom
+{
+	BOOL locChange = !NSEqualPoints(geom.location, m_location) && ![self locationLocked];
+	BOOL angleChange = (geom.angle != m_rotationAngle);
+	BOOL sizeChange = !NSEqualSizes(geom.size, m_scale);
+	BOOL offsetChange = !NSEqualSizes(geom.offset, m_offset);
+
+	if (!locChange && !angleChange && !sizeChange && !offsetChange)
+		return;
+
+	NSRect oldBounds = [self bounds];
+
+	[[[self undoManager] prepareWithInvocationTarget:self] applyGeometry:[self geometry]];
+	[self notifyVisualChange];
+
+	if (locChange)
+		m_location = geom.location;
+
+	if (angleChange)
+		m_rotationAngle = geom.angle;
+
+	if (sizeChange) {
+		m_scale = geom.size;
+
+		// give the shape the opportunity to reshape the path to account for the new size, if necessary
+		// this is implemented by subclasses. Not called if size is zero in either dimension.
+
+		if (m_scale.width != 0.0 && m_scale.height != 0.0)
+			[self reshapePath];
+	}
+
+	if (offsetChange) {
+		// as in -setOffset:, the location is compensated so the shape does not move. The transform
+		// rebuilds from the ivars set above, so the compensation sees the new location/angle/size
+		// but the old offset - the same state a sequential setOffset: call would see.
+
+		NSPoint p;
+
+		p.x = geom.offset.width;
+		p.y = geom.offset.height;
+		p = [[self transform] transformPoint:p];
+
+		m_location = p;
+		m_offset = geom.offset;
+	}
+
+	mBoundsCache = NSZeroRect;
+	[self notifyVisualChange];
+	[self notifyGeometryChange:oldBounds];
+}
+
 /** @brief Force the offset back to zero
  */
 - (void)resetOffset
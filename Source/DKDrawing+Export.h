@@ -9,6 +9,16 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** @brief \c YES while a bitmap export render is in progress.
+
+ Export renders at high dpi magnify costs that are invisible on screen - most notably stamping a
+ pattern motif thousands of times through the image drawing machinery. Resolution-dependent
+ rasterizers consult this to switch to export-friendly strategies (pattern fills render through a
+ true Quartz pattern, for example) without changing their screen behaviour. Only meaningful on the
+ main thread, where all export rendering happens.
+ */
+BOOL DKExportRenderingInProgress(void);
+
 /** @brief This category provides methods for exporting drawings in a variety of formats, such as TIFF, JPEG and PNG.
 
 This category provides methods for exporting drawings in a variety of formats, such as TIFF, JPEG and PNG. As these are all bitmap formats,
@@ -44,6 +54,9 @@ This uses Image I/O to perform the data encoding.
  
  Returned ref is autoreleased. The image always has an alpha channel, but the \c hasAlpha flag will
  paint the background in the paper colour if \c hasAlpha is NO.
+ Very large outputs (poster sizes at high dpi) are rendered band-by-band into a file-mapped backing
+ store rather than one monolithic bitmap context, so peak resident memory is bounded by the band
+ size instead of the output size.
  @param dpi the resolution of the image in dots per inch.
  @param hasAlpha specifies whether the image is painted in the background paper colour or not.
  @param relScale scaling factor, 1.0 = actual size, 0.5 = half size, etc.
@@ -133,6 +146,40 @@ This uses Image I/O to perform the data encoding.
  */
 - (nullable NSData*)multipartTIFFDataWithResolution:(NSUInteger)dpi;
 
+// SVG export:
+
+/** @brief Streams an SVG representation of the drawing to the given output stream.
+
+ The drawing is written bottom layer first, one \c &lt;g&gt; element per visible, printable object layer,
+ with one \c &lt;path&gt; element per object built from its rendering path. Styles are emitted once as CSS
+ classes in the document header (keyed by the style's \c uniqueKey, so objects sharing a style share its
+ definition) covering the plain fill and stroke properties - colour, opacity, width, dash, cap and join.
+ More elaborate rasterizers (gradients, hatches, text and image adornments, effects) are not converted.
+ Object fragments are serialized on worker threads a chunk of Z-order at a time and written out in order,
+ so the whole document string is never held in memory.
+ @param stream an opened output stream; the caller closes it
+ @param outError on return, the reason for any failure
+ @return YES if the export completed, NO on a stream error
+ */
+- (BOOL)writeSVGToStream:(NSOutputStream*)stream error:(NSError**)outError;
+
+/** @brief Streams an SVG representation of the drawing to a file.
+
+ Convenience wrapper around <code>-writeSVGToStream:error:</code> that opens (and closes) a stream on the
+ given file URL, overwriting any existing file.
+ @param url the file URL to write
+ @param outError on return, the reason for any failure
+ @return YES if the export completed, NO otherwise
+ */
+- (BOOL)writeSVGToURL:(NSURL*)url error:(NSError**)outError;
+
+/** @brief Returns SVG data for the drawing or nil if there was a problem
+
+ This is a convenience wrapper around the streaming writer, collecting the output in memory.
+ @return SVG data
+ */
+- (nullable NSData*)SVGData;
+
 @end
 
 extern NSBitmapImageRepPropertyKey const kDKExportPropertiesResolution;
@@ -4,15 +4,41 @@
  @copyright MPL2; see LICENSE.txt
 */
 
+#import "DKDrawableObject.h"
 #import "DKDrawing+Export.h"
 #import "DKLayer+Metadata.h"
+#import "DKObjectOwnerLayer.h"
 #import "DKSelectionPDFView.h"
+#import "DKStroke.h"
+#import "DKStrokeDash.h"
+#import "DKStyle+SimpleAccess.h"
 #import "LogEvent.h"
+#import "NSColor+DKAdditions.h"
+
+#import <sys/mman.h>
+#import <unistd.h>
 
 NSString* const kDKExportPropertiesResolution = @"kDKExportPropertiesResolution";
 NSString* const kDKExportedImageHasAlpha = @"kDKExportedImageHasAlpha";
 NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale";
 
+// outputs whose pixel buffer would exceed the threshold are rendered band-by-band into a backing
+// store mapped from an unlinked temporary file, so peak resident memory is bounded by the band
+// size rather than the output size.
+
+#define kDKExportTiledRenderingThreshold (256ULL * 1024 * 1024)
+#define kDKExportBandByteSize (64ULL * 1024 * 1024)
+
+// flag consulted by resolution-dependent rasterizers (see DKExportRenderingInProgress). Export
+// rendering is main-thread only, so a plain static suffices.
+
+static BOOL sExportRenderingInProgress = NO;
+
+BOOL DKExportRenderingInProgress(void)
+{
+	return sExportRenderingInProgress;
+}
+
 @interface DKGraphicsContextNoPrint : NSGraphicsContext
 
 - (instancetype)initWithCGContext:(CGContextRef)ctx;
@@ -113,6 +139,198 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 @end
 
+static void DKExportUnmapBackingStore(void* info, const void* data, size_t size)
+{
+#pragma unused(info)
+
+	munmap((void*)data, size);
+}
+
+#pragma mark -
+#pragma mark SVG export helpers
+
+// objects are serialized to SVG fragments in chunks of contiguous Z-order, a window of chunks at a
+// time. The chunks of each window are built concurrently, then written to the stream in order and
+// released, so memory is bounded by the window size rather than the document size.
+
+#define kDKSVGExportChunkSize 256
+#define kDKSVGExportChunkWindow 16
+
+/** writes a string to the stream as UTF-8, looping over partial writes. Returns NO and fills in
+ \c outError if the stream fails. */
+static BOOL svgWriteString(NSOutputStream* stream, NSString* string, NSError** outError)
+{
+	NSData* data = [string dataUsingEncoding:NSUTF8StringEncoding];
+	const uint8_t* bytes = [data bytes];
+	NSUInteger remaining = [data length];
+
+	while (remaining > 0) {
+		NSInteger written = [stream write:bytes
+								maxLength:remaining];
+
+		if (written <= 0) {
+			if (outError) {
+				*outError = [stream streamError];
+
+				if (*outError == nil)
+					*outError = [NSError errorWithDomain:NSCocoaErrorDomain
+													code:NSFileWriteUnknownError
+												userInfo:nil];
+			}
+			return NO;
+		}
+
+		bytes += written;
+		remaining -= (NSUInteger)written;
+	}
+
+	return YES;
+}
+
+/** escapes the five XML metacharacters in a string destined for an attribute value */
+static NSString* svgEscapedString(NSString* string)
+{
+	NSMutableString* s = [string mutableCopy];
+
+	[s replaceOccurrencesOfString:@"&"
+					   withString:@"&amp;"
+						  options:NSLiteralSearch
+							range:NSMakeRange(0, [s length])];
+	[s replaceOccurrencesOfString:@"<"
+					   withString:@"&lt;"
+						  options:NSLiteralSearch
+							range:NSMakeRange(0, [s length])];
+	[s replaceOccurrencesOfString:@">"
+					   withString:@"&gt;"
+						  options:NSLiteralSearch
+							range:NSMakeRange(0, [s length])];
+	[s replaceOccurrencesOfString:@"\""
+					   withString:@"&quot;"
+						  options:NSLiteralSearch
+							range:NSMakeRange(0, [s length])];
+	[s replaceOccurrencesOfString:@"'"
+					   withString:@"&apos;"
+						  options:NSLiteralSearch
+							range:NSMakeRange(0, [s length])];
+
+	return s;
+}
+
+/** converts a bezier path to SVG path data. Numbers are emitted with %g at 7 significant digits,
+ which round-trips typical page coordinates exactly while keeping curve data compact. */
+static NSString* svgPathDataFromBezierPath(NSBezierPath* path)
+{
+	NSInteger i, m = [path elementCount];
+	NSPoint p[3];
+	NSMutableString* d = [NSMutableString stringWithCapacity:(NSUInteger)m * 16];
+
+	for (i = 0; i < m; ++i) {
+		switch ([path elementAtIndex:i
+					associatedPoints:p]) {
+		case NSMoveToBezierPathElement:
+			[d appendFormat:@"M%.7g %.7g", (double)p[0].x, (double)p[0].y];
+			break;
+
+		case NSLineToBezierPathElement:
+			[d appendFormat:@"L%.7g %.7g", (double)p[0].x, (double)p[0].y];
+			break;
+
+		case NSCurveToBezierPathElement:
+			[d appendFormat:@"C%.7g %.7g %.7g %.7g %.7g %.7g", (double)p[0].x, (double)p[0].y, (double)p[1].x, (double)p[1].y, (double)p[2].x, (double)p[2].y];
+			break;
+
+		case NSClosePathBezierPathElement:
+			[d appendString:@"Z"];
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	return d;
+}
+
+/** returns the CSS declarations equivalent to the style's plain fill and stroke properties. Other
+ rasterizers (gradients, hatches, adornments, effects) have no direct SVG equivalent and are not
+ converted. */
+static NSString* svgCSSDeclarationsForStyle(DKStyle* style)
+{
+	NSMutableString* css = [NSMutableString string];
+	NSColor* fc = [style fillColour];
+
+	if (fc) {
+		[css appendFormat:@"fill:%@;", [fc hexString]];
+
+		if ([fc alphaComponent] < 1.0)
+			[css appendFormat:@"fill-opacity:%.3g;", (double)[fc alphaComponent]];
+	} else
+		[css appendString:@"fill:none;"];
+
+	DKStroke* stroke = [style stroke];
+
+	if (stroke) {
+		NSColor* sc = [stroke colour];
+
+		[css appendFormat:@"stroke:%@;stroke-width:%.7g;", [sc hexString], (double)[stroke width]];
+
+		if ([sc alphaComponent] < 1.0)
+			[css appendFormat:@"stroke-opacity:%.3g;", (double)[sc alphaComponent]];
+
+		DKStrokeDash* dash = [stroke dash];
+
+		if (dash) {
+			CGFloat pattern[8];
+			NSInteger count, k;
+
+			[dash getDashPattern:pattern
+						   count:&count];
+
+			if (count > 0) {
+				[css appendString:@"stroke-dasharray:"];
+
+				for (k = 0; k < count; ++k)
+					[css appendFormat:@"%@%.7g", (k > 0) ? @"," : @"", (double)pattern[k]];
+
+				[css appendString:@";"];
+			}
+		}
+
+		if ([stroke lineCapStyle] == NSRoundLineCapStyle)
+			[css appendString:@"stroke-linecap:round;"];
+		else if ([stroke lineCapStyle] == NSSquareLineCapStyle)
+			[css appendString:@"stroke-linecap:square;"];
+
+		if ([stroke lineJoinStyle] == NSRoundLineJoinStyle)
+			[css appendString:@"stroke-linejoin:round;"];
+		else if ([stroke lineJoinStyle] == NSBevelLineJoinStyle)
+			[css appendString:@"stroke-linejoin:bevel;"];
+	} else
+		[css appendString:@"stroke:none;"];
+
+	return css;
+}
+
+/** returns the SVG fragment for one object - a \c &lt;path&gt; element referencing its style's CSS
+ class. Objects without a path or a style produce an empty string. */
+static NSString* svgFragmentForObject(DKDrawableObject* obj, NSDictionary<NSString*, NSString*>* styleClassNames)
+{
+	NSBezierPath* path = [obj renderingPath];
+
+	if (path == nil || [path isEmpty])
+		return @"";
+
+	DKStyle* style = [obj style];
+	NSString* className = style ? [styleClassNames objectForKey:[style uniqueKey]] : nil;
+
+	if (className == nil)
+		return @"";
+
+	NSString* fillRule = ([path windingRule] == NSEvenOddWindingRule) ? @" fill-rule=\"evenodd\"" : @"";
+
+	return [NSString stringWithFormat:@"<path class=\"%@\"%@ d=\"%@\"/>\n", className, fillRule, svgPathDataFromBezierPath(path)];
+}
+
 @implementation DKDrawing (Export)
 
 /** @brief Creates the initial bitmap image that the various bitmap formats are created from.
@@ -133,7 +351,22 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 - (CGImageRef)CGImageWithResolution:(NSInteger)dpi hasAlpha:(BOOL)hasAlpha relativeScale:(CGFloat)relScale
 {
+	NSAssert(relScale > 0, @"scale factor must be greater than zero");
+
 	[self finalizePriorToSaving];
+
+	// work out the output pixel size up front so that very large exports can take the tiled path.
+
+	NSSize bmSize = [self drawingSize];
+
+	bmSize.width = ceil((bmSize.width * (CGFloat)dpi * relScale) / 72.0);
+	bmSize.height = ceil((bmSize.height * (CGFloat)dpi * relScale) / 72.0);
+
+	if (((uint64_t)bmSize.width * 4ULL * (uint64_t)bmSize.height) >= kDKExportTiledRenderingThreshold)
+		return [self tiledCGImageWithPixelSize:bmSize
+										 scale:(((CGFloat)dpi * relScale) / 72.0)
+									  hasAlpha:hasAlpha];
+
 	NSRect frame = NSZeroRect;
 	frame.size = [[self drawing] drawingSize];
 
@@ -143,15 +376,6 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 
 	[[self drawing] addController:vc];
 
-	NSAssert(relScale > 0, @"scale factor must be greater than zero");
-
-	// create a bitmap rep of the requisite size.
-
-	NSSize bmSize = [self drawingSize];
-
-	bmSize.width = ceil((bmSize.width * (CGFloat)dpi * relScale) / 72.0);
-	bmSize.height = ceil((bmSize.height * (CGFloat)dpi * relScale) / 72.0);
-
 	CGContextRef bmCtx;
 	{
 		CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
@@ -187,7 +411,9 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	[flipTrans concat];
 	// draw the PDF rep into the bitmap rep.
 
+	sExportRenderingInProgress = YES;
 	[pdfView drawRect:destRect];
+	sExportRenderingInProgress = NO;
 	//[pdfView displayRectIgnoringOpacity:destRect inContext:context];
 
 	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
@@ -198,6 +424,117 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	return (CGImageRef)CFAutorelease(image);
 }
 
+/** @brief Band-by-band renderer for very large exports.
+
+ The full pixel buffer is backed by a mapping of an unlinked temporary file instead of wired memory,
+ and rendering happens through a band-sized bitmap context windowed onto successive slices of it, so
+ resident memory is bounded by the band size however big the output is. Each band draws only the
+ strip of the drawing it covers. Rendering is not thread-safe (layers and styles share mutable
+ caches), so bands render sequentially - the win over the monolithic path is the bounded memory and
+ the per-band culling, not parallelism. Image I/O then encodes from the mapped provider, paging
+ bands in as it goes.
+ @param bmSize the output size in pixels
+ @param scale the drawing units to pixels scale factor
+ @param hasAlpha as for CGImageWithResolution:hasAlpha:
+ @return an autoreleased CG image backed by the file mapping */
+- (CGImageRef)tiledCGImageWithPixelSize:(NSSize)bmSize scale:(CGFloat)scale hasAlpha:(BOOL)hasAlpha
+{
+	size_t width = (size_t)bmSize.width;
+	size_t height = (size_t)bmSize.height;
+	size_t bytesPerRow = width * 4;
+	size_t totalBytes = bytesPerRow * height;
+
+	char path[PATH_MAX];
+
+	if (![[NSTemporaryDirectory() stringByAppendingPathComponent:@"DKExportBacking.XXXXXX"] getFileSystemRepresentation:path
+																											 maxLength:sizeof(path)])
+		return NULL;
+
+	int fd = mkstemp(path);
+
+	if (fd < 0)
+		return NULL;
+
+	unlink(path);
+
+	if (ftruncate(fd, (off_t)totalBytes) != 0) {
+		close(fd);
+		return NULL;
+	}
+
+	void* buffer = mmap(NULL, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (buffer == MAP_FAILED)
+		return NULL;
+
+	NSRect frame = NSZeroRect;
+	frame.size = [[self drawing] drawingSize];
+
+	DKLayerPDFView* pdfView = [[DKLayerPDFView alloc] initWithFrame:frame
+														  withLayer:self];
+	DKViewController* vc = [pdfView makeViewController];
+
+	[[self drawing] addController:vc];
+
+	CGColorSpaceRef clrSpace = CGColorSpaceCreateWithName(kCGColorSpaceSRGB);
+	size_t bandRows = MAX((size_t)1, (size_t)(kDKExportBandByteSize / bytesPerRow));
+	size_t firstRow;
+
+	LogEvent_(kInfoEvent, @"tiled export: size = %@, band rows = %lu", NSStringFromSize(bmSize), (unsigned long)bandRows);
+
+	for (firstRow = 0; firstRow < height; firstRow += bandRows) {
+		size_t rowsThisBand = MIN(bandRows, height - firstRow);
+		CGContextRef bandCtx = CGBitmapContextCreate((uint8_t*)buffer + (firstRow * bytesPerRow), width, rowsThisBand, 8, bytesPerRow, clrSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedLast);
+
+		if (bandCtx == NULL)
+			continue;
+
+		// no clear needed - pages from the freshly truncated file are already zero
+
+		NSGraphicsContext* context = [[DKGraphicsContextNoPrint alloc] initWithCGContext:bandCtx];
+
+		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+			[NSGraphicsContext setCurrentContext:context];
+		[context setShouldAntialias:YES];
+		[context setImageInterpolation:NSImageInterpolationHigh];
+
+		if (!hasAlpha) {
+			[[self paperColour] set];
+			NSRectFill(NSMakeRect(0, 0, width, rowsThisBand));
+		}
+
+		// flip and shift so that this band's context windows rows <firstRow> onward of the final image
+
+		NSAffineTransform* flipTrans = [[NSAffineTransform alloc] init];
+		[flipTrans scaleXBy:1 yBy:-1];
+		[flipTrans translateXBy:0 yBy:-(CGFloat)(firstRow + rowsThisBand)];
+		[flipTrans scaleXBy:scale yBy:scale];
+		[flipTrans concat];
+
+		// only the strip of the drawing covering this band needs to be drawn
+
+		NSRect bandRect = NSMakeRect(0, (CGFloat)firstRow / scale, (CGFloat)width / scale, (CGFloat)rowsThisBand / scale);
+
+		sExportRenderingInProgress = YES;
+		[pdfView drawRect:bandRect];
+		sExportRenderingInProgress = NO;
+
+		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+			CGContextRelease(bandCtx);
+	}
+
+	pdfView = nil; // removes the controller
+
+	CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, buffer, totalBytes, DKExportUnmapBackingStore);
+	CGImageRef image = CGImageCreate(width, height, 8, 32, bytesPerRow, clrSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedLast, provider, NULL, false, kCGRenderingIntentDefault);
+
+	CGDataProviderRelease(provider);
+	CGColorSpaceRelease(clrSpace);
+
+	return (CGImageRef)CFAutorelease(image);
+}
+
 /** @brief Returns JPEG data for the drawing.
  @param props various parameters and properties
  @return JPEG data or nil if there was a problem
@@ -534,4 +871,168 @@ NSString* const kDKExportedImageRelativeScale = @"kDKExportedImageRelativeScale"
 	return [NSBitmapImageRep TIFFRepresentationOfImageRepsInArray:[self layerBitmapsWithDPI:dpi]];
 }
 
+#pragma mark -
+#pragma mark - SVG export
+
+/** @brief Streams an SVG representation of the drawing to the given output stream.
+
+ Styles are memoized by \c uniqueKey and emitted once as CSS classes in the document header; the body is
+ then streamed bottom layer first with object chunks serialized on worker threads in Z-order windows.
+ @param stream an opened output stream; the caller closes it
+ @param outError on return, the reason for any failure
+ @return YES if the export completed, NO on a stream error
+ */
+- (BOOL)writeSVGToStream:(NSOutputStream*)stream error:(NSError**)outError
+{
+	NSAssert(stream != nil, @"cannot export SVG to a nil stream");
+
+	// collect the exportable layers and memoize the styles up front. Once built, the class-name map is
+	// read-only, so the worker threads below only ever look styles up - shared styles are never
+	// serialized twice and never touched concurrently.
+
+	NSMutableArray<NSArray<DKDrawableObject*>*>* layerObjects = [NSMutableArray array];
+	NSMutableArray<NSString*>* layerNames = [NSMutableArray array];
+	NSMutableDictionary<NSString*, NSString*>* styleClassNames = [NSMutableDictionary dictionary];
+	NSMutableString* css = [NSMutableString string];
+
+	for (DKObjectOwnerLayer* layer in [[self flattenedLayersOfClass:[DKObjectOwnerLayer class]] reverseObjectEnumerator]) {
+		if (![layer visible] || ![layer shouldDrawToPrinter])
+			continue;
+
+		NSArray<DKDrawableObject*>* objects = [layer visibleObjects];
+
+		if ([objects count] == 0)
+			continue;
+
+		[layerObjects addObject:objects];
+		[layerNames addObject:[layer layerName] ?: @""];
+
+		for (DKDrawableObject* obj in objects) {
+			DKStyle* style = [obj style];
+
+			if (style && [styleClassNames objectForKey:[style uniqueKey]] == nil) {
+				NSString* className = [NSString stringWithFormat:@"dk%lu", (unsigned long)[styleClassNames count]];
+
+				[styleClassNames setObject:className
+									forKey:[style uniqueKey]];
+				[css appendFormat:@".%@{%@}\n", className, svgCSSDeclarationsForStyle(style)];
+			}
+		}
+	}
+
+	// document header. The drawing's flipped coordinate system matches SVG's y-down convention, so
+	// coordinates pass through untransformed.
+
+	NSSize size = [self drawingSize];
+	NSMutableString* header = [NSMutableString string];
+
+	[header appendString:@"<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"];
+	[header appendFormat:@"<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%.7g\" height=\"%.7g\" viewBox=\"0 0 %.7g %.7g\">\n", (double)size.width, (double)size.height, (double)size.width, (double)size.height];
+	[header appendFormat:@"<style type=\"text/css\">\n%@</style>\n", css];
+
+	if (!svgWriteString(stream, header, outError))
+		return NO;
+
+	// body - one <g> per layer, bottom layer first, objects in Z-order within it
+
+	NSUInteger layerIndex;
+
+	for (layerIndex = 0; layerIndex < [layerObjects count]; ++layerIndex) {
+		NSArray<DKDrawableObject*>* objects = [layerObjects objectAtIndex:layerIndex];
+
+		if (!svgWriteString(stream, [NSString stringWithFormat:@"<g id=\"%@\">\n", svgEscapedString([layerNames objectAtIndex:layerIndex])], outError))
+			return NO;
+
+		NSUInteger chunkCount = ([objects count] + kDKSVGExportChunkSize - 1) / kDKSVGExportChunkSize;
+		NSUInteger windowStart;
+
+		for (windowStart = 0; windowStart < chunkCount; windowStart += kDKSVGExportChunkWindow) {
+			NSUInteger windowSize = MIN((NSUInteger)kDKSVGExportChunkWindow, chunkCount - windowStart);
+			__strong NSString** fragments = (__strong NSString**)calloc(windowSize, sizeof(NSString*));
+
+			dispatch_apply(windowSize, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t w) {
+				@autoreleasepool {
+					NSUInteger first = (windowStart + w) * kDKSVGExportChunkSize;
+					NSUInteger afterLast = MIN(first + kDKSVGExportChunkSize, [objects count]);
+					NSMutableString* chunk = [NSMutableString string];
+					NSUInteger i;
+
+					for (i = first; i < afterLast; ++i)
+						[chunk appendString:svgFragmentForObject([objects objectAtIndex:i], styleClassNames)];
+
+					fragments[w] = [chunk copy];
+				}
+			});
+
+			BOOL ok = YES;
+			NSUInteger w;
+
+			for (w = 0; w < windowSize && ok; ++w)
+				ok = svgWriteString(stream, fragments[w], outError);
+
+			for (w = 0; w < windowSize; ++w)
+				fragments[w] = nil;
+
+			free(fragments);
+
+			if (!ok)
+				return NO;
+		}
+
+		if (!svgWriteString(stream, @"</g>\n", outError))
+			return NO;
+	}
+
+	return svgWriteString(stream, @"</svg>\n", outError);
+}
+
+/** @brief Streams an SVG representation of the drawing to a file.
+ @param url the file URL to write; any existing file is overwritten
+ @param outError on return, the reason for any failure
+ @return YES if the export completed, NO otherwise
+ */
+- (BOOL)writeSVGToURL:(NSURL*)url error:(NSError**)outError
+{
+	NSAssert(url != nil, @"cannot export SVG to a nil URL");
+
+	NSOutputStream* stream = [NSOutputStream outputStreamWithURL:url
+														  append:NO];
+
+	if (stream == nil) {
+		if (outError)
+			*outError = [NSError errorWithDomain:NSCocoaErrorDomain
+											code:NSFileWriteUnknownError
+										userInfo:@{ NSURLErrorKey: url }];
+		return NO;
+	}
+
+	[stream open];
+
+	BOOL ok = [self writeSVGToStream:stream
+							   error:outError];
+	[stream close];
+
+	return ok;
+}
+
+/** @brief Returns SVG data for the drawing or nil if there was a problem
+
+ This is a convenience wrapper around the streaming writer, collecting the output in memory.
+ @return SVG data
+ */
+- (NSData*)SVGData
+{
+	NSOutputStream* stream = [NSOutputStream outputStreamToMemory];
+
+	[stream open];
+
+	BOOL ok = [self writeSVGToStream:stream
+							   error:NULL];
+	NSData* data = ok ? [stream propertyForKey:NSStreamDataWrittenToMemoryStreamKey] : nil;
+
+	[stream close];
+
+	return data;
+}
+
 @end
@@ -56,10 +56,24 @@ NS_ASSUME_NONNULL_BEGIN
 	NSTimeInterval m_lastRenderTime; /**< time the last render operation occurred */
 	NSTimeInterval mTriggerPeriod; /**< the time interval to use to trigger low quality rendering */
 	NSRect m_lastRectUpdated; /**< for refresh in HQ mode */
+	NSInteger mInteractiveRenderingCount; /**< nested begin count for gesture-scoped fast-tier rendering */
 	NSMutableSet<DKViewController*>* mControllers; /**< the set of current controllers */
 	DKImageDataManager* mImageManager; /**< internal object used to substantially improve efficiency of image archiving */
 	id<DKDrawingDelegate> __weak mDelegateRef; /**< delegate, if any */
 	id __weak mOwnerRef; /**< back pointer to document or view that owns this */
+	BOOL mAsyncRenderingEnabled; /**< YES if layer content is rendered on a background queue and composited */
+	BOOL mAsyncRenderInFlight; /**< YES while a background render is outstanding */
+	BOOL mAsyncContentDirty; /**< YES if content changed since the last background render was started */
+	NSImage* mAsyncRenderedFrame; /**< the most recently completed background-rendered frame */
+	dispatch_queue_t mAsyncRenderQueue; /**< serial queue the background renders run on */
+	BOOL mCoalescesUpdates; /**< YES if invalid rects are collected per runloop turn and clustered before hitting the views */
+	BOOL mUpdateFlushScheduled; /**< YES while a coalesced flush is pending on the current runloop turn */
+	NSMutableArray<NSValue*>* mPendingUpdateRects; /**< the invalid rects collected since the last flush */
+	NSRect mLastViewedRect; /**< the viewport last seen by the user, persisted in the chunked container to prioritize open */
+	BOOL mGeometryReconcileScheduled; /**< YES while a coalesced size/margin reconcile is queued on the main queue */
+	BOOL mPendingSizeChange; /**< a deferred size-change fan-out to layers and controllers is pending */
+	BOOL mPendingMarginsChange; /**< a deferred margin-change fan-out is pending */
+	NSRect mPendingOldInterior; /**< the interior as it was before the first pending margin change */
 }
 
 /** @brief Return the current version number of the framework
@@ -98,6 +112,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (nullable DKDrawing*)drawingWithData:(NSData*)drawingData;
 
+/** @brief Creates a drawing from chunked container data, as written by \c -chunkedDrawingData
+
+ Image chunks are handed to the image manager as uncopied subranges of <code>drawingData</code>, so when the caller supplies
+ memory-mapped data the image bytes remain backed by the file until an image is first drawn. Compressed chunks
+ (written by format version 3 and later) are expanded concurrently before decoding.
+ @param drawingData data representing a chunked drawing file
+ @return the unarchived drawing
+ */
++ (nullable DKDrawing*)drawingWithChunkedData:(NSData*)drawingData;
+
 /** @brief Return the default derachiving helper for deaerchiving a drawing
 
  This helper is a delegate of the dearchiver during dearchiving and translates older or obsolete
@@ -380,6 +404,68 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)qualityTimerCallback:(NSTimer*)timer;
 @property NSTimeInterval lowQualityTriggerInterval;
 
+/** @brief Marks the start of an interactive gesture which should render in the fast tier
+
+ Called by tool and view controllers when a gesture that generates many rapid updates begins, such as
+ dragging with a tool. While at least one begin is outstanding, rasterizers render in low quality and
+ the timer-based heuristic will not restore high quality mid-gesture, even if the user pauses. Calls
+ nest; each begin must be balanced by a matching <code>-endInteractiveRendering</code>. Has no effect
+ if \c dynamicQualityModulationEnabled is NO.
+ */
+- (void)beginInteractiveRendering;
+
+/** @brief Marks the end of an interactive gesture
+
+ When the last outstanding begin is balanced, high quality rendering is restored at once and the area
+ drawn in the fast tier is redisplayed at full quality, rather than waiting out the low quality
+ trigger interval.
+ */
+- (void)endInteractiveRendering;
+
+/** @brief Whether an interactive gesture is currently holding the fast rendering tier
+ */
+@property (readonly) BOOL interactiveRenderingInProgress;
+
+/** @brief Set whether the layer stack is rendered asynchronously on a background queue.
+
+ When enabled, screen updates composite the most recently completed frame instead of drawing the layer
+ stack inline, so interaction latency stays flat however expensive the styles are. Each background render
+ works on an isolated snapshot of the drawing (taken with -drawingData), so editing can continue while a
+ render is in flight; renders are coalesced, with at most one outstanding at a time. The composited frame
+ covers the whole drawing at nominal size, so this mode trades some zoomed-in fidelity and frame latency
+ for a responsive main thread - intended for documents whose styles are too costly to draw live.
+ Printing and export always use the normal synchronous path. Defaults to NO.
+ */
+@property (nonatomic) BOOL asynchronousRenderingEnabled;
+
+/** @brief Whether a background render is currently outstanding. */
+@property (readonly, getter=isAsynchronousRenderInProgress) BOOL asynchronousRenderInProgress;
+
+/** @brief Set whether invalidation is coalesced per runloop turn.
+
+ When enabled, rects passed to -setNeedsDisplayInRect: are collected for the remainder of the current
+ runloop turn and then clustered into a small set of tight regions which are invalidated in one go -
+ rather than one large union, so scattered edits (e.g. dragging a big selection) don't force everything
+ between the changed objects to redraw. Whole-drawing updates via -setNeedsDisplay: bypass the
+ collection. Defaults to NO.
+ */
+@property (nonatomic) BOOL coalescesUpdates;
+
+/** @brief Clusters and issues any pending coalesced updates immediately. Called automatically at the end
+ of the runloop turn; call directly when updates must reach the views before then.
+ */
+- (void)flushPendingUpdates;
+
+/** @brief Delivers any pending coalesced size/margin change immediately.
+
+ Changes to the drawing size or margins are fanned out to layers, controllers and notification
+ observers once per runloop turn rather than once per set - during interactive page-size
+ adjustment every layer recomputes its geometry-dependent caches once per frame instead of once
+ per change. Called automatically at the end of the turn and before the drawing draws itself;
+ call directly when dependent state must be up to date before then.
+ */
+- (void)reconcilePendingGeometryChanges;
+
 /** @} */
 /** @name setting the undo manager:
  @{ */
@@ -630,6 +716,16 @@ NS_ASSUME_NONNULL_BEGIN
 - (NSData*)drawingAsXMLDataAtRoot;
 - (NSData*)drawingAsXMLDataForKey:(NSString*)key;
 - (NSData*)drawingData;
+- (NSData*)chunkedDrawingData;
+
+/** @brief The rect of the drawing the user was last looking at, in drawing coordinates.
+
+ Set by the document before a chunked save and persisted in the container. On open it steers
+ progressive loading - layers whose content intersects this rect decode first and the window can show
+ them while the rest stream in - and lets the document restore the scroll position. \c NSZeroRect
+ when never set or loaded from a file that predates it.
+ */
+@property NSRect lastViewedRect;
 - (NSData*)pdf;
 
 /** @} */
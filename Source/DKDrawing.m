@@ -13,11 +13,13 @@
 #import "DKGridLayer.h"
 #import "DKGuideLayer.h"
 #import "DKImageDataManager.h"
+#import "DKKeyedArchiver.h"
 #import "DKKeyedUnarchiver.h"
 #import "DKKnob.h"
 #import "DKLayer+Metadata.h"
 #import "DKObjectDrawingLayer.h"
 #import "DKStyle.h"
+#import "DKStyle+Text.h"
 #import "DKStyleRegistry.h"
 #import "DKUnarchivingHelper.h"
 #import "DKUndoManager.h"
@@ -25,6 +27,8 @@
 #import "DKViewController.h"
 #import "LogEvent.h"
 
+#import <compression.h>
+
 #pragma mark Contants(Non - localized)
 
 // notifications:
@@ -82,6 +86,15 @@ NSString* const DKDrawingUnitsMiles = @"miles";
 
 static id sDearchivingHelper = nil;
 
+#pragma mark -
+
+@interface DKDrawing ()
+
+- (void)scheduleAsynchronousRender;
+- (void)compositeAsynchronousFrameInRect:(NSRect)rect;
+
+@end
+
 #pragma mark -
 @implementation DKDrawing
 #pragma mark As a DKDrawing
@@ -228,6 +241,422 @@ static id sDearchivingHelper = nil;
 
 	[unarch finishDecoding];
 
+	// fonts resolve lazily on first layout, so warm the text machinery for the styles the document
+	// actually uses in the background - first paint of text-heavy documents then finds them hot
+
+	if (dwg != nil)
+		[DKStyle warmTextAttributesOfStyles:[dwg allStyles]];
+
+	return dwg;
+}
+
+#pragma mark -
+
+// the chunked container file consists of a short header, a run of chunk payloads and a table of contents locating them
+// by name. The "graph" chunk is a keyed archive of the drawing, version 2 writes each top-level layer as its own
+// "layer:<index>" chunk so they can be dearchived in parallel, and each entry in the image manager's repository is
+// written as a separate "image:<key>" chunk. Version 3 compresses chunk payloads with LZFSE where that pays - keyed
+// archives shrink several-fold; image chunks usually hold already-compressed formats and stay raw, which also keeps
+// them usable as byte ranges of a file mapping. The table of contents records each chunk's encoding and expanded
+// size, so chunks expand independently and in parallel on open. All integer fields are little-endian.
+
+static NSString* const kDKChunkedDrawingGraphChunkName = @"graph";
+static NSString* const kDKChunkedDrawingImageChunkPrefix = @"image:";
+static NSString* const kDKChunkedDrawingLayerChunkPrefix = @"layer:";
+static NSString* const kDKChunkedDrawingOpenInfoChunkName = @"openinfo";
+
+static const char kDKChunkedDrawingMagic[4] = { 'd', 'k', 'c', 'f' };
+static const uint32_t kDKChunkedDrawingVersion = 3;
+
+static const uint32_t kDKChunkedDrawingEncodingRaw = 0;
+static const uint32_t kDKChunkedDrawingEncodingLZFSE = 1;
+
+static void DKChunkedDataAppendUInt32(NSMutableData* data, uint32_t value)
+{
+	uint32_t le = NSSwapHostIntToLittle(value);
+	[data appendBytes:&le
+			   length:sizeof(le)];
+}
+
+static void DKChunkedDataAppendUInt64(NSMutableData* data, uint64_t value)
+{
+	uint64_t le = NSSwapHostLongLongToLittle(value);
+	[data appendBytes:&le
+			   length:sizeof(le)];
+}
+
+static BOOL DKChunkedDataReadUInt32(NSData* data, NSUInteger* ioOffset, uint32_t* outValue)
+{
+	if (*ioOffset + sizeof(uint32_t) > [data length])
+		return NO;
+
+	uint32_t le;
+	[data getBytes:&le
+			 range:NSMakeRange(*ioOffset, sizeof(le))];
+	*outValue = NSSwapLittleIntToHost(le);
+	*ioOffset += sizeof(le);
+	return YES;
+}
+
+static BOOL DKChunkedDataReadUInt64(NSData* data, NSUInteger* ioOffset, uint64_t* outValue)
+{
+	if (*ioOffset + sizeof(uint64_t) > [data length])
+		return NO;
+
+	uint64_t le;
+	[data getBytes:&le
+			 range:NSMakeRange(*ioOffset, sizeof(le))];
+	*outValue = NSSwapLittleLongLongToHost(le);
+	*ioOffset += sizeof(le);
+	return YES;
+}
+
+static NSData* DKChunkedDataCompress(NSData* payload)
+{
+	// returns the LZFSE-compressed payload, or nil when compression isn't worthwhile - tiny chunks,
+	// or data that is already compressed (image formats, typically) and barely shrinks
+
+	if ([payload length] < 512)
+		return nil;
+
+	size_t capacity = [payload length];
+	uint8_t* dst = (uint8_t*)malloc(capacity);
+	size_t written = compression_encode_buffer(dst, capacity, (const uint8_t*)[payload bytes], [payload length], NULL, COMPRESSION_LZFSE);
+
+	// demand at least a 5% gain, otherwise raw storage keeps the no-copy mapping path open
+
+	if (written == 0 || written > capacity - capacity / 20) {
+		free(dst);
+		return nil;
+	}
+
+	return [NSData dataWithBytesNoCopy:dst
+								length:written
+						  freeWhenDone:YES];
+}
+
+static NSData* DKChunkedDataExpand(NSData* chunk, uint64_t expandedLength)
+{
+	uint8_t* dst = (uint8_t*)malloc((size_t)expandedLength);
+
+	if (dst == NULL)
+		return nil;
+
+	size_t got = compression_decode_buffer(dst, (size_t)expandedLength, (const uint8_t*)[chunk bytes], [chunk length], NULL, COMPRESSION_LZFSE);
+
+	if (got != (size_t)expandedLength) {
+		free(dst);
+		return nil;
+	}
+
+	return [NSData dataWithBytesNoCopy:dst
+								length:(NSUInteger)expandedLength
+						  freeWhenDone:YES];
+}
+
+/** @brief Creates a drawing from chunked container data, as written by \c -chunkedDrawingData
+
+ The image chunks are handed to a new image manager as subranges of \c drawingData without copying, so when the caller
+ supplies memory-mapped data (see -[DKDrawingDocument readFromURL:ofType:error:]), the typically dominant image bytes
+ stay backed by the file until an image is actually drawn.
+ @param drawingData data representing a chunked drawing file
+ @return the unarchived drawing
+ */
++ (DKDrawing*)drawingWithChunkedData:(NSData*)drawingData
+{
+	NSAssert(drawingData != nil, @"drawing data was nil - unable to proceed");
+
+	char magic[4];
+	NSUInteger offset = sizeof(magic);
+	uint32_t version;
+	uint64_t tocOffset, tocLength;
+
+	if ([drawingData length] < sizeof(magic))
+		return nil;
+
+	[drawingData getBytes:magic
+					range:NSMakeRange(0, sizeof(magic))];
+
+	if (memcmp(magic, kDKChunkedDrawingMagic, sizeof(magic)) != 0
+		|| !DKChunkedDataReadUInt32(drawingData, &offset, &version)
+		|| version > kDKChunkedDrawingVersion
+		|| !DKChunkedDataReadUInt64(drawingData, &offset, &tocOffset)
+		|| !DKChunkedDataReadUInt64(drawingData, &offset, &tocLength)
+		|| tocOffset + tocLength > [drawingData length])
+		return nil;
+
+	// walk the table of contents and build no-copy views onto the chunk payloads. The views retain the whole data
+	// object, so a mapped file remains mapped for as long as any image chunk is still referenced.
+
+	offset = (NSUInteger)tocOffset;
+
+	uint32_t chunkCount;
+
+	if (!DKChunkedDataReadUInt32(drawingData, &offset, &chunkCount))
+		return nil;
+
+	NSData* graphData = nil;
+	NSData* openInfoData = nil;
+	DKImageDataManager* imageManager = [[DKImageDataManager alloc] init];
+	NSMutableDictionary<NSNumber*, NSData*>* layerChunks = [NSMutableDictionary dictionary];
+	NSMutableArray<NSString*>* chunkNames = [NSMutableArray arrayWithCapacity:chunkCount];
+	NSMutableArray<NSData*>* chunkViews = [NSMutableArray arrayWithCapacity:chunkCount];
+	NSMutableArray<NSNumber*>* chunkEncodings = [NSMutableArray arrayWithCapacity:chunkCount];
+	NSMutableArray<NSNumber*>* chunkExpandedLengths = [NSMutableArray arrayWithCapacity:chunkCount];
+
+	for (uint32_t i = 0; i < chunkCount; ++i) {
+		uint32_t nameLength;
+		uint64_t chunkOffset, chunkLength;
+
+		if (!DKChunkedDataReadUInt32(drawingData, &offset, &nameLength) || offset + nameLength > [drawingData length])
+			return nil;
+
+		NSString* chunkName = [[NSString alloc] initWithBytes:((const char*)[drawingData bytes]) + offset
+													   length:nameLength
+													 encoding:NSUTF8StringEncoding];
+		offset += nameLength;
+
+		if (chunkName == nil
+			|| !DKChunkedDataReadUInt64(drawingData, &offset, &chunkOffset)
+			|| !DKChunkedDataReadUInt64(drawingData, &offset, &chunkLength)
+			|| chunkOffset + chunkLength > [drawingData length])
+			return nil;
+
+		// version 3 records how each chunk is encoded and its expanded size; earlier files are all raw
+
+		uint32_t encoding = kDKChunkedDrawingEncodingRaw;
+		uint64_t expandedLength = chunkLength;
+
+		if (version >= 3) {
+			if (!DKChunkedDataReadUInt32(drawingData, &offset, &encoding)
+				|| !DKChunkedDataReadUInt64(drawingData, &offset, &expandedLength)
+				|| encoding > kDKChunkedDrawingEncodingLZFSE)
+				return nil;
+		}
+
+		NSData* chunk = [NSData dataWithBytesNoCopy:(void*)(((const uint8_t*)[drawingData bytes]) + chunkOffset)
+											 length:(NSUInteger)chunkLength
+										deallocator:^(void* bytes, NSUInteger length) {
+#pragma unused(bytes, length)
+											(void)drawingData; // keeps the backing (possibly mapped) data alive
+										}];
+
+		[chunkNames addObject:chunkName];
+		[chunkViews addObject:chunk];
+		[chunkEncodings addObject:@(encoding)];
+		[chunkExpandedLengths addObject:@(expandedLength)];
+	}
+
+	// expand the compressed chunks - each is independent, so they decompress concurrently. Raw chunks
+	// keep their no-copy views onto the (possibly mapped) file data.
+
+	NSUInteger chunkTotal = [chunkViews count];
+	__strong NSData** payloads = (__strong NSData**)calloc(chunkTotal, sizeof(NSData*));
+	__block BOOL expandFailed = NO;
+
+	dispatch_apply(chunkTotal, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t idx) {
+		if ([[chunkEncodings objectAtIndex:idx] unsignedIntValue] == kDKChunkedDrawingEncodingLZFSE) {
+			payloads[idx] = DKChunkedDataExpand([chunkViews objectAtIndex:idx], [[chunkExpandedLengths objectAtIndex:idx] unsignedLongLongValue]);
+
+			if (payloads[idx] == nil)
+				expandFailed = YES;
+		} else
+			payloads[idx] = [chunkViews objectAtIndex:idx];
+	});
+
+	if (expandFailed) {
+		for (NSUInteger i = 0; i < chunkTotal; ++i)
+			payloads[i] = nil;
+
+		free(payloads);
+		return nil;
+	}
+
+	for (NSUInteger i = 0; i < chunkTotal; ++i) {
+		NSString* chunkName = [chunkNames objectAtIndex:i];
+		NSData* chunk = payloads[i];
+
+		if ([chunkName isEqualToString:kDKChunkedDrawingGraphChunkName])
+			graphData = chunk;
+		else if ([chunkName hasPrefix:kDKChunkedDrawingImageChunkPrefix])
+			[imageManager setImageData:chunk
+								forKey:[chunkName substringFromIndex:[kDKChunkedDrawingImageChunkPrefix length]]];
+		else if ([chunkName hasPrefix:kDKChunkedDrawingLayerChunkPrefix])
+			[layerChunks setObject:chunk
+							forKey:@([[chunkName substringFromIndex:[kDKChunkedDrawingLayerChunkPrefix length]] integerValue])];
+		else if ([chunkName isEqualToString:kDKChunkedDrawingOpenInfoChunkName])
+			openInfoData = chunk;
+
+		payloads[i] = nil;
+	}
+
+	free(payloads);
+
+	if (graphData == nil)
+		return nil;
+
+	// decode the object graph. The image manager is handed to the dearchiver up front so that image-using objects can
+	// resolve their keys against the mapped chunks; -initWithCoder: adopts it rather than creating its own.
+
+	DKKeyedUnarchiver* unarch = [[DKKeyedUnarchiver alloc] initForReadingWithData:graphData];
+
+	DKUnarchivingHelper* dearchivingHelper = [self dearchivingHelper];
+	if ([dearchivingHelper respondsToSelector:@selector(reset)])
+		[dearchivingHelper reset];
+
+	[unarch setDelegate:dearchivingHelper];
+	[unarch setImageManager:imageManager];
+
+	LogEvent_(kReactiveEvent, @"decoding drawing root object (chunked)......");
+
+	DKDrawing* dwg = [unarch decodeObjectForKey:@"root"];
+
+	[unarch finishDecoding];
+
+	// version 2 files carry the top-level layers as separate archives, so the graph decodes with an empty layer list.
+	// Each layer is an independent object graph sharing only the image manager (which serializes key access), so they
+	// can be dearchived concurrently - with many layers, open time scales with the core count. Each worker gets its
+	// own dearchiver and helper; the layers are then reattached in their original stacking order.
+
+	if (dwg != nil && [layerChunks count] > 0) {
+		NSUInteger layerCount = [layerChunks count];
+		Class helperClass = [dearchivingHelper class];
+
+		// viewport-priority ordering: the container records the viewport the user last saw and each
+		// layer's content extent. Layers intersecting the viewport (and any whose extent wasn't
+		// recorded - non-object layers are cheap anyway) decode now so the window has something to
+		// show; the rest stream in behind on a background queue.
+
+		NSDictionary* openInfo = nil;
+		NSRect viewport = NSZeroRect;
+
+		if (openInfoData)
+			openInfo = [NSPropertyListSerialization propertyListWithData:openInfoData
+																 options:NSPropertyListImmutable
+																  format:NULL
+																   error:NULL];
+
+		NSString* viewportString = [openInfo objectForKey:@"viewport"];
+
+		if (viewportString)
+			viewport = NSRectFromString(viewportString);
+
+		[dwg setLastViewedRect:viewport];
+
+		NSMutableIndexSet* prioritySet = [NSMutableIndexSet indexSet];
+		NSMutableIndexSet* deferredSet = [NSMutableIndexSet indexSet];
+
+		for (NSUInteger i = 0; i < layerCount; ++i) {
+			NSString* boundsString = [openInfo objectForKey:[NSString stringWithFormat:@"bounds:%lu", (unsigned long)i]];
+
+			if (NSIsEmptyRect(viewport) || boundsString == nil || NSIntersectsRect(NSRectFromString(boundsString), viewport))
+				[prioritySet addIndex:i];
+			else
+				[deferredSet addIndex:i];
+		}
+
+		// never defer everything - the topmost layer always arrives with the open
+
+		if ([prioritySet count] == 0 && layerCount > 0) {
+			[prioritySet addIndex:0];
+			[deferredSet removeIndex:0];
+		}
+
+		DKLayer* (^decodeLayer)(NSUInteger) = ^DKLayer*(NSUInteger idx) {
+			NSData* layerData = [layerChunks objectForKey:@(idx)];
+
+			if (layerData == nil)
+				return nil;
+
+			DKKeyedUnarchiver* layerUnarch = [[DKKeyedUnarchiver alloc] initForReadingWithData:layerData];
+			DKUnarchivingHelper* helper = [[helperClass alloc] init];
+
+			[layerUnarch setDelegate:helper];
+			[layerUnarch setImageManager:imageManager];
+
+			DKLayer* layer = [layerUnarch decodeObjectForKey:@"root"];
+
+			[layerUnarch finishDecoding];
+			return layer;
+		};
+
+		// decode the priority layers concurrently, as every layer was decoded before
+
+		NSUInteger priorityCount = [prioritySet count];
+		NSUInteger* priorityIndexes = (NSUInteger*)malloc(priorityCount * sizeof(NSUInteger));
+		[prioritySet getIndexes:priorityIndexes
+					   maxCount:priorityCount
+				   inIndexRange:NULL];
+
+		__strong DKLayer** decodedLayers = (__strong DKLayer**)calloc(priorityCount, sizeof(DKLayer*));
+
+		dispatch_apply(priorityCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+			decodedLayers[i] = decodeLayer(priorityIndexes[i]);
+		});
+
+		NSMutableArray<DKLayer*>* layers = [NSMutableArray arrayWithCapacity:priorityCount];
+		NSMutableArray<NSNumber*>* attachedOriginalIndexes = [NSMutableArray arrayWithCapacity:priorityCount];
+
+		for (NSUInteger i = 0; i < priorityCount; ++i) {
+			if (decodedLayers[i]) {
+				[layers addObject:decodedLayers[i]];
+				[attachedOriginalIndexes addObject:@(priorityIndexes[i])];
+			}
+			decodedLayers[i] = nil;
+		}
+
+		free(decodedLayers);
+		free(priorityIndexes);
+
+		[dwg setLayers:layers];
+		[dwg wasAddedToDrawing:dwg];
+		[dwg setActiveLayer:[dwg firstLayerOfClass:[DKObjectDrawingLayer class]]];
+
+		// the deferred layers decode sequentially in the background and attach on the main queue,
+		// each slotted back into its original stacking position. Undo registration is suppressed
+		// around the insert - streaming in saved content is not a user action.
+
+		if ([deferredSet count] > 0) {
+			NSIndexSet* deferred = [deferredSet copy];
+
+			dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+				for (NSUInteger idx = [deferred firstIndex]; idx != NSNotFound; idx = [deferred indexGreaterThanIndex:idx]) {
+					DKLayer* layer = decodeLayer(idx);
+
+					if (layer == nil)
+						continue;
+
+					dispatch_async(dispatch_get_main_queue(), ^{
+						NSUInteger insertAt = 0;
+
+						for (NSNumber* attached in attachedOriginalIndexes) {
+							if ([attached unsignedIntegerValue] < idx)
+								++insertAt;
+						}
+
+						[attachedOriginalIndexes insertObject:@(idx)
+													  atIndex:MIN(insertAt, [attachedOriginalIndexes count])];
+
+						[[dwg undoManager] disableUndoRegistration];
+						[dwg insertObject:layer
+							inLayersAtIndex:MIN(insertAt, [dwg countOfLayers])];
+						[layer wasAddedToDrawing:dwg];
+						[[dwg undoManager] enableUndoRegistration];
+
+						if ([dwg activeLayer] == nil)
+							[dwg setActiveLayer:[dwg firstLayerOfClass:[DKObjectDrawingLayer class]]];
+					});
+				}
+			});
+		}
+	}
+
+	// warm the text machinery for the styles of the layers attached so far (deferred layers warm
+	// their fonts naturally as they stream in) - see +warmTextAttributesOfStyles:
+
+	if (dwg != nil)
+		[DKStyle warmTextAttributesOfStyles:[dwg allStyles]];
+
 	return dwg;
 }
 
@@ -414,6 +843,7 @@ static id sDearchivingHelper = nil;
 }
 
 @synthesize owner = mOwnerRef;
+@synthesize lastViewedRect = mLastViewedRect;
 
 #pragma mark -
 #pragma mark - basic drawing parameters
@@ -437,14 +867,12 @@ static id sDearchivingHelper = nil;
 															object:self];
 		m_size = aSize;
 
-		// adjust bounds of every view to match
-
-		[self drawingDidChangeToSize:[NSValue valueWithSize:aSize]];
-		[[self controllers] makeObjectsPerformSelector:@selector(drawingDidChangeToSize:)
-											withObject:[NSValue valueWithSize:aSize]];
+		// the fan-out to layers, controllers and observers is coalesced per runloop turn - see
+		// -reconcilePendingGeometryChanges. During interactive resizing this means every layer
+		// recomputes its geometry-dependent caches once per frame, not once per set.
 
-		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingDidChangeSize
-															object:self];
+		mPendingSizeChange = YES;
+		[self scheduleGeometryReconcile];
 
 		if (!([[self undoManager] isUndoing] || [[self undoManager] isRedoing]))
 			[[self undoManager] setActionName:NSLocalizedString(@"Change Drawing Size", @"undo action for set drawing size")];
@@ -483,9 +911,16 @@ static id sDearchivingHelper = nil;
 		m_topMargin = t;
 		m_bottomMargin = b;
 
-		[self drawingDidChangeMargins:[NSValue valueWithRect:oldInterior]];
-		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingDidChangeMargins
-															object:self];
+		// fan-out is coalesced per runloop turn. The first captured interior survives coalescing,
+		// so the cumulative offset object layers apply to reposition their content stays correct
+		// however many margin changes land this turn.
+
+		if (!mPendingMarginsChange) {
+			mPendingOldInterior = oldInterior;
+			mPendingMarginsChange = YES;
+		}
+
+		[self scheduleGeometryReconcile];
 		[self setNeedsDisplay:YES];
 
 		if (!([[self undoManager] isUndoing] || [[self undoManager] isRedoing]))
@@ -501,6 +936,50 @@ static id sDearchivingHelper = nil;
 				  bottom:[printInfo bottomMargin]];
 }
 
+/** @brief Queues a single geometry reconcile for the current runloop turn if one isn't queued already. */
+- (void)scheduleGeometryReconcile
+{
+	if (!mGeometryReconcileScheduled) {
+		mGeometryReconcileScheduled = YES;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self reconcilePendingGeometryChanges];
+		});
+	}
+}
+
+/** @brief Delivers any pending coalesced size/margin change - the layer and controller fan-out and
+ the matching Did notifications. Size is reconciled before margins, matching the order the
+ synchronous path used. A no-op when nothing is pending, so the drawRect flush and the queued
+ reconcile can both run harmlessly in the same turn.
+ */
+- (void)reconcilePendingGeometryChanges
+{
+	mGeometryReconcileScheduled = NO;
+
+	if (mPendingSizeChange) {
+		mPendingSizeChange = NO;
+
+		NSValue* sizeVal = [NSValue valueWithSize:[self drawingSize]];
+
+		// adjust bounds of every view to match
+
+		[self drawingDidChangeToSize:sizeVal];
+		[[self controllers] makeObjectsPerformSelector:@selector(drawingDidChangeToSize:)
+											withObject:sizeVal];
+
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingDidChangeSize
+															object:self];
+	}
+
+	if (mPendingMarginsChange) {
+		mPendingMarginsChange = NO;
+
+		[self drawingDidChangeMargins:[NSValue valueWithRect:mPendingOldInterior]];
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingDidChangeMargins
+															object:self];
+	}
+}
+
 @synthesize leftMargin = m_leftMargin;
 @synthesize rightMargin = m_rightMargin;
 @synthesize topMargin = m_topMargin;
@@ -705,6 +1184,12 @@ static id sDearchivingHelper = nil;
 {
 #pragma unused(timer)
 
+	// while a tool gesture is in progress the fast tier is held regardless of redraw frequency - the
+	// high quality pass comes from -endInteractiveRendering when the gesture completes
+
+	if ([self interactiveRenderingInProgress])
+		return;
+
 	// if the timer ever fires it calls this, so we simply invalidate it and set high quality
 
 	[m_renderQualityTimer invalidate];
@@ -717,6 +1202,146 @@ static id sDearchivingHelper = nil;
 
 @synthesize lowQualityTriggerInterval = mTriggerPeriod;
 
+- (void)beginInteractiveRendering
+{
+	// nestable - the first begin drops to the fast tier immediately rather than waiting for the
+	// redraw-frequency heuristic to notice the gesture
+
+	if (++mInteractiveRenderingCount == 1 && [self dynamicQualityModulationEnabled])
+		[self setLowRenderingQuality:YES];
+}
+
+- (void)endInteractiveRendering
+{
+	NSAssert(mInteractiveRenderingCount > 0, @"unbalanced call to endInteractiveRendering");
+
+	if (mInteractiveRenderingCount > 0 && --mInteractiveRenderingCount == 0) {
+		// gesture over - restore best quality at once and repaint whatever was drawn fast
+
+		if (m_renderQualityTimer != nil) {
+			[m_renderQualityTimer invalidate];
+			m_renderQualityTimer = nil;
+		}
+
+		if ([self lowRenderingQuality]) {
+			[self setLowRenderingQuality:NO];
+			m_isForcedHQUpdate = YES;
+			[self setNeedsDisplayInRect:m_lastRectUpdated];
+			m_lastRectUpdated = NSZeroRect;
+		}
+	}
+}
+
+- (BOOL)interactiveRenderingInProgress
+{
+	return mInteractiveRenderingCount > 0;
+}
+
+#pragma mark -
+#pragma mark - asynchronous rendering
+
+@synthesize asynchronousRenderingEnabled = mAsyncRenderingEnabled;
+
+- (void)setAsynchronousRenderingEnabled:(BOOL)enable
+{
+	if (enable != mAsyncRenderingEnabled) {
+		mAsyncRenderingEnabled = enable;
+
+		if (enable) {
+			// render an initial frame so there is something to composite
+
+			mAsyncContentDirty = NO;
+			[self scheduleAsynchronousRender];
+		} else {
+			mAsyncRenderedFrame = nil;
+			[self setNeedsDisplay:YES];
+		}
+	}
+}
+
+- (BOOL)isAsynchronousRenderInProgress
+{
+	return mAsyncRenderInFlight;
+}
+
+/** @brief Kicks off a background render of the whole drawing from an isolated snapshot
+
+ All state here is touched on the main thread only; the background queue sees nothing but the archived
+ snapshot, so editing can continue freely while the render is in flight. Further triggers arriving while
+ a render is outstanding are coalesced into a single follow-up render.
+ */
+- (void)scheduleAsynchronousRender
+{
+	if (!mAsyncRenderingEnabled || mAsyncRenderInFlight)
+		return;
+
+	mAsyncRenderInFlight = YES;
+	mAsyncContentDirty = NO;
+
+	if (mAsyncRenderQueue == NULL)
+		mAsyncRenderQueue = dispatch_queue_create("net.apptree.drawkit.asyncrender", DISPATCH_QUEUE_SERIAL);
+
+	NSData* snapshot = [self drawingData];
+	NSSize size = [self drawingSize];
+	BOOL flipped = [self isFlipped];
+
+	dispatch_async(mAsyncRenderQueue, ^{
+		DKDrawing* replica = [DKDrawing drawingWithData:snapshot];
+		NSImage* frame = [[NSImage alloc] initWithSize:size];
+
+		[frame lockFocusFlipped:flipped];
+		[replica drawRect:NSMakeRect(0, 0, size.width, size.height)
+				   inView:nil];
+		[frame unlockFocus];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			mAsyncRenderInFlight = NO;
+
+			if (!mAsyncRenderingEnabled)
+				return;
+
+			mAsyncRenderedFrame = frame;
+
+			// update the views directly - going through -setNeedsDisplay: would mark the content dirty again
+
+			[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplay:)
+												withObject:@YES];
+
+			if (mAsyncContentDirty) {
+				mAsyncContentDirty = NO;
+				[self scheduleAsynchronousRender];
+			}
+		});
+	});
+}
+
+/** @brief Composites the most recently completed frame; called from -drawRect:inView: in async mode
+ */
+- (void)compositeAsynchronousFrameInRect:(NSRect)rect
+{
+	if ([self paperColour]) {
+		[[self paperColour] set];
+		NSRectFillUsingOperation(rect, NSCompositeSourceOver);
+	}
+
+	if (mAsyncRenderedFrame) {
+		NSRect fr = NSZeroRect;
+		fr.size = [self drawingSize];
+
+		[mAsyncRenderedFrame drawInRect:fr
+							   fromRect:NSZeroRect
+							  operation:NSCompositeSourceOver
+							   fraction:1.0
+						 respectFlipped:YES
+								  hints:nil];
+	}
+
+	if (mAsyncContentDirty && !mAsyncRenderInFlight) {
+		mAsyncContentDirty = NO;
+		[self scheduleAsynchronousRender];
+	}
+}
+
 #pragma mark -
 #pragma mark - setting the undo manager
 
@@ -1257,6 +1882,174 @@ static id sDearchivingHelper = nil;
 	return [NSKeyedArchiver archivedDataWithRootObject:self];
 }
 
+/** @brief Returns the entire drawing as a chunked container file
+
+ The container consists of a short header, a keyed archive of the drawing and one chunk per entry in the image
+ manager's repository, located by a table of contents at the end of the file. Because the image data is written outside
+ the object graph, +drawingWithChunkedData: can map the file and hand the image chunks to the image manager as byte
+ ranges of the mapping, so the image bytes are neither copied nor decoded until an image is actually drawn. Chunks
+ that benefit are stored LZFSE-compressed - the archive chunks typically shrink several-fold - and expand in
+ parallel on open.
+ @return an NSData object which is the entire drawing and all its contents
+ */
+- (NSData*)chunkedDrawingData
+{
+	[self finalizePriorToSaving];
+
+	// archive the object graph. Image-using objects detect the archiver's setting and leave their embedded image data
+	// out of the archive - it is written as separate chunks below, keyed by the image manager's keys. The top-level
+	// layers are likewise deferred and each written as its own archive, so that +drawingWithChunkedData: can decode
+	// them on several workers at once.
+
+	NSMutableData* graphData = [NSMutableData data];
+	DKKeyedArchiver* karch = [[DKKeyedArchiver alloc] initForWritingWithMutableData:graphData];
+
+	NSAssert(karch != nil, @"couldn't create archiver for archiving with data");
+
+	[karch setImageManager:[self imageManager]];
+	[karch setExternalizesImageData:YES];
+	[karch setDeferredLayerGroup:self];
+	[karch encodeObject:self
+				 forKey:@"root"];
+	[karch finishEncoding];
+
+	NSMutableArray<NSString*>* chunkNames = [NSMutableArray array];
+	NSMutableArray<NSData*>* chunkPayloads = [NSMutableArray array];
+
+	[chunkNames addObject:kDKChunkedDrawingGraphChunkName];
+	[chunkPayloads addObject:graphData];
+
+	[[self layers] enumerateObjectsUsingBlock:^(DKLayer* layer, NSUInteger idx, BOOL* stop) {
+#pragma unused(stop)
+		NSMutableData* layerData = [NSMutableData data];
+		DKKeyedArchiver* larch = [[DKKeyedArchiver alloc] initForWritingWithMutableData:layerData];
+
+		[larch setImageManager:[self imageManager]];
+		[larch setExternalizesImageData:YES];
+		[larch encodeObject:layer
+					 forKey:@"root"];
+		[larch finishEncoding];
+
+		[chunkNames addObject:[NSString stringWithFormat:@"%@%lu", kDKChunkedDrawingLayerChunkPrefix, (unsigned long)idx]];
+		[chunkPayloads addObject:layerData];
+	}];
+
+	for (NSString* key in [[self imageManager] allKeys]) {
+		NSData* imageData = [[self imageManager] imageDataForKey:key];
+
+		if (imageData) {
+			[chunkNames addObject:[kDKChunkedDrawingImageChunkPrefix stringByAppendingString:key]];
+			[chunkPayloads addObject:imageData];
+		}
+	}
+
+	// record what the open path needs for viewport-priority loading: the viewport the user last saw
+	// and the extent of each layer's content, so layers outside the viewport can stream in behind
+
+	NSMutableDictionary* openInfo = [NSMutableDictionary dictionary];
+
+	if (!NSIsEmptyRect([self lastViewedRect]))
+		[openInfo setObject:NSStringFromRect([self lastViewedRect])
+					 forKey:@"viewport"];
+
+	[[self layers] enumerateObjectsUsingBlock:^(DKLayer* layer, NSUInteger idx, BOOL* stop) {
+#pragma unused(stop)
+		if ([layer isKindOfClass:[DKObjectOwnerLayer class]]) {
+			NSRect contentBounds = [(DKObjectOwnerLayer*)layer unionOfAllObjectBounds];
+
+			if (!NSIsEmptyRect(contentBounds))
+				[openInfo setObject:NSStringFromRect(contentBounds)
+							 forKey:[NSString stringWithFormat:@"bounds:%lu", (unsigned long)idx]];
+		}
+	}];
+
+	if ([openInfo count] > 0) {
+		NSData* openInfoData = [NSPropertyListSerialization dataWithPropertyList:openInfo
+																		  format:NSPropertyListBinaryFormat_v1_0
+																		 options:0
+																		   error:NULL];
+
+		if (openInfoData) {
+			[chunkNames addObject:kDKChunkedDrawingOpenInfoChunkName];
+			[chunkPayloads addObject:openInfoData];
+		}
+	}
+
+	// compress the payloads that benefit - the keyed archives shrink several-fold, image chunks mostly
+	// hold already-compressed formats and stay raw. Chunks are independent, so this runs concurrently.
+
+	NSUInteger chunkTotal = [chunkPayloads count];
+	__strong NSData** packed = (__strong NSData**)calloc(chunkTotal, sizeof(NSData*));
+
+	dispatch_apply(chunkTotal, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t idx) {
+		packed[idx] = DKChunkedDataCompress([chunkPayloads objectAtIndex:idx]);
+	});
+
+	NSMutableArray<NSNumber*>* chunkEncodings = [NSMutableArray arrayWithCapacity:chunkTotal];
+	NSMutableArray<NSNumber*>* chunkExpandedLengths = [NSMutableArray arrayWithCapacity:chunkTotal];
+
+	for (NSUInteger i = 0; i < chunkTotal; ++i) {
+		[chunkExpandedLengths addObject:@([[chunkPayloads objectAtIndex:i] length])];
+
+		if (packed[i] != nil) {
+			[chunkEncodings addObject:@(kDKChunkedDrawingEncodingLZFSE)];
+			[chunkPayloads replaceObjectAtIndex:i
+									 withObject:packed[i]];
+		} else
+			[chunkEncodings addObject:@(kDKChunkedDrawingEncodingRaw)];
+
+		packed[i] = nil;
+	}
+
+	free(packed);
+
+	// the header records where the table of contents lands, which isn't known until the payloads have been written,
+	// so reserve its two fields and patch them afterwards
+
+	NSMutableData* result = [NSMutableData data];
+
+	[result appendBytes:kDKChunkedDrawingMagic
+				 length:sizeof(kDKChunkedDrawingMagic)];
+	DKChunkedDataAppendUInt32(result, kDKChunkedDrawingVersion);
+
+	NSUInteger tocFixupOffset = [result length];
+	DKChunkedDataAppendUInt64(result, 0);
+	DKChunkedDataAppendUInt64(result, 0);
+
+	NSMutableArray<NSValue*>* chunkRanges = [NSMutableArray array];
+
+	for (NSData* chunk in chunkPayloads) {
+		[chunkRanges addObject:[NSValue valueWithRange:NSMakeRange([result length], [chunk length])]];
+		[result appendData:chunk];
+	}
+
+	uint64_t tocOffset = [result length];
+
+	DKChunkedDataAppendUInt32(result, (uint32_t)[chunkNames count]);
+
+	[chunkNames enumerateObjectsUsingBlock:^(NSString* name, NSUInteger idx, BOOL* stop) {
+#pragma unused(stop)
+		NSData* nameData = [name dataUsingEncoding:NSUTF8StringEncoding];
+		NSRange chunkRange = [[chunkRanges objectAtIndex:idx] rangeValue];
+
+		DKChunkedDataAppendUInt32(result, (uint32_t)[nameData length]);
+		[result appendData:nameData];
+		DKChunkedDataAppendUInt64(result, chunkRange.location);
+		DKChunkedDataAppendUInt64(result, chunkRange.length);
+		DKChunkedDataAppendUInt32(result, [[chunkEncodings objectAtIndex:idx] unsignedIntValue]);
+		DKChunkedDataAppendUInt64(result, [[chunkExpandedLengths objectAtIndex:idx] unsignedLongLongValue]);
+	}];
+
+	uint64_t le = NSSwapHostLongLongToLittle(tocOffset);
+	[result replaceBytesInRange:NSMakeRange(tocFixupOffset, sizeof(le))
+					  withBytes:&le];
+	le = NSSwapHostLongLongToLittle([result length] - tocOffset);
+	[result replaceBytesInRange:NSMakeRange(tocFixupOffset + sizeof(le), sizeof(le))
+					  withBytes:&le];
+
+	return [result copy];
+}
+
 /** @brief The entire drawing in PDF format
 
  When rendering a drawing for PDF, the drawing acts as if it were printing, therefore layers that
@@ -1355,11 +2148,25 @@ static id sDearchivingHelper = nil;
  */
 - (void)drawRect:(NSRect)rect inView:(DKDrawingView*)aView
 {
+	// any coalesced size/margin change must land before layers paint from their geometry caches
+
+	[self reconcilePendingGeometryChanges];
+
 	// save the graphics context on entry so that we can restore it when we return. This allows recovery from an exception
 	// that could leave the context stack unbalanced.
 
 	NSGraphicsContext* topContext = [NSGraphicsContext currentContext];
 
+	// in asynchronous mode, screen updates just composite the latest completed background frame - the layer
+	// stack is never drawn inline. Printing and export fall through to the normal synchronous path.
+
+	if (mAsyncRenderingEnabled && [NSGraphicsContext currentContextDrawingToScreen]) {
+		[self compositeAsynchronousFrameInRect:rect];
+		return;
+	}
+
+	DK_SIGNPOST_BEGIN("DKDrawing drawRect", self, "rect={{%g,%g},{%g,%g}}", rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
+
 	@try {
 		// paint the paper colour over the view area. Not printed unless explictly set to do so.
 
@@ -1408,6 +2215,7 @@ static id sDearchivingHelper = nil;
 	}
 	@finally {
 		m_isForcedHQUpdate = NO;
+		DK_SIGNPOST_END("DKDrawing drawRect", self);
 	}
 
 	[NSGraphicsContext setCurrentContext:topContext];
@@ -1420,6 +2228,16 @@ static id sDearchivingHelper = nil;
  */
 - (void)setNeedsDisplay:(BOOL)refresh
 {
+	if (refresh && mAsyncRenderingEnabled) {
+		mAsyncContentDirty = YES;
+		[self scheduleAsynchronousRender];
+	}
+
+	// a whole-drawing update supersedes anything collected for coalescing
+
+	if (refresh)
+		[mPendingUpdateRects removeAllObjects];
+
 	[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplay:)
 										withObject:@(refresh)];
 }
@@ -1432,6 +2250,30 @@ static id sDearchivingHelper = nil;
  */
 - (void)setNeedsDisplayInRect:(NSRect)rect
 {
+	if (mAsyncRenderingEnabled) {
+		mAsyncContentDirty = YES;
+		[self scheduleAsynchronousRender];
+	}
+
+	// in coalescing mode the rect is collected and clustered with the rest of the turn's updates - see
+	// -flushPendingUpdates. This keeps thousands of tiny per-object rects from being merged by AppKit
+	// into one giant union covering everything in between.
+
+	if (mCoalescesUpdates) {
+		if (mPendingUpdateRects == nil)
+			mPendingUpdateRects = [[NSMutableArray alloc] init];
+
+		[mPendingUpdateRects addObject:[NSValue valueWithRect:rect]];
+
+		if (!mUpdateFlushScheduled) {
+			mUpdateFlushScheduled = YES;
+			dispatch_async(dispatch_get_main_queue(), ^{
+				[self flushPendingUpdates];
+			});
+		}
+		return;
+	}
+
 	[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplayInRect:)
 										withObject:[NSValue valueWithRect:rect]];
 }
@@ -1445,12 +2287,110 @@ static id sDearchivingHelper = nil;
 {
 	NSAssert(setOfRects != nil, @"update set was nil");
 
+	if (mCoalescesUpdates) {
+		for (NSValue* val in setOfRects)
+			[self setNeedsDisplayInRect:[val rectValue]];
+
+		return;
+	}
+
 	for (NSValue* val in setOfRects) {
 		[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplayInRect:)
 											withObject:val];
 	}
 }
 
+- (void)setCoalescesUpdates:(BOOL)coalesce
+{
+	if (coalesce != mCoalescesUpdates) {
+		mCoalescesUpdates = coalesce;
+
+		// anything already collected is delivered before the mode changes
+
+		if (!coalesce)
+			[self flushPendingUpdates];
+	}
+}
+
+- (BOOL)coalescesUpdates
+{
+	return mCoalescesUpdates;
+}
+
+#define kDKUpdateCoalescingMaxClusters 16
+
+/** @brief Clusters the rects collected this runloop turn into a few tight regions and invalidates those.
+
+ Greedy clustering: each rect joins the existing cluster it can join with the least wasted area, provided the union
+ isn't much larger than its parts; otherwise it starts a new cluster. Once the cluster limit is reached the cheapest
+ merge is taken regardless, so pathological scatter degrades gracefully toward fewer, larger regions instead of one
+ all-covering union.
+ */
+- (void)flushPendingUpdates
+{
+	mUpdateFlushScheduled = NO;
+
+	if ([mPendingUpdateRects count] == 0)
+		return;
+
+	NSArray<NSValue*>* pending = mPendingUpdateRects;
+	mPendingUpdateRects = [[NSMutableArray alloc] init];
+
+	NSRect clusters[kDKUpdateCoalescingMaxClusters];
+	NSUInteger clusterCount = 0;
+
+	for (NSValue* val in pending) {
+		NSRect r = [val rectValue];
+
+		if (NSIsEmptyRect(r))
+			continue;
+
+		NSUInteger best = NSNotFound;
+		CGFloat bestWaste = CGFLOAT_MAX;
+
+		for (NSUInteger i = 0; i < clusterCount; ++i) {
+			NSRect u = NSUnionRect(clusters[i], r);
+			CGFloat waste = (NSWidth(u) * NSHeight(u)) - (NSWidth(clusters[i]) * NSHeight(clusters[i]));
+
+			if (waste < bestWaste) {
+				bestWaste = waste;
+				best = i;
+			}
+		}
+
+		CGFloat area = NSWidth(r) * NSHeight(r);
+
+		if (best != NSNotFound && (bestWaste <= area * 2.0 || clusterCount == kDKUpdateCoalescingMaxClusters))
+			clusters[best] = NSUnionRect(clusters[best], r);
+		else
+			clusters[clusterCount++] = r;
+	}
+
+	// fold together any clusters that ended up overlapping each other
+
+	BOOL didMerge;
+
+	do {
+		didMerge = NO;
+
+		for (NSUInteger i = 0; i < clusterCount && !didMerge; ++i) {
+			for (NSUInteger j = i + 1; j < clusterCount; ++j) {
+				if (NSIntersectsRect(clusters[i], clusters[j])) {
+					clusters[i] = NSUnionRect(clusters[i], clusters[j]);
+					clusters[j] = clusters[--clusterCount];
+					didMerge = YES;
+					break;
+				}
+			}
+		}
+	} while (didMerge);
+
+	for (NSUInteger i = 0; i < clusterCount; ++i) {
+		[[self controllers] makeObjectsPerformSelector:@selector(setViewNeedsDisplayInRect:)
+											withObject:[NSValue valueWithRect:clusters[i]]];
+	}
+}
+
 /** @brief Marks several areas for update at once
 
  Several update optimising methods return sets of rect values, this allows them to be processed
@@ -1484,6 +2424,11 @@ static id sDearchivingHelper = nil;
  */
 - (void)updateMetadataKeys
 {
+	// layer metadata may have been archived as a compact blob - expand it first (this override does not call
+	// super, whose migration rules assume flat user info items are metadata, which is not true for a drawing)
+
+	[self reconstituteCompactMetadata];
+
 	if ([self drawingInfo] == nil) {
 		// assumes that all items in userInfo belong to drawing info. This is certainly true for DK implementations prior
 		// to 107, since all info values got dumped into the user info as a flat list.
@@ -1607,9 +2552,17 @@ static id sDearchivingHelper = nil;
 	[self setDrawingUnits:[coder decodeObjectForKey:@"drawing_units"]
 		unitToPointsConversionFactor:[coder decodeDoubleForKey:@"utp_conv"]];
 
-	// create an image manager - it is not necessary for this object to be archived
+	// create an image manager - it is not necessary for this object to be archived. If the coder already carries one
+	// (the chunked file format seeds it with the mapped image chunks before decoding), adopt it instead so the keys
+	// archived by image-using objects resolve against that data.
 
-	DKImageDataManager* imageManager = [[DKImageDataManager alloc] init];
+	DKImageDataManager* imageManager = nil;
+
+	if ([coder respondsToSelector:@selector(imageManager)])
+		imageManager = [(DKKeyedUnarchiver*)coder imageManager];
+
+	if (imageManager == nil)
+		imageManager = [[DKImageDataManager alloc] init];
 
 	// if the coder can respond to the -setImageManager: method, set it. This allows certain objects to dearchive images that
 	// are held by the image manager even though the object doesn't have a valid reference to the drawing to get it. It can get it from the
@@ -35,6 +35,10 @@ NS_ASSUME_NONNULL_BEGIN
 @private
 	IBOutlet DKDrawingView* __weak mMainDrawingView;
 	DKDrawing* m_drawing;
+	BOOL mJournalledSavingEnabled; // whether incremental (journalled) saving is in use
+	BOOL mJournalNeedsFullSnapshot; // set when a structural change invalidates the journal
+	NSUInteger mJournalSaveMark; // change sequence at the time of the last save
+	NSUInteger mJournalRecordCount; // number of delta records appended since the last full snapshot
 }
 
 /** @brief Returns an undo manager that can be shared by multiple documents.
@@ -193,6 +197,27 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (IBAction)deleteActiveLayer:(nullable id)sender;
 
+/** @brief Whether saving the document writes incremental change journals between full snapshots.
+
+ When enabled, a plain Save (or autosave in place) of the native file type appends compact
+ change records to a sidecar journal file alongside the document instead of re-archiving the
+ entire drawing. Each record carries an object's \c uniqueKey and its archived state, so the
+ journal grows with the size of the edit, not the size of the document. A full snapshot is
+ written (and the journal reset) whenever the document structure changes - objects or layers
+ added or removed, drawing resized - when Save As targets a new location, or when the journal
+ passes its compaction threshold. Opening a document replays any valid journal over the
+ snapshot, then consolidates on the next save.
+
+ The default is <code>NO</code>; the journal file is an implementation detail and apps that
+ enable this should treat the sidecar as part of the document when copying or moving files.
+ */
+@property (nonatomic) BOOL journalledSavingEnabled;
+
+/** @brief The location of the journal sidecar file for the document's current location.
+ @return The journal URL, or \c nil if the document has never been saved.
+ */
+@property (readonly, nullable) NSURL* journalURL;
+
 /** @brief Creates a view used to handle printing.
 
  This may be overridden to customise the print view. Called by \c printShowingPrintPanel:
@@ -206,6 +231,8 @@ extern NSString* const kDKDrawingDocumentType;
 extern NSString* const kDKDrawingDocumentUTI;
 extern NSString* const kDKDrawingDocumentXMLType;
 extern NSString* const kDKDrawingDocumentXMLUTI;
+extern NSString* const kDKDrawingDocumentChunkedType;
+extern NSString* const kDKDrawingDocumentChunkedUTI;
 
 extern NSString* const kDKDocumentLevelsOfUndoDefaultsKey;
 
@@ -5,6 +5,7 @@
 */
 
 #import "DKDrawingDocument.h"
+#import "DKDrawableObject.h"
 #import "DKDrawing+Paper.h"
 #import "DKDrawing.h"
 #import "DKDrawingInfoLayer.h"
@@ -32,9 +33,24 @@ NSString* const kDKDrawingDocumentType = @"Drawing";
 NSString* const kDKDrawingDocumentUTI = @"net.apptree.drawing";
 NSString* const kDKDrawingDocumentXMLType = @"xml_drawing";
 NSString* const kDKDrawingDocumentXMLUTI = @"net.apptree.xmldrawing";
+NSString* const kDKDrawingDocumentChunkedType = @"chunked_drawing";
+NSString* const kDKDrawingDocumentChunkedUTI = @"net.apptree.chunkeddrawing";
 
 NSString* const kDKDocumentLevelsOfUndoDefaultsKey = @"kDKDocumentLevelsOfUndo";
 
+static NSString* const kDKJournalPathExtension = @"dkjournal";
+static NSString* const kDKJournalRecordObjectKey = @"key";
+static NSString* const kDKJournalRecordObjectValue = @"object";
+static NSString* const kDKJournalHeaderSnapshotSize = @"snapshotSize";
+static NSString* const kDKJournalHeaderSnapshotDate = @"snapshotDate";
+
+// a save appends to the journal only when the number of dirty objects is modest - beyond this a full
+// snapshot is no slower and keeps the journal small. Once the journal accumulates this many records in
+// total it is compacted by rolling it into a fresh snapshot on the next save.
+
+#define kDKJournalMaxRecordsPerSave 64lu
+#define kDKJournalCompactionRecordLimit 256lu
+
 #define qGlobalUndoManager 0
 
 #pragma mark -
@@ -401,6 +417,256 @@ static NSMutableDictionary* sFileExportBindings = nil;
 	return pdv;
 }
 
+#pragma mark -
+#pragma mark incremental (journalled) saving
+
+- (void)setJournalledSavingEnabled:(BOOL)enable
+{
+	if (enable != mJournalledSavingEnabled) {
+		mJournalledSavingEnabled = enable;
+
+		// the journal is only trustworthy once a full snapshot has established its baseline
+
+		mJournalNeedsFullSnapshot = YES;
+	}
+}
+
+@synthesize journalledSavingEnabled = mJournalledSavingEnabled;
+
+- (NSURL*)journalURL
+{
+	return [self journalURLForDocumentURL:[self fileURL]];
+}
+
+- (NSURL*)journalURLForDocumentURL:(NSURL*)url
+{
+	return [url URLByAppendingPathExtension:kDKJournalPathExtension];
+}
+
+/** @brief Invalidates the journal when the document's structure changes.
+
+ Object and layer insertion/removal and drawing resizes can't be expressed as per-object deltas,
+ so any of them forces the next save to write a full snapshot.
+ */
+- (void)journalStructureDidChange:(NSNotification*)note
+{
+	id obj = [note object];
+	DKDrawing* dwg = nil;
+
+	if ([obj isKindOfClass:[DKDrawing class]])
+		dwg = obj;
+	else if ([obj respondsToSelector:@selector(drawing)])
+		dwg = [obj drawing];
+
+	if (dwg == [self drawing])
+		mJournalNeedsFullSnapshot = YES;
+}
+
+- (BOOL)fileTypeIsNativeDrawing:(NSString*)typeName
+{
+	return [typeName isEqualToString:kDKDrawingDocumentType] || [typeName isEqualToString:kDKDrawingDocumentUTI];
+}
+
+- (BOOL)canJournalSaveOfType:(NSString*)typeName forSaveOperation:(NSSaveOperationType)saveOperation
+{
+	// journalled saving only applies to a plain Save of the native type back to the existing file,
+	// and only while the journal is a faithful record of the changes since the last snapshot
+
+	return mJournalledSavingEnabled
+		&& !mJournalNeedsFullSnapshot
+		&& saveOperation == NSSaveOperation
+		&& [self fileTypeIsNativeDrawing:typeName]
+		&& [self fileURL] != nil
+		&& [[NSFileManager defaultManager] fileExistsAtPath:[[self journalURL] path]];
+}
+
+/** @brief Returns the objects changed since the last save, or \c nil if a full save is preferable.
+
+ Objects are dirty when their change sequence postdates the save mark. If more than
+ \c kDKJournalMaxRecordsPerSave objects are dirty, \c nil is returned - at that point a full
+ snapshot costs about the same and keeps the journal compact.
+ */
+- (NSArray<DKDrawableObject*>*)journalDirtyObjects
+{
+	NSMutableArray* dirty = [NSMutableArray array];
+
+	for (DKObjectOwnerLayer* layer in [[self drawing] flattenedLayersOfClass:[DKObjectOwnerLayer class]]) {
+		for (DKDrawableObject* obj in [layer objects]) {
+			if ([obj changeSequence] > mJournalSaveMark) {
+				[dirty addObject:obj];
+
+				if ([dirty count] > kDKJournalMaxRecordsPerSave)
+					return nil;
+			}
+		}
+	}
+
+	return dirty;
+}
+
+/** @brief Appends one length-prefixed archived record per object to the journal sidecar. */
+- (BOOL)appendJournalRecordsForObjects:(NSArray<DKDrawableObject*>*)objects error:(NSError**)outError
+{
+	NSFileHandle* fh = [NSFileHandle fileHandleForWritingToURL:[self journalURL]
+														 error:outError];
+
+	if (fh == nil)
+		return NO;
+
+	@try {
+		[fh seekToEndOfFile];
+
+		for (DKDrawableObject* obj in objects) {
+			NSDictionary* record = @{ kDKJournalRecordObjectKey: [obj uniqueKey],
+				kDKJournalRecordObjectValue: obj };
+			NSData* data = [NSKeyedArchiver archivedDataWithRootObject:record];
+			uint64_t length = CFSwapInt64HostToBig((uint64_t)[data length]);
+
+			[fh writeData:[NSData dataWithBytes:&length
+										 length:sizeof(length)]];
+			[fh writeData:data];
+		}
+
+		[fh synchronizeFile];
+	}
+	@catch (NSException* e) {
+		LogEvent_(kWheneverEvent, @"exception while appending to journal: %@", e);
+
+		if (outError)
+			*outError = [NSError errorWithDomain:NSCocoaErrorDomain
+											code:NSFileWriteUnknownError
+										userInfo:nil];
+		return NO;
+	}
+	@finally {
+		[fh closeFile];
+	}
+
+	mJournalRecordCount += [objects count];
+
+	LogEvent_(kFileEvent, @"journalled save appended %lu records (%lu total)", (unsigned long)[objects count], (unsigned long)mJournalRecordCount);
+
+	return YES;
+}
+
+/** @brief Starts a fresh journal after a full snapshot has been written to \c url.
+
+ The journal's first record captures the snapshot's size and modification date so that a
+ journal left behind by another copy of the file can be detected and ignored on open.
+ */
+- (void)resetJournalForSnapshotAtURL:(NSURL*)url
+{
+	NSDictionary* attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:[url path]
+																		   error:NULL];
+
+	if (attrs == nil)
+		return;
+
+	NSDictionary* header = @{ kDKJournalHeaderSnapshotSize: @([attrs fileSize]),
+		kDKJournalHeaderSnapshotDate: [attrs fileModificationDate] };
+	NSData* data = [NSKeyedArchiver archivedDataWithRootObject:header];
+	uint64_t length = CFSwapInt64HostToBig((uint64_t)[data length]);
+
+	NSMutableData* journal = [NSMutableData dataWithBytes:&length
+												   length:sizeof(length)];
+	[journal appendData:data];
+
+	if ([journal writeToURL:[self journalURLForDocumentURL:url]
+				 atomically:YES]) {
+		mJournalSaveMark = [DKDrawableObject currentChangeSequence];
+		mJournalRecordCount = 0;
+		mJournalNeedsFullSnapshot = NO;
+	}
+}
+
+/** @brief Replays any valid journal over the freshly loaded snapshot.
+
+ Each record replaces the in-place object bearing the same \c uniqueKey with its journalled
+ state. A journal that doesn't match the snapshot's file attributes is ignored. After a replay
+ the next save always writes a full snapshot, consolidating the journal.
+ */
+- (void)replayJournalForDocumentURL:(NSURL*)url
+{
+	NSData* journal = [NSData dataWithContentsOfURL:[self journalURLForDocumentURL:url]];
+
+	if (journal == nil)
+		return;
+
+	// every save through the journal means the snapshot on disk is stale - consolidate on the next save
+
+	mJournalNeedsFullSnapshot = YES;
+
+	NSUInteger loc = 0;
+	BOOL validated = NO;
+	NSUInteger applied = 0;
+
+	[[self undoManager] disableUndoRegistration];
+
+	@try {
+		while (loc + sizeof(uint64_t) <= [journal length]) {
+			uint64_t length;
+			[journal getBytes:&length
+						range:NSMakeRange(loc, sizeof(length))];
+			length = CFSwapInt64BigToHost(length);
+			loc += sizeof(length);
+
+			if (loc + length > [journal length])
+				break; // truncated tail record - ignore it and anything after
+
+			NSData* recordData = [journal subdataWithRange:NSMakeRange(loc, (NSUInteger)length)];
+			loc += length;
+
+			NSDictionary* record = [NSKeyedUnarchiver unarchiveObjectWithData:recordData];
+
+			if (!validated) {
+				// the first record is the header - it must match the snapshot we just read
+
+				NSDictionary* attrs = [[NSFileManager defaultManager] attributesOfItemAtPath:[url path]
+																					   error:NULL];
+
+				if (attrs == nil
+					|| [attrs fileSize] != [record[kDKJournalHeaderSnapshotSize] unsignedLongLongValue]
+					|| fabs([[attrs fileModificationDate] timeIntervalSinceDate:record[kDKJournalHeaderSnapshotDate]]) >= 1.0) {
+					LogEvent_(kFileEvent, @"journal does not match snapshot - ignoring it");
+					return;
+				}
+
+				validated = YES;
+				continue;
+			}
+
+			NSString* key = record[kDKJournalRecordObjectKey];
+			DKDrawableObject* replacement = record[kDKJournalRecordObjectValue];
+
+			if (key == nil || replacement == nil)
+				continue;
+
+			// later records for the same object simply replace the earlier state again
+
+			for (DKObjectOwnerLayer* layer in [[self drawing] flattenedLayersOfClass:[DKObjectOwnerLayer class]]) {
+				NSUInteger indx = [[layer objects] indexOfObjectPassingTest:^BOOL(DKDrawableObject* obj, NSUInteger i, BOOL* stop) {
+#pragma unused(i, stop)
+					return [[obj uniqueKey] isEqualToString:key];
+				}];
+
+				if (indx != NSNotFound) {
+					[layer removeObjectFromObjectsAtIndex:indx];
+					[layer insertObject:replacement
+						inObjectsAtIndex:indx];
+					++applied;
+					break;
+				}
+			}
+		}
+	}
+	@finally {
+		[[self undoManager] enableUndoRegistration];
+	}
+
+	if (applied > 0)
+		LogEvent_(kFileEvent, @"replayed %lu journal records", (unsigned long)applied);
+}
+
 #pragma mark -
 #pragma mark As an NSDocument
 
@@ -412,6 +678,22 @@ static NSMutableDictionary* sFileExportBindings = nil;
  @param outError an error, if it wasn't successful
  @return the data to be written to disk
  */
+/** @brief Permits autosaves of native drawings to be written without blocking editing.
+
+ Autosave then snapshots the document into data on a background thread while user interaction is
+ briefly blocked, and unblocks as soon as the immutable snapshot exists - the file is written out
+ while the user keeps editing, so autosave pauses shrink from the full write time to the archive
+ time. Explicit saves stay synchronous, preserving their semantics and the journalled fast path,
+ and only the native format is known to archive without touching any views.
+ */
+- (BOOL)canAsynchronouslyWriteToURL:(NSURL*)url ofType:(NSString*)typeName forSaveOperation:(NSSaveOperationType)saveOperation
+{
+#pragma unused(url)
+
+	return [self fileTypeIsNativeDrawing:typeName]
+		&& (saveOperation == NSAutosaveElsewhereOperation || saveOperation == NSAutosaveInPlaceOperation || saveOperation == NSAutosaveAsOperation);
+}
+
 - (NSData*)dataOfType:(NSString*)typeName error:(NSError**)outError
 {
 	NSData* theData = nil;
@@ -419,6 +701,12 @@ static NSMutableDictionary* sFileExportBindings = nil;
 	[[[self drawing] drawingInfo] setObject:[self displayName]
 									 forKey:kDKDrawingInfoTitle];
 
+	// record the current viewport so a chunked save can prioritise it on the next open. Skipped for
+	// an asynchronous (autosave) write, which runs off the main thread and must not touch views
+
+	if ([self mainView] != nil && [NSThread isMainThread])
+		[[self drawing] setLastViewedRect:[[self mainView] visibleRect]];
+
 	// if there is an export binding for the type, use it to create an invocation
 
 	if (sFileExportBindings != nil) {
@@ -443,9 +731,63 @@ static NSMutableDictionary* sFileExportBindings = nil;
 		return nil;
 	}
 
+	// for an asynchronous (autosave) write, the data now in hand is an immutable snapshot of the
+	// whole document, so editing can safely resume while the framework writes it out
+
+	if (![NSThread isMainThread])
+		[self unblockUserInteraction];
+
 	return theData;
 }
 
+/** @brief Saves the document, appending to the journal instead of rewriting when possible.
+
+ When journalled saving applies and the set of dirty objects is small, the snapshot file is left
+ untouched and only their change records are appended to the sidecar - save latency is then
+ proportional to the edit, not the document. In every other case a normal full save is performed
+ and the journal is restarted against the new snapshot.
+ */
+- (void)saveToURL:(NSURL*)url ofType:(NSString*)typeName forSaveOperation:(NSSaveOperationType)saveOperation completionHandler:(void (^)(NSError* _Nullable))completionHandler
+{
+	if ([self canJournalSaveOfType:typeName
+				  forSaveOperation:saveOperation]
+		&& [url isEqual:[self fileURL]]) {
+		NSArray* dirty = [self journalDirtyObjects];
+		NSError* error = nil;
+
+		if (dirty != nil && [self appendJournalRecordsForObjects:dirty
+														   error:&error]) {
+			mJournalSaveMark = [DKDrawableObject currentChangeSequence];
+
+			// compaction: once the journal is large enough, the next save rolls it up into a fresh snapshot
+
+			if (mJournalRecordCount >= kDKJournalCompactionRecordLimit)
+				mJournalNeedsFullSnapshot = YES;
+
+			[self updateChangeCount:NSChangeCleared];
+			completionHandler(nil);
+			return;
+		}
+
+		if (error != nil)
+			LogEvent_(kFileEvent, @"journal append failed (%@) - performing a full save", error);
+	}
+
+	BOOL resetJournal = mJournalledSavingEnabled
+		&& [self fileTypeIsNativeDrawing:typeName]
+		&& saveOperation != NSAutosaveElsewhereOperation;
+
+	[super saveToURL:url
+				  ofType:typeName
+		forSaveOperation:saveOperation
+	   completionHandler:^(NSError* _Nullable errorOrNil) {
+		   if (errorOrNil == nil && resetJournal)
+			   [self resetJournalForSnapshotAtURL:url];
+
+		   completionHandler(errorOrNil);
+	   }];
+}
+
 /** @brief Set up the document in its initial state for the "New" command.
 
  Creates a default drawing object
@@ -502,6 +844,42 @@ static NSMutableDictionary* sFileExportBindings = nil;
  @param outError the error if not successful
  @return YES if the file was opened, NO otherwise
  */
+/** @brief Reads the document from a file on disk.
+
+ For the chunked file type the data is read memory-mapped, so that the image chunks of a large file remain backed by
+ the file until their images are actually drawn. All other types fall through to the default implementation.
+ @param url the location of the file being read
+ @param typeName the type of data to load
+ @param outError the error if not successful
+ @return YES if the file was opened, NO otherwise
+ */
+- (BOOL)readFromURL:(NSURL*)url ofType:(NSString*)typeName error:(NSError**)outError
+{
+	if ([typeName isEqualToString:kDKDrawingDocumentChunkedType] || [typeName isEqualToString:kDKDrawingDocumentChunkedUTI]) {
+		NSData* data = [NSData dataWithContentsOfURL:url
+											 options:NSDataReadingMappedIfSafe
+											   error:outError];
+
+		if (data == nil)
+			return NO;
+
+		return [self readFromData:data
+						   ofType:typeName
+							error:outError];
+	}
+
+	BOOL result = [super readFromURL:url
+							  ofType:typeName
+							   error:outError];
+
+	// if a journal sidecar accompanies a native drawing, bring the loaded snapshot up to date
+
+	if (result && [self fileTypeIsNativeDrawing:typeName])
+		[self replayJournalForDocumentURL:url];
+
+	return result;
+}
+
 - (BOOL)readFromData:(NSData*)data ofType:(NSString*)typeName error:(NSError**)outError
 {
 	DKDrawing* theDrawing = nil;
@@ -532,6 +910,14 @@ static NSMutableDictionary* sFileExportBindings = nil;
 			[self remergeStyles:stylesToMerge
 					readFromURL:nil];
 
+		// with the registry reconciled, unify any remaining locked styles that are exact duplicates of
+		// ones already loaded by other open documents, collapsing duplicated rasterizer trees and caches
+
+		NSSet* internedStyles = [DKStyleRegistry internStylesInSet:[self allStyles]];
+
+		if (internedStyles != nil && [internedStyles count] > 0)
+			[self replaceDocumentStylesWithMatchingStylesFromSet:internedStyles];
+
 		[[self undoManager] enableUndoRegistration];
 		return YES;
 	} else {
@@ -579,6 +965,14 @@ static NSMutableDictionary* sFileExportBindings = nil;
 	if (mMainDrawingView != nil && [self drawing] != nil) {
 		DKViewController* mainViewController = [self makeControllerForView:[self mainView]];
 		[[self drawing] addController:mainViewController];
+
+		// restore the viewport recorded in a chunked save, so the user picks up where they left off
+		// and any layers still streaming in arrive behind visible content
+
+		NSRect viewport = [[self drawing] lastViewedRect];
+
+		if (!NSIsEmptyRect(viewport))
+			[[self mainView] scrollRectToVisible:viewport];
 	}
 
 #endif
@@ -613,11 +1007,30 @@ static NSMutableDictionary* sFileExportBindings = nil;
 							  toSelector:@selector(drawingAsXMLDataAtRoot)];
 		[[self class] bindFileExportType:kDKDrawingDocumentXMLUTI
 							  toSelector:@selector(drawingAsXMLDataAtRoot)];
+		[[self class] bindFileExportType:kDKDrawingDocumentChunkedType
+							  toSelector:@selector(chunkedDrawingData)];
+		[[self class] bindFileExportType:kDKDrawingDocumentChunkedUTI
+							  toSelector:@selector(chunkedDrawingData)];
 
 		[[self class] bindFileImportType:kDKDrawingDocumentType
 							  toSelector:@selector(drawingWithData:)];
 		[[self class] bindFileImportType:kDKDrawingDocumentUTI
 							  toSelector:@selector(drawingWithData:)];
+		[[self class] bindFileImportType:kDKDrawingDocumentChunkedType
+							  toSelector:@selector(drawingWithChunkedData:)];
+		[[self class] bindFileImportType:kDKDrawingDocumentChunkedUTI
+							  toSelector:@selector(drawingWithChunkedData:)];
+
+		// structural changes to the drawing can't be journalled as per-object deltas, so watch for them
+
+		NSNotificationCenter* nc = [NSNotificationCenter defaultCenter];
+
+		for (NSNotificationName name in @[kDKLayerDidAddObject, kDKLayerDidRemoveObject, kDKLayerGroupDidAddLayer, kDKLayerGroupDidRemoveLayer, kDKDrawingDidChangeSize]) {
+			[nc addObserver:self
+				   selector:@selector(journalStructureDidChange:)
+					   name:name
+					 object:nil];
+		}
 	}
 	return self;
 }
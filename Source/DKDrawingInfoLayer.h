@@ -10,6 +10,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class DKQuartzCache;
+
 //! placement of info panel:
 typedef NS_ENUM(NSInteger, DKInfoBoxPlacement) {
 	kDKDrawingInfoPlaceBottomRight = 0,
@@ -35,6 +37,8 @@ typedef NS_ENUM(NSInteger, DKInfoBoxPlacement) {
 	NSSize m_size; // the size of the panel
 	NSString* m_editingKeyRef; // which info key is being edited
 	BOOL m_drawBorder; // YES if a border is drawn around the drawing
+	DKQuartzCache* mPanelCache; // cached rendering of the panel, rebuilt only when its content changes
+	NSDictionary* mPanelCacheValues; // the displayed values and appearance state the cache was built from
 }
 
 /** @name General Settings:
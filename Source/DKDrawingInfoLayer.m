@@ -9,10 +9,17 @@
 #import "DKDrawing.h"
 #import "DKDrawingView.h"
 #import "DKGridLayer.h"
+#import "DKQuartzCache.h"
 
 #pragma mark Contants(Non - localized)
 NSString* const kDKDrawingInfoTextLabelAttributes = @"kDKDrawingInfoTextLabelAttributes";
 
+@interface DKDrawingInfoLayer ()
+
+- (NSDictionary*)displayedInfoValuesInView:(DKDrawingView*)aView;
+
+@end
+
 #pragma mark -
 @implementation DKDrawingInfoLayer
 #pragma mark As a DKDrawingInfoLayer
@@ -357,6 +364,37 @@ NSString* const kDKDrawingInfoTextLabelAttributes = @"kDKDrawingInfoTextLabelAtt
 	return [NSCursor IBeamCursor];
 }
 
+- (NSDictionary*)displayedInfoValuesInView:(DKDrawingView*)aView
+{
+	// collects everything the cached panel rendering depends on - the drawing info values actually
+	// displayed, plus the geometry, colours and view scale. Comparing this against the values the
+	// cache was built from is how the layer decides whether any re-layout is needed at all.
+
+	NSDictionary* di = [[self drawing] drawingInfo];
+	NSMutableDictionary* values = [NSMutableDictionary dictionary];
+
+	for (NSString* key in @[ kDKDrawingInfoDrawingNumber, kDKDrawingInfoDrawingRevision, kDKDrawingInfoDraughter, kDKDrawingInfoCreationDate ]) {
+		id value = [di objectForKey:key];
+
+		if (value)
+			[values setObject:value
+					   forKey:key];
+	}
+
+	[values setObject:NSStringFromRect([self infoBoxRect])
+			   forKey:@"rect"];
+
+	if ([self backgroundColour])
+		[values setObject:[self backgroundColour]
+				   forKey:@"background"];
+
+	if (aView)
+		[values setObject:@([aView scale])
+				   forKey:@"scale"];
+
+	return values;
+}
+
 - (void)drawRect:(NSRect)rect inView:(DKDrawingView*)aView
 {
 #pragma unused(rect)
@@ -364,19 +402,35 @@ NSString* const kDKDrawingInfoTextLabelAttributes = @"kDKDrawingInfoTextLabelAtt
 	NSRect diRect = [self infoBoxRect];
 
 	if (aView == nil || [aView needsToDrawRect:diRect]) {
-		// draw the info box
+		// the panel's text layout is costly relative to how rarely its content changes, yet this method
+		// runs on every pass over this part of the drawing. The box is therefore rendered to a cached
+		// CGLayer which is rebuilt only when a displayed value (or the geometry/zoom) actually differs.
 
-		[[self backgroundColour] set];
-		NSRectFillUsingOperation(diRect, NSCompositeSourceAtop);
+		NSDictionary* values = [self displayedInfoValuesInView:aView];
 
-		// draw the box border using the major grid colour:
+		if (mPanelCache == nil || ![values isEqualToDictionary:mPanelCacheValues]) {
+			mPanelCache = [DKQuartzCache cacheForCurrentContextInRect:diRect];
+			mPanelCacheValues = values;
 
-		[[DKGridLayer defaultMajorColour] set];
-		NSFrameRectWithWidth(diRect, 0.6);
+			[mPanelCache lockFocus];
+
+			// draw the info box background (source-over here - the cache layer starts fully transparent)
 
-		// divide up the box and label each one:
+			[[self backgroundColour] set];
+			NSRectFillUsingOperation(diRect, NSCompositeSourceOver);
+
+			// draw the box border using the major grid colour:
+
+			[[DKGridLayer defaultMajorColour] set];
+			NSFrameRectWithWidth(diRect, 0.6);
+
+			// divide up the box and label each one:
+
+			[self drawInfoInRect:diRect];
+			[mPanelCache unlockFocus];
+		}
 
-		[self drawInfoInRect:diRect];
+		[mPanelCache drawAtPoint:diRect.origin];
 	}
 
 	if ([self drawsBorder]) {
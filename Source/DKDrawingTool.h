@@ -115,6 +115,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)set;
 
+/** @brief Builds anything the tool can usefully build ahead of its first activation.
+
+ The tool registry sends this to newly registered tools once the current event has been processed, so
+ that one-off work such as cursor construction and swatch rendering is paid at registration time rather
+ than on the first switch to the tool. The default implementation touches the cursor; subclasses add
+ their own expensive one-off work. Prewarming is idempotent - a warm tool does nothing.
+ */
+- (void)prewarm;
+
 /** @brief Called when this tool is set by a tool controller.
 
  Subclasses can make use of this message to prepare themselves when they are set if necessary.
@@ -251,6 +251,16 @@ NSString* const kDKDrawingToolUserDefaultsKey = @"DK_DrawingTool_Defaults";
 	return [NSCursor arrowCursor];
 }
 
+/** @brief Build anything the tool can usefully build ahead of its first activation
+
+ The default implementation touches the cursor so that tools which cache a built cursor have it ready.
+ Subclasses override to add their own expensive one-off work, calling super.
+ */
+- (void)prewarm
+{
+	[self cursor];
+}
+
 /** @brief Handle the initial mouse down
 
  Override to do something useful
@@ -8,7 +8,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawableObject, DKLayer;
+@class DKDrawableObject, DKLayer, DKObjectPool;
 @protocol DKToolDelegate;
 
 NS_SWIFT_NAME(DKDrawingToolProtocol)
@@ -115,6 +115,16 @@ NS_SWIFT_NAME(DKDrawingToolProtocol)
 - (void)toolWillPerformUndoableAction:(id<DKDrawingTool>)aTool;
 - (void)toolDidPerformUndoableAction:(id<DKDrawingTool>)aTool;
 
+/** @brief Returns a recycling pool the delegate maintains for transient objects of the given class.
+
+ Tools can acquire short-lived scratch objects (paths, arrays and so on) from the pool instead of
+ allocating them per event. The delegate begins a new pool generation at each event boundary, so
+ anything acquired while handling one event (and any drawing it triggers) is recycled for the next -
+ acquired objects must not be kept beyond the event in which they were acquired.
+ @param aClass the class of object required
+ @return a pool vending that class, or nil if the delegate does not maintain pools */
+- (nullable DKObjectPool*)recyclingPoolForClass:(Class)aClass;
+
 @end
 
 NS_ASSUME_NONNULL_END
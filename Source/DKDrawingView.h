@@ -18,6 +18,18 @@ typedef NS_ENUM(NSInteger, DKCropMarkKind) {
 	DKCropMarksEdges = 2
 };
 
+/** @brief Immutable per-pass render state, captured once when a view begins drawing.
+
+ Zoom-adaptive code deep in the render loops (knob sizing, flattening tolerances, level-of-detail
+ decisions) needs the current view scale and visible rect per object per frame. Rather than crossing
+ back into view geometry for every query, the state is captured once when the view is pushed as the
+ current drawing view and read back from <code>+[DKDrawingView currentRenderState]</code>.
+ */
+typedef struct DKRenderState {
+	CGFloat scale; //!< view zoom scale in effect for the pass, 1.0 = 100%
+	NSRect visibleRect; //!< visible portion of the drawing, in drawing coordinates
+} DKRenderState;
+
 /** @brief DKDrawingView is the visible "front end" for the DKDrawing architecture.
 
  A drawing can have multiple views into the same drawing data model, each with independent scales, scroll positions and so forth, but
@@ -46,7 +58,12 @@ typedef NS_ENUM(NSInteger, DKCropMarkKind) {
 	BOOL m_didCreateDrawing; /**< YES if the window built the back end itself */
 	NSRect mEditorFrame; /**< tracks current frame of text editor */
 	NSTimeInterval mLastMouseDragTime; /**< time of last mouseDragged: event */
+	NSEvent* mPendingDragEvent; /**< drag event held back for frame pacing, delivered at the next frame boundary */
 	NSDictionary* mRulerMarkersDict; /**< tracks ruler markers */
+	NSView* mToolOverlayView; /**< transparent layer-backed plane above the content for transient tool feedback */
+	NSMutableArray* mCacheWarmQueue; /**< objects just outside the visible rect queued for idle cache warming */
+	NSRect mLastWarmVisibleRect; /**< visible rect at the previous draw, for scroll velocity estimation */
+	NSTimeInterval mLastWarmFrameTime; /**< timestamp of the previous draw */
 }
 
 /** @brief Return the view currently drawing
@@ -58,6 +75,35 @@ typedef NS_ENUM(NSInteger, DKCropMarkKind) {
 + (nullable DKDrawingView*)currentlyDrawingView;
 + (void)pop;
 
+/** @brief Return the render state for the current drawing pass.
+
+ Within a \c drawRect: pass this returns the scale and visible rect captured when the view was made
+ current - two static reads, no view-geometry queries. Outside of a pass it falls back to querying
+ the currently drawing view directly, or returns scale 1.0 and a zero visible rect (meaning
+ "unknown - treat everything as visible") when there is none.
+ @return the current render state
+ */
++ (DKRenderState)currentRenderState;
+
+/** @brief Return the view scale for the current drawing pass.
+
+ Shorthand for <code>[DKDrawingView currentRenderState].scale</code>; 1.0 when no view is current.
+ @return the current render scale
+ */
++ (CGFloat)currentRenderScale;
+
+/** @brief Scale a path flattening tolerance to suit the view currently drawing.
+
+ Flatness is expressed in drawing units, so the on-screen error it permits grows with the view's zoom
+ scale. This converts a tolerance chosen for 100% zoom into one giving the same device-pixel error at
+ the current zoom - coarser (fewer segments) when zoomed out, finer (no visible facets) when zoomed in.
+ Outside of a \c drawRect: call, when no view is current (printing, caching to an image), the tolerance
+ is returned unchanged.
+ @param flatness the flattening tolerance appropriate at 100% zoom
+ @return the tolerance adjusted for the current view's scale
+ */
++ (CGFloat)flatnessForViewScale:(CGFloat)flatness;
+
 /** @brief Set the colour used to draw the page breaks
  */
 @property (class, retain, null_resettable) NSColor* pageBreakColour;
@@ -76,7 +122,62 @@ typedef NS_ENUM(NSInteger, DKCropMarkKind) {
  */
 + (nullable NSImage*)imageResourceNamed:(NSImageName)name;
 
-/** @name Temporary Text Editor
+/** @brief The refresh period of the main display
+
+ Drag processing and autoscrolling are paced to this, so work is done at most once per frame.
+ Displays that do not report a refresh rate are assumed to run at 60Hz.
+ */
+@property (class, readonly) NSTimeInterval displayRefreshPeriod;
+
+/** @name Tool Feedback Overlay
+ @brief A transparent plane above the content for transient tool feedback.
+ @discussion Tools can draw rubber-bands, drag images and similar transient feedback here instead
+ of invalidating the document layers. The overlay has its own backing store, so updating it does
+ not re-render the content beneath. It is created on first use - until then tool drawing follows
+ the classic route through the content view's update mechanism.
+ @{ */
+
+/** @brief Return the overlay view, creating it if needed
+
+ The overlay covers the view's bounds, shares its coordinate system and flippedness, and passes
+ all events through. Its drawing is forwarded to the view's controller via \c drawOverlayRect:inView:
+ @return the overlay view
+ */
+- (NSView*)toolOverlayView;
+
+/** @brief Whether the overlay has been created
+
+ Controllers use this to decide whether tool feedback is drawn in the overlay or as part of the
+ normal content drawing pass.
+ */
+@property (readonly) BOOL hasToolOverlay;
+
+/** @brief Mark part of the overlay for update
+
+ Creates the overlay on first use. This is the invalidation tools should use for transient
+ feedback in place of the layer's \c setNeedsDisplayInRect:
+ @param rect the area to mark for update
+ */
+- (void)setToolOverlayNeedsDisplayInRect:(NSRect)rect;
+
+/** @}
+ @name Idle Cache Warming
+ @brief Pre-bakes render caches for content just outside the visible rect while the event loop is quiet.
+ @discussion Panning to a new region normally pays all first-draw costs at once - shadow bitmaps,
+ Core Image output, text layout. After each screen update the view schedules a deferred pass that
+ renders the objects within half a screenful of the visible rect into a scratch canvas, filling
+ the same caches a real draw would. The pass runs only in the default run loop mode, so tracking
+ input pre-empts it automatically, and each pass is time-budgeted to stay well under a frame.
+ @{ */
+
+/** @brief Schedule an idle warming pass, replacing any pass already pending. Called after each screen draw. */
+- (void)scheduleIdleCacheWarming;
+
+/** @brief Warm a budgeted batch of off-screen objects, rescheduling itself while any remain. */
+- (void)warmOffscreenCaches;
+
+/** @}
+ @name Temporary Text Editor
  @brief Setting the class to use for the temporary text editor
  @{ */
 
@@ -5,8 +5,12 @@
 */
 
 #import "DKDrawingView.h"
+#import "DKDrawableObject.h"
 #import "DKDrawing.h"
 #import "DKGridLayer.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKEventRingLog.h"
+#import "DKPerformanceCounters.h"
 #import "DKToolController.h"
 #import "GCThreadQueue.h"
 #import "LogEvent.h"
@@ -43,6 +47,8 @@ NSString* const kDKDrawingViewVerticalBottomMarkerName = @"marker_v_bottom";
 #pragma mark Static Vars
 
 static NSMutableArray* sDrawingViewStack = nil; // stack of view refs
+static CGFloat sRenderScale = 0.0; // scale of the view currently drawing, captured once per pass; 0 = no pass
+static NSRect sRenderVisibleRect; // visible rect of the view currently drawing, in drawing coordinates
 static NSColor* sPageBreakColour = nil;
 static NSPoint sLastContextMenuClick = { 0, 0 };
 
@@ -80,6 +86,71 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
 - (NSDictionary*)rulerMarkerInfo;
 
 @property (copy) NSDictionary* rulerMarkerInfo;
+
+/** @brief Forward a drag event downstream and record its time.
+
+ Private - the processing core shared by \c mouseDragged: and the deferred flush of a held event.
+ @param event the drag event
+ */
+- (void)processMouseDrag:(NSEvent*)event;
+
+/** @brief Deliver a drag event that was held back for frame pacing.
+
+ Private - scheduled by \c mouseDragged: for the next frame boundary so the newest pointer
+ position is never simply dropped.
+ */
+- (void)flushPendingMouseDrag;
+
+@end
+
+#pragma mark -
+
+/** @brief Transparent plane above the drawing content where tools draw transient feedback.
+
+ The overlay is layer-backed so it has its own backing store - invalidating it never causes the
+ document content beneath to re-render. It shares the host view's coordinate system and is purely
+ visual; all events fall through to the drawing view. Drawing is forwarded to the view's
+ controller via \c drawOverlayRect:inView: if the controller implements it.
+ */
+@interface DKToolOverlayView : NSView
+@end
+
+@implementation DKToolOverlayView
+
+- (BOOL)isFlipped
+{
+	return [[self superview] isFlipped];
+}
+
+- (BOOL)isOpaque
+{
+	return NO;
+}
+
+- (NSView*)hitTest:(NSPoint)aPoint
+{
+#pragma unused(aPoint)
+
+	// the overlay is purely visual - events fall through to the drawing view beneath
+
+	return nil;
+}
+
+- (CGFloat)scale
+{
+	return [(DKDrawingView*)[self superview] scale];
+}
+
+- (void)drawRect:(NSRect)rect
+{
+	id controller = [(DKDrawingView*)[self superview] controller];
+
+	if ([controller respondsToSelector:@selector(drawOverlayRect:
+												 inView:)])
+		[controller drawOverlayRect:rect
+							 inView:self];
+}
+
 @end
 
 #pragma mark -
@@ -105,6 +176,12 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
 	//NSLog(@"pushing %@; setting %@", [self currentlyDrawingView], aView);
 
 	[sDrawingViewStack addObject:aView];
+
+	// capture the render state once per pass - zoom-adaptive code deep in the render loops reads
+	// it back from +currentRenderState instead of re-querying the view geometry per object
+
+	sRenderScale = [aView scale];
+	sRenderVisibleRect = [aView visibleRect];
 }
 
 + (void)pop
@@ -114,9 +191,54 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
 	if (stackSize > 0)
 		[sDrawingViewStack removeObjectAtIndex:stackSize - 1];
 
+	// restore the render state of the view whose pass is resuming, if any
+
+	DKDrawingView* cv = [sDrawingViewStack lastObject];
+
+	if (cv != nil) {
+		sRenderScale = [cv scale];
+		sRenderVisibleRect = [cv visibleRect];
+	} else
+		sRenderScale = 0.0;
+
 	//NSLog(@"popping %@", [self currentlyDrawingView]);
 }
 
++ (DKRenderState)currentRenderState
+{
+	DKRenderState state;
+
+	if (sRenderScale > 0.0) {
+		state.scale = sRenderScale;
+		state.visibleRect = sRenderVisibleRect;
+	} else {
+		// outside of a drawing pass - fall back to querying the view directly
+
+		DKDrawingView* cv = [self currentlyDrawingView];
+
+		state.scale = (cv != nil && [cv scale] > 0.0) ? [cv scale] : 1.0;
+		state.visibleRect = (cv != nil) ? [cv visibleRect] : NSZeroRect;
+	}
+
+	return state;
+}
+
++ (CGFloat)currentRenderScale
+{
+	if (sRenderScale > 0.0)
+		return sRenderScale;
+
+	DKDrawingView* cv = [self currentlyDrawingView];
+	CGFloat scale = [cv scale];
+
+	return (scale > 0.0) ? scale : 1.0;
+}
+
++ (CGFloat)flatnessForViewScale:(CGFloat)flatness
+{
+	return flatness / [self currentRenderScale];
+}
+
 /** @brief Set the colour used to draw the page breaks
  @param colour the colour to draw page breaks with
  */
@@ -166,6 +288,24 @@ NSString* const kDKTextEditorUndoesTypingPrefsKey = @"kDKTextEditorUndoesTyping"
 	return image;
 }
 
++ (NSTimeInterval)displayRefreshPeriod
+{
+	CGDisplayModeRef mode = CGDisplayCopyDisplayMode(CGMainDisplayID());
+	double rate = 0.0;
+
+	if (mode != NULL) {
+		rate = CGDisplayModeGetRefreshRate(mode);
+		CGDisplayModeRelease(mode);
+	}
+
+	// built-in flat panels report a rate of zero - assume the common 60Hz
+
+	if (rate <= 0.0)
+		rate = 60.0;
+
+	return 1.0 / rate;
+}
+
 #pragma mark -
 #pragma mark - setting the class for the temporary text editor
 
@@ -894,6 +1034,14 @@ static Class s_textEditorClass = Nil;
  */
 - (void)drawRect:(NSRect)rect
 {
+	// during a rapid zoom change, a scaled blit of the snapshot captured at the gesture's start
+	// stands in for the content - see GCZoomView
+
+	if ([self drawZoomPreviewInRect:rect])
+		return;
+
+	uint64_t frameStart = DKPerfTimeNow();
+
 	// draw the entire content of the drawing:
 
 	[self set];
@@ -918,6 +1066,170 @@ static Class s_textEditorClass = Nil;
 		[self drawCropMarks];
 
 	[[self class] pop];
+
+	uint64_t frameNanos = DKPerfTimeSince(frameStart);
+
+	if (frameNanos > 0) {
+		DKPerfCounterAdd(&gDKPerfCounters.frameCount, 1);
+		DKPerfCounterAdd(&gDKPerfCounters.frameNanos, frameNanos);
+		DKPerfCounterSet(&gDKPerfCounters.lastFrameNanos, frameNanos);
+	}
+
+	DKEventLog_(kDKEventLogCategoryRender, kDKEventLogCodeViewFrameDrawn, frameNanos, (uintptr_t)self);
+
+	// when the event loop next goes quiet, pre-warm render caches for the content just outside
+	// the visible rect, so panning to it does not pay first-draw costs
+
+	if (!printing)
+		[self scheduleIdleCacheWarming];
+}
+
+#pragma mark -
+#pragma mark - idle cache warming
+
+static const CGFloat kDKPrefetchMinimumScrollSpeed = 400.0; // points per second, below which normal idle warming applies
+static const NSTimeInterval kDKPrefetchLookaheadInterval = 1.0 / 30.0; // how far ahead of the scroll the viewport is predicted
+
+- (void)scheduleIdleCacheWarming
+{
+	[NSObject cancelPreviousPerformRequestsWithTarget:self
+											 selector:@selector(warmOffscreenCaches)
+											   object:nil];
+	mCacheWarmQueue = nil;
+
+	// estimate scroll velocity from successive visible rects. During a live scroll the view redraws
+	// every frame, so the origin deltas between draws sample the scroll motion directly.
+
+	NSRect vr = [self visibleRect];
+	NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+	NSTimeInterval dt = now - mLastWarmFrameTime;
+	NSPoint velocity = NSZeroPoint;
+
+	if (dt > 0.0 && dt < 0.25 && !NSIsEmptyRect(mLastWarmVisibleRect) && NSEqualSizes(vr.size, mLastWarmVisibleRect.size)) {
+		velocity.x = (NSMinX(vr) - NSMinX(mLastWarmVisibleRect)) / dt;
+		velocity.y = (NSMinY(vr) - NSMinY(mLastWarmVisibleRect)) / dt;
+	}
+
+	mLastWarmVisibleRect = vr;
+	mLastWarmFrameTime = now;
+
+	if (hypot(velocity.x, velocity.y) > kDKPrefetchMinimumScrollSpeed) {
+		// scrolling fast: predict where the viewport is headed and queue the content about to
+		// enter it now, ahead of the idle delay. On fast flicks the frame spikes come from cold
+		// content crossing into view, so the warm pass has to land before the scroll does.
+
+		NSRect predicted = NSOffsetRect(vr, velocity.x * kDKPrefetchLookaheadInterval, velocity.y * kDKPrefetchLookaheadInterval);
+		NSMutableArray* queue = [self cacheWarmCandidatesInRect:NSUnionRect(vr, predicted)];
+
+		if ([queue count] > 0) {
+			mCacheWarmQueue = queue;
+			[self performSelector:@selector(warmOffscreenCaches)
+					   withObject:nil
+					   afterDelay:0.0
+						  inModes:@[NSDefaultRunLoopMode]];
+			return;
+		}
+	}
+
+	// default mode only - tracking and modal loops pre-empt the pass automatically
+
+	[self performSelector:@selector(warmOffscreenCaches)
+			   withObject:nil
+			   afterDelay:0.25
+				  inModes:@[NSDefaultRunLoopMode]];
+}
+
+/** @brief Gathers visible objects within \c band whose caches are worth warming.
+
+ Objects already intersecting the visible rect are skipped - their caches are warm from normal
+ display. The spatial storage makes the band query cheap.
+ @param band the rect, in drawing coordinates, to gather candidates from
+ @return the candidate objects, which may be empty
+ */
+- (NSMutableArray*)cacheWarmCandidatesInRect:(NSRect)band
+{
+	NSRect vr = [self visibleRect];
+	NSMutableArray* queue = [NSMutableArray array];
+
+	for (DKLayer* layer in [[self drawing] flattenedLayers]) {
+		if ([layer isKindOfClass:[DKObjectOwnerLayer class]] && [layer visible]) {
+			for (DKDrawableObject* od in [(DKObjectOwnerLayer*)layer objectsInRect:band]) {
+				if ([od visible] && ![od intersectsRect:vr])
+					[queue addObject:od];
+			}
+		}
+	}
+
+	return queue;
+}
+
+- (void)warmOffscreenCaches
+{
+	if ([self window] == nil || [self drawing] == nil)
+		return;
+
+	if (mCacheWarmQueue == nil) {
+		// gather visible objects within half a screenful beyond the visible rect; objects
+		// already on screen have warm caches.
+
+		NSRect vr = [self visibleRect];
+
+		if (NSIsEmptyRect(vr))
+			return;
+
+		NSMutableArray* queue = [self cacheWarmCandidatesInRect:NSInsetRect(vr, -NSWidth(vr) * 0.5, -NSHeight(vr) * 0.5)];
+
+		if ([queue count] == 0)
+			return;
+
+		mCacheWarmQueue = queue;
+	}
+
+	// render a few objects into a tiny scratch canvas. The destination pixels are discarded, but
+	// the render caches (shadow bitmaps, Core Image output, text layout) fill exactly as they
+	// would on first display. Budgeted so a pass stays well under one frame; leftovers continue
+	// at the next quiet moment.
+
+	const NSTimeInterval budget = 0.006;
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+	CGFloat scale = [self scale];
+	NSImage* scratch = [[NSImage alloc] initWithSize:NSMakeSize(8.0, 8.0)];
+
+	[self set];
+
+	while ([mCacheWarmQueue count] > 0 && ([NSDate timeIntervalSinceReferenceDate] - start) < budget) {
+		DKDrawableObject* od = [mCacheWarmQueue lastObject];
+		[mCacheWarmQueue removeLastObject];
+
+		[scratch lockFocusFlipped:[self isFlipped]];
+
+		CGContextRef cc = [[NSGraphicsContext currentContext] graphicsPort];
+		NSRect br = [od bounds];
+
+		// match the view's scale so scale-keyed caches are warmed for the zoom they will be used at
+
+		CGContextScaleCTM(cc, scale, scale);
+		CGContextTranslateCTM(cc, -NSMinX(br), -NSMinY(br));
+
+		@try {
+			[od drawContentWithSelectedState:NO];
+		}
+		@catch (NSException* e) {
+			LogEvent_(kWheneverEvent, @"exception during idle cache warming: %@", e);
+		}
+
+		[scratch unlockFocus];
+	}
+
+	[[self class] pop];
+
+	if ([mCacheWarmQueue count] > 0)
+		[self performSelector:@selector(warmOffscreenCaches)
+				   withObject:nil
+				   afterDelay:0.05
+					  inModes:@[NSDefaultRunLoopMode]];
+	else
+		mCacheWarmQueue = nil;
 }
 
 /** @brief Is the view flipped.
@@ -1089,18 +1401,93 @@ static Class s_textEditorClass = Nil;
  */
 - (void)mouseDragged:(NSEvent*)event
 {
-	// do not process drags at more than 40 fps...
+	// coalesce any further drags already waiting in the event queue, keeping only the newest
+	// position - there is no point doing the expensive snap/hit/invalidate work downstream for
+	// positions the display will never show
+
+	NSEvent* next;
+
+	while ((next = [[self window] nextEventMatchingMask:NSLeftMouseDraggedMask
+											  untilDate:[NSDate distantPast]
+												 inMode:NSEventTrackingRunLoopMode
+												dequeue:YES]) != nil)
+		event = next;
+
+	// pace processing to the display's refresh - at most one drag is processed per frame. An event
+	// arriving mid-frame is held and flushed at the frame boundary rather than dropped, so the
+	// pointer's final position always gets processed.
 
 	NSTimeInterval t = [event timestamp];
+	NSTimeInterval period = [[self class] displayRefreshPeriod];
+
+	if (t >= mLastMouseDragTime + period) {
+		mPendingDragEvent = nil;
+		[NSObject cancelPreviousPerformRequestsWithTarget:self
+												 selector:@selector(flushPendingMouseDrag)
+												   object:nil];
+		[self processMouseDrag:event];
+	} else {
+		BOOL alreadyScheduled = (mPendingDragEvent != nil);
+
+		mPendingDragEvent = event;
+
+		if (!alreadyScheduled)
+			[self performSelector:@selector(flushPendingMouseDrag)
+					   withObject:nil
+					   afterDelay:MAX(mLastMouseDragTime + period - t, 0.0)
+						  inModes:@[NSEventTrackingRunLoopMode, NSDefaultRunLoopMode]];
+	}
+}
+
+- (void)processMouseDrag:(NSEvent*)event
+{
+	mLastMouseDragTime = [event timestamp];
+
+	[self updateRulerMouseTracking:[event locationInWindow]];
+	[self postMouseLocationInfo:kDKDrawingMouseDraggedLocation
+						  event:event];
+	[[self controller] mouseDragged:event];
+}
+
+- (void)flushPendingMouseDrag
+{
+	NSEvent* event = mPendingDragEvent;
+	mPendingDragEvent = nil;
+
+	if (event != nil)
+		[self processMouseDrag:event];
+}
+
+#pragma mark -
+#pragma mark - tool feedback overlay
+
+- (NSView*)toolOverlayView
+{
+	if (mToolOverlayView == nil) {
+		mToolOverlayView = [[DKToolOverlayView alloc] initWithFrame:[self bounds]];
 
-	if (t > mLastMouseDragTime + 0.025) {
-		mLastMouseDragTime = t;
+		// the overlay gets its own backing store, so invalidating feedback drawn there never
+		// re-renders the document content below it
 
-		[self updateRulerMouseTracking:[event locationInWindow]];
-		[self postMouseLocationInfo:kDKDrawingMouseDraggedLocation
-							  event:event];
-		[[self controller] mouseDragged:event];
+		[mToolOverlayView setWantsLayer:YES];
+		[mToolOverlayView setAutoresizingMask:NSViewWidthSizable | NSViewHeightSizable];
+		[self addSubview:mToolOverlayView];
 	}
+
+	if (!NSEqualRects([mToolOverlayView frame], [self bounds]))
+		[mToolOverlayView setFrame:[self bounds]];
+
+	return mToolOverlayView;
+}
+
+- (BOOL)hasToolOverlay
+{
+	return mToolOverlayView != nil;
+}
+
+- (void)setToolOverlayNeedsDisplayInRect:(NSRect)rect
+{
+	[[self toolOverlayView] setNeedsDisplayInRect:rect];
 }
 
 /** @brief Handle the mouse moved event
@@ -1125,6 +1512,13 @@ static Class s_textEditorClass = Nil;
  */
 - (void)mouseUp:(NSEvent*)event
 {
+	// any drag still held for frame pacing is superseded by the up event's final position
+
+	mPendingDragEvent = nil;
+	[NSObject cancelPreviousPerformRequestsWithTarget:self
+											 selector:@selector(flushPendingMouseDrag)
+											   object:nil];
+
 	[self postMouseLocationInfo:kDKDrawingMouseUpLocation
 						  event:event];
 	[[self controller] mouseUp:event];
@@ -1206,6 +1600,7 @@ static Class s_textEditorClass = Nil;
 	}
 
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
 
 	// if the view automatically created its own "back-end", release all of that now - the drawing owns the controllers so
 	// they are also disposed of.
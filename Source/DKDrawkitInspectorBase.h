@@ -8,15 +8,24 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawing, DKLayer, DKDrawableObject, DKDrawingDocument, DKViewController;
+@class DKDrawing, DKLayer, DKDrawableObject, DKDrawingDocument, DKViewController, DKSelectionSummary;
 
 /** @brief This is a base class for any inspector for looking at DrawKit.
 
 This is a base class for any inspector for looking at DrawKit. All it does is respond to the various selection changed
 notifications at the document, layer and object levels, and call a method which you can override to set up the displayed
 content.
+
+Selection-change notifications are coalesced: however many arrive within one display frame (marquee
+dragging over a dense layer can produce hundreds per second), the content is refreshed at most once
+per frame. Inspectors that only need the headline facts about the selection can override
+-redisplayContentForSelectionSummary: and read the precomputed summary instead of scanning the
+selection array.
 */
-@interface DKDrawkitInspectorBase : NSWindowController
+@interface DKDrawkitInspectorBase : NSWindowController {
+@private
+	BOOL mSelectionRefreshPending; // YES when a coalesced selection refresh has been scheduled but not yet performed
+}
 
 - (void)documentDidChange:(NSNotification*)note;
 - (void)layerDidChange:(NSNotification*)note;
@@ -24,9 +33,11 @@ content.
 - (void)subSelectionDidChange:(NSNotification*)note;
 
 - (void)redisplayContentForSelection:(nullable NSArray<DKDrawableObject*>*)selection;
+- (void)redisplayContentForSelectionSummary:(nullable DKSelectionSummary*)summary;
 - (void)redisplayContentForSubSelection:(NSSet<DKDrawableObject*>*)subsel ofObject:(DKDrawableObject*)object;
 
 - (nullable id)selectedObjectForCurrentTarget;
+- (nullable DKSelectionSummary*)selectionSummaryForCurrentTarget;
 - (nullable id)selectedObjectForTargetWindow:(NSWindow*)window;
 - (nullable DKDrawing*)drawingForTargetWindow:(NSWindow*)window;
 
@@ -39,21 +39,43 @@
 	if ([[note object] respondsToSelector:@selector(selection)]) {
 		LogEvent_(kReactiveEvent, @"selection did change (%@), selected = %@", [note name], [[note object] selection]);
 
-		[[NSNotificationCenter defaultCenter] removeObserver:self
-														name:kDKDrawableSubselectionChangedNotification
-													  object:nil];
-
-		NSArray* sel = [self selectedObjectForCurrentTarget];
-		[self redisplayContentForSelection:sel];
-
-		for (id obj in sel)
-			[[NSNotificationCenter defaultCenter] addObserver:self
-													 selector:@selector(subSelectionDidChange:)
-														 name:kDKDrawableSubselectionChangedNotification
-													   object:obj];
+		// selection notifications are posted per mutation, so marquee-selecting across a dense layer fires
+		// hundreds per second. Coalesce them: the first one schedules a refresh a display frame ahead and the
+		// rest are absorbed by the pending flag. Common run loop modes so that the refresh fires during the
+		// mouse-tracking loop that is driving the changes.
+
+		if (!mSelectionRefreshPending) {
+			mSelectionRefreshPending = YES;
+			[self performSelector:@selector(performCoalescedSelectionRefresh)
+					   withObject:nil
+					   afterDelay:[DKDrawingView displayRefreshPeriod]
+						  inModes:@[NSRunLoopCommonModes]];
+		}
 	}
 }
 
+/** @brief Perform the single deferred refresh standing in for all selection changes this frame
+ */
+- (void)performCoalescedSelectionRefresh
+{
+	mSelectionRefreshPending = NO;
+
+	[[NSNotificationCenter defaultCenter] removeObserver:self
+													name:kDKDrawableSubselectionChangedNotification
+												  object:nil];
+
+	NSArray* sel = [self selectedObjectForCurrentTarget];
+
+	[self redisplayContentForSelectionSummary:[self selectionSummaryForCurrentTarget]];
+	[self redisplayContentForSelection:sel];
+
+	for (id obj in sel)
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(subSelectionDidChange:)
+													 name:kDKDrawableSubselectionChangedNotification
+												   object:obj];
+}
+
 - (void)subSelectionDidChange:(NSNotification*)note
 {
 
@@ -72,6 +94,14 @@
 	// override to do something useful
 }
 
+- (void)redisplayContentForSelectionSummary:(DKSelectionSummary*)summary
+{
+#pragma unused(summary)
+
+	// override to do something useful. The summary is maintained by the layer from the selection delta,
+	// so reading it here is cheap even for very large selections.
+}
+
 - (void)redisplayContentForSubSelection:(NSSet*)subsel ofObject:(DKDrawableObject*)object
 {
 #pragma unused(subsel, object)
@@ -101,6 +131,13 @@
 	return nil;
 }
 
+- (DKSelectionSummary*)selectionSummaryForCurrentTarget
+{
+	DKLayer* layer = [[self currentDrawing] activeLayerOfClass:[DKObjectDrawingLayer class]];
+
+	return [(DKObjectDrawingLayer*)layer selectionSummary];
+}
+
 - (DKDrawing*)drawingForTargetWindow:(NSWindow*)window
 {
 	NSDocument* cd = [[NSDocumentController sharedDocumentController] documentForWindow:window];
@@ -181,6 +218,7 @@
 
 - (void)dealloc
 {
+	[NSObject cancelPreviousPerformRequestsWithTarget:self];
 	[[NSNotificationCenter defaultCenter] removeObserver:self];
 }
 
@@ -0,0 +1,100 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief categories for the binary event log, combinable as a compile-time mask.
+ */
+typedef NS_OPTIONS(uint32_t, DKEventLogCategory) {
+	kDKEventLogCategoryRender = (1 << 0), //!< view and layer drawing
+	kDKEventLogCategoryCache = (1 << 1), //!< cache builds, hits and invalidations
+	kDKEventLogCategorySpatial = (1 << 2), //!< spatial index queries and rebuilds
+	kDKEventLogCategoryStorage = (1 << 3), //!< object storage mutations
+	kDKEventLogCategoryTool = (1 << 4), //!< tool and mouse handling
+	kDKEventLogCategoryUndo = (1 << 5) //!< undo task recording
+};
+
+/** @brief One fixed-size entry in the event log. 32 bytes, written verbatim to disk when draining.
+ */
+typedef struct DKEventLogRecord {
+	uint64_t timestamp; //!< host uptime in nanoseconds when the event was posted
+	uint32_t category; //!< one of the DKEventLogCategory bits
+	uint32_t code; //!< caller-defined event identifier, unique within its category
+	uint64_t value1; //!< caller-defined payload
+	uint64_t value2; //!< caller-defined payload
+} DKEventLogRecord;
+
+/** @brief event codes used by the framework's own logging sites, kept here as the registry for offline tooling.
+ */
+typedef NS_ENUM(uint32_t, DKEventLogCode) {
+	kDKEventLogCodeViewFrameDrawn = 1, //!< render: value1 = frame nanoseconds (0 when timing is off), value2 = view address
+	kDKEventLogCodeSpatialQuery = 2 //!< spatial: value1 = query nanoseconds (0 when timing is off), value2 = objects returned
+};
+
+/**    Which categories are compiled into the framework. A client build can predefine this (typically
+ in a prefix header) to a narrower mask, or to 0 to compile event logging out entirely. Calls for a
+ category outside the mask disappear at compile time, including evaluation of their arguments.
+*/
+#ifndef DK_EVENTLOG_CATEGORIES
+#define DK_EVENTLOG_CATEGORIES (kDKEventLogCategoryRender | kDKEventLogCategoryCache | kDKEventLogCategorySpatial | kDKEventLogCategoryStorage | kDKEventLogCategoryTool | kDKEventLogCategoryUndo)
+#endif
+
+/**    Post an event to the ring buffer. Unlike LogEvent_, no strings are built - the two payload
+ values are stored raw and interpreted offline - so this is cheap enough to leave in render loops.
+ When the category is excluded by DK_EVENTLOG_CATEGORIES the condition is a compile-time constant
+ and the whole statement, argument expressions included, is dead code. When compiled in but logging
+ is not enabled at runtime, the cost is a single relaxed atomic load and branch.
+*/
+#define DKEventLog_(cat, evtCode, v1, v2)                                          \
+	do {                                                                           \
+		if ((((uint32_t)(cat)) & (uint32_t)DK_EVENTLOG_CATEGORIES) != 0)           \
+			DKEventLogPost((cat), (evtCode), (uint64_t)(v1), (uint64_t)(v2));      \
+	} while (0)
+
+/** @brief Records the event if logging is enabled. Call through DKEventLog_, not directly. */
+void DKEventLogPost(DKEventLogCategory category, uint32_t code, uint64_t value1, uint64_t value2);
+
+/** @brief Fixed-size binary event log safe to leave enabled in shipping render paths.
+
+ Events are 32-byte records posted lock-free into a ring buffer from any thread; the newest entries
+ always survive, the oldest are overwritten once the ring wraps. A background queue can drain the
+ ring to a flat binary file for offline analysis. Because nothing is formatted at the call site,
+ posting costs a timestamp and a handful of relaxed atomic stores - unlike LogEvent(), which builds
+ an NSString per call and evaluates its arguments even when the log category is switched off.
+
+ Logging is off by default. Enabling logging only fills the ring (useful as a flight recorder read
+ after the fact); draining additionally streams records to disk as they arrive.
+*/
+@interface DKEventRingLog : NSObject
+
+/** @brief Whether posted events are recorded into the ring. Off by default. */
+@property (class) BOOL loggingEnabled;
+
+/** @brief Starts appending drained records to the given file, or to \c defaultLogFileURL if nil.
+
+ Also enables logging. Records are flushed roughly twice a second from a background queue; events
+ posted faster than the ring capacity between flushes are dropped oldest-first.
+ */
++ (BOOL)beginDrainingToFileURL:(nullable NSURL*)url;
+
+/** @brief Stops the background drain after a final flush. Logging remains enabled. */
++ (void)endDraining;
+
+/** @brief Where \c beginDrainingToFileURL:nil writes: DKEventLog.bin in the user's caches directory. */
++ (NSURL*)defaultLogFileURL;
+
+/** @brief Copies out the undrained contents of the ring, oldest first.
+
+ The flight-recorder read: call after something went wrong to inspect the most recent events
+ without having had a drain running. Records still in flight on other threads are skipped.
+ */
++ (NSData*)recordedEvents;
+
+@end
+
+NS_ASSUME_NONNULL_END
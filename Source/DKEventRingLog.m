@@ -0,0 +1,220 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKEventRingLog.h"
+
+#include <mach/mach_time.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+// the ring holds the most recent 8192 events (256 KB). Writers claim a sequence number with a
+// single atomic increment and fill the slot it maps to; each slot carries the sequence it was
+// written for, stored last with release ordering, so readers can detect slots that are still being
+// written or have been lapped and skip them instead of emitting torn records.
+
+#define kDKEventLogCapacity 8192
+#define kDKEventLogIndexMask (kDKEventLogCapacity - 1)
+
+typedef struct DKEventLogSlot {
+	_Atomic uint64_t seq; // (sequence + 1) once the record below is complete; 0 when never written
+	DKEventLogRecord record;
+} DKEventLogSlot;
+
+static DKEventLogSlot sRing[kDKEventLogCapacity];
+static _Atomic uint64_t sCursor; // next sequence number to be claimed
+static _Atomic int sLoggingEnabled;
+
+// drain state, only ever touched on the drain queue
+
+static uint64_t sDrainCursor; // first sequence not yet written to disk
+static FILE* sDrainFile;
+static dispatch_source_t sDrainTimer;
+
+static uint64_t eventTimeNow(void)
+{
+	static mach_timebase_info_data_t sTimebase;
+
+	if (sTimebase.denom == 0)
+		(void)mach_timebase_info(&sTimebase);
+
+	return mach_absolute_time() * sTimebase.numer / sTimebase.denom;
+}
+
+void DKEventLogPost(DKEventLogCategory category, uint32_t code, uint64_t value1, uint64_t value2)
+{
+	if (!atomic_load_explicit(&sLoggingEnabled, memory_order_relaxed))
+		return;
+
+	uint64_t seq = atomic_fetch_add_explicit(&sCursor, 1, memory_order_relaxed);
+	DKEventLogSlot* slot = &sRing[seq & kDKEventLogIndexMask];
+
+	// a writer that stalls here for a full lap of the ring could interleave with the writer that
+	// laps it; with 8192 slots that is not a realistic hazard for a diagnostic log
+
+	slot->record.timestamp = eventTimeNow();
+	slot->record.category = (uint32_t)category;
+	slot->record.code = code;
+	slot->record.value1 = value1;
+	slot->record.value2 = value2;
+	atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+}
+
+/**    Copy completed records in [fromSeq, toSeq) oldest-first into <outRecords>, which must have
+ room for (toSeq - fromSeq) entries. Slots still being written or already lapped are skipped.
+ Returns the number of records copied.
+*/
+static NSUInteger copyCompletedRecords(uint64_t fromSeq, uint64_t toSeq, DKEventLogRecord* outRecords)
+{
+	NSUInteger copied = 0;
+
+	for (uint64_t seq = fromSeq; seq < toSeq; ++seq) {
+		DKEventLogSlot* slot = &sRing[seq & kDKEventLogIndexMask];
+
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq + 1)
+			continue;
+
+		DKEventLogRecord rec = slot->record;
+
+		// re-check after the copy - if a writer lapped us mid-copy the record is torn, so drop it
+
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) != seq + 1)
+			continue;
+
+		outRecords[copied++] = rec;
+	}
+
+	return copied;
+}
+
+static dispatch_queue_t drainQueue(void)
+{
+	static dispatch_queue_t sQueue = nil;
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		sQueue = dispatch_queue_create("net.apptree.drawkit.eventlog", DISPATCH_QUEUE_SERIAL);
+	});
+
+	return sQueue;
+}
+
+static void drainToFile(void)
+{
+	if (sDrainFile == NULL)
+		return;
+
+	uint64_t toSeq = atomic_load_explicit(&sCursor, memory_order_acquire);
+	uint64_t oldest = (toSeq > kDKEventLogCapacity) ? toSeq - kDKEventLogCapacity : 0;
+	uint64_t fromSeq = MAX(sDrainCursor, oldest);
+
+	if (fromSeq >= toSeq)
+		return;
+
+	DKEventLogRecord* records = malloc((size_t)(toSeq - fromSeq) * sizeof(DKEventLogRecord));
+
+	if (records != NULL) {
+		NSUInteger count = copyCompletedRecords(fromSeq, toSeq, records);
+
+		if (count > 0) {
+			fwrite(records, sizeof(DKEventLogRecord), count, sDrainFile);
+			fflush(sDrainFile);
+		}
+		free(records);
+	}
+	sDrainCursor = toSeq;
+}
+
+#pragma mark -
+@implementation DKEventRingLog
+
++ (void)setLoggingEnabled:(BOOL)enable
+{
+	atomic_store_explicit(&sLoggingEnabled, enable ? 1 : 0, memory_order_relaxed);
+}
+
++ (BOOL)loggingEnabled
+{
+	return atomic_load_explicit(&sLoggingEnabled, memory_order_relaxed) != 0;
+}
+
++ (BOOL)beginDrainingToFileURL:(NSURL*)url
+{
+	if (url == nil)
+		url = [self defaultLogFileURL];
+
+	__block BOOL opened = NO;
+
+	dispatch_sync(drainQueue(), ^{
+		if (sDrainFile != NULL) {
+			opened = YES; // already draining; keep the current file
+			return;
+		}
+
+		sDrainFile = fopen([url fileSystemRepresentation], "ab");
+
+		if (sDrainFile == NULL)
+			return;
+
+		opened = YES;
+		sDrainCursor = atomic_load_explicit(&sCursor, memory_order_acquire);
+
+		sDrainTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, drainQueue());
+		dispatch_source_set_timer(sDrainTimer, dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC / 2), NSEC_PER_SEC / 2, NSEC_PER_SEC / 10);
+		dispatch_source_set_event_handler(sDrainTimer, ^{
+			drainToFile();
+		});
+		dispatch_resume(sDrainTimer);
+	});
+
+	if (opened)
+		[self setLoggingEnabled:YES];
+
+	return opened;
+}
+
++ (void)endDraining
+{
+	dispatch_sync(drainQueue(), ^{
+		if (sDrainTimer != nil) {
+			dispatch_source_cancel(sDrainTimer);
+			sDrainTimer = nil;
+		}
+
+		if (sDrainFile != NULL) {
+			drainToFile();
+			fclose(sDrainFile);
+			sDrainFile = NULL;
+		}
+	});
+}
+
++ (NSURL*)defaultLogFileURL
+{
+	NSString* base = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+	return [NSURL fileURLWithPath:[base stringByAppendingPathComponent:@"DKEventLog.bin"]];
+}
+
++ (NSData*)recordedEvents
+{
+	uint64_t toSeq = atomic_load_explicit(&sCursor, memory_order_acquire);
+	uint64_t fromSeq = (toSeq > kDKEventLogCapacity) ? toSeq - kDKEventLogCapacity : 0;
+
+	if (fromSeq >= toSeq)
+		return [NSData data];
+
+	DKEventLogRecord* records = malloc((size_t)(toSeq - fromSeq) * sizeof(DKEventLogRecord));
+
+	if (records == NULL)
+		return [NSData data];
+
+	NSUInteger count = copyCompletedRecords(fromSeq, toSeq, records);
+
+	return [NSData dataWithBytesNoCopy:records
+								length:count * sizeof(DKEventLogRecord)
+						  freeWhenDone:YES];
+}
+
+@end
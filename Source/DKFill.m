@@ -144,14 +144,27 @@
 		if ([path isEmpty] || [path bounds].size.width <= 0.0 || [path bounds].size.height <= 0.0)
 			return;
 
-		[[NSGraphicsContext currentContext] saveGraphicsState];
-
-		// if low quality, don't bother with shadow - shadows really sap performance
+		// shadows really sap performance, so for drawables the blurred shadow is composited from
+		// a cached bitmap and only re-blurred when the content changes. Low quality drawing
+		// (rapid updates, live drags) renders the bitmap at reduced resolution
 
 		BOOL lowQuality = [obj useLowQualityDrawing];
-
-		if ([self shadow] != nil && [DKStyle willDrawShadows]) {
-			if (!lowQuality)
+		BOOL shadowing = ([self shadow] != nil && [DKStyle willDrawShadows]);
+
+		// only the shadow sets persistent state on the context - fill colour and gradient are
+		// per-draw attributes - so the save/restore pair is skipped when there isn't one
+
+		if (shadowing)
+			[[NSGraphicsContext currentContext] saveGraphicsState];
+
+		if (shadowing) {
+			if ([obj isKindOfClass:[DKDrawableObject class]])
+				[[self shadow] drawCachedShadowWithPath:path
+											  forObject:(DKDrawableObject*)obj
+											  operation:kDKShadowDrawFill
+											strokeWidth:0
+											 lowQuality:lowQuality];
+			else if (!lowQuality)
 				[[self shadow] setAbsolute];
 			else
 				[[self shadow] drawApproximateShadowWithPath:path
@@ -183,10 +196,18 @@
 				[[self gradient] setAngleWithoutNotifying:ga];
 		}
 
-		[[NSGraphicsContext currentContext] restoreGraphicsState];
+		if (shadowing)
+			[[NSGraphicsContext currentContext] restoreGraphicsState];
 	}
 }
 
+- (BOOL)perturbsContextState
+{
+	// the shadow case brackets its own state in -render:; the fill and gradient set only per-draw attributes
+
+	return NO;
+}
+
 - (BOOL)isFill
 {
 	return YES;
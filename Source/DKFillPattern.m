@@ -6,12 +6,20 @@
 
 #import "DKFillPattern.h"
 #import "DKDrawKitMacros.h"
+#import "DKDrawing+Export.h"
 #import "DKGeometryUtilities.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
+#import "NSBezierPath+Geometry.h"
 #import "NSBezierPath+Text.h"
 #import "NSBezierPath-OAExtensions.h"
 
+@interface DKFillPattern (QuartzPatternExport)
+- (BOOL)canRenderAsQuartzPattern;
+- (BOOL)drawQuartzPatternInPath:(NSBezierPath*)aPath;
+- (void)drawPatternCellInContext:(CGContextRef)ctx;
+@end
+
 @implementation DKFillPattern
 #pragma mark As a DKFillPattern
 
@@ -59,6 +67,15 @@
 	if ([self image] == nil)
 		return; // no image, nothing to do
 
+	// at export resolutions stamping each motif individually through the image machinery is the
+	// dominant cost of the whole render - Quartz can instead rasterize the repeating cell once and
+	// tile it. Only regular patterns qualify; randomised ones fall through to explicit placement.
+
+	if (DKExportRenderingInProgress() && [self canRenderAsQuartzPattern]) {
+		if ([self drawQuartzPatternInPath:aPath])
+			return;
+	}
+
 	NSRect rect = [aPath bounds];
 
 	// because the shape may have any rotation, we cannot rely on the passed rect being aligned to the shape. Thus to prevent the pattern
@@ -132,9 +149,14 @@
 
 		NSAffineTransform* tfm = RotationTransform(angle, cp);
 		NSPoint wobblePoint = NSZeroPoint;
-		CGFloat tempAngle = mangle;
 
-		// ok, draw 'em...
+		// placements and motif angles for the whole grid are computed up front, so the rotation
+		// and the angle wrap can be applied across the entire batch in one pass each
+
+		NSUInteger cellCount = (NSUInteger)(rows * 2) * (NSUInteger)(cols * 2);
+		NSPoint* positions = (NSPoint*)malloc(cellCount * sizeof(NSPoint));
+		CGFloat* angles = (CGFloat*)malloc(cellCount * sizeof(CGFloat));
+		NSUInteger placed = 0;
 
 		for (y = -rows; y < rows; ++y) {
 			for (x = -cols; x < cols; ++x) {
@@ -163,52 +185,64 @@
 					mp.y += wobblePoint.y;
 				}
 
-				if ([self motifAngleRandomness] > 0.0) {
-					CGFloat ra = 0.0;
+				CGFloat ra = 0.0;
 
+				if ([self motifAngleRandomness] > 0.0) {
 					if (mPlacementCount < [mMotifAngleRandCache count])
 						ra = [[mMotifAngleRandCache objectAtIndex:mPlacementCount] doubleValue];
 					else {
 						ra = [DKRandom randomPositiveOrNegativeNumber] * 2.0 * M_PI * [self motifAngleRandomness];
 						[mMotifAngleRandCache addObject:@(ra)];
 					}
-					tempAngle = mangle;
-					tempAngle += ra;
 				}
 
-				tp = [tfm transformPoint:mp];
+				positions[placed] = mp;
+				angles[placed] = mangle + ra;
+				++placed;
 				++mPlacementCount;
+			}
+		}
+
+		TransformPoints(positions, placed, [tfm transformStruct]);
+		NormalizeAngles(angles, placed);
 
-				if (m_noClippedElements) {
-					// if this option is set, we don't draw pattern images that intersect the path. To detect whether that happens, the bounding rect
-					// of the element is calculated in position and intersected with the path. The text for intersection can be potentially intensive,
-					// so this option may incur a significant performance hit depending on pattern density, as every placed element needs to be checked.
+		// ok, draw 'em...
 
-					// first, if <tp> is outside the path, we already know it's clipped or intersecting, so we can trivially discard that case
+		for (NSUInteger k = 0; k < placed; ++k) {
+			tp = positions[k];
 
-					if (![aPath containsPoint:tp])
-						continue;
+			if (m_noClippedElements) {
+				// if this option is set, we don't draw pattern images that intersect the path. To detect whether that happens, the bounding rect
+				// of the element is calculated in position and intersected with the path. The text for intersection can be potentially intensive,
+				// so this option may incur a significant performance hit depending on pattern density, as every placed element needs to be checked.
 
-					// tp is inside the path but not all of the image's bounds may be, so need to do full intersection test
+				// first, if <tp> is outside the path, we already know it's clipped or intersecting, so we can trivially discard that case
 
-					motifBounds.origin.x = tp.x - motifBounds.size.width * 0.5;
-					motifBounds.origin.y = tp.y - motifBounds.size.height * 0.5;
+				if (![aPath containsPointUsingInteriorMap:tp])
+					continue;
 
-					// uses Omni's code to perform the detection - returns as soon as it has an answer
+				// tp is inside the path but not all of the image's bounds may be, so need to do full intersection test
 
-					if ([aPath intersectsRect:motifBounds])
-						continue;
-				}
+				motifBounds.origin.x = tp.x - motifBounds.size.width * 0.5;
+				motifBounds.origin.y = tp.y - motifBounds.size.height * 0.5;
 
-				// defer to superclass's placement method to actually draw the elements which applies further transformations, etc.
+				// uses Omni's code to perform the detection - returns as soon as it has an answer
 
-				[self placeObjectAtPoint:tp
-								  onPath:nil
-								position:0
-								   slope:tempAngle
-								userInfo:NULL];
+				if ([aPath intersectsRect:motifBounds])
+					continue;
 			}
+
+			// defer to superclass's placement method to actually draw the elements which applies further transformations, etc.
+
+			[self placeObjectAtPoint:tp
+							  onPath:nil
+							position:0
+							   slope:angles[k]
+							userInfo:NULL];
 		}
+
+		free(positions);
+		free(angles);
 	}
 }
 
@@ -353,6 +387,7 @@
 			[fPath addClip];
 		mPlacementCount = 0;
 		[self drawPatternInPath:fPath];
+		[self flushPendingStamps]; // stamps collected during placement are drawn while the clip is still in force
 		RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 	}
 }
@@ -428,3 +463,177 @@
 }
 
 @end
+
+#pragma mark -
+#pragma mark - Quartz pattern rendering for export
+
+static void DKFillPatternDrawCell(void* info, CGContextRef ctx)
+{
+	[(DKFillPattern*)info drawPatternCellInContext:ctx];
+}
+
+static void DKFillPatternReleaseInfo(void* info)
+{
+	[(DKFillPattern*)info release];
+}
+
+@implementation DKFillPattern (QuartzPatternExport)
+
+- (BOOL)canRenderAsQuartzPattern
+{
+	// a Quartz pattern repeats one fixed cell, so any per-placement randomisation rules it out, as
+	// does the clipped-element suppression (which tests every placement against the path) and the
+	// lateral offset options, whose effect depends on placement order.
+
+	return [self image] != nil
+		&& [self wobblyness] <= 0.0
+		&& [self motifAngleRandomness] <= 0.0
+		&& [self scaleRandomness] <= 0.0
+		&& !m_noClippedElements
+		&& mLateralOffset == 0.0
+		&& !mAlternateLateralOffsets;
+}
+
+- (BOOL)drawQuartzPatternInPath:(NSBezierPath*)aPath
+{
+	NSSize mb = [[self image] size];
+
+	if (mb.width <= 0.0 || mb.height <= 0.0)
+		return NO;
+
+	CGFloat dx = (mb.width + [self interval]) * [self scale];
+	CGFloat dy = (mb.height + [self interval]) * [self scale];
+
+	if (dx <= 0.0 || dy <= 0.0)
+		return NO;
+
+	NSRect rect = [aPath bounds];
+	NSPoint cp;
+
+	cp.x = NSMidX(rect);
+	cp.y = NSMidY(rect);
+
+	CGFloat angle = [self angle];
+
+	if ([self angleIsRelativeToObject])
+		angle += m_objectAngle;
+
+	// the repeating cell is two motifs by two so that the alternate row and column offsets are
+	// reproduced by straight tiling. The cell bounds overhang the tile step by the motif size so
+	// that motifs spilling across the cell edge are not clipped - the neighbouring tile's copy
+	// fills in the rest.
+
+	CGFloat overhang = MAX(mb.width, mb.height) * [self scale];
+	CGRect cellBounds = CGRectMake(-overhang, -overhang, (dx * 2.0) + (overhang * 2.0), (dy * 2.0) + (overhang * 2.0));
+
+	CGContextRef ctx = [[NSGraphicsContext currentContext] graphicsPort];
+
+	CGContextSaveGState(ctx);
+
+	// the pattern matrix maps pattern space to base space - anchor the cell grid on the path's
+	// centre and rotate the whole pattern there, mirroring the explicit placement path
+
+	CGAffineTransform patTfm = CGContextGetCTM(ctx);
+
+	patTfm = CGAffineTransformTranslate(patTfm, cp.x, cp.y);
+	patTfm = CGAffineTransformRotate(patTfm, angle);
+
+	static const CGPatternCallbacks callbacks = { 0, DKFillPatternDrawCell, DKFillPatternReleaseInfo };
+
+	CGPatternRef pattern = CGPatternCreate([self retain], cellBounds, patTfm, dx * 2.0, dy * 2.0, kCGPatternTilingConstantSpacing, true, &callbacks);
+
+	if (pattern == NULL) {
+		[self release]; // the release callback never runs if creation failed
+		CGContextRestoreGState(ctx);
+		return NO;
+	}
+
+	CGColorSpaceRef patSpace = CGColorSpaceCreatePattern(NULL);
+	CGContextSetFillColorSpace(ctx, patSpace);
+	CGColorSpaceRelease(patSpace);
+
+	const CGFloat alpha = 1.0;
+
+	CGContextSetFillPattern(ctx, pattern, &alpha);
+	CGPatternRelease(pattern);
+
+	// the caller has already clipped to the path, so a generous rect fill covers it entirely
+
+	CGContextFillRect(ctx, NSRectToCGRect(NSInsetRect(rect, -overhang, -overhang)));
+	CGContextRestoreGState(ctx);
+
+	return YES;
+}
+
+- (void)drawPatternCellInContext:(CGContextRef)ctx
+{
+	NSImage* img = [self image];
+	NSSize mb = [img size];
+	CGFloat dx = (mb.width + [self interval]) * [self scale];
+	CGFloat dy = (mb.height + [self interval]) * [self scale];
+	CGFloat angle = [self angle];
+	CGFloat mangle = [self motifAngle];
+
+	if ([self angleIsRelativeToObject]) {
+		angle += m_objectAngle;
+		mangle += m_objectAngle;
+	}
+
+	if ([self motifAngleIsRelativeToPattern])
+		mangle += [self angle];
+
+	NSGraphicsContext* nsctx = [NSGraphicsContext graphicsContextWithGraphicsPort:ctx
+																		  flipped:NO];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:nsctx];
+
+	NSInteger x, y;
+
+	for (y = 0; y < 2; ++y) {
+		for (x = 0; x < 2; ++x) {
+			NSPoint mp;
+
+			// same alternating row/column offsets as the explicit placement loop
+
+			if (y & 1)
+				mp.x = dx * (x + m_altXOffset);
+			else
+				mp.x = x * dx;
+
+			if (x & 1)
+				mp.y = dy * (y + m_altYOffset);
+			else
+				mp.y = y * dy;
+
+			CGContextSaveGState(ctx);
+			CGContextTranslateCTM(ctx, mp.x, mp.y);
+
+			// pattern space is rotated by the pattern angle as a whole, so unwind that here and
+			// apply the motif's own rotation in the unrotated frame, exactly as explicit
+			// placement does
+
+			CGContextRotateCTM(ctx, -angle);
+			CGContextScaleCTM(ctx, [self scale], -[self scale]);
+
+			if ([self normalToPath])
+				CGContextRotateCTM(ctx, -mangle);
+
+			CGContextTranslateCTM(ctx, -(mb.width / 2.0), -(mb.height / 2.0));
+
+			if (m_pdf != nil)
+				[m_pdf draw];
+			else
+				[img drawAtPoint:NSZeroPoint
+						fromRect:NSZeroRect
+					   operation:NSCompositeSourceOver
+						fraction:1.0];
+
+			CGContextRestoreGState(ctx);
+		}
+	}
+
+	[NSGraphicsContext restoreGraphicsState];
+}
+
+@end
@@ -45,6 +45,35 @@ NSRect UnionOfTwoRects(const NSRect a, const NSRect b);
  @return The rectangle that encloses all rects. */
 NSRect UnionOfRectsInSet(const NSSet<NSValue*>* aSet) NS_REFINED_FOR_SWIFT;
 
+/** @brief Returns the smallest rect that encloses all \c count rects in the array.
+
+ Batch form of <code>UnionOfTwoRects</code>, accumulating with vector min/max rather than one call
+ per rect. Rects that are \b exactly \c NSZeroRect are skipped, consistent with the two-rect form,
+ so infinitely thin lines and points still push out the envelope but "no bounds yet" placeholders
+ do not. Prefer this in loops that union the bounds of many objects per frame.
+ @param rects An array of <code>count</code> rects.
+ @param count The number of rects in the array.
+ @return The rectangle that encloses all the rects, or \c NSZeroRect if none contribute. */
+NSRect UnionOfRects(const NSRect* rects, const NSUInteger count);
+
+/** @brief Transforms \c count points in place by the given affine transform.
+
+ Batch form of <code>-[NSAffineTransform transformPoint:]</code> for raw point arrays - the matrix
+ is loaded once and applied across the array, avoiding a message send per point. Obtain the struct
+ from an <code>NSAffineTransform</code> via <code>-transformStruct</code>.
+ @param ioPoints An array of \c count points, transformed in place.
+ @param count The number of points in the array.
+ @param t The transform to apply. */
+void TransformPoints(NSPoint* ioPoints, const NSUInteger count, const NSAffineTransformStruct t);
+
+/** @brief Normalizes \c count angles in radians in place to the range <code>-pi..pi</code>.
+
+ Batch form for loops that accumulate several angular terms per element (object angle, motif
+ angle, randomisation) and need the results wrapped back into range once at the end.
+ @param ioAngles An array of \c count angles in radians, normalized in place.
+ @param count The number of angles in the array. */
+void NormalizeAngles(CGFloat* ioAngles, const NSUInteger count);
+
 /** @brief Returns the area that is different between two input rects, as a list of rects
  
  This can be used to optimize upates. If a and b are "before and after" rects of a visual change,
@@ -8,6 +8,7 @@
 #import "DKDrawKitMacros.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
+#import <simd/simd.h>
 
 // this point constant is arbitrary but it is intended to be very unlikely to arise by chance. It can be used to signal "not found" when
 // returning a point value from a function.
@@ -62,14 +63,80 @@ NSRect UnionOfTwoRects(const NSRect a, const NSRect b)
 
 NSRect UnionOfRectsInSet(const NSSet* aSet)
 {
-	NSRect ur = NSZeroRect;
+	NSUInteger n = [aSet count];
+
+	if (n == 0)
+		return NSZeroRect;
+
+	NSRect* rects = (NSRect*)malloc(n * sizeof(NSRect));
+	NSUInteger i = 0;
 
 	for (NSValue* val in aSet)
-		ur = UnionOfTwoRects(ur, [val rectValue]);
+		rects[i++] = [val rectValue];
+
+	NSRect ur = UnionOfRects(rects, i);
+
+	free(rects);
 
 	return ur;
 }
 
+NSRect UnionOfRects(const NSRect* rects, const NSUInteger count)
+{
+	simd_double2 lo = simd_make_double2(INFINITY, INFINITY);
+	simd_double2 hi = simd_make_double2(-INFINITY, -INFINITY);
+	BOOL any = NO;
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		// exactly-zero rects mean "no envelope yet", consistent with UnionOfTwoRects
+
+		if (NSEqualRects(rects[i], NSZeroRect))
+			continue;
+
+		simd_double2 o = simd_make_double2(rects[i].origin.x, rects[i].origin.y);
+		simd_double2 q = o + simd_make_double2(rects[i].size.width, rects[i].size.height);
+
+		// per-rect min/max normalises negative widths and heights, as NSRectFromTwoPoints does
+
+		lo = simd_min(lo, simd_min(o, q));
+		hi = simd_max(hi, simd_max(o, q));
+		any = YES;
+	}
+
+	if (!any)
+		return NSZeroRect;
+
+	return NSMakeRect(lo.x, lo.y, hi.x - lo.x, hi.y - lo.y);
+}
+
+void TransformPoints(NSPoint* ioPoints, const NSUInteger count, const NSAffineTransformStruct t)
+{
+	const simd_double2 col1 = simd_make_double2(t.m11, t.m12);
+	const simd_double2 col2 = simd_make_double2(t.m21, t.m22);
+	const simd_double2 trans = simd_make_double2(t.tX, t.tY);
+
+	for (NSUInteger i = 0; i < count; ++i) {
+		simd_double2 p = col1 * ioPoints[i].x + col2 * ioPoints[i].y + trans;
+
+		ioPoints[i].x = p.x;
+		ioPoints[i].y = p.y;
+	}
+}
+
+void NormalizeAngles(CGFloat* ioAngles, const NSUInteger count)
+{
+	for (NSUInteger i = 0; i < count; ++i) {
+		CGFloat a = fmod(ioAngles[i], 2.0 * M_PI);
+
+		if (a <= -M_PI)
+			a += 2.0 * M_PI;
+		else if (a > M_PI)
+			a -= 2.0 * M_PI;
+
+		ioAngles[i] = a;
+	}
+}
+
 NSSet* DifferenceOfTwoRects(const NSRect a, const NSRect b)
 {
 	NSMutableSet* result = [NSMutableSet set];
@@ -42,6 +42,7 @@ typedef NS_ENUM(NSInteger, DKGradientInterpolation) {
 	DKGradientType m_gradType; // type
 	DKGradientBlending m_blending; // method to blend colours
 	DKGradientInterpolation m_interp; // interpolation function
+	NSGradient* m_cachedGradient; // gradient object used for drawing, rebuilt lazily when the ramp changes
 }
 
 // simple gradient convenience methods
@@ -195,6 +196,13 @@ typedef NS_ENUM(NSInteger, DKGradientInterpolation) {
 			  endingAtPoint:(NSPoint)ep
 				  endRadius:(CGFloat)er;
 
+/** @brief Discards the cached drawing gradient.
+
+ The cache is managed automatically - every operation that changes the colour ramp discards it and the
+ next fill rebuilds it - so calling this is only needed if the stops are mutated behind the gradient's back.
+ */
+- (void)invalidateGradientCache;
+
 /** @brief Returns the computed color for the gradient ramp expressed as a value from 0 to 1.0
  
  While intended for internal use, this function can be called at any time if you wish
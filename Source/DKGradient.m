@@ -26,6 +26,11 @@ NSString* const kDKNotificationGradientDidChange = @"kDKNotificationGradientDidC
 
 #pragma mark Static Vars
 
+// number of samples used when a ramp with non-linear interpolation or HSB blending is baked into evenly
+// spaced stops for NSGradient - see -newNSGradient
+
+static const NSInteger kDKGradientRampResolution = 256;
+
 #pragma mark Function Declarations
 static inline double powerMap(double x, double y);
 static inline double sineMap(double x, double y);
@@ -127,6 +132,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 			inColorStopsAtIndex:[m_colorStops count]];
 		[stop setOwner:self];
 		[self sortColorStops];
+		[self invalidateGradientCache];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidAddColorStop
 															object:self];
 	}
@@ -144,6 +150,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 															object:self];
 		NSUInteger indx = [m_colorStops indexOfObject:stop];
 		[self removeObjectFromColorStopsAtIndex:indx];
+		[self invalidateGradientCache];
 
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidRemoveColorStop
 															object:self];
@@ -155,6 +162,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientWillRemoveColorStop
 														object:self];
 	[m_colorStops removeAllObjects];
+	[self invalidateGradientCache];
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidRemoveColorStop
 														object:self];
 }
@@ -177,6 +185,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 	[m_colorStops makeObjectsPerformSelector:@selector(setOwner:)
 								  withObject:self];
 
+	[self invalidateGradientCache];
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidAddColorStop
 														object:self];
 }
@@ -218,6 +227,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 	}
 
 	[self sortColorStops];
+	[self invalidateGradientCache];
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidChange
 														object:self];
 }
@@ -535,6 +545,39 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 
 - (NSGradient*)newNSGradient
 {
+	// a linear RGB ramp maps directly onto NSGradient's own stop interpolation. The other interpolation
+	// functions and HSB blending do not, so for those the ramp is baked through private_colorAtValue:...
+	// (which honours them) into a table of evenly spaced stops which NSGradient then interpolates linearly -
+	// at this resolution the per-span error is invisible. The result is cached by the caller, so the bake
+	// cost is only paid when the ramp actually changes.
+
+	if (([self gradientInterpolation] != DKGradientInterpolationLinear || [self gradientBlending] != DKGradientBlendingRGB) && [self countOfColorStops] >= 2) {
+		NSMutableArray* rampArr = [[NSMutableArray alloc] initWithCapacity:kDKGradientRampResolution];
+		CGFloat* rampLocs = calloc(kDKGradientRampResolution, sizeof(CGFloat));
+		CGFloat components[4] = { 0, 0, 0, 1 };
+		NSInteger i;
+
+		for (i = 0; i < kDKGradientRampResolution; ++i) {
+			CGFloat val = (CGFloat)i / (CGFloat)(kDKGradientRampResolution - 1);
+
+			[self private_colorAtValue:val
+							components:components
+						  randomAccess:NO];
+			[rampArr addObject:[NSColor colorWithCalibratedRed:components[0]
+														 green:components[1]
+														  blue:components[2]
+														 alpha:components[3]]];
+			rampLocs[i] = val;
+		}
+
+		NSGradient* ramp = [[NSGradient alloc] initWithColors:rampArr
+												  atLocations:rampLocs
+												   colorSpace:[NSColorSpace genericRGBColorSpace]];
+		free(rampLocs);
+
+		return ramp;
+	}
+
 	NSMutableArray* colArr = [[NSMutableArray alloc] initWithCapacity:m_colorStops.count];
 	CGFloat* stopsArr = calloc(m_colorStops.count, sizeof(CGFloat));
 	NSInteger i = 0;
@@ -556,7 +599,13 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 			  endingAtPoint:(NSPoint)ep
 				  endRadius:(CGFloat)er
 {
-	NSGradient* gradient = [self newNSGradient];
+	// rebuilding the NSGradient on every fill is measurable in gradient-heavy drawings, so it is cached
+	// here and discarded whenever the ramp changes
+
+	if (m_cachedGradient == nil)
+		m_cachedGradient = [self newNSGradient];
+
+	NSGradient* gradient = m_cachedGradient;
 
 	switch (self.gradientType) {
 	case kDKGradientTypeLinear:
@@ -595,6 +644,13 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 
 #pragma mark -
 
+- (void)invalidateGradientCache
+{
+	m_cachedGradient = nil;
+}
+
+#pragma mark -
+
 - (NSColor*)colorAtValue:(CGFloat)val
 {
 	// public method to get colour at any point from 0->1 across the gradient. Note that this methiod allows arbitrary
@@ -706,6 +762,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientWillChange
 															object:self];
 		m_blending = bt;
+		[self invalidateGradientCache];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidChange
 															object:self];
 	}
@@ -724,6 +781,7 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientWillChange
 															object:self];
 		m_interp = intrp;
+		[self invalidateGradientCache];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKNotificationGradientDidChange
 															object:self];
 	}
@@ -766,6 +824,8 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 {
 #pragma unused(stop)
 
+	[self invalidateGradientCache];
+
 	//	LogEvent_(kStateEvent, @"stop changed color (%@)", stop);
 }
 
@@ -778,6 +838,8 @@ static inline void resolveHSV(CGFloat* color1, CGFloat* color2);
 {
 #pragma unused(stop)
 
+	[self invalidateGradientCache];
+
 	//	LogEvent_(kStateEvent, @"stop changed position (%@)", stop);
 }
 
@@ -43,7 +43,9 @@ typedef NS_ENUM(NSInteger, DKGridMeasurementSystem) {
 
  General-purpose "snap to grid" type methods are implemented by \c DKDrawing using the grid as a basis - the grid itself doesn't implement snapping.
 
- Note: caching in a \c CGLayer is not recommended - the code is here but it doesn't draw nicely at high zooms. Turned off by default.
+ The grid is rendered once per (zoom, colour scheme) into a repeating \c CGLayer tile covering one major cycle, which is then
+ wallpapered across the update rect - so the per-frame cost is a handful of layer blits regardless of window size or grid density.
+ The tile is re-rendered whenever the zoom changes, so it always matches the view's current resolution.
 */
 @interface DKGridLayer : DKLayer <NSCoding> {
 @private
@@ -68,6 +70,8 @@ typedef NS_ENUM(NSInteger, DKGridMeasurementSystem) {
 	CGFloat mSpanSupressionScale; // scale below which span is not drawn at all (default = 0.1)
 	CGFloat mSpanCycleChangeThreshold; // scale below which span cycle is incremented
 	CGFloat mCachedViewScale; // view scale cache currently set up for
+	CGFloat mTileScale; // view scale the cached grid tile was rendered at
+	BOOL mTileDarkBG; // whether the cached tile used the dark-background colour swap
 @protected
 	CGFloat mSpanMultiplier; // the span is unit distance x this (usually 1.0)
 	NSUInteger m_divisionsPerSpan; // the number of divisions per span
@@ -379,6 +383,13 @@ typedef NS_ENUM(NSInteger, DKGridMeasurementSystem) {
  @param r the rect in which the grid is defined (typically the drawing interior)
  */
 - (void)createGridCacheInRect:(NSRect)r;
+
+/** @brief Returns the size of one repeating cell of the grid pattern
+
+ One cell spans a whole number of spans covering both the major cycle and the current span cycle,
+ so the pattern tiles seamlessly. Returns \c NSZeroSize if the grid parameters are degenerate.
+ */
+- (NSSize)gridTileSize;
 - (void)drawBorderOutline:(DKDrawingView*)aView;
 
 /** @} */
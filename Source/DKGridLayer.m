@@ -216,16 +216,19 @@ static NSColor* sMajorColour = nil;
 - (void)setDivisionsHidden:(BOOL)hide
 {
 	mDrawsDivisions = !hide;
+	[self invalidateCache];
 }
 
 - (void)setSpansHidden:(BOOL)hide
 {
 	mDrawsSpans = !hide;
+	[self invalidateCache];
 }
 
 - (void)setMajorsHidden:(BOOL)hide
 {
 	mDrawsMajors = !hide;
+	[self invalidateCache];
 }
 
 - (BOOL)divisionsHidden
@@ -330,6 +333,7 @@ static NSColor* sMajorColour = nil;
 {
 	if (![self locked]) {
 		m_spanColour = colour;
+		[self invalidateCache];
 		[self setNeedsDisplay:YES];
 	}
 }
@@ -340,6 +344,7 @@ static NSColor* sMajorColour = nil;
 {
 	if (![self locked]) {
 		m_divisionColour = colour;
+		[self invalidateCache];
 		[self setNeedsDisplay:YES];
 	}
 }
@@ -350,6 +355,7 @@ static NSColor* sMajorColour = nil;
 {
 	if (![self locked]) {
 		m_majorColour = colour;
+		[self invalidateCache];
 		[self setNeedsDisplay:YES];
 	}
 }
@@ -515,6 +521,33 @@ static NSColor* sMajorColour = nil;
 	if (m_cgl)
 		CGLayerRelease(m_cgl);
 	m_cgl = nil;
+	mTileScale = 0.0;
+}
+
+static NSUInteger DKGridGCD(NSUInteger a, NSUInteger b)
+{
+	while (b != 0) {
+		NSUInteger t = b;
+		b = a % b;
+		a = t;
+	}
+	return a;
+}
+
+- (NSSize)gridTileSize
+{
+	CGFloat span = [self spanDistance] * mSpanMultiplier;
+
+	if (span <= 0.0 || m_spansPerMajor == 0)
+		return NSZeroSize;
+
+	// one cell must span a whole number of major cycles AND span cycles to repeat seamlessly
+
+	NSUInteger cycle = MAX(mSpanCycle, (NSUInteger)1);
+	NSUInteger period = (cycle / DKGridGCD(cycle, m_spansPerMajor)) * m_spansPerMajor;
+	CGFloat side = span * (CGFloat)period;
+
+	return NSMakeSize(side, side);
 }
 
 - (void)createGridCacheInRect:(NSRect)r
@@ -659,17 +692,12 @@ static NSColor* sMajorColour = nil;
  */
 - (void)drawRect:(NSRect)rect inView:(DKDrawingView*)aView
 {
-#pragma unused(rect)
-
 	// if the view scale has crossed the threshold for span cycle change, invalidate the cache
 
 	[self adjustSpanCycleForViewScale:[aView scale]];
 
 	NSRect mr = [[self drawing] interior];
 
-	if (m_divsCache == nil)
-		[self createGridCacheInRect:mr];
-
 	// be smart about colour: if the drawing has a dark background, switch the divs and majors colours to give better contrast
 	// this is very rarely required but for some unusual situations gives a more usable/visible grid.
 
@@ -677,13 +705,14 @@ static NSColor* sMajorColour = nil;
 	NSColor* mc = m_majorColour;
 
 	CGFloat lum = [[[self drawing] paperColour] luminosity];
+	BOOL darkBG = (lum < 0.67);
 
-	if (lum < 0.67) {
+	if (darkBG) {
 		mc = m_divisionColour;
 		dc = m_majorColour;
 	}
 
-	// draw directly from the cache. Apply the linewidth accounting for the view's scale factor
+	// apply the linewidth accounting for the view's scale factor
 
 	CGFloat zoom = [aView scale];
 	CGFloat dlw, slw, mlw;
@@ -692,31 +721,86 @@ static NSColor* sMajorColour = nil;
 	slw = MIN(m_spanLineWidth / zoom, 1.0);
 	mlw = MIN(m_majorLineWidth / zoom, 1.0);
 
-	if (mDrawsDivisions && zoom >= mDivsSupressionScale) {
-		if (zoom * dlw > 1.0)
-			dlw = 0;
+	if (zoom * dlw > 1.0)
+		dlw = 0;
+	if (zoom * slw > 1.0)
+		slw = 0;
+	if (zoom * mlw > 1.0)
+		mlw = 0;
 
-		[m_divsCache setLineWidth:dlw];
-		[dc setStroke];
-		[m_divsCache stroke];
-	}
+	// the grid repeats every major cycle, so it is rendered once per (zoom, colour scheme) into a
+	// CGLayer tile at the view's current resolution and wallpapered across the update rect - the
+	// per-frame cost is a handful of layer blits regardless of window size or grid density
 
-	if (mDrawsSpans && zoom >= mSpanSupressionScale) {
-		if (zoom * slw > 1.0)
-			slw = 0;
+	NSSize ts = [self gridTileSize];
+	CGContextRef ctx = [[NSGraphicsContext currentContext] graphicsPort];
 
-		[m_spanCache setLineWidth:slw];
-		[m_spanColour setStroke];
-		[m_spanCache stroke];
-	}
+	if (ts.width > 0.0 && ts.height > 0.0) {
+		if (m_cgl == nil || zoom != mTileScale || darkBG != mTileDarkBG) {
+			if (m_cgl)
+				CGLayerRelease(m_cgl);
+
+			m_cgl = CGLayerCreateWithContext(ctx, CGSizeMake(ts.width, ts.height), NULL);
+			mTileScale = zoom;
+			mTileDarkBG = darkBG;
+
+			// the cached paths cover one repeat cell anchored at the origin
+
+			m_divsCache = nil;
+			m_spanCache = nil;
+			m_majorsCache = nil;
+			[self createGridCacheInRect:NSMakeRect(0.0, 0.0, ts.width, ts.height)];
+
+			NSGraphicsContext* tileCtx = [NSGraphicsContext graphicsContextWithGraphicsPort:CGLayerGetContext(m_cgl)
+																					flipped:NO];
+
+			[NSGraphicsContext saveGraphicsState];
+			[NSGraphicsContext setCurrentContext:tileCtx];
+
+			if (mDrawsDivisions && zoom >= mDivsSupressionScale) {
+				[m_divsCache setLineWidth:dlw];
+				[dc setStroke];
+				[m_divsCache stroke];
+			}
 
-	if (mDrawsMajors) {
-		if (zoom * mlw > 1.0)
-			mlw = 0;
+			if (mDrawsSpans && zoom >= mSpanSupressionScale) {
+				[m_spanCache setLineWidth:slw];
+				[m_spanColour setStroke];
+				[m_spanCache stroke];
+			}
 
-		[m_majorsCache setLineWidth:mlw];
-		[mc setStroke];
-		[m_majorsCache stroke];
+			if (mDrawsMajors) {
+				[m_majorsCache setLineWidth:mlw];
+				[mc setStroke];
+				[m_majorsCache stroke];
+			}
+
+			[NSGraphicsContext restoreGraphicsState];
+		}
+
+		// wallpaper the tile across the update area, clipped to the drawing's interior
+
+		NSRect dr = NSIntersectionRect(rect, mr);
+
+		if (!NSIsEmptyRect(dr) && m_cgl != nil) {
+			CGContextSaveGState(ctx);
+			CGContextClipToRect(ctx, NSRectToCGRect(dr));
+
+			NSInteger tx0 = (NSInteger)floor((NSMinX(dr) - NSMinX(mr)) / ts.width);
+			NSInteger tx1 = (NSInteger)floor((NSMaxX(dr) - NSMinX(mr)) / ts.width);
+			NSInteger ty0 = (NSInteger)floor((NSMinY(dr) - NSMinY(mr)) / ts.height);
+			NSInteger ty1 = (NSInteger)floor((NSMaxY(dr) - NSMinY(mr)) / ts.height);
+			NSInteger tx, ty;
+
+			for (ty = ty0; ty <= ty1; ++ty) {
+				for (tx = tx0; tx <= tx1; ++tx)
+					CGContextDrawLayerAtPoint(ctx,
+											  CGPointMake(NSMinX(mr) + tx * ts.width, NSMinY(mr) + ty * ts.height),
+											  m_cgl);
+			}
+
+			CGContextRestoreGState(ctx);
+		}
 	}
 
 	[self drawBorderOutline:aView];
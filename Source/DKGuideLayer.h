@@ -35,6 +35,9 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat m_snapTolerance; // the current snap tolerance value
 	NSRect mGuideDeletionZone; // guides dragged outside this rect are deleted
 	BOOL mDrawGuidesInClipView; // if YES, guides are extended to be drawn in the clip view of an enclosing scroller
+	NSArray<DKGuide*>* mSortedVGuides; // vertical guides sorted by position, for fast snapping - rebuilt lazily
+	NSArray<DKGuide*>* mSortedHGuides; // horizontal guides sorted by position, for fast snapping - rebuilt lazily
+	BOOL mGuideIndexValid; // NO when the sorted guide arrays need rebuilding
 }
 
 // default snapping tolerance:
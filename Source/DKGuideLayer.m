@@ -25,6 +25,9 @@
  */
 - (void)repositionGuide:(DKGuide*)guide atPoint:(NSPoint)p inView:(NSView*)aView;
 - (NSRect)guideRectOfGuide:(DKGuide*)guide forEnclosingClipViewOfView:(NSView*)aView;
+- (void)invalidateGuideIndex;
+- (void)rebuildGuideIndexIfNeeded;
+- (nullable DKGuide*)nearestGuideInSortedArray:(NSArray<DKGuide*>*)sorted toPosition:(CGFloat)pos;
 
 @end
 
@@ -75,6 +78,7 @@ static BOOL sWasInside = NO;
 		[m_hGuides addObject:guide];
 
 	[guide setGuideColour:[self guideColour]];
+	[self invalidateGuideIndex];
 	[self refreshGuide:guide];
 
 	if (!([[self undoManager] isUndoing] || [[self undoManager] isRedoing]))
@@ -97,6 +101,8 @@ static BOOL sWasInside = NO;
 	else
 		[m_hGuides removeObject:guide];
 
+	[self invalidateGuideIndex];
+
 	if (!([[self undoManager] isUndoing] || [[self undoManager] isRedoing]))
 		[[self undoManager] setActionName:NSLocalizedString(@"Delete Guide", @"undo action for Remove Guide")];
 }
@@ -110,6 +116,7 @@ static BOOL sWasInside = NO;
 
 		[m_vGuides removeAllObjects];
 		[m_hGuides removeAllObjects];
+		[self invalidateGuideIndex];
 		[self setNeedsDisplay:YES];
 	}
 }
@@ -122,19 +129,9 @@ static BOOL sWasInside = NO;
  */
 - (DKGuide*)nearestVerticalGuideToPosition:(CGFloat)pos
 {
-	DKGuide* nearestGuide = nil;
-	CGFloat nearestDistance = 10000, distance;
-
-	for (DKGuide* guide in [self verticalGuides]) {
-		distance = fabs(pos - [guide guidePosition]);
-
-		if (distance < [self snapTolerance] && distance < nearestDistance) {
-			nearestDistance = distance;
-			nearestGuide = guide;
-		}
-	}
-
-	return nearestGuide;
+	[self rebuildGuideIndexIfNeeded];
+	return [self nearestGuideInSortedArray:mSortedVGuides
+								toPosition:pos];
 }
 
 /** @brief Locates the nearest guide to the given position, if position is within the snap tolerance
@@ -143,15 +140,69 @@ static BOOL sWasInside = NO;
  */
 - (DKGuide*)nearestHorizontalGuideToPosition:(CGFloat)pos
 {
+	[self rebuildGuideIndexIfNeeded];
+	return [self nearestGuideInSortedArray:mSortedHGuides
+								toPosition:pos];
+}
+
+- (void)invalidateGuideIndex
+{
+	mGuideIndexValid = NO;
+}
+
+- (void)rebuildGuideIndexIfNeeded
+{
+	// the snapping methods search guides sorted by position, so snapping cost is logarithmic in the number of
+	// guides. The sorted arrays are rebuilt lazily after any change to the guide lists or a guide's position.
+
+	if (!mGuideIndexValid) {
+		NSSortDescriptor* byPosition = [NSSortDescriptor sortDescriptorWithKey:@"guidePosition"
+																	 ascending:YES];
+
+		mSortedVGuides = [m_vGuides sortedArrayUsingDescriptors:@[byPosition]];
+		mSortedHGuides = [m_hGuides sortedArrayUsingDescriptors:@[byPosition]];
+		mGuideIndexValid = YES;
+	}
+}
+
+- (DKGuide*)nearestGuideInSortedArray:(NSArray<DKGuide*>*)sorted toPosition:(CGFloat)pos
+{
+	NSUInteger count = [sorted count];
+
+	if (count == 0)
+		return nil;
+
+	// binary search for the insertion point of <pos> - the nearest guide is then one of its two neighbours
+
+	NSUInteger lo = 0, hi = count;
+
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) / 2;
+
+		if ([[sorted objectAtIndex:mid] guidePosition] < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
 	DKGuide* nearestGuide = nil;
-	CGFloat nearestDistance = 10000, distance;
+	CGFloat nearestDistance = [self snapTolerance];
+	CGFloat distance;
 
-	for (DKGuide* guide in [self horizontalGuides]) {
-		distance = fabs(pos - [guide guidePosition]);
+	if (lo < count) {
+		distance = fabs(pos - [[sorted objectAtIndex:lo] guidePosition]);
 
-		if (distance < [self snapTolerance] && distance < nearestDistance) {
+		if (distance < nearestDistance) {
 			nearestDistance = distance;
-			nearestGuide = guide;
+			nearestGuide = [sorted objectAtIndex:lo];
+		}
+	}
+
+	if (lo > 0) {
+		distance = fabs(pos - [[sorted objectAtIndex:lo - 1] guidePosition]);
+
+		if (distance < nearestDistance) {
+			nearestGuide = [sorted objectAtIndex:lo - 1];
 		}
 	}
 
@@ -507,6 +558,7 @@ static BOOL sWasInside = NO;
 #endif
 			[self refreshGuide:guide];
 		[guide setGuidePosition:newPos];
+		[self invalidateGuideIndex];
 #if DK_DRAW_GUIDES_IN_CLIP_VIEW
 		gr = [self guideRectOfGuide:guide
 			forEnclosingClipViewOfView:aView];
@@ -29,6 +29,14 @@ DKHandle is a base class for all handles, which are the knobs attached to shapes
 + (nullable DKHandle*)handleForType:(DKKnobType)type size:(NSSize)size colour:(nullable NSColor*)colour;
 + (void)setHandleClass:(Class)hClass forType:(DKKnobType)type;
 
+/** @brief Discards every cached handle instance.
+
+ Handles are shared instances recycled from per-class pools by <code>+handleForType:size:colour:</code>.
+ They are rebuilt on demand, so this simply bounds the pools when many stale sizes have accumulated,
+ e.g. after heavy zooming.
+ */
++ (void)recycleAllHandles;
+
 @property (class, readonly, copy, nullable) NSColor* fillColour;
 @property (class, readonly, copy, nullable) NSColor* strokeColour;
 + (NSBezierPath*)pathWithSize:(NSSize)size;
@@ -7,15 +7,15 @@
 #import "DKHandle.h"
 #import "DKBoundingRectHandle.h"
 #import "DKGeometryUtilities.h"
+#import "DKObjectPool.h"
 #import "DKPathPointHandle.h"
 #import "DKQuartzCache.h"
 #import "DKRotationHandle.h"
 #import "DKTargetHandle.h"
-#import "NSColor+DKAdditions.h"
 
 @interface DKHandle ()
 
-+ (NSString*)keyForKnobType:(DKKnobType)type;
++ (NSNumber*)keyForKnobType:(DKKnobType)type;
 
 @end
 
@@ -24,7 +24,7 @@
 @implementation DKHandle
 
 static NSMutableDictionary* s_handleClassTable = nil;
-static NSMutableDictionary* s_handleInstancesTable = nil;
+static NSMutableDictionary* s_handlePoolTable = nil;
 
 + (void)initialize
 {
@@ -71,37 +71,54 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 + (DKHandle*)handleForType:(DKKnobType)type size:(NSSize)size colour:(NSColor*)colour
 {
-	NSString* classKey = [self keyForKnobType:type];
-	NSString* key;
+	// handles are shared instances recycled from a per-class pool. Matching against the pooled
+	// instance's size and colour avoids building a dictionary key per lookup - this is called for
+	// every knob drawn, so the old string keys showed up as pure allocation traffic in profiles.
 
-	if (colour)
-		key = [NSString stringWithFormat:@"%@_%@_%ldx%ld", classKey, [colour hexString], (long)ceil(size.width), (long)ceil(size.height)];
-	else
-		key = [NSString stringWithFormat:@"%@_%ldx%ld", classKey, (long)ceil(size.width), (long)ceil(size.height)];
+	Class hc = [s_handleClassTable objectForKey:[self keyForKnobType:type]];
 
-	DKHandle* inst = nil;
+	if (hc == Nil)
+		return nil;
 
-	if (s_handleInstancesTable == nil)
-		s_handleInstancesTable = [[NSMutableDictionary alloc] init];
+	if (s_handlePoolTable == nil)
+		s_handlePoolTable = [[NSMutableDictionary alloc] init];
 
-	inst = [s_handleInstancesTable objectForKey:key];
+	DKObjectPool* pool = [s_handlePoolTable objectForKey:(id<NSCopying>)hc];
 
-	if (inst == nil) {
-		Class hc = [s_handleClassTable objectForKey:classKey];
+	if (pool == nil) {
+		pool = [[DKObjectPool alloc] initWithObjectClass:hc];
+		[s_handlePoolTable setObject:pool
+							  forKey:(id<NSCopying>)hc];
+	}
 
-		if (hc != Nil)
-			inst = [[hc alloc] initWithSize:size
-									 colour:colour];
+	// the stored size is derived from the requested one by the initializer, so derive the same
+	// value for matching
 
-		if (inst != nil) {
-			[s_handleInstancesTable setObject:inst
-									   forKey:key];
+	NSSize match;
 
-			//NSLog(@"added handle instance %@, key = %@, total instances = %d", inst, key, [s_handleInstancesTable count]);
-		}
+	match.width = ceil(size.width * [hc scaleFactor]);
+	match.height = ceil(size.height * [hc scaleFactor]);
+
+	return [pool objectPassingTest:^BOOL(DKHandle* handle) {
+		if (!NSEqualSizes([handle size], match))
+			return NO;
+
+		NSColor* hColour = [handle colour];
+		return (hColour == colour) || (hColour != nil && colour != nil && [hColour isEqual:colour]);
 	}
+		create:^id {
+			return [[hc alloc] initWithSize:size
+									 colour:colour];
+		}];
+}
 
-	return inst;
++ (void)recycleAllHandles
+{
+	// discards every cached handle instance. Handles are rebuilt (and their offscreen caches
+	// refilled) on demand, so this is a way to bound the pools after heavy zooming has cached
+	// handles at many sizes that will not recur.
+
+	[[s_handlePoolTable allValues] makeObjectsPerformSelector:@selector(drain)];
 }
 
 + (void)setHandleClass:(Class)hClass forType:(DKKnobType)type
@@ -112,7 +129,7 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 	if (s_handleClassTable == nil)
 		s_handleClassTable = [[NSMutableDictionary alloc] init];
 
-	NSString* key = [self keyForKnobType:type];
+	NSNumber* key = [self keyForKnobType:type];
 	[s_handleClassTable setObject:hClass
 						   forKey:key];
 }
@@ -247,9 +264,12 @@ static NSMutableDictionary* s_handleInstancesTable = nil;
 
 #pragma mark -
 
-+ (NSString*)keyForKnobType:(DKKnobType)type
++ (NSNumber*)keyForKnobType:(DKKnobType)type
 {
-	return [NSString stringWithFormat:@"hnd_type_%ld", (long)type];
+	// NSNumber keys are tagged pointers, so unlike the formatted strings previously used here they
+	// cost nothing to build per lookup
+
+	return @(type);
 }
 
 #pragma mark -
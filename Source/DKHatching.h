@@ -22,11 +22,16 @@ NS_ASSUME_NONNULL_BEGIN
  The hatch is cached in an \c NSBezierPath object based on the bounds of the path. If another path is hatched that is smaller
  than the cached size, it is not rebuilt. It is rebuilt if the angle or spacing changes or a bigger path is hatched. Linewidth also
  doesn't change the cache.
+
+ For plain hatches (no roughness or wobble) the lines are additionally clipped against the path geometrically and the resulting
+ segments cached per path and parameter set, so steady-state redraws stroke a flat array of precomputed segments in a single
+ call instead of re-clipping the whole line set every time.
 */
 @interface DKHatching : DKRasterizer <NSCoding, NSCopying, DKDashable> {
 @private
 	NSBezierPath* m_cache;
 	NSBezierPath* mRoughenedCache;
+	NSMutableDictionary<NSString*, NSData*>* mSegmentCache; // clipped hatch segments (flat CGPoint pairs) keyed by path + parameters
 	NSColor* m_hatchColour;
 	DKStrokeDash* m_hatchDash;
 	NSLineCapStyle m_cap;
@@ -10,9 +10,31 @@
 #import "DKStrokeDash.h"
 #import "NSBezierPath+Geometry.h"
 
+// number of path/parameter combinations whose clipped segments are retained before the cache is
+// emptied wholesale - enough for the working set of a redraw without unbounded growth
+
+static const NSUInteger kDKHatchSegmentCacheCapacity = 32;
+
+// scanline intersection record used by the geometric clipper
+
+typedef struct {
+	CGFloat y; // intersection ordinate along the scanline
+	NSInteger dir; // edge direction, for the winding rule
+} DKHatchIntersection;
+
+static int hatchIntersectionCompare(const void* a, const void* b)
+{
+	const CGFloat ya = ((const DKHatchIntersection*)a)->y;
+	const CGFloat yb = ((const DKHatchIntersection*)b)->y;
+
+	return (ya < yb) ? -1 : ((ya > yb) ? 1 : 0);
+}
+
 @interface DKHatching ()
 
 - (void)invalidateRoughnessCache;
+- (nullable NSData*)clippedHatchSegmentsForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa;
+- (void)strokeHatchSegments:(NSData*)segments;
 
 @end
 
@@ -116,6 +138,20 @@
  */
 - (void)hatchPath:(NSBezierPath*)path objectAngle:(CGFloat)oa
 {
+	// fast path: for plain hatches (no roughness or wobble) the lines are clipped against the path
+	// geometrically, cached per path and parameter set, and stroked in a single call - steady-state
+	// redraws neither rebuild the hatch nor clip the full line set against the path again
+
+	if (!mRoughenStrokes && mWobblyness == 0.0) {
+		NSData* segments = [self clippedHatchSegmentsForPath:path
+												 objectAngle:oa];
+
+		if (segments) {
+			[self strokeHatchSegments:segments];
+			return;
+		}
+	}
+
 	// if the bounds size of <path> is larger than the cached hatch, then we'll need to enlarge the cache, so invalidate
 	// it.
 
@@ -343,9 +379,208 @@
 - (void)invalidateCache
 {
 	m_cache = nil;
+	[mSegmentCache removeAllObjects];
 	[self invalidateRoughnessCache];
 }
 
+- (NSData*)clippedHatchSegmentsForPath:(NSBezierPath*)path objectAngle:(CGFloat)oa
+{
+	NSRect br = [path bounds];
+
+	if (NSIsEmptyRect(br) || [path isEmpty])
+		return nil;
+
+	NSString* key = [self derivedPathCacheKeyForPath:path
+										  parameters:[NSString stringWithFormat:@"%.4f_%.3f_%.3f_%.4f", [self angle], [self spacing], [self leadIn], oa]];
+	NSData* segments = [mSegmentCache objectForKey:key];
+
+	if (segments)
+		return segments;
+
+	// work in a frame rotated so the hatch lines are vertical, centred on the path. The path is
+	// flattened and its edges intersected with each scanline - a plain C loop over flat arrays
+	// that the compiler can vectorize, touching no transient Cocoa objects
+
+	const CGFloat theta = [self angle] + oa;
+	const CGFloat ct = cos(theta);
+	const CGFloat st = sin(theta);
+	const NSPoint centre = NSMakePoint(NSMidX(br), NSMidY(br));
+
+	NSBezierPath* flat = [path bezierPathByFlatteningPath];
+	NSMutableData* edgeData = [NSMutableData data];
+	NSInteger i, ec = [flat elementCount];
+	NSPoint pts[3], firstPt = NSZeroPoint, curPt = NSZeroPoint;
+	BOOL hasFirst = NO;
+	CGFloat minX = CGFLOAT_MAX, maxX = -CGFLOAT_MAX;
+
+// rotate into the hatch frame and append one edge (4 CGFloats) per line segment, closing
+// each subpath; degenerate (vertical-in-frame) edges never intersect a scanline interior
+// and are kept - the parity test rejects them
+
+#define ROTATED_X(p) (((p).x - centre.x) * ct + ((p).y - centre.y) * st)
+#define ROTATED_Y(p) (-((p).x - centre.x) * st + ((p).y - centre.y) * ct)
+#define APPEND_EDGE(p, q)                                                          \
+	{                                                                              \
+		CGFloat e[4] = { ROTATED_X(p), ROTATED_Y(p), ROTATED_X(q), ROTATED_Y(q) }; \
+		minX = MIN(minX, MIN(e[0], e[2]));                                         \
+		maxX = MAX(maxX, MAX(e[0], e[2]));                                         \
+		[edgeData appendBytes:e                                                    \
+					   length:sizeof(e)];                                          \
+	}
+
+	for (i = 0; i < ec; ++i) {
+		switch ([flat elementAtIndex:i
+					associatedPoints:pts]) {
+		case NSMoveToBezierPathElement:
+			if (hasFirst && !NSEqualPoints(curPt, firstPt))
+				APPEND_EDGE(curPt, firstPt);
+			firstPt = curPt = pts[0];
+			hasFirst = YES;
+			break;
+
+		case NSLineToBezierPathElement:
+			APPEND_EDGE(curPt, pts[0]);
+			curPt = pts[0];
+			break;
+
+		case NSClosePathBezierPathElement:
+			APPEND_EDGE(curPt, firstPt);
+			curPt = firstPt;
+			break;
+
+		default:
+			break; // the path is flattened - no curve elements occur
+		}
+	}
+
+	if (hasFirst && !NSEqualPoints(curPt, firstPt))
+		APPEND_EDGE(curPt, firstPt);
+
+#undef ROTATED_X
+#undef ROTATED_Y
+#undef APPEND_EDGE
+
+	const NSUInteger edgeCount = [edgeData length] / (sizeof(CGFloat) * 4);
+
+	if (edgeCount == 0)
+		return nil;
+
+	const CGFloat* edges = (const CGFloat*)[edgeData bytes];
+	DKHatchIntersection* cross = malloc(edgeCount * sizeof(DKHatchIntersection));
+	NSMutableData* segData = [NSMutableData data];
+	const BOOL evenOdd = ([path windingRule] == NSEvenOddWindingRule);
+	const CGFloat spacing = [self spacing];
+	CGFloat x = [self leadIn] + spacing * ceil((minX - [self leadIn]) / spacing);
+
+	for (; x <= maxX; x += spacing) {
+		NSUInteger n = 0, e;
+
+		for (e = 0; e < edgeCount; ++e) {
+			const CGFloat ax = edges[e * 4], ay = edges[e * 4 + 1];
+			const CGFloat bx = edges[e * 4 + 2], by = edges[e * 4 + 3];
+
+			if ((ax <= x) != (bx <= x)) {
+				const CGFloat t = (x - ax) / (bx - ax);
+
+				cross[n].y = ay + t * (by - ay);
+				cross[n].dir = (bx > ax) ? 1 : -1;
+				++n;
+			}
+		}
+
+		if (n < 2)
+			continue;
+
+		qsort(cross, n, sizeof(DKHatchIntersection), hatchIntersectionCompare);
+
+		// pair the sorted intersections into interior spans according to the path's winding rule,
+		// rotating each resulting segment back into drawing space
+
+		NSInteger w = 0;
+		CGFloat spanStart = 0;
+
+		for (e = 0; e < n; ++e) {
+			const NSInteger pw = w;
+
+			if (evenOdd)
+				w = !w;
+			else
+				w += cross[e].dir;
+
+			if (pw == 0 && w != 0)
+				spanStart = cross[e].y;
+			else if (pw != 0 && w == 0) {
+				const CGPoint seg[2] = {
+					{ x * ct - spanStart * st + centre.x, x * st + spanStart * ct + centre.y },
+					{ x * ct - cross[e].y * st + centre.x, x * st + cross[e].y * ct + centre.y }
+				};
+				[segData appendBytes:seg
+							  length:sizeof(seg)];
+			}
+		}
+	}
+
+	free(cross);
+
+	if (mSegmentCache == nil)
+		mSegmentCache = [[NSMutableDictionary alloc] init];
+
+	// wholesale eviction at capacity - cheap, and the working set is quickly re-primed
+
+	if ([mSegmentCache count] >= kDKHatchSegmentCacheCapacity)
+		[mSegmentCache removeAllObjects];
+
+	segments = [segData copy];
+	[mSegmentCache setObject:segments
+					  forKey:key];
+
+	return segments;
+}
+
+- (void)strokeHatchSegments:(NSData*)segments
+{
+	CGContextRef ctx = [[NSGraphicsContext currentContext] graphicsPort];
+
+	CGContextSaveGState(ctx);
+
+	// enforce a minimum line width of 0.1 - sizes of zero do not print.
+
+	CGFloat actualLineWidth = [self width];
+
+	if (![NSGraphicsContext currentContextDrawingToScreen]) {
+		if (actualLineWidth <= 0.0)
+			actualLineWidth = 0.05; // hairline
+	}
+
+	CGContextSetLineWidth(ctx, actualLineWidth);
+	CGContextSetLineCap(ctx, (CGLineCap)[self lineCapStyle]);
+
+	if ([self dash]) {
+		CGFloat dp[8];
+		NSInteger count = 0;
+		CGFloat phase = [[self dash] phase];
+
+		[[self dash] getDashPattern:dp
+							  count:&count];
+
+		if ([[self dash] scalesToLineWidth]) {
+			NSInteger d;
+
+			for (d = 0; d < count; ++d)
+				dp[d] *= actualLineWidth;
+
+			phase *= actualLineWidth;
+		}
+
+		CGContextSetLineDash(ctx, -phase, dp, count);
+	}
+
+	[[self colour] setStroke];
+	CGContextStrokeLineSegments(ctx, (const CGPoint*)[segments bytes], [segments length] / sizeof(CGPoint));
+
+	CGContextRestoreGState(ctx);
+}
+
 - (void)calcHatchInRect:(NSRect)rect
 {
 	if (m_cache == nil) {
@@ -476,6 +711,13 @@
 			objectAngle:0.0];
 }
 
+- (BOOL)perturbsContextState
+{
+	// -hatchPath:objectAngle: brackets its clip with its own save/restore
+
+	return NO;
+}
+
 #pragma mark -
 #pragma mark As part of GraphicAttributtes Protocol
 - (void)setValue:(id)val forNumericParameter:(NSInteger)pnum
@@ -547,6 +789,7 @@
 	self = [super initWithCoder:coder];
 	if (self != nil) {
 		NSAssert(m_cache == nil, @"Expected init to zero");
+
 		[self setColour:[coder decodeObjectForKey:@"colour"]];
 		[self setDash:[coder decodeObjectForKey:@"dash"]];
 
@@ -21,6 +21,11 @@ typedef NS_ENUM(NSInteger, DKImageFittingOption) {
 /** @brief This class allows any image to be part of the rendering tree.
 
 This class allows any image to be part of the rendering tree.
+
+ Where the image is stored in the drawing's \c DKImageDataManager (set via <code>-setImageWithKey:forDrawing:</code>), rendering
+ draws a representation decoded at no more than the resolution the adornment actually occupies on screen. Higher resolutions
+ needed after zooming in are decoded asynchronously, the clients of the owning style being refreshed when they arrive, so a
+ style adorning hundreds of objects never stalls drawing on a full-size decode.
 */
 @interface DKImageAdornment : DKRasterizer <NSCoding, NSCopying> {
 @private
@@ -33,6 +38,7 @@ This class allows any image to be part of the rendering tree.
 	NSCompositingOperation m_op;
 	DKImageFittingOption m_fittingOption;
 	NSString* m_imageIdentifier;
+	BOOL mThumbnailUpgradePending; // YES while an async decode of a higher-resolution representation is in flight
 }
 
 + (instancetype)imageAdornmentWithImage:(NSImage*)image;
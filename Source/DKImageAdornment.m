@@ -11,7 +11,22 @@
 #import "DKGeometryUtilities.h"
 
 #import "DKDrawing.h"
+#import "DKDrawingView.h"
 #import "DKImageDataManager.h"
+#import "DKStyle.h"
+
+#pragma mark Constants
+
+#define kDKImageAdornmentMinimumThumbnailSize 128 // smallest representation ever decoded, in pixels
+#define kDKImageAdornmentMaximumThumbnailSize 16384
+
+@interface DKImageAdornment ()
+
+- (NSImage*)imageToDrawForObject:(id<DKRenderable>)object source:(NSImage*)source;
+
+@end
+
+#pragma mark -
 
 @implementation DKImageAdornment
 #pragma mark As a DKImageAdornment
@@ -148,6 +163,93 @@
 	return xform;
 }
 
+- (NSImage*)imageToDrawForObject:(id<DKRenderable>)object source:(NSImage*)source
+{
+	// returns the image to actually composite. Where the source is backed by the drawing's image
+	// manager, this is a representation decoded at no more than the resolution the adornment
+	// occupies on screen; a larger representation needed after zooming in is decoded asynchronously
+	// and the owning style's clients refreshed when it arrives, drawing whatever is already decoded
+	// in the meantime. This mirrors DKImageShape's thumbnail pipeline, but per-rasterizer so that
+	// one style shared by many objects shares the decoded representations too.
+
+	NSString* key = [self imageKey];
+	DKImageDataManager* dm = nil;
+
+	if ([key length] > 0 && [object respondsToSelector:@selector(drawing)])
+		dm = [[(id)object drawing] imageManager];
+
+	if (dm == nil || ![dm hasImageDataForKey:key] || source != [self image])
+		return source;
+
+	// the largest dimension the image will occupy on screen, in pixels. The CTM at this point
+	// already includes the view zoom and this adornment's scaling transform
+
+	CGAffineTransform ctm = CGContextGetCTM([[NSGraphicsContext currentContext] graphicsPort]);
+	NSSize si = [source size];
+	CGFloat maxDim = MAX(si.width * hypot(ctm.a, ctm.b), si.height * hypot(ctm.c, ctm.d));
+
+	// quantize up to the next power of two so a continuous zoom reuses cached representations
+
+	NSUInteger maxPx = kDKImageAdornmentMinimumThumbnailSize;
+
+	while ((CGFloat)maxPx < maxDim && maxPx < kDKImageAdornmentMaximumThumbnailSize)
+		maxPx <<= 1;
+
+	NSImage* image = [dm cachedThumbnailImageForKey:key
+								   maximumPixelSize:maxPx];
+
+	if (image == nil) {
+		// nothing decoded at this size yet. If a smaller representation is already cached, draw that
+		// and upgrade asynchronously so zooming in never stalls on a large decode.
+
+		NSUInteger px = maxPx;
+
+		while (image == nil && (px >>= 1) >= kDKImageAdornmentMinimumThumbnailSize)
+			image = [dm cachedThumbnailImageForKey:key
+								  maximumPixelSize:px];
+
+		if (image != nil) {
+			if (!mThumbnailUpgradePending) {
+				mThumbnailUpgradePending = YES;
+
+				// decode at high priority when the object is in the viewport, low when the request
+				// is speculative. The adornment may be shared by many objects, so no cancellation
+				// token is kept - cancelling on behalf of one client could starve another.
+
+				DKRenderState rs = [DKDrawingView currentRenderState];
+				DKImageDecodePriority priority = kDKImageDecodePriorityNormal;
+
+				if (!NSIsEmptyRect(rs.visibleRect))
+					priority = NSIntersectsRect([object bounds], rs.visibleRect) ? kDKImageDecodePriorityHigh : kDKImageDecodePriorityLow;
+
+				[dm requestThumbnailImageForKey:key
+							   maximumPixelSize:maxPx
+									   priority:priority
+									 completion:^(NSImage* decoded) {
+#pragma unused(decoded)
+										 mThumbnailUpgradePending = NO;
+
+										 // redisplay every client of the owning style. This goes through
+										 // -redisplayClients rather than -notifyClientsAfterChange so a
+										 // mere cache fill does not touch the style's modification timestamp
+
+										 DKRastGroup* root = [self root];
+
+										 if ([root isKindOfClass:[DKStyle class]])
+											 [(DKStyle*)root redisplayClients];
+									 }];
+			}
+		} else {
+			// first draw - decode synchronously at the displayed resolution
+
+			image = [dm thumbnailImageForKey:key
+							maximumPixelSize:maxPx];
+		}
+	}
+
+	return image ? image : source;
+}
+
 #pragma mark -
 #pragma mark As a DKRasterizer
 - (BOOL)isValid
@@ -244,6 +346,13 @@
 		destRect.origin.x = [self origin].x - (destRect.size.width / 2.0);
 		destRect.origin.y = [self origin].y - (destRect.size.height / 2.0);
 
+		// where the image lives in the drawing's image manager, substitute a representation decoded
+		// at no more than the on-screen resolution - the geometry above is unaffected as it is
+		// computed from the image's logical size
+
+		image = [self imageToDrawForObject:object
+									source:image];
+
 		// draw the image
 		[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationHigh];
 		[image drawInRect:destRect
@@ -8,6 +8,17 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** @brief Scheduling priority for asynchronous decodes.
+
+ Requests are worked highest priority first, so content the user is looking at decodes before
+ speculative prefetches.
+ */
+typedef NS_ENUM(NSInteger, DKImageDecodePriority) {
+	kDKImageDecodePriorityLow = 0, //!< prefetch, content well outside the viewport
+	kDKImageDecodePriorityNormal = 1, //!< default
+	kDKImageDecodePriorityHigh = 2 //!< content currently in the viewport
+};
+
 /**
 The purpose of this class is to allow images to be archived much more efficiently, by archiving the original data that the image was created from rather than any bitmaps or
  other uncompressed forms, and to avoid storing multiple copies of the same image. Each drawing will have an instance of this class and any image using objects such as DKImageShape
@@ -21,7 +32,14 @@ The purpose of this class is to allow images to be archived much more efficientl
 @private
 	NSMutableDictionary<NSString*, NSData*>* mRepository;
 	NSMutableDictionary<NSString*, NSString*>* mHashList;
+	NSMutableDictionary<NSString*, NSString*>* mExternalRefs; // key -> content hash, for images resident in the external store
 	NSMutableDictionary<NSString*, NSNumber*>* mKeyUsage;
+	NSCache* mThumbnailCache; // decoded, downsampled representations keyed by image key and pixel size
+	dispatch_queue_t mDecodeQueue; // concurrent queue on which decode work executes
+	NSMutableArray* mPendingDecodes; // queued decode requests, highest priority first
+	NSUInteger mActiveDecodeCount; // decodes currently executing
+	NSUInteger mDecodeWorkerLimit; // maximum decodes allowed in flight at once
+	dispatch_source_t mMemoryPressureSource; // flushes the thumbnail cache under memory pressure
 }
 
 - (nullable NSData*)imageDataForKey:(NSString*)key;
@@ -37,6 +55,53 @@ The purpose of this class is to allow images to be archived much more efficientl
 - (nullable NSImage*)makeImageWithContentsOfURL:(NSURL*)url key:(NSString* _Nullable __autoreleasing* _Nullable)key;
 - (nullable NSImage*)makeImageForKey:(NSString*)key;
 
+/** @brief Returns a representation of the stored image decoded at no more than \c maxPixelSize along its longest side.
+
+ The decode works directly from the compressed data, so its cost (and the resulting bitmap's footprint) is
+ proportional to the requested size, not the image's native size. Representations are cached, shared between
+ all clients displaying the same data, and evicted under memory pressure, after which they are simply decoded
+ again on demand. Passing a size at least as large as the image's longest side returns a full-resolution decode.
+ @param key the image's key
+ @param maxPixelSize the maximum dimension of the returned representation, in pixels
+ @return the decoded image, or \c nil if the key is unknown or the data cannot be decoded
+ */
+- (nullable NSImage*)thumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize;
+
+/** @brief As -thumbnailImageForKey:maximumPixelSize: but only consults the cache - nothing is decoded. */
+- (nullable NSImage*)cachedThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize;
+
+/** @brief Decodes a representation asynchronously, calling \c completion on the main queue when it is ready.
+
+ Used to upgrade to a higher-resolution representation without stalling drawing - the client draws whatever
+ it already has and refreshes from the cache when the completion fires. Equivalent to requesting at
+ \c kDKImageDecodePriorityNormal and discarding the cancellation token.
+ @param key the image's key
+ @param maxPixelSize the maximum dimension of the representation, in pixels
+ @param completion called on the main queue with the decoded image, or \c nil on failure
+ */
+- (void)requestThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize completion:(void (^)(NSImage* _Nullable image))completion;
+
+/** @brief As above, with an explicit priority, returning a token that can cancel the request.
+
+ Decodes run on a bounded worker pool sized to a fraction of the machine's cores, so a burst of requests
+ (opening a document full of images, say) neither oversubscribes the CPU nor holds hundreds of decoded
+ bitmaps in flight at once. Queued requests are worked highest priority first; within a priority,
+ first-come first-served. Callers that know their content has scrolled out of relevance should cancel,
+ which drops a queued request entirely and suppresses the completion of an executing one.
+ @param key the image's key
+ @param maxPixelSize the maximum dimension of the representation, in pixels
+ @param priority the scheduling priority
+ @param completion called on the main queue with the decoded image, or \c nil on failure
+ @return an opaque token for <code>-cancelThumbnailRequest:</code>, or \c nil if the request completed immediately
+ */
+- (nullable id)requestThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize priority:(DKImageDecodePriority)priority completion:(void (^)(NSImage* _Nullable image))completion;
+
+/** @brief Cancels a pending or executing decode request.
+
+ Safe to call with \c nil or an already-completed token.
+ */
+- (void)cancelThumbnailRequest:(nullable id)token;
+
 - (void)setKey:(NSString*)key isInUse:(BOOL)inUse;
 - (BOOL)keyIsInUse:(NSString*)key;
 
@@ -44,6 +109,29 @@ The purpose of this class is to allow images to be archived much more efficientl
  */
 - (void)removeUnusedData;
 
+/** @brief Set whether image data is kept in an external content-addressed store instead of the archive.
+
+ When enabled, archiving writes each image's compressed data to a file in the external store named by the
+ SHA-256 of its content, and the archive itself records only the key-to-hash mapping. Documents then open
+ without reading any image bytes - the data is memory-mapped from the store the first time an image is
+ actually needed, and the mapping is shared between all open documents referencing identical imagery.
+ Writing a blob whose hash is already present in the store is skipped, so identical images across any
+ number of documents occupy the space of one. When disabled (the default), archives embed the image data
+ as before; a document saved with the store disabled is self-contained and can leave the machine.
+ The setting is persistent.
+ */
++ (void)setExternalStoreEnabled:(BOOL)enable;
++ (BOOL)externalStoreEnabled;
+
+/** @brief The directory the external store keeps its content-addressed files in.
+
+ Defaults to "DrawKit/Image Store" within the user's Application Support directory. Set to \c nil to
+ restore the default. Store files are shared between documents, so they are never deleted by the
+ framework - housekeeping of the store directory is the application's business.
+ */
++ (void)setExternalStoreURL:(nullable NSURL*)url;
++ (NSURL*)externalStoreURL;
+
 @end
 
 extern NSPasteboardType const kDKImageDataManagerPasteboardType NS_SWIFT_NAME(dkImageDataManager);
@@ -56,6 +144,19 @@ extern NSPasteboardType const kDKImageDataManagerPasteboardType NS_SWIFT_NAME(dk
 - (NSUInteger)checksum;
 - (NSString*)checksumString;
 
+/** @brief A 64-bit FNV-1a hash over the entire data. Much stronger than \c -checksum, which only samples the first
+ 1K bytes; used by the image manager's duplicate index. Callers should still confirm a match with \c -isEqualToData:
+ as hash equality alone does not guarantee identical data.
+ */
+- (uint64_t)hash64;
+- (NSString*)hash64String;
+
+/** @brief The SHA-256 digest of the data as a lowercase hex string. Used to name files in the image
+ manager's external content-addressed store, where a collision would silently alias two different images,
+ so a cryptographic hash is warranted.
+ */
+- (NSString*)sha256String;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -7,9 +7,64 @@
 #import "DKImageDataManager.h"
 #import "DKKeyedUnarchiver.h"
 #import "DKUniqueID.h"
+#import "LogEvent.h"
+
+#import <CommonCrypto/CommonDigest.h>
+#import <ImageIO/ImageIO.h>
 
 NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdatamgrtype";
 
+static NSString* const kDKExternalStoreDefaultsKey = @"DKImageDataManager_useExternalStore";
+
+// mapped store data is shared between every open document referencing the same content hash. The values are
+// weak, so a blob is unmapped as soon as the last document using it lets go.
+
+static NSMapTable<NSString*, NSData*>* sMappedStoreData = nil;
+static NSURL* sExternalStoreURL = nil;
+
+/** a queued or executing asynchronous decode. Doubles as the caller's cancellation token. */
+@interface DKImageDecodeRequest : NSObject
+
+@property (copy) NSString* key;
+@property NSUInteger maxPixelSize;
+@property DKImageDecodePriority priority;
+@property BOOL cancelled;
+@property (copy) void (^completion)(NSImage*);
+
+@end
+
+@implementation DKImageDecodeRequest
+@end
+
+/** decodes a representation of the compressed data no larger than \c maxPixelSize on its longest side. This goes
+ through CGImageSource's thumbnail machinery, so only the pixels actually requested are ever decoded and the
+ result is pre-rasterized (no further lazy decode happens when it is first drawn).
+ */
+static NSImage* dkDecodeThumbnail(NSData* data, NSUInteger maxPixelSize)
+{
+	CGImageSourceRef src = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+
+	if (src == NULL)
+		return nil;
+
+	NSDictionary* options = @{ (NSString*)kCGImageSourceCreateThumbnailFromImageAlways: @YES,
+		(NSString*)kCGImageSourceCreateThumbnailWithTransform: @YES,
+		(NSString*)kCGImageSourceShouldCacheImmediately: @YES,
+		(NSString*)kCGImageSourceThumbnailMaxPixelSize: @(maxPixelSize) };
+
+	CGImageRef cgImage = CGImageSourceCreateThumbnailAtIndex(src, 0, (__bridge CFDictionaryRef)options);
+	CFRelease(src);
+
+	if (cgImage == NULL)
+		return nil;
+
+	NSImage* image = [[NSImage alloc] initWithCGImage:cgImage
+												 size:NSZeroSize];
+	CGImageRelease(cgImage);
+
+	return image;
+}
+
 @interface DKImageDataManager ()
 
 /** hash list maps hash (or checksum) -> key, so is inverse to repository. As it can be built from the repo, it is safer to do this following dearchiving
@@ -17,13 +72,148 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 */
 - (void)buildHashList;
 
+- (void)setUpThumbnailCache;
+- (NSString*)thumbnailCacheKeyForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize;
+
+/** starts queued decodes until the worker limit is reached. Called whenever the queue gains work or a worker finishes. */
+- (void)pumpDecodeQueue;
+
++ (nullable NSData*)mappedStoreDataForHash:(NSString*)hash;
++ (BOOL)writeData:(NSData*)data toStoreForHash:(NSString*)hash;
+
 @end
 
 @implementation DKImageDataManager
 
+#pragma mark - external content-addressed store
+
++ (void)setExternalStoreEnabled:(BOOL)enable
+{
+	[[NSUserDefaults standardUserDefaults] setBool:enable
+											forKey:kDKExternalStoreDefaultsKey];
+}
+
++ (BOOL)externalStoreEnabled
+{
+	return [[NSUserDefaults standardUserDefaults] boolForKey:kDKExternalStoreDefaultsKey];
+}
+
++ (void)setExternalStoreURL:(NSURL*)url
+{
+	sExternalStoreURL = [url copy];
+}
+
++ (NSURL*)externalStoreURL
+{
+	if (sExternalStoreURL == nil) {
+		NSURL* base = [[NSFileManager defaultManager] URLForDirectory:NSApplicationSupportDirectory
+															 inDomain:NSUserDomainMask
+													appropriateForURL:nil
+															   create:YES
+																error:NULL];
+		sExternalStoreURL = [[base URLByAppendingPathComponent:@"DrawKit"
+												   isDirectory:YES] URLByAppendingPathComponent:@"Image Store"
+																					isDirectory:YES];
+	}
+
+	return sExternalStoreURL;
+}
+
++ (NSData*)mappedStoreDataForHash:(NSString*)hash
+{
+	// returns the store blob for <hash>, memory-mapped. The same NSData is handed to every caller asking for
+	// the same hash while anyone is still holding it, so identical imagery in several documents is mapped once.
+
+	@synchronized([DKImageDataManager class]) {
+		if (sMappedStoreData == nil)
+			sMappedStoreData = [NSMapTable strongToWeakObjectsMapTable];
+
+		NSData* data = [sMappedStoreData objectForKey:hash];
+
+		if (data == nil) {
+			NSURL* url = [[self externalStoreURL] URLByAppendingPathComponent:hash];
+			NSError* error = nil;
+
+			data = [NSData dataWithContentsOfURL:url
+										 options:NSDataReadingMappedIfSafe
+										   error:&error];
+
+			if (data == nil) {
+				LogEvent_(kWheneverEvent, @"image store blob missing or unreadable for hash %@: %@", hash, error);
+				return nil;
+			}
+
+			[sMappedStoreData setObject:data
+								 forKey:hash];
+		}
+
+		return data;
+	}
+}
+
++ (BOOL)writeData:(NSData*)data toStoreForHash:(NSString*)hash
+{
+	// adds <data> to the store if a blob with this hash isn't already present. Returns NO if the blob could
+	// not be written, in which case the caller should fall back to embedding the data.
+
+	NSFileManager* fm = [NSFileManager defaultManager];
+	NSURL* storeURL = [self externalStoreURL];
+	NSURL* blobURL = [storeURL URLByAppendingPathComponent:hash];
+
+	if ([fm fileExistsAtPath:[blobURL path]])
+		return YES;
+
+	NSError* error = nil;
+
+	if (![fm createDirectoryAtURL:storeURL
+		  withIntermediateDirectories:YES
+						   attributes:nil
+								error:&error]) {
+		LogEvent_(kWheneverEvent, @"unable to create image store directory %@: %@", storeURL, error);
+		return NO;
+	}
+
+	if (![data writeToURL:blobURL
+				  options:NSDataWritingAtomic
+					error:&error]) {
+		LogEvent_(kWheneverEvent, @"unable to write image store blob %@: %@", blobURL, error);
+		return NO;
+	}
+
+	return YES;
+}
+
+#pragma mark -
+
+// the primitive accessors are serialized so that key registration and lookup are safe when layers are dearchived on
+// several workers at once (see +[DKDrawing drawingWithChunkedData:]). Compound operations such as -makeImageWithData:key:
+// are not atomic overall, but the decode workers only ever look up keys and mark them in use.
+
 - (NSData*)imageDataForKey:(NSString*)key
 {
-	return [mRepository objectForKey:key];
+	@synchronized(self) {
+		NSData* data = [mRepository objectForKey:key];
+
+		if (data == nil) {
+			// the data may live in the external store - if so, map it in now. This is the only point at
+			// which a store-backed document actually touches image bytes.
+
+			NSString* hash = [mExternalRefs objectForKey:key];
+
+			if (hash != nil) {
+				data = [[self class] mappedStoreDataForHash:hash];
+
+				if (data != nil) {
+					[mRepository setObject:data
+									forKey:key];
+					[mHashList setObject:key
+								  forKey:[data hash64String]];
+				}
+			}
+		}
+
+		return data;
+	}
 }
 
 - (void)setImageData:(NSData*)imageData forKey:(NSString*)key
@@ -32,24 +222,41 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 
 	//NSLog(@"%@ set data (%d bytes), key = %@", self, [imageData length], key);
 
-	[mRepository setObject:imageData
-					forKey:key];
-	[mHashList setObject:key
-				  forKey:[imageData checksumString]];
+	@synchronized(self) {
+		[mRepository setObject:imageData
+						forKey:key];
+		[mHashList setObject:key
+					  forKey:[imageData hash64String]];
+	}
+
+	// any decoded representations of data previously held under this key are now stale
+
+	[mThumbnailCache removeAllObjects];
 }
 
 - (BOOL)hasImageDataForKey:(NSString*)key
 {
-	return ([mRepository objectForKey:key] != nil);
+	@synchronized(self) {
+		return ([mRepository objectForKey:key] != nil || [mExternalRefs objectForKey:key] != nil);
+	}
 }
 
 - (NSString*)keyForImageData:(NSData*)imageData
 {
-	// if the imagedata is known to the repository, its key is returned, otherwise nil.
+	// if the imagedata is known to the repository, its key is returned, otherwise nil. The hash index makes this a
+	// single lookup regardless of how many images are stored; a hit is confirmed against the stored bytes so that a
+	// hash collision can never alias two different images to one key.
 
-	if (imageData)
-		return [mHashList objectForKey:[imageData checksumString]];
-	else
+	if (imageData) {
+		@synchronized(self) {
+			NSString* key = [mHashList objectForKey:[imageData hash64String]];
+
+			if (key && ![[mRepository objectForKey:key] isEqualToData:imageData])
+				key = nil;
+
+			return key;
+		}
+	} else
 		return nil;
 }
 
@@ -60,21 +267,37 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 
 - (NSArray*)allKeys
 {
-	return [mRepository allKeys];
+	@synchronized(self) {
+		if ([mExternalRefs count] == 0)
+			return [mRepository allKeys];
+
+		NSMutableSet<NSString*>* keys = [NSMutableSet setWithArray:[mRepository allKeys]];
+		[keys addObjectsFromArray:[mExternalRefs allKeys]];
+
+		return [keys allObjects];
+	}
 }
 
 - (void)removeKey:(NSString*)key
 {
 	// removes the key and all data associated with it
 
-	NSData* data = [self imageDataForKey:key];
+	@synchronized(self) {
+		NSData* data = [mRepository objectForKey:key];
 
-	if (data) {
-		NSString* cs = [data checksumString];
-		[mHashList removeObjectForKey:cs];
+		if (data) {
+			NSString* cs = [data hash64String];
+			[mHashList removeObjectForKey:cs];
+		}
+
+		[mRepository removeObjectForKey:key];
+
+		// the store blob, if any, is left alone - other documents may reference it
+
+		[mExternalRefs removeObjectForKey:key];
 	}
 
-	[mRepository removeObjectForKey:key];
+	[mThumbnailCache removeAllObjects];
 }
 
 - (NSImage*)makeImageWithData:(NSData*)imageData key:(NSString**)key
@@ -169,30 +392,183 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 		return nil;
 }
 
-- (void)setKey:(NSString*)key isInUse:(BOOL)inUse
+#pragma mark -
+
+- (NSString*)thumbnailCacheKeyForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize
+{
+	return [NSString stringWithFormat:@"%@:%lu", key, (unsigned long)maxPixelSize];
+}
+
+- (NSImage*)thumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize
 {
-	if ([self hasImageDataForKey:key]) {
-		NSInteger useCount = [[mKeyUsage objectForKey:key] integerValue];
+	NSImage* image = [self cachedThumbnailImageForKey:key
+									  maximumPixelSize:maxPixelSize];
+
+	if (image)
+		return image;
 
-		if (inUse) {
-			++useCount;
-		} else {
-			--useCount;
+	NSData* data = [self imageDataForKey:key];
+
+	if (data == nil)
+		return nil;
+
+	image = dkDecodeThumbnail(data, maxPixelSize);
+
+	if (image) {
+		// the cache cost is the approximate bitmap footprint, so eviction discards the biggest wins first
+
+		NSSize isize = [image size];
+		[mThumbnailCache setObject:image
+							forKey:[self thumbnailCacheKeyForKey:key
+												maximumPixelSize:maxPixelSize]
+							  cost:(NSUInteger)(isize.width * isize.height * 4.0)];
+	}
+
+	return image;
+}
+
+- (NSImage*)cachedThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize
+{
+	if (key == nil)
+		return nil;
+
+	return [mThumbnailCache objectForKey:[self thumbnailCacheKeyForKey:key
+													  maximumPixelSize:maxPixelSize]];
+}
+
+- (void)requestThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize completion:(void (^)(NSImage*))completion
+{
+	[self requestThumbnailImageForKey:key
+					 maximumPixelSize:maxPixelSize
+							 priority:kDKImageDecodePriorityNormal
+						   completion:completion];
+}
+
+- (id)requestThumbnailImageForKey:(NSString*)key maximumPixelSize:(NSUInteger)maxPixelSize priority:(DKImageDecodePriority)priority completion:(void (^)(NSImage*))completion
+{
+	NSAssert(completion != nil, @"completion block was nil");
+
+	NSImage* cached = [self cachedThumbnailImageForKey:key
+									  maximumPixelSize:maxPixelSize];
+	NSData* data = cached ? nil : [self imageDataForKey:key];
+
+	if (cached != nil || data == nil) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completion(cached);
+		});
+		return nil;
+	}
+
+	DKImageDecodeRequest* req = [[DKImageDecodeRequest alloc] init];
+
+	req.key = key;
+	req.maxPixelSize = maxPixelSize;
+	req.priority = priority;
+	req.completion = completion;
+
+	@synchronized(self) {
+		// keep the queue ordered highest priority first; first-come first-served within a priority
+
+		NSUInteger indx = 0;
+
+		for (DKImageDecodeRequest* pending in mPendingDecodes) {
+			if (pending.priority < priority)
+				break;
+			++indx;
 		}
 
-		// protect against over-decrementing
+		[mPendingDecodes insertObject:req
+							  atIndex:indx];
+	}
+
+	[self pumpDecodeQueue];
+
+	return req;
+}
+
+- (void)cancelThumbnailRequest:(id)token
+{
+	if (![token isKindOfClass:[DKImageDecodeRequest class]])
+		return;
 
-		if (useCount < 0)
-			useCount = 0;
+	DKImageDecodeRequest* req = (DKImageDecodeRequest*)token;
 
-		[mKeyUsage setObject:@(useCount)
-					  forKey:key];
+	req.cancelled = YES;
+
+	@synchronized(self) {
+		[mPendingDecodes removeObjectIdenticalTo:req];
+	}
+}
+
+- (void)pumpDecodeQueue
+{
+	// starts as many queued decodes as the worker limit allows. The limit bounds both CPU
+	// oversubscription and peak memory - each decode in flight holds a full bitmap.
+
+	@synchronized(self) {
+		while (mActiveDecodeCount < mDecodeWorkerLimit && [mPendingDecodes count] > 0) {
+			DKImageDecodeRequest* req = [mPendingDecodes firstObject];
+
+			[mPendingDecodes removeObjectAtIndex:0];
+			++mActiveDecodeCount;
+
+			dispatch_async(mDecodeQueue, ^{
+				NSImage* image = nil;
+
+				if (!req.cancelled) {
+					// a concurrent request for the same representation may have beaten us to it
+
+					image = [self cachedThumbnailImageForKey:req.key
+											maximumPixelSize:req.maxPixelSize];
+
+					if (image == nil)
+						image = [self thumbnailImageForKey:req.key
+										  maximumPixelSize:req.maxPixelSize];
+				}
+
+				dispatch_async(dispatch_get_main_queue(), ^{
+					@synchronized(self) {
+						--mActiveDecodeCount;
+					}
+
+					if (!req.cancelled)
+						req.completion(image);
+
+					[self pumpDecodeQueue];
+				});
+			});
+		}
+	}
+}
+
+- (void)setKey:(NSString*)key isInUse:(BOOL)inUse
+{
+	@synchronized(self) {
+		if ([mRepository objectForKey:key] != nil || [mExternalRefs objectForKey:key] != nil) {
+			NSInteger useCount = [[mKeyUsage objectForKey:key] integerValue];
+
+			if (inUse) {
+				++useCount;
+			} else {
+				--useCount;
+			}
+
+			// protect against over-decrementing
+
+			if (useCount < 0)
+				useCount = 0;
+
+			[mKeyUsage setObject:@(useCount)
+						  forKey:key];
+		}
 	}
 }
 
 - (BOOL)keyIsInUse:(NSString*)key
 {
-	return [[mKeyUsage objectForKey:key] integerValue] > 0;
+	@synchronized(self) {
+		return [[mKeyUsage objectForKey:key] integerValue] > 0;
+	}
 }
 
 - (void)removeUnusedData
@@ -215,7 +591,7 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 	for (NSString* key in mRepository) {
 		NSData* data = [mRepository objectForKey:key];
 		[mHashList setObject:key
-					  forKey:[data checksumString]];
+					  forKey:[data hash64String]];
 	}
 }
 
@@ -228,21 +604,116 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 		mRepository = [[NSMutableDictionary alloc] init];
 		mHashList = [[NSMutableDictionary alloc] init];
 		mKeyUsage = [[NSMutableDictionary alloc] init];
+		mExternalRefs = [[NSMutableDictionary alloc] init];
+
+		[self setUpThumbnailCache];
 	}
 
 	return self;
 }
 
+- (void)setUpThumbnailCache
+{
+	mThumbnailCache = [[NSCache alloc] init];
+	[mThumbnailCache setName:@"DKImageDataManager thumbnails"];
+
+	mDecodeQueue = dispatch_queue_create("net.apptree.drawkit.imagedecode", DISPATCH_QUEUE_CONCURRENT);
+	mPendingDecodes = [[NSMutableArray alloc] init];
+
+	// decodes are memory-heavy as well as CPU-heavy (each one holds a full bitmap while it runs),
+	// so the worker limit is a fraction of the cores rather than all of them.
+
+	NSUInteger cores = (NSUInteger)[[NSProcessInfo processInfo] activeProcessorCount];
+	mDecodeWorkerLimit = MAX(2u, MIN(4u, cores / 2));
+
+	// decoded representations are only ever a cache over the compressed data, so they can all be
+	// thrown away when the system comes under memory pressure and re-decoded on demand.
+
+	mMemoryPressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+		DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL, dispatch_get_main_queue());
+
+	NSCache* cache = mThumbnailCache;
+	dispatch_source_set_event_handler(mMemoryPressureSource, ^{
+		[cache removeAllObjects];
+	});
+	dispatch_resume(mMemoryPressureSource);
+}
+
+- (void)dealloc
+{
+	if (mMemoryPressureSource)
+		dispatch_source_cancel(mMemoryPressureSource);
+}
+
 - (void)encodeWithCoder:(NSCoder*)coder
 {
-	[coder encodeObject:mRepository
-				 forKey:@"DKImageDataManager_repo"];
+	if ([[self class] externalStoreEnabled]) {
+		// each image's data goes to the content-addressed store and the archive records only key -> hash.
+		// Data that is already store-backed and has never been resolved is passed through by hash alone,
+		// without its bytes ever being read. Anything that fails to externalize is embedded as before.
+
+		NSMutableDictionary<NSString*, NSString*>* refs = [[NSMutableDictionary alloc] init];
+		NSMutableDictionary<NSString*, NSData*>* embedded = [[NSMutableDictionary alloc] init];
+
+		@synchronized(self) {
+			[mExternalRefs enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSString* hash, BOOL* stop) {
+#pragma unused(stop)
+				[refs setObject:hash
+						 forKey:key];
+			}];
+
+			[mRepository enumerateKeysAndObjectsUsingBlock:^(NSString* key, NSData* data, BOOL* stop) {
+#pragma unused(stop)
+				if ([refs objectForKey:key] != nil)
+					return;
+
+				NSString* hash = [data sha256String];
+
+				if ([[self class] writeData:data
+							 toStoreForHash:hash])
+					[refs setObject:hash
+							 forKey:key];
+				else
+					[embedded setObject:data
+								 forKey:key];
+			}];
+		}
+
+		[coder encodeObject:embedded
+					 forKey:@"DKImageDataManager_repo"];
+		[coder encodeObject:refs
+					 forKey:@"DKImageDataManager_externalRefs"];
+	} else {
+		// embedding everything - store-backed images must be materialized first so the archive is self-contained
+
+		@synchronized(self) {
+			for (NSString* key in [mExternalRefs allKeys]) {
+				if ([mRepository objectForKey:key] == nil)
+					[self imageDataForKey:key];
+			}
+		}
+
+		[coder encodeObject:mRepository
+					 forKey:@"DKImageDataManager_repo"];
+	}
 }
 
 - (instancetype)initWithCoder:(NSCoder*)coder
 {
 	if (self = [super init]) {
 		mRepository = [[coder decodeObjectForKey:@"DKImageDataManager_repo"] mutableCopy];
+
+		if (mRepository == nil)
+			mRepository = [[NSMutableDictionary alloc] init];
+
+		// store-backed images dearchive as key -> hash references only; their data is mapped in lazily by
+		// -imageDataForKey: the first time each image is needed.
+
+		mExternalRefs = [[coder decodeObjectForKey:@"DKImageDataManager_externalRefs"] mutableCopy];
+
+		if (mExternalRefs == nil)
+			mExternalRefs = [[NSMutableDictionary alloc] init];
+
 		mHashList = [[NSMutableDictionary alloc] init];
 
 		// hash list is built from repository, so there is no need to archive it.
@@ -253,6 +724,8 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 
 		mKeyUsage = [[NSMutableDictionary alloc] init];
 
+		[self setUpThumbnailCache];
+
 		// if the coder can keep a note of the image manager, set it to self (on the basis that only one image manager should
 		// exist per archive, therefore this must be it)
 
@@ -295,4 +768,40 @@ NSString* const kDKImageDataManagerPasteboardType = @"net.apptree.drawkit.imgdat
 	return [NSString stringWithFormat:@"%ld", (long)[self checksum]];
 }
 
+- (uint64_t)hash64
+{
+	// FNV-1a over the whole data. Unlike -checksum this covers every byte, so images differing only beyond the first
+	// kilobyte (common with similar photographs) do not collide in practice.
+
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	const unsigned char* p = (const unsigned char*)[self bytes];
+	NSUInteger bc = [self length];
+
+	while (bc--) {
+		hash ^= *p++;
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+- (NSString*)hash64String
+{
+	return [NSString stringWithFormat:@"%llx", (unsigned long long)[self hash64]];
+}
+
+- (NSString*)sha256String
+{
+	unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+
+	CC_SHA256([self bytes], (CC_LONG)[self length], digest);
+
+	NSMutableString* hex = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+
+	for (NSInteger i = 0; i < CC_SHA256_DIGEST_LENGTH; ++i)
+		[hex appendFormat:@"%02x", digest[i]];
+
+	return hex;
+}
+
 @end
@@ -35,6 +35,10 @@ typedef NS_OPTIONS(NSInteger, DKImageCroppingOptions) {
  the data is maintained, and that data is the original compressed data from the file (if it did come from a file). This data sharing is
  facilitated by a central DKImageDataManager object, which is managed by the drawing. Note that using certian operations, such as creating
  the shape with an NSImage will bypass this benefit.
+
+ Where the data is managed in this way the bitmap itself is also decoded lazily - drawing uses a representation no larger than the view
+ can actually show, higher resolutions are decoded asynchronously as the view zooms in, and decoded representations can be discarded
+ under memory pressure and recreated on demand. Only the compressed data is kept resident per image.
 */
 @interface DKImageShape : DKDrawableShape <NSCoding, NSCopying, DKHotspotDelegate> {
 @private
@@ -48,6 +52,9 @@ typedef NS_OPTIONS(NSInteger, DKImageCroppingOptions) {
 	DKImageCroppingOptions mImageCropping; // whether the image is scaled or cropped to the bounds
 	NSInteger mImageOffsetPartcode; // the partcode of the image offset hotspot
 	NSData* mOriginalImageData; // original image data (shared with image manager)
+	NSSize mImageSize; // the image's original size, known without decoding the bitmap
+	BOOL mThumbnailUpgradePending; // YES while an async decode of a higher-resolution representation is in flight
+	id mThumbnailRequestToken; // cancellation token for the in-flight decode, if any
 }
 
 + (DKStyle*)imageShapeDefaultStyle;
@@ -86,7 +93,8 @@ typedef NS_OPTIONS(NSInteger, DKImageCroppingOptions) {
 
 /** @brief Sets the object's image
 
- The shape's path, size, angle, etc. are not changed by this method
+ The shape's path, size, angle, etc. are not changed by this method. Note that where the shape was
+ created from data, the getter decodes the full-resolution image on demand - drawing does not use it.
  */
 @property (nonatomic, retain) NSImage* image;
 
@@ -10,13 +10,20 @@
 #import "DKDrawableShape+Hotspots.h"
 #import "DKDrawing.h"
 #import "DKImageDataManager.h"
+#import "DKKeyedArchiver.h"
 #import "DKKeyedUnarchiver.h"
+#import "DKDrawingView.h"
 #import "DKObjectOwnerLayer.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
 
+#import <ImageIO/ImageIO.h>
+
 #pragma mark Constants
 
+#define kDKImageShapeMinimumThumbnailSize 128 // smallest representation ever decoded, in pixels
+#define kDKImageShapeMaximumThumbnailSize 16384
+
 NSString* const kDKOriginalFileMetadataKey = @"dk_original_file";
 NSString* const kDKOriginalImageDimensionsMetadataKey = @"dk_image_original_dims";
 NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
@@ -38,6 +45,14 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 - (NSAffineTransform*)imageTransformWithoutLocation;
 - (NSAffineTransform*)imageTransform;
 
+/** @brief Return the image's original size without forcing the full bitmap to be decoded
+ */
+- (NSSize)imageSize;
+
+/** @brief Return the image to draw right now, which may be a downsampled representation
+ */
+- (NSImage*)imageForCurrentScale;
+
 /** @brief Draw the image applying all of the shape's settings
  */
 - (void)drawImage;
@@ -218,6 +233,7 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 											object:[self image]];
 
 		m_image = anImage;
+		mImageSize = [anImage size];
 
 		[m_image setCacheMode:NSImageCacheNever];
 		[m_image recache];
@@ -234,7 +250,22 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 	}
 }
 
-@synthesize image = m_image;
+/** @brief Returns the object's image at full resolution
+
+ Where the shape was created from data the full bitmap is decoded here on demand - drawing itself
+ goes through -imageForCurrentScale instead, so this typically only runs when the image is exported,
+ copied to the pasteboard or otherwise needed at its native size.
+ @return the image
+ */
+- (NSImage*)image
+{
+	if (m_image == nil && [self imageData] != nil) {
+		m_image = [[NSImage alloc] initWithData:[self imageData]];
+		[m_image setCacheMode:NSImageCacheNever];
+	}
+
+	return m_image;
+}
 
 /** @brief Get a copy of the object's image scaled to the same size, angle and aspect ratio as the image drawn
 
@@ -603,6 +634,121 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 
 #pragma mark -
 
+- (NSSize)imageSize
+{
+	if (m_image)
+		return [m_image size];
+
+	if (mImageSize.width <= 0.0 || mImageSize.height <= 0.0) {
+		// first try the size recorded in the metadata when the image was set. Failing that, read it
+		// from the compressed data's properties, which does not decode any pixels.
+
+		mImageSize = [self sizeForKey:kDKOriginalImageDimensionsMetadataKey];
+
+		NSData* data;
+
+		if ((mImageSize.width <= 0.0 || mImageSize.height <= 0.0) && (data = [self imageData]) != nil) {
+			CGImageSourceRef src = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+
+			if (src) {
+				NSDictionary* props = CFBridgingRelease(CGImageSourceCopyPropertiesAtIndex(src, 0, NULL));
+
+				mImageSize.width = [[props objectForKey:(NSString*)kCGImagePropertyPixelWidth] doubleValue];
+				mImageSize.height = [[props objectForKey:(NSString*)kCGImagePropertyPixelHeight] doubleValue];
+				CFRelease(src);
+			}
+		}
+
+		// last resort - decode the image itself
+
+		if (mImageSize.width <= 0.0 || mImageSize.height <= 0.0)
+			mImageSize = [[self image] size];
+	}
+
+	return mImageSize;
+}
+
+- (NSImage*)imageForCurrentScale
+{
+	// returns the image to draw right now. Where the image lives in the image manager this is a
+	// representation decoded at no more than the resolution the view can actually show; a larger
+	// representation needed after zooming in is decoded asynchronously and the object refreshed
+	// when it arrives, drawing whatever is already decoded in the meantime.
+
+	if (m_image != nil)
+		return m_image; // already fully decoded
+
+	NSString* key = [self imageKey];
+	DKImageDataManager* dm = [[self container] imageManager];
+
+	if (key == nil || dm == nil || ![dm hasImageDataForKey:key])
+		return [self image]; // not managed - decode in full
+
+	// the largest dimension the image can occupy on screen, in pixels
+
+	CGFloat viewScale = 1.0;
+	NSView* view = [self currentView];
+
+	if ([view isKindOfClass:[DKDrawingView class]])
+		viewScale = [(DKDrawingView*)view scale];
+
+	NSSize destSize = ([self imageCroppingOptions] == kDKImageScaleToPath) ? [self size] : [self imageSize];
+	CGFloat maxDim = MAX(destSize.width, destSize.height) * viewScale;
+
+	// quantize up to the next power of two so a continuous zoom reuses cached representations
+
+	NSUInteger maxPx = kDKImageShapeMinimumThumbnailSize;
+
+	while ((CGFloat)maxPx < maxDim && maxPx < kDKImageShapeMaximumThumbnailSize)
+		maxPx <<= 1;
+
+	NSImage* image = [dm cachedThumbnailImageForKey:key
+								   maximumPixelSize:maxPx];
+
+	if (image == nil) {
+		// nothing decoded at this size yet. If a smaller representation is already cached, draw that
+		// and upgrade asynchronously so zooming in never stalls on a large decode.
+
+		NSUInteger px = maxPx;
+
+		while (image == nil && (px >>= 1) >= kDKImageShapeMinimumThumbnailSize)
+			image = [dm cachedThumbnailImageForKey:key
+								  maximumPixelSize:px];
+
+		if (image != nil) {
+			if (!mThumbnailUpgradePending) {
+				mThumbnailUpgradePending = YES;
+
+				// decode at high priority when the shape is in the viewport, low when the request
+				// is speculative (e.g. triggered by the view's cache prefetch)
+
+				DKRenderState rs = [DKDrawingView currentRenderState];
+				DKImageDecodePriority priority = kDKImageDecodePriorityNormal;
+
+				if (!NSIsEmptyRect(rs.visibleRect))
+					priority = NSIntersectsRect([self bounds], rs.visibleRect) ? kDKImageDecodePriorityHigh : kDKImageDecodePriorityLow;
+
+				mThumbnailRequestToken = [dm requestThumbnailImageForKey:key
+														maximumPixelSize:maxPx
+																priority:priority
+															  completion:^(NSImage* decoded) {
+#pragma unused(decoded)
+																  mThumbnailUpgradePending = NO;
+																  mThumbnailRequestToken = nil;
+																  [self notifyVisualChange];
+															  }];
+			}
+		} else {
+			// first draw - decode synchronously at the displayed resolution
+
+			image = [dm thumbnailImageForKey:key
+							maximumPixelSize:maxPx];
+		}
+	}
+
+	return image ? image : [self image];
+}
+
 - (void)drawImage
 {
 	// the image must be transformed to the object's scale, rotation and position. This is achieved by concatenating the transform
@@ -620,7 +766,7 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 
 	NSRect ir;
 
-	ir.size = [[self image] size];
+	ir.size = [self imageSize];
 
 	if ([self imageCroppingOptions] == kDKImageScaleToPath) {
 		ir.origin.x = m_imageOffset.x - (ir.size.width / 2.0);
@@ -635,12 +781,12 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 	[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationHigh];
 	//[[self image] setFlipped:[[NSGraphicsContext currentContext] isFlipped]];
 
-	[[self image] drawInRect:ir
-					fromRect:NSZeroRect
-				   operation:[self compositingOperation]
-					fraction:[self imageOpacity]
-			  respectFlipped:YES
-					   hints:nil];
+	[[self imageForCurrentScale] drawInRect:ir
+								   fromRect:NSZeroRect
+								  operation:[self compositingOperation]
+								   fraction:[self imageOpacity]
+							 respectFlipped:YES
+									  hints:nil];
 
 	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 }
@@ -664,7 +810,7 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 
 - (NSAffineTransform*)imageTransformWithoutLocation
 {
-	NSSize si = [[self image] size];
+	NSSize si = [self imageSize];
 	NSSize sc = [self size];
 	CGFloat sx, sy;
 
@@ -772,7 +918,7 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 	if ([self imageCroppingOptions] == kDKImageScaleToPath) {
 		[self setImageOffset:NSZeroPoint];
 
-		NSSize is = [[self image] size];
+		NSSize is = [self imageSize];
 
 		is.width *= [self imageScale];
 		is.height *= [self imageScale];
@@ -790,7 +936,7 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 		// reset any offset to the centre
 
 		[self setOffset:NSZeroSize];
-		[self setSize:[[self image] size]];
+		[self setSize:[self imageSize]];
 		[self setImageOffset:NSZeroPoint];
 
 		// the rotation isn't reset - take it into account
@@ -869,6 +1015,19 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 	[super setContainer:container];
 }
 
+- (void)objectWasRemovedFromLayer:(DKObjectOwnerLayer*)aLayer
+{
+	// a decode requested for this shape is no longer wanted - free its queue slot for visible content
+
+	if (mThumbnailRequestToken != nil) {
+		[[[self drawing] imageManager] cancelThumbnailRequest:mThumbnailRequestToken];
+		mThumbnailRequestToken = nil;
+		mThumbnailUpgradePending = NO;
+	}
+
+	[super objectWasRemovedFromLayer:aLayer];
+}
+
 #pragma mark -
 #pragma mark As an NSObject
 
@@ -917,8 +1076,8 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 		[hs setRelativeLocation:p];
 		[self notifyVisualChange];
 
-		offset.x = p.x * [[self image] size].width;
-		offset.y = p.y * [[self image] size].height;
+		offset.x = p.x * [self imageSize].width;
+		offset.y = p.y * [self imageSize].height;
 		[self setImageOffset:offset];
 	}
 }
@@ -971,8 +1130,18 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 	if (mImageKey) {
 		[coder encodeObject:[self imageKey]
 					 forKey:@"DKImageShape_imageKey"];
-		[coder encodeObject:[self imageData]
-					 forKey:@"DKImageShape_imageData"];
+
+		// when archiving to the chunked container format the image data is written separately by the drawing, so it can
+		// be left out here provided the archiver's image manager really holds it - the key alone recovers it on load.
+
+		BOOL externalised = NO;
+
+		if ([coder respondsToSelector:@selector(externalizesImageData)])
+			externalised = [(DKKeyedArchiver*)coder externalizesImageData] && [[(DKKeyedArchiver*)coder imageManager] hasImageDataForKey:[self imageKey]];
+
+		if (!externalised)
+			[coder encodeObject:[self imageData]
+						 forKey:@"DKImageShape_imageData"];
 	} else
 		[coder encodeObject:[self image]
 					 forKey:@"image"];
@@ -1009,9 +1178,17 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 
 			NSData* imgData = [coder decodeObjectForKey:@"DKImageShape_imageData"];
 
-			if (imgData)
-				[self setImageData:imgData];
-			else {
+			if (imgData == nil && [coder respondsToSelector:@selector(imageManager)])
+				imgData = [[(DKKeyedUnarchiver*)coder imageManager] imageDataForKey:imKey];
+
+			if (imgData) {
+				// only the compressed data is kept - the bitmap is not decoded here. The first draw
+				// decodes a representation no larger than the view needs (see -imageForCurrentScale)
+				// and -image expands the full image only if someone actually asks for it.
+
+				mOriginalImageData = imgData;
+				mImageKey = [imKey copy];
+			} else {
 				// older method: create image from original data in the master cache & store the key
 
 				[self setImageWithKey:imKey
@@ -1042,9 +1219,16 @@ NSString* const kDKOriginalNameMetadataKey = @"dk_original_name";
 {
 	DKImageShape* copy = [super copyWithZone:zone];
 
-	if ([self imageData])
-		[copy setImageData:[self imageData]];
-	else {
+	if ([self imageData]) {
+		// transfer the data reference, key and any decoded image directly - duplicating an image
+		// shape never touches the pixels. When the copy gains a container the key and data are
+		// consolidated with its image manager as usual.
+
+		copy->mOriginalImageData = mOriginalImageData;
+		copy->mImageKey = [mImageKey copy];
+		copy->m_image = m_image;
+		copy->mImageSize = mImageSize;
+	} else {
 		[copy setImage:[self image]];
 		[copy setImageKey:[self imageKey]];
 	}
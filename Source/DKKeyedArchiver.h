@@ -0,0 +1,36 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+@class DKImageDataManager;
+@class DKLayerGroup;
+
+/** @brief This class works identically to NSKeyedArchiver in every way, except that it can store a reference to the drawing's \c DKImageDataManager instance.
+
+ It is the archiving counterpart of DKKeyedUnarchiver. When \c externalizesImageData is set, image-using objects such as DKImageShape
+ that would normally embed a copy of their original image data in the archive may omit it, encoding only their image key. The caller is
+ then responsible for storing the image manager's data alongside the archive - see -[DKDrawing chunkedDrawingData], which writes it as
+ separate chunks of the container file so that a reader can map them lazily.
+*/
+@interface DKKeyedArchiver : NSKeyedArchiver {
+@private
+	DKImageDataManager* __unsafe_unretained mImageManagerRef;
+	DKLayerGroup* __unsafe_unretained mDeferredLayerGroupRef;
+	BOOL mExternalizesImageData;
+}
+
+// not retained because we know that it's retained by the drawing and the lifetime of the archiver is limited.
+@property (unsafe_unretained, nullable) DKImageDataManager* imageManager;
+
+// when set, image-using objects may leave their embedded image data out of the archive, encoding only their image keys
+@property BOOL externalizesImageData;
+
+// the layer group (normally the drawing itself) whose top-level layers are written as separate chunks rather than as part
+// of the object graph, allowing them to be dearchived in parallel. Nested groups archive their layers normally.
+@property (unsafe_unretained, nullable) DKLayerGroup* deferredLayerGroup;
+
+@end
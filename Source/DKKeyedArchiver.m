@@ -0,0 +1,14 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKKeyedArchiver.h"
+
+@implementation DKKeyedArchiver
+@synthesize imageManager = mImageManagerRef;
+@synthesize externalizesImageData = mExternalizesImageData;
+@synthesize deferredLayerGroup = mDeferredLayerGroupRef;
+
+@end
@@ -88,6 +88,20 @@ might include the shape of a knob, its colours, whether stroked or filled or bot
 - (DKHandle*)handleForType:(DKKnobType)knobType colour:(nullable NSColor*)colour;
 @property (readonly) NSSize actualHandleSize;
 
+/** @brief screen size in points below which an object's selection handles are decimated (not drawn)
+
+ When an object's largest dimension as drawn on screen falls below this value, the drawables' selection
+ drawing skips the handles and shows just the selection path. With many small selected objects the handles
+ otherwise dominate drawing time while completely obscuring the objects. The default is 6; a value of 0
+ disables decimation.
+*/
+@property (class) CGFloat handleDecimationThreshold;
+
+/** @brief Whether selection handles should be drawn for an object of the given size
+ @param size the object's size in drawing units
+ @return \c NO when handle decimation applies at the current drawing scale */
+- (BOOL)shouldDrawHandlesForObjectOfSize:(NSSize)size;
+
 @end
 
 #pragma mark -
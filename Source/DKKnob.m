@@ -21,6 +21,7 @@ static NSColor* sOffPointColour = nil;
 static NSColor* sBarColour = nil;
 static CGFloat sBarWidth = 0.0;
 static NSSize sKnobSize = { 6.0, 6.0 };
+static CGFloat sDecimationThreshold = 6.0;
 
 @implementation DKKnob
 #pragma mark As a DKKnob
@@ -31,6 +32,16 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 	return [[DKKnob alloc] init];
 }
 
++ (CGFloat)handleDecimationThreshold
+{
+	return sDecimationThreshold;
+}
+
++ (void)setHandleDecimationThreshold:(CGFloat)threshold
+{
+	sDecimationThreshold = threshold;
+}
+
 #pragma mark -
 #pragma mark - main high - level methods will be called by clients
 - (void)setOwner:(id<DKKnobOwner>)owner
@@ -407,6 +418,29 @@ static NSSize sKnobSize = { 6.0, 6.0 };
 							colour:colour];
 }
 
+- (BOOL)shouldDrawHandlesForObjectOfSize:(NSSize)size
+{
+	// returns whether selection handles should be drawn at all for an object of the given size at the
+	// current drawing scale. Below the decimation threshold only the selection path is worth drawing -
+	// handles would obscure the object entirely while costing the bulk of the selection drawing time.
+
+	CGFloat threshold = [[self class] handleDecimationThreshold];
+
+	if (threshold <= 0.0)
+		return YES;
+
+	CGFloat scale = 1.0;
+
+	if ([self owner] != nil) {
+		scale = [[self owner] knobsWantDrawingScale];
+
+		if (scale <= 0.0)
+			scale = 1.0;
+	}
+
+	return (MAX(size.width, size.height) * scale) >= threshold;
+}
+
 - (NSSize)actualHandleSize
 {
 	// the size of the handle as it is actually drawn to hte screen, taking into account all the scale factors, etc.
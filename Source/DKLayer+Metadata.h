@@ -60,6 +60,21 @@ typedef NS_ENUM(NSInteger, DKLayerMetadataSchema) {
 - (NSSize)sizeForKey:(NSString*)key;
 
 - (void)updateMetadataKeys;
+
+/** @brief Replaces a compact metadata blob in the user info with the reconstituted items dictionary.
+
+ Called as part of <code>-updateMetadataKeys</code>. DKDrawing overrides that method without calling super
+ (its migration rules differ), so it invokes this directly instead.
+ */
+- (void)reconstituteCompactMetadata;
+
+/** @brief Returns the user info as it should be written to an archive.
+
+ When compact metadata archiving is enabled (see DKMetadataItem) and the metadata dictionary can be
+ represented, this returns a copy of the user info with the items dictionary replaced by a single compact
+ data blob. Otherwise the user info is returned unchanged.
+ */
+- (nullable NSDictionary*)userInfoForArchiving;
 @property (readonly) NSUInteger metadataChecksum;
 
 /** Subclasses that want to prevent access to metadata for a layer can override this to return NO. Controllers that provide
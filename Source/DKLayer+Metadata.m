@@ -374,6 +374,15 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKMetadataDidChangeNotification
 														object:self
 													  userInfo:userInfo];
+
+	// layer metadata never draws directly, so interested observers get just one coalesced notification
+	// per runloop turn however many keys were written
+
+	[[NSNotificationQueue defaultQueue] enqueueNotification:[NSNotification notificationWithName:kDKMetadataChangesDidOccurNotification
+																						  object:self]
+											   postingStyle:NSPostASAP
+											   coalesceMask:NSNotificationCoalescingOnName | NSNotificationCoalescingOnSender
+												   forModes:nil];
 }
 
 #pragma mark -
@@ -387,6 +396,8 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 	// Also in the 107 schema, drawing info set by DKDrawing is stored in a separate subdictionary (but not using DKMetadataItem wrappers).
 	// To deal with that, DKDrawing implements an override of this method which migrates its user info items to the drawing info subdictionary.
 
+	[self reconstituteCompactMetadata];
+
 	DKLayerMetadataSchema schema = [self schema];
 
 	if (schema == kDKLayerMetadata107Schema)
@@ -422,6 +433,51 @@ NSString* const kDKLayerMetadataUndoableChangesUserDefaultsKey = @"kDKLayerMetad
 #endif
 }
 
+- (void)reconstituteCompactMetadata
+{
+	// metadata written by the compact archiving fast path arrives as a single data blob - reconstitute the
+	// items dictionary before anything looks for it. See -userInfoForArchiving.
+
+	id stored = [self userInfoObjectForKey:kDKLayerMetadataUserInfoKey];
+
+	if ([stored isKindOfClass:[NSData class]]) {
+		NSMutableDictionary* itemDict = [DKMetadataItem metadataItemDictionaryWithCompactData:(NSData*)stored];
+
+		if (itemDict == nil) {
+			LogEvent_(kWheneverEvent, @"malformed compact metadata blob - discarding");
+			itemDict = [NSMutableDictionary dictionary];
+		}
+
+		[self setUserInfoObject:itemDict
+						 forKey:kDKLayerMetadataUserInfoKey];
+	}
+}
+
+- (NSDictionary*)userInfoForArchiving
+{
+	// returns the user info as it should be written to an archive, substituting the compact blob for the
+	// metadata items dictionary when the fast path is in force and the items can be represented.
+
+	NSDictionary* userInfo = [self userInfo];
+
+#if USE_107_OR_LATER_SCHEMA
+	NSDictionary* meta = [self metadata];
+
+	if (userInfo != nil && meta != nil && [DKMetadataItem compactArchivingEnabled]) {
+		NSData* blob = [DKMetadataItem compactDataWithMetadataItemDictionary:meta];
+
+		if (blob != nil) {
+			NSMutableDictionary* infoCopy = [userInfo mutableCopy];
+			[infoCopy setObject:blob
+						 forKey:kDKLayerMetadataUserInfoKey];
+			return infoCopy;
+		}
+	}
+#endif
+
+	return userInfo;
+}
+
 - (NSUInteger)metadataChecksum
 {
 	NSUInteger cs = 319162352; // arbitrary
@@ -50,7 +50,11 @@ NS_ASSUME_NONNULL_BEGIN
 	NSMutableDictionary* mUserInfo; // metadata
 	NSUInteger mReserved[3]; // unused
 	NSString* mLayerUniqueKey; // unique ID for the layer
+	uint64_t mLayerIntegerKey; // compact in-memory ID for the layer, not persisted
 	CGFloat mAlpha; // alpha value applied to layer as a whole
+	BOOL mCacheContent; // YES if the layer's content may be captured into a backing store and composited
+	NSImage* mContentCache; // the captured content, covering the whole drawing, or nil
+	CGFloat mContentCacheScale; // the view scale the backing store was captured at
 }
 
 /** @brief Returns the list of colours used for supplying the selection colours
@@ -262,6 +266,34 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (nonatomic) CGFloat alpha;
 
+/** @brief Hints that the layer's content changes rarely and may be composited from a backing store
+
+ When set, the enclosing group captures the layer's content into a retained bitmap the first time it is
+ drawn and composites that bitmap on subsequent frames, so scrolling or other overlapping redraws cost a
+ blit instead of a full render. The capture is taken at the current view scale (up to a sensible pixel
+ budget) and is composited with the layer's \c alpha applied, so this is also the supported way to give
+ reduced-opacity layers an actual effect. The backing store is dropped automatically whenever the layer
+ marks itself for display, when the view scale changes, and under memory pressure - it is only ever a
+ cache. Appropriate for grids, locked reference layers and similar mostly-static content; leave off
+ (the default) for layers being actively edited. Printing always renders live. The setting is saved
+ with the layer.
+ */
+@property (nonatomic) BOOL shouldCacheContent;
+
+/** @brief Discards the layer's content backing store, if any
+
+ Called automatically from the \c setNeedsDisplay family; the next draw re-captures the content. The
+ invalidation propagates to enclosing groups, since a group's own capture includes this layer's content.
+ */
+- (void)invalidateContentCache;
+
+/** @brief Composites the layer's content from its backing store, capturing it first if necessary
+
+ Called by \c DKLayerGroup in place of \c -drawRect:inView: when \c shouldCacheContent is set. Not
+ normally called by client code.
+ */
+- (void)drawContentCacheInRect:(NSRect)rect inView:(nullable DKDrawingView*)aView;
+
 // managing ruler markers:
 
 - (void)updateRulerMarkersForRect:(NSRect)rect;
@@ -330,6 +362,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, copy) NSString* uniqueKey;
 
+/** @brief Returns the layer's compact integer key
+
+ Unique within the process but not across launches and never persisted - use \c uniqueKey for
+ anything that reaches disk or the pasteboard. Intended for in-memory maps keyed by layer, where
+ boxing this is cheaper than hashing the string key.
+ */
+@property (readonly) uint64_t uniqueIntegerKey;
+
 // print this layer?
 
 /** @brief Whether the layer should be part of the printed output or not
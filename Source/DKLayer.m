@@ -26,6 +26,17 @@ NSString* const kDKLayerSelectionHighlightColourDidChange = @"kDKLayerSelectionH
 #pragma mark Static Vars
 static NSInteger sLayerIndexSeed = 4;
 
+// content backing stores are only ever caches over the layer's live content, so every layer holding one
+// registers here and they are all dropped together when the system comes under memory pressure.
+
+static NSHashTable<DKLayer*>* sContentCachedLayers = nil;
+static dispatch_source_t sContentCachePressureSource = NULL;
+
+// upper bound on the pixel area of a single layer's backing store - the capture scale is reduced to fit
+// within this when zoomed far in, trading blit sharpness for bounded memory.
+
+#define kDKContentCacheMaxPixelArea (4096.0 * 4096.0)
+
 #pragma mark -
 @implementation DKLayer
 #pragma mark As a DKLayer
@@ -243,6 +254,9 @@ static NSArray* s_selectionColours = nil;
  */
 - (void)setNeedsDisplay:(BOOL)update
 {
+	if (update)
+		[self invalidateContentCache];
+
 	[[self drawing] setNeedsDisplay:update];
 }
 
@@ -254,6 +268,7 @@ static NSArray* s_selectionColours = nil;
  */
 - (void)setNeedsDisplayInRect:(NSRect)rect
 {
+	[self invalidateContentCache];
 	[[self drawing] setNeedsDisplayInRect:rect];
 }
 
@@ -265,6 +280,7 @@ static NSArray* s_selectionColours = nil;
  */
 - (void)setNeedsDisplayInRects:(NSSet*)setOfRects
 {
+	[self invalidateContentCache];
 	[[self drawing] setNeedsDisplayInRects:setOfRects];
 }
 
@@ -277,6 +293,7 @@ static NSArray* s_selectionColours = nil;
  */
 - (void)setNeedsDisplayInRects:(NSSet*)setOfRects withExtraPadding:(NSSize)padding
 {
+	[self invalidateContentCache];
 	[[self drawing] setNeedsDisplayInRects:setOfRects
 						  withExtraPadding:padding];
 }
@@ -300,6 +317,137 @@ static NSArray* s_selectionColours = nil;
 }
 
 #pragma mark -
+#pragma mark - content backing store
+
+- (void)setShouldCacheContent:(BOOL)cache
+{
+	if (cache != mCacheContent) {
+		mCacheContent = cache;
+
+		if (!cache)
+			[self invalidateContentCache];
+	}
+}
+
+@synthesize shouldCacheContent = mCacheContent;
+
+- (void)invalidateContentCache
+{
+	mContentCache = nil;
+
+	// a group's capture includes this layer's content, so staleness propagates to the root
+
+	[[self layerGroup] invalidateContentCache];
+}
+
++ (void)registerLayerForCacheEviction:(DKLayer*)layer
+{
+	// backing stores are pure caches, so they are all dropped under memory pressure and simply
+	// re-captured on the next draw. The table holds its members weakly.
+
+	if (sContentCachedLayers == nil) {
+		sContentCachedLayers = [NSHashTable weakObjectsHashTable];
+
+		sContentCachePressureSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_MEMORYPRESSURE, 0,
+			DISPATCH_MEMORYPRESSURE_WARN | DISPATCH_MEMORYPRESSURE_CRITICAL, dispatch_get_main_queue());
+
+		dispatch_source_set_event_handler(sContentCachePressureSource, ^{
+			for (DKLayer* cachedLayer in sContentCachedLayers)
+				[cachedLayer invalidateContentCache];
+		});
+		dispatch_resume(sContentCachePressureSource);
+	}
+
+	[sContentCachedLayers addObject:layer];
+}
+
+- (void)drawContentCacheInRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+	NSSize size = [[self drawing] drawingSize];
+
+	if (size.width <= 0.0 || size.height <= 0.0)
+		return;
+
+	// capture at the view's scale so blits stay sharp when zoomed, bounded by the pixel budget
+
+	CGFloat scale = (aView != nil) ? [aView scale] : 1.0;
+
+	if (scale < 1.0)
+		scale = 1.0;
+
+	CGFloat maxScale = sqrt(kDKContentCacheMaxPixelArea / (size.width * size.height));
+
+	if (scale > maxScale)
+		scale = maxScale;
+
+	if (mContentCache == nil || scale != mContentCacheScale) {
+		NSBitmapImageRep* rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																		pixelsWide:ceil(size.width * scale)
+																		pixelsHigh:ceil(size.height * scale)
+																	 bitsPerSample:8
+																   samplesPerPixel:4
+																		  hasAlpha:YES
+																		  isPlanar:NO
+																	colorSpaceName:NSCalibratedRGBColorSpace
+																	   bytesPerRow:0
+																	  bitsPerPixel:0];
+
+		if (rep == nil)
+			return;
+
+		NSGraphicsContext* context = [NSGraphicsContext graphicsContextWithBitmapImageRep:rep];
+		[context setImageInterpolation:NSImageInterpolationHigh];
+		[context setShouldAntialias:YES];
+
+		SAVE_GRAPHICS_CONTEXT
+
+			[NSGraphicsContext setCurrentContext:context];
+
+		// the bitmap context's space is in pixels with the origin at the bottom left, so map the
+		// drawing's coordinates (possibly flipped) onto it
+
+		NSAffineTransform* tfm = [NSAffineTransform transform];
+
+		if ([[self drawing] isFlipped]) {
+			[tfm translateXBy:0
+						  yBy:size.height * scale];
+			[tfm scaleXBy:scale
+					  yBy:-scale];
+		} else
+			[tfm scaleBy:scale];
+
+		[tfm concat];
+
+		[self beginDrawing];
+		[self drawRect:NSMakeRect(0, 0, size.width, size.height)
+				inView:aView];
+		[self endDrawing];
+
+		RESTORE_GRAPHICS_CONTEXT
+
+		[rep setSize:size];
+
+		NSImage* cache = [[NSImage alloc] initWithSize:size];
+		[cache addRepresentation:rep];
+
+		mContentCache = cache;
+		mContentCacheScale = scale;
+
+		[[self class] registerLayerForCacheEviction:self];
+	}
+
+	// composite - the view's clip confines the blit to the update area, and the layer's alpha is
+	// applied here, giving reduced-opacity layers an actual effect
+
+#pragma unused(rect)
+
+	[mContentCache drawInRect:NSMakeRect(0, 0, size.width, size.height)
+					 fromRect:NSZeroRect
+					operation:NSCompositingOperationSourceOver
+					 fraction:[self alpha]
+			   respectFlipped:YES
+						hints:nil];
+}
 
 /** @brief Sets the colour preference to use for selected objects within this layer
 
@@ -562,6 +710,7 @@ static NSArray* s_selectionColours = nil;
 		[[[self undoManager] prepareWithInvocationTarget:self] setLocked:m_locked];
 		m_locked = locked;
 		[self setNeedsDisplay:YES];
+		[[self layerGroup] invalidateFlattenedStateCaches];
 		[[self drawing] invalidateCursors];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerLockStateDidChange
 															object:self];
@@ -592,6 +741,7 @@ static NSArray* s_selectionColours = nil;
 		[[[self undoManager] prepareWithInvocationTarget:self] setVisible:[self visible]];
 		m_visible = visible;
 		[self setNeedsDisplay:YES];
+		[[self layerGroup] invalidateFlattenedStateCaches];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerVisibleStateDidChange
 															object:self];
 
@@ -636,6 +786,7 @@ static NSArray* s_selectionColours = nil;
 }
 
 @synthesize uniqueKey = mLayerUniqueKey;
+@synthesize uniqueIntegerKey = mLayerIntegerKey;
 
 #pragma mark -
 
@@ -1236,6 +1387,7 @@ static NSArray* s_selectionColours = nil;
 		[self setShouldDrawToPrinter:YES];
 		[self setSelectionColour:[[self class] selectionColourForIndex:sLayerIndexSeed++]];
 		mLayerUniqueKey = [DKUniqueID uniqueKey];
+		mLayerIntegerKey = [DKUniqueID uniqueIntegerKey];
 		mRulerMarkersEnabled = YES;
 		mAlpha = 1.0;
 	}
@@ -1271,10 +1423,12 @@ static NSArray* s_selectionColours = nil;
 			   forKey:@"printed"];
 	[coder encodeBool:m_clipToInterior
 			   forKey:@"DKLayer_clipToInterior"];
-	[coder encodeObject:[self userInfo]
+	[coder encodeObject:[self userInfoForArchiving]
 				 forKey:@"DKLayer_userInfo"];
 	[coder encodeDouble:[self alpha]
 				 forKey:@"DKLayer_alpha"];
+	[coder encodeBool:mCacheContent
+			   forKey:@"DKLayer_cacheContent"];
 
 	[coder encodeBool:![self rulerMarkerUpdatesEnabled]
 			   forKey:@"DKLayer_disableRulerMarkerUpdates"];
@@ -1310,6 +1464,7 @@ static NSArray* s_selectionColours = nil;
 		[self setUserInfo:[coder decodeObjectForKey:@"DKLayer_userInfo"]];
 
 		mLayerUniqueKey = [DKUniqueID uniqueKey];
+		mLayerIntegerKey = [DKUniqueID uniqueIntegerKey];
 
 		// alpha was added in 1.0.7 - if not present, default to 1.0
 
@@ -1318,6 +1473,8 @@ static NSArray* s_selectionColours = nil;
 		else
 			mAlpha = 1.0;
 
+		mCacheContent = [coder decodeBoolForKey:@"DKLayer_cacheContent"];
+
 		[self setRulerMarkerUpdatesEnabled:![coder decodeBoolForKey:@"DKLayer_disableRulerMarkerUpdates"]];
 	}
 	return self;
@@ -1384,10 +1541,11 @@ static NSArray* s_selectionColours = nil;
 
 - (CGFloat)knobsWantDrawingScale
 {
-	// query the currently rendering view's scale and pass it back to the knobs
+	// pass the current render scale back to the knobs. This is queried per knob per object, so it
+	// reads the state captured at the start of the pass rather than the view's geometry each time
 
 	if ([self knobsShouldAdjustToViewScale])
-		return [(DKDrawingView*)[[self drawing] currentView] scale];
+		return [DKDrawingView currentRenderScale];
 	else
 		return 1.0;
 }
@@ -28,6 +28,12 @@ NS_ASSUME_NONNULL_BEGIN
 @interface DKLayerGroup : DKLayer <NSCoding> {
 @private
 	NSMutableArray<DKLayer*>* m_layers;
+	NSArray<DKLayer*>* mVisibleLayersCache; // flattened visible layers, top to bottom - see -visibleLayers
+	NSArray<DKLayer*>* mEditableLayersCache; // flattened visible, unlocked layers - see -editableLayers
+	BOOL mFlattenedStateCachesValid; // hierarchical dirty bit for the two caches above
+	NSArray<DKLayer*>* mFlattenedLayersCache; // flattened leaf layers regardless of state - see -flattenedLayers
+	NSArray<DKLayer*>* mFlattenedLayersAndGroupsCache; // as above but with the groups included
+	NSUInteger mStructureGeneration; // bumped by every structural change; detects mutation during enumeration
 }
 
 /** @brief Convenience method for building a new layer group from an existing list of layers
@@ -102,6 +108,44 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSArray<__kindof DKLayer*>*)flattenedLayersOfClass:(Class)layerClass includeGroups:(BOOL)includeGroups;
 
+/** @brief Calls \c block once for each layer in this group and every group below it, top to bottom.
+
+ @discussion Copy-free equivalent of iterating <code>-flattenedLayersIncludingGroups:</code> - the walk
+ reads the layer lists in place and allocates nothing, so it suits per-event traversal of deep
+ hierarchies. Like fast enumeration, mutating any group's layer list during the walk raises
+ <code>NSGenericException</code>; set \c *stop to \c YES to end the enumeration early.
+ @param includeGroups If <code>YES</code>, groups are passed to the block (each before its contents), \c NO passes leaf layers only.
+ @param block Called with each layer in turn.
+ */
+- (void)enumerateFlattenedLayersIncludingGroups:(BOOL)includeGroups usingBlock:(void (NS_NOESCAPE ^)(__kindof DKLayer* layer, BOOL* stop))block;
+
+/** @brief Returns all visible layers in this group and all groups below it, in top to bottom order.
+
+ @discussion The flattened list is cached with hierarchical dirty bits - visibility, lock and structure
+ changes anywhere in the subtree mark the affected group and its ancestors stale, so steady-state
+ queries (hit testing and tool target resolution on every mouse event) return the cached array
+ without walking the tree. After a localized change only the path from the changed group to the
+ root is re-walked. The returned list contains no layer groups.
+ @return A list of layers.
+ */
+- (NSArray<__kindof DKLayer*>*)visibleLayers;
+
+/** @brief Returns all visible, unlocked layers in this group and all groups below it, in top to bottom order.
+
+ @discussion Cached in the same way as <code>-visibleLayers</code>. Layers hidden or locked through an
+ ancestor group are excluded.
+ @return A list of layers.
+ */
+- (NSArray<__kindof DKLayer*>*)editableLayers;
+
+/** @brief Marks the cached flattened layer lists stale here and in all ancestor groups.
+
+ @discussion Called automatically on structure, visibility and lock changes; client code rarely
+ needs this. Propagation stops at the first group that is already stale, so repeated invalidation
+ during a batch of edits is cheap.
+ */
+- (void)invalidateFlattenedStateCaches;
+
 /** @brief Returns the hierarchical level of this group, i.e. how deeply nested it is.
 
  @discussion The root group returns 0, next level is 1 and so on.
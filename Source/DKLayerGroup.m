@@ -7,6 +7,7 @@
 #import "DKLayerGroup.h"
 #import "DKDrawKitMacros.h"
 #import "DKDrawing.h"
+#import "DKKeyedArchiver.h"
 #import "LogEvent.h"
 
 #pragma mark Constants(Non - localized)
@@ -87,6 +88,8 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 
 		[m_layers makeObjectsPerformSelector:@selector(setLayerGroup:)
 								  withObject:self];
+		[self invalidateFlattenedStateCaches];
+		[self noteStructuralChange];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerGroupNumberOfLayersDidChange
 															object:self];
 	}
@@ -147,19 +150,34 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
  */
 - (NSArray*)flattenedLayersIncludingGroups:(BOOL)includeGroups
 {
+	// structure-only flattening is cached until a structural change anywhere in the subtree -
+	// subgroups keep their own sublists, so a localized change only re-walks the path to the root
+
+	NSArray* cached = includeGroups ? mFlattenedLayersAndGroupsCache : mFlattenedLayersCache;
+
+	if (cached != nil)
+		return cached;
+
 	NSMutableArray* fLayers = [NSMutableArray array];
 
 	if (includeGroups)
 		[fLayers addObject:self];
 
-	for (DKLayer* layer in [self layers]) {
+	for (DKLayer* layer in m_layers) {
 		if ([layer respondsToSelector:_cmd])
 			[fLayers addObjectsFromArray:[(DKLayerGroup*)layer flattenedLayersIncludingGroups:includeGroups]];
 		else
 			[fLayers addObject:layer];
 	}
 
-	return fLayers;
+	cached = [fLayers copy];
+
+	if (includeGroups)
+		mFlattenedLayersAndGroupsCache = cached;
+	else
+		mFlattenedLayersCache = cached;
+
+	return cached;
 }
 
 /** @brief Returns all of the layers in this group and all groups below it having the given class
@@ -186,7 +204,7 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 	if (includeGroups || [self isKindOfClass:layerClass])
 		[fLayers addObject:self];
 
-	for (DKLayer* layer in [self layers]) {
+	for (DKLayer* layer in m_layers) {
 		if ([layer respondsToSelector:_cmd])
 			[fLayers addObjectsFromArray:[(DKLayerGroup*)layer flattenedLayersOfClass:layerClass
 																		includeGroups:includeGroups]];
@@ -197,6 +215,138 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 	return fLayers;
 }
 
+/** @brief Enumerates the flattened hierarchy in place - see header
+
+ The recursion threads a single stop flag; each level watches its own structure generation so a
+ mutation by the block (at any depth) is detected exactly where it happened.
+ */
+- (void)enumerateFlattenedLayersIncludingGroups:(BOOL)includeGroups usingBlock:(void (NS_NOESCAPE ^)(__kindof DKLayer*, BOOL*))block
+{
+	NSAssert(block != nil, @"layer enumeration block cannot be nil");
+
+	BOOL stop = NO;
+
+	[self enumerateFlattenedLayersIncludingGroups:includeGroups
+											 stop:&stop
+									   usingBlock:block];
+}
+
+- (void)enumerateFlattenedLayersIncludingGroups:(BOOL)includeGroups stop:(BOOL*)stop usingBlock:(void (NS_NOESCAPE ^)(__kindof DKLayer*, BOOL*))block
+{
+	if (includeGroups) {
+		block(self, stop);
+
+		if (*stop)
+			return;
+	}
+
+	NSUInteger generation = mStructureGeneration;
+
+	for (DKLayer* layer in m_layers) {
+		if ([layer isKindOfClass:[DKLayerGroup class]])
+			[(DKLayerGroup*)layer enumerateFlattenedLayersIncludingGroups:includeGroups
+																	 stop:stop
+															   usingBlock:block];
+		else
+			block(layer, stop);
+
+		if (*stop)
+			return;
+
+		if (mStructureGeneration != generation)
+			[NSException raise:NSGenericException
+						format:@"layer group %@ was mutated while being enumerated", self];
+	}
+}
+
+/** rebuilds both flattened state caches with a single walk if they are stale. Subgroups rebuild
+ (and keep) their own lists on demand, so after a localized change only the path from the changed
+ group up to the root is actually re-walked - untouched subtrees answer from their caches.
+ */
+- (void)rebuildFlattenedStateCachesIfNeeded
+{
+	if (mFlattenedStateCachesValid)
+		return;
+
+	NSMutableArray* visLayers = [NSMutableArray array];
+	NSMutableArray* edLayers = [NSMutableArray array];
+
+	for (DKLayer* layer in m_layers) {
+		if ([layer isKindOfClass:[DKLayerGroup class]]) {
+			DKLayerGroup* group = (DKLayerGroup*)layer;
+
+			if ([group visible]) {
+				[visLayers addObjectsFromArray:[group visibleLayers]];
+				[edLayers addObjectsFromArray:[group editableLayers]];
+			}
+		} else if ([layer visible]) {
+			[visLayers addObject:layer];
+
+			if (![layer locked])
+				[edLayers addObject:layer];
+		}
+	}
+
+	mVisibleLayersCache = [visLayers copy];
+	mEditableLayersCache = [edLayers copy];
+	mFlattenedStateCachesValid = YES;
+}
+
+- (NSArray*)visibleLayers
+{
+	[self rebuildFlattenedStateCachesIfNeeded];
+	return mVisibleLayersCache;
+}
+
+- (NSArray*)editableLayers
+{
+	[self rebuildFlattenedStateCachesIfNeeded];
+	return mEditableLayersCache;
+}
+
+- (void)invalidateFlattenedStateCaches
+{
+	// a group that is already stale implies its ancestors are stale too, so propagation stops here -
+	// this keeps repeated invalidation during a batch of edits O(1)
+
+	if (!mFlattenedStateCachesValid)
+		return;
+
+	mFlattenedStateCachesValid = NO;
+	mVisibleLayersCache = nil;
+	mEditableLayersCache = nil;
+
+	[[self layerGroup] invalidateFlattenedStateCaches];
+}
+
+/** invalidates the caches of this group and every group below it. Needed when this group's own
+ visibility or lock state changes, because descendants' cached lists bake in the state they
+ inherit through the chain of groups above them.
+ */
+- (void)invalidateFlattenedStateCachesInSubtree
+{
+	for (DKLayer* layer in m_layers) {
+		if ([layer isKindOfClass:[DKLayerGroup class]])
+			[(DKLayerGroup*)layer invalidateFlattenedStateCachesInSubtree];
+	}
+
+	[self invalidateFlattenedStateCaches];
+}
+
+/** notes a change to the subtree's structure (as opposed to a mere visibility or lock change):
+ bumps the generation that detects mutation during enumeration and drops the structural flattened
+ caches here and in every ancestor, whose lists embed this subtree. The state caches are handled
+ separately through the existing dirty bit.
+ */
+- (void)noteStructuralChange
+{
+	++mStructureGeneration;
+	mFlattenedLayersCache = nil;
+	mFlattenedLayersAndGroupsCache = nil;
+
+	[[self layerGroup] noteStructuralChange];
+}
+
 #pragma mark -
 #pragma mark - adding and removing layers
 
@@ -270,6 +420,8 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 					   atIndex:layerIndex];
 		[aLayer setLayerGroup:self];
 		[aLayer drawingDidChangeToSize:[NSValue valueWithSize:[[self drawing] drawingSize]]];
+		[self invalidateFlattenedStateCaches];
+		[self noteStructuralChange];
 		[self setNeedsDisplay:YES];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerGroupDidAddLayer
 															object:self];
@@ -308,6 +460,8 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 																inLayersAtIndex:layerIndex];
 			[aLayer setLayerGroup:nil];
 			[m_layers removeObjectAtIndex:layerIndex];
+			[self invalidateFlattenedStateCaches];
+			[self noteStructuralChange];
 			[self setNeedsDisplay:YES];
 			[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerGroupDidRemoveLayer
 																object:self];
@@ -330,6 +484,8 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 		[m_layers makeObjectsPerformSelector:@selector(setLayerGroup:)
 								  withObject:nil];
 		[m_layers removeAllObjects];
+		[self invalidateFlattenedStateCaches];
+		[self noteStructuralChange];
 		[self setNeedsDisplay:YES];
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerGroupDidRemoveLayer
 															object:self];
@@ -503,15 +659,10 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 - (DKLayer*)findLayerForPoint:(NSPoint)p
 {
 	if ([self visible]) {
-		NSEnumerator* iter = [self layerTopToBottomEnumerator];
-
-		for (__strong DKLayer* layer in iter) {
-			if ([layer isKindOfClass:[DKLayerGroup class]]) {
-				layer = [(DKLayerGroup*)layer findLayerForPoint:p];
+		// the cached flattened list keeps this at one array scan per event, with no tree walk
 
-				if (layer)
-					return layer;
-			} else if ([layer visible] && [layer hitLayer:p])
+		for (DKLayer* layer in [self visibleLayers]) {
+			if ([layer hitLayer:p])
 				return layer;
 		}
 	}
@@ -780,6 +931,8 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 			[m_layers insertObject:aLayer
 						   atIndex:i];
 
+			[self invalidateFlattenedStateCaches];
+			[self noteStructuralChange];
 			[self setNeedsDisplay:YES];
 			[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerGroupDidReorderLayers
 																object:self];
@@ -790,6 +943,21 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 #pragma mark -
 #pragma mark As a DKLayer
 
+/** @brief A group's own state is consulted through the chain by every descendant, so the whole
+ subtree's cached flattened lists go stale, not just this level's.
+ */
+- (void)setVisible:(BOOL)visible
+{
+	[super setVisible:visible];
+	[self invalidateFlattenedStateCachesInSubtree];
+}
+
+- (void)setLocked:(BOOL)locked
+{
+	[super setLocked:locked];
+	[self invalidateFlattenedStateCachesInSubtree];
+}
+
 /** @brief Propagates the undo manager to all contained layers
  @param um the drawing's undo manager
  */
@@ -831,15 +999,27 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 					if ([layer clipsDrawingToInterior])
 						[NSBezierPath clipRect:[[self drawing] interior]];
 
-					[layer beginDrawing];
-					[layer drawRect:rect
-							 inView:aView];
-					[layer endDrawing];
+					DK_SIGNPOST_BEGIN("DKLayer render", layer, "%{public}@", [layer layerName]);
+
+					// layers hinting that their content is mostly static are composited from a
+					// retained backing store - a blit per frame instead of a full render. Printing
+					// always renders live at full quality.
+
+					if (!printing && [layer shouldCacheContent])
+						[layer drawContentCacheInRect:rect
+											   inView:aView];
+					else {
+						[layer beginDrawing];
+						[layer drawRect:rect
+								 inView:aView];
+						[layer endDrawing];
+					}
 				}
 				@catch (id exc) {
 					NSLog(@"exception while drawing layer %@ [%ld of %ld in group %@](%@ - ignored)", layer, (long)n, (long)[self countOfLayers], self, exc);
 				}
 				@finally {
+					DK_SIGNPOST_END("DKLayer render", layer);
 					[NSGraphicsContext restoreGraphicsState];
 				}
 			}
@@ -1009,7 +1189,16 @@ NSString* const kDKLayerGroupDidReorderLayers = @"kDKLayerGroupDidReorderLayers"
 
 	[coder encodeBool:YES
 			   forKey:@"DKLayerGroup_invertedStack"];
-	[coder encodeObject:[self layers]
+
+	// when archiving to the chunked container format the root group's layers are written as separate chunks by the
+	// drawing, so an empty list is stored in their place - the reader reattaches the decoded layers afterwards
+
+	NSArray* layers = [self layers];
+
+	if ([coder respondsToSelector:@selector(deferredLayerGroup)] && [(DKKeyedArchiver*)coder deferredLayerGroup] == self)
+		layers = @[];
+
+	[coder encodeObject:layers
 				 forKey:@"DKLayerGroup_layers"];
 }
 
@@ -0,0 +1,61 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKQuartzCache;
+
+/** @brief Grid of retained offscreen tiles covering a layer's canvas.
+
+ Manages a sparse grid of fixed-size DKQuartzCache tiles covering the canvas. A client draws by asking the cache
+ for a rect; any missing tiles are rendered on demand by the supplied block and retained, so subsequent redraws of
+ unchanged areas - scrolling in particular - are plain blits. When content changes, only the tiles intersecting
+ the changed rect are discarded, so the cost of an edit is proportional to the area it dirties, not to the window
+ size. Tiles are created against the current context, so the cache should only be used for screen drawing.
+*/
+@interface DKLayerTileCache : NSObject {
+@private
+	NSMutableDictionary<NSNumber*, DKQuartzCache*>* mTiles;
+	NSSize mCanvasSize;
+	CGFloat mTileSize;
+	NSUInteger mCols;
+	NSUInteger mRows;
+}
+
+- (instancetype)init UNAVAILABLE_ATTRIBUTE;
+- (instancetype)initWithCanvasSize:(NSSize)size tileSize:(CGFloat)tileSize NS_DESIGNATED_INITIALIZER;
+
+@property (readonly) NSSize canvasSize;
+@property (readonly) CGFloat tileSize;
+
+/** @brief The number of tiles currently rendered and retained. */
+@property (readonly) NSUInteger countOfTiles;
+
+/** @brief Discards any tiles intersecting \c rect so they are re-rendered on the next draw. */
+- (void)invalidateRect:(NSRect)rect;
+
+/** @brief Discards all tiles. */
+- (void)invalidateAll;
+
+/** @brief Changes the canvas size, discarding all tiles if it differs from the current size. */
+- (void)setCanvasSize:(NSSize)size;
+
+/** @brief Composites all tiles intersecting \c rect into the current context.
+
+ Tiles not yet rendered are first filled by calling \c renderer with the tile's rect in canvas coordinates; the
+ renderer should draw exactly the content intersecting that rect, clipped or not as it pleases (each tile clips
+ to its own bounds when composited anyway).
+*/
+- (void)drawRect:(NSRect)rect usingRenderer:(void (NS_NOESCAPE ^)(NSRect tileRect))renderer;
+
+@end
+
+/// default tile dimension, in drawing units
+#define kDKLayerTileCacheDefaultTileSize 256.0
+
+NS_ASSUME_NONNULL_END
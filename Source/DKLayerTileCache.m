@@ -0,0 +1,148 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKLayerTileCache.h"
+#import "DKPerformanceCounters.h"
+#import "DKQuartzCache.h"
+
+@implementation DKLayerTileCache
+
+- (instancetype)initWithCanvasSize:(NSSize)size tileSize:(CGFloat)tileSize
+{
+	NSAssert(tileSize > 0.0, @"tile size must be positive");
+
+	self = [super init];
+	if (self) {
+		mTiles = [[NSMutableDictionary alloc] init];
+		mTileSize = tileSize;
+		[self setCanvasSize:size];
+	}
+
+	return self;
+}
+
+@synthesize canvasSize = mCanvasSize;
+@synthesize tileSize = mTileSize;
+
+- (NSUInteger)countOfTiles
+{
+	return [mTiles count];
+}
+
+- (void)setCanvasSize:(NSSize)size
+{
+	if (!NSEqualSizes(size, mCanvasSize)) {
+		mCanvasSize = size;
+		mCols = (NSUInteger)ceil(size.width / mTileSize);
+		mRows = (NSUInteger)ceil(size.height / mTileSize);
+		[self invalidateAll];
+	}
+}
+
+- (void)invalidateRect:(NSRect)rect
+{
+	if (NSIsEmptyRect(rect))
+		return;
+
+	NSUInteger col, row, colMin, colMax, rowMin, rowMax;
+
+	if (![self getTileRangeForRect:rect
+							colMin:&colMin
+							colMax:&colMax
+							rowMin:&rowMin
+							rowMax:&rowMax])
+		return;
+
+	for (row = rowMin; row <= rowMax; ++row)
+		for (col = colMin; col <= colMax; ++col)
+			[mTiles removeObjectForKey:@(row * mCols + col)];
+}
+
+- (void)invalidateAll
+{
+	[mTiles removeAllObjects];
+}
+
+- (void)drawRect:(NSRect)rect usingRenderer:(void (NS_NOESCAPE ^)(NSRect))renderer
+{
+	if (NSIsEmptyRect(rect) || mCols == 0 || mRows == 0)
+		return;
+
+	NSUInteger col, row, colMin, colMax, rowMin, rowMax;
+
+	if (![self getTileRangeForRect:rect
+							colMin:&colMin
+							colMax:&colMax
+							rowMin:&rowMin
+							rowMax:&rowMax])
+		return;
+
+	for (row = rowMin; row <= rowMax; ++row) {
+		for (col = colMin; col <= colMax; ++col) {
+			NSNumber* key = @(row * mCols + col);
+			DKQuartzCache* tile = [mTiles objectForKey:key];
+			NSRect tileRect = [self rectForTileAtColumn:col
+													row:row];
+
+			if (tile == nil) {
+				DKPerfCounterAdd(&gDKPerfCounters.tileCacheMisses, 1);
+
+				tile = [DKQuartzCache cacheForCurrentContextInRect:tileRect];
+				[tile lockFocus];
+				NSRectClip(tileRect);
+				renderer(tileRect);
+				[tile unlockFocus];
+				[mTiles setObject:tile
+						   forKey:key];
+			} else
+				DKPerfCounterAdd(&gDKPerfCounters.tileCacheHits, 1);
+
+			[tile drawAtPoint:tileRect.origin];
+		}
+	}
+}
+
+#pragma mark -
+#pragma mark - private
+
+- (NSRect)rectForTileAtColumn:(NSUInteger)col row:(NSUInteger)row
+{
+	NSRect r = NSMakeRect(col * mTileSize, row * mTileSize, mTileSize, mTileSize);
+
+	// edge tiles are clipped to the canvas
+
+	if (NSMaxX(r) > mCanvasSize.width)
+		r.size.width = mCanvasSize.width - NSMinX(r);
+	if (NSMaxY(r) > mCanvasSize.height)
+		r.size.height = mCanvasSize.height - NSMinY(r);
+
+	return r;
+}
+
+- (BOOL)getTileRangeForRect:(NSRect)rect colMin:(NSUInteger*)colMin colMax:(NSUInteger*)colMax rowMin:(NSUInteger*)rowMin rowMax:(NSUInteger*)rowMax
+{
+	rect = NSIntersectionRect(rect, NSMakeRect(0, 0, mCanvasSize.width, mCanvasSize.height));
+
+	if (NSIsEmptyRect(rect))
+		return NO;
+
+	*colMin = (NSUInteger)floor(NSMinX(rect) / mTileSize);
+	*rowMin = (NSUInteger)floor(NSMinY(rect) / mTileSize);
+	*colMax = MIN((NSUInteger)floor(NSMaxX(rect) / mTileSize), mCols - 1);
+	*rowMax = MIN((NSUInteger)floor(NSMaxY(rect) / mTileSize), mRows - 1);
+
+	return YES;
+}
+
+#pragma mark -
+#pragma mark - as a NSObject
+
+- (NSString*)description
+{
+	return [NSString stringWithFormat:@"<%@ %p>, %lu x %lu grid, %lu tiles rendered", NSStringFromClass([self class]), self, (unsigned long)mCols, (unsigned long)mRows, (unsigned long)[mTiles count]];
+}
+
+@end
@@ -11,7 +11,14 @@
 
 Basic storage class stores objects in a standard array. For many uses this will be entirely adequate, but may be substituted for scalability or
  special uses.
- 
+
+ The storage owns a packed struct-of-arrays mirror of each object's bounds and visibility - the hot state that culling reads -
+ maintained incrementally through every structural change: inserts and removals shift the packed arrays in place, batch edits
+ refill only the affected tail, and a full rebuild happens only on wholesale replacement. Each object is stamped with its
+ Z-index (via the DKStorableObject \c index property) so a bounds or visibility change patches its slot directly, without
+ searching. Rect queries test the mirror in a plain C loop over contiguous memory - no per-object messaging - and only touch
+ the objects that pass, so the objects themselves are the cold side, consulted when something is actually drawn or edited.
+
  Note regarding NSCoding: currently the storage itself is no longer archived - only its objects are. The storage class is selected at runtime. However for
  a brief period (beta 5), the storage was archived. To support files written at that time, this class and its derivatives currently support NSCoding (for reading)
  so that the files can be correctly dearchived. Re-saving the files will update to the new approach. Archiving of the storage isn't curremtly done, and attempting to
@@ -20,6 +27,17 @@ Basic storage class stores objects in a standard array. For many uses this will
 @interface DKLinearObjectStorage : NSObject <DKObjectStorage, NSCoding> {
 @private
 	NSMutableArray<id<DKStorableObject>>* mObjects;
+	CGFloat* mMirrorMinX; // packed per-index mirror of object bounds (struct-of-arrays)
+	CGFloat* mMirrorMinY;
+	CGFloat* mMirrorMaxX;
+	CGFloat* mMirrorMaxY;
+	uint8_t* mMirrorVisible; // 1 where the object at that index is visible
+	CGFloat* mMirrorObbCos; // oriented culling box local x-axis (cos); 0 with sin 0 when no box
+	CGFloat* mMirrorObbSin; // oriented culling box local x-axis (sin); 0 means cull on bounds alone
+	CGFloat* mMirrorObbU; // oriented box half extent along its local x-axis, margins folded in
+	CGFloat* mMirrorObbV; // oriented box half extent along its local y-axis, margins folded in
+	NSUInteger mMirrorCapacity; // allocated slots in the mirror arrays
+	BOOL mMirrorValid; // NO after a structural change; the next query rebuilds the mirror
 }
 
 @end
@@ -5,8 +5,26 @@
 */
 
 #import "DKLinearObjectStorage.h"
+#import "DKDrawableObject.h"
 #import "LogEvent.h"
 
+@interface DKLinearObjectStorage ()
+
+- (void)rebuildMirrorIfNeeded;
+- (void)updateMirrorSlotForObject:(id<DKStorableObject>)obj;
+- (void)ensureMirrorCapacity:(NSUInteger)count;
+- (void)fillMirrorSlot:(NSUInteger)indx forObject:(id<DKStorableObject>)obj;
+- (void)fillOrientedBoxSlot:(NSUInteger)indx forObject:(id<DKStorableObject>)obj;
+- (BOOL)orientedBoxSlot:(NSUInteger)indx hitsRect:(NSRect)aRect;
+
+/** refills mirror slots and stored Z-indexes from \c start to the end; used after a batch structural change */
+- (void)refreshMirrorFromIndex:(NSUInteger)start;
+
+/** re-stamps each object's Z-index from \c start to the end without touching the mirrored geometry */
+- (void)renumberObjectsFromIndex:(NSUInteger)start;
+
+@end
+
 @implementation DKLinearObjectStorage
 
 #pragma mark - as implementor of the DKObjectStorage protocol
@@ -14,27 +32,64 @@
 - (NSArray*)objectsIntersectingRect:(NSRect)aRect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
 	NSMutableArray* temp = [NSMutableArray array];
-	NSEnumerator* iter;
+	NSUInteger count = [mObjects count];
+
+	if (count == 0)
+		return temp;
 
-	if (options & kDKReverseOrder)
-		iter = [[self objects] reverseObjectEnumerator];
-	else
-		iter = [[self objects] objectEnumerator];
+	if (options & kDKIgnoreUpdateRect) {
+		NSEnumerator* iter;
 
-	for (id<DKStorableObject> obj in iter) {
-		if ((options & kDKIncludeInvisible) || [obj visible]) {
-			if (options & kDKIgnoreUpdateRect) {
+		if (options & kDKReverseOrder)
+			iter = [[self objects] reverseObjectEnumerator];
+		else
+			iter = [[self objects] objectEnumerator];
+
+		for (id<DKStorableObject> obj in iter) {
+			if ((options & kDKIncludeInvisible) || [obj visible])
 				[temp addObject:obj];
-			} else {
-				NSRect bounds = [obj bounds];
+		}
+
+		return temp;
+	}
+
+	[self rebuildMirrorIfNeeded];
+
+	// first pass tests the packed mirror - a plain C loop over contiguous memory with no messaging,
+	// which the compiler is free to vectorize. Only objects that pass are touched at all.
+
+	const uint8_t includeInvisible = (options & kDKIncludeInvisible) ? 1 : 0;
+	NSUInteger i, indx;
+
+	if (aView == nil) {
+		const CGFloat rx0 = NSMinX(aRect), ry0 = NSMinY(aRect), rx1 = NSMaxX(aRect), ry1 = NSMaxY(aRect);
+		uint8_t* hits = (uint8_t*)malloc(count);
+
+		for (i = 0; i < count; ++i)
+			hits[i] = (uint8_t)((mMirrorVisible[i] | includeInvisible) & (mMirrorMinX[i] < rx1) & (mMirrorMaxX[i] > rx0) & (mMirrorMinY[i] < ry1) & (mMirrorMaxY[i] > ry0));
+
+		for (i = 0; i < count; ++i) {
+			indx = (options & kDKReverseOrder) ? (count - 1 - i) : i;
 
-				// if a view was passed, use -needsToDrawRect, otherwise intersection with <rect>
+			if (hits[indx] && [self orientedBoxSlot:indx
+										   hitsRect:aRect])
+				[temp addObject:[mObjects objectAtIndex:indx]];
+		}
+
+		free(hits);
+	} else {
+		// a view was passed - -needsToDrawRect decides, fed from the mirrored bounds so the
+		// objects themselves are still only messaged when collected
+
+		for (i = 0; i < count; ++i) {
+			indx = (options & kDKReverseOrder) ? (count - 1 - i) : i;
 
-				if (aView) {
-					if ([aView needsToDrawRect:bounds])
-						[temp addObject:obj];
-				} else if (NSIntersectsRect(bounds, aRect))
-					[temp addObject:obj];
+			if (mMirrorVisible[indx] | includeInvisible) {
+				NSRect bounds = NSMakeRect(mMirrorMinX[indx], mMirrorMinY[indx], mMirrorMaxX[indx] - mMirrorMinX[indx], mMirrorMaxY[indx] - mMirrorMinY[indx]);
+
+				if ([aView needsToDrawRect:bounds] && [self orientedBoxSlot:indx
+																  hitsRect:aRect])
+					[temp addObject:[mObjects objectAtIndex:indx]];
 			}
 		}
 	}
@@ -55,6 +110,7 @@
 	LogEvent_(kReactiveEvent, @"storage setting %lu objects %@", (unsigned long)[objects count], self);
 
 	mObjects = [objects mutableCopy];
+	mMirrorValid = NO;
 
 	[mObjects makeObjectsPerformSelector:@selector(setStorage:)
 							  withObject:self];
@@ -90,6 +146,33 @@
 		[mObjects insertObject:obj
 					   atIndex:indx];
 		[obj setStorage:self];
+
+		// open up one slot in the mirror rather than discarding it - the objects above the
+		// insertion keep their packed state and are only re-stamped with their new Z-index
+
+		if (mMirrorValid) {
+			NSUInteger count = [mObjects count];
+
+			[self ensureMirrorCapacity:count];
+
+			NSUInteger tail = count - 1 - indx;
+
+			if (tail > 0) {
+				memmove(&mMirrorMinX[indx + 1], &mMirrorMinX[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorMinY[indx + 1], &mMirrorMinY[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorMaxX[indx + 1], &mMirrorMaxX[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorMaxY[indx + 1], &mMirrorMaxY[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorVisible[indx + 1], &mMirrorVisible[indx], tail);
+				memmove(&mMirrorObbCos[indx + 1], &mMirrorObbCos[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorObbSin[indx + 1], &mMirrorObbSin[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorObbU[indx + 1], &mMirrorObbU[indx], tail * sizeof(CGFloat));
+				memmove(&mMirrorObbV[indx + 1], &mMirrorObbV[indx], tail * sizeof(CGFloat));
+			}
+
+			[self fillMirrorSlot:indx
+					   forObject:obj];
+			[self renumberObjectsFromIndex:indx];
+		}
 	}
 }
 
@@ -100,6 +183,25 @@
 	id<DKStorableObject> obj = [mObjects objectAtIndex:indx];
 	[obj setStorage:nil];
 	[mObjects removeObjectAtIndex:indx];
+
+	if (mMirrorValid) {
+		NSUInteger count = [mObjects count];
+		NSUInteger tail = count - indx;
+
+		if (tail > 0) {
+			memmove(&mMirrorMinX[indx], &mMirrorMinX[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorMinY[indx], &mMirrorMinY[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorMaxX[indx], &mMirrorMaxX[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorMaxY[indx], &mMirrorMaxY[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorVisible[indx], &mMirrorVisible[indx + 1], tail);
+			memmove(&mMirrorObbCos[indx], &mMirrorObbCos[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorObbSin[indx], &mMirrorObbSin[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorObbU[indx], &mMirrorObbU[indx + 1], tail * sizeof(CGFloat));
+			memmove(&mMirrorObbV[indx], &mMirrorObbV[indx + 1], tail * sizeof(CGFloat));
+		}
+
+		[self renumberObjectsFromIndex:indx];
+	}
 }
 
 - (void)replaceObjectInObjectsAtIndex:(NSUInteger)indx withObject:(id<DKStorableObject>)obj
@@ -112,6 +214,12 @@
 	[mObjects replaceObjectAtIndex:indx
 						withObject:obj];
 	[obj setStorage:self];
+
+	if (mMirrorValid) {
+		[obj setIndex:indx];
+		[self fillMirrorSlot:indx
+				   forObject:obj];
+	}
 }
 
 - (void)insertObjects:(NSArray*)objs atIndexes:(NSIndexSet*)set
@@ -125,6 +233,7 @@
 							  withObject:self];
 		[mObjects insertObjects:objs
 					  atIndexes:set];
+		[self refreshMirrorFromIndex:[set firstIndex]];
 	}
 }
 
@@ -139,6 +248,7 @@
 		[objs makeObjectsPerformSelector:@selector(setStorage:)
 							  withObject:nil];
 		[mObjects removeObjectsAtIndexes:set];
+		[self refreshMirrorFromIndex:[set firstIndex]];
 	}
 }
 
@@ -165,22 +275,55 @@
 		[mObjects removeObject:obj];
 		[mObjects insertObject:obj
 					   atIndex:indx];
+		[self refreshMirrorFromIndex:MIN(old, indx)];
 	}
 }
 
+- (void)moveObjectsAtIndexes:(NSIndexSet*)set toIndex:(NSUInteger)indx
+{
+	NSAssert(set != nil, @"cannot move objects - index set is nil");
+	NSAssert([set lastIndex] == NSNotFound || [set lastIndex] < [self countOfObjects], @"error - index set extends beyond bounds");
+
+	if ([set count] == 0)
+		return;
+
+	// extract the moving block and reinsert it in one operation - unlike per-object
+	// remove/insert this shifts the remainder of the array only once however many
+	// objects are moving
+
+	NSArray* moving = [mObjects objectsAtIndexes:set];
+
+	[mObjects removeObjectsAtIndexes:set];
+
+	indx = MIN(indx, [mObjects count]);
+	[mObjects insertObjects:moving
+				  atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(indx, [moving count])]];
+	[self refreshMirrorFromIndex:MIN([set firstIndex], indx)];
+}
+
+- (void)applyObjectOrdering:(NSArray<id<DKStorableObject>>*)orderedObjects
+{
+	NSAssert(orderedObjects != nil, @"cannot apply a nil ordering");
+	NSAssert([orderedObjects count] == [mObjects count], @"ordering must be a permutation of the stored objects");
+
+	// trusted to be a permutation of the existing objects - ownership is unchanged
+
+	mObjects = [orderedObjects mutableCopy];
+	mMirrorValid = NO;
+}
+
 - (void)object:(id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds
 {
-#pragma unused(obj, oldBounds)
+#pragma unused(oldBounds)
 
-	// linear storage does't care about an object's bounds, but other spatially-partitioned storage may do. This method
-	// can be used to re-store the object when it is resized or moved
+	// patch the mirrored bounds in place so a drag doesn't throw away the whole mirror every frame
 
-	//NSLog(@"bounds change from: %@, old = %@, new = %@", obj, NSStringFromRect( oldBounds ), NSStringFromRect([obj bounds]));
+	[self updateMirrorSlotForObject:obj];
 }
 
 - (void)objectDidChangeVisibility:(id<DKStorableObject>)obj
 {
-#pragma unused(obj)
+	[self updateMirrorSlotForObject:obj];
 }
 
 - (void)setCanvasSize:(NSSize)size
@@ -188,6 +331,284 @@
 #pragma unused(size)
 }
 
+- (NSRect)unionOfObjectBounds
+{
+	[self rebuildMirrorIfNeeded];
+
+	NSUInteger count = [mObjects count];
+
+	if (count == 0)
+		return NSZeroRect;
+
+	// reduce the packed mirror, not the objects. Each chunk produces an independent partial
+	// min/max over contiguous memory - plain scalar compares the compiler can vectorize - and
+	// the partials are folded serially. Invisible slots are skipped by substituting a value
+	// that can never win the comparison.
+
+	const NSUInteger chunkSize = 16384;
+	NSUInteger nChunks = (count + chunkSize - 1) / chunkSize;
+
+	CGFloat* partMinX = (CGFloat*)malloc(nChunks * sizeof(CGFloat));
+	CGFloat* partMinY = (CGFloat*)malloc(nChunks * sizeof(CGFloat));
+	CGFloat* partMaxX = (CGFloat*)malloc(nChunks * sizeof(CGFloat));
+	CGFloat* partMaxY = (CGFloat*)malloc(nChunks * sizeof(CGFloat));
+
+	const CGFloat* minX = mMirrorMinX;
+	const CGFloat* minY = mMirrorMinY;
+	const CGFloat* maxX = mMirrorMaxX;
+	const CGFloat* maxY = mMirrorMaxY;
+	const uint8_t* vis = mMirrorVisible;
+
+	dispatch_apply(nChunks, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t chunk) {
+		NSUInteger start = chunk * chunkSize;
+		NSUInteger end = MIN(start + chunkSize, count);
+		CGFloat x0 = CGFLOAT_MAX, y0 = CGFLOAT_MAX, x1 = -CGFLOAT_MAX, y1 = -CGFLOAT_MAX;
+
+		for (NSUInteger i = start; i < end; ++i) {
+			if (vis[i]) {
+				x0 = MIN(x0, minX[i]);
+				y0 = MIN(y0, minY[i]);
+				x1 = MAX(x1, maxX[i]);
+				y1 = MAX(y1, maxY[i]);
+			}
+		}
+
+		partMinX[chunk] = x0;
+		partMinY[chunk] = y0;
+		partMaxX[chunk] = x1;
+		partMaxY[chunk] = y1;
+	});
+
+	CGFloat x0 = CGFLOAT_MAX, y0 = CGFLOAT_MAX, x1 = -CGFLOAT_MAX, y1 = -CGFLOAT_MAX;
+
+	for (NSUInteger c = 0; c < nChunks; ++c) {
+		x0 = MIN(x0, partMinX[c]);
+		y0 = MIN(y0, partMinY[c]);
+		x1 = MAX(x1, partMaxX[c]);
+		y1 = MAX(y1, partMaxY[c]);
+	}
+
+	free(partMinX);
+	free(partMinY);
+	free(partMaxX);
+	free(partMaxY);
+
+	// all slots invisible leaves the accumulators untouched
+
+	if (x1 < x0)
+		return NSZeroRect;
+
+	return NSMakeRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+- (void)enumerateObjectSpansWithOptions:(DKObjectStorageOptions)options usingBlock:(void (NS_NOESCAPE ^)(DKObjectStorageSpan span, BOOL* stop))block
+{
+	NSAssert(block != nil, @"span enumeration block cannot be nil");
+
+	NSUInteger count = [mObjects count];
+
+	if (count == 0)
+		return;
+
+	[self rebuildMirrorIfNeeded];
+
+	// the array is snapshotted into an unretained C buffer once, then spans are carved out of it
+	// with their bounds gathered from the packed mirror, so the block walks sequential memory in
+	// both arrays and the enumeration never messages an object it delivers
+
+	__unsafe_unretained id* all = (__unsafe_unretained id*)malloc(count * sizeof(id));
+	[mObjects getObjects:all
+				   range:NSMakeRange(0, count)];
+
+	const BOOL includeInvisible = (options & kDKIncludeInvisible) != 0;
+	const BOOL reverse = (options & kDKReverseOrder) != 0;
+
+	__unsafe_unretained id<DKStorableObject> spanObjects[kDKObjectStorageSpanLength];
+	NSRect spanBounds[kDKObjectStorageSpanLength];
+	NSUInteger filled = 0;
+	BOOL stop = NO;
+	NSUInteger i;
+
+	for (i = 0; i < count && !stop; ++i) {
+		NSUInteger indx = reverse ? (count - 1 - i) : i;
+
+		if (!includeInvisible && !mMirrorVisible[indx])
+			continue;
+
+		spanObjects[filled] = all[indx];
+		spanBounds[filled] = NSMakeRect(mMirrorMinX[indx], mMirrorMinY[indx], mMirrorMaxX[indx] - mMirrorMinX[indx], mMirrorMaxY[indx] - mMirrorMinY[indx]);
+
+		if (++filled == kDKObjectStorageSpanLength) {
+			@autoreleasepool {
+				DKObjectStorageSpan span = { spanObjects, spanBounds, filled };
+				block(span, &stop);
+			}
+			filled = 0;
+		}
+	}
+
+	if (filled > 0 && !stop) {
+		@autoreleasepool {
+			DKObjectStorageSpan span = { spanObjects, spanBounds, filled };
+			block(span, &stop);
+		}
+	}
+
+	free(all);
+}
+
+#pragma mark -
+#pragma mark - mirror maintenance
+
+- (void)rebuildMirrorIfNeeded
+{
+	if (mMirrorValid)
+		return;
+
+	[self ensureMirrorCapacity:[mObjects count]];
+
+	// the rebuild pass reads the memoized bounds slot directly, so it is a single cheap sweep.
+	// Each object is also stamped with its Z-index so later slot patches can address the
+	// packed arrays directly instead of searching for the object
+
+	NSUInteger i = 0;
+
+	for (id<DKStorableObject> obj in mObjects) {
+		[obj setIndex:i];
+		[self fillMirrorSlot:i
+				   forObject:obj];
+		++i;
+	}
+
+	mMirrorValid = YES;
+}
+
+- (void)ensureMirrorCapacity:(NSUInteger)count
+{
+	if (count > mMirrorCapacity) {
+		NSUInteger newCapacity = MAX(count, MAX(mMirrorCapacity * 2, (NSUInteger)64));
+
+		mMirrorMinX = (CGFloat*)reallocf(mMirrorMinX, newCapacity * sizeof(CGFloat));
+		mMirrorMinY = (CGFloat*)reallocf(mMirrorMinY, newCapacity * sizeof(CGFloat));
+		mMirrorMaxX = (CGFloat*)reallocf(mMirrorMaxX, newCapacity * sizeof(CGFloat));
+		mMirrorMaxY = (CGFloat*)reallocf(mMirrorMaxY, newCapacity * sizeof(CGFloat));
+		mMirrorVisible = (uint8_t*)reallocf(mMirrorVisible, newCapacity);
+		mMirrorObbCos = (CGFloat*)reallocf(mMirrorObbCos, newCapacity * sizeof(CGFloat));
+		mMirrorObbSin = (CGFloat*)reallocf(mMirrorObbSin, newCapacity * sizeof(CGFloat));
+		mMirrorObbU = (CGFloat*)reallocf(mMirrorObbU, newCapacity * sizeof(CGFloat));
+		mMirrorObbV = (CGFloat*)reallocf(mMirrorObbV, newCapacity * sizeof(CGFloat));
+		mMirrorCapacity = newCapacity;
+	}
+}
+
+- (void)fillMirrorSlot:(NSUInteger)indx forObject:(id<DKStorableObject>)obj
+{
+	NSRect bounds = DKDrawableObjectBounds((DKDrawableObject*)obj);
+
+	mMirrorMinX[indx] = NSMinX(bounds);
+	mMirrorMinY[indx] = NSMinY(bounds);
+	mMirrorMaxX[indx] = NSMaxX(bounds);
+	mMirrorMaxY[indx] = NSMaxY(bounds);
+	mMirrorVisible[indx] = [obj visible] ? 1 : 0;
+	[self fillOrientedBoxSlot:indx
+					forObject:obj];
+}
+
+- (void)refreshMirrorFromIndex:(NSUInteger)start
+{
+	if (!mMirrorValid)
+		return; // a full rebuild is already pending
+
+	NSUInteger count = [mObjects count];
+
+	[self ensureMirrorCapacity:count];
+
+	for (NSUInteger i = start; i < count; ++i) {
+		id<DKStorableObject> obj = [mObjects objectAtIndex:i];
+
+		[obj setIndex:i];
+		[self fillMirrorSlot:i
+				   forObject:obj];
+	}
+}
+
+- (void)renumberObjectsFromIndex:(NSUInteger)start
+{
+	NSUInteger count = [mObjects count];
+
+	for (NSUInteger i = start; i < count; ++i)
+		[[mObjects objectAtIndex:i] setIndex:i];
+}
+
+- (void)fillOrientedBoxSlot:(NSUInteger)indx forObject:(id<DKStorableObject>)obj
+{
+	CGFloat c, s, u, v;
+
+	if ([(DKDrawableObject*)obj getOrientedCullingBoxCosine:&c
+													   sine:&s
+													uExtent:&u
+													vExtent:&v]) {
+		mMirrorObbCos[indx] = c;
+		mMirrorObbSin[indx] = s;
+		mMirrorObbU[indx] = u;
+		mMirrorObbV[indx] = v;
+	} else
+		mMirrorObbCos[indx] = mMirrorObbSin[indx] = mMirrorObbU[indx] = mMirrorObbV[indx] = 0.0;
+}
+
+- (BOOL)orientedBoxSlot:(NSUInteger)indx hitsRect:(NSRect)aRect
+{
+	// refinement of the axis-aligned test: when the slot records an oriented box, the query rect is
+	// also tested on the box's own two axes (the axis-aligned pass already covered the other two
+	// axes of the separating-axis test). For a rotated shape this rejects the large corner regions
+	// the inflated axis-aligned bounds cover but the shape cannot reach.
+
+	CGFloat s = mMirrorObbSin[indx];
+
+	if (s == 0.0)
+		return YES; // no oriented box recorded - the bounds test was exact
+
+	CGFloat c = mMirrorObbCos[indx];
+	CGFloat qhw = NSWidth(aRect) * 0.5, qhh = NSHeight(aRect) * 0.5;
+	CGFloat dx = NSMidX(aRect) - (mMirrorMinX[indx] + mMirrorMaxX[indx]) * 0.5;
+	CGFloat dy = NSMidY(aRect) - (mMirrorMinY[indx] + mMirrorMaxY[indx]) * 0.5;
+	CGFloat absC = fabs(c), absS = fabs(s);
+
+	if (fabs(dx * c + dy * s) > mMirrorObbU[indx] + qhw * absC + qhh * absS)
+		return NO;
+
+	if (fabs(dx * s - dy * c) > mMirrorObbV[indx] + qhw * absS + qhh * absC)
+		return NO;
+
+	return YES;
+}
+
+- (void)updateMirrorSlotForObject:(id<DKStorableObject>)obj
+{
+	if (!mMirrorValid)
+		return;
+
+	// the stamped Z-index addresses the slot directly - a drag patches four floats and a byte
+	// without any search. The stamp is verified in case the object was mutated outside the
+	// storage's knowledge, falling back to a search and, failing that, a rebuild.
+
+	NSUInteger indx = [obj index];
+
+	if (indx >= [mObjects count] || [mObjects objectAtIndex:indx] != obj) {
+		indx = [mObjects indexOfObjectIdenticalTo:obj];
+
+		if (indx == NSNotFound) {
+			mMirrorValid = NO;
+			return;
+		}
+
+		[obj setIndex:indx];
+	}
+
+	[self fillMirrorSlot:indx
+			   forObject:obj];
+}
+
 #pragma mark -
 #pragma mark - as implementor of the NSCoding protocol
 
@@ -228,6 +649,16 @@
 {
 	[[self objects] makeObjectsPerformSelector:@selector(setStorage:)
 									withObject:nil];
+
+	free(mMirrorMinX);
+	free(mMirrorMinY);
+	free(mMirrorMaxX);
+	free(mMirrorMaxY);
+	free(mMirrorVisible);
+	free(mMirrorObbCos);
+	free(mMirrorObbSin);
+	free(mMirrorObbU);
+	free(mMirrorObbV);
 }
 
 @end
@@ -0,0 +1,92 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class DKObjectOwnerLayer, DKDrawableObject;
+
+/** @brief Maintains inverted metadata indexes over the objects of a layer.
+
+ For layers holding very many objects, answering "all objects where metadata key X equals Y" by a
+ linear scan calling \c -metadataItemForKey: per object is far too slow to drive selection or styling
+ interactively. DKMetadataIndex keeps, for each registered key, a map from metadata value to the set
+ of objects currently carrying that value, so equality queries are a single hash lookup and range
+ queries walk a sorted list of the distinct values.
+
+ Indexes are maintained incrementally from the metadata change notifications
+ (<code>kDKMetadataWillChangeNotification</code> / <code>kDKMetadataDidChangeNotification</code>),
+ which identify the object and the affected key. Structural changes to the layer (objects added or
+ removed) only mark the index stale; it is rebuilt lazily by the next query, so bulk edits do not
+ pay per-object maintenance costs.
+
+ Keys are case-insensitive, matching the metadata API. Queries against a key that is not indexed
+ fall back to a linear scan so the API always answers. Query results are unordered - callers that
+ care about Z-order should reorder using the layer. Typically this object is not used directly -
+ see the metadata query methods of <code>DKObjectDrawingLayer</code>, which own one of these.
+*/
+@interface DKMetadataIndex : NSObject {
+@private
+	__weak DKObjectOwnerLayer* mLayerRef; // the layer whose objects are indexed
+	NSMutableDictionary<NSString*, NSMutableDictionary<id, NSMutableSet<DKDrawableObject*>*>*>* mIndexes; // key -> (value -> objects)
+	NSMapTable<DKDrawableObject*, NSMutableDictionary<NSString*, id>*>* mObjectValues; // reverse map for O(1) deindexing
+	NSMutableDictionary<NSString*, NSArray*>* mSortedValueCache; // key -> sorted distinct values, for range queries
+	NSArray<NSString*>* mIndexedKeys; // the (lowercased) keys indexes are maintained for
+	BOOL mNeedsRebuild; // YES after a structural change; next query rebuilds wholesale
+}
+
+/** @brief Designated initializer.
+ @param aLayer the layer whose objects are to be indexed (held weakly)
+ @return the index
+ */
+- (instancetype)initWithLayer:(DKObjectOwnerLayer*)aLayer NS_DESIGNATED_INITIALIZER;
+- (instancetype)init UNAVAILABLE_ATTRIBUTE;
+
+/** @brief The layer whose objects are indexed. */
+@property (readonly, weak) DKObjectOwnerLayer* layer;
+
+/** @brief The metadata keys for which inverted indexes are maintained.
+
+ Setting this replaces the previous set; keys are lowercased on the way in. The indexes themselves
+ are (re)built lazily by the next query.
+ */
+@property (nonatomic, copy) NSArray<NSString*>* indexedKeys;
+
+/** @brief Whether an inverted index is maintained for the given key. */
+- (BOOL)isKeyIndexed:(NSString*)key;
+
+/** @brief Returns the objects whose metadata value for \c key equals <code>value</code>.
+
+ A single hash lookup for indexed keys; a linear scan over the layer otherwise. Values are compared
+ with <code>-isEqual:</code>, so pass the same class the metadata stores (NSString, NSNumber, etc).
+ @param value the value to match
+ @param key the metadata key
+ @return the matching objects, unordered
+ */
+- (NSArray<DKDrawableObject*>*)objectsWithValue:(id)value forKey:(NSString*)key;
+
+/** @brief Returns the objects whose metadata value for \c key lies between the given values, inclusive.
+
+ Values are ordered with <code>-compare:</code>; either bound may be nil to leave that end open.
+ For indexed keys this walks a cached sorted list of the distinct values rather than the objects.
+ @param minValue the lower bound, or nil for no lower bound
+ @param maxValue the upper bound, or nil for no upper bound
+ @param key the metadata key
+ @return the matching objects, unordered
+ */
+- (NSArray<DKDrawableObject*>*)objectsWithValuesFrom:(nullable id)minValue to:(nullable id)maxValue forKey:(NSString*)key;
+
+/** @brief Marks the indexes stale so the next query rebuilds them from scratch.
+
+ Called automatically when objects are added to or removed from the layer; clients only need it if
+ they mutate metadata in a way that bypasses the normal change notifications.
+ */
+- (void)markNeedsRebuild;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,343 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKMetadataIndex.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKDrawableObject+Metadata.h"
+#import "LogEvent.h"
+
+@interface DKMetadataIndex ()
+
+- (void)rebuildIfNeeded;
+- (void)indexObject:(DKDrawableObject*)obj forKey:(NSString*)key;
+- (void)deindexObject:(DKDrawableObject*)obj forKey:(NSString*)key;
+- (void)metadataWillChange:(NSNotification*)note;
+- (void)metadataDidChange:(NSNotification*)note;
+- (void)layerStructureDidChange:(NSNotification*)note;
+- (nullable id)localValueOfObject:(DKDrawableObject*)obj forKey:(NSString*)key;
+- (NSArray*)sortedValuesForKey:(NSString*)key;
+
+@end
+
+#pragma mark -
+
+@implementation DKMetadataIndex
+
+- (instancetype)initWithLayer:(DKObjectOwnerLayer*)aLayer
+{
+	NSAssert(aLayer != nil, @"cannot create a metadata index without a layer");
+
+	self = [super init];
+	if (self) {
+		mLayerRef = aLayer;
+		mIndexes = [[NSMutableDictionary alloc] init];
+		mObjectValues = [NSMapTable weakToStrongObjectsMapTable];
+		mSortedValueCache = [[NSMutableDictionary alloc] init];
+		mIndexedKeys = @[];
+
+		// metadata notifications identify the object and key, so the indexes are maintained incrementally;
+		// add/remove of whole objects only marks the index stale - it is rebuilt by the next query
+
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(metadataWillChange:)
+													 name:kDKMetadataWillChangeNotification
+												   object:nil];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(metadataDidChange:)
+													 name:kDKMetadataDidChangeNotification
+												   object:nil];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(layerStructureDidChange:)
+													 name:kDKLayerDidAddObject
+												   object:aLayer];
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(layerStructureDidChange:)
+													 name:kDKLayerDidRemoveObject
+												   object:aLayer];
+	}
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (DKObjectOwnerLayer*)layer
+{
+	return mLayerRef;
+}
+
+#pragma mark -
+#pragma mark - registering keys
+
+- (void)setIndexedKeys:(NSArray<NSString*>*)keys
+{
+	NSMutableArray* lc = [NSMutableArray arrayWithCapacity:[keys count]];
+
+	for (NSString* key in keys) {
+		if (![lc containsObject:[key lowercaseString]])
+			[lc addObject:[key lowercaseString]];
+	}
+
+	if (![lc isEqualToArray:mIndexedKeys]) {
+		mIndexedKeys = [lc copy];
+		[self markNeedsRebuild];
+	}
+}
+
+- (NSArray<NSString*>*)indexedKeys
+{
+	return mIndexedKeys;
+}
+
+- (BOOL)isKeyIndexed:(NSString*)key
+{
+	return [mIndexedKeys containsObject:[key lowercaseString]];
+}
+
+- (void)markNeedsRebuild
+{
+	mNeedsRebuild = YES;
+}
+
+#pragma mark -
+#pragma mark - queries
+
+- (NSArray<DKDrawableObject*>*)objectsWithValue:(id)value forKey:(NSString*)key
+{
+	NSAssert(value != nil, @"cannot query for a nil value");
+	NSAssert(key != nil, @"cannot query a nil key");
+
+	key = [key lowercaseString];
+	[self rebuildIfNeeded];
+
+	if ([self isKeyIndexed:key])
+		return [[[mIndexes objectForKey:key] objectForKey:value] allObjects] ?: @[];
+
+	// not indexed - fall back to a linear scan so the API always answers
+
+	NSMutableArray* result = [NSMutableArray array];
+
+	for (DKDrawableObject* obj in [[self layer] objects]) {
+		if ([[self localValueOfObject:obj
+							   forKey:key] isEqual:value])
+			[result addObject:obj];
+	}
+
+	return result;
+}
+
+- (NSArray<DKDrawableObject*>*)objectsWithValuesFrom:(id)minValue to:(id)maxValue forKey:(NSString*)key
+{
+	NSAssert(key != nil, @"cannot query a nil key");
+
+	key = [key lowercaseString];
+	[self rebuildIfNeeded];
+
+	NSMutableArray* result = [NSMutableArray array];
+
+	if ([self isKeyIndexed:key]) {
+		// walk the sorted distinct values rather than the objects - for dense indexes this visits
+		// far fewer items than the object count
+
+		NSDictionary* valueMap = [mIndexes objectForKey:key];
+
+		for (id value in [self sortedValuesForKey:key]) {
+			if (minValue && [value compare:minValue] == NSOrderedAscending)
+				continue;
+			if (maxValue && [value compare:maxValue] == NSOrderedDescending)
+				break;
+
+			[result addObjectsFromArray:[[valueMap objectForKey:value] allObjects]];
+		}
+	} else {
+		for (DKDrawableObject* obj in [[self layer] objects]) {
+			id value = [self localValueOfObject:obj
+										 forKey:key];
+
+			if (value == nil)
+				continue;
+			if (minValue && [value compare:minValue] == NSOrderedAscending)
+				continue;
+			if (maxValue && [value compare:maxValue] == NSOrderedDescending)
+				continue;
+
+			[result addObject:obj];
+		}
+	}
+
+	return result;
+}
+
+#pragma mark -
+#pragma mark - maintenance
+
+- (id)localValueOfObject:(DKDrawableObject*)obj forKey:(NSString*)key
+{
+	// the object's own value only - inherited (container) metadata is common to every object in the
+	// layer, so indexing it would be meaningless
+
+	return [[obj metadataItemForKey:key
+				 limitToLocalSearch:YES] value];
+}
+
+- (void)rebuildIfNeeded
+{
+	if (!mNeedsRebuild)
+		return;
+
+	mNeedsRebuild = NO;
+	[mIndexes removeAllObjects];
+	[mObjectValues removeAllObjects];
+	[mSortedValueCache removeAllObjects];
+
+	if ([mIndexedKeys count] == 0)
+		return;
+
+	NSArray* objects = [[self layer] objects];
+
+	LogEvent_(kReactiveEvent, @"metadata index rebuilding over %lu objects, keys: %@", (unsigned long)[objects count], mIndexedKeys);
+
+	for (DKDrawableObject* obj in objects) {
+		for (NSString* key in mIndexedKeys)
+			[self indexObject:obj
+					   forKey:key];
+	}
+}
+
+- (void)indexObject:(DKDrawableObject*)obj forKey:(NSString*)key
+{
+	id value = [self localValueOfObject:obj
+								 forKey:key];
+
+	if (value == nil)
+		return;
+
+	NSMutableDictionary* valueMap = [mIndexes objectForKey:key];
+
+	if (valueMap == nil) {
+		valueMap = [NSMutableDictionary dictionary];
+		[mIndexes setObject:valueMap
+					 forKey:key];
+	}
+
+	NSMutableSet* objects = [valueMap objectForKey:value];
+
+	if (objects == nil) {
+		objects = [NSMutableSet set];
+		[valueMap setObject:objects
+					 forKey:value];
+		[mSortedValueCache removeObjectForKey:key];
+	}
+
+	[objects addObject:obj];
+
+	NSMutableDictionary* reverse = [mObjectValues objectForKey:obj];
+
+	if (reverse == nil) {
+		reverse = [NSMutableDictionary dictionary];
+		[mObjectValues setObject:reverse
+						  forKey:obj];
+	}
+
+	[reverse setObject:value
+				forKey:key];
+}
+
+- (void)deindexObject:(DKDrawableObject*)obj forKey:(NSString*)key
+{
+	// the reverse map records the exact value the object was indexed under, so removal does not
+	// depend on the object's current (possibly already mutated) metadata
+
+	NSMutableDictionary* reverse = [mObjectValues objectForKey:obj];
+	id oldValue = [reverse objectForKey:key];
+
+	if (oldValue == nil)
+		return;
+
+	NSMutableDictionary* valueMap = [mIndexes objectForKey:key];
+	NSMutableSet* objects = [valueMap objectForKey:oldValue];
+
+	[objects removeObject:obj];
+
+	if ([objects count] == 0) {
+		[valueMap removeObjectForKey:oldValue];
+		[mSortedValueCache removeObjectForKey:key];
+	}
+
+	[reverse removeObjectForKey:key];
+}
+
+- (NSArray*)sortedValuesForKey:(NSString*)key
+{
+	NSArray* sorted = [mSortedValueCache objectForKey:key];
+
+	if (sorted == nil) {
+		sorted = [[[mIndexes objectForKey:key] allKeys] sortedArrayUsingSelector:@selector(compare:)];
+		[mSortedValueCache setObject:sorted
+							  forKey:key];
+	}
+
+	return sorted;
+}
+
+#pragma mark -
+#pragma mark - notification handlers
+
+- (void)metadataWillChange:(NSNotification*)note
+{
+	DKDrawableObject* obj = [note object];
+
+	// only top-level objects of our layer are indexed - grouped objects have the group as container
+
+	if (mNeedsRebuild || ![obj isKindOfClass:[DKDrawableObject class]] || (id)[obj container] != [self layer])
+		return;
+
+	NSString* key = [[note userInfo] objectForKey:@"key"];
+
+	if (key) {
+		if ([self isKeyIndexed:key])
+			[self deindexObject:obj
+						 forKey:key];
+	} else {
+		// wholesale change (e.g. -setMetadata:) - deindex the object entirely
+
+		for (NSString* indexedKey in mIndexedKeys)
+			[self deindexObject:obj
+						 forKey:indexedKey];
+	}
+}
+
+- (void)metadataDidChange:(NSNotification*)note
+{
+	DKDrawableObject* obj = [note object];
+
+	if (mNeedsRebuild || ![obj isKindOfClass:[DKDrawableObject class]] || (id)[obj container] != [self layer])
+		return;
+
+	NSString* key = [[note userInfo] objectForKey:@"key"];
+
+	if (key) {
+		if ([self isKeyIndexed:key])
+			[self indexObject:obj
+					   forKey:key];
+	} else {
+		for (NSString* indexedKey in mIndexedKeys)
+			[self indexObject:obj
+					   forKey:indexedKey];
+	}
+}
+
+- (void)layerStructureDidChange:(NSNotification*)note
+{
+#pragma unused(note)
+
+	[self markNeedsRebuild];
+}
+
+@end
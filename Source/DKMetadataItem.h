@@ -109,6 +109,36 @@ DKMetadataItems are used to store metadata (attribute) values in user info dicti
  */
 + (BOOL)writeMetadataItems:(NSArray<DKMetadataItem*>*)items forKeys:(NSArray<NSString*>*)keys toPasteboard:(NSPasteboard*)pb;
 
+// compact archiving
+
+/** @brief Whether metadata dictionaries are written to archives as a single compact data blob.
+
+ @discussion Keyed archiving treats every metadata item as a separate object, and decoding the resulting
+ plist structure dominates the time taken to dearchive metadata-heavy drawings. When this is enabled (the
+ default), objects and layers write their whole metadata dictionary as one compact blob which is decoded
+ by a dedicated reader directly into pre-sized storage. Dictionaries containing item types the compact
+ format cannot represent, and all existing files, continue to use keyed archiving - the reader always
+ accepts both. Turn this off to write files readable by versions of DrawKit that predate the compact
+ format. The setting is persistent.
+ */
++ (void)setCompactArchivingEnabled:(BOOL)enable;
++ (BOOL)compactArchivingEnabled;
+
+/** @brief Serializes a dictionary of metadata items as a single compact data blob.
+
+ @discussion Only items whose stored values are strings, numbers, dates, URLs or raw data can be
+ represented, which covers every type except attributed string, image and colour. Returns \c nil if the
+ dictionary contains an item the format cannot carry, in which case the caller should fall back to
+ keyed archiving.
+ */
++ (nullable NSData*)compactDataWithMetadataItemDictionary:(NSDictionary<NSString*, DKMetadataItem*>*)aDict;
+
+/** @brief Reconstitutes a dictionary of metadata items from a compact data blob.
+
+ @discussion Returns \c nil if the data is not a well-formed compact metadata blob.
+ */
++ (nullable NSMutableDictionary<NSString*, DKMetadataItem*>*)metadataItemDictionaryWithCompactData:(NSData*)data;
+
 // initializing various types of metadata item
 
 - (instancetype)initWithType:(DKMetadataType)type NS_DESIGNATED_INITIALIZER;
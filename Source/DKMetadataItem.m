@@ -19,6 +19,57 @@ NSString* DKMultipleMetadataItemsPBoardType = @"com.apptree.dk.multimeta";
 
 #pragma mark -
 
+// compact archiving support. The blob layout is a fixed header (magic, format version, item count) followed by one
+// record per item: the key (uint16 length + UTF8 bytes), the item type (int8) and a typed payload. Multi-byte fields
+// are stored native-endian; every platform the framework builds for is little-endian.
+
+static NSString* const kDKCompactArchivingDefaultsKey = @"DKMetadataItem_noCompactArchiving";
+
+#define kDKCompactMetadataMagic 0x444B6D69 // 'DKmi'
+#define kDKCompactMetadataVersion 1
+
+typedef struct {
+	const uint8_t* bytes;
+	NSUInteger length;
+	NSUInteger pos;
+} DKCompactMetadataReader;
+
+static BOOL readerGetBytes(DKCompactMetadataReader* r, void* outBuffer, NSUInteger len)
+{
+	if (len > r->length - r->pos)
+		return NO;
+
+	memcpy(outBuffer, r->bytes + r->pos, len);
+	r->pos += len;
+	return YES;
+}
+
+static NSString* readerGetString(DKCompactMetadataReader* r, NSUInteger len)
+{
+	if (len > r->length - r->pos)
+		return nil;
+
+	NSString* str = [[NSString alloc] initWithBytes:r->bytes + r->pos
+											 length:len
+										   encoding:NSUTF8StringEncoding];
+	r->pos += len;
+	return str;
+}
+
+static BOOL appendLengthPrefixedData(NSMutableData* blob, NSData* data)
+{
+	if (data == nil || [data length] > UINT32_MAX)
+		return NO;
+
+	uint32_t len = (uint32_t)[data length];
+	[blob appendBytes:&len
+			   length:sizeof(len)];
+	[blob appendData:data];
+	return YES;
+}
+
+#pragma mark -
+
 @implementation DKMetadataItem
 
 + (Class)classForType:(DKMetadataType)type
@@ -357,6 +408,255 @@ NSString* DKMultipleMetadataItemsPBoardType = @"com.apptree.dk.multimeta";
 			   forType:DKMultipleMetadataItemsPBoardType];
 }
 
+#pragma mark -
+#pragma mark - compact archiving
+
++ (void)setCompactArchivingEnabled:(BOOL)enable
+{
+	[[NSUserDefaults standardUserDefaults] setBool:!enable
+											forKey:kDKCompactArchivingDefaultsKey];
+}
+
++ (BOOL)compactArchivingEnabled
+{
+	return ![[NSUserDefaults standardUserDefaults] boolForKey:kDKCompactArchivingDefaultsKey];
+}
+
++ (NSData*)compactDataWithMetadataItemDictionary:(NSDictionary<NSString*, DKMetadataItem*>*)aDict
+{
+	NSMutableData* blob = [NSMutableData dataWithCapacity:16 + [aDict count] * 48];
+
+	uint32_t magic = kDKCompactMetadataMagic;
+	uint8_t version = kDKCompactMetadataVersion;
+	uint32_t count = (uint32_t)[aDict count];
+
+	[blob appendBytes:&magic
+			   length:sizeof(magic)];
+	[blob appendBytes:&version
+			   length:sizeof(version)];
+	[blob appendBytes:&count
+			   length:sizeof(count)];
+
+	for (NSString* key in aDict) {
+		DKMetadataItem* item = [aDict objectForKey:key];
+		id value = [item value];
+
+		if (![item isKindOfClass:[DKMetadataItem class]] || value == nil)
+			return nil;
+
+		NSData* keyBytes = [key dataUsingEncoding:NSUTF8StringEncoding];
+
+		if (keyBytes == nil || [keyBytes length] > UINT16_MAX)
+			return nil;
+
+		uint16_t keyLength = (uint16_t)[keyBytes length];
+		[blob appendBytes:&keyLength
+				   length:sizeof(keyLength)];
+		[blob appendData:keyBytes];
+
+		int8_t type = (int8_t)[item type];
+		[blob appendBytes:&type
+				   length:sizeof(type)];
+
+		switch ([item type]) {
+		case DKMetadataTypeString:
+		case DKMetadataTypeSize:
+		case DKMetadataTypePoint:
+		case DKMetadataTypeRect:
+			// size, point and rect items store their value as a string (see -setSize: et al), so these share the string payload
+
+			if (![value isKindOfClass:[NSString class]] || !appendLengthPrefixedData(blob, [value dataUsingEncoding:NSUTF8StringEncoding]))
+				return nil;
+			break;
+
+		case DKMetadataTypeInteger: {
+			int64_t v = [value longLongValue];
+			[blob appendBytes:&v
+					   length:sizeof(v)];
+			break;
+		}
+
+		case DKMetadataTypeUnsignedInt: {
+			uint64_t v = [value unsignedLongLongValue];
+			[blob appendBytes:&v
+					   length:sizeof(v)];
+			break;
+		}
+
+		case DKMetadataTypeReal: {
+			double v = [value doubleValue];
+			[blob appendBytes:&v
+					   length:sizeof(v)];
+			break;
+		}
+
+		case DKMetadataTypeBoolean: {
+			uint8_t v = [value boolValue] ? 1 : 0;
+			[blob appendBytes:&v
+					   length:sizeof(v)];
+			break;
+		}
+
+		case DKMetadataTypeDate: {
+			if (![value isKindOfClass:[NSDate class]])
+				return nil;
+
+			double v = [value timeIntervalSinceReferenceDate];
+			[blob appendBytes:&v
+					   length:sizeof(v)];
+			break;
+		}
+
+		case DKMetadataTypeURL:
+			if (![value isKindOfClass:[NSURL class]] || !appendLengthPrefixedData(blob, [[value absoluteString] dataUsingEncoding:NSUTF8StringEncoding]))
+				return nil;
+			break;
+
+		case DKMetadataTypeData:
+		case DKMetadataTypeImageData:
+			if (![value isKindOfClass:[NSData class]] || !appendLengthPrefixedData(blob, value))
+				return nil;
+			break;
+
+		default:
+			// attributed strings, images and colours have no compact representation - fall back to keyed archiving
+
+			return nil;
+		}
+	}
+
+	return blob;
+}
+
++ (NSMutableDictionary<NSString*, DKMetadataItem*>*)metadataItemDictionaryWithCompactData:(NSData*)data
+{
+	DKCompactMetadataReader reader = { [data bytes], [data length], 0 };
+
+	uint32_t magic = 0;
+	uint8_t version = 0;
+	uint32_t count = 0;
+
+	if (!readerGetBytes(&reader, &magic, sizeof(magic)) || magic != kDKCompactMetadataMagic)
+		return nil;
+
+	if (!readerGetBytes(&reader, &version, sizeof(version)) || version != kDKCompactMetadataVersion)
+		return nil;
+
+	if (!readerGetBytes(&reader, &count, sizeof(count)))
+		return nil;
+
+	NSMutableDictionary<NSString*, DKMetadataItem*>* dict = [NSMutableDictionary dictionaryWithCapacity:count];
+
+	for (uint32_t i = 0; i < count; ++i) {
+		uint16_t keyLength = 0;
+
+		if (!readerGetBytes(&reader, &keyLength, sizeof(keyLength)))
+			return nil;
+
+		NSString* key = readerGetString(&reader, keyLength);
+		int8_t type = 0;
+
+		if (key == nil || !readerGetBytes(&reader, &type, sizeof(type)))
+			return nil;
+
+		id value = nil;
+
+		switch ((DKMetadataType)type) {
+		case DKMetadataTypeString:
+		case DKMetadataTypeSize:
+		case DKMetadataTypePoint:
+		case DKMetadataTypeRect:
+		case DKMetadataTypeURL: {
+			uint32_t length = 0;
+
+			if (!readerGetBytes(&reader, &length, sizeof(length)))
+				return nil;
+
+			value = readerGetString(&reader, length);
+
+			if ((DKMetadataType)type == DKMetadataTypeURL && value != nil)
+				value = [NSURL URLWithString:value];
+			break;
+		}
+
+		case DKMetadataTypeInteger: {
+			int64_t v = 0;
+
+			if (!readerGetBytes(&reader, &v, sizeof(v)))
+				return nil;
+
+			value = [NSNumber numberWithInteger:(NSInteger)v];
+			break;
+		}
+
+		case DKMetadataTypeUnsignedInt: {
+			uint64_t v = 0;
+
+			if (!readerGetBytes(&reader, &v, sizeof(v)))
+				return nil;
+
+			value = [NSNumber numberWithUnsignedInteger:(NSUInteger)v];
+			break;
+		}
+
+		case DKMetadataTypeReal: {
+			double v = 0;
+
+			if (!readerGetBytes(&reader, &v, sizeof(v)))
+				return nil;
+
+			value = [NSNumber numberWithDouble:v];
+			break;
+		}
+
+		case DKMetadataTypeBoolean: {
+			uint8_t v = 0;
+
+			if (!readerGetBytes(&reader, &v, sizeof(v)))
+				return nil;
+
+			value = [NSNumber numberWithBool:v != 0];
+			break;
+		}
+
+		case DKMetadataTypeDate: {
+			double v = 0;
+
+			if (!readerGetBytes(&reader, &v, sizeof(v)))
+				return nil;
+
+			value = [NSDate dateWithTimeIntervalSinceReferenceDate:v];
+			break;
+		}
+
+		case DKMetadataTypeData:
+		case DKMetadataTypeImageData: {
+			uint32_t length = 0;
+
+			if (!readerGetBytes(&reader, &length, sizeof(length)) || length > reader.length - reader.pos)
+				return nil;
+
+			value = [data subdataWithRange:NSMakeRange(reader.pos, length)];
+			reader.pos += length;
+			break;
+		}
+
+		default:
+			return nil;
+		}
+
+		if (value == nil)
+			return nil;
+
+		DKMetadataItem* item = [[DKMetadataItem alloc] initWithType:(DKMetadataType)type];
+		[item assignValue:value];
+		[dict setObject:item
+				 forKey:key];
+	}
+
+	return dict;
+}
+
 #pragma mark -
 
 // designated initializer:
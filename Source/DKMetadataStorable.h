@@ -67,4 +67,10 @@ NS_ASSUME_NONNULL_BEGIN
 extern NSNotificationName const kDKMetadataWillChangeNotification;
 extern NSNotificationName const kDKMetadataDidChangeNotification;
 
+/** posted once per runloop turn per object after one or more metadata changes, via the notification
+ queue with coalescing. Observers that only need to know "this object's metadata changed this turn"
+ (inspectors, palettes) should prefer this over \c kDKMetadataDidChangeNotification, which fires
+ synchronously for every individual mutation. */
+extern NSNotificationName const kDKMetadataChangesDidOccurNotification;
+
 NS_ASSUME_NONNULL_END
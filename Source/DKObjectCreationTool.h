@@ -24,6 +24,9 @@ You can also set up a style to be applied to all new objects initially as an ind
 @interface DKObjectCreationTool : DKDrawingTool {
 @private
 	id<NSCopying, NSObject> m_prototypeObject;
+	NSImage* mPrototypeSwatch; // cached swatch image for the prototype, rebuilt when the prototype or its style changes
+	BOOL mSwatchIsProvisional; // YES while the cached swatch is a placeholder or a previous launch's render
+	BOOL mSwatchRenderPending; // YES while an async swatch render is in flight
 	BOOL mEnableStylePickup;
 	BOOL mDidPickup;
 	NSPoint mLastPoint;
@@ -87,7 +90,12 @@ You can also set up a style to be applied to all new objects initially as an ind
 
 /** @brief Return an image showing what the tool creates
 
- The image may be used as an icon for this tool in a UI, for example
+ The image may be used as an icon for this tool in a UI, for example. Rendering the prototype's
+ swatch can be arbitrarily expensive for complex styles, so it is produced asynchronously: until the
+ render completes this returns a stand-in - the swatch this style rendered in a previous launch if
+ one is on disk, or a generic placeholder - and posts
+ \c kDKDrawingToolDidRenderPrototypeSwatchNotification once the real swatch is ready, at which point
+ callers should re-fetch it.
  @return an image
  */
 - (nullable NSImage*)image;
@@ -99,4 +107,7 @@ You can also set up a style to be applied to all new objects initially as an ind
 extern NSNotificationName const kDKDrawingToolWillMakeNewObjectNotification;
 extern NSNotificationName const kDKDrawingToolCreatedObjectsStyleDidChange;
 
+/** @brief Posted on the main thread when an asynchronously rendered prototype swatch becomes available; object is the tool. */
+extern NSNotificationName const kDKDrawingToolDidRenderPrototypeSwatchNotification;
+
 NS_ASSUME_NONNULL_END
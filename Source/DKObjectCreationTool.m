@@ -17,10 +17,64 @@
 #pragma mark Contants(Non - localized)
 NSString* const kDKDrawingToolWillMakeNewObjectNotification = @"kDKDrawingToolWillMakeNewObjectNotification";
 NSString* const kDKDrawingToolCreatedObjectsStyleDidChange = @"kDKDrawingToolCreatedObjectsStyleDidChange";
+NSString* const kDKDrawingToolDidRenderPrototypeSwatchNotification = @"kDKDrawingToolDidRenderPrototypeSwatchNotification";
 
 #pragma mark Static Vars
 static DKStyle* sCreatedObjectsStyle = nil;
 
+#pragma mark Static Functions
+
+static NSString* swatchCacheDirectory(void)
+{
+	// swatches rendered for a style are kept in the user's caches directory so the next launch can
+	// stand them in immediately while the fresh render is still in flight
+
+	static NSString* sDir = nil;
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		NSString* base = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+		NSString* bundleID = [[NSBundle mainBundle] bundleIdentifier];
+
+		if (bundleID == nil)
+			bundleID = @"DrawKit";
+
+		sDir = [[base stringByAppendingPathComponent:bundleID] stringByAppendingPathComponent:@"DKToolSwatches"];
+		[[NSFileManager defaultManager] createDirectoryAtPath:sDir
+								  withIntermediateDirectories:YES
+												   attributes:nil
+														error:NULL];
+	});
+
+	return sDir;
+}
+
+static NSImage* genericSwatchPlaceholder(void)
+{
+	// shared stand-in shown until a prototype's real swatch has rendered
+
+	static NSImage* sPlaceholder = nil;
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		sPlaceholder = [[NSImage alloc] initWithSize:kDKDefaultToolSwatchSize];
+		[sPlaceholder lockFocus];
+
+		NSRect r = NSInsetRect(NSMakeRect(0, 0, kDKDefaultToolSwatchSize.width, kDKDefaultToolSwatchSize.height), 6, 6);
+		NSBezierPath* path = [NSBezierPath bezierPathWithRoundedRect:r
+															 xRadius:4
+															 yRadius:4];
+
+		[[NSColor secondarySelectedControlColor] set];
+		[path setLineWidth:2.0];
+		[path stroke];
+
+		[sPlaceholder unlockFocus];
+	});
+
+	return sPlaceholder;
+}
+
 @interface DKObjectCreationTool ()
 
 - (BOOL)finishCreation:(DKToolController*)controller;
@@ -95,13 +149,45 @@ static DKStyle* sCreatedObjectsStyle = nil;
 		if (m_prototypeObject == nil) {
 			return nil;
 		}
+
+		// the cached swatch depends on the prototype's style, so an edit to the style must throw it away
+
+		[[NSNotificationCenter defaultCenter] addObserver:self
+												 selector:@selector(prototypeStyleDidChange:)
+													 name:kDKStyleDidChangeNotification
+												   object:nil];
 	}
 	return self;
 }
 
+- (void)dealloc
+{
+	[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
 #pragma mark -
 
-@synthesize prototype = m_prototypeObject;
+- (void)setPrototype:(id<NSCopying, NSObject>)aPrototype
+{
+	m_prototypeObject = aPrototype;
+	mPrototypeSwatch = nil;
+	mSwatchIsProvisional = NO;
+}
+
+- (id<NSCopying, NSObject>)prototype
+{
+	return m_prototypeObject;
+}
+
+- (void)prototypeStyleDidChange:(NSNotification*)note
+{
+	// the swatch renders the prototype with its own style, so only that style matters here
+
+	if ([self prototype] != nil && [(DKDrawableObject*)[self prototype] respondsToSelector:@selector(style)] && [note object] == [(DKDrawableObject*)[self prototype] style]) {
+		mPrototypeSwatch = nil;
+		mSwatchIsProvisional = NO;
+	}
+}
 
 /** @brief Return a new object copied from the prototype, but with the current class style if there is one
 
@@ -132,6 +218,9 @@ static DKStyle* sCreatedObjectsStyle = nil;
 	// sets the style for the prototype (and hence subsequently created objects). This setting is overridden by
 	// a style set for the class as a whole.
 
+	mPrototypeSwatch = nil;
+	mSwatchIsProvisional = NO;
+
 	if ([[self prototype] respondsToSelector:_cmd])
 		[(DKDrawableObject*)[self prototype] setStyle:aStyle];
 }
@@ -157,7 +246,89 @@ static DKStyle* sCreatedObjectsStyle = nil;
  */
 - (NSImage*)image
 {
-	return [(id)[self prototype] swatchImageWithSize:kDKDefaultToolSwatchSize];
+	// rendering the swatch means fully rasterizing the prototype's style, which can be arbitrarily
+	// complex, so the real render happens off the main thread and a stand-in is returned until it
+	// completes - the swatch this style rendered in a previous launch if one is on disk, else a
+	// generic placeholder. -setPrototype: and style edits throw the cache away.
+
+	if ([self prototype] == nil)
+		return nil;
+
+	if (mPrototypeSwatch != nil && !mSwatchIsProvisional)
+		return mPrototypeSwatch;
+
+	if (mPrototypeSwatch == nil) {
+		NSString* path = [self swatchCachePath];
+		NSImage* stored = (path != nil) ? [[NSImage alloc] initWithContentsOfFile:path] : nil;
+
+		mPrototypeSwatch = (stored != nil) ? stored : genericSwatchPlaceholder();
+		mSwatchIsProvisional = YES;
+	}
+
+	[self renderSwatchAsync];
+
+	return mPrototypeSwatch;
+}
+
+- (NSString*)swatchCachePath
+{
+	// the persistent cache is keyed by the style's unique key, which survives archiving, so the same
+	// style yields the same file across launches. A prototype with no style has no stable key and is
+	// not cached on disk.
+
+	DKStyle* style = [self style];
+
+	if (style == nil)
+		return nil;
+
+	NSString* filename = [NSString stringWithFormat:@"%@_%dx%d.tiff", [style uniqueKey], (int)kDKDefaultToolSwatchSize.width, (int)kDKDefaultToolSwatchSize.height];
+
+	return [swatchCacheDirectory() stringByAppendingPathComponent:filename];
+}
+
+- (void)renderSwatchAsync
+{
+	if (mSwatchRenderPending)
+		return;
+
+	mSwatchRenderPending = YES;
+
+	id prototype = [self prototype];
+	DKStyle* style = [self style];
+	NSUInteger styleGeneration = [style changeGeneration];
+	NSString* path = [self swatchCachePath];
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSImage* swatch = [(id)prototype swatchImageWithSize:kDKDefaultToolSwatchSize];
+
+		// the fresh render always overwrites the disk entry, so an edit made to the style in a past
+		// session can only ever show as a stand-in for the duration of one render
+
+		if (swatch != nil && path != nil)
+			[[swatch TIFFRepresentation] writeToFile:path
+										  atomically:YES];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			self->mSwatchRenderPending = NO;
+
+			// discard the result if the prototype or its style moved on while rendering - the next
+			// -image call starts over against the current state
+
+			if (swatch != nil && prototype == [self prototype] && style == [self style] && styleGeneration == [style changeGeneration]) {
+				self->mPrototypeSwatch = swatch;
+				self->mSwatchIsProvisional = NO;
+
+				[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingToolDidRenderPrototypeSwatchNotification
+																	object:self];
+			}
+		});
+	});
+}
+
+- (void)prewarm
+{
+	[super prewarm];
+	[self image];
 }
 
 /** @brief Complete the object creation cleanly
@@ -79,6 +79,18 @@ typedef NS_OPTIONS(NSUInteger, DKAlignmentAlign) {
  */
 - (void)alignObjects:(NSArray<DKDrawableObject*>*)objects toLocation:(NSPoint)loc withAlignment:(DKAlignmentAlign)align;
 
+/** @brief Moves a set of objects by individual offsets as a single bulk operation.
+
+ This is the workhorse that the alignment and distribution methods apply their precomputed moves
+ through. The entire move undoes as one action (the per-object undo registration that moving each
+ object would otherwise perform is suppressed), the view is invalidated once with the union of the
+ affected areas, and the moves are applied in the order the objects are kept by the layer's storage
+ rather than the arbitrary order of the input array.
+ @param objects The objects to move.
+ @param offsets An array of point values (NSValue), one per object, giving each object's offset.
+ */
+- (void)moveObjects:(NSArray<DKDrawableObject*>*)objects byOffsets:(NSArray<NSValue*>*)offsets;
+
 /** @brief Aligns the objects to the grid, resizing and positioning as necessary so that all edges lie on
  the grid. The logical bounds is used for alignment, consistent with normal snapping behaviour.
 
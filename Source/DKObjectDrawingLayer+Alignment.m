@@ -89,15 +89,92 @@
 
 		mb = [object apparentBounds];
 
+		// compute all of the target offsets first, then apply them in one bulk operation
+
+		NSMutableArray<DKDrawableObject*>* moved = [NSMutableArray arrayWithCapacity:[objects count]];
+		NSMutableArray<NSValue*>* offsets = [NSMutableArray arrayWithCapacity:[objects count]];
+
 		for (id mo in objects) {
 			if (mo != object) {
 				ob = [mo apparentBounds];
 				alignOffset = DKCalculateAlignmentOffset(mb, ob, align);
-				[mo offsetLocationByX:alignOffset.x
-								  byY:alignOffset.y];
+
+				[moved addObject:mo];
+				[offsets addObject:[NSValue valueWithPoint:alignOffset]];
+			}
+		}
+
+		[self moveObjects:moved
+				byOffsets:offsets];
+	}
+}
+
+- (void)moveObjects:(NSArray<DKDrawableObject*>*)objects byOffsets:(NSArray<NSValue*>*)offsets
+{
+	NSAssert([objects count] == [offsets count], @"objects and offsets counts differ");
+
+	if ([objects count] == 0)
+		return;
+
+	// a bulk move undoes as a single bulk move with the offsets negated, so the per-object undo
+	// registration that moving each object would perform is disabled while the moves are applied
+
+	NSMutableArray<NSValue*>* inverse = [NSMutableArray arrayWithCapacity:[offsets count]];
+
+	for (NSValue* v in offsets) {
+		NSPoint o = [v pointValue];
+		[inverse addObject:[NSValue valueWithPoint:NSMakePoint(-o.x, -o.y)]];
+	}
+
+	[[[self undoManager] prepareWithInvocationTarget:self] moveObjects:objects
+															 byOffsets:inverse];
+
+	// map each object to its offset so the moves can be applied in the order the storage keeps the
+	// objects, which touches memory far more predictably than the arbitrary order of the input array
+
+	NSMapTable<DKDrawableObject*, NSValue*>* moveMap = [NSMapTable strongToStrongObjectsMapTable];
+	NSUInteger i;
+
+	for (i = 0; i < [objects count]; ++i)
+		[moveMap setObject:[offsets objectAtIndex:i]
+					forKey:[objects objectAtIndex:i]];
+
+	[self beginDeferredUpdates];
+	[[self undoManager] disableUndoRegistration];
+
+	for (DKDrawableObject* obj in [self objects]) {
+		NSValue* v = [moveMap objectForKey:obj];
+
+		if (v) {
+			NSPoint o = [v pointValue];
+
+			[obj offsetLocationByX:o.x
+							   byY:o.y];
+			[moveMap removeObjectForKey:obj];
+
+			if ([moveMap count] == 0)
+				break;
+		}
+	}
+
+	// anything not found in the storage (not normally the case) is still moved so that the
+	// registered undo remains the exact inverse of the operation
+
+	if ([moveMap count] > 0) {
+		for (i = 0; i < [objects count]; ++i) {
+			DKDrawableObject* obj = [objects objectAtIndex:i];
+
+			if ([moveMap objectForKey:obj] != nil) {
+				NSPoint o = [[offsets objectAtIndex:i] pointValue];
+
+				[obj offsetLocationByX:o.x
+								   byY:o.y];
 			}
 		}
 	}
+
+	[[self undoManager] enableUndoRegistration];
+	[self endDeferredUpdates];
 }
 
 /** @brief Aligns a set of objects to a given point
@@ -127,6 +204,11 @@
 {
 	NSAssert(grid != nil, @"grid parameter is nil");
 
+	// grid alignment can resize as well as move so it retains per-object undo, but the view is
+	// still only invalidated once for the whole set
+
+	[self beginDeferredUpdates];
+
 	for (DKDrawableObject* mo in objects) {
 		if ([mo respondsToSelector:@selector(adjustToFitGrid:)]) {
 			[(id)mo adjustToFitGrid:grid];
@@ -145,16 +227,29 @@
 			[mo setOffset:offset];
 		}
 	}
+
+	[self endDeferredUpdates];
 }
 
 - (void)alignObjectLocation:(NSArray<DKDrawableObject*>*)objects toGrid:(DKGridLayer*)grid
 {
 	NSAssert(grid != nil, @"grid parameter is nil");
 
+	// precompute the snap offsets, then apply them as one bulk move
+
+	NSMutableArray<DKDrawableObject*>* moved = [NSMutableArray arrayWithCapacity:[objects count]];
+	NSMutableArray<NSValue*>* offsets = [NSMutableArray arrayWithCapacity:[objects count]];
+
 	for (DKDrawableObject* mo in objects) {
-		NSPoint p = [grid nearestGridIntersectionToPoint:[mo location]];
-		[mo setLocation:p];
+		NSPoint loc = [mo location];
+		NSPoint p = [grid nearestGridIntersectionToPoint:loc];
+
+		[moved addObject:mo];
+		[offsets addObject:[NSValue valueWithPoint:NSMakePoint(p.x - loc.x, p.y - loc.y)]];
 	}
+
+	[self moveObjects:moved
+			byOffsets:offsets];
 }
 
 #pragma mark -
@@ -258,6 +353,12 @@
 	if (numToAlign < 3)
 		return NO;
 
+	// each distribution computes all of its offsets up front and applies them through the bulk
+	// move API, so the whole operation costs one undo task and one invalidation
+
+	NSMutableArray<DKDrawableObject*>* moved = [NSMutableArray arrayWithCapacity:numToAlign];
+	NSMutableArray<NSValue*>* offsets = [NSMutableArray arrayWithCapacity:numToAlign];
+
 	if (align & kDKAlignmentAlignVDistribution) {
 		sorted = [self objectsSortedByVerticalPosition:objects];
 
@@ -271,20 +372,20 @@
 
 		//	LogEvent_(kReactiveEvent, @"vertically distributing %d objects, increment = %f, span = %f", numToAlign, spanIncrement, spanDistance );
 
-		NSPoint cp;
+		// iterate through the objects between the two, computing each one's vertical offset
 
-		// iterate through the objects between the two, setting their vertical position accordingly
+		[moved removeAllObjects];
+		[offsets removeAllObjects];
 
 		for (i = 1; i < (numToAlign - 1); i++) {
 			mo = [sorted objectAtIndex:i];
 
-			cp.x = [mo location].x;
-			cp.y = min + ((CGFloat)i * spanIncrement);
-
-			//	LogEvent_(kReactiveEvent,  @"positioning object %d, {%f, %f}", i, cp.x, cp.y );
-
-			[mo setLocation:cp];
+			[moved addObject:mo];
+			[offsets addObject:[NSValue valueWithPoint:NSMakePoint(0, min + ((CGFloat)i * spanIncrement) - [mo location].y)]];
 		}
+
+		[self moveObjects:moved
+				byOffsets:offsets];
 	}
 
 	if (align & kDKAlignmentAlignHDistribution) {
@@ -298,18 +399,20 @@
 		spanDistance = max - min; //NSMidX( bottom ) - NSMidX( top );
 		spanIncrement = spanDistance / (CGFloat)(numToAlign - 1);
 
-		NSPoint cp;
+		// iterate through the objects between the two, computing each one's horizontal offset
 
-		// iterate through the objects between the two, setting their vertical position accordingly
+		[moved removeAllObjects];
+		[offsets removeAllObjects];
 
 		for (i = 1; i < (numToAlign - 1); i++) {
 			mo = [sorted objectAtIndex:i];
 
-			cp.y = [mo location].y;
-			cp.x = min + ((CGFloat)i * spanIncrement);
-
-			[mo setLocation:cp];
+			[moved addObject:mo];
+			[offsets addObject:[NSValue valueWithPoint:NSMakePoint(min + ((CGFloat)i * spanIncrement) - [mo location].x, 0)]];
 		}
+
+		[self moveObjects:moved
+				byOffsets:offsets];
 	}
 
 	if (align & kDKAlignmentAlignVSpaceDistribution) {
@@ -326,26 +429,34 @@
 		if (space > 0.0) {
 			//	LogEvent_(kReactiveEvent, @"distributing space = %f among %d objects", space, numToAlign );
 
-			NSPoint cp;
+			CGFloat dy;
+
+			[moved removeAllObjects];
+			[offsets removeAllObjects];
 
 			for (i = 0; i < numToAlign - 1; i++) {
 				mo = [sorted objectAtIndex:i];
 				mobr = [mo logicalBounds];
 
 				if (i > 0) {
-					cp.x = [mo location].x;
-
 					// top edge of this object is bottom edge of last + spaceEach, but we are calculating the
-					// centre
+					// centre. As the move is a pure translation, the moved bounds can be predicted without
+					// applying it, so each object's dependence on its predecessor's new position is resolved
+					// here and all of the moves applied in one bulk operation afterwards.
 
 					nte = NSMaxY(prevBounds) + spaceEach;
-					cp.y = NSMidY(mobr) - NSMinY(mobr) + nte;
+					dy = NSMidY(mobr) - NSMinY(mobr) + nte - [mo location].y;
+
+					[moved addObject:mo];
+					[offsets addObject:[NSValue valueWithPoint:NSMakePoint(0, dy)]];
 
-					[mo setLocation:cp];
-					mobr = [mo logicalBounds];
+					mobr = NSOffsetRect(mobr, 0, dy);
 				}
 				prevBounds = mobr;
 			}
+
+			[self moveObjects:moved
+					byOffsets:offsets];
 		}
 	}
 
@@ -363,26 +474,32 @@
 		if (space > 0.0) {
 			//	LogEvent_(kReactiveEvent, @"distributing space = %f among %d objects", space, numToAlign );
 
-			NSPoint cp;
+			CGFloat dx;
+
+			[moved removeAllObjects];
+			[offsets removeAllObjects];
 
 			for (i = 0; i < numToAlign - 1; i++) {
 				mo = [sorted objectAtIndex:i];
 				mobr = [mo logicalBounds];
 
 				if (i > 0) {
-					cp.y = [mo location].y;
-
-					// top edge of this object is bottom edge of last + spaceEach, but we are calculating the
-					// centre
+					// left edge of this object is right edge of last + spaceEach - resolved prospectively
+					// as in the vertical case above
 
 					nte = NSMaxX(prevBounds) + spaceEach;
-					cp.x = NSMidX(mobr) - NSMinX(mobr) + nte;
+					dx = NSMidX(mobr) - NSMinX(mobr) + nte - [mo location].x;
+
+					[moved addObject:mo];
+					[offsets addObject:[NSValue valueWithPoint:NSMakePoint(dx, 0)]];
 
-					[mo setLocation:cp];
-					mobr = [mo logicalBounds];
+					mobr = NSOffsetRect(mobr, dx, 0);
 				}
 				prevBounds = mobr;
 			}
+
+			[self moveObjects:moved
+					byOffsets:offsets];
 		}
 	}
 
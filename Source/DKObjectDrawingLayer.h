@@ -9,7 +9,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKShapeGroup;
+@class DKShapeGroup, DKMetadataIndex, DKSelectionSummary, DKStyle;
 
 /** @brief This layer adds the concept of selection to drawable objects as defined by DKObjectOwnerLayer.
 
@@ -36,6 +36,7 @@ NS_ASSUME_NONNULL_BEGIN
 	NSRect m_dragExcludeRect; // drags will become "real" once this rect is left
 	BOOL m_selectionIsUndoable; // YES if selection changes tracked by undo
 	BOOL m_drawSelectionOnTop; // YES if selection highlights are drawn in a pseudo-layer on top of all objects
+	BOOL mSelectionInOverlay; // YES if selection highlights are drawn in the view overlay plane rather than the content plane
 	BOOL m_selectionVisible; // YES if selection is actually drawn
 	BOOL m_allowDragTargeting; // YES if the layer can target individual objects when receiving a drag/drop
 	BOOL mMultipleAutoForwarding; // YES to automatically forward actions to all objects in the selection that can respond
@@ -44,6 +45,11 @@ NS_ASSUME_NONNULL_BEGIN
 	NSArray<DKDrawableObject*>* m_objectsPendingDrag; // temporary list of objects being dragged from the layer
 	__unsafe_unretained DKDrawableObject* mKeyAlignmentObject; // the master object to which others can be aligned
 	NSRect mSelBoundsCached; // cached value of the selection bounds
+	NSMutableSet<DKDrawableObject*>* mMarqueeHits; // bounds-level hits maintained incrementally during a marquee drag
+	NSRect mLastMarqueeRect; // the marquee rect as of the previous incremental query
+	NSMutableDictionary* mPasteboardSnapshots; // per-pasteboard snapshots backing lazily provided (promised) clipboard data
+	DKMetadataIndex* mMetadataIndex; // inverted metadata indexes backing the metadata query API (lazily created)
+	DKSelectionSummary* mSelectionSummary; // cached selection summary for inspectors (lazily built, extended in place on single adds)
 }
 
 // default settings:
@@ -164,6 +170,14 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)refreshSelectedObjects;
 
+/** @brief Refreshes just the selection visuals (highlights) of the given objects
+
+ When \c drawsSelectionInOverlay is in force this invalidates only the objects' highlight refresh
+ rects in the overlay plane; otherwise it falls back to a full visual refresh of each object.
+ @param container a container of drawable objects
+ */
+- (void)refreshSelectionVisualsOfObjects:(id<NSFastEnumeration>)container;
+
 /** @brief Changes the location of all objects in the selection by dx and dy
  @param dx add this much to each object's x coordinate
  @param dy add this much to each object's y coordinate
@@ -252,6 +266,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)exchangeSelectionWithObjectsFromArray:(NSArray<DKDrawableObject*>*)sel;
 
+/** @brief Returns the objects to show as selected for the given marquee (drag selection) rect
+
+ This is intended to be called repeatedly during a marquee drag. It maintains the hit list incrementally:
+ objects already in the list are dropped when their bounds leave the rect, and only the regions newly covered
+ since the previous call are queried for objects entering it, so the per-event cost tracks the size of the
+ rect delta rather than the size of the layer. For speed the test is bounds-level only - the precise
+ path-level test (-objectsInRect:) should be applied once, when the drag completes. The incremental state
+ is discarded by <code>-endMarqueeSelection</code>, which must be called when the drag ends.
+ @param rect the current marquee rect
+ @return the objects whose bounds intersect the rect
+ */
+- (NSArray<DKDrawableObject*>*)objectsInMarqueeRect:(NSRect)rect;
+
+/** @brief Discards the incremental state maintained by <code>-objectsInMarqueeRect:</code>
+ */
+- (void)endMarqueeSelection;
+
 /** @brief Scrolls one or all views attached to the drawing so that the selection within this layer is visible
  @param aView if not nil, the view to scroll. If nil, scrolls all views
  */
@@ -276,6 +307,26 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)replaceStyle:(DKStyle*)style withStyle:(DKStyle*)newStyle selectingObjects:(BOOL)select;
 
+/** @brief Applies a style to a list of objects as a single transaction.
+
+ Equivalent to calling \c -setStyle: on each object but records one coalesced undo action for the
+ whole list and merges the per-object invalidations into a single update area, so styling a very
+ large selection does not register thousands of undo tasks or flag thousands of tiny rects. The
+ style's sharable flag is honoured as usual. The caller should set an undo action name.
+ @param aStyle The style to apply, or \c nil to remove the objects' styles.
+ @param objects The objects to style.
+ */
+- (void)setStyle:(nullable DKStyle*)aStyle forObjects:(NSArray<DKDrawableObject*>*)objects;
+
+/** @brief Undo entry point for <code>-setStyle:forObjects:</code>.
+
+ Reinstates per-object styles captured by the transaction, registering the inverse so the
+ operation toggles between its two states on undo and redo.
+ @param styles The styles to reinstate, parallel to <code>objects</code>; \c NSNull stands for no style.
+ @param objects The objects to restyle.
+ */
+- (void)restoreStyles:(NSArray*)styles forObjects:(NSArray<DKDrawableObject*>*)objects;
+
 // useful selection tests:
 
 /** @brief Query whether a given object is selected or not
@@ -309,6 +360,17 @@ NS_ASSUME_NONNULL_BEGIN
 @property (readonly) NSRect selectionBounds;
 @property (readonly) NSRect selectionLogicalBounds;
 
+/** @brief Return a precomputed summary of the selection for inspector-style clients
+
+ The summary carries the selection count, the union of the selected objects' bounds and the style
+ common to every selected object (nil if the styles differ or nothing is selected). It is cached
+ and maintained from the selection delta where possible - adding a single object extends the
+ existing summary rather than re-scanning the selection - so inspectors can query it on every
+ selection change without an O(n) cost per notification. The returned object is a snapshot; it is
+ not updated if the selection subsequently changes.
+ */
+@property (readonly, strong) DKSelectionSummary* selectionSummary;
+
 // selection undo stuff:
 
 /** @brief Set whether selection changes should be recorded for undo.
@@ -374,6 +436,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSData*)pdfDataOfSelectedObjects;
 
+/** @brief Creates a PDF representation of the selected objects asynchronously
+
+ As pdfDataOfSelectedObjects, but without blocking the main thread while a large selection renders.
+ The selection is snapshotted (deep copies with detached styles) on the calling thread, rendered
+ into a PDF context on a background queue, and \c completion is called on the main queue with the
+ data, or \c nil if the selection was empty or rendering failed. Must be called from the main thread.
+ @param completion called on the main queue with the PDF data */
+- (void)pdfDataOfSelectedObjectsWithCompletion:(void (^)(NSData* _Nullable pdfData))completion;
+
 // clipboard ops:
 
 /** @brief Copies the selection to the given pasteboard in a variety of formats
@@ -394,6 +465,37 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property BOOL drawsSelectionHighlightsOnTop;
 
+/** @brief Whether selection highlights are drawn in the view's overlay plane instead of the content plane.
+
+ When enabled (and the highlights are drawn on top), the active layer's selection visuals are drawn into
+ the same overlay plane used for transient tool feedback, and selection changes invalidate only the
+ highlight rects there (see <code>-[DKDrawableObject selectionHighlightRefreshRects]</code>) - a select-all
+ over a dense layer then repaints only handle pixels instead of re-rendering every object. Views without
+ an overlay, printing, and inactive layers showing their selection all fall back to the content plane.
+ Default is NO; the setting is saved with the layer.
+ */
+@property (nonatomic) BOOL drawsSelectionInOverlay;
+
+/** @brief Draws just the selection highlights into the view's overlay plane.
+
+ Called by the tool controller when the overlay redraws and \c drawsSelectionInOverlay is in force.
+ @param rect the update rect in the overlay
+ @param aView the overlay view being drawn
+ */
+- (void)drawSelectionOverlayRect:(NSRect)rect inView:(NSView*)aView;
+
+/** @brief Whether selection highlights are currently being routed to the overlay plane.
+
+ \c YES only when \c drawsSelectionInOverlay and \c drawsSelectionHighlightsOnTop are both set and the
+ layer is active - in all other situations highlights are drawn in the content plane as usual.
+ */
+@property (readonly) BOOL selectionIsDrawnInOverlay;
+
+/** @brief Marks a rect of the overlay plane of all attached views as needing display.
+ @param rect the rect to invalidate, in drawing coordinates
+ */
+- (void)setSelectionOverlayNeedsDisplayInRect:(NSRect)rect;
+
 /** @brief Whether a drag into this layer will target individual objects or not.
 
  If YES, the object under the mouse will highlight as a drag into the layer proceeds, and upon drop,
@@ -487,6 +589,45 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)didUngroupObjects:(NSArray<__kindof DKShapeGroup*>*)ungroupedObjects;
 
+// metadata queries:
+
+/** @brief The metadata keys for which inverted indexes are maintained.
+
+ For layers holding very many objects, the metadata query methods below answer in time proportional
+ to the result rather than the object count for any key listed here - a \c DKMetadataIndex keeps a
+ map from value to objects per key, maintained incrementally from the metadata change notifications.
+ Keys are case-insensitive, matching the metadata API, and the list is archived with the layer.
+ Queries against keys not listed fall back to a linear scan, so indexing is purely an optimisation.
+ The default is an empty list.
+ */
+@property (nonatomic, copy) NSArray<NSString*>* indexedMetadataKeys;
+
+/** @brief Returns the objects whose own metadata value for \c key equals <code>value</code>.
+
+ A single hash lookup when \c key is indexed (see <code>indexedMetadataKeys</code>), a linear scan
+ otherwise. Only each object's local metadata is considered, not values inherited from containers.
+ @param value the value to match, of the class the metadata stores (NSString, NSNumber, etc)
+ @param key the metadata key
+ @return the matching objects, unordered
+ */
+- (NSArray<DKDrawableObject*>*)objectsWithMetadataValue:(id)value forKey:(NSString*)key;
+
+/** @brief Returns the objects whose own metadata value for \c key lies between the bounds, inclusive.
+
+ Values are ordered using <code>-compare:</code>; either bound may be nil to leave that end open.
+ @param minValue the lower bound, or nil for no lower bound
+ @param maxValue the upper bound, or nil for no upper bound
+ @param key the metadata key
+ @return the matching objects, unordered
+ */
+- (NSArray<DKDrawableObject*>*)objectsWithMetadataValuesFrom:(nullable id)minValue to:(nullable id)maxValue forKey:(NSString*)key;
+
+/** @brief Replaces the selection with the objects matching the given metadata value.
+ @param value the value to match
+ @param key the metadata key
+ */
+- (void)selectObjectsWithMetadataValue:(id)value forKey:(NSString*)key;
+
 // user actions:
 
 /** @brief Perform a cut
@@ -671,4 +812,25 @@ enum {
 extern NSNotificationName const kDKLayerSelectionDidChange;
 extern NSNotificationName const kDKLayerKeyObjectDidChange;
 
+#pragma mark -
+
+/** @brief A cheap, precomputed digest of a layer's selection.
+
+ Vended by -[DKObjectDrawingLayer selectionSummary] and consumed by inspectors that only need the
+ headline facts about the selection - how many objects, their overall bounds and whether they all
+ share one style - without walking the selection themselves.
+ */
+@interface DKSelectionSummary : NSObject
+
+/** @brief The number of selected objects. */
+@property (readonly) NSUInteger count;
+
+/** @brief The style shared by every selected object, or \c nil if styles differ or the selection is empty. */
+@property (readonly, strong, nullable) DKStyle* commonStyle;
+
+/** @brief The union of the selected objects' bounds; \c NSZeroRect for an empty selection. */
+@property (readonly) NSRect bounds;
+
+@end
+
 NS_ASSUME_NONNULL_END
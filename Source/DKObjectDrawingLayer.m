@@ -7,8 +7,10 @@
 #import "DKObjectDrawingLayer.h"
 #import "DKDrawablePath.h"
 #import "DKDrawing.h"
+#import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
 #import "DKImageShape.h"
+#import "DKMetadataIndex.h"
 #import "DKObjectDrawingLayer+Alignment.h"
 #import "DKPasteboardInfo.h"
 #import "DKRuntimeHelper.h"
@@ -17,6 +19,7 @@
 #import "DKStyle.h"
 #import "DKTextShape.h"
 #import "DKUndoManager.h"
+#import "DKViewController.h"
 #import "LogEvent.h"
 #import "NSMutableArray+DKAdditions.h"
 
@@ -56,6 +59,11 @@ enum {
 - (BOOL)isBufferingSelectionChanges;
 - (void)bufferObject:(id)obj forSelectionOp:(NSInteger)op;
 
+- (NSData*)pdfDataWithDrawables:(NSArray*)objects inRect:(NSRect)sr;
+- (void)discardPasteboardSnapshot:(NSPasteboard*)pb;
+
+- (DKMetadataIndex*)metadataIndex;
+
 @end
 
 #pragma mark -
@@ -371,6 +379,15 @@ enum {
 - (void)refreshSelectedObjects
 {
 	[self refreshObjectsInContainer:[self selection]];
+
+	// at transition points (activation changes, option toggles) either plane may hold stale selection
+	// pixels, so the overlay is refreshed as well whenever it may be in use. Pure selection membership
+	// changes use -refreshSelectionVisualsOfObjects: instead, which touches only one plane.
+
+	if (mSelectionInOverlay) {
+		for (DKDrawableObject* obj in [self selection])
+			[self setSelectionOverlayNeedsDisplayInRect:[obj bounds]];
+	}
 }
 
 /** @brief Changes the location of all objects in the selection by dx and dy
@@ -414,15 +431,16 @@ enum {
 			if ([self selectionChangesAreUndoable] || [[self undoManager] isUndoing] || [[self undoManager] isRedoing])
 				[[[self undoManager] prepareWithInvocationTarget:self] setSelection:[self selection]];
 
-			[self refreshSelectedObjects];
+			[self refreshSelectionVisualsOfObjects:m_selection];
 			[m_selection makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
 
 			NSMutableSet* temp = [sel mutableCopy];
 			m_selection = temp;
 			mSelBoundsCached = NSZeroRect;
+			mSelectionSummary = nil;
 
 			[m_selection makeObjectsPerformSelector:@selector(objectDidBecomeSelected)];
-			[self refreshSelectedObjects];
+			[self refreshSelectionVisualsOfObjects:m_selection];
 			[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 																object:self];
 		}
@@ -475,11 +493,12 @@ enum {
 - (void)deselectAll
 {
 	if ([self isSelectionNotEmpty]) {
-		[self refreshSelectedObjects];
+		[self refreshSelectionVisualsOfObjects:m_selection];
 		[m_selection makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
 		[m_selection removeAllObjects];
 		[self hideRulerMarkers];
 		mSelBoundsCached = NSZeroRect;
+		mSelectionSummary = nil;
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 															object:self];
 	}
@@ -506,8 +525,25 @@ enum {
 	if (![m_selection containsObject:obj] && ![self lockedOrHidden] && [obj objectMayBecomeSelected]) {
 		[m_selection addObject:obj];
 		[obj objectDidBecomeSelected];
-		[obj notifyVisualChange];
+		[self refreshSelectionVisualsOfObjects:@[obj]];
 		mSelBoundsCached = NSZeroRect;
+
+		// a single add can extend the cached summary from the delta - no re-scan of the selection. A fresh
+		// snapshot is built so that summaries already handed out to inspectors are not mutated behind their backs.
+
+		if (mSelectionSummary != nil) {
+			DKSelectionSummary* extended = [[DKSelectionSummary alloc] init];
+
+			if (mSelectionSummary.count == 0) {
+				extended.commonStyle = [obj style];
+				extended.bounds = [obj bounds];
+			} else {
+				extended.commonStyle = (mSelectionSummary.commonStyle == [obj style]) ? mSelectionSummary.commonStyle : nil;
+				extended.bounds = NSUnionRect(mSelectionSummary.bounds, [obj bounds]);
+			}
+			extended.count = mSelectionSummary.count + 1;
+			mSelectionSummary = extended;
+		}
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 															object:self];
 	}
@@ -559,13 +595,14 @@ enum {
 			[self bufferObject:obj
 				forSelectionOp:kObjectRemove];
 		else {
-			[obj notifyVisualChange];
+			[self refreshSelectionVisualsOfObjects:@[obj]];
 			[obj objectIsNoLongerSelected];
 			[m_selection removeObject:obj];
 
 			[self updateRulerMarkersForRect:[self selectionLogicalBounds]];
 
 			mSelBoundsCached = NSZeroRect;
+			mSelectionSummary = nil;
 			[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 																object:self];
 		}
@@ -583,13 +620,14 @@ enum {
 
 	if (![self lockedOrHidden]) {
 		NSSet* removeSet = [NSSet setWithArray:objs];
-		[self refreshObjectsInContainer:objs];
+		[self refreshSelectionVisualsOfObjects:objs];
 		[objs makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
 		[m_selection minusSet:removeSet];
 
 		[self updateRulerMarkersForRect:[self selectionLogicalBounds]];
 
 		mSelBoundsCached = NSZeroRect;
+		mSelectionSummary = nil;
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 															object:self];
 	}
@@ -642,14 +680,15 @@ enum {
 					[newSel minusSet:m_selection]; // these are not present in the old selection, so will be selected
 
 					[oldSel makeObjectsPerformSelector:@selector(objectIsNoLongerSelected)];
-					[oldSel makeObjectsPerformSelector:@selector(notifyVisualChange)];
+					[self refreshSelectionVisualsOfObjects:oldSel];
 
 					[m_selection setSet:[NSSet setWithArray:sel]];
 
 					[newSel makeObjectsPerformSelector:@selector(objectDidBecomeSelected)];
-					[newSel makeObjectsPerformSelector:@selector(notifyVisualChange)];
+					[self refreshSelectionVisualsOfObjects:newSel];
 
 					mSelBoundsCached = NSZeroRect;
+					mSelectionSummary = nil;
 					[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerSelectionDidChange
 																		object:self];
 					didChange = YES;
@@ -663,6 +702,69 @@ enum {
 	return didChange;
 }
 
+- (NSArray*)objectsInMarqueeRect:(NSRect)rect
+{
+	// maintains the marquee hit list incrementally between calls. Objects cannot move while a marquee is being
+	// dragged, so hits can only change in the regions covered by the difference between this rect and the
+	// previous one - the entire layer never needs retesting. The test here is bounds-level only; the precise
+	// path-level query is applied once, on mouse up.
+
+	if (mMarqueeHits == nil) {
+		// first call of a drag - seed the list with a full (bounds-level) query
+
+		mMarqueeHits = [[NSMutableSet alloc] init];
+		mLastMarqueeRect = NSZeroRect;
+	}
+
+	// drop current members whose bounds have left the rect - only the members are tested
+
+	NSMutableSet* leavers = nil;
+
+	for (DKDrawableObject* obj in mMarqueeHits) {
+		if (!NSIntersectsRect([obj bounds], rect)) {
+			if (leavers == nil)
+				leavers = [NSMutableSet set];
+
+			[leavers addObject:obj];
+		}
+	}
+
+	if (leavers)
+		[mMarqueeHits minusSet:leavers];
+
+	// objects can only enter through the regions the rect newly covers, so only those are queried
+
+	NSSet* enteredRegions;
+
+	if (NSIsEmptyRect(mLastMarqueeRect))
+		enteredRegions = [NSSet setWithObject:[NSValue valueWithRect:rect]];
+	else
+		enteredRegions = SubtractTwoRects(rect, mLastMarqueeRect);
+
+	for (NSValue* rval in enteredRegions) {
+		NSRect dr = [rval rectValue];
+
+		if (NSIsEmptyRect(dr))
+			continue;
+
+		for (DKDrawableObject* obj in [self objectsForUpdateRect:dr
+														  inView:nil]) {
+			if ([obj visible] && NSIntersectsRect([obj bounds], rect))
+				[mMarqueeHits addObject:obj];
+		}
+	}
+
+	mLastMarqueeRect = rect;
+
+	return [mMarqueeHits allObjects];
+}
+
+- (void)endMarqueeSelection
+{
+	mMarqueeHits = nil;
+	mLastMarqueeRect = NSZeroRect;
+}
+
 /** @brief Scrolls one or all views attached to the drawing so that the selection within this layer is visible
  @param aView if not nil, the view to scroll. If nil, scrolls all views
  */
@@ -798,9 +900,8 @@ enum {
 {
 	NSArray* matches = [self objectsWithStyle:style];
 
-	for (DKDrawableObject* o in matches) {
-		[o setStyle:newStyle];
-	}
+	[self setStyle:newStyle
+		forObjects:matches];
 
 	if (selectObjects)
 		return [self exchangeSelectionWithObjectsFromArray:matches];
@@ -808,6 +909,86 @@ enum {
 		return NO;
 }
 
+/** @brief Applies a style to a list of objects as a single transaction.
+
+ Equivalent to calling \c -setStyle: on each object but records one coalesced undo action for the
+ whole list and merges the per-object invalidations into a single update area, so styling a very
+ large selection does not register thousands of undo tasks or flag thousands of tiny rects. The
+ style's sharable flag is honoured as usual. The caller should set an undo action name.
+ @param aStyle The style to apply, or \c nil to remove the objects' styles.
+ @param objects The objects to style.
+ */
+- (void)setStyle:(DKStyle*)aStyle forObjects:(NSArray<DKDrawableObject*>*)objects
+{
+	if (aStyle && ![aStyle isKindOfClass:[DKStyle class]])
+		return;
+
+	if ([objects count] == 0)
+		return;
+
+	// record the styles being replaced so the whole transaction undoes as one action
+
+	NSMutableArray* oldStyles = [NSMutableArray arrayWithCapacity:[objects count]];
+
+	for (DKDrawableObject* o in objects)
+		[oldStyles addObject:[o style] ? (id)[o style] : (id)[NSNull null]];
+
+	[[[self undoManager] prepareWithInvocationTarget:self] restoreStyles:oldStyles
+															  forObjects:objects];
+
+	// apply in one pass with per-object undo registration off and the invalidations deferred
+	// into a single union rect. -setStyle: still honours the sharable flag per object - a
+	// sharable style is attached shared, a non-sharable one is copied per object.
+
+	[self beginDeferredUpdates];
+	[[self undoManager] disableUndoRegistration];
+
+	@try {
+		for (DKDrawableObject* o in objects)
+			[o setStyle:aStyle];
+	}
+	@finally {
+		[[self undoManager] enableUndoRegistration];
+		[self endDeferredUpdates];
+	}
+}
+
+/** @brief Undo entry point for <code>-setStyle:forObjects:</code>.
+
+ Reinstates per-object styles captured by the transaction, registering the inverse so the
+ operation toggles between its two states on undo and redo.
+ @param styles The styles to reinstate, parallel to <code>objects</code>; \c NSNull stands for no style.
+ @param objects The objects to restyle.
+ */
+- (void)restoreStyles:(NSArray*)styles forObjects:(NSArray<DKDrawableObject*>*)objects
+{
+	NSAssert([styles count] == [objects count], @"style restoration arrays are mismatched");
+
+	NSMutableArray* current = [NSMutableArray arrayWithCapacity:[objects count]];
+
+	for (DKDrawableObject* o in objects)
+		[current addObject:[o style] ? (id)[o style] : (id)[NSNull null]];
+
+	[[[self undoManager] prepareWithInvocationTarget:self] restoreStyles:current
+															  forObjects:objects];
+
+	[self beginDeferredUpdates];
+	[[self undoManager] disableUndoRegistration];
+
+	@try {
+		NSUInteger i = 0;
+
+		for (DKDrawableObject* o in objects) {
+			id s = [styles objectAtIndex:i++];
+			[o setStyle:(s == (id)[NSNull null]) ? nil : s];
+		}
+	}
+	@finally {
+		[[self undoManager] enableUndoRegistration];
+		[self endDeferredUpdates];
+	}
+}
+
 #pragma mark -
 #pragma mark - useful selection tests
 
@@ -862,9 +1043,15 @@ enum {
 	mSelBoundsCached = NSZeroRect;
 
 	if ([self isSelectionNotEmpty]) {
-		for (DKDrawableObject* od in self.selection) {
-			mSelBoundsCached = UnionOfTwoRects(mSelBoundsCached, [od bounds]);
-		}
+		NSRect* bounds = (NSRect*)malloc([self.selection count] * sizeof(NSRect));
+		NSUInteger i = 0;
+
+		for (DKDrawableObject* od in self.selection)
+			bounds[i++] = [od bounds];
+
+		mSelBoundsCached = UnionOfRects(bounds, i);
+
+		free(bounds);
 	}
 	return mSelBoundsCached;
 }
@@ -874,13 +1061,55 @@ enum {
 	NSRect lbr = NSZeroRect;
 
 	if ([self isSelectionNotEmpty]) {
-		for (DKDrawableObject* od in self.selection) {
-			lbr = UnionOfTwoRects(lbr, [od logicalBounds]);
-		}
+		NSRect* bounds = (NSRect*)malloc([self.selection count] * sizeof(NSRect));
+		NSUInteger i = 0;
+
+		for (DKDrawableObject* od in self.selection)
+			bounds[i++] = [od logicalBounds];
+
+		lbr = UnionOfRects(bounds, i);
+
+		free(bounds);
 	}
 	return lbr;
 }
 
+- (DKSelectionSummary*)selectionSummary
+{
+	if (mSelectionSummary == nil) {
+		DKSelectionSummary* summary = [[DKSelectionSummary alloc] init];
+		NSUInteger selCount = [m_selection count];
+
+		summary.count = selCount;
+
+		if (selCount > 0) {
+			NSRect* bounds = (NSRect*)malloc(selCount * sizeof(NSRect));
+			NSUInteger i = 0;
+			DKStyle* common = nil;
+			BOOL first = YES;
+
+			for (DKDrawableObject* od in m_selection) {
+				bounds[i++] = [od bounds];
+
+				// styles are shared objects, so a pointer comparison is the right test for "same style"
+
+				if (first) {
+					common = [od style];
+					first = NO;
+				} else if (common != [od style])
+					common = nil;
+			}
+
+			summary.bounds = UnionOfRects(bounds, i);
+			summary.commonStyle = common;
+
+			free(bounds);
+		}
+		mSelectionSummary = summary;
+	}
+	return mSelectionSummary;
+}
+
 #pragma mark -
 #pragma mark - selection undo stuff
 
@@ -1066,12 +1295,106 @@ enum {
 	return pdfData;
 }
 
+/** @brief Creates a PDF representation of the selected objects asynchronously
+
+ The selection is deep-copied first so the worker renders only private objects. -copy returns shared
+ styles as-is, so each copy is also given a detached (mutable) style - the snapshot must not touch
+ anything the main thread could be drawing or editing concurrently. The copies are then drawn into a
+ PDF context on a background queue and the data handed to \c completion on the main queue.
+ @param completion called on the main queue with the PDF data, or nil if there was nothing to render */
+- (void)pdfDataOfSelectedObjectsWithCompletion:(void (^)(NSData* pdfData))completion
+{
+	NSAssert(completion != nil, @"completion block was nil");
+
+	NSArray* selection = [self selectedObjectsPreservingStackingOrder];
+	NSRect sr = [self selectionBounds];
+
+	if ([selection count] == 0) {
+		completion(nil);
+		return;
+	}
+
+	NSMutableArray<DKDrawableObject*>* snapshot = [NSMutableArray arrayWithCapacity:[selection count]];
+
+	for (DKDrawableObject* obj in selection) {
+		DKDrawableObject* copy = [obj copy];
+		[copy setStyle:[[obj style] mutableCopy]];
+		[copy detachSharedUserInfo]; // copies share user info copy-on-write; detach now so the originals can be freely edited while we render
+		[snapshot addObject:copy];
+	}
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		NSData* data = [self pdfDataWithDrawables:snapshot
+										   inRect:sr];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completion(data);
+		});
+	});
+}
+
+/** @brief Renders a list of drawables into PDF data, shifting \c sr to the media box origin.
+
+ This is the rendering core shared by the selection PDF methods and the promised pasteboard data.
+ The objects are drawn directly, without a view, so this may run on any thread provided the caller
+ owns the objects it passes in.
+ @param objects the drawables to render, in bottom-to-top order
+ @param sr the rect enclosing the objects, in drawing coordinates
+ @return the PDF data, or nil if there was nothing to render
+ */
+- (NSData*)pdfDataWithDrawables:(NSArray*)objects inRect:(NSRect)sr
+{
+	if ([objects count] == 0 || sr.size.width <= 0.0 || sr.size.height <= 0.0)
+		return nil;
+
+	NSMutableData* data = [NSMutableData data];
+	CGDataConsumerRef consumer = CGDataConsumerCreateWithCFData((__bridge CFMutableDataRef)data);
+	CGRect mediaBox = CGRectMake(0, 0, sr.size.width, sr.size.height);
+	CGContextRef pdfCtx = CGPDFContextCreate(consumer, &mediaBox, NULL);
+
+	CGDataConsumerRelease(consumer);
+
+	if (pdfCtx == NULL)
+		return nil;
+
+	CGPDFContextBeginPage(pdfCtx, NULL);
+
+	NSGraphicsContext* context = [NSGraphicsContext graphicsContextWithGraphicsPort:pdfCtx
+																			flipped:YES];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:context];
+
+	// flip to match the drawing's top-left coordinate system and shift the selection to the origin
+
+	NSAffineTransform* tfm = [NSAffineTransform transform];
+	[tfm scaleXBy:1.0 yBy:-1.0];
+	[tfm translateXBy:-sr.origin.x
+				  yBy:-(sr.origin.y + sr.size.height)];
+	[tfm concat];
+
+	for (DKDrawableObject* obj in objects)
+		[obj drawContentWithSelectedState:NO];
+
+	[NSGraphicsContext restoreGraphicsState];
+
+	CGPDFContextEndPage(pdfCtx);
+	CGPDFContextClose(pdfCtx);
+	CGContextRelease(pdfCtx);
+
+	return [data length] > 0 ? [data copy] : nil;
+}
+
 #pragma mark -
 #pragma mark - clipboard ops
 
 /** @brief Copies the selection to the given pasteboard in a variety of formats
 
- Data is recorded as native data, PDF and TIFF. Note that locked objects can't be copied as
+ The native type, PDF and TIFF representations are promised rather than written - a snapshot of the
+ selection is taken (cheap, since copies share their storage until mutated) and the data is built
+ from it in -pasteboard:provideDataForType: only if something actually asks for it. A paste or drop
+ within this application bypasses even that, duplicating the snapshot directly - see
+ +[DKDrawableObject nativeObjectsFromPasteboard:]. Note that locked objects can't be copied as
  native types, but images are still copied.
  @param pb the pasteboard to copy to
  */
@@ -1087,6 +1410,10 @@ enum {
 	if ([sel count] == 0)
 		[dataTypes removeObject:kDKDrawableObjectPasteboardType];
 
+	// discard any snapshot backing an earlier promise on this pasteboard
+
+	[self discardPasteboardSnapshot:pb];
+
 	[pb declareTypes:dataTypes
 			   owner:self];
 
@@ -1096,32 +1423,87 @@ enum {
 	DKPasteboardInfo* pbInfo = [DKPasteboardInfo pasteboardInfoForObjects:sel];
 	[pbInfo writeToPasteboard:pb];
 
-	if ([sel count] > 0) {
-		// convert selection to data by archiving it.
-		// DK's native pasteboard type is simply an archived array of the selection.
+	// snapshot the objects the promised types will be built from. The native type covers the available
+	// (unlocked) objects; the image types render everything selected, as before. The native snapshot is
+	// also registered under the info's session key so that an intra-application paste or drop can
+	// duplicate the objects directly, with no archiving at either end.
 
-		NSData* pbdata = [NSKeyedArchiver archivedDataWithRootObject:sel];
-		[pb setData:pbdata
-			forType:kDKDrawableObjectPasteboardType];
+	NSMutableArray* native = [NSMutableArray arrayWithCapacity:[sel count]];
 
-		// if a single object is selected, it is offered the chance to add further data to the clipboard
+	for (DKDrawableObject* obj in sel)
+		[native addObject:[obj copy]];
 
-		if ([sel count] == 1) {
-			DKDrawableObject* ss = [sel lastObject];
-			[ss writeSupplementaryDataToPasteboard:pb];
-		}
+	NSMutableArray* render = [NSMutableArray array];
+
+	for (DKDrawableObject* obj in [self selectedObjectsPreservingStackingOrder]) {
+		DKDrawableObject* copy = [obj copy];
+		[copy setStyle:[[obj style] mutableCopy]];
+		[render addObject:copy];
 	}
 
-	// add image of selection in PDF format:
-	NSData* pdf = [self pdfDataOfSelectedObjects];
-	[pb setData:pdf
-		forType:NSPasteboardTypePDF];
+	[pbInfo registerLocalObjects:native];
+
+	if (mPasteboardSnapshots == nil)
+		mPasteboardSnapshots = [[NSMutableDictionary alloc] init];
 
-	// and TIFF format:
+	[mPasteboardSnapshots setObject:@{ @"native": native,
+		@"render": render,
+		@"bounds": [NSValue valueWithRect:[self selectionBounds]],
+		@"sessionKey": [pbInfo sessionKey] }
+							 forKey:[pb name]];
 
-	NSImage* si = [self imageOfSelectedObjects];
-	[pb setData:[si TIFFRepresentation]
-		forType:NSPasteboardTypeTIFF];
+	// if a single object is selected, it is offered the chance to add further data to the clipboard
+
+	if ([sel count] == 1) {
+		DKDrawableObject* ss = [sel lastObject];
+		[ss writeSupplementaryDataToPasteboard:pb];
+	}
+}
+
+/** @brief Fulfils data promised by -copySelectionToPasteboard:
+
+ The data is built from the snapshot taken when the pasteboard was written, so it reflects the
+ objects as they were at that moment even if they have since been edited or deleted.
+ @param sender the pasteboard requesting the data
+ @param type the data type being requested
+ */
+- (void)pasteboard:(NSPasteboard*)sender provideDataForType:(NSPasteboardType)type
+{
+	NSDictionary* record = [mPasteboardSnapshots objectForKey:[sender name]];
+
+	if (record == nil)
+		return;
+
+	if ([type isEqualToString:kDKDrawableObjectPasteboardType]) {
+		[sender setData:[NSKeyedArchiver archivedDataWithRootObject:[record objectForKey:@"native"]]
+				forType:type];
+	} else if ([type isEqualToString:NSPasteboardTypePDF]) {
+		[sender setData:[self pdfDataWithDrawables:[record objectForKey:@"render"]
+											inRect:[[record objectForKey:@"bounds"] rectValue]]
+				forType:type];
+	} else if ([type isEqualToString:NSPasteboardTypeTIFF]) {
+		NSData* pdf = [self pdfDataWithDrawables:[record objectForKey:@"render"]
+										  inRect:[[record objectForKey:@"bounds"] rectValue]];
+		NSImage* image = pdf ? [[NSImage alloc] initWithData:pdf] : nil;
+		[sender setData:[image TIFFRepresentation]
+				forType:type];
+	}
+}
+
+/** @brief Called when something else takes over the pasteboard; releases the snapshot behind the promises. */
+- (void)pasteboardChangedOwner:(NSPasteboard*)sender
+{
+	[self discardPasteboardSnapshot:sender];
+}
+
+- (void)discardPasteboardSnapshot:(NSPasteboard*)pb
+{
+	NSDictionary* record = [mPasteboardSnapshots objectForKey:[pb name]];
+
+	if (record) {
+		[DKPasteboardInfo unregisterLocalObjectsForKey:[record objectForKey:@"sessionKey"]];
+		[mPasteboardSnapshots removeObjectForKey:[pb name]];
+	}
 }
 
 #pragma mark -
@@ -1148,6 +1530,91 @@ enum {
 	return m_drawSelectionOnTop;
 }
 
+/** @brief Sets whether selection highlights are drawn in the view's overlay plane instead of the content plane.
+
+ See the header for details. Turning this on creates the overlay planes up front so that the content and
+ overlay passes agree on where the selection is drawn, then repaints the selection in both planes.
+ @param inOverlay YES to draw selection highlights in the overlay plane
+ */
+- (void)setDrawsSelectionInOverlay:(BOOL)inOverlay
+{
+	if (inOverlay != mSelectionInOverlay) {
+		mSelectionInOverlay = inOverlay;
+
+		if (inOverlay) {
+			for (DKViewController* vc in [[self drawing] controllers]) {
+				if ([[vc view] isKindOfClass:[DKDrawingView class]])
+					[(DKDrawingView*)[vc view] toolOverlayView];
+			}
+		}
+
+		[self refreshSelectedObjects];
+	}
+}
+
+- (BOOL)drawsSelectionInOverlay
+{
+	return mSelectionInOverlay;
+}
+
+/** @brief Whether the selection visuals are currently routed to the overlay plane.
+
+ True only while this layer is active and draws its highlights on top - the overlay is drawn via the
+ active layer's tool controller, and interleaved (in situ) highlights cannot leave the content plane.
+ Inactive layers showing their selection use the content plane as before.
+ @return YES if selection drawing and invalidation target the overlay
+ */
+- (BOOL)selectionIsDrawnInOverlay
+{
+	return mSelectionInOverlay && m_drawSelectionOnTop && [self isActive];
+}
+
+/** @brief Mark a rect of the selection overlay for update in every attached view
+
+ The overlay is created lazily in views that do not have one yet; when that happens the selection is
+ also refreshed in the content plane once, so any highlight pixels drawn there before the overlay
+ existed are cleaned up.
+ @param rect the rect to invalidate, in drawing coordinates
+ */
+- (void)setSelectionOverlayNeedsDisplayInRect:(NSRect)rect
+{
+	BOOL created = NO;
+
+	for (DKViewController* vc in [[self drawing] controllers]) {
+		NSView* v = [vc view];
+
+		if ([v isKindOfClass:[DKDrawingView class]]) {
+			if (![(DKDrawingView*)v hasToolOverlay])
+				created = YES;
+
+			[(DKDrawingView*)v setToolOverlayNeedsDisplayInRect:rect];
+		}
+	}
+
+	if (created)
+		[self refreshObjectsInContainer:[self selection]];
+}
+
+/** @brief Repaint the selection visuals of the given objects in whichever plane they are drawn
+
+ This is the invalidation used for pure selection membership changes. When the selection lives in the
+ overlay only the objects' selection highlight rects are marked there, so selecting or deselecting any
+ number of objects never re-renders their content; otherwise the objects are refreshed as a whole.
+ @param container an array, set or other enumerable collection of drawables
+ */
+- (void)refreshSelectionVisualsOfObjects:(id<NSFastEnumeration>)container
+{
+	if ([self selectionIsDrawnInOverlay]) {
+		for (DKDrawableObject* obj in container) {
+			for (NSValue* rval in [obj selectionHighlightRefreshRects])
+				[self setSelectionOverlayNeedsDisplayInRect:[rval rectValue]];
+		}
+	} else {
+		for (DKDrawableObject* obj in container)
+			[obj notifyVisualChange];
+	}
+}
+
 /** @brief Sets whether a drag into this layer will target individual objects or not.
 
  If YES, the object under the mouse will highlight as a drag into the layer proceeds, and upon drop,
@@ -1356,6 +1823,51 @@ enum {
 #pragma unused(ungroupedObjects)
 }
 
+#pragma mark -
+#pragma mark - metadata queries
+
+- (DKMetadataIndex*)metadataIndex
+{
+	// created on demand - layers that never use the query API carry no index at all
+
+	if (mMetadataIndex == nil)
+		mMetadataIndex = [[DKMetadataIndex alloc] initWithLayer:self];
+
+	return mMetadataIndex;
+}
+
+- (void)setIndexedMetadataKeys:(NSArray<NSString*>*)keys
+{
+	if ([keys count] == 0 && mMetadataIndex == nil)
+		return;
+
+	[[self metadataIndex] setIndexedKeys:keys];
+}
+
+- (NSArray<NSString*>*)indexedMetadataKeys
+{
+	return mMetadataIndex ? [mMetadataIndex indexedKeys] : @[];
+}
+
+- (NSArray<DKDrawableObject*>*)objectsWithMetadataValue:(id)value forKey:(NSString*)key
+{
+	return [[self metadataIndex] objectsWithValue:value
+										   forKey:key];
+}
+
+- (NSArray<DKDrawableObject*>*)objectsWithMetadataValuesFrom:(id)minValue to:(id)maxValue forKey:(NSString*)key
+{
+	return [[self metadataIndex] objectsWithValuesFrom:minValue
+													to:maxValue
+												forKey:key];
+}
+
+- (void)selectObjectsWithMetadataValue:(id)value forKey:(NSString*)key
+{
+	[self exchangeSelectionWithObjectsFromArray:[self objectsWithMetadataValue:value
+																		forKey:key]];
+}
+
 #pragma mark -
 #pragma mark - user actions
 
@@ -2017,8 +2529,8 @@ enum {
 
 	if (sender && repObject && [self isSelectionNotEmpty]) {
 		if ([repObject isKindOfClass:[DKStyle class]]) {
-			[[self selectedAvailableObjects] makeObjectsPerformSelector:@selector(setStyle:)
-															 withObject:repObject];
+			[self setStyle:repObject
+				forObjects:[self selectedAvailableObjects]];
 			[[self undoManager] setActionName:NSLocalizedString(@"Apply Style", @"undo action for Apply Style")];
 		}
 	}
@@ -2167,6 +2679,12 @@ enum {
 
 				BOOL screen = [NSGraphicsContext currentContextDrawingToScreen];
 				BOOL drawSelected = [self selectionVisible] && screen && ([self isActive] || [[self class] selectionIsShownWhenInactive]) && ![self locked];
+
+				// when the selection lives in this view's overlay plane it is drawn there instead -
+				// see -drawSelectionOverlayRect:inView:
+
+				if (drawSelected && [self selectionIsDrawnInOverlay] && [aView isKindOfClass:[DKDrawingView class]] && [aView hasToolOverlay])
+					drawSelected = NO;
 				NSArray* objectsToDraw = [self objectsForUpdateRect:rect
 															 inView:aView];
 
@@ -2218,6 +2736,50 @@ enum {
 	RESTORE_GRAPHICS_CONTEXT
 }
 
+/** @brief Draws just the selection highlights into the view's overlay plane
+
+ Called by the tool controller when the overlay redraws and the selection is routed there. The content
+ pass omits the highlights in that case, so selection changes never re-render object content.
+ @param rect the update rect in the overlay
+ @param aView the overlay view being drawn
+ */
+- (void)drawSelectionOverlayRect:(NSRect)rect inView:(NSView*)aView
+{
+	if (![self selectionIsDrawnInOverlay] || ![self visible] || ![self selectionVisible] || [self locked])
+		return;
+
+	SAVE_GRAPHICS_CONTEXT
+
+	@autoreleasepool {
+		NSArray* objectsToDraw = [self objectsForUpdateRect:rect
+													 inView:aView];
+
+		for (DKDrawableObject* obj in objectsToDraw) {
+			if ([self isSelectedObject:obj])
+				[obj drawSelectedState];
+		}
+	}
+
+	RESTORE_GRAPHICS_CONTEXT
+}
+
+/** @brief Invalidate part of the layer on an object's behalf
+
+ In addition to the usual content invalidation, the same rect is mirrored into the selection overlay
+ when the object is selected and the selection lives there, so that editing or dragging a selected
+ object moves its handles along with it.
+ @param obj the object requesting the update
+ @param rect the rect needing display
+ */
+- (void)drawable:(DKDrawableObject*)obj needsDisplayInRect:(NSRect)rect
+{
+	[super drawable:obj
+		needsDisplayInRect:rect];
+
+	if ([self selectionIsDrawnInOverlay] && [m_selection containsObject:obj])
+		[self setSelectionOverlayNeedsDisplayInRect:rect];
+}
+
 /**
  Refreshes the selection when the layer becomes active
  */
@@ -2610,8 +3172,14 @@ enum {
 			   forKey:@"selundo"];
 	[coder encodeBool:m_drawSelectionOnTop
 			   forKey:@"selOnTop"];
+	[coder encodeBool:mSelectionInOverlay
+			   forKey:@"DKObjectDrawingLayer_selectionInOverlay"];
 	[coder encodeBool:[self allowsObjectsToBeTargetedByDrags]
 			   forKey:@"DKObjectDrawingLayer_allowDragTargets"];
+
+	if ([[self indexedMetadataKeys] count] > 0)
+		[coder encodeObject:[self indexedMetadataKeys]
+					 forKey:@"DKObjectDrawingLayer_indexedMetadataKeys"];
 }
 
 - (instancetype)initWithCoder:(NSCoder*)coder
@@ -2628,6 +3196,7 @@ enum {
 		m_selectionIsUndoable = [[self class] defaultSelectionChangesAreUndoable];
 
 		m_drawSelectionOnTop = [coder decodeBoolForKey:@"selOnTop"];
+		mSelectionInOverlay = [coder decodeBoolForKey:@"DKObjectDrawingLayer_selectionInOverlay"];
 		m_selectionVisible = YES;
 
 		if ([coder containsValueForKey:@"DKObjectDrawingLayer_allowDragTargets"])
@@ -2635,6 +3204,10 @@ enum {
 		else
 			[self setAllowsObjectsToBeTargetedByDrags:YES];
 
+		NSArray* indexedKeys = [coder decodeObjectForKey:@"DKObjectDrawingLayer_indexedMetadataKeys"];
+		if ([indexedKeys count] > 0)
+			[self setIndexedMetadataKeys:indexedKeys];
+
 		if (m_selection == nil) {
 			return nil;
 		}
@@ -2772,3 +3345,16 @@ enum {
 }
 
 @end
+
+#pragma mark -
+
+@interface DKSelectionSummary ()
+
+@property (readwrite) NSUInteger count;
+@property (readwrite, strong, nullable) DKStyle* commonStyle;
+@property (readwrite) NSRect bounds;
+
+@end
+
+@implementation DKSelectionSummary
+@end
@@ -11,7 +11,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawableObject, DKStyle;
+@class DKDrawableObject, DKStyle, DKLayerTileCache;
 
 /** @brief caching options
  */
@@ -19,7 +19,8 @@ typedef NS_OPTIONS(NSUInteger, DKLayerCacheOption) {
 	kDKLayerCacheNone = 0, //!< no caching
 	kDKLayerCacheUsingPDF = (1 << 0), //!< layer is cached in a PDF Image Rep
 	kDKLayerCacheUsingCGLayer = (1 << 1), //!< layer is cached in a CGLayer bitmap
-	kDKLayerCacheObjectOutlines = (1 << 2) //!< objects are drawn using a simple outline stroke only
+	kDKLayerCacheObjectOutlines = (1 << 2), //!< objects are drawn using a simple outline stroke only
+	kDKLayerCacheUsingTiles = (1 << 3) //!< rendered output is retained in a grid of offscreen tiles, invalidated per-object
 };
 
 // the class
@@ -63,6 +64,17 @@ application needs.
 	BOOL m_recordPasteOffset; // set to YES following a paste, and NO following a drag. When YES, paste offset is recorded.
 	NSInteger mPasteboardLastChange; // last change count recorded during a paste
 	NSInteger mPasteCount; // number of repeated paste operations since last new paste
+	DKLayerTileCache* mTileCache; // retained tile cache, used when the tile caching option is set
+	NSUInteger mUpdateDeferCount; // > 0 while a bulk operation is accumulating object update areas
+	NSRect mDeferredUpdateRect; // the union of the areas flagged while updates are deferred
+	BOOL mUsesRenderTimeBudget; // YES to interrupt drawing when the per-frame render budget expires
+	NSTimeInterval mRenderTimeBudget; // the per-frame render budget, in seconds
+	NSRect mPendingRenderRect; // region painted with a placeholder when the budget expired, awaiting continuation
+	NSUInteger mRenderProgressCount; // number of objects completed for the pending region (cached progress)
+	BOOL mUsesConcurrentRendering; // YES to render contiguous Z-spans of objects into bitmaps concurrently
+	NSData* mHibernatedObjectData; // compressed archive of the object graph while hibernated - see -hibernate
+	NSUInteger mHibernatedExpandedLength; // length of the archive before compression (0 = stored uncompressed)
+	NSUInteger mHibernatedObjectCount; // object count the layer reports while hibernated
 @protected
 	BOOL mShowStorageDebugging; // if YES, draws the debugging path for the storage on top (debugging feature only)
 }
@@ -87,6 +99,37 @@ application needs.
  */
 @property (nonatomic, strong) id<DKObjectStorage> storage;
 
+/** @}
+ @name Hibernation
+ @brief Dormant layers can trade their live object graph for a compressed archive.
+ @{ */
+
+/** @brief Whether the layer's objects are currently held as a compressed archive rather than live objects.
+ */
+@property (readonly, getter=isHibernated) BOOL hibernated;
+
+/** @brief Serializes the layer's objects to a compressed in-memory archive and drops the live graph.
+
+ Documents often carry many reference layers that are hidden and locked for the whole session, yet
+ their fully materialized object graphs (and per-object caches) stay resident. Hibernation archives
+ the objects, LZFSE-compresses the archive, and empties the storage, cutting the layer's footprint
+ to the compressed blob. Only a dormant layer may hibernate - it must be hidden, locked, not active
+ and have no pending object - otherwise this does nothing and returns NO. Rehydration is transparent:
+ making the layer visible, unlocking it, or accessing \c -objects (which saving does) restores the
+ live graph automatically. \c -countOfObjects answers without waking the layer. Not undoable; since
+ the objects are archived and restored wholesale, style sharing with objects on other layers is not
+ preserved across the round trip.
+ @return YES if the layer is hibernated on return
+ */
+- (BOOL)hibernate;
+
+/** @brief Restores the live object graph from the hibernation archive, if hibernated.
+
+ Called automatically on visibility and lock changes and on object access; call directly to
+ pre-warm a layer before it is needed.
+ */
+- (void)rehydrate;
+
 /** @}
  @name As A Container For A \c DKDrawableObject
  @{ */
@@ -393,6 +436,19 @@ application needs.
  */
 - (void)drawable:(DKDrawableObject*)obj needsDisplayInRect:(NSRect)rect;
 
+/** @brief Starts deferring the areas flagged by <code>-drawable:needsDisplayInRect:</code>.
+
+ While deferred, the flagged areas are accumulated into a single union rect rather than each
+ triggering its own view invalidation; the union is invalidated by the balancing call to
+ <code>-endDeferredUpdates</code>. Bulk operations that touch a large number of objects (such as
+ aligning or distributing them) use this to replace thousands of tiny invalidations with one.
+ Calls may be nested.
+ */
+- (void)beginDeferredUpdates;
+
+/** @brief Balances a call to <code>-beginDeferredUpdates</code>, invalidating the accumulated area. */
+- (void)endDeferredUpdates;
+
 /** @brief Draws all of the visible objects.
  
  This is used when drawing the layer into special contexts, not for view rendering.
@@ -541,14 +597,24 @@ application needs.
 
 /** @brief Moves the objects in the array to the given stacking position index.
 
- Useful for restacking several objects. Array passed can be the selection. The order of objects in
- the array is preserved relative to one another. After the operation the lowest indexed object
+ Useful for restacking several objects. Array passed can be the selection. The objects keep
+ their stacking order relative to one another. After the operation the lowest stacked object
  will be at \c indx and the rest at consecutive indexes above it.
  @param objs An array of objects already owned by the layer.
  @param indx The index they should be moved to.
  */
 - (void)moveObjectsInArray:(NSArray<DKDrawableObject*>*)objs toIndex:(NSUInteger)indx;
 
+/** @brief Restacks the layer's objects to the given permutation of them.
+
+ \c orderedObjects must contain exactly the layer's objects in the desired bottom-to-top order -
+ nothing is added or removed. This is the primitive behind the multiple-object restacking ops
+ (and their undo): the storage applies the new ordering in a single pass with one spatial-index
+ repair, so restacking any number of objects is linear.
+ @param orderedObjects The layer's objects in the desired stacking order.
+ */
+- (void)applyObjectOrdering:(NSArray<DKDrawableObject*>*)orderedObjects;
+
 /** @}
  @name Clipboard Ops
  @brief Clipboard ops and predictive pasting support.
@@ -701,6 +767,38 @@ application needs.
  */
 @property (nonatomic) DKLayerCacheOption layerCacheOption;
 
+/** @brief Whether screen drawing is limited by a per-frame time budget.
+
+ When set, objects are drawn in Z-order until \c renderTimeBudget expires for the current frame.
+ The region belonging to objects that did not get drawn is painted with a neutral placeholder and
+ automatically requeued, so the view stays responsive on any document and full fidelity converges
+ over the following few frames. Only applies to screen updates - printing and data capture always
+ render everything. The default is NO.
+ */
+@property (nonatomic) BOOL usesRenderTimeBudget;
+
+/** @brief The per-frame render budget, in seconds, applied when \c usesRenderTimeBudget is YES.
+
+ The default is 1/30 second. Values of zero or less disable the budget.
+ */
+@property (nonatomic) NSTimeInterval renderTimeBudget;
+
+/** @brief Whether screen drawing renders objects concurrently on multiple cores.
+
+ When set, the Z-sorted object list for an update is split into contiguous spans which are
+ rendered into per-thread transparent bitmaps in parallel, then composited in span order -
+ stacking is preserved exactly, and spatially disjoint content approaches a linear speedup.
+ Each span's bitmap is only as large as the area its objects touch.
+
+ Because objects and their styles are rendered off the main thread, content must not be
+ mutated while an update is in progress and styles shared between objects must be safe to
+ render concurrently. Only applies to screen updates, and only when enough objects need
+ drawing to repay the compositing overhead; printing and data capture always render
+ sequentially at full vector fidelity. Takes precedence below the tile cache and render
+ time budget options. The default is NO.
+ */
+@property (nonatomic) BOOL usesConcurrentRendering;
+
 /** @brief Set whether the layer is currently highlighted for a drag (receive) operation.
  Is \c YES if highlighted, \c NO otherwise.
  */
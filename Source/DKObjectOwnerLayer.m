@@ -13,13 +13,18 @@
 #import "DKGridLayer.h"
 #import "DKImageDataManager.h"
 #import "DKImageShape.h"
+#import "DKKeyedUnarchiver.h"
 #import "DKLayer+Metadata.h"
+#import "DKLayerTileCache.h"
 #import "DKPasteboardInfo.h"
+#import "DKPerformanceCounters.h"
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
 #import "DKTextShape.h"
+#import "DKUnarchivingHelper.h"
 #import "DKUndoManager.h"
 #import "LogEvent.h"
+#import <compression.h>
 
 // constants
 
@@ -31,8 +36,26 @@ NSString* const kDKLayerDidRemoveObject = @"kDKLayerDidRemoveObject";
 @interface DKObjectOwnerLayer ()
 - (void)updateCache;
 - (void)invalidateCache;
+- (void)drawUsingTileCacheInRect:(NSRect)rect;
+- (void)drawObjectsWithTimeBudgetInRect:(NSRect)rect inView:(DKDrawingView*)aView;
+- (void)continueInterruptedRender;
+- (void)drawObjectsConcurrentlyInRect:(NSRect)rect inView:(DKDrawingView*)aView;
 @end
 
+// the default per-frame render budget when usesRenderTimeBudget is set
+
+static const NSTimeInterval kDKDefaultRenderTimeBudget = 1.0 / 30.0;
+
+// how many objects are drawn between checks of the clock - polling the time after every object is
+// itself measurable when objects are simple
+
+static const NSUInteger kDKRenderBudgetPollInterval = 8;
+
+// the smallest span worth dispatching to another core when usesConcurrentRendering is set - below
+// this the bitmap allocation and compositing outweigh the rendering itself
+
+static const NSUInteger kDKConcurrentRenderMinSpanLength = 16;
+
 static Class sStorageClass = nil;
 static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
@@ -74,6 +97,161 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 @synthesize storage = mStorage;
 
+#pragma mark - hibernation
+
+/** returns the LZFSE-compressed archive, or nil when compression isn't worthwhile - the archive is
+ then held raw. */
+static NSData* DKHibernationCompress(NSData* archive)
+{
+	if ([archive length] < 512)
+		return nil;
+
+	size_t capacity = [archive length];
+	uint8_t* dst = (uint8_t*)malloc(capacity);
+	size_t written = compression_encode_buffer(dst, capacity, (const uint8_t*)[archive bytes], [archive length], NULL, COMPRESSION_LZFSE);
+
+	if (written == 0 || written >= capacity) {
+		free(dst);
+		return nil;
+	}
+
+	return [NSData dataWithBytesNoCopy:dst
+								length:written
+						  freeWhenDone:YES];
+}
+
+static NSData* DKHibernationExpand(NSData* blob, NSUInteger expandedLength)
+{
+	uint8_t* dst = (uint8_t*)malloc(expandedLength);
+
+	if (dst == NULL)
+		return nil;
+
+	size_t got = compression_decode_buffer(dst, expandedLength, (const uint8_t*)[blob bytes], [blob length], NULL, COMPRESSION_LZFSE);
+
+	if (got != expandedLength) {
+		free(dst);
+		return nil;
+	}
+
+	return [NSData dataWithBytesNoCopy:dst
+								length:expandedLength
+						  freeWhenDone:YES];
+}
+
+- (BOOL)isHibernated
+{
+	return mHibernatedObjectData != nil;
+}
+
+- (BOOL)hibernate
+{
+	if ([self isHibernated])
+		return YES;
+
+	// only a dormant layer may drop its live graph - anything visible, editable or mid-edit keeps it
+
+	if ([self visible] || ![self locked] || [self isActive] || mNewObjectPending != nil)
+		return NO;
+
+	NSArray* objects = [self objects];
+
+	if ([objects count] == 0)
+		return NO;
+
+	NSMutableData* data = [NSMutableData data];
+	NSKeyedArchiver* karch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+
+	[karch encodeObject:objects
+				 forKey:@"root"];
+	[karch finishEncoding];
+
+	NSData* compressed = DKHibernationCompress(data);
+
+	if (compressed != nil) {
+		mHibernatedExpandedLength = [data length];
+		mHibernatedObjectData = compressed;
+	} else {
+		mHibernatedExpandedLength = 0;
+		mHibernatedObjectData = [data copy];
+	}
+
+	mHibernatedObjectCount = [objects count];
+
+	// drop the live graph and every cache derived from it. The storage object itself is kept, so
+	// whatever spatial indexing scheme is in use rebuilds on rehydration.
+
+	[objects makeObjectsPerformSelector:@selector(setContainer:)
+							 withObject:nil];
+	[[self storage] setObjects:@[]];
+	mTileCache = nil;
+	[self invalidateCache];
+
+	LogEvent_(kInfoEvent, @"layer '%@' hibernated %lu objects into %lu bytes", [self layerName], (unsigned long)mHibernatedObjectCount, (unsigned long)[mHibernatedObjectData length]);
+
+	return YES;
+}
+
+- (void)rehydrate
+{
+	if (![self isHibernated])
+		return;
+
+	NSData* archive = mHibernatedObjectData;
+
+	if (mHibernatedExpandedLength > 0)
+		archive = DKHibernationExpand(archive, mHibernatedExpandedLength);
+
+	mHibernatedObjectData = nil;
+	mHibernatedExpandedLength = 0;
+	mHibernatedObjectCount = 0;
+
+	if (archive == nil) {
+		LogEvent_(kWheneverEvent, @"layer '%@' could not expand its hibernation archive", [self layerName]);
+		return;
+	}
+
+	// same decode setup as opening a file, so image data resolves through the drawing's image manager
+
+	DKKeyedUnarchiver* unarch = [[DKKeyedUnarchiver alloc] initForReadingWithData:archive];
+	DKUnarchivingHelper* helper = [[DKUnarchivingHelper alloc] init];
+
+	[unarch setDelegate:helper];
+	[unarch setImageManager:[self imageManager]];
+
+	NSArray* objects = [unarch decodeObjectForKey:@"root"];
+
+	[unarch finishDecoding];
+
+	if (objects != nil) {
+		// restored directly into the storage - rehydration is transparent, not an undoable edit
+
+		[[self storage] setObjects:objects];
+		[objects makeObjectsPerformSelector:@selector(setContainer:)
+								 withObject:self];
+		[objects makeObjectsPerformSelector:@selector(objectWasAddedToLayer:)
+								 withObject:self];
+
+		LogEvent_(kInfoEvent, @"layer '%@' rehydrated %lu objects", [self layerName], (unsigned long)[objects count]);
+	}
+}
+
+- (void)setVisible:(BOOL)visible
+{
+	[super setVisible:visible];
+
+	if (visible)
+		[self rehydrate];
+}
+
+- (void)setLocked:(BOOL)locked
+{
+	[super setLocked:locked];
+
+	if (!locked)
+		[self rehydrate];
+}
+
 #pragma mark - the list of objects
 
 - (void)setObjects:(NSArray*)objs
@@ -108,6 +286,11 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSArray*)objects
 {
+	// object access wakes a hibernated layer, so clients (including saving) never see the archive
+
+	if ([self isHibernated])
+		[self rehydrate];
+
 	return [[[self storage] objects] copy];
 }
 
@@ -179,9 +362,27 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	NSMutableArray* ao = [[NSMutableArray alloc] init];
 	NSString* key = [style uniqueKey];
 
-	for (DKDrawableObject* od in self.objects) {
-		if ([[[od style] uniqueKey] isEqualToString:key])
-			[ao addObject:od];
+	if ([[self storage] respondsToSelector:@selector(enumerateObjectSpansWithOptions:usingBlock:)]) {
+		// spans wrap each batch of 64 objects in its own pool, so the key strings created by the
+		// comparison drain as the traversal goes instead of piling up across a large document
+
+		[(id)[self storage] enumerateObjectSpansWithOptions:kDKIncludeInvisible
+												 usingBlock:^(DKObjectStorageSpan span, BOOL* stop) {
+#pragma unused(stop)
+													 NSUInteger i;
+
+													 for (i = 0; i < span.count; ++i) {
+														 DKDrawableObject* od = (DKDrawableObject*)span.objects[i];
+
+														 if ([[[od style] uniqueKey] isEqualToString:key])
+															 [ao addObject:od];
+													 }
+												 }];
+	} else {
+		for (DKDrawableObject* od in self.objects) {
+			if ([[[od style] uniqueKey] isEqualToString:key])
+				[ao addObject:od];
+		}
 	}
 
 	return ao;
@@ -216,6 +417,11 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSUInteger)countOfObjects
 {
+	// answered without waking a hibernated layer, so layer-list UIs stay cheap
+
+	if ([self isHibernated])
+		return mHibernatedObjectCount;
+
 	return [[self storage] countOfObjects];
 }
 
@@ -540,9 +746,14 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSArray<DKDrawableObject*>*)objectsForUpdateRect:(NSRect)rect inView:(NSView*)aView options:(DKObjectStorageOptions)options
 {
-	return [[self storage] objectsIntersectingRect:rect
-											inView:aView
-										   options:options];
+	NSArray<DKDrawableObject*>* objects = [[self storage] objectsIntersectingRect:rect
+																		   inView:aView
+																		  options:options];
+
+	DKPerfCounterAdd(&gDKPerfCounters.objectsDrawn, [objects count]);
+	DKPerfCounterAdd(&gDKPerfCounters.objectsCulled, [self countOfObjects] - [objects count]);
+
+	return objects;
 }
 
 #pragma mark -
@@ -556,7 +767,29 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	// for example an undo was performed on a contained object that changed its appearance
 
 	[self invalidateCache];
-	[self setNeedsDisplayInRect:rect];
+
+	// the tile cache only discards the tiles the change actually touches - everything else remains a blit
+
+	[mTileCache invalidateRect:rect];
+
+	if (mUpdateDeferCount > 0)
+		mDeferredUpdateRect = NSUnionRect(mDeferredUpdateRect, rect);
+	else
+		[self setNeedsDisplayInRect:rect];
+}
+
+- (void)beginDeferredUpdates
+{
+	if (mUpdateDeferCount++ == 0)
+		mDeferredUpdateRect = NSZeroRect;
+}
+
+- (void)endDeferredUpdates
+{
+	NSAssert(mUpdateDeferCount > 0, @"unbalanced call to -endDeferredUpdates");
+
+	if (--mUpdateDeferCount == 0 && !NSIsEmptyRect(mDeferredUpdateRect))
+		[self setNeedsDisplayInRect:mDeferredUpdateRect];
 }
 
 - (void)drawVisibleObjects
@@ -677,11 +910,26 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSRect)unionOfAllObjectBounds
 {
-	NSRect u = NSZeroRect;
+	// storages that keep packed bounds data can answer this directly with a parallel reduction
 
-	for (DKDrawableObject* obj in self.visibleObjects) {
-		u = UnionOfTwoRects(u, [obj bounds]);
-	}
+	if ([[self storage] respondsToSelector:@selector(unionOfObjectBounds)])
+		return [(id)[self storage] unionOfObjectBounds];
+
+	NSArray* visible = self.visibleObjects;
+	NSUInteger n = [visible count];
+
+	if (n == 0)
+		return NSZeroRect;
+
+	NSRect* bounds = (NSRect*)malloc(n * sizeof(NSRect));
+	NSUInteger i = 0;
+
+	for (DKDrawableObject* obj in visible)
+		bounds[i++] = [obj bounds];
+
+	NSRect u = UnionOfRects(bounds, i);
+
+	free(bounds);
 
 	return u;
 }
@@ -768,10 +1016,18 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 {
 	NSAssert(set != nil, @"cannot move objects as index set is nil");
 
-	if ([set count] > 0) {
-		NSArray* objs = [self objectsAtIndexes:set];
-		[self moveObjectsInArray:objs
-						 toIndex:indx];
+	if ([set count] > 0 && ![self lockedOrHidden]) {
+		// the storage moves the whole block in a single pass with one spatial-index repair; the
+		// undo restores the previous ordering wholesale rather than reversing each object's move
+
+		[[[self undoManager] prepareWithInvocationTarget:self] applyObjectOrdering:[[self storage] objects]];
+
+		[[self storage] moveObjectsAtIndexes:set
+									 toIndex:indx];
+
+		[self setNeedsDisplay:YES];
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidReorderObjects
+															object:self];
 	}
 }
 
@@ -780,14 +1036,23 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	NSAssert(objs != nil, @"can't move objects - array is nil");
 
 	if ([objs count] > 0) {
-		// iterate in reverse - insertion at index reverses the order
+		[self moveObjectsAtIndexes:[self indexesOfObjectsInArray:objs]
+						   toIndex:indx];
+	}
+}
 
-		NSEnumerator* iter = [objs reverseObjectEnumerator];
+- (void)applyObjectOrdering:(NSArray*)orderedObjects
+{
+	NSAssert(orderedObjects != nil, @"cannot apply a nil ordering");
 
-		for (DKDrawableObject* od in iter) {
-			[self moveObject:od
-					 toIndex:indx];
-		}
+	if (![self lockedOrHidden]) {
+		[[[self undoManager] prepareWithInvocationTarget:self] applyObjectOrdering:[[self storage] objects]];
+
+		[[self storage] applyObjectOrdering:orderedObjects];
+
+		[self setNeedsDisplay:YES];
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKLayerDidReorderObjects
+															object:self];
 	}
 }
 
@@ -987,13 +1252,21 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 - (NSPoint)snapPoint:(NSPoint)p toAnyObjectExcept:(DKDrawableObject*)except snapTolerance:(CGFloat)tol
 {
-#pragma unused(tol)
-
 	if ([self allowsSnapToObjects]) {
+		// only objects whose bounds fall close to the point can possibly provide a snap, so ask the storage for
+		// the objects intersecting a small rect around the point instead of scanning the entire layer. The
+		// storage answers this spatially when it is a BSP storage, so snapping cost is independent of how many
+		// objects the layer holds. The margin allows for the snap detection hit zone, which is based on the
+		// knob size rather than <tol>.
+
+		CGFloat margin = MAX(tol, [[self knobs] controlKnobSize].width * 2.0);
+		NSRect sr = NSMakeRect(p.x - margin, p.y - margin, margin * 2.0, margin * 2.0);
+
 		NSInteger pc;
 		NSEnumerator* iter;
 
-		iter = [[self objects] reverseObjectEnumerator];
+		iter = [[self objectsForUpdateRect:sr
+									inView:nil] reverseObjectEnumerator];
 
 		for (DKDrawableObject* ho in iter) {
 			if (ho != except) {
@@ -1072,6 +1345,32 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 @synthesize allowsEditing = m_allowEditing;
 @synthesize allowsSnapToObjects = m_allowSnapToObjects;
 @synthesize layerCacheOption = mLayerCachingOption;
+@synthesize renderTimeBudget = mRenderTimeBudget;
+
+- (void)setUsesRenderTimeBudget:(BOOL)budgeted
+{
+	if (budgeted != mUsesRenderTimeBudget) {
+		mUsesRenderTimeBudget = budgeted;
+
+		// discard any partial progress - the next update starts a fresh frame either way
+
+		mPendingRenderRect = NSZeroRect;
+		mRenderProgressCount = 0;
+		[self setNeedsDisplay:YES];
+	}
+}
+
+@synthesize usesRenderTimeBudget = mUsesRenderTimeBudget;
+
+- (void)setUsesConcurrentRendering:(BOOL)concurrent
+{
+	if (concurrent != mUsesConcurrentRendering) {
+		mUsesConcurrentRendering = concurrent;
+		[self setNeedsDisplay:YES];
+	}
+}
+
+@synthesize usesConcurrentRendering = mUsesConcurrentRendering;
 
 - (void)setHighlightedForDrag:(BOOL)highlight
 {
@@ -1129,6 +1428,206 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 	// not implemented
 }
 
+/** @brief Draws the layer's content by compositing retained tiles, rendering any stale ones on demand
+
+ Used when the kDKLayerCacheUsingTiles option is set. Static content costs a blit; only tiles dirtied by
+ object changes are re-rendered.
+ */
+- (void)drawUsingTileCacheInRect:(NSRect)rect
+{
+	if (mTileCache == nil)
+		mTileCache = [[DKLayerTileCache alloc] initWithCanvasSize:[[self drawing] drawingSize]
+														 tileSize:kDKLayerTileCacheDefaultTileSize];
+
+	[mTileCache drawRect:rect
+		   usingRenderer:^(NSRect tileRect) {
+			   NSArray* objects = [self objectsForUpdateRect:tileRect
+													  inView:nil
+													 options:0];
+
+			   for (DKDrawableObject* obj in objects)
+				   [obj drawContentWithSelectedState:NO];
+		   }];
+}
+
+/** @brief Draws objects in Z-order until the per-frame render budget expires
+
+ Objects that did not get drawn have the region they occupy painted with a neutral placeholder, and
+ that region is requeued once the current display pass has completed. Because each continuation
+ guarantees at least as many objects as the last pass completed before consulting the clock, every
+ frame makes strictly more progress than the one before, so fidelity converges even when many
+ objects overlap.
+ */
+- (void)drawObjectsWithTimeBudgetInRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+	NSArray* objects = [self objectsForUpdateRect:rect
+										   inView:aView];
+
+	// if this update continues an interrupted frame, the number of objects completed last time is the
+	// progress floor - those are drawn before the budget is consulted.
+
+	NSUInteger guaranteed = 0;
+
+	if (!NSIsEmptyRect(mPendingRenderRect) && NSContainsRect(rect, mPendingRenderRect))
+		guaranteed = mRenderProgressCount;
+
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+	NSUInteger drawn = 0, count = [objects count];
+
+	while (drawn < count) {
+		[(DKDrawableObject*)[objects objectAtIndex:drawn] drawContentWithSelectedState:NO];
+		++drawn;
+
+		if (drawn < count && drawn > guaranteed && (drawn % kDKRenderBudgetPollInterval) == 0
+			&& ([NSDate timeIntervalSinceReferenceDate] - start) >= mRenderTimeBudget)
+			break;
+	}
+
+	if (drawn < count) {
+		// out of time - placeholder the area the remaining objects occupy and continue next frame
+
+		NSRect remainder = NSZeroRect;
+		NSUInteger i;
+
+		for (i = drawn; i < count; ++i)
+			remainder = UnionOfTwoRects(remainder, [(DKDrawableObject*)[objects objectAtIndex:i] bounds]);
+
+		remainder = NSIntersectionRect(remainder, rect);
+
+		[[NSColor colorWithCalibratedWhite:0.9
+									 alpha:1.0] set];
+		NSRectFillUsingOperation(remainder, NSCompositeSourceOver);
+
+		mPendingRenderRect = remainder;
+		mRenderProgressCount = drawn;
+
+		// the invalidation must not occur while drawing is underway, so defer it to the next runloop cycle
+
+		[self performSelector:@selector(continueInterruptedRender)
+				   withObject:nil
+				   afterDelay:0.0];
+	} else {
+		mPendingRenderRect = NSZeroRect;
+		mRenderProgressCount = 0;
+	}
+}
+
+/** @brief Invalidates the placeholdered region so the next frame resumes the interrupted render */
+- (void)continueInterruptedRender
+{
+	if (!NSIsEmptyRect(mPendingRenderRect))
+		[self setNeedsDisplayInRect:mPendingRenderRect];
+}
+
+/** @brief Renders contiguous Z-spans of the update's objects into bitmaps on multiple cores
+
+ Because each span is a contiguous run of the Z-sorted object list, compositing the span bitmaps
+ in span order reproduces the sequential stacking exactly, however the spans overlap spatially.
+ Each bitmap covers only the area its span's objects touch, so spatially disjoint content pays
+ only for the pixels it uses. All bitmaps are created up front on the calling thread; the worker
+ threads touch nothing shared.
+ */
+- (void)drawObjectsConcurrentlyInRect:(NSRect)rect inView:(DKDrawingView*)aView
+{
+	NSArray* objects = [self objectsForUpdateRect:rect
+										   inView:aView];
+	NSUInteger count = [objects count];
+	NSUInteger spanCount = MIN((NSUInteger)[[NSProcessInfo processInfo] activeProcessorCount], count / kDKConcurrentRenderMinSpanLength);
+
+	if (spanCount < 2) {
+		// too few objects to repay the fork-join overhead - draw sequentially as usual
+
+		for (DKDrawableObject* obj in objects)
+			[obj drawContentWithSelectedState:NO];
+
+		return;
+	}
+
+	CGFloat scale = (aView != nil) ? [aView scale] : 1.0;
+	NSUInteger spanLength = (count + spanCount - 1) / spanCount;
+	NSMutableArray* spanReps = [NSMutableArray arrayWithCapacity:spanCount]; // NSNull where a span has nothing visible
+	NSMutableData* rectStore = [NSMutableData dataWithLength:spanCount * sizeof(NSRect)];
+	NSRect* spanRects = (NSRect*)[rectStore mutableBytes];
+	NSUInteger span;
+
+	for (span = 0; span < spanCount; ++span) {
+		NSRect spanRect = NSZeroRect;
+		NSUInteger i, last = MIN((span + 1) * spanLength, count);
+
+		for (i = span * spanLength; i < last; ++i)
+			spanRect = UnionOfTwoRects(spanRect, [(DKDrawableObject*)[objects objectAtIndex:i] bounds]);
+
+		spanRect = NSIntersectionRect(spanRect, rect);
+		spanRects[span] = spanRect;
+
+		NSBitmapImageRep* rep = nil;
+
+		if (!NSIsEmptyRect(spanRect))
+			rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+														  pixelsWide:MAX(1l, (NSInteger)ceil(spanRect.size.width * scale))
+														  pixelsHigh:MAX(1l, (NSInteger)ceil(spanRect.size.height * scale))
+													   bitsPerSample:8
+													 samplesPerPixel:4
+															hasAlpha:YES
+															isPlanar:NO
+													  colorSpaceName:NSCalibratedRGBColorSpace
+														 bytesPerRow:0
+														bitsPerPixel:0];
+
+		[spanReps addObject:rep ? (id)rep : (id)[NSNull null]];
+	}
+
+	dispatch_apply(spanCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t spanIndex) {
+		id rep = [spanReps objectAtIndex:spanIndex];
+
+		if (rep == [NSNull null])
+			return;
+
+		NSRect spanRect = spanRects[spanIndex];
+		NSGraphicsContext* bmc = [NSGraphicsContext graphicsContextWithBitmapImageRep:rep];
+		NSGraphicsContext* context = [NSGraphicsContext graphicsContextWithGraphicsPort:[bmc graphicsPort]
+																				flipped:YES];
+
+		// the current context is per-thread, so no save/restore gymnastics are needed here
+
+		[NSGraphicsContext setCurrentContext:context];
+
+		// map drawing space into the bitmap, flipping so content renders the right way up
+
+		NSAffineTransform* tfm = [NSAffineTransform transform];
+		NSAffineTransformStruct ts = { scale, 0, 0, -scale, -NSMinX(spanRect) * scale, NSMaxY(spanRect) * scale };
+		[tfm setTransformStruct:ts];
+		[tfm concat];
+
+		NSRectClip(spanRect);
+
+		NSUInteger i, last = MIN((spanIndex + 1) * spanLength, count);
+
+		for (i = spanIndex * spanLength; i < last; ++i)
+			[(DKDrawableObject*)[objects objectAtIndex:i] drawContentWithSelectedState:NO];
+
+		[context flushGraphics];
+	});
+
+	// composite the spans in Z-order
+
+	for (span = 0; span < spanCount; ++span) {
+		id rep = [spanReps objectAtIndex:span];
+
+		if (rep == [NSNull null])
+			continue;
+
+		NSImage* image = [[NSImage alloc] initWithSize:spanRects[span].size];
+		[image addRepresentation:rep];
+		[image drawInRect:spanRects[span]
+				 fromRect:NSZeroRect
+				operation:NSCompositeSourceOver
+				 fraction:1.0
+		   respectFlipped:YES
+					hints:nil];
+	}
+}
+
 #pragma mark -
 #pragma mark As a DKLayer
 
@@ -1153,6 +1652,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 - (void)drawingDidChangeToSize:(NSValue*)sizeVal
 {
 	[[self storage] setCanvasSize:[sizeVal sizeValue]];
+	[mTileCache setCanvasSize:[sizeVal sizeValue]];
 }
 
 /** @brief Called when the drawing's margins changed - this gives layers that need to know about this a
@@ -1186,13 +1686,23 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 #pragma unused(rect)
 
 	if ([self countOfObjects] > 0) {
-		NSEnumerator* iter = [self objectEnumeratorForUpdateRect:rect
-														  inView:aView];
-
-		// draw the objects - this enumerator has already excluded any not needing to be drawn
-
-		for (DKDrawableObject* obj in iter)
-			[obj drawContentWithSelectedState:NO];
+		if (([self layerCacheOption] & kDKLayerCacheUsingTiles) != 0)
+			[self drawUsingTileCacheInRect:rect];
+		else if (mUsesRenderTimeBudget && mRenderTimeBudget > 0 && [NSGraphicsContext currentContextDrawingToScreen])
+			[self drawObjectsWithTimeBudgetInRect:rect
+										   inView:aView];
+		else if (mUsesConcurrentRendering && [NSGraphicsContext currentContextDrawingToScreen])
+			[self drawObjectsConcurrentlyInRect:rect
+										 inView:aView];
+		else {
+			NSEnumerator* iter = [self objectEnumeratorForUpdateRect:rect
+															  inView:aView];
+
+			// draw the objects - this enumerator has already excluded any not needing to be drawn
+
+			for (DKDrawableObject* obj in iter)
+				[obj drawContentWithSelectedState:NO];
+		}
 	}
 
 	// draw any pending object on top of the others
@@ -1360,6 +1870,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[self setAllowsSnapToObjects:YES];
 		[self setAllowsEditing:YES];
 		[self setLayerCacheOption:[[self class] defaultLayerCacheOption]];
+		[self setRenderTimeBudget:kDKDefaultRenderTimeBudget];
 		[self setLayerName:NSLocalizedString(@"Drawing Layer", @"default name for new drawing layers")];
 	}
 	return self;
@@ -1405,6 +1916,20 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 
 	[coder encodeObject:[self objects]
 				 forKey:@"objects"];
+
+	// if the storage maintains a spatial index, a compact archive of it is saved alongside the
+	// objects so that spatial queries are warm immediately after opening, without re-inserting
+	// every object. The index validates itself against the objects on load, so storage using a
+	// different scheme (or none) simply ignores it.
+
+	if ([(id)[self storage] respondsToSelector:@selector(archivedSpatialIndexData)]) {
+		NSData* indexData = [(DKBSPObjectStorage*)[self storage] archivedSpatialIndexData];
+
+		if (indexData)
+			[coder encodeObject:indexData
+						 forKey:@"DKObjectOwnerLayer_spatialIndex"];
+	}
+
 	[coder encodeBool:[self allowsEditing]
 			   forKey:@"editable"];
 	[coder encodeBool:[self allowsSnapToObjects]
@@ -1442,6 +1967,16 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 			// common case: storage wasn't archived but objects were
 
 			[self setObjects:[coder decodeObjectForKey:@"objects"]];
+
+			// if a spatial index was saved with the file and the storage can use it, adopt it now
+			// that the objects are fully attached - this skips the per-object rebuild of the index.
+			// Adoption validates against the objects via a checksum, so a stale or foreign index is
+			// simply ignored and the tree is rebuilt by insertion as usual.
+
+			NSData* indexData = [coder decodeObjectForKey:@"DKObjectOwnerLayer_spatialIndex"];
+
+			if (indexData && [(id)mStorage respondsToSelector:@selector(adoptSpatialIndexData:)])
+				[(DKBSPObjectStorage*)mStorage adoptSpatialIndexData:indexData];
 		}
 
 		[self setPasteOffsetX:20
@@ -1449,6 +1984,7 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 		[self setAllowsEditing:[coder decodeBoolForKey:@"editable"]];
 		[self setAllowsSnapToObjects:[coder decodeBoolForKey:@"snappable"]];
 		[self setLayerCacheOption:[[self class] defaultLayerCacheOption]];
+		[self setRenderTimeBudget:kDKDefaultRenderTimeBudget];
 	}
 	return self;
 }
@@ -1504,18 +2040,36 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 			result = YES;
 		}
 	} else if ([NSImage canInitWithPasteboard:pb]) {
-		// so that image can be efficiently cached and subsequently archived, we make the image via the image manager and
-		// initialise the object that way.
+		// the drop is accepted straight away with a placeholder shape while the raw image bits are
+		// captured, which must happen now while the pasteboard is still valid. Checksumming,
+		// registration with the image manager and image creation all run on a background queue and
+		// the real image is swapped in when ready, so a large drop never stalls the drop gesture.
+
+		NSURL* fileURL = nil;
+		NSData* imageData = nil;
+		NSString* privateType = [pb availableTypeFromArray:@[kDKImageDataManagerPasteboardType]];
+
+		// image data dragged from the same document is already cached under its key
+
+		if (privateType)
+			imageData = [[[self drawing] imageManager] imageDataForKey:[pb stringForType:kDKImageDataManagerPasteboardType]];
 
-		NSString* newKey = nil;
-		NSImage* image = [[[self drawing] imageManager] makeImageWithPasteboard:pb
-																			key:&newKey];
+		if (imageData == nil) {
+			fileURL = [NSURL URLFromPasteboard:pb];
 
-		if (image) {
-			DKImageShape* imshape = [[DKImageShape alloc] initWithImage:image];
-			[imshape setImageKey:newKey];
+			if (fileURL == nil) {
+				NSString* imageType = [pb availableTypeFromArray:[NSImage imagePasteboardTypes]];
 
-			// centre the image on the drop location as the drag image is from Finder and is of little use to us here
+				if (imageType)
+					imageData = [pb dataForType:imageType];
+			}
+		}
+
+		if (imageData != nil || fileURL != nil) {
+			NSImage* placeholder = [[NSImage alloc] initWithSize:NSMakeSize(64, 64)];
+			DKImageShape* imshape = [[DKImageShape alloc] initWithImage:placeholder];
+
+			// centre the placeholder on the drop location as the drag image is from Finder and is of little use to us here
 
 			cp = [view convertPoint:[sender draggingLocation]
 						   fromView:nil];
@@ -1529,6 +2083,41 @@ static DKLayerCacheOption sDefaultCacheOption = kDKLayerCacheNone;
 				atDropLocation:cp];
 			[[self undoManager] setActionName:NSLocalizedString(@"Drag and Drop Image", @"undo string for drag/drop image")];
 
+			dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+				NSData* data = imageData;
+
+				if (data == nil)
+					data = [NSData dataWithContentsOfURL:fileURL];
+
+				NSString* newKey = nil;
+				NSImage* image = nil;
+
+				if (data != nil)
+					image = [[[self drawing] imageManager] makeImageWithData:data
+																		 key:&newKey];
+
+				NSSize imageSize = (image != nil) ? [image size] : NSZeroSize;
+
+				dispatch_async(dispatch_get_main_queue(), ^{
+					// swapping the real content in isn't a user action, so it bypasses undo; the
+					// original drop undoes as a whole either way
+
+					[[self undoManager] disableUndoRegistration];
+
+					if (image != nil) {
+						[imshape setImage:image];
+						[imshape setImageKey:newKey];
+						[imshape setSize:imageSize];
+					} else {
+						// the pasteboard data never yielded an image, so the placeholder goes too
+
+						[self removeObject:imshape];
+					}
+
+					[[self undoManager] enableUndoRegistration];
+				});
+			});
+
 			result = YES;
 		}
 	}
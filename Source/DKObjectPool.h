@@ -0,0 +1,88 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Implemented by objects that want to clear stale state when a pool recycles them.
+ */
+@protocol DKRecyclableObject <NSObject>
+@optional
+
+/** @brief Called by \c DKObjectPool just before a previously used object is handed out again. */
+- (void)prepareForReuse;
+
+@end
+
+/** @brief A recycling pool for small transient objects.
+
+ DKObjectPool hands out instances of a single class for repeated short-lived use, avoiding allocator
+ traffic on hot paths such as knob drawing and tool event handling. Objects are not returned to the
+ pool individually; instead the owner calls \c -beginNewGeneration at a natural boundary - the start
+ of a mouse event, a new drawing pass - which makes everything handed out since the previous reset
+ available for reuse in one step. Objects implementing \c -prepareForReuse from the
+ \c DKRecyclableObject protocol are given the chance to clear stale state as they are recycled.
+
+ For shared objects that are expensive to build but immutable once configured (handles, for example),
+ \c -objectPassingTest:create: performs a find-or-create over the whole pool without involving
+ generations at all; \c -drain empties the pool when such objects become wholesale stale. The two
+ styles should not be mixed within one pool.
+
+ Pools are not thread safe - each belongs to whichever single thread drives its owner.
+*/
+@interface DKObjectPool : NSObject {
+@private
+	Class mObjectClass; // the class of object this pool vends
+	NSMutableArray* mObjects; // every object the pool owns; indexes below the cursor are in use
+	NSUInteger mCursor; // number of objects handed out in the current generation
+	NSUInteger mGeneration; // incremented by each reset
+}
+
+/** @brief Designated initializer.
+ @param aClass the class of object the pool will vend
+ @return the pool
+ */
+- (instancetype)initWithObjectClass:(Class)aClass NS_DESIGNATED_INITIALIZER;
+- (instancetype)init UNAVAILABLE_ATTRIBUTE;
+
+/** @brief Returns a recycled instance, or a newly allocated one if none is free.
+
+ Recycled objects receive \c -prepareForReuse if they implement it. The object remains "in use"
+ until the next generation reset - the caller must not use it beyond that.
+ @return an instance of the pool's class
+ */
+- (id)acquire;
+
+/** @brief Returns a pooled object passing the test, creating and pooling one if none exists.
+
+ Searches the entire pool regardless of generation, so this suits shared immutable objects that are
+ matched by their configuration rather than owned for a single generation.
+ @param predicate the test a pooled object must pass to be returned
+ @param creationBlock called to build the object when nothing in the pool matches; its result is
+ added to the pool. May return nil, in which case nothing is added.
+ @return the matching or newly created object
+ */
+- (nullable id)objectPassingTest:(BOOL (^)(id object))predicate create:(nullable id (^)(void))creationBlock;
+
+/** @brief Makes everything handed out by \c -acquire since the previous reset available for reuse. */
+- (void)beginNewGeneration;
+
+/** @brief Empties the pool entirely, releasing every object it owns. */
+- (void)drain;
+
+/** @brief The class of object this pool vends. */
+@property (readonly) Class objectClass;
+
+/** @brief The current generation number; incremented by each reset. */
+@property (readonly) NSUInteger generation;
+
+/** @brief The total number of objects the pool owns, in use or free. */
+@property (readonly) NSUInteger count;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,84 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKObjectPool.h"
+
+@implementation DKObjectPool
+
+- (instancetype)initWithObjectClass:(Class)aClass
+{
+	NSAssert(aClass != Nil, @"pool requires a class");
+
+	self = [super init];
+	if (self) {
+		mObjectClass = aClass;
+		mObjects = [[NSMutableArray alloc] init];
+	}
+	return self;
+}
+
+- (id)acquire
+{
+	id obj;
+
+	if (mCursor < [mObjects count]) {
+		obj = [mObjects objectAtIndex:mCursor];
+
+		if ([obj respondsToSelector:@selector(prepareForReuse)])
+			[obj prepareForReuse];
+	} else {
+		obj = [[mObjectClass alloc] init];
+		[mObjects addObject:obj];
+	}
+
+	++mCursor;
+	return obj;
+}
+
+- (id)objectPassingTest:(BOOL (^)(id))predicate create:(id (^)(void))creationBlock
+{
+	NSAssert(predicate != nil, @"pool requires a predicate");
+
+	for (id obj in mObjects) {
+		if (predicate(obj))
+			return obj;
+	}
+
+	id obj = creationBlock ? creationBlock() : nil;
+
+	if (obj)
+		[mObjects addObject:obj];
+
+	return obj;
+}
+
+- (void)beginNewGeneration
+{
+	mCursor = 0;
+	++mGeneration;
+}
+
+- (void)drain
+{
+	[mObjects removeAllObjects];
+	mCursor = 0;
+	++mGeneration;
+}
+
+@synthesize objectClass = mObjectClass;
+@synthesize generation = mGeneration;
+
+- (NSUInteger)count
+{
+	return [mObjects count];
+}
+
+- (NSString*)description
+{
+	return [NSString stringWithFormat:@"%@, class = %@, %lu objects (%lu in use), generation %lu", [super description], NSStringFromClass(mObjectClass), (unsigned long)[mObjects count], (unsigned long)mCursor, (unsigned long)mGeneration];
+}
+
+@end
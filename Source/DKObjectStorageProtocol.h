@@ -9,6 +9,7 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @protocol DKObjectStorage;
+@protocol DKStorableObject;
 
 typedef NS_OPTIONS(NSUInteger, DKObjectStorageOptions) {
 	kDKReverseOrder = (1 << 0), //!< return objects in top to bottom order if set
@@ -17,6 +18,21 @@ typedef NS_OPTIONS(NSUInteger, DKObjectStorageOptions) {
 	kDKZOrderMayBeRelaxed = (1 << 3) //!< if set, the strict Z-ordering of objects may be relaxed if there is a performance benefit
 };
 
+/// number of objects delivered per span by <code>-enumerateObjectSpansWithOptions:usingBlock:</code>
+#define kDKObjectStorageSpanLength 64
+
+/** @brief A batch of stored objects handed to a span enumeration block.
+
+ Both arrays are backed by the enumerator's stack and are only valid for the duration of the block
+ call; the objects are not retained. The bounds are copied from the storage's packed mirror, so a
+ consumer that only needs geometry can scan them without messaging any object.
+ */
+typedef struct DKObjectStorageSpan {
+	const __unsafe_unretained id<DKStorableObject>* _Nonnull objects; //!< the objects, in enumeration order
+	const NSRect* _Nonnull bounds; //!< parallel bounds of each object
+	NSUInteger count; //!< number of valid entries, at most kDKObjectStorageSpanLength
+} DKObjectStorageSpan;
+
 /**
  
  This protocol is used by \c DKObjectStorage classes to implement a common object storage schema. The purpose is to allow object storage to swapped for more efficient
@@ -81,6 +97,24 @@ typedef NS_OPTIONS(NSUInteger, DKObjectStorageOptions) {
 - (NSUInteger)indexOfObject:(__kindof id<DKStorableObject>)object;
 - (void)moveObject:(__kindof id<DKStorableObject>)obj toIndex:(NSUInteger)indx;
 
+// batch Z-order changes. These must be equivalent to a series of -moveObject:toIndex: calls but are
+// performed in a single pass over the storage with at most one spatial-index repair, so reordering a
+// large selection is linear, not quadratic
+
+/** @brief Moves the objects at the given indexes to a new position as one block.
+
+ The moved objects keep their relative stacking order; \c indx is the position of the block among
+ the remaining objects, clamped to the valid range.
+ */
+- (void)moveObjectsAtIndexes:(NSIndexSet*)set toIndex:(NSUInteger)indx;
+
+/** @brief Reorders the storage to the given permutation of its objects.
+
+ \c orderedObjects must contain exactly the stored objects, in the desired bottom-to-top order.
+ No objects are added or removed.
+ */
+- (void)applyObjectOrdering:(NSArray<__kindof id<DKStorableObject>>*)orderedObjects;
+
 // methods that may be used by spatially sensitive storage algorithms
 
 - (void)object:(__kindof id<DKStorableObject>)obj didChangeBoundsFrom:(NSRect)oldBounds;
@@ -90,6 +124,27 @@ typedef NS_OPTIONS(NSUInteger, DKObjectStorageOptions) {
 @optional
 - (NSBezierPath*)debugStorageDivisions;
 
+/** @brief Returns the exact union of the bounds of all visible stored objects.
+
+ Storage classes that keep packed bounds data can compute this as a parallel min/max
+ reduction without messaging any object, making it usable every frame even for very
+ large documents. Returns \c NSZeroRect when there are no visible objects. Callers
+ should fall back to iterating the objects when the storage does not implement this.
+ */
+- (NSRect)unionOfObjectBounds;
+
+/** @brief Calls \c block with successive spans of the stored objects in Z-order.
+
+ Traverses the same objects as \c -objects but in batches of up to \c kDKObjectStorageSpanLength
+ at a time, each delivered with a parallel bounds slice and wrapped in its own autorelease pool
+ scope, so bulk consumers pay one pool drain and one dispatch per span instead of per object.
+ Invisible objects are skipped unless \c kDKIncludeInvisible is set, and \c kDKReverseOrder
+ enumerates top to bottom; other option flags are ignored. Set \c *stop to \c YES to end the
+ enumeration early. Callers should fall back to \c -objects when the storage does not implement
+ this.
+ */
+- (void)enumerateObjectSpansWithOptions:(DKObjectStorageOptions)options usingBlock:(void (NS_NOESCAPE ^)(DKObjectStorageSpan span, BOOL* stop))block;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,32 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <XCTest/XCTest.h>
+
+/** @brief Open-time budget tests for representative document corpora.
+
+Open-time budget tests for representative document corpora. Where DKPerformanceTests only reports timings, these tests additionally FAIL when
+opening a document blows a time or memory budget, so an open-time regression breaks the build instead of quietly shipping. Each test synthesizes
+a reproducible corpus document (the random generator is seeded with a fixed value), performs one untimed warm-up open so that one-off process
+costs are excluded, then times a few further opens and measures the growth in the process's physical footprint while the opened drawing is held
+alive. Timings are also emitted as \c DKBENCH lines in the same format as DKPerformanceTests so they can be tracked between releases.
+
+The corpora cover the open paths that have historically regressed: documents dense with per-object metadata, image-heavy documents read through
+the chunked container format, and legacy documents whose archives carry old class names and therefore exercise DKUnarchivingHelper's
+class-substitution machinery on every object.
+*/
+@interface DKOpenTimeTests : XCTestCase
+
+/** opens a document whose objects each carry a large user info dictionary, and fails if over budget. */
+- (void)testMetadataHeavyOpenPerformance;
+
+/** opens an image-heavy chunked document, and fails if over time or footprint budget. */
+- (void)testImageHeavyOpenPerformance;
+
+/** opens an archive rewritten to legacy 'GC' class names so every object passes through the class-substitution path. */
+- (void)testLegacyClassNameOpenPerformance;
+
+@end
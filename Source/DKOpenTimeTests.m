@@ -0,0 +1,325 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKOpenTimeTests.h"
+
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKImageShape.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+
+#import <mach/mach.h>
+
+// the corpus documents are synthesized deterministically (fixed random seed) rather than stored as
+// committed binary fixtures, so the workload always tracks the current archive format without opaque
+// blobs in the repository. The budgets are deliberately loose - they are tripwires for
+// order-of-magnitude regressions, not instruments for measuring noise-level drift (the DKBENCH lines
+// serve that purpose).
+
+#define OPENTIME_RANDOM_SEED 176543
+#define OPENTIME_CANVAS_SIZE 4000.0
+#define OPENTIME_METADATA_OBJECT_COUNT 1000
+#define OPENTIME_METADATA_KEYS_PER_OBJECT 24
+#define OPENTIME_IMAGE_COUNT 12
+#define OPENTIME_IMAGE_PIXELS 512
+#define OPENTIME_LEGACY_OBJECT_COUNT 400
+#define OPENTIME_OPEN_ITERATIONS 3
+
+#define OPENTIME_BUDGET_SECONDS 5.0
+#define OPENTIME_FOOTPRINT_BUDGET_BYTES (512ULL * 1024ULL * 1024ULL)
+
+static CGFloat openRandomFloat(CGFloat minVal, CGFloat maxVal)
+{
+	CGFloat rf = fmod((CGFloat)random(), maxVal - minVal);
+
+	return minVal + rf;
+}
+
+/** returns the process's current physical footprint in bytes, or 0 if it cannot be read. */
+static uint64_t physicalFootprint(void)
+{
+	task_vm_info_data_t info;
+	mach_msg_type_number_t count = TASK_VM_INFO_COUNT;
+
+	if (task_info(mach_task_self(), TASK_VM_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+		return 0;
+
+	return info.phys_footprint;
+}
+
+/** rewrites every occurrence of a class name within a keyed archive to a same-length replacement.
+
+ binary keyed archives store class names as plain strings, so an equal-length byte substitution yields a
+ well-formed archive whose classes cannot be resolved - exactly what a document written by an old DrawKit
+ looks like to the unarchiver, which then consults DKUnarchivingHelper for a substitute.
+ */
+static NSData* dataByRenamingClass(NSData* archive, NSString* currentName, NSString* legacyName)
+{
+	NSCAssert([currentName length] == [legacyName length], @"class rename must preserve length to keep the archive well-formed");
+
+	NSData* from = [currentName dataUsingEncoding:NSASCIIStringEncoding];
+	NSData* to = [legacyName dataUsingEncoding:NSASCIIStringEncoding];
+	NSMutableData* result = [[archive mutableCopy] autorelease];
+	NSRange search = NSMakeRange(0, [result length]);
+	NSRange found;
+
+	while ((found = [result rangeOfData:from
+								options:0
+								  range:search])
+			   .location
+		!= NSNotFound) {
+		[result replaceBytesInRange:found
+						  withBytes:[to bytes]
+							 length:[to length]];
+		search.location = NSMaxRange(found);
+		search.length = [result length] - search.location;
+	}
+
+	return result;
+}
+
+@implementation DKOpenTimeTests
+
+#pragma mark - budget harness
+
+/** opens <data> with <opener> once untimed (warm-up), then <OPENTIME_OPEN_ITERATIONS> more times,
+ emitting a DKBENCH line and failing the test if the best open time or the footprint growth while the
+ opened drawing is held alive exceeds the budgets. */
+- (void)runOpenBenchmark:(NSString*)name data:(NSData*)data opener:(DKDrawing* (^)(NSData*))opener
+{
+	XCTAssertNotNil(data, @"corpus document '%@' could not be built", name);
+
+	// warm-start: the first open pays one-off costs (class resolution, colour and font machinery)
+	// that belong to the process, not the document - it is verified but not timed.
+
+	@autoreleasepool {
+		XCTAssertNotNil(opener(data), @"warm-up open of '%@' failed", name);
+	}
+
+	uint64_t footprintBefore = physicalFootprint();
+	DKDrawing* heldOpen = nil;
+	NSTimeInterval best = -1.0;
+	NSTimeInterval total = 0.0;
+	NSUInteger i;
+
+	for (i = 0; i < OPENTIME_OPEN_ITERATIONS; ++i) {
+		@autoreleasepool {
+			NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+			DKDrawing* dwg = opener(data);
+			NSTimeInterval elapsed = [NSDate timeIntervalSinceReferenceDate] - start;
+
+			XCTAssertNotNil(dwg, @"open of '%@' failed", name);
+
+			total += elapsed;
+
+			if (best < 0.0 || elapsed < best)
+				best = elapsed;
+
+			[heldOpen release];
+			heldOpen = [dwg retain];
+		}
+	}
+
+	uint64_t footprintAfter = physicalFootprint();
+	uint64_t growth = (footprintAfter > footprintBefore) ? footprintAfter - footprintBefore : 0;
+
+	NSDictionary* result = @{ @"benchmark": name,
+		@"iterations": @(OPENTIME_OPEN_ITERATIONS),
+		@"total_seconds": @(total),
+		@"seconds_per_iteration": @(total / (NSTimeInterval)OPENTIME_OPEN_ITERATIONS),
+		@"best_seconds": @(best),
+		@"footprint_growth_bytes": @(growth) };
+
+	NSData* json = [NSJSONSerialization dataWithJSONObject:result
+												   options:0
+													 error:NULL];
+	NSString* line = [[[NSString alloc] initWithData:json
+											encoding:NSUTF8StringEncoding] autorelease];
+
+	fprintf(stdout, "DKBENCH %s\n", [line UTF8String]);
+	fflush(stdout);
+
+	XCTAssertLessThan(best, OPENTIME_BUDGET_SECONDS, @"opening '%@' exceeded the open-time budget", name);
+
+	if (footprintBefore != 0 && footprintAfter != 0)
+		XCTAssertLessThan(growth, OPENTIME_FOOTPRINT_BUDGET_BYTES, @"holding '%@' open exceeded the footprint budget", name);
+
+	[heldOpen release];
+}
+
+#pragma mark - corpus builders
+
+/** builds a drawing whose objects each carry a sizeable user info dictionary, archived as a keyed archive. */
+- (NSData*)metadataHeavyDocumentData
+{
+	srandom(OPENTIME_RANDOM_SEED);
+
+	DKDrawing* drawing = [DKDrawing defaultDrawingWithSize:NSMakeSize(OPENTIME_CANVAS_SIZE, OPENTIME_CANVAS_SIZE)];
+	DKObjectDrawingLayer* layer = (DKObjectDrawingLayer*)[drawing activeLayerOfClass:[DKObjectDrawingLayer class]];
+
+	XCTAssertNotNil(layer, @"default drawing has no object layer to populate");
+
+	NSUInteger i, k;
+
+	for (i = 0; i < OPENTIME_METADATA_OBJECT_COUNT; ++i) {
+		NSRect r;
+		r.origin.x = openRandomFloat(0.0, OPENTIME_CANVAS_SIZE - 100.0);
+		r.origin.y = openRandomFloat(0.0, OPENTIME_CANVAS_SIZE - 100.0);
+		r.size.width = openRandomFloat(5.0, 100.0);
+		r.size.height = openRandomFloat(5.0, 100.0);
+
+		DKDrawableShape* shape = [DKDrawableShape drawableShapeWithRect:r];
+		NSMutableDictionary* info = [NSMutableDictionary dictionaryWithCapacity:OPENTIME_METADATA_KEYS_PER_OBJECT];
+
+		for (k = 0; k < OPENTIME_METADATA_KEYS_PER_OBJECT; ++k) {
+			NSString* key = [NSString stringWithFormat:@"meta_key_%lu", (unsigned long)k];
+
+			if ((k % 2) == 0)
+				[info setObject:[NSString stringWithFormat:@"metadata value %lu for object %lu", (unsigned long)k, (unsigned long)i]
+						 forKey:key];
+			else
+				[info setObject:@(random())
+						 forKey:key];
+		}
+
+		[shape setUserInfo:info];
+		[layer addObject:shape];
+	}
+
+	return [drawing drawingData];
+}
+
+/** returns uncompressed TIFF data of a deterministic noise bitmap - incompressible, like a photo. */
+- (NSData*)generatedImageData
+{
+	NSBitmapImageRep* rep = [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+																	pixelsWide:OPENTIME_IMAGE_PIXELS
+																	pixelsHigh:OPENTIME_IMAGE_PIXELS
+																 bitsPerSample:8
+															   samplesPerPixel:4
+																	  hasAlpha:YES
+																	  isPlanar:NO
+																colorSpaceName:NSCalibratedRGBColorSpace
+																   bytesPerRow:OPENTIME_IMAGE_PIXELS * 4
+																  bitsPerPixel:32];
+
+	unsigned char* pixels = [rep bitmapData];
+	NSUInteger byteCount = OPENTIME_IMAGE_PIXELS * OPENTIME_IMAGE_PIXELS * 4;
+	NSUInteger b;
+
+	for (b = 0; b < byteCount; ++b)
+		pixels[b] = (unsigned char)(random() & 0xFF);
+
+	NSData* tiff = [rep TIFFRepresentation];
+	[rep release];
+
+	return tiff;
+}
+
+/** builds a drawing holding several large bitmap images, archived through the chunked container format. */
+- (NSData*)imageHeavyDocumentData
+{
+	srandom(OPENTIME_RANDOM_SEED);
+
+	DKDrawing* drawing = [DKDrawing defaultDrawingWithSize:NSMakeSize(OPENTIME_CANVAS_SIZE, OPENTIME_CANVAS_SIZE)];
+	DKObjectDrawingLayer* layer = (DKObjectDrawingLayer*)[drawing activeLayerOfClass:[DKObjectDrawingLayer class]];
+
+	XCTAssertNotNil(layer, @"default drawing has no object layer to populate");
+
+	NSUInteger i;
+
+	for (i = 0; i < OPENTIME_IMAGE_COUNT; ++i) {
+		DKImageShape* shape = [[DKImageShape alloc] initWithImageData:[self generatedImageData]];
+
+		XCTAssertNotNil(shape, @"image shape could not be built from generated image data");
+
+		[shape setLocation:NSMakePoint(openRandomFloat(300.0, OPENTIME_CANVAS_SIZE - 300.0),
+								openRandomFloat(300.0, OPENTIME_CANVAS_SIZE - 300.0))];
+		[layer addObject:shape];
+		[shape release];
+	}
+
+	return [drawing chunkedDrawingData];
+}
+
+/** builds a plain drawing archive, then rewrites its class names to the legacy 'GC' spellings. */
+- (NSData*)legacyClassNameDocumentData
+{
+	srandom(OPENTIME_RANDOM_SEED);
+
+	DKDrawing* drawing = [DKDrawing defaultDrawingWithSize:NSMakeSize(OPENTIME_CANVAS_SIZE, OPENTIME_CANVAS_SIZE)];
+	DKObjectDrawingLayer* layer = (DKObjectDrawingLayer*)[drawing activeLayerOfClass:[DKObjectDrawingLayer class]];
+
+	XCTAssertNotNil(layer, @"default drawing has no object layer to populate");
+
+	NSUInteger i;
+
+	for (i = 0; i < OPENTIME_LEGACY_OBJECT_COUNT; ++i) {
+		NSRect r;
+		r.origin.x = openRandomFloat(0.0, OPENTIME_CANVAS_SIZE - 100.0);
+		r.origin.y = openRandomFloat(0.0, OPENTIME_CANVAS_SIZE - 100.0);
+		r.size.width = openRandomFloat(5.0, 100.0);
+		r.size.height = openRandomFloat(5.0, 100.0);
+
+		[layer addObject:[DKDrawableShape drawableShapeWithRect:r]];
+	}
+
+	NSData* archive = [drawing drawingData];
+
+	archive = dataByRenamingClass(archive, @"DKDrawableShape", @"GCDrawableShape");
+	archive = dataByRenamingClass(archive, @"DKObjectDrawingLayer", @"GCObjectDrawingLayer");
+
+	return archive;
+}
+
+#pragma mark - tests
+
+- (void)testMetadataHeavyOpenPerformance
+{
+	NSData* data = [self metadataHeavyDocumentData];
+
+	[self runOpenBenchmark:@"open_metadata_heavy"
+					  data:data
+					opener:^DKDrawing*(NSData* d) {
+						return [DKDrawing drawingWithData:d];
+					}];
+}
+
+- (void)testImageHeavyOpenPerformance
+{
+	NSData* data = [self imageHeavyDocumentData];
+
+	[self runOpenBenchmark:@"open_image_heavy"
+					  data:data
+					opener:^DKDrawing*(NSData* d) {
+						return [DKDrawing drawingWithChunkedData:d];
+					}];
+}
+
+- (void)testLegacyClassNameOpenPerformance
+{
+	NSData* data = [self legacyClassNameDocumentData];
+
+	// verify the rewrite really routes through the class-substitution path and that the objects
+	// come back as their modern classes before treating the timings as meaningful
+
+	DKDrawing* probe = [DKDrawing drawingWithData:data];
+
+	XCTAssertNotNil(probe, @"legacy-classname archive failed to open at all");
+
+	DKObjectDrawingLayer* probeLayer = (DKObjectDrawingLayer*)[probe firstLayerOfClass:[DKObjectDrawingLayer class]];
+
+	XCTAssertNotNil(probeLayer, @"legacy GCObjectDrawingLayer was not substituted back to DKObjectDrawingLayer");
+	XCTAssertEqual([probeLayer countOfObjects], (NSUInteger)OPENTIME_LEGACY_OBJECT_COUNT, @"legacy archive lost objects during substitution");
+
+	[self runOpenBenchmark:@"open_legacy_classnames"
+					  data:data
+					opener:^DKDrawing*(NSData* d) {
+						return [DKDrawing drawingWithData:d];
+					}];
+}
+
+@end
@@ -20,6 +20,7 @@ NS_ASSUME_NONNULL_BEGIN
 	NSDictionary<NSString*, NSNumber*>* mClassInfo;
 	NSRect mBoundingRect;
 	NSString* mOriginatingLayerKey;
+	NSString* mSessionKey;
 }
 
 + (instancetype)pasteboardInfoForObjects:(NSArray*)objects NS_SWIFT_UNAVAILABLE("");
@@ -38,6 +39,31 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (readonly, copy) NSString* keyOfOriginatingLayer;
 
+/** @brief A key identifying the in-process snapshot that backs this info, if any.
+
+ The key is generated when the info is created and travels with it in the archive, so a receiver can
+ tell whether the objects the info describes are still available in memory in this process.
+*/
+@property (readonly, copy, nullable) NSString* sessionKey;
+
+/** @brief Registers \c objects in a process-wide table under the receiver's session key.
+
+ The originating layer calls this with a snapshot of the copied objects, so that an intra-application
+ paste or drop can duplicate them directly without the objects ever being archived.
+*/
+- (void)registerLocalObjects:(NSArray*)objects;
+
+/** @brief Returns the in-process objects registered under the receiver's session key, or \c nil.
+
+ Returns \c nil when the info was written by another process, or when the originating layer has since
+ relinquished the pasteboard (registrations are removed when pasteboard ownership changes). In that
+ case the caller must fall back on the archived data, which is generated on demand.
+*/
+- (nullable NSArray*)localObjects;
+
+/** @brief Removes a registration made by <code>-registerLocalObjects:</code>. */
++ (void)unregisterLocalObjectsForKey:(NSString*)key;
+
 - (NSData*)data;
 - (BOOL)writeToPasteboard:(NSPasteboard*)pb;
 
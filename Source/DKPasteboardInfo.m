@@ -10,6 +10,12 @@
 #import "DKObjectOwnerLayer.h"
 #import "LogEvent.h"
 
+// process-wide table of object snapshots keyed by session key. Entries are added by the layer that
+// writes the pasteboard and removed when it loses ownership, so the table only ever holds the
+// snapshots behind currently live pasteboard contents.
+
+static NSMutableDictionary<NSString*, NSArray*>* sLocalObjects = nil;
+
 @implementation DKPasteboardInfo
 
 + (DKPasteboardInfo*)pasteboardInfoForObjects:(NSArray*)objects
@@ -75,6 +81,7 @@
 
 		mClassInfo = [clDict copy];
 		mBoundingRect = br;
+		mSessionKey = [[NSUUID UUID] UUIDString];
 
 		LogEvent_(kInfoEvent, @"pasteboard class info = %@", mClassInfo);
 	}
@@ -92,6 +99,34 @@
 }
 
 @synthesize keyOfOriginatingLayer = mOriginatingLayerKey;
+@synthesize sessionKey = mSessionKey;
+
+- (void)registerLocalObjects:(NSArray*)objects
+{
+	NSAssert(objects != nil, @"cannot register a nil snapshot");
+
+	if (mSessionKey != nil) {
+		if (sLocalObjects == nil)
+			sLocalObjects = [[NSMutableDictionary alloc] init];
+
+		[sLocalObjects setObject:objects
+						  forKey:mSessionKey];
+	}
+}
+
+- (NSArray*)localObjects
+{
+	if (mSessionKey == nil)
+		return nil;
+
+	return [sLocalObjects objectForKey:mSessionKey];
+}
+
++ (void)unregisterLocalObjectsForKey:(NSString*)key
+{
+	if (key != nil)
+		[sLocalObjects removeObjectForKey:key];
+}
 
 - (NSData*)data
 {
@@ -116,6 +151,7 @@
 		mClassInfo = [coder decodeObjectForKey:@"DKPasteboardInfo_classInfo"];
 		mBoundingRect = [coder decodeRectForKey:@"DKPasteboardInfo_boundsRect"];
 		mOriginatingLayerKey = [coder decodeObjectForKey:@"DKPasteboardInfo_originatingLayerKey"];
+		mSessionKey = [coder decodeObjectForKey:@"DKPasteboardInfo_sessionKey"];
 	}
 	return self;
 }
@@ -130,6 +166,8 @@
 			   forKey:@"DKPasteboardInfo_boundsRect"];
 	[coder encodeObject:[self keyOfOriginatingLayer]
 				 forKey:@"DKPasteboardInfo_originatingLayerKey"];
+	[coder encodeObject:[self sessionKey]
+				 forKey:@"DKPasteboardInfo_sessionKey"];
 }
 
 @end
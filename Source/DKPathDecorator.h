@@ -36,7 +36,13 @@ NS_ASSUME_NONNULL_BEGIN
 	BOOL m_normalToPath;
 	BOOL m_useChainMethod;
 	DKQuartzCache* mDKCache;
+	NSMutableArray<NSAffineTransform*>* mPendingStamps; // motif transforms collected for batched stamping
 	BOOL m_lowQuality;
+	NSData* mPlacementBuffer; // front buffer of precomputed motif placements, consumed while the path is unchanged
+	NSUInteger mPlacementBufferElements; // path state the buffer was built for
+	NSRect mPlacementBufferBounds;
+	CGFloat mPlacementBufferInterval;
+	BOOL mPlacementBuildInFlight; // YES while a worker is rebuilding the buffer in the background
 @protected
 	NSUInteger mPlacementCount;
 	NSMutableArray* mWobbleCache;
@@ -52,6 +58,29 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)setUpCache;
 - (void)setPDFImageRep:(NSPDFImageRep*)rep;
 
+/** @brief Whether motif placement currently collects transforms for batched stamping.
+
+ \c YES when a layer cache exists and stamping it loses nothing - i.e. in low quality mode, or when the
+ image has no PDF representation whose resolution independence per-copy drawing would preserve. Placement
+ then just records each motif's transform and \c -flushPendingStamps draws the lot in one tight loop,
+ avoiding a full graphics context save/restore and image draw per copy.
+ */
+- (BOOL)batchesMotifPlacement;
+
+/** @brief Stamps the layer cache once for each collected motif transform, then empties the list. */
+- (void)flushPendingStamps;
+
+/** @brief Returns the precomputed motif placements for the given path, or \c nil if none are usable.
+
+ Walking the path with \c -pointOnPathAtLength:slope: for every motif is by far the most expensive part
+ of rendering a decorator, so the positions and tangents are computed once into a buffer and consumed
+ directly on subsequent renders while the path is unchanged. In low quality (gesture) rendering a stale
+ buffer triggers a rebuild on a background worker and the previous front buffer is consumed meanwhile,
+ so dragging never pays for placement on the main thread; high quality renders rebuild synchronously so
+ the final result is always exact.
+ */
+- (nullable NSData*)placementsForPath:(NSBezierPath*)path;
+
 @property (nonatomic) CGFloat scale;
 
 @property (nonatomic) CGFloat scaleRandomness;
@@ -18,6 +18,18 @@
 #import "NSBezierPath+Text.h"
 #include <tgmath.h>
 
+// a precomputed motif placement - the output of pointOnPathAtLength:slope: for one copy
+
+typedef struct {
+	NSPoint point;
+	CGFloat position;
+	CGFloat slope;
+} DKMotifPlacement;
+
+// placement rebuilds from all decorators share one concurrent worker queue
+
+static dispatch_queue_t sPlacementQueue = NULL;
+
 @implementation DKPathDecorator
 #pragma mark As a DKPathDecorator
 
@@ -79,12 +91,22 @@
 
 #define USE_DK_CACHE 1
 
+- (DKRenderCacheKey)motifCacheKey
+{
+	// the motif cache depends only on the image the stamps are made from. NSImage carries no change
+	// generation, so the image's identity stands in for one here - replacing the image (however the
+	// replacement reaches us) makes the recorded key stale and the cache rebuilds itself.
+
+	return DKRenderCacheKeyMake((NSUInteger)(__bridge void*)m_image, 0, 0, 0.0);
+}
+
 - (void)setUpCache
 {
 	NSAssert(m_image != nil, @"no image to create cache with");
 
 #if USE_DK_CACHE
 	mDKCache = [DKQuartzCache cacheForImage:[self image]];
+	[mDKCache recordDependencyKey:[self motifCacheKey]];
 #else
 	NSAssert(m_cache == nil, @"expected cache to be NULL");
 
@@ -371,20 +393,30 @@
 		//NSFrameRectWithWidth( drawnRect, 1.0 );
 
 		if (cv == nil || [cv needsToDrawRect:drawnRect]) {
-			SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
-				[tfm concat];
-
-			if (mDKCache && m_lowQuality) {
-				[mDKCache drawAtPoint:NSZeroPoint];
-			} else if (m_pdf != nil)
-				[m_pdf draw];
-			else
-				[img drawAtPoint:NSZeroPoint
-						fromRect:NSZeroRect
-					   operation:NSCompositeSourceAtop
-						fraction:1.0];
-
-			RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+			if ([self batchesMotifPlacement]) {
+				// just collect the transform - the stamps are drawn in a single tight loop by
+				// -flushPendingStamps once placement has visited the whole path or pattern
+
+				if (mPendingStamps == nil)
+					mPendingStamps = [[NSMutableArray alloc] init];
+
+				[mPendingStamps addObject:tfm];
+			} else {
+				SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
+					[tfm concat];
+
+				if (mDKCache && m_lowQuality) {
+					[mDKCache drawAtPoint:NSZeroPoint];
+				} else if (m_pdf != nil)
+					[m_pdf draw];
+				else
+					[img drawAtPoint:NSZeroPoint
+							fromRect:NSZeroRect
+						   operation:NSCompositeSourceAtop
+							fraction:1.0];
+
+				RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
+			}
 		}
 	}
 
@@ -395,6 +427,36 @@
 	return nil;
 }
 
+- (BOOL)batchesMotifPlacement
+{
+	// stamping the cached layer is only a faithful substitute for per-copy drawing when there is no PDF
+	// representation in play, or when low quality drawing has opted out of vector fidelity anyway
+
+	return mDKCache != nil && (m_lowQuality || m_pdf == nil);
+}
+
+- (void)flushPendingStamps
+{
+	if ([mPendingStamps count] == 0)
+		return;
+
+	// a plain gstate push around each stamp is far cheaper than the full NSGraphicsContext save/restore
+	// that per-copy drawing performs, and the layer blit itself is cheaper than an NSImage draw
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	for (NSAffineTransform* tfm in mPendingStamps) {
+		NSAffineTransformStruct ts = [tfm transformStruct];
+
+		CGContextSaveGState(context);
+		CGContextConcatCTM(context, CGAffineTransformMake(ts.m11, ts.m12, ts.m21, ts.m22, ts.tX, ts.tY));
+		[mDKCache drawAtPoint:NSZeroPoint];
+		CGContextRestoreGState(context);
+	}
+
+	[mPendingStamps removeAllObjects];
+}
+
 - (id)placeLinkFromPoint:(NSPoint)pa toPoint:(NSPoint)pb onPath:(NSBezierPath*)path linkNumber:(NSInteger)lkn userInfo:(void*)userInfo
 {
 #pragma unused(path)
@@ -442,6 +504,9 @@
 		return;
 
 	if ([self enabled] && ([self image] != nil || [self usesChainMethod])) {
+		if (mDKCache != nil && ![mDKCache isValidForKey:[self motifCacheKey]])
+			mDKCache = nil;
+
 		if (mDKCache == nil && [self image] != nil)
 			[self setUpCache];
 
@@ -496,10 +561,106 @@
 		[path placeLinksOnPathWithLinkLength:[self interval]
 							   factoryObject:self
 									userInfo:&pass];
-	} else
-		[path placeObjectsOnPathAtInterval:[self interval]
-							 factoryObject:self
-								  userInfo:NULL];
+	} else {
+		NSData* placements = [self placementsForPath:path];
+
+		if (placements != nil) {
+			// placement geometry is already known - drive the factory callback straight from the buffer
+			// without walking the path again
+
+			const DKMotifPlacement* pl = (const DKMotifPlacement*)[placements bytes];
+			NSUInteger i, count = [placements length] / sizeof(DKMotifPlacement);
+
+			for (i = 0; i < count; ++i)
+				[self placeObjectAtPoint:pl[i].point
+								  onPath:path
+								position:pl[i].position
+								   slope:pl[i].slope
+								userInfo:NULL];
+		} else
+			[path placeObjectsOnPathAtInterval:[self interval]
+								 factoryObject:self
+									  userInfo:NULL];
+	}
+
+	[self flushPendingStamps];
+}
+
++ (NSData*)buildPlacementsForPath:(NSBezierPath*)path atInterval:(CGFloat)interval
+{
+	// walks the path computing each motif's position and tangent. Touches nothing but the path passed in,
+	// so it can run on a worker against a private copy.
+
+	if ([path elementCount] < 2 || interval <= 0.0)
+		return nil;
+
+	NSMutableData* data = [[NSMutableData alloc] init];
+	CGFloat length = [path length];
+	DKMotifPlacement pl;
+
+	for (pl.position = 0; pl.position <= length; pl.position += interval) {
+		pl.point = [path pointOnPathAtLength:pl.position
+									   slope:&pl.slope];
+		[data appendBytes:&pl
+				   length:sizeof(pl)];
+	}
+
+	return data;
+}
+
+- (NSData*)placementsForPath:(NSBezierPath*)path
+{
+	NSUInteger ec = [path elementCount];
+	NSRect pb = [path bounds];
+	CGFloat interval = [self interval];
+
+	BOOL fresh = (mPlacementBuffer != nil && mPlacementBufferElements == ec
+		&& NSEqualRects(mPlacementBufferBounds, pb) && mPlacementBufferInterval == interval);
+
+	if (fresh)
+		return mPlacementBuffer;
+
+	if (m_lowQuality) {
+		// mid-gesture: rebuild on a worker against a private copy of the path and swap the result in on
+		// the main queue. This frame consumes the previous front buffer - possibly a copy or two stale,
+		// which low quality drawing tolerates - or falls back to walking the path if there is none yet.
+
+		if (!mPlacementBuildInFlight) {
+			mPlacementBuildInFlight = YES;
+
+			if (sPlacementQueue == NULL)
+				sPlacementQueue = dispatch_queue_create("net.apptree.drawkit.motifplacement", DISPATCH_QUEUE_CONCURRENT);
+
+			NSBezierPath* pathCopy = [path copy];
+
+			dispatch_async(sPlacementQueue, ^{
+				NSData* built = [[self class] buildPlacementsForPath:pathCopy
+														  atInterval:interval];
+
+				dispatch_async(dispatch_get_main_queue(), ^{
+					mPlacementBuffer = built;
+					mPlacementBufferElements = [pathCopy elementCount];
+					mPlacementBufferBounds = [pathCopy bounds];
+					mPlacementBufferInterval = interval;
+					mPlacementBuildInFlight = NO;
+				});
+			});
+		}
+
+		return mPlacementBuffer;
+	}
+
+	// high quality: build synchronously so this render is exact, and keep the result for reuse
+
+	NSData* built = [[self class] buildPlacementsForPath:path
+											  atInterval:interval];
+
+	mPlacementBuffer = built;
+	mPlacementBufferElements = ec;
+	mPlacementBufferBounds = pb;
+	mPlacementBufferInterval = interval;
+
+	return built;
 }
 
 #pragma mark -
@@ -72,28 +72,45 @@ NSString* const kDKDeletePathElementCursorImageName = @"Delete Path Element";
 
 - (NSCursor*)cursor
 {
-	NSImage* img;
+	// the cursor for each mode is built once and cached - this is requested on every tool switch and cursor update
+
+	static NSMutableDictionary<NSString*, NSCursor*>* sCursors = nil;
+
+	NSString* imageName;
 
 	switch ([self mode]) {
 	case kDKPathDeletePointMode:
-		img = [NSImage imageNamed:kDKDeletePathPointCursorImageName];
+		imageName = kDKDeletePathPointCursorImageName;
 		break;
 
 	case kDKPathInsertPointMode:
-		img = [NSImage imageNamed:kDKInsertPathPointCursorImageName];
+		imageName = kDKInsertPathPointCursorImageName;
 		break;
 
 	case kDKPathDeleteElementMode:
-		img = [NSImage imageNamed:kDKDeletePathElementCursorImageName];
+		imageName = kDKDeletePathElementCursorImageName;
 		break;
 
 	default:
-		img = nil;
+		imageName = nil;
 		break;
 	}
 
-	NSCursor* curs = [[NSCursor alloc] initWithImage:img
-											 hotSpot:NSMakePoint(1, 1)];
+	if (sCursors == nil)
+		sCursors = [[NSMutableDictionary alloc] init];
+
+	NSCursor* curs = imageName ? [sCursors objectForKey:imageName] : nil;
+
+	if (curs == nil) {
+		NSImage* img = imageName ? [NSImage imageNamed:imageName] : nil;
+		curs = [[NSCursor alloc] initWithImage:img
+									   hotSpot:NSMakePoint(1, 1)];
+
+		if (imageName)
+			[sCursors setObject:curs
+						 forKey:imageName];
+	}
+
 	return curs;
 }
 
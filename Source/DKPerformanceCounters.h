@@ -0,0 +1,108 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Foundation/Foundation.h>
+
+#include <stdatomic.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Point-in-time copy of the framework's performance counters.
+
+ All fields are plain values copied atomically enough for monitoring purposes - individual counters
+ are exact, but a snapshot taken while rendering is in flight may catch a frame half-recorded.
+ Counters accumulate from the moment collection is enabled (or the last reset).
+*/
+typedef struct DKPerformanceSnapshot {
+	uint64_t frameCount; //!< view frames rendered
+	double lastFrameMillis; //!< duration of the most recent frame
+	double averageFrameMillis; //!< mean frame duration
+	uint64_t objectsDrawn; //!< objects returned for update rects (i.e. considered for drawing)
+	uint64_t objectsCulled; //!< objects excluded by spatial culling
+	uint64_t tileCacheHits; //!< layer tiles composited from cache
+	uint64_t tileCacheMisses; //!< layer tiles rendered on demand
+	uint64_t quartzPathCacheHits; //!< drawable CGPath conversions served from cache
+	uint64_t quartzPathCacheMisses; //!< drawable CGPath conversions performed
+	uint64_t swatchCacheHits; //!< style swatch images served from cache
+	uint64_t swatchCacheMisses; //!< style swatch images rendered
+	uint64_t spatialQueryCount; //!< BSP index queries run
+	double averageSpatialQueryMillis; //!< mean BSP query duration
+} DKPerformanceSnapshot;
+
+/** @brief Lightweight performance counters for production monitoring.
+
+ A host application enables collection, then periodically polls \c +snapshot and ships the values to
+ its metrics pipeline. Recording sites throughout the framework are a test of the enable flag
+ followed by a relaxed atomic add, so collection is safe from any thread and costs a single
+ predictable branch per site when disabled. Collection is off by default.
+*/
+@interface DKPerformanceCounters : NSObject
+
+/** @brief Whether the counters are being recorded. Off by default. */
+@property (class) BOOL collectionEnabled;
+
+/** @brief Returns a copy of the current counter values. Thread-safe; may be polled at any rate. */
++ (DKPerformanceSnapshot)snapshot;
+
+/** @brief Zeroes all counters. */
++ (void)reset;
+
+@end
+
+// recording primitives used by the framework's hot paths. Not intended for client use.
+
+typedef struct DKPerformanceCounterStore {
+	_Atomic uint64_t frameCount;
+	_Atomic uint64_t frameNanos;
+	_Atomic uint64_t lastFrameNanos;
+	_Atomic uint64_t objectsDrawn;
+	_Atomic uint64_t objectsCulled;
+	_Atomic uint64_t tileCacheHits;
+	_Atomic uint64_t tileCacheMisses;
+	_Atomic uint64_t quartzPathCacheHits;
+	_Atomic uint64_t quartzPathCacheMisses;
+	_Atomic uint64_t swatchCacheHits;
+	_Atomic uint64_t swatchCacheMisses;
+	_Atomic uint64_t spatialQueryCount;
+	_Atomic uint64_t spatialQueryNanos;
+} DKPerformanceCounterStore;
+
+extern DKPerformanceCounterStore gDKPerfCounters;
+extern _Atomic int gDKPerfCollectionEnabled;
+
+/** @brief Current uptime in nanoseconds, or 0 when collection is disabled. */
+uint64_t DKPerfTimeNow(void);
+
+/** @brief Current uptime in nanoseconds, regardless of the collection flag.
+
+ For callers that keep their own accounting (e.g. per-style render cost) and so must time even when
+ global counter collection is off.
+ */
+uint64_t DKPerfUptimeNanos(void);
+
+NS_INLINE void DKPerfCounterAdd(_Atomic uint64_t* counter, uint64_t amount)
+{
+	if (atomic_load_explicit(&gDKPerfCollectionEnabled, memory_order_relaxed))
+		atomic_fetch_add_explicit(counter, amount, memory_order_relaxed);
+}
+
+NS_INLINE void DKPerfCounterSet(_Atomic uint64_t* counter, uint64_t value)
+{
+	if (atomic_load_explicit(&gDKPerfCollectionEnabled, memory_order_relaxed))
+		atomic_store_explicit(counter, value, memory_order_relaxed);
+}
+
+/** @brief Nanoseconds elapsed since a \c DKPerfTimeNow() result; 0 if timing was or became disabled. */
+NS_INLINE uint64_t DKPerfTimeSince(uint64_t start)
+{
+	if (start == 0)
+		return 0;
+
+	uint64_t now = DKPerfTimeNow();
+	return (now > start) ? (now - start) : 0;
+}
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,92 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKPerformanceCounters.h"
+
+#include <mach/mach_time.h>
+
+DKPerformanceCounterStore gDKPerfCounters;
+_Atomic int gDKPerfCollectionEnabled;
+
+uint64_t DKPerfTimeNow(void)
+{
+	if (!atomic_load_explicit(&gDKPerfCollectionEnabled, memory_order_relaxed))
+		return 0;
+
+	return DKPerfUptimeNanos();
+}
+
+uint64_t DKPerfUptimeNanos(void)
+{
+	static mach_timebase_info_data_t sTimebase;
+
+	if (sTimebase.denom == 0)
+		(void)mach_timebase_info(&sTimebase);
+
+	return mach_absolute_time() * sTimebase.numer / sTimebase.denom;
+}
+
+static inline double millisFromNanos(uint64_t nanos)
+{
+	return (double)nanos / 1.0e6;
+}
+
+@implementation DKPerformanceCounters
+
++ (void)setCollectionEnabled:(BOOL)enable
+{
+	atomic_store_explicit(&gDKPerfCollectionEnabled, enable ? 1 : 0, memory_order_relaxed);
+}
+
++ (BOOL)collectionEnabled
+{
+	return atomic_load_explicit(&gDKPerfCollectionEnabled, memory_order_relaxed) != 0;
+}
+
++ (DKPerformanceSnapshot)snapshot
+{
+	DKPerformanceSnapshot snap;
+
+	uint64_t frameCount = atomic_load_explicit(&gDKPerfCounters.frameCount, memory_order_relaxed);
+	uint64_t frameNanos = atomic_load_explicit(&gDKPerfCounters.frameNanos, memory_order_relaxed);
+	uint64_t queryCount = atomic_load_explicit(&gDKPerfCounters.spatialQueryCount, memory_order_relaxed);
+	uint64_t queryNanos = atomic_load_explicit(&gDKPerfCounters.spatialQueryNanos, memory_order_relaxed);
+
+	snap.frameCount = frameCount;
+	snap.lastFrameMillis = millisFromNanos(atomic_load_explicit(&gDKPerfCounters.lastFrameNanos, memory_order_relaxed));
+	snap.averageFrameMillis = (frameCount > 0) ? millisFromNanos(frameNanos) / (double)frameCount : 0.0;
+	snap.objectsDrawn = atomic_load_explicit(&gDKPerfCounters.objectsDrawn, memory_order_relaxed);
+	snap.objectsCulled = atomic_load_explicit(&gDKPerfCounters.objectsCulled, memory_order_relaxed);
+	snap.tileCacheHits = atomic_load_explicit(&gDKPerfCounters.tileCacheHits, memory_order_relaxed);
+	snap.tileCacheMisses = atomic_load_explicit(&gDKPerfCounters.tileCacheMisses, memory_order_relaxed);
+	snap.quartzPathCacheHits = atomic_load_explicit(&gDKPerfCounters.quartzPathCacheHits, memory_order_relaxed);
+	snap.quartzPathCacheMisses = atomic_load_explicit(&gDKPerfCounters.quartzPathCacheMisses, memory_order_relaxed);
+	snap.swatchCacheHits = atomic_load_explicit(&gDKPerfCounters.swatchCacheHits, memory_order_relaxed);
+	snap.swatchCacheMisses = atomic_load_explicit(&gDKPerfCounters.swatchCacheMisses, memory_order_relaxed);
+	snap.spatialQueryCount = queryCount;
+	snap.averageSpatialQueryMillis = (queryCount > 0) ? millisFromNanos(queryNanos) / (double)queryCount : 0.0;
+
+	return snap;
+}
+
++ (void)reset
+{
+	atomic_store_explicit(&gDKPerfCounters.frameCount, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.frameNanos, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.lastFrameNanos, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.objectsDrawn, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.objectsCulled, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.tileCacheHits, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.tileCacheMisses, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.quartzPathCacheHits, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.quartzPathCacheMisses, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.swatchCacheHits, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.swatchCacheMisses, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.spatialQueryCount, 0, memory_order_relaxed);
+	atomic_store_explicit(&gDKPerfCounters.spatialQueryNanos, 0, memory_order_relaxed);
+}
+
+@end
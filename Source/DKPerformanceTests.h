@@ -0,0 +1,38 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <DKDrawKit/DKBSPDirectObjectStorage.h>
+#import <XCTest/XCTest.h>
+
+/** @brief Performance benchmark suite for the storage, rendering and geometry hot paths.
+
+Performance benchmark suite for the storage, rendering and geometry hot paths. Unlike the functional unit tests, nothing here verifies behaviour -
+each test builds a reproducible scene (the random generator is seeded with a fixed value), times a workload over a fixed number of iterations and
+emits a machine-readable result line to stdout of the form:
+
+	DKBENCH {"benchmark":"<name>","iterations":N,"total_seconds":T,"seconds_per_iteration":S}
+
+so that timings can be collected by scripts and compared between releases. The workloads cover BSP storage insertion and query at large object
+counts, per-rasterizer-class rendering throughput, bezier path length/trimming, and drawing archive round-trips.
+*/
+@interface DKPerformanceTests : XCTestCase
+
+/** times insertion of a large number of storable objects into a BSP-backed storage. */
+- (void)testBSPInsertionPerformance;
+
+/** times rect and point queries against a BSP-backed storage populated with a large number of objects. */
+- (void)testBSPQueryPerformance;
+
+/** times rendering throughput of each stock rasterizer class against a fixed path, drawn offscreen. */
+- (void)testRasterizerRenderingPerformance;
+
+/** times path length estimation and trimming from NSBezierPath+Geometry on a long curved path. */
+- (void)testPathGeometryPerformance;
+
+/** times archiving a populated drawing to data and opening it again. */
+- (void)testArchivingPerformance;
+
+@end
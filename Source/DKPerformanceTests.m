@@ -0,0 +1,285 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import "DKPerformanceTests.h"
+#import "TestBSPStorage.h"
+
+#import <DKDrawKit/DKDrawing.h>
+#import <DKDrawKit/DKDrawableShape.h>
+#import <DKDrawKit/DKFill.h>
+#import <DKDrawKit/DKHatching.h>
+#import <DKDrawKit/DKObjectDrawingLayer.h>
+#import <DKDrawKit/DKStroke.h>
+#import <DKDrawKit/DKStyle.h>
+#import <DKDrawKit/DKZigZagStroke.h>
+#import <DKDrawKit/NSBezierPath+Geometry.h>
+
+// the random generator is seeded with a fixed value before each benchmark so the scenes are
+// identical from run to run - any change in the numbers is a change in the code, not the workload
+
+#define BENCHMARK_RANDOM_SEED 176543
+#define BENCHMARK_BSP_OBJECT_COUNT 100000
+#define BENCHMARK_BSP_QUERY_COUNT 1000
+#define BENCHMARK_CANVAS_SIZE 10000.0
+#define BENCHMARK_RENDER_REPEATS 200
+#define BENCHMARK_ARCHIVE_OBJECT_COUNT 2000
+
+static CGFloat benchRandomFloat(CGFloat minVal, CGFloat maxVal)
+{
+	CGFloat rf = fmod((CGFloat)random(), maxVal - minVal);
+
+	return minVal + rf;
+}
+
+@implementation DKPerformanceTests
+
+#pragma mark - benchmark harness
+
+/** times <block> over <iters> iterations and emits a machine-readable result line to stdout. */
+- (NSTimeInterval)reportBenchmark:(NSString*)name iterations:(NSUInteger)iters block:(void (^)(void))block
+{
+	NSUInteger i;
+	NSTimeInterval start = [NSDate timeIntervalSinceReferenceDate];
+
+	for (i = 0; i < iters; ++i)
+		block();
+
+	NSTimeInterval total = [NSDate timeIntervalSinceReferenceDate] - start;
+
+	NSDictionary* result = @{ @"benchmark": name,
+		@"iterations": @(iters),
+		@"total_seconds": @(total),
+		@"seconds_per_iteration": @(total / (NSTimeInterval)iters) };
+
+	NSData* json = [NSJSONSerialization dataWithJSONObject:result
+												   options:0
+													 error:NULL];
+	NSString* line = [[[NSString alloc] initWithData:json
+											encoding:NSUTF8StringEncoding] autorelease];
+
+	fprintf(stdout, "DKBENCH %s\n", [line UTF8String]);
+	fflush(stdout);
+
+	return total;
+}
+
+/** builds a reproducible population of storable objects scattered over the benchmark canvas. */
+- (NSArray*)benchmarkObjects:(NSUInteger)count
+{
+	NSMutableArray* objects = [NSMutableArray arrayWithCapacity:count];
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i) {
+		testStorableObject* tso = [[testStorableObject alloc] init];
+
+		NSRect bounds;
+		bounds.origin.x = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 300.0);
+		bounds.origin.y = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 300.0);
+		bounds.size.width = benchRandomFloat(1.0, 300.0);
+		bounds.size.height = benchRandomFloat(1.0, 300.0);
+
+		[tso setBounds:bounds];
+		[objects addObject:tso];
+		[tso release];
+	}
+
+	return objects;
+}
+
+- (DKBSPDirectObjectStorage*)populatedBenchmarkStorage
+{
+	DKBSPDirectObjectStorage* storage = [[DKBSPDirectObjectStorage alloc] init];
+	[storage setCanvasSize:NSMakeSize(BENCHMARK_CANVAS_SIZE, BENCHMARK_CANVAS_SIZE)];
+
+	NSArray* objects = [self benchmarkObjects:BENCHMARK_BSP_OBJECT_COUNT];
+	[storage insertObjects:objects
+				 atIndexes:[NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [objects count])]];
+
+	return [storage autorelease];
+}
+
+#pragma mark - storage
+
+- (void)testBSPInsertionPerformance
+{
+	srandom(BENCHMARK_RANDOM_SEED);
+
+	NSArray* objects = [self benchmarkObjects:BENCHMARK_BSP_OBJECT_COUNT];
+	NSIndexSet* allIndexes = [NSIndexSet indexSetWithIndexesInRange:NSMakeRange(0, [objects count])];
+
+	[self reportBenchmark:@"bsp_insert_100k"
+			   iterations:3
+					block:^{
+						DKBSPDirectObjectStorage* storage = [[DKBSPDirectObjectStorage alloc] init];
+						[storage setCanvasSize:NSMakeSize(BENCHMARK_CANVAS_SIZE, BENCHMARK_CANVAS_SIZE)];
+						[storage insertObjects:objects
+									 atIndexes:allIndexes];
+						[storage release];
+					}];
+}
+
+- (void)testBSPQueryPerformance
+{
+	srandom(BENCHMARK_RANDOM_SEED);
+
+	DKBSPDirectObjectStorage* storage = [self populatedBenchmarkStorage];
+
+	[self reportBenchmark:@"bsp_rect_query_100k"
+			   iterations:5
+					block:^{
+						NSUInteger q;
+
+						for (q = 0; q < BENCHMARK_BSP_QUERY_COUNT; ++q) {
+							NSRect qr;
+							qr.origin.x = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 500.0);
+							qr.origin.y = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 500.0);
+							qr.size.width = benchRandomFloat(10.0, 500.0);
+							qr.size.height = benchRandomFloat(10.0, 500.0);
+
+							(void)[storage objectsIntersectingRect:qr
+															inView:nil
+														   options:0];
+						}
+					}];
+
+	[self reportBenchmark:@"bsp_point_query_100k"
+			   iterations:5
+					block:^{
+						NSUInteger q;
+
+						for (q = 0; q < BENCHMARK_BSP_QUERY_COUNT; ++q) {
+							NSPoint qp = NSMakePoint(benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE),
+								benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE));
+
+							(void)[storage objectsContainingPoint:qp];
+						}
+					}];
+}
+
+#pragma mark - rendering
+
+/** returns a fixed moderately complex closed path used by the rendering and geometry suites. */
+- (NSBezierPath*)benchmarkPath
+{
+	NSBezierPath* path = [NSBezierPath bezierPath];
+	NSUInteger i;
+
+	[path moveToPoint:NSMakePoint(256.0, 40.0)];
+
+	for (i = 1; i <= 24; ++i) {
+		CGFloat a = ((CGFloat)i / 24.0) * M_PI * 2.0;
+		CGFloat r = ((i % 2) == 0) ? 200.0 : 120.0;
+		NSPoint p = NSMakePoint(256.0 + cos(a) * r, 256.0 + sin(a) * r);
+
+		[path curveToPoint:p
+			 controlPoint1:NSMakePoint(256.0 + cos(a - 0.1) * (r + 40.0), 256.0 + sin(a - 0.1) * (r + 40.0))
+			 controlPoint2:NSMakePoint(256.0 + cos(a - 0.05) * (r - 40.0), 256.0 + sin(a - 0.05) * (r - 40.0))];
+	}
+
+	[path closePath];
+	return path;
+}
+
+- (void)testRasterizerRenderingPerformance
+{
+	NSBezierPath* path = [self benchmarkPath];
+
+	NSDictionary* rasterizers = @{ @"stroke": [DKStroke strokeWithWidth:2.0
+																 colour:[NSColor blackColor]],
+		@"fill": [DKFill fillWithColour:[NSColor blueColor]],
+		@"hatch": [DKHatching hatchingWithLineWidth:1.0
+											spacing:6.0
+											  angle:0.7],
+		@"zigzag_stroke": [DKZigZagStroke strokeWithWidth:2.0
+												   colour:[NSColor redColor]] };
+
+	NSImage* offscreen = [[NSImage alloc] initWithSize:NSMakeSize(512.0, 512.0)];
+
+	for (NSString* name in rasterizers) {
+		DKRasterizer* rast = [rasterizers objectForKey:name];
+
+		[offscreen lockFocus];
+		[self reportBenchmark:[NSString stringWithFormat:@"render_%@", name]
+				   iterations:5
+						block:^{
+							NSUInteger r;
+
+							for (r = 0; r < BENCHMARK_RENDER_REPEATS; ++r)
+								[rast renderPath:path];
+						}];
+		[offscreen unlockFocus];
+	}
+
+	[offscreen release];
+}
+
+#pragma mark - geometry
+
+- (void)testPathGeometryPerformance
+{
+	NSBezierPath* path = [self benchmarkPath];
+	CGFloat pathLength = [path length];
+
+	[self reportBenchmark:@"path_length"
+			   iterations:50
+					block:^{
+						(void)[path length];
+					}];
+
+	[self reportBenchmark:@"path_trim_to_length"
+			   iterations:50
+					block:^{
+						(void)[path bezierPathByTrimmingToLength:pathLength * 0.5];
+					}];
+
+	[self reportBenchmark:@"path_trim_from_length"
+			   iterations:50
+					block:^{
+						(void)[path bezierPathByTrimmingFromLength:pathLength * 0.25];
+					}];
+}
+
+#pragma mark - archiving
+
+- (void)testArchivingPerformance
+{
+	srandom(BENCHMARK_RANDOM_SEED);
+
+	DKDrawing* drawing = [DKDrawing defaultDrawingWithSize:NSMakeSize(BENCHMARK_CANVAS_SIZE, BENCHMARK_CANVAS_SIZE)];
+	DKObjectDrawingLayer* layer = (DKObjectDrawingLayer*)[drawing activeLayerOfClass:[DKObjectDrawingLayer class]];
+
+	XCTAssertNotNil(layer, @"default drawing has no object layer to populate");
+
+	NSUInteger i;
+
+	for (i = 0; i < BENCHMARK_ARCHIVE_OBJECT_COUNT; ++i) {
+		NSRect r;
+		r.origin.x = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 200.0);
+		r.origin.y = benchRandomFloat(0.0, BENCHMARK_CANVAS_SIZE - 200.0);
+		r.size.width = benchRandomFloat(5.0, 200.0);
+		r.size.height = benchRandomFloat(5.0, 200.0);
+
+		[layer addObject:[DKDrawableShape drawableShapeWithRect:r]];
+	}
+
+	__block NSData* archive = nil;
+
+	[self reportBenchmark:@"drawing_archive"
+			   iterations:5
+					block:^{
+						archive = [drawing drawingData];
+					}];
+
+	XCTAssertNotNil(archive, @"archiving the benchmark drawing produced no data");
+
+	[self reportBenchmark:@"drawing_unarchive"
+			   iterations:5
+					block:^{
+						(void)[DKDrawing drawingWithData:archive];
+					}];
+}
+
+@end
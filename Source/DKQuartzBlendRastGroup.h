@@ -17,6 +17,7 @@ NS_ASSUME_NONNULL_BEGIN
 	CGBlendMode m_blendMode;
 	CGFloat m_alpha;
 	NSImage* m_maskImage;
+	CGImageRef m_cachedMask; // greyscale mask derived from m_maskImage, rebuilt when the image changes
 }
 
 @property CGBlendMode blendMode;
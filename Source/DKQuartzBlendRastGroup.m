@@ -17,7 +17,25 @@ static CGImageRef CreateMaskFromImage(NSImage* image);
 @synthesize alpha = m_alpha;
 
 #pragma mark -
-@synthesize maskImage = m_maskImage;
+- (void)setMaskImage:(NSImage*)image
+{
+	if (image != m_maskImage) {
+		m_maskImage = image;
+
+		// the CGImage mask is derived lazily in render: and kept until the image changes - building
+		// it involves a full greyscale redraw of the image, far too expensive to repeat per frame
+
+		if (m_cachedMask != NULL) {
+			CGImageRelease(m_cachedMask);
+			m_cachedMask = NULL;
+		}
+	}
+}
+
+- (NSImage*)maskImage
+{
+	return m_maskImage;
+}
 
 #pragma mark -
 #pragma mark As a GCObservableObject
@@ -50,6 +68,12 @@ static CGImageRef CreateMaskFromImage(NSImage* image);
 	return self;
 }
 
+- (void)dealloc
+{
+	if (m_cachedMask != NULL)
+		CGImageRelease(m_cachedMask);
+}
+
 #pragma mark -
 #pragma mark As part of DKRasterizerProtocol
 - (void)render:(id)object
@@ -66,7 +90,8 @@ static CGImageRef CreateMaskFromImage(NSImage* image);
 	// apply the mask image if there is one
 
 	if ([self maskImage]) {
-		CGImageRef mask = CreateMaskFromImage([self maskImage]);
+		if (m_cachedMask == NULL)
+			m_cachedMask = CreateMaskFromImage([self maskImage]);
 
 		// TO DO: set up he image so it's aligned to the shape's path bounds and takes account of the
 		// rotation, etc. (As per DKImageAdornment). This is currently only OK for unrotated shapes.
@@ -75,11 +100,9 @@ static CGImageRef CreateMaskFromImage(NSImage* image);
 
 		clipr = [object bounds];
 
-		CGContextClipToMask(context, NSRectToCGRect(clipr), mask);
+		CGContextClipToMask(context, NSRectToCGRect(clipr), m_cachedMask);
 
 		//CGContextDrawImage( context, *(CGRect*)&clipr, mask );
-
-		CGImageRelease(mask);
 	}
 	[super render:object];
 
@@ -5,19 +5,35 @@
 */
 
 #import <Cocoa/Cocoa.h>
+#import "DKRenderCacheKey.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 /** @brief Higher-level wrapper for CGLayer, used to cache graphics in numerous places in DK.
 
 Higher-level wrapper for CGLayer, used to cache graphics in numerous places in DK.
+
+ Backing layers are recycled through a process-wide pool bucketed by size and colorspace: when a cache is released its
+ layer is parked for reuse, and a new cache of the same dimensions clears and adopts it instead of creating a fresh
+ offscreen context. The pool is bounded and entirely transparent to callers of the factory methods.
 */
+#define kDKQuartzCacheMaxMipLevels 8
+
 @interface DKQuartzCache : NSObject {
 @private
 	CGLayerRef mCGLayer;
 	BOOL mFocusLocked;
 	BOOL mFlipped;
 	NSPoint mOrigin;
+	CGLayerRef mMipLayers[kDKQuartzCacheMaxMipLevels];
+	NSUInteger mMipCount;
+	NSUInteger mMipBytes;
+	uint64_t mLastMipUse;
+	BOOL mMipMapped;
+	BOOL mMipsDirty;
+	NSString* mPoolKey; // size + colorspace bucket the backing layer is returned to on release
+	DKRenderCacheKey mDependencyKey; // generations the cached content was rendered under
+	BOOL mHasDependencyKey; // YES once a key has been recorded
 }
 
 + (DKQuartzCache*)cacheForCurrentContextWithSize:(NSSize)size;
@@ -33,6 +49,41 @@ Higher-level wrapper for CGLayer, used to cache graphics in numerous places in D
 @property (getter=isFlipped) BOOL flipped;
 - (BOOL)flipped API_DEPRECATED_WITH_REPLACEMENT("isFlipped", macosx(10.0, 10.6));
 
+/** @brief When set, the cache maintains a chain of half-resolution copies of its content and -drawInRect: composites
+ from the level nearest the requested scale, so heavily zoomed-out drawing neither downscales the full-size layer on
+ every composite nor re-renders. The chain is rebuilt lazily after the content changes (i.e. after -unlockFocus). The
+ memory used by all mip chains is bounded by +mipMapByteBudget; least recently drawn chains are discarded first and
+ rebuilt on demand.
+ */
+@property (nonatomic, getter=isMipMapped) BOOL mipMapped;
+
+/** @brief The total number of bytes the mip chains of all caches may occupy before the least recently used chains are
+ discarded. Base content layers are never evicted. The default is 64MB.
+ */
+@property (class) NSUInteger mipMapByteBudget;
+
+/** @brief Releases all pooled backing layers immediately.
+
+ The pool refills as caches are created and released; call this to give the memory back, e.g. under memory pressure.
+ */
++ (void)drainLayerPool;
+
+/** @brief Records the generation key the cached content was rendered under.
+
+ Call after rendering into the cache (typically right after <code>-unlockFocus</code>) with the key captured
+ for whatever the content was derived from - usually \c DKRenderCacheKeyForObject for artwork derived
+ from a drawable, but callers caching content with other dependencies may fill the key's fields with
+ any stamps that change when those dependencies do.
+ */
+- (void)recordDependencyKey:(DKRenderCacheKey)key;
+
+/** @brief Whether content recorded under the stored key is still current under <code>key</code>.
+
+ Compares with <code>DKRenderCacheKeyEqual</code>. A cache that has never recorded a key answers NO, so
+ call sites can treat "never built" and "outdated" uniformly and simply rebuild on NO.
+ */
+- (BOOL)isValidForKey:(DKRenderCacheKey)key;
+
 - (void)drawAtPoint:(NSPoint)point;
 - (void)drawAtPoint:(NSPoint)point operation:(CGBlendMode)op fraction:(CGFloat)frac;
 - (void)drawInRect:(NSRect)rect;
@@ -6,6 +6,49 @@
 
 #import "DKQuartzCache.h"
 
+// all mip-mapped caches are tracked (weakly) so that the total memory used by their chains can be kept within the
+// budget - when it is exceeded, the least recently drawn chains are discarded and rebuilt on demand. Caches are only
+// ever used from the drawing thread, so no locking is needed here.
+
+static NSHashTable<DKQuartzCache*>* sMipCaches = nil;
+static NSUInteger sMipByteTotal = 0;
+static NSUInteger sMipByteBudget = 64 * 1024 * 1024;
+static uint64_t sMipUseStamp = 0;
+
+// backing layers are pooled process-wide rather than created afresh for every cache - context creation costs show up
+// when caches churn (every zoom step, tool overlay or swatch rebuild makes one). Retired layers are bucketed by exact
+// pixel size and colorspace, cleared on reuse, and the pool is bounded both per bucket and overall. Like the mip
+// machinery above this runs only on the drawing thread, so no locking.
+
+static NSMutableDictionary<NSString*, NSMutableArray*>* sLayerPool = nil;
+static NSUInteger sLayerPoolCount = 0;
+static const NSUInteger kDKQuartzCachePoolBucketCapacity = 4;
+static const NSUInteger kDKQuartzCachePoolMaxLayers = 64;
+
+static NSString* DKQuartzCachePoolKey(CGContextRef port, CGSize size)
+{
+	// the colorspace is only determinable for bitmap-backed contexts; window-backed ones share a bucket
+
+	NSString* spaceName = @"device";
+	CGColorSpaceRef space = CGBitmapContextGetColorSpace(port);
+
+	if (space != NULL) {
+		CFStringRef name = CGColorSpaceCopyName(space);
+
+		if (name != NULL)
+			spaceName = CFBridgingRelease(name);
+	}
+
+	return [NSString stringWithFormat:@"%.0f_%.0f_%@", size.width, size.height, spaceName];
+}
+
+@interface DKQuartzCache ()
+
+- (void)buildMipChain;
+- (void)discardMipChain;
+
+@end
+
 @implementation DKQuartzCache
 
 + (DKQuartzCache*)cacheForCurrentContextWithSize:(NSSize)size
@@ -52,6 +95,22 @@
 	return cache;
 }
 
++ (void)setMipMapByteBudget:(NSUInteger)budget
+{
+	sMipByteBudget = budget;
+}
+
++ (NSUInteger)mipMapByteBudget
+{
+	return sMipByteBudget;
+}
+
++ (void)drainLayerPool
+{
+	[sLayerPool removeAllObjects];
+	sLayerPoolCount = 0;
+}
+
 #pragma mark -
 
 - (instancetype)initWithContext:(NSGraphicsContext*)context forRect:(NSRect)rect
@@ -68,7 +127,22 @@
 #else
 		CGSize cg_size = CGSizeMake(NSWidth(rect), NSHeight(rect));
 #endif
-		mCGLayer = CGLayerCreateWithContext(port, cg_size, NULL);
+		// reuse a pooled layer of the same size and colorspace when one is available - the content is
+		// cleared here so the cache starts out identical to a freshly created one
+
+		mPoolKey = DKQuartzCachePoolKey(port, cg_size);
+
+		NSMutableArray* bucket = [sLayerPool objectForKey:mPoolKey];
+
+		if ([bucket count] > 0) {
+			mCGLayer = (CGLayerRef)CFBridgingRetain([bucket lastObject]);
+			[bucket removeLastObject];
+			--sLayerPoolCount;
+
+			CGContextClearRect(CGLayerGetContext(mCGLayer), CGRectMake(0, 0, cg_size.width, cg_size.height));
+		} else
+			mCGLayer = CGLayerCreateWithContext(port, cg_size, NULL);
+
 		mOrigin = rect.origin;
 		[self setFlipped:[context isFlipped]];
 	}
@@ -99,6 +173,17 @@
 	return [self isFlipped];
 }
 
+- (void)recordDependencyKey:(DKRenderCacheKey)key
+{
+	mDependencyKey = key;
+	mHasDependencyKey = YES;
+}
+
+- (BOOL)isValidForKey:(DKRenderCacheKey)key
+{
+	return mHasDependencyKey && DKRenderCacheKeyEqual(mDependencyKey, key);
+}
+
 - (void)drawAtPoint:(NSPoint)point
 {
 	[self drawAtPoint:point
@@ -119,7 +204,119 @@
 {
 	CGRect cg_rect = CGRectMake(rect.origin.x, rect.origin.y, rect.size.width, rect.size.height);
 	CGContextRef port = [[NSGraphicsContext currentContext] graphicsPort];
-	CGContextDrawLayerInRect(port, cg_rect, mCGLayer);
+	CGLayerRef layer = mCGLayer;
+
+	if (mMipMapped && !mFocusLocked) {
+		if (mMipsDirty)
+			[self buildMipChain];
+
+		mLastMipUse = ++sMipUseStamp;
+
+		// pick the level whose power-of-two scale is nearest the requested one, so that a zoomed-out composite reads
+		// the prefiltered copy instead of downscaling the full-size layer
+
+		NSSize baseSize = [self size];
+		CGFloat scale = MAX(rect.size.width / baseSize.width, rect.size.height / baseSize.height);
+
+		if (scale > 0.0 && scale < 1.0) {
+			NSInteger level = lround(-log2(scale));
+
+			if (level > (NSInteger)mMipCount)
+				level = (NSInteger)mMipCount;
+
+			if (level > 0)
+				layer = mMipLayers[level - 1];
+		}
+	}
+
+	CGContextDrawLayerInRect(port, cg_rect, layer);
+}
+
+#pragma mark -
+
+- (void)setMipMapped:(BOOL)mipMapped
+{
+	if (mipMapped != mMipMapped) {
+		mMipMapped = mipMapped;
+
+		if (mipMapped) {
+			if (sMipCaches == nil)
+				sMipCaches = [NSHashTable weakObjectsHashTable];
+
+			[sMipCaches addObject:self];
+			mMipsDirty = YES;
+		} else {
+			[self discardMipChain];
+			[sMipCaches removeObject:self];
+		}
+	}
+}
+
+- (BOOL)isMipMapped
+{
+	return mMipMapped;
+}
+
+- (void)buildMipChain
+{
+	// each level is rendered from the previous one at half its size, down to roughly 32 points in the larger dimension.
+	// Once built, the chain stays valid until the content is redrawn (-unlockFocus marks it dirty) or it is evicted to
+	// keep the overall budget.
+
+	[self discardMipChain];
+
+	NSSize levelSize = [self size];
+	CGLayerRef previous = mCGLayer;
+
+	while (mMipCount < kDKQuartzCacheMaxMipLevels && MAX(levelSize.width, levelSize.height) >= 64.0) {
+		levelSize.width /= 2.0;
+		levelSize.height /= 2.0;
+
+		CGLayerRef level = CGLayerCreateWithContext(CGLayerGetContext(mCGLayer), CGSizeMake(levelSize.width, levelSize.height), NULL);
+
+		if (level == NULL)
+			break;
+
+		CGContextRef levelContext = CGLayerGetContext(level);
+		CGContextSetInterpolationQuality(levelContext, kCGInterpolationHigh);
+		CGContextDrawLayerInRect(levelContext, CGRectMake(0, 0, levelSize.width, levelSize.height), previous);
+
+		mMipLayers[mMipCount++] = level;
+		mMipBytes += (NSUInteger)(levelSize.width * levelSize.height * 4.0);
+		previous = level;
+	}
+
+	sMipByteTotal += mMipBytes;
+	mMipsDirty = NO;
+
+	// stay within the global budget by discarding the least recently drawn chains (never this one)
+
+	while (sMipByteTotal > sMipByteBudget) {
+		DKQuartzCache* victim = nil;
+
+		for (DKQuartzCache* cache in sMipCaches) {
+			if (cache != self && cache->mMipBytes > 0 && (victim == nil || cache->mLastMipUse < victim->mLastMipUse))
+				victim = cache;
+		}
+
+		if (victim == nil)
+			break;
+
+		[victim discardMipChain];
+		victim->mMipsDirty = YES;
+	}
+}
+
+- (void)discardMipChain
+{
+	for (NSUInteger i = 0; i < mMipCount; ++i) {
+		CGLayerRelease(mMipLayers[i]);
+		mMipLayers[i] = NULL;
+	}
+
+	sMipByteTotal -= mMipBytes;
+	mMipCount = 0;
+	mMipBytes = 0;
 }
 
 - (void)lockFocus
@@ -136,6 +333,11 @@
 																			   flipped:flip];
 	[NSGraphicsContext setCurrentContext:newContext];
 
+	// bracket the layer context's own state so the origin translation doesn't accumulate across
+	// focus sessions - essential now that layers outlive a single cache via the pool
+
+	CGContextSaveGState([self context]);
+
 	NSAffineTransform* transform = [NSAffineTransform transform];
 	[transform translateXBy:-mOrigin.x
 						yBy:-mOrigin.y];
@@ -148,8 +350,16 @@
 {
 	NSAssert(mFocusLocked == YES, @"unlockFocus called without a matching lockFocus");
 
+	CGContextRestoreGState([self context]);
 	[NSGraphicsContext restoreGraphicsState];
 	mFocusLocked = NO;
+
+	// the content just changed, so any existing mip chain is stale - it is rebuilt on the next scaled draw
+
+	if (mMipMapped) {
+		[self discardMipChain];
+		mMipsDirty = YES;
+	}
 }
 
 #pragma mark -
@@ -160,7 +370,33 @@
 	if (mFocusLocked)
 		[self unlockFocus];
 
-	CGLayerRelease(mCGLayer);
+	[self discardMipChain];
+
+	// return the backing layer to the pool for reuse rather than releasing it, within the bounds
+
+	if (mCGLayer != NULL) {
+		if (mPoolKey != nil && sLayerPoolCount < kDKQuartzCachePoolMaxLayers) {
+			if (sLayerPool == nil)
+				sLayerPool = [[NSMutableDictionary alloc] init];
+
+			NSMutableArray* bucket = [sLayerPool objectForKey:mPoolKey];
+
+			if (bucket == nil) {
+				bucket = [[NSMutableArray alloc] init];
+				[sLayerPool setObject:bucket
+							   forKey:mPoolKey];
+			}
+
+			if ([bucket count] < kDKQuartzCachePoolBucketCapacity) {
+				[bucket addObject:CFBridgingRelease(mCGLayer)];
+				++sLayerPoolCount;
+				mCGLayer = NULL;
+			}
+		}
+
+		if (mCGLayer != NULL)
+			CGLayerRelease(mCGLayer);
+	}
 }
 
 @end
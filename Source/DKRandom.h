@@ -18,4 +18,16 @@
  */
 + (CGFloat)randomPositiveOrNegativeNumber;
 
+/** @brief Makes subsequent random numbers come from a deterministic sequence keyed by <code>seed</code>.
+
+ While a seed is set the values are drawn from a private generator, so the normal stream is not
+ perturbed. Callers that need reproducible randomness (e.g. stable roughened geometry) should set a
+ seed, generate, then call \c +clearSeed to restore normal behaviour.
+ */
++ (void)setSeed:(NSUInteger)seed;
+
+/** @brief Restores the normal non-deterministic random sequence.
+ */
++ (void)clearSeed;
+
 @end
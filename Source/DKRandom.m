@@ -6,6 +6,9 @@
 
 #import "DKRandom.h"
 
+static NSUInteger sSeededState = 0;
+static BOOL sSeeded = NO;
+
 @implementation DKRandom
 #pragma mark As a DKRandom
 
@@ -13,6 +16,19 @@
 {
 	// returns a random value between 0 and 1.
 
+	if (sSeeded) {
+		// deterministic xorshift sequence, used while an explicit seed is in force
+
+		NSUInteger x = sSeededState;
+
+		x ^= x << 13;
+		x ^= x >> 7;
+		x ^= x << 17;
+		sSeededState = x;
+
+		return (CGFloat)(x & 0xFFFFFF) / (CGFloat)0xFFFFFF;
+	}
+
 	static unsigned long seed = 0;
 
 	if (seed == 0) {
@@ -30,4 +46,15 @@
 	return [self randomNumber] - 0.5;
 }
 
++ (void)setSeed:(NSUInteger)seed
+{
+	sSeededState = (seed != 0) ? seed : 1; // xorshift must not start from zero
+	sSeeded = YES;
+}
+
++ (void)clearSeed
+{
+	sSeeded = NO;
+}
+
 @end
@@ -35,6 +35,7 @@ as well.
 @interface DKRastGroup : DKRasterizer <NSCoding, NSCopying> {
 @private
 	NSMutableArray<DKRasterizer*>* m_renderList;
+	NSMutableDictionary<NSString*, NSBezierPath*>* mDerivedPathCache; // centrally cached derived geometry, see -derivedPathForKey:creator:
 }
 
 /** @brief The list of contained renderers.
@@ -152,6 +153,31 @@ as well.
  */
 - (void)removeRenderersOfClass:(Class)cl inSubgroups:(BOOL)subs;
 
+/** @brief Returns a derived path for the given cache key, creating and retaining it on a miss.
+
+ This is a central cache service for expensive geometry that rasterizers derive from the rendering
+ path - paralleloid insets, stroke outlines, zig-zags and so on. Rasterizers build their key with
+ <code>-[DKRasterizer derivedPathCacheKeyForPath:parameters:]</code>, which folds in the source
+ path's geometry, the rasterizer's own parameters and the quantized view zoom, so stale entries
+ are simply never asked for again and are eventually evicted when the cache fills. The cache is
+ kept by the root of the tree (normally the style), so nested groups and every contained
+ rasterizer share one store.
+
+ The returned path is the cached instance - callers that modify drawing attributes on it must
+ copy it first.
+ @param key The cache key identifying the derivation.
+ @param creator A block performing the derivation; called only on a cache miss.
+ @return The cached or newly derived path.
+ */
+- (nullable NSBezierPath*)derivedPathForKey:(NSString*)key creator:(nullable NSBezierPath* (NS_NOESCAPE ^)(void))creator;
+
+/** @brief Empties the derived geometry cache.
+
+ Normally unnecessary - keys change when their inputs do - but available where a large amount of
+ cached geometry is known to be obsolete, such as when a document closes.
+ */
+- (void)invalidateDerivedPathCache;
+
 // KVO compliant variants of the render list management methods, key = "renderList"
 
 - (__kindof DKRasterizer*)objectInRenderListAtIndex:(NSUInteger)indx;
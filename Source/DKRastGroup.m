@@ -11,6 +11,11 @@
 #import "LogEvent.h"
 #import "NSDictionary+DeepCopy.h"
 
+// the derived path cache is emptied wholesale when it reaches this many entries - the handful of hot
+// keys repopulate within a frame or two, which is far simpler than tracking recency per entry
+
+static const NSUInteger kDKDerivedPathCacheCapacity = 128;
+
 @implementation DKRastGroup
 #pragma mark As a DKRenderGroup
 
@@ -70,6 +75,62 @@
 
 #pragma mark -
 
+- (NSBezierPath*)derivedPathForKey:(NSString*)key creator:(NSBezierPath* (NS_NOESCAPE ^)(void))creator
+{
+	NSAssert(key != nil, @"derived path cache key cannot be nil");
+
+	// the cache is kept by the root of the tree (normally the style) so that all rasterizers in the
+	// tree share one store - a group below the root forwards the request upwards
+
+	DKRastGroup* root = [self root];
+
+	if (root != nil && root != self)
+		return [root derivedPathForKey:key
+							   creator:creator];
+
+	// styles may be rendered from several threads at once when concurrent layer rendering is in
+	// use, so access to the shared store is serialized
+
+	NSBezierPath* path;
+
+	@synchronized(self) {
+		path = [mDerivedPathCache objectForKey:key];
+	}
+
+	if (path == nil && creator != nil) {
+		path = creator();
+
+		if (path != nil) {
+			@synchronized(self) {
+				if (mDerivedPathCache == nil)
+					mDerivedPathCache = [[NSMutableDictionary alloc] init];
+				else if ([mDerivedPathCache count] >= kDKDerivedPathCacheCapacity)
+					[mDerivedPathCache removeAllObjects];
+
+				[mDerivedPathCache setObject:path
+									  forKey:key];
+			}
+		}
+	}
+
+	return path;
+}
+
+- (void)invalidateDerivedPathCache
+{
+	DKRastGroup* root = [self root];
+
+	if (root != nil && root != self) {
+		[root invalidateDerivedPathCache];
+	} else {
+		@synchronized(self) {
+			[mDerivedPathCache removeAllObjects];
+		}
+	}
+}
+
+#pragma mark -
+
 - (void)addRenderer:(DKRasterizer*)renderer
 {
 	if (![m_renderList containsObject:renderer]) {
@@ -407,6 +468,16 @@
 	if (![object conformsToProtocol:@protocol(DKRenderable)])
 		return;
 
+	// the outer save/restore only matters if some contained rasterizer can leave context state
+	// behind; the stock rasterizers declare themselves clean, so styles composed of them render
+	// without any state management at this level
+
+	if (![self perturbsContextState]) {
+		[[self renderList] makeObjectsPerformSelector:_cmd
+										   withObject:object];
+		return;
+	}
+
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 		[[self renderList] makeObjectsPerformSelector:_cmd
 										   withObject:object];
@@ -425,12 +496,35 @@
 	if (![self enabled])
 		return;
 
+	if (![self perturbsContextState]) {
+		[[self renderList] makeObjectsPerformSelector:_cmd
+										   withObject:path];
+		return;
+	}
+
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 		[[self renderList] makeObjectsPerformSelector:_cmd
 										   withObject:path];
 	RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 }
 
+/** @brief Returns whether any contained rasterizer can leave context state modified.
+
+ The group itself touches no context state - only its members do - so the answer is simply whether any
+ enabled member perturbs. Disabled members don't draw and so don't count. This propagates through nested
+ groups, so a whole style built from clean rasterizers reports clean and renders with no save/restore
+ churn anywhere in the hierarchy.
+ */
+- (BOOL)perturbsContextState
+{
+	for (DKRasterizer* rast in [self renderList]) {
+		if ([rast enabled] && [rast perturbsContextState])
+			return YES;
+	}
+
+	return NO;
+}
+
 /** @brief Queries whther the rasterizer implements a fill or not
 
  Returns YES if any contained rasterizer returns YES, NO otherwise
@@ -46,6 +46,33 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
 */
 + (nullable DKRasterizer*)rasterizerFromPasteboard:(NSPasteboard*)pb;
 
+/** @brief Returns an empty scratch path for use as a rendering temporary.
+
+ Scratch paths come from a per-thread recycling pool, so rasterizer internals that need a throwaway
+ path per render (trim, offset and outline intermediates, attribute-bearing copies) avoid allocating
+ one every frame - the paths keep their element storage across reuse. The pool is reset wholesale by
+ \c +recycleScratchPaths after each object's render, so a scratch path must never be stored beyond
+ the render pass that obtained it - copy it if it needs to outlive the pass.
+ @return an empty path valid until the end of the current render pass
+ */
++ (NSBezierPath*)scratchPath;
+
+/** @brief Returns a scratch path containing the elements of the given path.
+
+ Equivalent to copying the path into a scratch path from <code>+scratchPath</code>; use it where a
+ mutable, attribute-safe copy of a source path is needed only for the duration of the render.
+ @param path the path whose elements to copy in
+ @return a path with the same elements, valid until the end of the current render pass
+ */
++ (NSBezierPath*)scratchPathWithPath:(NSBezierPath*)path;
+
+/** @brief Makes every scratch path handed out on this thread since the previous reset reusable.
+
+ Called by \c DKStyle at the end of each object's render; only code driving rendering directly needs
+ to call this itself.
+ */
++ (void)recycleScratchPaths;
+
 - (instancetype)init NS_DESIGNATED_INITIALIZER;
 - (nullable instancetype)initWithCoder:(NSCoder*)coder NS_DESIGNATED_INITIALIZER;
 
@@ -96,6 +123,17 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
  */
 @property DKClippingOption clipping;
 
+/** @brief Whether rendering may leave persistent graphics context state modified.
+
+ Persistent state means the clip, shadow, transform, compositing mode or alpha - per-draw attributes such
+ as the current colour or line width, which every rasterizer establishes before drawing, do not count.
+ The default is \c YES, which preserves the conservative save/restore bracketing around every rasterizer.
+ Subclasses whose rendering either touches no persistent state or brackets its own changes internally
+ return \c NO, letting containing groups skip the save/restore pairs entirely - context state management
+ is a measurable share of render time in styles composed of simple strokes and fills.
+ */
+@property (readonly) BOOL perturbsContextState;
+
 /** @brief Returns the path to render given the object doing the rendering
 
  This method is called internally by render: to obtain the path to be rendered. It is factored to
@@ -106,6 +144,30 @@ typedef NS_ENUM(NSInteger, DKClippingOption) {
  @return the rendering path */
 - (NSBezierPath*)renderingPathForObject:(id<DKRenderable>)object;
 
+/** @brief Builds a key for the container's derived path cache.
+
+ The key folds together the rasterizer's identity, the source path's geometry (element count and
+ bounds stand in for a generation counter) and the current view zoom quantized to quarter steps,
+ so zoom-dependent derivations are reused across frames at the same zoom without flooding the
+ cache during zoom animation. \c params should carry whatever parameters of the rasterizer the
+ derivation depends on, formatted into a string.
+ @param path The source path the derivation starts from.
+ @param params The derivation parameters, formatted into a string.
+ @return A key for use with <code>-cachedDerivedPathWithKey:creator:</code>.
+ */
+- (NSString*)derivedPathCacheKeyForPath:(NSBezierPath*)path parameters:(NSString*)params;
+
+/** @brief Returns a derived path via the container's central cache, deriving it on a miss.
+
+ Convenience wrapper around <code>-[DKRastGroup derivedPathForKey:creator:]</code> that simply
+ invokes the creator directly when the rasterizer has no container. The returned path is the
+ cached instance - copy it before changing its drawing attributes.
+ @param key A key built with <code>-derivedPathCacheKeyForPath:parameters:</code>.
+ @param creator A block performing the derivation; called only on a cache miss.
+ @return The cached or newly derived path.
+ */
+- (nullable NSBezierPath*)cachedDerivedPathWithKey:(NSString*)key creator:(nullable NSBezierPath* (NS_NOESCAPE ^)(void))creator;
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb;
 
 @end
@@ -4,6 +4,7 @@
  @copyright MPL2; see LICENSE.txt
 */
 
+#import "DKObjectPool.h"
 #import "DKRasterizer.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
@@ -14,6 +15,48 @@ NSString* const kDKRasterizerPropertyWillChange = @"kDKRasterizerPropertyWillCha
 NSString* const kDKRasterizerPropertyDidChange = @"kDKRasterizerPropertyDidChange";
 NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedPropertyKey";
 
+static NSString* const kDKRasterizerScratchPoolKey = @"DKRasterizer_scratchPathPool";
+
+/** scratch paths are recycled through DKObjectPool, which clears them via -prepareForReuse as they
+ are handed out again. Clearing removes the elements but keeps the path's element storage, and resets
+ the drawing attributes a previous user may have set. */
+@interface NSBezierPath (DKScratchRecycling) <DKRecyclableObject>
+@end
+
+@implementation NSBezierPath (DKScratchRecycling)
+
+- (void)prepareForReuse
+{
+	[self removeAllPoints];
+	[self setLineWidth:1.0];
+	[self setLineCapStyle:NSButtLineCapStyle];
+	[self setLineJoinStyle:NSMiterLineJoinStyle];
+	[self setMiterLimit:10.0];
+	[self setWindingRule:NSNonZeroWindingRule];
+	[self setFlatness:[NSBezierPath defaultFlatness]];
+	[self setLineDash:NULL
+				count:0
+				phase:0.0];
+}
+
+@end
+
+/** returns the calling thread's scratch path pool, creating it on first use. Pools live in the
+ thread dictionary, so each rendering thread recycles its own paths without locking. */
+static DKObjectPool* scratchPathPool(void)
+{
+	NSMutableDictionary* threadDict = [[NSThread currentThread] threadDictionary];
+	DKObjectPool* pool = [threadDict objectForKey:kDKRasterizerScratchPoolKey];
+
+	if (pool == nil) {
+		pool = [[DKObjectPool alloc] initWithObjectClass:[NSBezierPath class]];
+		[threadDict setObject:pool
+					   forKey:kDKRasterizerScratchPoolKey];
+	}
+
+	return pool;
+}
+
 @implementation DKRasterizer
 #pragma mark As a DKRasterizer
 
@@ -36,6 +79,42 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	return rend;
 }
 
+#pragma mark -
+
+/** @brief Returns an empty scratch path for use as a rendering temporary
+
+ The path comes from the calling thread's recycling pool and remains valid until the pool is reset
+ by \c +recycleScratchPaths at the end of the object's render - it must not be stored beyond that.
+ @return an empty path valid until the end of the current render pass
+ */
++ (NSBezierPath*)scratchPath
+{
+	return [scratchPathPool() acquire];
+}
+
+/** @brief Returns a scratch path containing the elements of the given path
+ @param path the path whose elements to copy in
+ @return a path with the same elements, valid until the end of the current render pass
+ */
++ (NSBezierPath*)scratchPathWithPath:(NSBezierPath*)path
+{
+	NSBezierPath* scratch = [scratchPathPool() acquire];
+
+	if (path)
+		[scratch appendBezierPath:path];
+
+	return scratch;
+}
+
+/** @brief Makes every scratch path handed out on this thread since the previous reset reusable
+
+ Called by \c DKStyle at the end of each object's render.
+ */
++ (void)recycleScratchPaths
+{
+	[scratchPathPool() beginNewGeneration];
+}
+
 /** @brief Sets the immediate container of this object
 
  This is a weak reference as the object is owned by its container. Generally this is called as
@@ -102,6 +181,15 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	mClipping = clipping;
 }
 
+- (BOOL)perturbsContextState
+{
+	// conservative default - unaudited subclasses keep the save/restore bracketing they have always
+	// had. Subclasses whose rendering touches no persistent context state (or brackets what it does
+	// touch internally) override this to return NO so containers can skip the redundant saves.
+
+	return YES;
+}
+
 #pragma mark -
 
 /** @brief Returns the path to render given the object doing the rendering
@@ -117,6 +205,45 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 	return [object renderingPath];
 }
 
+- (NSString*)derivedPathCacheKeyForPath:(NSBezierPath*)path parameters:(NSString*)params
+{
+	// the zoom is read from the current context's CTM and quantized to quarter steps so that
+	// animated zooming doesn't generate a new key for every intermediate scale
+
+	CGFloat zoom = 1.0;
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	if (context != NULL)
+		zoom = CGContextGetCTM(context).a;
+
+	zoom = round(fabs(zoom) * 4.0) * 0.25;
+
+	// the root style's change generation folds any change anywhere in the style tree into the key,
+	// so stale entries simply stop being hit and age out - no notification observer is needed
+
+	NSUInteger styleGeneration = 0;
+	DKRastGroup* root = [self root];
+
+	if ([root isKindOfClass:[DKStyle class]])
+		styleGeneration = [(DKStyle*)root changeGeneration];
+
+	// the element count and bounds stand in for a path generation counter - rendering paths are
+	// rebuilt per draw, so pointer identity carries no information
+
+	return [NSString stringWithFormat:@"%@_%p_%lu_%ld_%@_%.2f_%@", NSStringFromClass([self class]), self, (unsigned long)styleGeneration, (long)[path elementCount], NSStringFromRect([path bounds]), zoom, params];
+}
+
+- (NSBezierPath*)cachedDerivedPathWithKey:(NSString*)key creator:(NSBezierPath* (NS_NOESCAPE ^)(void))creator
+{
+	DKRastGroup* group = [self container];
+
+	if (group == nil)
+		return creator ? creator() : nil;
+
+	return [group derivedPathForKey:key
+							creator:creator];
+}
+
 - (BOOL)copyToPasteboard:(NSPasteboard*)pb
 {
 	NSAssert(pb != nil, @"expected pasteboard to be non-nil");
@@ -192,6 +319,15 @@ NSString* const kDKRasterizerChangedPropertyKey = @"kDKRasterizerChangedProperty
 
 	if ([self enabled]) {
 		NSBezierPath* path = [self renderingPathForObject:object];
+
+		// when no clip applies and the rasterizer declares that it leaves no persistent context
+		// state behind, the save/restore pair is pure overhead, so render directly without it
+
+		if ([self clipping] == kDKClippingNone && ![self perturbsContextState]) {
+			[self renderPath:path];
+			return;
+		}
+
 		SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 			switch ([self clipping])
 		{
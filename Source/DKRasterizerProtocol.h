@@ -67,6 +67,16 @@ NS_SWIFT_NAME(DKRasterizerProtocol)
 - (void)renderPath:(nullable NSBezierPath*)path;
 @property (readonly) BOOL isFill;
 
+@optional
+
+/** Returns \c YES if \c -render: may leave persistent graphics context state (the clip, shadow, transform,
+ compositing mode or alpha) modified after it returns; \c NO if the rasterizer either touches no such state
+ or brackets its own changes with save/restore internally. Containers use this to skip redundant context
+ saves around rasterizers that declare themselves clean. Rasterizers that do not implement this are treated
+ as perturbing, which preserves the conservative always-save behaviour.
+ */
+@property (readonly) BOOL perturbsContextState;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -0,0 +1,56 @@
+/**
+ @author Contributions from the community; see CONTRIBUTORS.md
+ @date 2005-2016
+ @copyright MPL2; see LICENSE.txt
+*/
+
+#import <Cocoa/Cocoa.h>
+#import "DKDrawableObject.h"
+#import "DKStyle.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/** @brief Combined generation stamp for cached artwork derived from a drawable and its style.
+
+ Caches that hold rendered or derived geometry for a drawable (tiles, CGLayers, clipped segment sets,
+ derived paths) need a cheap way to tell whether an entry is still current. Rather than each cache
+ observing object and style change notifications, an entry records a \c DKRenderCacheKey when it is
+ built and compares it against a freshly captured key before reuse - four integer/float comparisons,
+ with no notification traffic on the hot path.
+
+ The key combines the drawable's change sequence (bumped by <code>-notifyVisualChange</code>), the owning
+ style's change generation (bumped per committed style change, once per update transaction), the
+ rendering path's element count as a proxy for path identity, and the view scale the artwork was
+ produced at. Rendering paths in DrawKit are plain \c NSBezierPath objects rebuilt on demand and carry
+ no generation of their own, which is why the element count stands in for one here.
+ */
+typedef struct DKRenderCacheKey {
+	NSUInteger objectGeneration; // the drawable's change sequence when the entry was built
+	NSUInteger styleGeneration; // the style's change generation when the entry was built
+	NSInteger pathElementCount; // element count of the rendering path, proxy for path identity
+	CGFloat zoom; // view scale the cached artwork was produced at
+} DKRenderCacheKey;
+
+/** @brief Assembles a key from its components. */
+NS_INLINE DKRenderCacheKey DKRenderCacheKeyMake(NSUInteger objectGeneration, NSUInteger styleGeneration, NSInteger pathElementCount, CGFloat zoom)
+{
+	DKRenderCacheKey key = { objectGeneration, styleGeneration, pathElementCount, zoom };
+	return key;
+}
+
+/** @brief Captures the current generations of a drawable and its style.
+
+ \c path may be nil for caches whose content does not depend on a particular rendering path.
+ */
+NS_INLINE DKRenderCacheKey DKRenderCacheKeyForObject(DKDrawableObject* obj, NSBezierPath* _Nullable path, CGFloat zoom)
+{
+	return DKRenderCacheKeyMake([obj changeSequence], [[obj style] changeGeneration], path ? (NSInteger)[path elementCount] : 0, zoom);
+}
+
+/** @brief The staleness test - YES if a cached entry built under \c a is still valid under <code>b</code>. */
+NS_INLINE BOOL DKRenderCacheKeyEqual(DKRenderCacheKey a, DKRenderCacheKey b)
+{
+	return a.objectGeneration == b.objectGeneration && a.styleGeneration == b.styleGeneration && a.pathElementCount == b.pathElementCount && a.zoom == b.zoom;
+}
+
+NS_ASSUME_NONNULL_END
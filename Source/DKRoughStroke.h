@@ -23,12 +23,22 @@ NS_ASSUME_NONNULL_BEGIN
 @interface DKRoughStroke : DKStroke <NSCoding, NSCopying> {
 @private
 	CGFloat mRoughness;
+	NSUInteger mSeed;
 	NSMutableDictionary<NSString*, NSBezierPath*>* mPathCache;
 	NSMutableArray<NSBezierPath*>* mCacheList;
 }
 
 @property (nonatomic) CGFloat roughness;
 
+/** @brief The seed used when randomising the stroke outline.
+
+ The roughened geometry is fully determined by the path, width, roughness and this seed, so a given
+ stroke no longer shimmers when its cached outline is discarded and recomputed. A new stroke picks a
+ seed at random when initialised and keeps it thereafter (it is archived), so every rough stroke still
+ looks individual; set it explicitly to reproduce a particular appearance.
+ */
+@property (nonatomic) NSUInteger seed;
+
 - (NSString*)pathKeyForPath:(NSBezierPath*)path;
 - (void)invalidateCache;
 - (nullable NSBezierPath*)roughPathFromPath:(NSBezierPath*)path;
@@ -5,6 +5,8 @@
 */
 
 #import "DKRoughStroke.h"
+#import "DKDiskRenderCache.h"
+#import "DKRandom.h"
 #import "NSBezierPath+Geometry.h"
 
 @implementation DKRoughStroke
@@ -21,13 +23,23 @@
 
 @synthesize roughness = mRoughness;
 
+- (void)setSeed:(NSUInteger)seed
+{
+	if (seed != mSeed) {
+		mSeed = seed;
+		[self invalidateCache];
+	}
+}
+
+@synthesize seed = mSeed;
+
 - (NSString*)pathKeyForPath:(NSBezierPath*)path
 {
-	// form a simple hash from the path's size, length and current stroke width. Note that the precision is deliberately set to just 1 decimal
-	// place so that minor rounding errors when doing path transforms don't generate different keys. Do not rely on this format, or attempt
-	// to interpret it.
+	// form a simple hash from the path's size, length, current stroke width, roughness and seed. Note that the precision is deliberately set
+	// to just 1 decimal place so that minor rounding errors when doing path transforms don't generate different keys. Do not rely on this
+	// format, or attempt to interpret it.
 
-	return [NSString stringWithFormat:@"%.1f.%.1f.%.1f.%.1f", [path bounds].size.width, [path bounds].size.height, [path length], [self width]];
+	return [NSString stringWithFormat:@"%.1f.%.1f.%.1f.%.1f.%.3f.%lu", [path bounds].size.width, [path bounds].size.height, [path length], [self width], [self roughness], (unsigned long)[self seed]];
 }
 
 - (void)invalidateCache
@@ -46,9 +58,32 @@
 	NSRect pb = [path bounds];
 
 	if (cp == nil) {
-		// not in the cache, so create it from scratch
+		// not in memory - a previous launch may have banked the identical outline on disk. The
+		// roughening is a pure function of the key's inputs (see below), so a disk hit is exact.
+
+		NSString* fingerprint = [@"DKRoughStroke." stringByAppendingString:key];
+		NSBezierPath* banked = [[DKDiskRenderCache sharedCache] bezierPathForFingerprint:fingerprint];
+
+		if (banked != nil) {
+			[mPathCache setObject:banked
+						   forKey:key];
+			[mCacheList insertObject:banked
+							 atIndex:0];
+
+			// the stored path has its origin at 0,0 - align it to the path being rendered
+
+			[tfm translateXBy:pb.origin.x
+						  yBy:pb.origin.y];
+			return [tfm transformBezierPath:banked];
+		}
+
+		// nothing banked either, so create it from scratch. The randomisation is seeded from the stroke's seed
+		// mixed with the path key, so recomputing the same outline after a cache miss reproduces identical
+		// geometry - the stroke doesn't shimmer when the cache is discarded.
 
+		[DKRandom setSeed:[self seed] ^ [key hash]];
 		cp = [path bezierPathWithRoughenedStrokeOutline:[self roughness] * [self width]];
+		[DKRandom clearSeed];
 
 		if (cp != nil) {
 			// set its origin to 0,0 based on the original path
@@ -57,12 +92,14 @@
 						  yBy:-pb.origin.y];
 			NSBezierPath* temp = [tfm transformBezierPath:cp];
 
-			// cache it for future re-use
+			// cache it for future re-use, and bank it for the next launch
 
 			[mPathCache setObject:temp
 						   forKey:key];
 			[mCacheList insertObject:temp
 							 atIndex:0];
+			[[DKDiskRenderCache sharedCache] storeBezierPath:temp
+											  forFingerprint:fingerprint];
 
 			//NSLog(@"DKRoughStroke cached new path, key = %@", key );
 
@@ -105,6 +142,7 @@
 	if (self != nil) {
 		mPathCache = [[NSMutableDictionary alloc] init];
 		mCacheList = [[NSMutableArray alloc] init];
+		mSeed = (NSUInteger)([DKRandom randomNumber] * 0x7FFFFFFF) + 1;
 		[self setRoughness:0.25];
 	}
 
@@ -166,6 +204,13 @@
 		mPathCache = [[NSMutableDictionary alloc] init];
 		mCacheList = [[NSMutableArray alloc] init];
 		[self setRoughness:[coder decodeDoubleForKey:@"DKRoughStroke_roughness"]];
+
+		// older archives carry no seed - pick one so the stroke's appearance is at least stable from now on
+
+		if ([coder containsValueForKey:@"DKRoughStroke_seed"])
+			mSeed = (NSUInteger)[coder decodeIntegerForKey:@"DKRoughStroke_seed"];
+		else
+			mSeed = (NSUInteger)([DKRandom randomNumber] * 0x7FFFFFFF) + 1;
 	}
 
 	return self;
@@ -176,6 +221,8 @@
 	[super encodeWithCoder:coder];
 	[coder encodeDouble:[self roughness]
 				 forKey:@"DKRoughStroke_roughness"];
+	[coder encodeInteger:(NSInteger)[self seed]
+				  forKey:@"DKRoughStroke_seed"];
 }
 
 #pragma mark -
@@ -185,6 +232,7 @@
 {
 	DKRoughStroke* rs = [super copyWithZone:zone];
 	[rs setRoughness:[self roughness]];
+	[rs setSeed:[self seed]];
 
 	return rs;
 }
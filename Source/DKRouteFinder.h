@@ -40,7 +40,8 @@ resolves to an \c NSPoint return value, and is given by <code>key</code>. The re
 */
 @interface DKRouteFinder : NSObject {
 @private
-	NSArray<NSValue*>* mInput; // input list of NSPoint values
+	NSArray<NSValue*>* mInput; // input list of NSPoint values; may be nil when initialised from a raw point buffer
+	NSUInteger mInputCount; // number of input points
 	DKRouteAlgorithmType mAlgorithm; // which algorithm to use
 	NSInteger* mOrder; // final sort order (1-based)
 	BOOL mCalculationDone; // flag whether the sort was run
@@ -53,9 +54,21 @@ resolves to an \c NSPoint return value, and is given by <code>key</code>. The re
 	// for NN
 	NSMutableArray<NSValue*>* mVisited; // for NN, the list of visited points in visit order
 	DKDirection mDirection; // limit search for NN to this direction
+	// for async operation
+	BOOL mCancelled; // set by -cancel; the annealing loop checks this cooperatively
+	NSArray<NSNumber*>* mCheckpoint; // latest best-so-far route snapshot (0-based indices), guarded by @synchronized(self)
+	NSInteger mLastCheckpointStep; // temperature step of the last snapshot taken
 }
 
 + (nullable DKRouteFinder*)routeFinderWithArrayOfPoints:(NSArray<NSValue*>*)arrayOfPoints NS_REFINED_FOR_SWIFT;
+
+/** @brief Creates a route finder from a C array of points, without boxing each one in an NSValue.
+
+ Equivalent to \c +routeFinderWithArrayOfPoints: but takes the points in contiguous storage, which
+ the Swift overlay hands over directly from an array of <code>CGPoint</code>s. Returns \c nil for
+ fewer than four points, as for the array form.
+ */
++ (nullable DKRouteFinder*)routeFinderWithPoints:(const NSPoint*)points count:(NSUInteger)count NS_REFINED_FOR_SWIFT;
 + (nullable DKRouteFinder*)routeFinderWithObjects:(NSArray*)objects withValueForKey:(NSString*)key;
 + (NSArray*)sortedArrayOfObjects:(NSArray*)objects byShortestRouteForKey:(NSString*)key;
 @property (class) DKRouteAlgorithmType algorithm;
@@ -68,6 +81,24 @@ resolves to an \c NSPoint return value, and is given by <code>key</code>. The re
  */
 - (NSArray<NSNumber*>*)shortestRouteOrder NS_REFINED_FOR_SWIFT;
 
+/** @brief The number of input points. */
+@property (readonly) NSUInteger pointCount;
+
+/** @brief Copies the original points, reordered into the shortest route, into \c buffer.
+
+ The buffer must have room for at least \c pointCount points. The result is the same as
+ <code>-shortestRoute</code>, without the boxing. Runs the calculation if it has not yet been run.
+ */
+- (void)getShortestRoutePoints:(NSPoint*)buffer NS_REFINED_FOR_SWIFT;
+
+/** @brief Copies the shortest route order into \c buffer.
+
+ The buffer must have room for at least \c pointCount values. The result is the same as
+ <code>-shortestRouteOrder</code> (0-based indices into the input), without the boxing. Runs the
+ calculation if it has not yet been run.
+ */
+- (void)getShortestRouteOrder:(NSInteger*)buffer NS_REFINED_FOR_SWIFT;
+
 /** @brief Sorts \c anArray according to the sort order calculated and returns the sorted copy.
  */
 - (nullable NSArray*)sortedArrayFromArray:(NSArray*)anArray;
@@ -79,10 +110,56 @@ resolves to an \c NSPoint return value, and is given by <code>key</code>. The re
 
 @property (weak, nullable) id<DKRouteFinderProgressDelegate> progressDelegate;
 
+/** @brief Runs the route calculation on a background queue.
+
+ The completion handler is invoked on the main queue with the result of \c -shortestRouteOrder and the
+ path length. While the run is in progress, <code>-currentBestRouteOrder</code> returns periodic
+ checkpoints of the best route found so far, so callers can show a usable route immediately and let it
+ keep improving. Note that progress delegate callbacks arrive on the background queue - a delegate that
+ updates UI should forward to the main thread. A run abandoned with \c -cancel still completes normally
+ with the best route found up to that point.
+ */
+- (void)findRouteAsynchronouslyWithCompletionHandler:(void (^)(NSArray<NSNumber*>* routeOrder, CGFloat pathLength))completionHandler;
+
+/** @brief Resumes annealing from the best route found so far, for \c steps further temperature steps.
+
+ Only meaningful for the simulated annealing algorithm; a no-op otherwise. Because the current order
+ seeds the run, improvement accumulates across calls - a cancelled or completed run can be refined
+ further at any time. The completion handler is invoked on the main queue as for
+ <code>-findRouteAsynchronouslyWithCompletionHandler:</code>.
+ */
+- (void)refineAsynchronouslyWithAdditionalSteps:(NSInteger)steps completionHandler:(void (^)(NSArray<NSNumber*>* routeOrder, CGFloat pathLength))completionHandler;
+
+/** @brief Requests cooperative cancellation of a running calculation.
+
+ The annealing loop polls this between moves and stops at the next opportunity, leaving the best route
+ found so far in place - the route order remains a valid permutation at every point, so the result is
+ immediately usable.
+ */
+- (void)cancel;
+@property (readonly, getter=isCancelled) BOOL cancelled;
+
+/** @brief Returns the latest checkpoint of the best-so-far route, or nil if none has been taken yet.
+
+ Checkpoints are published at each annealing temperature step and on completion, in the same form as
+ <code>-shortestRouteOrder</code> (0-based indices into the input array). Safe to call from any thread
+ while a background run is in progress.
+ */
+- (nullable NSArray<NSNumber*>*)currentBestRouteOrder;
+
 @end
 
 #define kDKDefaultAnnealingSteps 100
 
+/** simulated annealing inputs at least this large are split into spatial clusters (k-d partition of
+ roughly \c kDKAnnealingClusterSize points each) which are annealed concurrently on worker threads and
+ then stitched back together with a 2-opt pass across the cluster seams. Results are equivalent in
+ quality to the serial path but arrive far sooner for large inputs. Note that in this mode the progress
+ delegate is called on private worker threads - a delegate that updates UI should forward to the main
+ thread. */
+#define kDKConcurrentAnnealingThreshold 2000
+#define kDKAnnealingClusterSize 512
+
 /** @brief Protocol that an object can implement to be called back as the route finding progresses.
  \c value is in the range 0..1
  */
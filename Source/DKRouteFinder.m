@@ -6,19 +6,43 @@
 
 #import "DKRouteFinder.h"
 
-static CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, const void* context);
-static void progressCallback(CGFloat iteration, CGFloat maxIterations, const void* context);
+// the progress function returns whether the annealing loop should continue; returning NO requests
+// cooperative cancellation, with the loop stopping at the next opportunity.
+
+typedef BOOL (*DKAnnealProgressFunction)(CGFloat iteration, CGFloat maxIterations, const void* context);
+
+static CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, DKAnnealProgressFunction progress, const void* context);
+static BOOL progressCallback(CGFloat iteration, CGFloat maxIterations, const void* context);
+static BOOL clusterProgressCallback(CGFloat iteration, CGFloat maxIterations, const void* context);
+static void partitionClusterRange(NSInteger indices[], NSRange range, const CGFloat x[], const CGFloat y[], NSMutableArray<NSValue*>* outRanges);
+static void twoOptImproveAroundSeam(const CGFloat x[], const CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger seam, NSInteger window);
 static DKDirection directionOfAngle(const CGFloat angle);
 
+// shared progress state for the concurrent annealing path. Each cluster writes only its own slot;
+// reads of the other slots are racy but only ever feed a progress figure, so that is harmless.
+
+typedef struct {
+	const void* routeFinder; // the DKRouteFinder, bridged
+	CGFloat* clusterProgress; // per-cluster fraction complete, 0..1
+	CGFloat* lastNotified; // overall fraction at the last delegate callback
+	NSInteger clusterIndex;
+	NSInteger clusterCount;
+} DKClusterProgressContext;
+
 @interface DKRouteFinder ()
 
 - (id)initWithArray:(NSArray<NSValue*>*)array;
+- (id)initWithPoints:(const NSPoint*)points count:(NSUInteger)count;
+- (NSArray<NSValue*>*)boxedInputPoints;
 - (void)notifyProgress:(CGFloat)value;
 - (NSUInteger)nearestNeighbourInArray:(NSArray*)arrayOfPoint toPoint:(NSPoint)cvp inDirection:(DKDirection)direction;
 - (NSArray*)sortArrayUsingNearestNeighbour:(NSArray*)points;
 - (CGFloat)pathLengthOfArray:(NSArray*)points;
 - (NSUInteger)indexOfTopLeftPointInArray:(NSArray*)points;
 - (void)performSortIfNeeded;
+- (void)annealConcurrently;
+- (void)checkpointRouteAtStep:(NSInteger)step;
+- (void)publishCheckpoint;
 
 @end
 
@@ -50,6 +74,16 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 	return tsp;
 }
 
++ (DKRouteFinder*)routeFinderWithPoints:(const NSPoint*)points count:(NSUInteger)count
+{
+	NSAssert(points != NULL, @"cannot operate on a NULL point buffer");
+
+	DKRouteFinder* tsp = [[self alloc] initWithPoints:points
+												count:count];
+
+	return tsp;
+}
+
 + (DKRouteFinder*)routeFinderWithObjects:(NSArray*)objects withValueForKey:(NSString*)key
 {
 	// given a list of arbitrary objects, this builds an array of point values by querying each object using valueForKey:key. The key should
@@ -75,7 +109,23 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 
 - (NSArray*)shortestRoute
 {
-	// returns the original points reordered into the shortest route
+	// returns the original points reordered into the shortest route. An instance initialised from
+	// a raw point buffer has no boxed input to reorder, so the result is boxed here on demand.
+
+	if (mInput == nil) {
+		NSPoint* route = malloc(sizeof(NSPoint) * mInputCount);
+		[self getShortestRoutePoints:route];
+
+		NSMutableArray* result = [NSMutableArray arrayWithCapacity:mInputCount];
+		NSUInteger k;
+
+		for (k = 0; k < mInputCount; ++k)
+			[result addObject:[NSValue valueWithPoint:route[k]]];
+
+		free(route);
+		return [result copy];
+	}
+
 	return [self sortedArrayFromArray:mInput];
 }
 
@@ -90,7 +140,7 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 	NSUInteger k;
 	NSNumber* num;
 
-	for (k = 1; k <= [mInput count]; ++k) {
+	for (k = 1; k <= mInputCount; ++k) {
 		num = @(mOrder[k] - 1);
 		[routeOrder addObject:num];
 	}
@@ -98,6 +148,56 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 	return [routeOrder copy];
 }
 
+- (NSUInteger)pointCount
+{
+	return mInputCount;
+}
+
+- (void)getShortestRoutePoints:(NSPoint*)buffer
+{
+	NSAssert(buffer != NULL, @"cannot copy the route to a NULL buffer");
+
+	[self performSortIfNeeded];
+
+	// rotate the order so that the route starts at the original first point, exactly as
+	// -sortedArrayFromArray: does for the boxed result
+
+	NSUInteger k, n, m;
+
+	n = mInputCount;
+	k = 0;
+	m = 1;
+
+	while (k < n && mOrder[++k] != 1) {
+		++m;
+	}
+
+	for (k = 0; k < n; ++k) {
+		NSInteger indx = mOrder[1 + ((k + m - 1) % n)];
+
+		if (mX != NULL && mY != NULL)
+			buffer[k] = NSMakePoint(mX[indx], mY[indx]);
+		else {
+			// a nearest-neighbour instance made from a boxed array never allocates the
+			// coordinate arrays, so unbox through the computed order instead
+
+			buffer[k] = [[mInput objectAtIndex:(NSUInteger)(indx - 1)] pointValue];
+		}
+	}
+}
+
+- (void)getShortestRouteOrder:(NSInteger*)buffer
+{
+	NSAssert(buffer != NULL, @"cannot copy the route order to a NULL buffer");
+
+	[self performSortIfNeeded];
+
+	NSUInteger k;
+
+	for (k = 1; k <= mInputCount; ++k)
+		buffer[k - 1] = mOrder[k] - 1;
+}
+
 - (NSArray*)sortedArrayFromArray:(NSArray*)anArray
 {
 	// sorts <anArray> according to the sort order calculated and returns the sorted copy
@@ -106,7 +206,7 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 
 	NSMutableArray* result = nil;
 
-	if ([anArray count] == [mInput count]) {
+	if ([anArray count] == mInputCount) {
 		result = [NSMutableArray array];
 
 		// perform the calculation if not already done
@@ -115,7 +215,7 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 		NSUInteger k, n, m;
 		id object;
 
-		n = [mInput count];
+		n = mInputCount;
 		k = 0;
 		m = 1;
 
@@ -148,6 +248,69 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 
 @synthesize algorithm = mAlgorithm;
 
+@synthesize cancelled = mCancelled;
+
+- (void)cancel
+{
+	mCancelled = YES;
+}
+
+- (NSArray*)currentBestRouteOrder
+{
+	@synchronized(self) {
+		return mCheckpoint;
+	}
+}
+
+- (void)findRouteAsynchronouslyWithCompletionHandler:(void (^)(NSArray<NSNumber*>*, CGFloat))completionHandler
+{
+	NSAssert(completionHandler != nil, @"completion handler cannot be nil");
+
+	mCancelled = NO;
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		[self performSortIfNeeded];
+
+		NSArray<NSNumber*>* routeOrder = [self shortestRouteOrder];
+		CGFloat length = [self pathLength];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completionHandler(routeOrder, length);
+		});
+	});
+}
+
+- (void)refineAsynchronouslyWithAdditionalSteps:(NSInteger)steps completionHandler:(void (^)(NSArray<NSNumber*>*, CGFloat))completionHandler
+{
+	NSAssert(completionHandler != nil, @"completion handler cannot be nil");
+
+	mCancelled = NO;
+
+	dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+		// refinement is only meaningful for the annealing algorithm, and needs the coordinate arrays
+
+		if ((mAlgorithm & kDKUseSimulatedAnnealing) != 0 && mX != NULL && steps > 0) {
+			// make sure an initial route exists, then re-anneal starting from it. Because the current
+			// order seeds the run, improvement accumulates across calls.
+
+			[self performSortIfNeeded];
+
+			mLastCheckpointStep = 0;
+			anneal(mX, mY, mOrder, mInputCount, steps, progressCallback, (__bridge const void*)self);
+			mPathLength = [self pathLengthOfArray:[self shortestRoute]];
+			[self publishCheckpoint];
+		} else
+			[self performSortIfNeeded];
+
+		NSArray<NSNumber*>* routeOrder = [self shortestRouteOrder];
+		CGFloat length = [self pathLength];
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			completionHandler(routeOrder, length);
+		});
+	});
+}
+
 @synthesize progressDelegate = mProgressDelegate;
 #if 0
 - (void)setProgressDelegate:(id)aDelegate
@@ -185,6 +348,7 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 
 		mCalculationDone = NO;
 		mInput = array;
+		mInputCount = [array count];
 		mAnnealingSteps = kDKDefaultAnnealingSteps;
 
 		// prepare for the computation by allocating C arrays and populating them from the input.
@@ -226,6 +390,59 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 	return self;
 }
 
+- (instancetype)initWithPoints:(const NSPoint*)points count:(NSUInteger)count
+{
+	self = [super init];
+	if (self != nil) {
+		NSAssert(points != NULL, @"cannot initialise with a NULL point buffer");
+
+		mAlgorithm = s_Algorithm;
+		mDirection = kDirectionEast;
+
+		// same minimum as -initWithArray: - anneal requires at least four points
+
+		if (count < 4) {
+			return nil;
+		}
+
+		mCalculationDone = NO;
+		mInputCount = count;
+		mAnnealingSteps = kDKDefaultAnnealingSteps;
+
+		// as for -initWithArray:, the C arrays are 1-based. The coordinate arrays are filled
+		// whichever algorithm is in force - they are the unboxed record of the input, and the
+		// nearest-neighbour path boxes from them lazily if and when it runs.
+
+		NSUInteger n = count + 1, k;
+
+		mOrder = malloc(sizeof(NSInteger) * n);
+		mX = malloc(sizeof(CGFloat) * n);
+		mY = malloc(sizeof(CGFloat) * n);
+		mOrder[0] = 1;
+
+		for (k = 1; k <= count; ++k) {
+			mX[k] = points[k - 1].x;
+			mY[k] = points[k - 1].y;
+			mOrder[k] = (NSInteger)k;
+		}
+	}
+
+	return self;
+}
+
+- (NSArray<NSValue*>*)boxedInputPoints
+{
+	// boxes the coordinate arrays back into the NSValue form the nearest-neighbour walk operates on
+
+	NSMutableArray<NSValue*>* pts = [NSMutableArray arrayWithCapacity:mInputCount];
+	NSUInteger k;
+
+	for (k = 1; k <= mInputCount; ++k)
+		[pts addObject:[NSValue valueWithPoint:NSMakePoint(mX[k], mY[k])]];
+
+	return [pts copy];
+}
+
 - (void)dealloc
 {
 	if (mX)
@@ -400,27 +617,314 @@ static DKRouteAlgorithmType s_Algorithm = kDKUseNearestNeighbour; //kDKUseSimula
 {
 	if (!mCalculationDone) {
 		mCalculationDone = YES;
+		mLastCheckpointStep = 0;
 
 		if ((mAlgorithm & kDKUseSimulatedAnnealing) != 0) {
-			anneal(mX, mY, mOrder, [mInput count], mAnnealingSteps, (__bridge const void*)(self));
+			// large inputs are clustered and annealed on worker threads - annealing the whole set in one
+			// go scales badly past a few thousand points.
+
+			if (mInputCount >= kDKConcurrentAnnealingThreshold)
+				[self annealConcurrently];
+			else
+				anneal(mX, mY, mOrder, mInputCount, mAnnealingSteps, progressCallback, (__bridge const void*)(self));
+
 			mPathLength = [self pathLengthOfArray:[self shortestRoute]];
 		}
 
 		if ((mAlgorithm & kDKUseNearestNeighbour) != 0) {
+			// an instance initialised from a raw buffer has no boxed input; the NN walk needs one,
+			// so it is boxed here, once, on first use
+
+			if (mInput == nil)
+				mInput = [self boxedInputPoints];
+
 			[self sortArrayUsingNearestNeighbour:mInput];
 			mPathLength = [self pathLengthOfArray:mVisited];
 		}
+
+		// the finished route is the final checkpoint
+
+		[self publishCheckpoint];
+	}
+}
+
+- (void)checkpointRouteAtStep:(NSInteger)step
+{
+	// called from the serial annealing progress funnel. A snapshot per temperature step is cheap (the
+	// outer loop runs kDKDefaultAnnealingSteps times in total) while the fractional inner-loop progress
+	// reports, which arrive far too often to snapshot, are filtered out here.
+
+	if (step > mLastCheckpointStep) {
+		mLastCheckpointStep = step;
+		[self publishCheckpoint];
+	}
+}
+
+- (void)publishCheckpoint
+{
+	// copies the current order into an immutable snapshot that -currentBestRouteOrder can hand out from
+	// any thread. Only ever called from the thread that is mutating mOrder, so the read here is safe;
+	// the @synchronized exchange protects concurrent readers of the snapshot itself.
+
+	NSUInteger n = mInputCount;
+	NSMutableArray<NSNumber*>* snapshot = [NSMutableArray arrayWithCapacity:n];
+	NSUInteger k;
+
+	for (k = 1; k <= n; ++k)
+		[snapshot addObject:@(mOrder[k] - 1)];
+
+	@synchronized(self) {
+		mCheckpoint = [snapshot copy];
 	}
 }
 
+- (void)annealConcurrently
+{
+	// divide-and-conquer version of the annealing sort for large inputs. The points are partitioned
+	// spatially (recursive k-d median split) into clusters of roughly kDKAnnealingClusterSize points,
+	// each cluster is annealed independently on a worker thread, then the per-cluster routes are
+	// concatenated in partition order and the seams between them cleaned up with a local 2-opt pass.
+	// The result lands in mOrder exactly as the serial anneal would leave it.
+
+	NSInteger ncity = mInputCount;
+	NSInteger k;
+
+	// master index list, holding 1-based city numbers. The partition reorders this in place so that
+	// each cluster occupies a contiguous range; in-order recursion leaves adjacent ranges spatially
+	// adjacent, which is what makes simple concatenation a reasonable starting route.
+
+	NSInteger* indices = malloc(sizeof(NSInteger) * ncity);
+
+	for (k = 0; k < ncity; ++k)
+		indices[k] = k + 1;
+
+	NSMutableArray<NSValue*>* clusterRanges = [NSMutableArray array];
+	partitionClusterRange(indices, NSMakeRange(0, ncity), mX, mY, clusterRanges);
+
+	NSInteger clusterCount = [clusterRanges count];
+	NSInteger** clusterOrders = calloc(clusterCount, sizeof(NSInteger*));
+	CGFloat* progressTable = calloc(clusterCount, sizeof(CGFloat));
+	CGFloat lastNotified = 0.0;
+	CGFloat* lastNotifiedPtr = &lastNotified;
+
+	[self notifyProgress:0.0];
+
+	dispatch_apply(clusterCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t c) {
+		NSRange range = [[clusterRanges objectAtIndex:c] rangeValue];
+		NSInteger m = range.length;
+		NSInteger j;
+
+		// local 1-based coordinate and order arrays for this cluster, as anneal() expects
+
+		CGFloat* cx = malloc(sizeof(CGFloat) * (m + 1));
+		CGFloat* cy = malloc(sizeof(CGFloat) * (m + 1));
+		NSInteger* corder = malloc(sizeof(NSInteger) * (m + 1));
+
+		for (j = 1; j <= m; ++j) {
+			NSInteger city = indices[range.location + j - 1];
+			cx[j] = mX[city];
+			cy[j] = mY[city];
+			corder[j] = j;
+		}
+
+		if (m >= 4) {
+			DKClusterProgressContext cpc = { (__bridge const void*)self, progressTable, lastNotifiedPtr, (NSInteger)c, clusterCount };
+			anneal(cx, cy, corder, m, mAnnealingSteps, clusterProgressCallback, &cpc);
+		}
+
+		progressTable[c] = 1.0;
+		clusterOrders[c] = corder;
+		free(cx);
+		free(cy);
+	});
+
+	// stitch: append each cluster's cycle to mOrder, rotating it to start at the point nearest
+	// the end of the route so far. The first cluster is anchored near the original start point.
+
+	NSInteger pos = 1;
+	CGFloat ex = mX[1], ey = mY[1];
+	NSInteger* seams = malloc(sizeof(NSInteger) * clusterCount);
+	NSInteger seamCount = 0;
+	NSInteger c;
+
+	for (c = 0; c < clusterCount; ++c) {
+		NSRange range = [[clusterRanges objectAtIndex:c] rangeValue];
+		NSInteger m = range.length;
+		NSInteger* corder = clusterOrders[c];
+		NSInteger j, s = 1;
+		CGFloat dist, shortest = HUGE_VAL;
+
+		for (j = 1; j <= m; ++j) {
+			NSInteger city = indices[range.location + corder[j] - 1];
+			dist = hypot(mX[city] - ex, mY[city] - ey);
+
+			if (dist < shortest) {
+				shortest = dist;
+				s = j;
+			}
+		}
+
+		for (j = 0; j < m; ++j)
+			mOrder[pos + j] = indices[range.location + corder[1 + ((s - 1 + j) % m)] - 1];
+
+		pos += m;
+		ex = mX[mOrder[pos - 1]];
+		ey = mY[mOrder[pos - 1]];
+
+		if (c > 0)
+			seams[seamCount++] = pos - m; // index of the first point of this cluster in mOrder
+
+		free(corder);
+	}
+
+	// clean up the joins - a windowed 2-opt around each seam removes the crossings that
+	// concatenation typically introduces
+
+	for (c = 0; c < seamCount; ++c)
+		twoOptImproveAroundSeam(mX, mY, mOrder, ncity, seams[c], 16);
+
+	free(seams);
+	free(clusterOrders);
+	free(progressTable);
+	free(indices);
+
+	[self notifyProgress:1.0];
+}
+
 @end
 
-void progressCallback(CGFloat iteration, CGFloat maxIterations, const void* context)
+BOOL progressCallback(CGFloat iteration, CGFloat maxIterations, const void* context)
 {
 	DKRouteFinder* rf = (__bridge DKRouteFinder*)context;
 
-	if (rf != nil)
+	if (rf != nil) {
 		[rf notifyProgress:iteration / maxIterations];
+		[rf checkpointRouteAtStep:(NSInteger)iteration];
+
+		return ![rf isCancelled];
+	}
+
+	return YES;
+}
+
+BOOL clusterProgressCallback(CGFloat iteration, CGFloat maxIterations, const void* context)
+{
+	// progress funnel for the concurrent annealing path. Each worker records its own cluster's
+	// fraction, then the overall mean is forwarded to the delegate - serialised, and only when it
+	// has advanced noticeably, since the callback rate across all workers is very high.
+
+	const DKClusterProgressContext* cpc = (const DKClusterProgressContext*)context;
+
+	cpc->clusterProgress[cpc->clusterIndex] = iteration / maxIterations;
+
+	DKRouteFinder* rf = (__bridge DKRouteFinder*)cpc->routeFinder;
+
+	if (rf != nil) {
+		@synchronized(rf) {
+			CGFloat sum = 0.0;
+			NSInteger k;
+
+			for (k = 0; k < cpc->clusterCount; ++k)
+				sum += cpc->clusterProgress[k];
+
+			CGFloat overall = sum / (CGFloat)cpc->clusterCount;
+
+			if (overall - *cpc->lastNotified >= 0.01) {
+				*cpc->lastNotified = overall;
+				[rf notifyProgress:overall];
+			}
+		}
+
+		// a cancelled cluster simply stops annealing; its order is still a valid route, so the
+		// stitching pass afterwards proceeds as normal
+
+		return ![rf isCancelled];
+	}
+
+	return YES;
+}
+
+static void partitionClusterRange(NSInteger indices[], NSRange range, const CGFloat x[], const CGFloat y[], NSMutableArray<NSValue*>* outRanges)
+{
+	// recursively splits <range> of the master index list at the spatial median of its wider axis,
+	// reordering the indices in place, until the pieces are no larger than kDKAnnealingClusterSize.
+	// the in-order recursion means consecutive output ranges are spatial neighbours.
+
+	if (range.length <= kDKAnnealingClusterSize) {
+		[outRanges addObject:[NSValue valueWithRange:range]];
+		return;
+	}
+
+	CGFloat minX = HUGE_VAL, maxX = -HUGE_VAL, minY = HUGE_VAL, maxY = -HUGE_VAL;
+	NSUInteger k;
+
+	for (k = range.location; k < NSMaxRange(range); ++k) {
+		CGFloat px = x[indices[k]], py = y[indices[k]];
+
+		minX = MIN(minX, px);
+		maxX = MAX(maxX, px);
+		minY = MIN(minY, py);
+		maxY = MAX(maxY, py);
+	}
+
+	const BOOL splitX = (maxX - minX) >= (maxY - minY);
+
+	qsort_b(indices + range.location, range.length, sizeof(NSInteger), ^int(const void* a, const void* b) {
+		CGFloat va = splitX ? x[*(const NSInteger*)a] : y[*(const NSInteger*)a];
+		CGFloat vb = splitX ? x[*(const NSInteger*)b] : y[*(const NSInteger*)b];
+
+		return (va < vb) ? -1 : ((va > vb) ? 1 : 0);
+	});
+
+	NSUInteger half = range.length / 2;
+
+	partitionClusterRange(indices, NSMakeRange(range.location, half), x, y, outRanges);
+	partitionClusterRange(indices, NSMakeRange(range.location + half, range.length - half), x, y, outRanges);
+}
+
+static void twoOptImproveAroundSeam(const CGFloat x[], const CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger seam, NSInteger window)
+{
+	// classic 2-opt restricted to a window either side of the join at <seam> (the 1-based position in
+	// iorder of the first point of a stitched-on cluster). Where swapping a pair of edges for the pair
+	// that "uncrosses" them shortens the route, the intervening segment is reversed. Repeats until no
+	// improvement or a small pass limit is hit.
+
+	NSInteger lo = MAX(1, seam - window);
+	NSInteger hi = MIN(ncity - 1, seam + window);
+	NSInteger pass = 0;
+	BOOL improved;
+
+	do {
+		improved = NO;
+
+		NSInteger i, j;
+
+		for (i = lo; i < hi; ++i) {
+			for (j = i + 1; j < hi; ++j) {
+				NSInteger a = iorder[i], b = iorder[i + 1];
+				NSInteger c = iorder[j], d = iorder[j + 1];
+
+				CGFloat before = hypot(x[b] - x[a], y[b] - y[a]) + hypot(x[d] - x[c], y[d] - y[c]);
+				CGFloat after = hypot(x[c] - x[a], y[c] - y[a]) + hypot(x[d] - x[b], y[d] - y[b]);
+
+				if (after < before) {
+					// reverse the segment between the two edges
+
+					NSInteger p = i + 1, q = j;
+
+					while (p < q) {
+						NSInteger tmp = iorder[p];
+						iorder[p] = iorder[q];
+						iorder[q] = tmp;
+						++p;
+						--q;
+					}
+
+					improved = YES;
+				}
+			}
+		}
+	} while (improved && ++pass < 4);
 }
 
 static DKDirection directionOfAngle(const CGFloat angle)
@@ -443,12 +947,23 @@ static DKDirection directionOfAngle(const CGFloat angle)
 #pragma mark -
 #pragma mark - from Numerical Recipes in C(2nd ed.Ch 10. p448)
 
+// all of the mutable state of the annealing loop and its random generator, formerly file statics.
+// each call to anneal() owns one of these on its own stack, so concurrent anneals (one per cluster
+// on the concurrent path) cannot interfere with one another.
+
+typedef struct {
+	long idum; // seed/state flag for ran3
+	NSInteger inext, inextp; // ran3 table cursors
+	long ma[56]; // ran3 state table
+	NSInteger iff; // ran3 initialisation flag
+	unsigned long iseed; // irbit1 shift register
+} DKAnnealState;
+
 static NSInteger* ivector(long nl, long nh);
 static void free_ivector(NSInteger* v, long nl, long nh);
-static CGFloat ran3(long* idum);
+static CGFloat ran3(DKAnnealState* state);
 static NSInteger irbit1(unsigned long* iseed);
-static NSInteger metrop(CGFloat de, CGFloat t);
-static CGFloat ran3(long* idum);
+static NSInteger metrop(CGFloat de, CGFloat t, DKAnnealState* state);
 static CGFloat revcst(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger n[]);
 static void reverse(NSInteger iorder[], NSInteger ncity, NSInteger n[]);
 static CGFloat trncst(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger n[]);
@@ -487,16 +1002,15 @@ void free_ivector(NSInteger* v, long nl, long nh)
 #define MZ 0
 #define FAC (1.0 / MBIG)
 
-CGFloat ran3(long* idum)
+CGFloat ran3(DKAnnealState* state)
 {
-	static NSInteger inext, inextp;
-	static long ma[56];
-	static NSInteger iff = 0;
+	long* idum = &state->idum;
+	long* ma = state->ma;
 	long mj, mk;
 	NSInteger i, ii, k;
 
-	if (*idum < 0 || iff == 0) {
-		iff = 1;
+	if (*idum < 0 || state->iff == 0) {
+		state->iff = 1;
 		mj = MSEED - (*idum < 0 ? -*idum : *idum);
 		mj %= MBIG;
 		ma[55] = mj;
@@ -518,23 +1032,23 @@ CGFloat ran3(long* idum)
 					ma[i] += MBIG;
 			}
 		}
-		inext = 0;
-		inextp = 31;
+		state->inext = 0;
+		state->inextp = 31;
 		*idum = 1;
 	}
 
-	if (++inext == 56)
-		inext = 1;
+	if (++state->inext == 56)
+		state->inext = 1;
 
-	if (++inextp == 56)
-		inextp = 1;
+	if (++state->inextp == 56)
+		state->inextp = 1;
 
-	mj = ma[inext] - ma[inextp];
+	mj = ma[state->inext] - ma[state->inextp];
 
 	if (mj < MZ)
 		mj += MBIG;
 
-	ma[inext] = mj;
+	ma[state->inext] = mj;
 
 	return mj * FAC;
 }
@@ -570,22 +1084,24 @@ function result is the final path length
 #define TFACTR 0.9 // Annealing schedule: reduce t by this factor on each step.
 #define ALEN(a, b, c, d) sqrt(((b) - (a)) * ((b) - (a)) + ((d) - (c)) * ((d) - (c)))
 
-CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, const void* context)
+CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NSInteger annealingSteps, DKAnnealProgressFunction progress, const void* context)
 {
 	NSInteger ans, nover, nlimit, i1, i2;
 	NSInteger i, j, k, nsucc, nn, idec;
 
-	static NSInteger n[7];
-	static long idum = -1;
-	static unsigned long iseed = 111;
+	NSInteger n[7];
+	DKAnnealState state = { 0 };
 	CGFloat path, de, t, previousPath;
 
+	state.idum = -1;
+	state.iseed = 111;
+
 	nover = 100 * ncity; // Maximum number of paths tried at any temperature.
 	nlimit = 20 * ncity; // Maximum number of successful path changes before continuing.
 	path = 0.0;
 	t = 0.5;
 
-	progressCallback(0, annealingSteps, context);
+	progress(0, annealingSteps, context);
 
 	for (i = 1; i < ncity; ++i) {
 		// Calculate initial path length.
@@ -597,13 +1113,12 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 	i1 = iorder[ncity]; // Close the loop by tying path ends together.
 	i2 = iorder[1];
 	path += ALEN(x[i1], x[i2], y[i1], y[i2]);
-	//idum = -1;
-	//iseed = 111;
 
 	previousPath = path;
 
 	for (j = 1; j <= annealingSteps; ++j) {
-		progressCallback(j, annealingSteps, context);
+		if (!progress(j, annealingSteps, context))
+			return path; // cooperative cancellation - iorder holds the best route found so far
 
 		// Try up to <annealingSteps> temperature steps.
 
@@ -615,29 +1130,30 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 				previousPath = path;
 				CGFloat kprog = (CGFloat)k / (CGFloat)nover;
 
-				progressCallback((CGFloat)j + kprog, (CGFloat)annealingSteps, context); // for testing only - remove for production it slows this down too much
+				if (!progress((CGFloat)j + kprog, (CGFloat)annealingSteps, context)) // for testing only - remove for production it slows this down too much
+					return path; // cooperative cancellation, as above
 			}
 
 			do {
-				n[1] = 1 + (NSInteger)(ncity * ran3(&idum)); // Choose beginning of segment..
-				n[2] = 1 + (NSInteger)((ncity - 1) * ran3(&idum)); // ..and end of segment.
+				n[1] = 1 + (NSInteger)(ncity * ran3(&state)); // Choose beginning of segment..
+				n[2] = 1 + (NSInteger)((ncity - 1) * ran3(&state)); // ..and end of segment.
 				if (n[2] >= n[1])
 					++n[2];
 
 				nn = 1 + ((n[1] - n[2] + ncity - 1) % ncity); // nn is the number of cities not on the segment.
 			} while (nn < 3);
 
-			idec = irbit1(&iseed);
+			idec = irbit1(&state.iseed);
 
 			// Decide whether to do a segment reversal or transport.
 			if (idec == 0) {
 				// Do a transport.
-				n[3] = n[2] + (NSInteger)(labs(nn - 2) * ran3(&idum)) + 1;
+				n[3] = n[2] + (NSInteger)(labs(nn - 2) * ran3(&state)) + 1;
 				n[3] = 1 + ((n[3] - 1) % ncity);
 
 				// Transport to a location not on the path.
 				de = trncst(x, y, iorder, ncity, n); // Calculate cost.
-				ans = metrop(de, t); // Consult the oracle.
+				ans = metrop(de, t, &state); // Consult the oracle.
 				if (ans) {
 					++nsucc;
 					path += de;
@@ -646,7 +1162,7 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 			} else {
 				// Do a path reversal.
 				de = revcst(x, y, iorder, ncity, n); // Calculate cost.
-				ans = metrop(de, t); // Consult the oracle.
+				ans = metrop(de, t, &state); // Consult the oracle.
 
 				if (ans) {
 					++nsucc;
@@ -663,7 +1179,7 @@ CGFloat anneal(CGFloat x[], CGFloat y[], NSInteger iorder[], NSInteger ncity, NS
 
 		t *= TFACTR; // Annealing schedule.
 		if (nsucc == 0) {
-			progressCallback(annealingSteps, annealingSteps, context);
+			progress(annealingSteps, annealingSteps, context);
 			return path; // If no success, we are done.
 		}
 	}
@@ -811,9 +1327,7 @@ metrop = 1(true), while if de > 0, metrop is only true with probability exp(-de/
 t is a temperature determined by the annealing schedule.
 */
 
-NSInteger metrop(CGFloat de, CGFloat t)
+NSInteger metrop(CGFloat de, CGFloat t, DKAnnealState* state)
 {
-	static long gljdum = 1;
-
-	return de < 0.0 || ran3(&gljdum) < exp(-de / t);
+	return de < 0.0 || ran3(state) < exp(-de / t);
 }
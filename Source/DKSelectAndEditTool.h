@@ -10,7 +10,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawingView, DKStyle, DKObjectDrawingLayer;
+@class DKDrawingView, DKStyle, DKObjectDrawingLayer, DKObjectPool, DKDrawableObject;
 
 //! modes of operation determined by what was hit and what is in the selection
 typedef NS_ENUM(NSInteger, DKEditToolOperation) {
@@ -63,6 +63,12 @@ typedef NS_ENUM(NSInteger, DKEditToolDragPhase) {
 	NSRect mProxyDragDestRect; // where it is drawn
 	NSArray* mDraggedObjects; // cache of objects being dragged
 	BOOL mWasInLockedObject; // YES if initial mouse down was in a locked object
+	DKObjectPool* mScratchPathPool; // the delegate's recycling pool for marquee paths, if it maintains one
+	DKDrawableObject* mPendingPreciseObject; // object awaiting the deferred precise drag phase
+	NSPoint mPendingPrecisePoint; // latest drag point for the deferred precise phase
+	NSInteger mPendingPrecisePartcode; // partcode for the deferred precise phase
+	NSEvent* mPendingPreciseEvent; // event for the deferred precise phase
+	BOOL mPreciseDragScheduled; // YES while a precise drag phase is queued for the frame boundary
 }
 
 /** @brief Returns the default style to use for drawing the selection marquee
@@ -10,6 +10,7 @@
 #import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
 #import "DKObjectDrawingLayer.h"
+#import "DKObjectPool.h"
 #import "DKStyle.h"
 #import "DKToolController.h"
 #import "DKUndoManager.h"
@@ -29,6 +30,7 @@
 @property (readwrite, copy) NSArray* draggedObjects;
 - (void)proxyDragObjectsAsGroup:(NSArray*)objects inLayer:(DKObjectDrawingLayer*)layer toPoint:(NSPoint)p event:(NSEvent*)event dragPhase:(DKEditToolDragPhase)ph;
 - (BOOL)finishUsingToolInLayer:(DKObjectDrawingLayer*)odl delegate:(id)aDel event:(NSEvent*)event;
+- (void)setFeedbackNeedsDisplayInRect:(NSRect)rect inLayer:(DKLayer*)aLayer;
 
 @end
 
@@ -123,13 +125,32 @@ NSString* const kDKSelectionToolTargetObject = @"kDKSelectionToolTargetObject";
 		// the extra padding here is OK for the default style - if you use something with a
 		// bigger stroke this may need changing
 
-		[aLayer setNeedsDisplayInRects:updateRegion
-					  withExtraPadding:NSMakeSize(2.5, 2.5)];
+		for (NSValue* rval in updateRegion)
+			[self setFeedbackNeedsDisplayInRect:NSInsetRect([rval rectValue], -2.5, -2.5)
+										inLayer:aLayer];
 
 		mMarqueeRect = marqueeRect;
 	}
 }
 
+/** @brief Invalidate an area of transient tool feedback
+
+ Where the event's view supports the tool overlay plane, only the overlay is marked for update,
+ so the document content beneath is never re-rendered just because the feedback moved. Otherwise
+ this falls back to the classic route of invalidating the layer.
+ @param rect the area to mark for update (already padded as required)
+ @param aLayer the current layer, used for the fallback route
+ */
+- (void)setFeedbackNeedsDisplayInRect:(NSRect)rect inLayer:(DKLayer*)aLayer
+{
+	NSView* v = [aLayer currentView];
+
+	if ([v isKindOfClass:[DKDrawingView class]])
+		[(DKDrawingView*)v setToolOverlayNeedsDisplayInRect:rect];
+	else
+		[aLayer setNeedsDisplayInRect:rect];
+}
+
 #if 0
 /** @brief Set the drawing style for the marquee (selection rect)
 
@@ -604,7 +625,8 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 			mProxyDragDestRect.origin.x = p.x - offset.width;
 			mProxyDragDestRect.origin.y = p.y - offset.height;
 
-			[layer setNeedsDisplayInRect:mProxyDragDestRect];
+			[self setFeedbackNeedsDisplayInRect:mProxyDragDestRect
+										inLayer:layer];
 
 			// need to hide the real objects being dragged. Since we cache the dragged list
 			// locally we can do this without getting bad results from [layer selectedAvailableObjects]
@@ -622,19 +644,22 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 	} break;
 
 	case kDKDragMouseDragged: {
-		[layer setNeedsDisplayInRect:mProxyDragDestRect];
+		[self setFeedbackNeedsDisplayInRect:mProxyDragDestRect
+									inLayer:layer];
 
 		mProxyDragDestRect.size = [mProxyDragImage size];
 		mProxyDragDestRect.origin.x = p.x - offset.width;
 		mProxyDragDestRect.origin.y = p.y - offset.height;
 
-		[layer setNeedsDisplayInRect:mProxyDragDestRect];
+		[self setFeedbackNeedsDisplayInRect:mProxyDragDestRect
+									inLayer:layer];
 	} break;
 
 	case kDKDragMouseUp: {
 		ARCRELEASE(mProxyDragImage);
 		mProxyDragImage = nil;
-		[layer setNeedsDisplayInRect:mProxyDragDestRect];
+		[self setFeedbackNeedsDisplayInRect:mProxyDragDestRect
+									inLayer:layer];
 
 		// move the objects by the total drag distance
 
@@ -663,6 +688,10 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 
 - (BOOL)finishUsingToolInLayer:(DKObjectDrawingLayer*)odl delegate:(id)aDel event:(NSEvent*)event
 {
+	// settle any precise drag phase still queued so the gesture ends at the snapped position
+
+	[self flushPendingPreciseDrag];
+
 	NSArray* sel = nil;
 	DKDrawableObject* obj;
 	NSDictionary* userInfoDict = [NSDictionary dictionaryWithObjectsAndKeys:odl, kDKSelectionToolTargetLayer, [odl singleSelection], kDKSelectionToolTargetObject, nil];
@@ -677,6 +706,8 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 		[self setMarqueeRect:NSRectFromTwoPoints(mAnchorPoint, mLastPoint)
 					 inLayer:odl];
 
+		[odl endMarqueeSelection];
+
 		if (NSIsEmptyRect([self marqueeRect]) && mWasInLockedObject) {
 			obj = [odl hitTest:mLastPoint];
 			[odl replaceSelectionWithObject:obj];
@@ -795,12 +826,18 @@ static void dragFunction_mouseUp(const void* obj, void* context)
  */
 - (NSInteger)mouseDownAtPoint:(NSPoint)p targetObject:(DKDrawableObject*)obj layer:(DKLayer*)layer event:(NSEvent*)event delegate:(id)aDel
 {
-#pragma unused(aDel)
-
 	// first sanity check the layer kind - if it's not one that handles objects and selection, we can't operate.
 
 	NSAssert(layer != nil, @"can't operate on a nil layer");
 
+	// if the delegate maintains recycling pools, scratch paths for the marquee are acquired from
+	// one rather than allocated per redraw
+
+	if ([aDel respondsToSelector:@selector(recyclingPoolForClass:)])
+		mScratchPathPool = [aDel recyclingPoolForClass:[NSBezierPath class]];
+	else
+		mScratchPathPool = nil;
+
 	mPartcode = kDKDrawingNoPart;
 
 	mPerformedUndoableTask = NO;
@@ -968,7 +1005,10 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 				[self setMarqueeRect:NSRectFromTwoPoints(mAnchorPoint, p)
 							 inLayer:odl];
 
-				sel = [odl objectsInRect:[self marqueeRect]];
+				// during the drag, the hit list is maintained incrementally at bounds level - the precise
+				// path-level query happens once, on mouse up
+
+				sel = [odl objectsInMarqueeRect:[self marqueeRect]];
 
 				if (extended)
 					[odl addObjectsToSelectionFromArray:sel];
@@ -982,11 +1022,34 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 
 				if ([sel count] > 0) {
 					[aDel toolWillPerformUndoableAction:self];
-					[self dragObjectsAsGroup:sel
-									 inLayer:odl
-									 toPoint:p
-									   event:event
-								   dragPhase:kDKDragMouseDragged];
+
+					obj = ([sel count] == 1) ? [sel lastObject] : nil;
+
+					if (obj != nil && [obj mouseSnappingEnabled]) {
+						// split phase: move with snapping suppressed right now - pure arithmetic,
+						// so the object stays glued to the cursor - and resolve the precise snap
+						// at the frame boundary. Multi-object drags only grid-snap the input
+						// point, which is already cheap, so they stay single-phase.
+
+						[obj setMouseSnappingEnabled:NO];
+						[self dragObjectsAsGroup:sel
+										 inLayer:odl
+										 toPoint:p
+										   event:event
+									   dragPhase:kDKDragMouseDragged];
+						[obj setMouseSnappingEnabled:YES];
+
+						[self deferPreciseDragOfObject:obj
+											   toPoint:p
+											  partCode:kDKDrawingEntireObjectPart
+												 event:event];
+					} else {
+						[self dragObjectsAsGroup:sel
+										 inLayer:odl
+										 toPoint:p
+										   event:event
+									   dragPhase:kDKDragMouseDragged];
+					}
 					mPerformedUndoableTask = YES;
 				}
 				break;
@@ -995,9 +1058,25 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 				obj = [odl singleSelection];
 				if (obj != nil) {
 					[aDel toolWillPerformUndoableAction:self];
-					[obj mouseDraggedAtPoint:p
-									  inPart:pc
-									   event:event];
+
+					if ([obj mouseSnappingEnabled]) {
+						// split phase, as for the single-object move above
+
+						[obj setMouseSnappingEnabled:NO];
+						[obj mouseDraggedAtPoint:p
+										  inPart:pc
+										   event:event];
+						[obj setMouseSnappingEnabled:YES];
+
+						[self deferPreciseDragOfObject:obj
+											   toPoint:p
+											  partCode:pc
+												 event:event];
+					} else {
+						[obj mouseDraggedAtPoint:p
+										  inPart:pc
+										   event:event];
+					}
 					mPerformedUndoableTask = YES;
 				}
 				break;
@@ -1009,6 +1088,58 @@ static void dragFunction_mouseUp(const void* obj, void* context)
 	}
 }
 
+#pragma mark -
+#pragma mark - split-phase dragging
+
+/** @brief Queues the precise phase of a drag for the frame boundary.
+
+ The immediate phase has already moved the object with snapping suppressed, so pointer feedback is
+ never waiting on precision work. This records the latest drag point and schedules one precise
+ re-application - snap resolution against grid and guides, exact constraints - on the main queue.
+ Consecutive drag events between frames coalesce to a single precise pass at the newest point.
+ */
+- (void)deferPreciseDragOfObject:(DKDrawableObject*)obj toPoint:(NSPoint)p partCode:(NSInteger)pc event:(NSEvent*)event
+{
+	mPendingPreciseObject = obj;
+	mPendingPrecisePoint = p;
+	mPendingPrecisePartcode = pc;
+	mPendingPreciseEvent = event;
+
+	if (!mPreciseDragScheduled) {
+		mPreciseDragScheduled = YES;
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[self flushPendingPreciseDrag];
+		});
+	}
+}
+
+/** @brief Runs the deferred precise drag phase, if one is pending.
+
+ Re-applies the latest drag point with snapping enabled, settling the object onto its precise
+ position. Called from the scheduled block at the frame boundary, and directly on mouse up so the
+ gesture always finishes precisely. A no-op when nothing is pending.
+ */
+- (void)flushPendingPreciseDrag
+{
+	if (!mPreciseDragScheduled)
+		return;
+
+	mPreciseDragScheduled = NO;
+
+	DKDrawableObject* obj = mPendingPreciseObject;
+	NSEvent* event = mPendingPreciseEvent;
+
+	mPendingPreciseObject = nil;
+	mPendingPreciseEvent = nil;
+
+	if (obj != nil)
+		[obj mouseDraggedAtPoint:mPendingPrecisePoint
+						  inPart:mPendingPrecisePartcode
+						   event:event];
+}
+
+#pragma mark -
+
 /** @brief Handle the mouse up event
 
  The delegate may be called to signal that an undoable task is about to be created at certain times.
@@ -1155,7 +1286,17 @@ static void dragFunction_mouseUp(const void* obj, void* context)
  */
 - (NSBezierPath*)renderingPath
 {
-	return [NSBezierPath bezierPathWithRect:[self marqueeRect]];
+	// the marquee redraws on every drag event, so reuse a pooled path when the delegate provides one
+
+	NSBezierPath* path = [mScratchPathPool acquire];
+
+	if (path)
+		[path removeAllPoints];
+	else
+		path = [NSBezierPath bezierPath];
+
+	[path appendBezierPathWithRect:[self marqueeRect]];
+	return path;
 }
 
 /** @brief Required for the complete protocol
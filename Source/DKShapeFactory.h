@@ -77,8 +77,38 @@ typedef NS_OPTIONS(NSUInteger, DKSpeechBalloonOption) {
 
 + (NSBezierPath*)roundEndedRect:(NSRect)rect;
 
+/** @brief Direct CGPath construction for the hot parameterised shapes.
+
+ These build the same geometry as the NSBezierPath factories above - both share a single set of
+ path emitters - but write straight into a CGPath, so callers that render through Quartz (offscreen
+ caches, layer contents, bulk import pipelines) skip the NSBezierPath intermediate and its
+ conversion cost entirely. Per the \c new prefix ownership rule the caller releases the result.
+ */
++ (CGPathRef)newCGPathWithRoundRectInRect:(NSRect)rect andCornerRadius:(CGFloat)radius CF_RETURNS_RETAINED;
++ (CGPathRef)newCGPathWithRoundEndedRect:(NSRect)rect CF_RETURNS_RETAINED;
++ (CGPathRef)newCGPathWithCross CF_RETURNS_RETAINED;
++ (CGPathRef)newCGPathWithDiagonalCross CF_RETURNS_RETAINED;
+
+/** @brief Returns a copy of \c unitPath transformed to occupy <code>rect</code>.
+
+ CG-side counterpart of paths:inRects:count: - \c unitPath is expected to be bounded by
+ \c rectOfUnitSize as the paths returned by this class are. Bulk callers create one canonical
+ unit path and map it into each target rect with this, never materialising an NSBezierPath.
+ */
++ (CGPathRef)newCGPathWithUnitPath:(CGPathRef)unitPath mappedToRect:(NSRect)rect CF_RETURNS_RETAINED;
+
 + (NSBezierPath*)pathFromGlyph:(NSString*)glyph inFontWithName:(NSString*)fontName;
 
+/** @brief Returns \c count independent copies of <code>unitPath</code>, each transformed to occupy the corresponding rect.
+
+ Bulk-instantiation helper for import pipelines that create very large numbers of primitives.
+ \c unitPath is expected to be bounded by \c rectOfUnitSize as the paths returned by this class
+ are; each result is scaled and translated so that the unit square maps onto <code>rects[i]</code>.
+ Combined with the canonical path caching the per-instance cost is a flat copy and transform of
+ the path's element storage, with no trigonometry or arc flattening.
+ */
++ (NSArray<NSBezierPath*>*)paths:(NSBezierPath*)unitPath inRects:(const NSRect*)rects count:(NSUInteger)count;
+
 - (NSBezierPath*)roundRectInRect:(NSRect)bounds objParam:(id)param;
 - (NSBezierPath*)roundEndedRect:(NSRect)rect objParam:(id)param;
 - (NSBezierPath*)speechBalloonInRect:(NSRect)rect objParam:(id)param;
@@ -7,11 +7,133 @@
 #import "DKShapeFactory.h"
 #import "DKDrawKitMacros.h"
 #import "LogEvent.h"
+#import "NSBezierPath+Geometry.h"
 
 #pragma mark Contants(Non - localized)
 NSString* const kDKSpeechBalloonType = @"kDKSpeechBalloonType";
 NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 
+#pragma mark Static Functions
+
+/** canonical unit paths, one per distinct shape type and parameter set. Building the arc and
+ trig based primitives dominates bulk imports that instantiate them by the million, so the
+ canonical path is constructed once on first request and later requests get a flat copy of its
+ element storage, which is far cheaper. NSCache keeps the table bounded and thread-safe.
+ */
+static NSBezierPath* DKShapeFactoryCachedPath(NSString* key, NSBezierPath* (^creator)(void))
+{
+	static NSCache* sCanonicalPaths = nil;
+	static dispatch_once_t onceToken;
+
+	dispatch_once(&onceToken, ^{
+		sCanonicalPaths = [[NSCache alloc] init];
+		[sCanonicalPaths setCountLimit:256];
+	});
+
+	NSBezierPath* canonical = [sCanonicalPaths objectForKey:key];
+
+	if (canonical == nil) {
+		canonical = creator();
+
+		if (canonical == nil)
+			return nil;
+
+		[sCanonicalPaths setObject:canonical
+							forKey:key];
+	}
+
+	return [canonical copy];
+}
+
+/** shared geometry emitters. Each writes one shape straight into <path>, so the CGPath-returning
+ and NSBezierPath-returning factories for a given shape are guaranteed to agree - the NSBezierPath
+ variants convert the emitted path with bezierPathWithCGPath: rather than duplicating the maths.
+ CGPathAddArc with clockwise == false sweeps anticlockwise through increasing angles, matching the
+ appendBezierPathWithArcWithCenter construction these shapes originally used.
+ */
+static void DKShapeFactoryEmitRoundRect(CGMutablePathRef path, NSRect rect, CGFloat radius)
+{
+	// geometry based on Uli Kusterer's NSBezierpathRoundRects class with grateful thanks.
+
+	// Make sure radius doesn't exceed a maximum size
+
+	if (radius >= (rect.size.height / 2))
+		radius = rect.size.height * 0.5;
+
+	if (radius >= (rect.size.width / 2))
+		radius = rect.size.width * 0.5;
+
+	// Make sure silly values simply lead to un-rounded corners:
+
+	if (radius <= 0 || NSIsEmptyRect(rect)) {
+		CGPathAddRect(path, NULL, NSRectToCGRect(rect));
+		return;
+	}
+
+	NSRect innerRect = NSInsetRect(rect, radius, radius); // Make rect with corners being centers of the corner circles.
+
+	CGPathMoveToPoint(path, NULL, rect.origin.x, rect.origin.y + radius);
+
+	// Bottom left (origin):
+	CGPathAddArc(path, NULL, NSMinX(innerRect), NSMinY(innerRect), radius, DEGREES_TO_RADIANS(180.0), DEGREES_TO_RADIANS(270.0), false);
+
+	// Bottom right:
+	CGPathAddArc(path, NULL, NSMaxX(innerRect), NSMinY(innerRect), radius, DEGREES_TO_RADIANS(270.0), DEGREES_TO_RADIANS(360.0), false);
+
+	// Top right:
+	CGPathAddArc(path, NULL, NSMaxX(innerRect), NSMaxY(innerRect), radius, DEGREES_TO_RADIANS(0.0), DEGREES_TO_RADIANS(90.0), false);
+
+	// Top left:
+	CGPathAddArc(path, NULL, NSMinX(innerRect), NSMaxY(innerRect), radius, DEGREES_TO_RADIANS(90.0), DEGREES_TO_RADIANS(180.0), false);
+
+	CGPathCloseSubpath(path); // Implicitly creates left edge.
+}
+
+static void DKShapeFactoryEmitRoundEndedRect(CGMutablePathRef path, NSRect rect)
+{
+	// a rect with rounded ends (half circles). If <rect> is square this emits a circle. The rounded
+	// ends are applied to the shorter sides.
+
+	if (rect.size.width == rect.size.height) {
+		CGPathAddEllipseInRect(path, NULL, NSRectToCGRect(rect));
+		return;
+	}
+
+	NSSize rs = rect.size;
+	BOOL vertical = (rs.width < rs.height);
+	CGFloat radius = MIN(rs.width, rs.height);
+
+	radius /= 2.0;
+
+	if (!vertical) {
+		CGPathMoveToPoint(path, NULL, NSMinX(rect) + radius, NSMinY(rect));
+		CGPathAddArc(path, NULL, NSMaxX(rect) - radius, NSMinY(rect) + radius, radius, DEGREES_TO_RADIANS(270.0), DEGREES_TO_RADIANS(90.0), false);
+		CGPathAddArc(path, NULL, NSMinX(rect) + radius, NSMinY(rect) + radius, radius, DEGREES_TO_RADIANS(90.0), DEGREES_TO_RADIANS(270.0), false);
+	} else {
+		CGPathMoveToPoint(path, NULL, NSMaxX(rect), NSMinY(rect) + radius);
+		CGPathAddArc(path, NULL, NSMinX(rect) + radius, NSMaxY(rect) - radius, radius, DEGREES_TO_RADIANS(0.0), DEGREES_TO_RADIANS(180.0), false);
+		CGPathAddArc(path, NULL, NSMinX(rect) + radius, NSMinY(rect) + radius, radius, DEGREES_TO_RADIANS(180.0), DEGREES_TO_RADIANS(0.0), false);
+	}
+
+	CGPathCloseSubpath(path);
+}
+
+static void DKShapeFactoryEmitCross(CGMutablePathRef path)
+{
+	CGPathMoveToPoint(path, NULL, 0, -0.5);
+	CGPathAddLineToPoint(path, NULL, 0, 0.5);
+	CGPathMoveToPoint(path, NULL, -0.5, 0);
+	CGPathAddLineToPoint(path, NULL, 0.5, 0);
+}
+
+static void DKShapeFactoryEmitDiagonalCross(CGMutablePathRef path)
+{
+	CGPathMoveToPoint(path, NULL, -0.5, -0.5);
+	CGPathAddLineToPoint(path, NULL, 0.5, 0.5);
+	CGPathMoveToPoint(path, NULL, 0.5, -0.5);
+	CGPathAddLineToPoint(path, NULL, -0.5, 0.5);
+}
+
 #pragma mark -
 @implementation DKShapeFactory
 #pragma mark As a DKShapeFactory
@@ -53,58 +175,21 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 
 + (NSBezierPath*)roundRectWithCornerRadius:(CGFloat)radius
 {
-	return [self roundRectInRect:[self rectOfUnitSize]
-				 andCornerRadius:radius];
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"roundRect.%g", radius], ^NSBezierPath* {
+		return [self roundRectInRect:[self rectOfUnitSize]
+					 andCornerRadius:radius];
+	});
 }
 
 + (NSBezierPath*)roundRectInRect:(NSRect)rect andCornerRadius:(CGFloat)radius
 {
-	// return a roundRect with given corner radius. Note: this code based on Uli Kusterer's NSBezierpathRoundRects class with
-	// grateful thanks.
-
-	// Make sure radius doesn't exceed a maximum size
-
-	if (radius >= (rect.size.height / 2))
-		radius = rect.size.height * 0.5;
+	// return a roundRect with given corner radius. The geometry lives in DKShapeFactoryEmitRoundRect
+	// so this and the CGPath variant stay in step.
 
-	if (radius >= (rect.size.width / 2))
-		radius = rect.size.width * 0.5;
-
-	// Make sure silly values simply lead to un-rounded corners:
-
-	if (radius <= 0 || NSIsEmptyRect(rect))
-		return [NSBezierPath bezierPathWithRect:rect];
-
-	// Now draw our rectangle:
-	NSRect innerRect = NSInsetRect(rect, radius, radius); // Make rect with corners being centers of the corner circles.
-	NSBezierPath* path = [NSBezierPath bezierPath];
-
-	[path moveToPoint:NSMakePoint(rect.origin.x, rect.origin.y + radius)];
-
-	// Bottom left (origin):
-	[path appendBezierPathWithArcWithCenter:innerRect.origin
-									 radius:radius
-								 startAngle:180.0
-								   endAngle:270.0];
-
-	// Bottom right:
-	[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMaxX(innerRect), NSMinY(innerRect))
-									 radius:radius
-								 startAngle:270.0
-								   endAngle:360.0];
-
-	// Top right:
-	[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMaxX(innerRect), NSMaxY(innerRect))
-									 radius:radius
-								 startAngle:0.0
-								   endAngle:90.0];
-
-	// Top left:
-	[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMinX(innerRect), NSMaxY(innerRect))
-									 radius:radius
-								 startAngle:90.0
-								   endAngle:180.0];
-	[path closePath]; // Implicitly creates left edge.
+	CGPathRef cp = [self newCGPathWithRoundRectInRect:rect
+									  andCornerRadius:radius];
+	NSBezierPath* path = [NSBezierPath bezierPathWithCGPath:cp];
+	CGPathRelease(cp);
 
 	return path;
 }
@@ -112,33 +197,35 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 #pragma mark -
 + (NSBezierPath*)regularPolygon:(NSInteger)numberOfSides
 {
-	CGFloat angle, radius = 0.5;
-	NSInteger i;
-	NSBezierPath* path = [NSBezierPath bezierPath];
-	NSPoint p;
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"polygon.%ld", (long)numberOfSides], ^NSBezierPath* {
+		CGFloat angle, radius = 0.5;
+		NSInteger i;
+		NSBezierPath* path = [NSBezierPath bezierPath];
+		NSPoint p;
 
-	p.x = 0.5;
-	p.y = 0.0;
+		p.x = 0.5;
+		p.y = 0.0;
 
-	[path moveToPoint:p];
+		[path moveToPoint:p];
 
-	for (i = 0; i < numberOfSides; i++) {
-		angle = ((2 * M_PI * i) / numberOfSides);
+		for (i = 0; i < numberOfSides; i++) {
+			angle = ((2 * M_PI * i) / numberOfSides);
 
-		p.x = radius * cos(angle);
-		p.y = radius * sin(angle);
+			p.x = radius * cos(angle);
+			p.y = radius * sin(angle);
 
-		[path lineToPoint:p];
-	}
+			[path lineToPoint:p];
+		}
 
-	p.x = 0.5;
-	p.y = 0.0;
-	[path lineToPoint:p];
-	[path closePath];
+		p.x = 0.5;
+		p.y = 0.0;
+		[path lineToPoint:p];
+		[path closePath];
 
-	//[path appendBezierPathWithOvalInRect:[DKShapeFactory rectOfUnitSize]];
+		//[path appendBezierPathWithOvalInRect:[DKShapeFactory rectOfUnitSize]];
 
-	return path;
+		return path;
+	});
 }
 
 #pragma mark -
@@ -192,39 +279,41 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 #pragma mark -
 + (NSBezierPath*)star:(NSInteger)numberOfPoints innerDiameter:(CGFloat)diam
 {
-	CGFloat angle, radius = 0.5;
-	NSInteger i;
-	NSBezierPath* path = [NSBezierPath bezierPath];
-	NSPoint p;
-
 	if (diam > 1.0)
 		diam = 1.0;
 
-	p.x = 0.5;
-	p.y = 0.0;
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"star.%ld.%g", (long)numberOfPoints, diam], ^NSBezierPath* {
+		CGFloat angle, radius = 0.5;
+		NSInteger i;
+		NSBezierPath* path = [NSBezierPath bezierPath];
+		NSPoint p;
 
-	[path moveToPoint:p];
+		p.x = 0.5;
+		p.y = 0.0;
 
-	for (i = 0; i < (numberOfPoints * 2); i++) {
-		angle = ((M_PI * i) / numberOfPoints);
+		[path moveToPoint:p];
 
-		if ((i % 2) == 0) {
-			p.x = radius * cos(angle);
-			p.y = radius * sin(angle);
-		} else {
-			p.x = diam * cos(angle) / 2.0;
-			p.y = diam * sin(angle) / 2.0;
+		for (i = 0; i < (numberOfPoints * 2); i++) {
+			angle = ((M_PI * i) / numberOfPoints);
+
+			if ((i % 2) == 0) {
+				p.x = radius * cos(angle);
+				p.y = radius * sin(angle);
+			} else {
+				p.x = diam * cos(angle) / 2.0;
+				p.y = diam * sin(angle) / 2.0;
+			}
+
+			[path lineToPoint:p];
 		}
 
+		p.x = 0.5;
+		p.y = 0.0;
 		[path lineToPoint:p];
-	}
-
-	p.x = 0.5;
-	p.y = 0.0;
-	[path lineToPoint:p];
-	[path closePath];
+		[path closePath];
 
-	return path;
+		return path;
+	});
 }
 
 + (NSBezierPath*)regularStar:(NSInteger)numberOfPoints
@@ -239,46 +328,46 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 
 + (NSBezierPath*)cross
 {
-	NSBezierPath* path = [NSBezierPath bezierPath];
-	[path moveToPoint:NSMakePoint(0, -0.5)];
-	[path lineToPoint:NSMakePoint(0, 0.5)];
-	[path moveToPoint:NSMakePoint(-0.5, 0)];
-	[path lineToPoint:NSMakePoint(0.5, 0)];
+	CGPathRef cp = [self newCGPathWithCross];
+	NSBezierPath* path = [NSBezierPath bezierPathWithCGPath:cp];
+	CGPathRelease(cp);
 	return path;
 }
 
 + (NSBezierPath*)diagonalCross
 {
-	NSBezierPath* path = [NSBezierPath bezierPath];
-	[path moveToPoint:NSMakePoint(-0.5, -0.5)];
-	[path lineToPoint:NSMakePoint(0.5, 0.5)];
-	[path moveToPoint:NSMakePoint(0.5, -0.5)];
-	[path lineToPoint:NSMakePoint(-0.5, 0.5)];
+	CGPathRef cp = [self newCGPathWithDiagonalCross];
+	NSBezierPath* path = [NSBezierPath bezierPathWithCGPath:cp];
+	CGPathRelease(cp);
 	return path;
 }
 
 #pragma mark -
 + (NSBezierPath*)ring:(CGFloat)innerDiameter
 {
-	NSBezierPath* path = [NSBezierPath bezierPathWithOvalInRect:[self rectOfUnitSize]];
-
 	if (innerDiameter > 1.0)
 		innerDiameter = 1.0;
 
-	CGFloat rad = innerDiameter * 0.5;
-	NSRect r = NSMakeRect(-rad, -rad, innerDiameter, innerDiameter);
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"ring.%g", innerDiameter], ^NSBezierPath* {
+		NSBezierPath* path = [NSBezierPath bezierPathWithOvalInRect:[self rectOfUnitSize]];
 
-	[path appendBezierPathWithOvalInRect:r];
-	[path setWindingRule:NSEvenOddWindingRule];
+		CGFloat rad = innerDiameter * 0.5;
+		NSRect r = NSMakeRect(-rad, -rad, innerDiameter, innerDiameter);
 
-	return path;
+		[path appendBezierPathWithOvalInRect:r];
+		[path setWindingRule:NSEvenOddWindingRule];
+
+		return path;
+	});
 }
 
 + (NSBezierPath*)roundRectSpeechBalloon:(DKSpeechBalloonOption)sbParams cornerRadius:(CGFloat)cr
 {
-	return [self roundRectSpeechBalloonInRect:[self rectOfUnitSize]
-									   params:sbParams
-								 cornerRadius:cr];
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"balloon.%lu.%g", (unsigned long)sbParams, cr], ^NSBezierPath* {
+		return [self roundRectSpeechBalloonInRect:[self rectOfUnitSize]
+										   params:sbParams
+									 cornerRadius:cr];
+	});
 }
 
 + (NSBezierPath*)roundRectSpeechBalloonInRect:(NSRect)rect params:(DKSpeechBalloonOption)sbParams cornerRadius:(CGFloat)cr
@@ -413,17 +502,17 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 
 + (NSBezierPath*)arrowhead
 {
-	NSBezierPath* sArrowhead = nil;
+	return DKShapeFactoryCachedPath(@"arrowhead", ^NSBezierPath* {
+		NSRect r = [self rectOfUnitSize];
+		NSBezierPath* sArrowhead = [NSBezierPath bezierPath];
 
-	NSRect r = [self rectOfUnitSize];
-	sArrowhead = [NSBezierPath bezierPath];
+		[sArrowhead moveToPoint:NSMakePoint(NSMinX(r), NSMidY(r))];
+		[sArrowhead lineToPoint:NSMakePoint(NSMaxX(r), NSMinY(r))];
+		[sArrowhead lineToPoint:NSMakePoint(NSMaxX(r), NSMaxY(r))];
+		[sArrowhead closePath];
 
-	[sArrowhead moveToPoint:NSMakePoint(NSMinX(r), NSMidY(r))];
-	[sArrowhead lineToPoint:NSMakePoint(NSMaxX(r), NSMinY(r))];
-	[sArrowhead lineToPoint:NSMakePoint(NSMaxX(r), NSMaxY(r))];
-	[sArrowhead closePath];
-
-	return sArrowhead;
+		return sArrowhead;
+	});
 }
 
 + (NSBezierPath*)arrowTailFeather
@@ -435,28 +524,30 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 {
 	// the rakeFactor is how far back the feather is swept - can be a value from 0..1
 
-	rakeFactor = LIMIT(rakeFactor, 0, 1) * 0.5;
+	const CGFloat rake = LIMIT(rakeFactor, 0, 1) * 0.5;
 
-	NSBezierPath* feather = [NSBezierPath bezierPath];
-	NSPoint p = NSMakePoint(-0.5 + rakeFactor, 0);
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"feather.%g", rake], ^NSBezierPath* {
+		NSBezierPath* feather = [NSBezierPath bezierPath];
+		NSPoint p = NSMakePoint(-0.5 + rake, 0);
 
-	[feather moveToPoint:p];
-	p.x = -0.5;
-	p.y = -0.5;
-	[feather lineToPoint:p];
-	p.x = 0.5 - rakeFactor;
-	[feather lineToPoint:p];
-	p.x = 0.5;
-	p.y = 0;
-	[feather lineToPoint:p];
-	p.x = 0.5 - rakeFactor;
-	p.y = 0.5;
-	[feather lineToPoint:p];
-	p.x = -0.5;
-	[feather lineToPoint:p];
-	[feather closePath];
+		[feather moveToPoint:p];
+		p.x = -0.5;
+		p.y = -0.5;
+		[feather lineToPoint:p];
+		p.x = 0.5 - rake;
+		[feather lineToPoint:p];
+		p.x = 0.5;
+		p.y = 0;
+		[feather lineToPoint:p];
+		p.x = 0.5 - rake;
+		p.y = 0.5;
+		[feather lineToPoint:p];
+		p.x = -0.5;
+		[feather lineToPoint:p];
+		[feather closePath];
 
-	return feather;
+		return feather;
+	});
 }
 
 + (NSBezierPath*)inflectedArrowhead
@@ -476,45 +567,55 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 + (NSBezierPath*)roundEndedRect:(NSRect)rect
 {
 	// returns a rect with rounded ends (half circles). If <rect> is square this returns a circle. The rounded ends are applied
-	// to the shorter sides.
+	// to the shorter sides. The geometry lives in DKShapeFactoryEmitRoundEndedRect, shared with the CGPath variant.
 
-	if (rect.size.width == rect.size.height)
-		return [NSBezierPath bezierPathWithOvalInRect:rect];
-	else {
-		NSSize rs = rect.size;
-		BOOL vertical = (rs.width < rs.height);
-		CGFloat radius = MIN(rs.width, rs.height);
+	CGPathRef cp = [self newCGPathWithRoundEndedRect:rect];
+	NSBezierPath* path = [NSBezierPath bezierPathWithCGPath:cp];
+	CGPathRelease(cp);
 
-		radius /= 2.0;
+	return path;
+}
 
-		NSBezierPath* path = [NSBezierPath bezierPath];
+#pragma mark -
++ (CGPathRef)newCGPathWithRoundRectInRect:(NSRect)rect andCornerRadius:(CGFloat)radius
+{
+	CGMutablePathRef path = CGPathCreateMutable();
+	DKShapeFactoryEmitRoundRect(path, rect, radius);
+	return path;
+}
 
-		if (!vertical) {
-			[path moveToPoint:NSMakePoint(NSMinX(rect) + radius, NSMinY(rect))];
-			[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMaxX(rect) - radius, NSMinY(rect) + radius)
-											 radius:radius
-										 startAngle:270.0
-										   endAngle:90.0];
-			[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMinX(rect) + radius, NSMinY(rect) + radius)
-											 radius:radius
-										 startAngle:90.0
-										   endAngle:270.0];
-		} else {
-			[path moveToPoint:NSMakePoint(NSMaxX(rect), NSMinY(rect) + radius)];
-			[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMinX(rect) + radius, NSMaxY(rect) - radius)
-											 radius:radius
-										 startAngle:0.0
-										   endAngle:180.0];
-			[path appendBezierPathWithArcWithCenter:NSMakePoint(NSMinX(rect) + radius, NSMinY(rect) + radius)
-											 radius:radius
-										 startAngle:180.0
-										   endAngle:0.0];
-		}
++ (CGPathRef)newCGPathWithRoundEndedRect:(NSRect)rect
+{
+	CGMutablePathRef path = CGPathCreateMutable();
+	DKShapeFactoryEmitRoundEndedRect(path, rect);
+	return path;
+}
 
-		[path closePath];
++ (CGPathRef)newCGPathWithCross
+{
+	CGMutablePathRef path = CGPathCreateMutable();
+	DKShapeFactoryEmitCross(path);
+	return path;
+}
 
-		return path;
-	}
++ (CGPathRef)newCGPathWithDiagonalCross
+{
+	CGMutablePathRef path = CGPathCreateMutable();
+	DKShapeFactoryEmitDiagonalCross(path);
+	return path;
+}
+
++ (CGPathRef)newCGPathWithUnitPath:(CGPathRef)unitPath mappedToRect:(NSRect)rect
+{
+	// CG-side counterpart of paths:inRects:count: for a single rect - maps a canonical unit path
+	// (bounded by rectOfUnitSize) into <rect> without round-tripping through NSBezierPath. Bulk
+	// callers invoke this once per rect against one shared canonical path.
+
+	NSAssert(unitPath != NULL, @"cannot map a NULL unit path");
+
+	CGAffineTransform tfm = CGAffineTransformMake(rect.size.width, 0.0, 0.0, rect.size.height, NSMidX(rect), NSMidY(rect));
+
+	return CGPathCreateCopyByTransformingPath(unitPath, &tfm);
 }
 
 #pragma mark -
@@ -523,16 +624,49 @@ NSString* const kDKSpeechBalloonCornerRadius = @"kDKSpeechBalloonCornerRadius";
 	// returns a path at the origin representing the glyph of the letter passed. This may need some adjustment to use in a shape.
 	// the character will be drawn "upside down" in a DKDrawingView unless the object that owns this path creates an appropriate transform.
 
-	NSFont* font = [NSFont fontWithName:fontName
-								   size:1];
-	NSBezierPath* path = [NSBezierPath bezierPath];
-	NSPoint p = NSMakePoint(-0.5, -0.5);
+	return DKShapeFactoryCachedPath([NSString stringWithFormat:@"glyph.%@.%@", fontName, glyph], ^NSBezierPath* {
+		NSFont* font = [NSFont fontWithName:fontName
+									   size:1];
+		NSBezierPath* path = [NSBezierPath bezierPath];
+		NSPoint p = NSMakePoint(-0.5, -0.5);
 
-	[path moveToPoint:p];
-	[path appendBezierPathWithGlyph:[font glyphWithName:glyph]
-							 inFont:font];
+		[path moveToPoint:p];
+		[path appendBezierPathWithGlyph:[font glyphWithName:glyph]
+								 inFont:font];
 
-	return path;
+		return path;
+	});
+}
+
+#pragma mark -
++ (NSArray<NSBezierPath*>*)paths:(NSBezierPath*)unitPath inRects:(const NSRect*)rects count:(NSUInteger)count
+{
+	// bulk instantiation for import workloads - maps the canonical unit path into each rect in
+	// turn, reusing one transform object across the whole batch. transformBezierPath: copies the
+	// path before transforming it, so each result is independent.
+
+	NSAssert(unitPath != nil, @"cannot bulk-transform a nil path");
+	NSAssert(rects != NULL || count == 0, @"rect array was NULL");
+
+	NSMutableArray<NSBezierPath*>* result = [NSMutableArray arrayWithCapacity:count];
+	NSAffineTransform* tfm = [NSAffineTransform transform];
+	NSAffineTransformStruct ts;
+
+	ts.m12 = ts.m21 = 0.0;
+
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i) {
+		ts.m11 = rects[i].size.width;
+		ts.m22 = rects[i].size.height;
+		ts.tX = NSMidX(rects[i]);
+		ts.tY = NSMidY(rects[i]);
+		[tfm setTransformStruct:ts];
+
+		[result addObject:[tfm transformBezierPath:unitPath]];
+	}
+
+	return result;
 }
 
 #pragma mark -
@@ -11,6 +11,7 @@
 NS_ASSUME_NONNULL_BEGIN
 
 @class DKObjectDrawingLayer;
+@class DKQuartzCache;
 
 /** caching options
  */
@@ -48,11 +49,13 @@ typedef NS_ENUM(NSInteger, DKCreateGroupObjectType) {
 	NSArray<__kindof DKDrawableObject*>* m_objects; // objects in the group
 	NSRect mBounds; // overall bounding rect of the group
 	BOOL m_transformVisually; // if YES, group transform is visual only (like SVG) otherwise it's genuine
-	CGLayerRef mContentCache; // used to cache content
+	DKQuartzCache* mDKContentCache; // cached rendering of the whole group in drawing space, validated by its generation key
 	NSPDFImageRep* mPDFContentCache; // used to cache content at higher quality
 	DKGroupCacheOption mCacheOption; // caching options
 	BOOL mIsWritingToCache; // YES when building cache - modifies transforms
 	BOOL mClipContentToPath; // YES to clip group content to the group's path
+	NSSize mExtraSpaceCache; // cached aggregate of the children's extra space requirements
+	BOOL mExtraSpaceCacheValid; // NO when a child change requires the aggregate to be recomputed
 }
 
 // creating new groups:
@@ -10,15 +10,21 @@
 #import "DKDrawing.h"
 #import "DKGeometryUtilities.h"
 #import "DKObjectDrawingLayer.h"
+#import "DKQuartzCache.h"
 #import "DKSelectionPDFView.h"
 #import "DKStyle.h"
 #import "LogEvent.h"
+#import "NSAffineTransform+DKAdditions.h"
 #import "NSBezierPath+Geometry.h"
 
 @interface DKShapeGroup ()
 - (void)invalidateCache;
 - (void)updateCache;
 - (void)drawUntransformedContent;
+- (void)drawDirectContent;
+- (void)drawContentFromCache;
+- (BOOL)shouldUseContentCache;
+- (DKRenderCacheKey)contentCacheKey;
 
 @end
 
@@ -121,7 +127,7 @@
 		NSBezierPath* path = [NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]];
 		[self setPath:path];
 
-		//[self setCacheOptions:kDKGroupCacheUsingCGLayer];
+		[self setCacheOptions:kDKGroupCacheUsingCGLayer];
 	}
 	return self;
 }
@@ -153,13 +159,29 @@
 
 	[self setObjects:groupObjects];
 
-	// set the initial coordinates for the objects so they are relative to the group location
+	// set the initial coordinates for the objects so they are relative to the group location.
+	// the inverted content transform is built once and applied to all the locations in a single
+	// vectorized pass, instead of being rebuilt and inverted for every object as
+	// -convertPointFromContainer: would.
 
-	NSPoint loc;
+	NSUInteger i, count = [m_objects count];
 
-	for (DKDrawableObject* obj in m_objects) {
-		loc = [self convertPointFromContainer:[obj location]];
-		[obj setLocation:loc];
+	if (count > 0) {
+		NSPoint* locs = (NSPoint*)malloc(count * sizeof(NSPoint));
+		NSAffineTransform* ct = [self contentTransform];
+
+		[ct invert];
+
+		for (i = 0; i < count; ++i)
+			locs[i] = [(DKDrawableObject*)[m_objects objectAtIndex:i] location];
+
+		[ct transformPoints:locs
+					  count:count];
+
+		for (i = 0; i < count; ++i)
+			[(DKDrawableObject*)[m_objects objectAtIndex:i] setLocation:locs[i]];
+
+		free(locs);
 	}
 }
 
@@ -384,12 +406,63 @@
 
 - (void)updateCache
 {
-	// currently no-op
+	// nothing is rebuilt eagerly - the cache validates itself against its recorded generation key the
+	// next time the group draws, so an explicit update step is unnecessary
 }
 
 - (void)invalidateCache
 {
-	// currently no-op
+	mDKContentCache = nil;
+}
+
+- (BOOL)shouldUseContentCache
+{
+	// the cache is only a faithful substitute for direct drawing on screen - printing and PDF export
+	// must keep full vector fidelity, and hit testing draws into its own tiny bitmap context
+
+	return (mCacheOption & kDKGroupCacheUsingCGLayer) != 0 && !mIsWritingToCache && ![self isBeingHitTested] && [NSGraphicsContext currentContextDrawingToScreen];
+}
+
+- (DKRenderCacheKey)contentCacheKey
+{
+	// any change within the group - geometry or style of any child, at any depth - funnels through
+	// -drawableDidChangeBounds: and bumps the group's own change sequence, so that one counter stands
+	// for the entire content. The zoom is read from the current CTM and quantized to quarter steps,
+	// as for the rasterizer caches, so the bitmap is re-rendered when its resolution becomes stale.
+
+	CGFloat zoom = 1.0;
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+
+	if (context != NULL)
+		zoom = CGContextGetCTM(context).a;
+
+	zoom = round(fabs(zoom) * 4.0) * 0.25;
+
+	return DKRenderCacheKeyMake([self changeSequence], [[self style] changeGeneration], (NSInteger)[[self groupObjects] count], zoom);
+}
+
+- (void)drawContentFromCache
+{
+	NSRect br = [self bounds];
+
+	if (NSIsEmptyRect(br))
+		return;
+
+	DKRenderCacheKey key = [self contentCacheKey];
+
+	if (mDKContentCache == nil || ![mDKContentCache isValidForKey:key]) {
+		DKQuartzCache* cache = [DKQuartzCache cacheForCurrentContextInRect:br];
+
+		[cache lockFocus];
+		NSRectClip(br);
+		[self drawDirectContent];
+		[cache unlockFocus];
+		[cache recordDependencyKey:key];
+
+		mDKContentCache = cache;
+	}
+
+	[mDKContentCache drawAtPoint:br.origin];
 }
 
 - (void)drawUntransformedContent
@@ -519,11 +592,9 @@
 #pragma mark -
 #pragma mark As a DKDrawableObject
 
-- (NSRect)bounds
-{
-	mBoundsCache = NSZeroRect;
-	return [super bounds];
-}
+// note: -bounds is inherited unchanged from DKDrawableShape. The only child-dependent input to it is
+// -extraSpaceNeeded, which is cached here and invalidated through -drawableDidChangeBounds:, so the
+// inherited bounds cache remains valid until a child actually changes.
 
 - (NSSet*)allStyles
 {
@@ -583,6 +654,19 @@
  and renders the objects directly, or else it relies on the objects calling back to get the
  parent transform and applying it correctly. */
 - (void)drawContent
+{
+	// with the CGLayer cache option on, a group whose content has not changed since the last draw is
+	// composited as a single layer blit instead of re-rendering the whole child hierarchy
+
+	if ([self shouldUseContentCache]) {
+		[self drawContentFromCache];
+		return;
+	}
+
+	[self drawDirectContent];
+}
+
+- (void)drawDirectContent
 {
 	SAVE_GRAPHICS_CONTEXT
 
@@ -630,7 +714,15 @@
 
 - (NSSize)extraSpaceNeeded
 {
-	return [self extraSpaceNeededByObjects:[self groupObjects]];
+	// aggregating the children is linear in the total (nested) content, so the result is cached and only
+	// recomputed after a child reports a change via -drawableDidChangeBounds:
+
+	if (!mExtraSpaceCacheValid) {
+		mExtraSpaceCache = [self extraSpaceNeededByObjects:[self groupObjects]];
+		mExtraSpaceCacheValid = YES;
+	}
+
+	return mExtraSpaceCache;
 }
 
 /** @brief Adds group commands to the contextual menu
@@ -790,7 +882,7 @@
 	if (self != nil) {
 		NSBezierPath* path = [NSBezierPath bezierPathWithRect:[[self class] unitRectAtOrigin]];
 		[self setPath:path];
-		//[self setCacheOptions:kDKGroupCacheUsingCGLayer];
+		[self setCacheOptions:kDKGroupCacheUsingCGLayer];
 	}
 	return self;
 }
@@ -841,6 +933,23 @@
 	return [[self groupObjects] indexOfObject:obj];
 }
 
+/** @brief Marks the cached aggregates stale when a child changes.
+
+ Invalidation is lazy - nothing is recomputed here. The next query of the group's bounds re-aggregates
+ the children once. Notifying our own visual change propagates the dirty flag to any enclosing group,
+ so each level of a nested hierarchy is invalidated at most once per edit.
+ @param obj the child that changed (unused - any change dirties the aggregate) */
+- (void)drawableDidChangeBounds:(DKDrawableObject*)obj
+{
+#pragma unused(obj)
+
+	if (mExtraSpaceCacheValid || !NSEqualRects(mBoundsCache, NSZeroRect)) {
+		mExtraSpaceCacheValid = NO;
+		mBoundsCache = NSZeroRect;
+		[self notifyVisualChange];
+	}
+}
+
 - (DKImageDataManager*)imageManager
 {
 	return [[self drawing] imageManager];
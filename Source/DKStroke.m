@@ -218,6 +218,13 @@
 	return NSMakeSize([self allowance], [self allowance]);
 }
 
+- (BOOL)perturbsContextState
+{
+	// stroking works on a scratch path and the shadow case brackets its own state in -render:
+
+	return NO;
+}
+
 - (void)render:(id<DKRenderable>)obj
 {
 	if (![obj conformsToProtocol:@protocol(DKRenderable)] || ![self enabled])
@@ -225,10 +232,27 @@
 
 	BOOL lowQuality = [obj useLowQualityDrawing];
 
+	// without a shadow nothing persistent is set on the context (stroking attributes live on the
+	// scratch path), so the plain case renders without the save/restore pair
+
+	if ([self shadow] == nil || ![DKStyle willDrawShadows]) {
+		[super render:obj];
+		return;
+	}
+
 	SAVE_GRAPHICS_CONTEXT //[NSGraphicsContext saveGraphicsState];
 		if ([self shadow] != nil && [DKStyle willDrawShadows])
 	{
-		if (!lowQuality)
+		// drawables get the shadow composited from a cached bitmap, re-blurred only when the
+		// content changes; low quality drawing renders the bitmap at reduced resolution
+
+		if ([obj isKindOfClass:[DKDrawableObject class]])
+			[[self shadow] drawCachedShadowWithPath:[obj renderingPath]
+										  forObject:(DKDrawableObject*)obj
+										  operation:kDKShadowDrawStroke
+										strokeWidth:[self width]
+										 lowQuality:lowQuality];
+		else if (!lowQuality)
 			[[self shadow] setAbsolute];
 		else
 			[[self shadow] drawApproximateShadowWithPath:[obj renderingPath]
@@ -242,23 +266,43 @@
 
 - (void)renderPath:(NSBezierPath*)path
 {
-	// copy path as we are about to change many of its properties
+	// the path is about to have many of its drawing attributes changed, so work on a scratch copy;
+	// scratch paths are recycled per thread, avoiding an allocation per stroke per frame
 
 	NSBezierPath* pc;
 
-	if ([self trimLength] > 0.0)
-		pc = [path bezierPathByTrimmingFromBothEnds:[self trimLength]];
-	else
-		pc = [path copy];
-
-	if (mLateralOffset != 0.0) {
-		// make a parallel copy of the path
-		CGFloat savedFlatness = [NSBezierPath defaultFlatness];
-		[NSBezierPath setDefaultFlatness:0.05];
-		[pc setLineJoinStyle:[self lineJoinStyle]];
-		pc = [pc paralleloidPathWithOffset22:[self lateralOffset]];
-		[NSBezierPath setDefaultFlatness:savedFlatness];
-	}
+	if ([self trimLength] > 0.0 || mLateralOffset != 0.0) {
+		// trimming and offsetting walk the whole path, so the derived geometry is kept in the
+		// container's central cache and recomputed only when the path or the parameters change
+
+		NSString* key = [self derivedPathCacheKeyForPath:path
+											  parameters:[NSString stringWithFormat:@"%.3f_%.3f_%ld", [self trimLength], [self lateralOffset], (long)[self lineJoinStyle]]];
+
+		pc = [self cachedDerivedPathWithKey:key
+									creator:^NSBezierPath* {
+										 NSBezierPath* derived = path;
+
+										 if ([self trimLength] > 0.0)
+											 derived = [derived bezierPathByTrimmingFromBothEnds:[self trimLength]];
+
+										 if (mLateralOffset != 0.0) {
+											 // make a parallel copy of the path
+											 CGFloat savedFlatness = [NSBezierPath defaultFlatness];
+											 [NSBezierPath setDefaultFlatness:0.05];
+
+											 if (derived == path)
+												 derived = [path copy];
+
+											 [derived setLineJoinStyle:[self lineJoinStyle]];
+											 derived = [derived paralleloidPathWithOffset22:[self lateralOffset]];
+											 [NSBezierPath setDefaultFlatness:savedFlatness];
+										 }
+
+										 return derived;
+									 }];
+		pc = [DKRasterizer scratchPathWithPath:pc];
+	} else
+		pc = [DKRasterizer scratchPathWithPath:path];
 
 	[[self colour] setStroke];
 	[self applyAttributesToPath:pc];
@@ -15,6 +15,8 @@ NS_ASSUME_NONNULL_BEGIN
 	NSUInteger m_count;
 	BOOL m_scaleToLineWidth;
 	BOOL mEditing;
+	CGFloat mScaledPattern[8]; // pattern pre-multiplied for the cached scale bucket
+	CGFloat mScaledPatternScale; // quantized scale the cache was built for (0 = cache invalid)
 }
 
 + (DKStrokeDash*)defaultDash NS_SWIFT_UNAVAILABLE("Use `init()` instead");
@@ -19,6 +19,19 @@ static NSUInteger euclid_hcf(NSUInteger a, NSUInteger b)
 		return euclid_hcf(b, a % b);
 }
 
+static inline CGFloat quantizedDashScale(CGFloat scale)
+{
+	// snaps a dash scale factor to a geometric bucket (32 per octave, ~2% steps). Continuously
+	// varying zoom then maps to a small stable set of scales, so the scaled pattern can be cached
+	// and consecutive strokes hand Quartz bit-identical dash arrays. A 2% step in dash length is
+	// well below what the eye can pick out of a stroked pattern.
+
+	if (scale <= 0.0)
+		return 1.0;
+
+	return exp2(round(log2(scale) * 32.0) / 32.0);
+}
+
 #pragma mark -
 @implementation DKStrokeDash
 #pragma mark As a DKStrokeDash
@@ -130,6 +143,8 @@ static NSUInteger euclid_hcf(NSUInteger a, NSUInteger b)
 
 	if (!valid)
 		m_pattern[0] = 1.0;
+
+	mScaledPatternScale = 0.0;
 }
 
 - (void)getDashPattern:(CGFloat[])dashes count:(NSInteger*)count
@@ -198,14 +213,21 @@ static NSUInteger euclid_hcf(NSUInteger a, NSUInteger b)
 	// if scales to line width, use path's line width to multiply each element of the pattern
 
 	if ([self scalesToLineWidth]) {
-		CGFloat scale = [path lineWidth];
-		CGFloat dp[8];
-		NSUInteger i;
+		// the scale is quantized into buckets and the multiplied pattern cached, so redrawing
+		// at a continuously varying zoom reuses the same array instead of recomputing it per stroke
+
+		CGFloat scale = quantizedDashScale([path lineWidth]);
+
+		if (scale != mScaledPatternScale) {
+			NSUInteger i;
+
+			for (i = 0; i < m_count; ++i)
+				mScaledPattern[i] = m_pattern[i] * scale;
 
-		for (i = 0; i < m_count; ++i)
-			dp[i] = m_pattern[i] * scale;
+			mScaledPatternScale = scale;
+		}
 
-		[path setLineDash:dp
+		[path setLineDash:mScaledPattern
 					count:m_count
 					phase:-phase * scale];
 	} else
@@ -334,6 +356,7 @@ static NSUInteger euclid_hcf(NSUInteger a, NSUInteger b)
 	if (pnum < 8 && pnum >= 0) {
 		m_count = pnum + 1;
 		m_pattern[pnum] = [val doubleValue];
+		mScaledPatternScale = 0.0;
 	}
 }
 
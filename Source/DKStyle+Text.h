@@ -45,6 +45,18 @@ the text it displays. Other objects that use text can make use of this as they w
 
 - (DKStyle*)drawingStyleFromTextAttributes;
 
+/** @brief Warms the text machinery for the text attributes of the given styles on a background queue.
+
+ Fonts resolve lazily - the first time text is actually laid out with a font, AppKit pays the full
+ font-resolution cost, so the first paint of a text-heavy document stutters font-by-font. This walks the
+ given styles (typically a freshly opened drawing's \c -allStyles set), and for each distinct set of text
+ attributes not yet seen this process, performs a tiny throwaway layout on a background queue so the font
+ caches are hot before the first real draw. Attribute sets are fingerprinted into a process-wide cache,
+ so repeated opens (or many styles sharing a font) warm each distinct set only once. Styles without text
+ attributes are skipped. Called automatically when a drawing is opened from data.
+ */
++ (void)warmTextAttributesOfStyles:(NSSet<DKStyle*>*)styles;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -11,6 +11,54 @@
 
 static NSString* kDKBasicTextStyleDefaultKey = @"326CF635-7863-42C6-900D-CFFC7D57505E";
 
+#pragma mark - text attribute warming
+
+/** returns a compact fingerprint of a text attribute dictionary - equal attribute sets produce equal
+ fingerprints, so the warming cache can recognise attribute sets it has already resolved regardless of
+ which style instance carries them. */
+static NSString* textAttributesFingerprint(NSDictionary* attributes)
+{
+	NSFont* font = [attributes objectForKey:NSFontAttributeName];
+	NSMutableString* fp = [NSMutableString stringWithFormat:@"%@_%.2f", [font fontName], [font pointSize]];
+
+	// the remaining attributes (colours, paragraph style, underline etc.) fold in by their hashes -
+	// they don't affect font resolution but distinguish attribute sets for the cache
+
+	NSArray* keys = [[attributes allKeys] sortedArrayUsingSelector:@selector(compare:)];
+
+	for (NSString* key in keys) {
+		if (![key isEqualToString:NSFontAttributeName])
+			[fp appendFormat:@"_%@=%lu", key, (unsigned long)[[attributes objectForKey:key] hash]];
+	}
+
+	return fp;
+}
+
+/** the serial queue the warming layouts run on - deliberately off the main thread and one at a time,
+ so a document with many text styles warms steadily behind the open instead of competing with it. */
+static dispatch_queue_t textWarmingQueue(void)
+{
+	static dispatch_queue_t sQueue = NULL;
+	static dispatch_once_t sOnce;
+
+	dispatch_once(&sOnce, ^{
+		sQueue = dispatch_queue_create("net.apptree.drawkit.textwarming", DISPATCH_QUEUE_SERIAL);
+	});
+
+	return sQueue;
+}
+
+/** fingerprints of attribute sets already warmed (or being warmed) this process; accessed only on the warming queue. */
+static NSMutableSet* warmedFingerprints(void)
+{
+	static NSMutableSet* sWarmed = nil;
+
+	if (sWarmed == nil)
+		sWarmed = [[NSMutableSet alloc] init];
+
+	return sWarmed;
+}
+
 @implementation DKStyle (TextAdditions)
 #pragma mark As a DKStyle
 
@@ -71,6 +119,41 @@ static NSString* kDKBasicTextStyleDefaultKey = @"326CF635-7863-42C6-900D-CFFC7D5
 	return [NSString stringWithFormat:@"%@ %.1fpt", [font displayName], [font pointSize]];
 }
 
++ (void)warmTextAttributesOfStyles:(NSSet<DKStyle*>*)styles
+{
+	// snapshot the attribute dictionaries now - the styles themselves stay on the calling thread
+
+	NSMutableArray* attributeSets = [NSMutableArray array];
+
+	for (DKStyle* style in styles) {
+		if ([style hasTextAttributes])
+			[attributeSets addObject:[[style textAttributes] copy]];
+	}
+
+	if ([attributeSets count] == 0)
+		return;
+
+	dispatch_async(textWarmingQueue(), ^{
+		NSMutableSet* warmed = warmedFingerprints();
+
+		for (NSDictionary* attributes in attributeSets) {
+			NSString* fp = textAttributesFingerprint(attributes);
+
+			if ([warmed containsObject:fp])
+				continue;
+
+			[warmed addObject:fp];
+
+			// a tiny throwaway measurement forces the font through the full resolution path (string
+			// drawing is thread-safe per-thread), so the first real draw finds everything hot
+
+			NSAttributedString* probe = [[NSAttributedString alloc] initWithString:@"Ag"
+																		attributes:attributes];
+			(void)[probe size];
+		}
+	});
+}
+
 #pragma mark -
 - (void)setParagraphStyle:(NSParagraphStyle*)style
 {
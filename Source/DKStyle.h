@@ -38,8 +38,18 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
 	NSString* m_uniqueKey; // unique key, set once for all time
 	BOOL m_mergeFlag; // set to YES when a style is read in from a file and was saved in a registered state.
 	NSTimeInterval m_lastModTime; // timestamp to determine when styles have been updated
+	NSUInteger mChangeGeneration; // monotonically increasing counter, bumped by each committed change fan-out
 	NSUInteger m_clientCount; // keeps count of the clients using the style
+	NSHashTable<DKDrawableObject*>* mClients; // weak set of the drawables using the style, for direct change delivery
 	NSMutableDictionary* mSwatchCache; // cache of swatches at various sizes previously requested
+	NSInteger mUpdateLevel; // nesting level of beginUpdates/endUpdates transactions, 0 = not in a transaction
+	BOOL mChangesDuringUpdate; // YES if any change was notified while a transaction was open
+	NSUInteger mStructuralHash; // cached structural fingerprint of the render tree - see -structuralHash
+	NSUInteger mStructuralHashGeneration; // change generation the cached fingerprint was computed at
+	BOOL mStructuralHashValid; // NO until the fingerprint has been computed at least once
+	NSTimeInterval mRenderCostEMA; // smoothed measured render time per object, in seconds
+	NSUInteger mRenderCostSamples; // number of full-fidelity renders measured so far
+	BOOL mBudgetExceededNotified; // YES once the over-budget notification has been posted for the current episode
 }
 
 // basic standard styles:
@@ -162,8 +172,67 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 @property (class) BOOL shouldSubstitutePlaceholderStyle;
 
+/** @brief Set whether styles record their rendering into retained vector buffers for replay.
+
+ Default is <code>NO</code>. When enabled, a style records the Quartz calls it issues for a drawable
+ into a compact single-page vector buffer and replays that buffer on subsequent frames, until the
+ object's geometry or the style itself changes. Replay is resolution independent, so unlike bitmap
+ caches the buffer survives zoom changes without re-running any rasterizer logic. Note that raster
+ based effects within a style (shadows, Core Image filters) are flattened into the buffer at the
+ resolution they were recorded at.
+ */
+@property (class) BOOL shouldRetainVectorBuffers;
+
+/** @brief The per-object render time above which a style is considered over budget.
+
+ Default is \c 0.0, which disables budgeting. When set to a positive interval (in seconds), each style
+ compares its own measured render cost against it: an over-budget style renders its placeholder tier
+ while low quality drawing is in effect (i.e. during tool gestures and rapid redraws), and posts
+ \c kDKStyleRenderTimeExceededBudgetNotification the first time it crosses the budget so the host
+ application can tell the user which style is slow, and by how much. Full-quality and printed output
+ is never degraded. The setting is persistent.
+ */
+@property (class) NSTimeInterval renderTimeBudget;
+
+/** @brief The style's measured render cost, in seconds per object.
+
+ An exponential moving average over the style's full-fidelity renders - placeholder and replayed-buffer
+ draws are excluded so the figure reflects what the style's rasterizers actually cost. \c 0.0 until the
+ style has been rendered at least once.
+ */
+@property (readonly) NSTimeInterval averageRenderTime;
+
+/** @brief The number of renders that contributed to <code>averageRenderTime</code>. */
+@property (readonly) NSUInteger renderCostSampleCount;
+
+/** @brief Whether the style's measured cost is above the class render time budget.
+
+ Always \c NO when budgeting is disabled or while too few renders have been measured to judge.
+ */
+@property (readonly) BOOL exceedsRenderTimeBudget;
+
 // updating & notifying clients:
 
+/** @brief Opens a batched update transaction.
+
+ While a transaction is open, the will-change notification is sent to clients at most once and the did-change
+ notification is deferred entirely until the matching <code>-endUpdates</code>. For a shared style attached to
+ many objects this collapses a multi-attribute change into a single fan-out to the clients - and thus a single
+ redraw invalidation per client - instead of one per property. Transactions nest; only the outermost pair
+ notifies.
+ */
+- (void)beginUpdates;
+
+/** @brief Closes a batched update transaction.
+
+ When the outermost transaction ends and any property changed within it, clients receive one did-change
+ notification covering all of the changes.
+ */
+- (void)endUpdates;
+
+/** @brief Whether a batched update transaction is currently open. */
+@property (readonly, getter=isUpdating) BOOL updating;
+
 /** @brief Informs clients that a property of the style is about to change. */
 - (void)notifyClientsBeforeChange;
 
@@ -172,6 +241,15 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  This method is called in response to any observed change to any renderer the style contains. */
 - (void)notifyClientsAfterChange;
 
+/** @brief A counter that increases by one each time a change to the style is committed to clients.
+
+ Caches of artwork derived from the style can record this value when an entry is built and compare it
+ later - a cheap O(1) staleness test that avoids observing the style's change notifications. Within a
+ batched update transaction the counter moves once, when the outermost \c -endUpdates commits. The value
+ is not archived and restarts at zero per instance, so only compare values captured from the same
+ style object. */
+@property (readonly) NSUInteger changeGeneration;
+
 /** @brief Called when a style is attached to an object.
 
  The notification's object is the drawable, not the style - the style is passed in the user info
@@ -189,6 +267,14 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 - (void)styleWillBeRemoved:(DKDrawableObject*)fromObject;
 
+/** @brief Tells every client using the style to redisplay itself.
+
+ Unlike <code>-notifyClientsAfterChange</code>, this does not bump the change generation or the
+ modification timestamp - use it when cached artwork derived from the style has become available
+ (or invalid) without the style itself having been edited.
+ */
+- (void)redisplayClients;
+
 /** @brief Returns the number of client objects using this style.
 
  This is for information only - do not base critical code on this value.
@@ -291,6 +377,25 @@ typedef NS_ENUM(NSInteger, DKDerivedStyleOptions) {
  */
 - (BOOL)isEqualToStyle:(DKStyle*)aStyle;
 
+/** @brief A fingerprint of the style's visual structure - the rasterizer tree and text attributes.
+
+ Styles that render identically produce equal hashes regardless of their unique key or timestamp, so
+ the hash can index styles by what they draw rather than by their identity. The hash is computed from
+ an archive of the render tree, cached, and recomputed only after the style has changed. Equal hashes
+ are confirmed with <code>-isStructurallyEqualToStyle:</code> before being treated as a match.
+ */
+@property (readonly) NSUInteger structuralHash;
+
+/** @brief Compares the visual structure of two styles.
+
+ Unlike <code>-isEqualToStyle:</code>, which tests identity (unique key and timestamp), this tests
+ whether the two styles would render identically, by comparing archives of their render trees and
+ text attributes. Intended to be called only when the styles' structural hashes already match.
+ @param aStyle A style to compare this with.
+ @return \c YES if the styles have the same visual structure, \c NO otherwise.
+ */
+- (BOOL)isStructurallyEqualToStyle:(DKStyle*)aStyle;
+
 // undo:
 
 /** @brief Sets the undo manager that style changes will be recorded by.
@@ -493,10 +598,20 @@ extern NSNotificationName const kDKStyleLockStateChangedNotification;
 extern NSNotificationName const kDKStyleSharableFlagChangedNotification;
 extern NSNotificationName const kDKStyleNameChangedNotification;
 
+/** posted (once per over-budget episode, on the main queue) when a style's measured render cost first
+ exceeds the class render time budget. The object is the style; the user info carries the measured
+ average render time in seconds under \c kDKStyleRenderTimeUserInfoKey. */
+extern NSNotificationName const kDKStyleRenderTimeExceededBudgetNotification;
+
+/** user info key for the measured average render time (NSNumber, seconds). */
+extern NSString* const kDKStyleRenderTimeUserInfoKey;
+
 // preferences keys
 
 extern NSString* const kDKStyleDisplayPerformance_no_anti_aliasing;
 extern NSString* const kDKStyleDisplayPerformance_no_shadows;
 extern NSString* const kDKStyleDisplayPerformance_substitute_styles;
+extern NSString* const kDKStyleDisplayPerformance_retained_vectors;
+extern NSString* const kDKStyleDisplayPerformance_render_budget;
 
 NS_ASSUME_NONNULL_END
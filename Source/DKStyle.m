@@ -5,6 +5,7 @@
 */
 
 #import "DKStyle.h"
+#import "DKDrawKitMacros.h"
 #import "DKDrawablePath.h"
 #import "DKDrawableShape.h"
 #import "DKFill.h"
@@ -13,6 +14,9 @@
 #import "DKGradient.h"
 #import "DKHatching.h"
 #import "DKImageAdornment.h"
+#import "DKObjectOwnerLayer.h"
+#import "DKPerformanceCounters.h"
+#import "DKRenderCacheKey.h"
 #import "DKRoughStroke.h"
 #import "DKStyleRegistry.h"
 #import "DKTextAdornment.h"
@@ -40,6 +44,11 @@ NSString* const kDKStyleTextAttributesDidChangeNotification = @"kDKStyleTextAttr
 NSString* const kDKStyleDisplayPerformance_no_anti_aliasing = @"kDKStyleDisplayPerformance_no_anti_aliasing";
 NSString* const kDKStyleDisplayPerformance_no_shadows = @"kDKStyleDisplayPerformance_no_shadows";
 NSString* const kDKStyleDisplayPerformance_substitute_styles = @"kDKStyleDisplayPerformance_substitute_styles";
+NSString* const kDKStyleDisplayPerformance_retained_vectors = @"kDKStyleDisplayPerformance_retained_vectors";
+NSString* const kDKStyleDisplayPerformance_render_budget = @"kDKStyleDisplayPerformance_render_budget";
+
+NSString* const kDKStyleRenderTimeExceededBudgetNotification = @"kDKStyleRenderTimeExceededBudgetNotification";
+NSString* const kDKStyleRenderTimeUserInfoKey = @"kDKStyleRenderTimeUserInfoKey";
 
 // the fixed default styles need to have a predetermined (but still unique) key. We define them here.
 // Do not change or interpret these values.
@@ -54,10 +63,33 @@ static NSMutableDictionary* sPasteboardRegistry = nil;
 static BOOL sShouldDrawShadows = YES;
 static BOOL sAntialias = YES;
 static BOOL sSubstitute = NO;
+static BOOL sRetainVectorBuffers = NO;
+static NSTimeInterval sRenderTimeBudget = 0.0;
+
+// per-style render cost accounting: weight of the newest sample in the moving average, and how many
+// samples must accumulate before a style is willing to call itself over budget
+
+static const double kDKRenderCostEMAWeight = 0.1;
+static const NSUInteger kDKRenderCostMinimumSamples = 4;
+
+// recorded vector buffers are held per drawable in a weak-keyed map, so entries vanish with their objects.
+// Each slot stores the single-page document and the generation stamp it was recorded under.
+
+static NSMapTable* sVectorBufferCache = nil;
+
+// objects larger than this on either side are not worth buffering - the PDF machinery gains nothing over direct drawing
+
+static const CGFloat kDKVectorBufferMaxSide = 16384.0;
 
 @interface DKStyle ()
 
 - (NSSize)extraSpaceNeededIgnoringMitreLimit;
+- (void)deliverChangeToClients:(NSNotification*)note;
+- (BOOL)shouldRenderPlaceholderForObject:(id<DKRenderable>)object;
+- (void)renderPlaceholderForObject:(id<DKRenderable>)object;
+- (void)recordRenderTimeNanos:(uint64_t)nanos;
+- (BOOL)renderVectorBufferForObject:(id<DKRenderable>)object;
+- (CGPDFDocumentRef)recordVectorBufferForObject:(id<DKRenderable>)object pageRect:(NSRect)pageRect CF_RETURNS_RETAINED;
 
 @end
 
@@ -372,14 +404,93 @@ static BOOL sSubstitute = NO;
 	return sSubstitute;
 }
 
+/** @brief Set whether styles record their rendering into retained vector buffers for replay.
+
+ Default is NO. When enabled, the Quartz calls a style issues for an object are recorded once and
+ replayed on subsequent frames until the object or the style changes, which skips all rasterizer
+ logic for unchanged objects. Replay is resolution independent so the buffer survives zoom changes.
+ @param retainBuffers YES to record and replay vector buffers, NO to re-run rasterizers every frame
+ */
++ (void)setShouldRetainVectorBuffers:(BOOL)retainBuffers
+{
+	sRetainVectorBuffers = retainBuffers;
+	[[NSUserDefaults standardUserDefaults] setBool:retainBuffers
+											forKey:kDKStyleDisplayPerformance_retained_vectors];
+}
+
+/** @brief Whether styles record their rendering into retained vector buffers for replay
+
+ See <code>+setShouldRetainVectorBuffers:</code>.
+ @return YES to record and replay vector buffers, NO to re-run rasterizers every frame
+ */
++ (BOOL)shouldRetainVectorBuffers
+{
+	return sRetainVectorBuffers;
+}
+
+/** @brief Set the per-object render time budget - see header
+
+ 0 disables budgeting (the default).
+ @param budget the budget in seconds, or 0 to disable
+ */
++ (void)setRenderTimeBudget:(NSTimeInterval)budget
+{
+	sRenderTimeBudget = MAX(budget, 0.0);
+	[[NSUserDefaults standardUserDefaults] setDouble:sRenderTimeBudget
+											  forKey:kDKStyleDisplayPerformance_render_budget];
+}
+
+/** @brief The per-object render time budget in seconds; 0 when budgeting is disabled */
++ (NSTimeInterval)renderTimeBudget
+{
+	return sRenderTimeBudget;
+}
+
 #pragma mark -
 #pragma mark - updating& notifying clients
 
+/** @brief Opens a batched update transaction - see header */
+- (void)beginUpdates
+{
+	if (++mUpdateLevel == 1)
+		mChangesDuringUpdate = NO;
+}
+
+/** @brief Closes a batched update transaction - see header */
+- (void)endUpdates
+{
+	NSAssert(mUpdateLevel > 0, @"unbalanced call to -endUpdates");
+
+	if (--mUpdateLevel == 0 && mChangesDuringUpdate) {
+		mChangesDuringUpdate = NO;
+		[self notifyClientsAfterChange];
+	}
+}
+
+- (BOOL)isUpdating
+{
+	return mUpdateLevel > 0;
+}
+
 /** @brief Informs clients that a property of the style is about to change */
 - (void)notifyClientsBeforeChange
 {
-	[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleWillChangeNotification
-														object:self];
+	// within a transaction, only the first change notifies - clients capture their "before" state once
+
+	if (mUpdateLevel > 0) {
+		if (mChangesDuringUpdate)
+			return;
+
+		mChangesDuringUpdate = YES;
+	}
+
+	// clients are told directly - the notification is still posted for the benefit of other interested
+	// parties (registry, UI), but no drawable observes it
+
+	NSNotification* note = [NSNotification notificationWithName:kDKStyleWillChangeNotification
+														 object:self];
+	[self deliverChangeToClients:note];
+	[[NSNotificationCenter defaultCenter] postNotification:note];
 }
 
 /** @brief Informs clients that a property of the style has just changed
@@ -387,16 +498,74 @@ static BOOL sSubstitute = NO;
  This method is called in response to any observed change to any renderer the style contains */
 - (void)notifyClientsAfterChange
 {
+	// within a transaction the fan-out is deferred until the outermost -endUpdates, which calls back here
+
+	if (mUpdateLevel > 0) {
+		mChangesDuringUpdate = YES;
+		return;
+	}
+
 	// update the timestamp so that style registry can determine which of a pair of similar styles is the more recent
 
 	m_lastModTime = [NSDate timeIntervalSinceReferenceDate];
+	++mChangeGeneration;
 
 	// invalidate any swatch cache to ensure cache is forced to be rebuilt after a change
 
 	[mSwatchCache removeAllObjects];
 
-	[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleDidChangeNotification
-														object:self];
+	NSNotification* note = [NSNotification notificationWithName:kDKStyleDidChangeNotification
+														 object:self];
+	[self deliverChangeToClients:note];
+	[[NSNotificationCenter defaultCenter] postNotification:note];
+}
+
+/** @brief Delivers a change to every client using the style by direct iteration
+
+ With very large numbers of objects sharing a style, notification centre dispatch is itself a
+ measurable cost on every style edit, so the attached drawables are called directly instead of
+ observing the style. Each client's layer is put into deferred update mode for the duration so the
+ per-object invalidation rects accumulate into one union per layer rather than being flagged
+ individually. Clients not yet in a layer are skipped, matching the old rule that observation was
+ only established once an object joined a layer.
+ */
+- (void)deliverChangeToClients:(NSNotification*)note
+{
+	if ([mClients count] == 0)
+		return;
+
+	BOOL isWillChange = [[note name] isEqualToString:kDKStyleWillChangeNotification];
+	NSMutableSet* deferredLayers = nil;
+
+	for (DKDrawableObject* client in [mClients allObjects]) {
+		DKLayer* layer = [client layer];
+
+		if (layer == nil)
+			continue;
+
+		if ([layer respondsToSelector:@selector(beginDeferredUpdates)] && ![deferredLayers containsObject:layer]) {
+			if (deferredLayers == nil)
+				deferredLayers = [NSMutableSet set];
+
+			[(DKObjectOwnerLayer*)layer beginDeferredUpdates];
+			[deferredLayers addObject:layer];
+		}
+
+		if (isWillChange)
+			[client styleWillChange:note];
+		else
+			[client styleDidChange:note];
+	}
+
+	for (DKObjectOwnerLayer* layer in deferredLayers)
+		[layer endDeferredUpdates];
+}
+
+/** @brief Tells every client using the style to redisplay itself - see header */
+- (void)redisplayClients
+{
+	[self deliverChangeToClients:[NSNotification notificationWithName:kDKStyleDidChangeNotification
+															   object:self]];
 }
 
 /** @brief Called when a style is attached to an object
@@ -417,6 +586,14 @@ static BOOL sSubstitute = NO;
 														object:toObject
 													  userInfo:userInfo];
 
+	// record the client in the weak client set - style changes are delivered to it by direct
+	// iteration, not through the notification centre
+
+	if (mClients == nil)
+		mClients = [NSHashTable weakObjectsHashTable];
+
+	[mClients addObject:toObject];
+
 	// keep track of the number of clients using this
 
 	++m_clientCount;
@@ -438,6 +615,8 @@ static BOOL sSubstitute = NO;
 														object:fromObject
 													  userInfo:userInfo];
 
+	[mClients removeObject:fromObject];
+
 	// keep track of the number of clients using this
 
 	--m_clientCount;
@@ -625,6 +804,7 @@ static BOOL sSubstitute = NO;
 }
 
 @synthesize lastModificationTimestamp = m_lastModTime;
+@synthesize changeGeneration = mChangeGeneration;
 
 /** @brief Is this style the same as <aStyle>?
 
@@ -642,6 +822,62 @@ static BOOL sSubstitute = NO;
 	return same;
 }
 
+/** returns an archive of the parts of the style that determine what it draws - the render tree and
+ the text attributes - and nothing of its identity (key, name, timestamp). Equal structures built the
+ same way archive identically within a process, so the archive serves as a comparable fingerprint.
+ In the rare case that equal structures archive differently, the only consequence is a missed match,
+ which is safe. */
+- (NSData*)structuralFingerprintData
+{
+	NSMutableData* data = [NSMutableData data];
+	NSKeyedArchiver* arch = [[NSKeyedArchiver alloc] initForWritingWithMutableData:data];
+
+	[arch encodeObject:[self renderList]
+				forKey:@"renderList"];
+	[arch encodeObject:[self textAttributes]
+				forKey:@"textAttributes"];
+	[arch finishEncoding];
+
+	return data;
+}
+
+- (NSUInteger)structuralHash
+{
+	// the fingerprint is stable until the style changes, so it is cached against the change
+	// generation and only recomputed after a committed change
+
+	if (!mStructuralHashValid || mStructuralHashGeneration != [self changeGeneration]) {
+		NSData* fp = [self structuralFingerprintData];
+		const uint8_t* bytes = [fp bytes];
+		NSUInteger i, len = [fp length];
+		uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a
+
+		for (i = 0; i < len; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001b3ULL;
+		}
+
+		mStructuralHash = (NSUInteger)hash;
+		mStructuralHashGeneration = [self changeGeneration];
+		mStructuralHashValid = YES;
+	}
+
+	return mStructuralHash;
+}
+
+- (BOOL)isStructurallyEqualToStyle:(DKStyle*)aStyle
+{
+	if (aStyle == self)
+		return YES;
+
+	if (aStyle == nil || [self structuralHash] != [aStyle structuralHash])
+		return NO;
+
+	// hashes agree - confirm with a full comparison of the fingerprints
+
+	return [[self structuralFingerprintData] isEqualToData:[aStyle structuralFingerprintData]];
+}
+
 #pragma mark -
 #pragma mark - undo
 
@@ -670,6 +906,10 @@ static BOOL sSubstitute = NO;
 - (void)scaleStrokeWidthsBy:(CGFloat)scale withoutInformingClients:(BOOL)quiet
 {
 	if (quiet || ![self locked]) {
+		// batched so that scaling several strokes fans out to the clients only once
+
+		[self beginUpdates];
+
 		if (!quiet)
 			[self notifyClientsBeforeChange];
 
@@ -679,6 +919,8 @@ static BOOL sSubstitute = NO;
 
 		if (!quiet)
 			[self notifyClientsAfterChange];
+
+		[self endUpdates];
 	}
 }
 
@@ -1006,8 +1248,12 @@ static BOOL sSubstitute = NO;
 	NSString* cacheKey = [self swatchCacheKeyForSize:size
 												type:type];
 
-	if ([mSwatchCache objectForKey:cacheKey] != nil)
+	if ([mSwatchCache objectForKey:cacheKey] != nil) {
+		DKPerfCounterAdd(&gDKPerfCounters.swatchCacheHits, 1);
 		return [mSwatchCache objectForKey:cacheKey];
+	}
+
+	DKPerfCounterAdd(&gDKPerfCounters.swatchCacheMisses, 1);
 
 	//NSLog(@"building swatch (size: %@) for style '%@'", NSStringFromSize( size ), [self name]);
 
@@ -1346,6 +1592,144 @@ static BOOL sSubstitute = NO;
 #pragma mark -
 #pragma mark As a DKRasterizer
 
+/** @brief Replays a retained vector buffer for the object, recording one first if necessary
+
+ The buffer is a single-page PDF holding the Quartz calls the style's render list issued for the
+ object, stamped with the object and style generations it was recorded under. While the stamp
+ matches, subsequent frames replay the page instead of re-running any rasterizer logic; replay is
+ resolution independent, so the buffer survives zoom changes. Returns NO whenever the buffer route
+ does not apply (feature off, printing, unflipped destination, oversized object, or a stale buffer
+ during low quality drawing) - the caller then renders directly as normal.
+ @param object the object being rendered
+ @return YES if the object was drawn from a vector buffer, NO if the caller should render directly
+ */
+- (BOOL)renderVectorBufferForObject:(id<DKRenderable>)object
+{
+	if (!sRetainVectorBuffers || ![NSGraphicsContext currentContextDrawingToScreen] || ![[NSGraphicsContext currentContext] isFlipped])
+		return NO;
+
+	if (![object isKindOfClass:[DKDrawableObject class]])
+		return NO;
+
+	DKDrawableObject* obj = (DKDrawableObject*)object;
+	NSSize es = [self extraSpaceNeeded];
+	NSRect pageRect = NSInsetRect([obj bounds], -es.width, -es.height);
+
+	if (NSIsEmptyRect(pageRect) || pageRect.size.width > kDKVectorBufferMaxSide || pageRect.size.height > kDKVectorBufferMaxSide)
+		return NO;
+
+	// the stamp's zoom component is deliberately zero - vector replay is valid at any scale
+
+	DKRenderCacheKey stamp = DKRenderCacheKeyForObject(obj, [obj renderingPath], 0.0);
+	NSDictionary* slot = [sVectorBufferCache objectForKey:obj];
+	CGPDFDocumentRef doc = (__bridge CGPDFDocumentRef)slot[@"document"];
+
+	BOOL valid = NO;
+
+	if (slot != nil) {
+		DKRenderCacheKey prev;
+		[(NSValue*)slot[@"stamp"] getValue:&prev];
+		valid = DKRenderCacheKeyEqual(prev, stamp);
+	}
+
+	if (!valid) {
+		// while tracking, rebuilding a stale buffer would cost more than direct drawing saves
+
+		if ([obj useLowQualityDrawing])
+			return NO;
+
+		doc = [self recordVectorBufferForObject:obj
+									   pageRect:pageRect];
+
+		if (doc == NULL) {
+			[sVectorBufferCache removeObjectForKey:obj];
+			return NO;
+		}
+
+		if (sVectorBufferCache == nil)
+			sVectorBufferCache = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+														   valueOptions:NSPointerFunctionsStrongMemory
+															   capacity:8];
+
+		[sVectorBufferCache setObject:@{ @"document": CFBridgingRelease(doc),
+			@"stamp": [NSValue value:&stamp
+						withObjCType:@encode(DKRenderCacheKey)] }
+							   forKey:obj];
+	}
+
+	CGPDFPageRef page = CGPDFDocumentGetPage(doc, 1);
+
+	if (page == NULL)
+		return NO;
+
+	CGContextRef ctx = [[NSGraphicsContext currentContext] graphicsPort];
+
+	CGContextSaveGState(ctx);
+
+	// recording mirrored the y-axis about the page rect so flipped-view coordinates land upright
+	// on the page - mirror again here so replay puts everything back where it was drawn
+
+	CGContextTranslateCTM(ctx, 0.0, NSMinY(pageRect) + NSMaxY(pageRect));
+	CGContextScaleCTM(ctx, 1.0, -1.0);
+	CGContextDrawPDFPage(ctx, page);
+	CGContextRestoreGState(ctx);
+
+	return YES;
+}
+
+/** @brief Plays the style's render list into a fresh single-page PDF context covering pageRect
+
+ The page is flipped to match the view coordinates the rasterizers emit. Returns a +1 document, or
+ \c NULL if the recording could not be built.
+ */
+- (CGPDFDocumentRef)recordVectorBufferForObject:(id<DKRenderable>)object pageRect:(NSRect)pageRect
+{
+	NSMutableData* pdfData = [NSMutableData data];
+	CGDataConsumerRef consumer = CGDataConsumerCreateWithCFData((__bridge CFMutableDataRef)pdfData);
+
+	if (consumer == NULL)
+		return NULL;
+
+	CGRect mediaBox = NSRectToCGRect(pageRect);
+	CGContextRef pdfContext = CGPDFContextCreate(consumer, &mediaBox, NULL);
+	CGDataConsumerRelease(consumer);
+
+	if (pdfContext == NULL)
+		return NULL;
+
+	CGPDFContextBeginPage(pdfContext, NULL);
+	CGContextTranslateCTM(pdfContext, 0.0, NSMinY(pageRect) + NSMaxY(pageRect));
+	CGContextScaleCTM(pdfContext, 1.0, -1.0);
+
+	NSGraphicsContext* savedContext = [NSGraphicsContext currentContext];
+	[NSGraphicsContext setCurrentContext:[NSGraphicsContext graphicsContextWithGraphicsPort:pdfContext
+																					flipped:YES]];
+
+	@try {
+		[super render:object];
+	}
+	@catch (NSException* exception) {
+		LogEvent_(kWheneverEvent, @"exception while recording vector buffer for %@ - %@", object, exception);
+	}
+
+	[[NSGraphicsContext currentContext] flushGraphics];
+	[NSGraphicsContext setCurrentContext:savedContext];
+
+	CGPDFContextEndPage(pdfContext);
+	CGPDFContextClose(pdfContext);
+	CGContextRelease(pdfContext);
+
+	CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)pdfData);
+
+	if (provider == NULL)
+		return NULL;
+
+	CGPDFDocumentRef doc = CGPDFDocumentCreateWithProvider(provider);
+	CGDataProviderRelease(provider);
+
+	return doc;
+}
+
 /** @brief Renders the object using this style
 
  Sets the value of the client for the duration of rendering */
@@ -1356,6 +1740,7 @@ static BOOL sSubstitute = NO;
 
 	if ([self enabled]) {
 		@autoreleasepool {
+			DK_SIGNPOST_BEGIN("DKStyle render", self, "%{public}@", [self name]);
 
 			if (![[self class] shouldAntialias] && [NSGraphicsContext currentContextDrawingToScreen]) {
 				[[NSGraphicsContext currentContext] setShouldAntialias:NO];
@@ -1365,7 +1750,18 @@ static BOOL sSubstitute = NO;
 			m_renderClientRef = object;
 
 			@try {
-				[super render:object];
+				if ([self shouldRenderPlaceholderForObject:object])
+					[self renderPlaceholderForObject:object];
+				else if (![self renderVectorBufferForObject:object]) {
+					// only the full rasterizer run is measured - placeholder and buffer-replay draws
+					// are excluded so the cost score reflects what the style genuinely costs
+
+					uint64_t startNanos = DKPerfUptimeNanos();
+
+					[super render:object];
+
+					[self recordRenderTimeNanos:DKPerfUptimeNanos() - startNanos];
+				}
 			}
 			@catch (NSException* exception) {
 				// exceptions thrown during drawing can cause a lot of problems that multiply a minor bug into a major one.
@@ -1376,10 +1772,115 @@ static BOOL sSubstitute = NO;
 				NSLog(@"An exception occurred while rendering the style - PLEASE FIX - %@. Exception = %@", self, exception);
 			}
 			m_renderClientRef = nil;
+
+			// the object's render is over - everything the rasterizers borrowed from the per-thread
+			// scratch pool becomes reusable in one step
+
+			[DKRasterizer recycleScratchPaths];
+			DK_SIGNPOST_END("DKStyle render", self);
 		}
 	}
 }
 
+/** @brief Whether this render pass should draw the degraded placeholder tier instead of the render list
+
+ Applies when the global substitution flag is set, or when this style has measured itself over the
+ render time budget and the fast tier is active. Non-screen (print/export) output is never degraded.
+ */
+- (BOOL)shouldRenderPlaceholderForObject:(id<DKRenderable>)object
+{
+	if (![NSGraphicsContext currentContextDrawingToScreen])
+		return NO;
+
+	if (sSubstitute)
+		return YES;
+
+	// an over-budget style only degrades while low quality drawing is in effect - during tool
+	// gestures and rapid redraws - so static views always show the real style
+
+	return [self exceedsRenderTimeBudget] && [object useLowQualityDrawing];
+}
+
+/** @brief Draws a single simple stroke in place of the style's components
+
+ The style's own first stroke supplies the colour and weight where one exists, so the placeholder
+ remains recognisable; otherwise a default thin grey stroke is used.
+ */
+- (void)renderPlaceholderForObject:(id<DKRenderable>)object
+{
+	NSBezierPath* path = [object renderingPath];
+
+	if (path == nil || [path isEmpty])
+		return;
+
+	NSArray* strokes = [self renderersOfClass:[DKStroke class]];
+
+	if ([strokes count] > 0) {
+		DKStroke* stroke = [strokes objectAtIndex:0];
+
+		[[stroke colour] setStroke];
+		[path setLineWidth:[stroke width]];
+	} else {
+		[[NSColor grayColor] setStroke];
+		[path setLineWidth:1.0];
+	}
+
+	[path stroke];
+}
+
+/** @brief Folds one measured render into the style's cost score and polices the budget
+
+ Keeps an exponential moving average so the score settles quickly but ignores one-off spikes
+ (cache warm-up, paging). When budgeting is enabled and the score first crosses the budget, the
+ over-budget notification is posted once, on the main queue so observers never run mid-draw;
+ it re-arms when the score falls back below half the budget.
+ */
+- (void)recordRenderTimeNanos:(uint64_t)nanos
+{
+	NSTimeInterval seconds = (NSTimeInterval)nanos * 1.0e-9;
+
+	if (mRenderCostSamples == 0)
+		mRenderCostEMA = seconds;
+	else
+		mRenderCostEMA += (seconds - mRenderCostEMA) * kDKRenderCostEMAWeight;
+
+	++mRenderCostSamples;
+
+	if (sRenderTimeBudget > 0.0) {
+		if ([self exceedsRenderTimeBudget]) {
+			if (!mBudgetExceededNotified) {
+				mBudgetExceededNotified = YES;
+
+				NSTimeInterval cost = mRenderCostEMA;
+
+				dispatch_async(dispatch_get_main_queue(), ^{
+					[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleRenderTimeExceededBudgetNotification
+																		object:self
+																	  userInfo:@{ kDKStyleRenderTimeUserInfoKey: @(cost) }];
+				});
+
+				LogEvent_(kInfoEvent, @"style '%@' exceeded the render budget: %.2fms per object (budget %.2fms)", [self name], mRenderCostEMA * 1000.0, sRenderTimeBudget * 1000.0);
+			}
+		} else if (mRenderCostEMA < sRenderTimeBudget * 0.5)
+			mBudgetExceededNotified = NO;
+	}
+}
+
+- (NSTimeInterval)averageRenderTime
+{
+	return mRenderCostEMA;
+}
+
+- (NSUInteger)renderCostSampleCount
+{
+	return mRenderCostSamples;
+}
+
+- (BOOL)exceedsRenderTimeBudget
+{
+	return sRenderTimeBudget > 0.0 && mRenderCostSamples >= kDKRenderCostMinimumSamples && mRenderCostEMA > sRenderTimeBudget;
+}
+
 /** @brief Sets the style's name undoably
 
  Does not inform the client(s) as this is not typically a visual change, but does send a notification */
@@ -1434,6 +1935,8 @@ static BOOL sSubstitute = NO;
 	sShouldDrawShadows = ![[NSUserDefaults standardUserDefaults] boolForKey:kDKStyleDisplayPerformance_no_shadows];
 	sAntialias = ![[NSUserDefaults standardUserDefaults] boolForKey:kDKStyleDisplayPerformance_no_anti_aliasing];
 	sSubstitute = [[NSUserDefaults standardUserDefaults] boolForKey:kDKStyleDisplayPerformance_substitute_styles];
+	sRetainVectorBuffers = [[NSUserDefaults standardUserDefaults] boolForKey:kDKStyleDisplayPerformance_retained_vectors];
+	sRenderTimeBudget = MAX([[NSUserDefaults standardUserDefaults] doubleForKey:kDKStyleDisplayPerformance_render_budget], 0.0);
 }
 
 - (void)dealloc
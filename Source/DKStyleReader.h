@@ -11,12 +11,29 @@
 
 @interface DKStyleReader : DKEvaluator {
 	DKParser* mParser;
+	NSString* mCompiledScriptCachePath; // folder holding compiled copies of parsed scripts, nil disables caching
 }
 
 - (id)evaluateScript:(NSString*)script;
+
+/** @brief Parse the script file at the given path, reusing a compiled copy where possible.
+
+ The first time a given script is parsed its expression tree is archived into the compiled
+ script cache, keyed by a hash of the source. Subsequent reads of the same (unmodified) source
+ recover the tree with a single file read, bypassing the parser entirely. Editing the source
+ changes its hash, so a stale cache entry is simply never hit again.
+ */
 - (id)readContentsOfFile:(NSString*)filenamet;
 - (void)loadBuiltinSymbols;
 
 - (void)registerClass:(id)aClass withShortName:(NSString*)sym;
 
+/** @brief Set the folder where compiled scripts are cached
+
+ Defaults to a DrawKit folder inside the user's caches directory. Set \c nil to disable the
+ cache altogether, in which case every read runs the parser.
+ */
+- (void)setCompiledScriptCachePath:(NSString*)path;
+- (NSString*)compiledScriptCachePath;
+
 @end
@@ -8,9 +8,19 @@
 #import "DKStyleReader.h"
 
 #import "DKExpression.h"
+#import "DKImageDataManager.h"
 #import "DKParser.h"
 #import "DKScriptingAdditions.h"
 
+#pragma mark Constants
+static NSString* const kDKCompiledScriptFileExtension = @"dkexpr";
+
+@interface DKStyleReader ()
+
+- (NSString*)compiledPathForScriptData:(NSData*)data;
+
+@end
+
 @implementation DKStyleReader
 #pragma mark As a DKStyleReader
 
@@ -22,7 +32,66 @@
 
 - (id)readContentsOfFile:(NSString*)filename;
 {
-	return [mParser parseContentsOfFile:filename];
+	NSData* source = [NSData dataWithContentsOfFile:filename];
+
+	if (source == nil)
+		return nil;
+
+	// if a compiled copy of this exact source is cached, a single read recovers the expression tree
+	// without running the parser at all
+
+	NSString* compiledPath = [self compiledPathForScriptData:source];
+
+	if (compiledPath != nil && [[NSFileManager defaultManager] fileExistsAtPath:compiledPath]) {
+		@try {
+			id expr = [NSKeyedUnarchiver unarchiveObjectWithFile:compiledPath];
+
+			if (expr != nil)
+				return expr;
+		}
+		@catch (NSException* excp) {
+			// a damaged cache entry is harmless - fall through and reparse the source
+		}
+	}
+
+	id expr = [mParser parseContentsOfFile:filename];
+
+	if (expr != nil && compiledPath != nil)
+		[NSKeyedArchiver archiveRootObject:expr
+									toFile:compiledPath];
+
+	return expr;
+}
+
+- (void)setCompiledScriptCachePath:(NSString*)path
+{
+	[path retain];
+	[mCompiledScriptCachePath release];
+	mCompiledScriptCachePath = path;
+}
+
+- (NSString*)compiledScriptCachePath
+{
+	return mCompiledScriptCachePath;
+}
+
+- (NSString*)compiledPathForScriptData:(NSData*)data
+{
+	NSString* folder = [self compiledScriptCachePath];
+
+	if (folder == nil)
+		return nil;
+
+	if (![[NSFileManager defaultManager] createDirectoryAtPath:folder
+								   withIntermediateDirectories:YES
+													attributes:nil
+														 error:NULL])
+		return nil;
+
+	// the file is named for a hash of the source, so an edited script never hits a stale entry
+
+	NSString* name = [[data hash64String] stringByAppendingPathExtension:kDKCompiledScriptFileExtension];
+	return [folder stringByAppendingPathComponent:name];
 }
 
 - (void)loadBuiltinSymbols
@@ -153,6 +222,7 @@
 - (void)dealloc
 {
 	[mParser release];
+	[mCompiledScriptCachePath release];
 
 	[super dealloc];
 }
@@ -170,6 +240,17 @@
 	}
 	if (self != nil) {
 		[self loadBuiltinSymbols];
+
+		NSString* cacheRoot = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+
+		if (cacheRoot != nil) {
+			NSString* appID = [[NSBundle mainBundle] bundleIdentifier];
+
+			if (appID == nil)
+				appID = @"DrawKit";
+
+			mCompiledScriptCachePath = [[[cacheRoot stringByAppendingPathComponent:appID] stringByAppendingPathComponent:@"Compiled Style Scripts"] retain];
+		}
 	}
 	return self;
 }
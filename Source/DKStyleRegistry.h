@@ -6,6 +6,7 @@
 
 #import <Cocoa/Cocoa.h>
 #import "DKCategoryManager.h"
+#import "DKStyle.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -116,7 +117,11 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  Cut/Paste: cut and paste of styles works independently of the registry, including dealing with shared styles. See DKStyle for more info.
 */
 @interface DKStyleRegistry : DKCategoryManager <DKStyle*>
-<DKCategoryManagerMenuItemDelegate>
+<DKCategoryManagerMenuItemDelegate> {
+@private
+	NSMutableDictionary<NSNumber*, NSMutableSet<NSString*>*>* mStructuralIndex; // structural hash -> keys of registered styles having it
+	BOOL mStructuralIndexValid; // NO after any mutation; the index is rebuilt lazily on next use
+}
 
 	// retrieving the registry and styles
 
@@ -146,6 +151,19 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 + (nullable DKStyle*)styleForKeyAddingToRecentlyUsed:(NSString*)styleID;
 
+/** @brief Return a registered style that has the same visual structure as the given style.
+
+ Looks the style up by its structural hash (see <code>-[DKStyle structuralHash]</code>) rather than
+ its key, so a registered style that draws identically is found in constant time regardless of the
+ registry's size; a full structural comparison is run only on hash collisions. Used during merges to
+ avoid multiplying the registry with structurally identical entries, and available to clients that
+ want to intern document styles against the registry by content.
+ @param aStyle The style to match. Need not be registered.
+ @return A registered style structurally equal to <code>aStyle</code> (never \c aStyle itself),
+ or \c nil if there is none.
+ */
++ (nullable DKStyle*)registeredStyleMatchingStructureOfStyle:(DKStyle*)aStyle;
+
 // registering a style
 
 /** @brief Register the style with the registry
@@ -241,6 +259,22 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 + (NSDictionary<NSString*, NSNumber*>*)compareStylesInSet:(NSSet<DKStyle*>*)styles;
 
+/** @brief Substitute already-interned instances for structurally equal styles in the set.
+
+ Every document that embeds copies of the same styles dearchives its own instances, each carrying its
+ own rasterizer tree and caches. This process-wide service keeps a weak table of previously seen
+ locked styles keyed by unique key and modification timestamp - the same identity that
+ <code>-isEqualToStyle:</code> tests - and, for each style in the set that exactly matches an entry
+ loaded earlier by another document, returns the earlier instance. Styles with no match are entered
+ into the table as the canonical instance for their identity. Unlocked (editable) styles are never
+ interned, since shared mutation would leak between documents. The table holds its styles weakly, so
+ interned styles die with the last document using them.
+ @param styles The styles loaded by a document, typically its \c -allStyles set.
+ @return The interned instances that should replace equal styles in the caller's structure, suitable for
+ passing to <code>-replaceMatchingStylesFromSet:</code>. Can be nil if there is nothing to replace.
+ */
++ (nullable NSSet<DKStyle*>*)internStylesInSet:(NSSet<DKStyle*>*)styles;
+
 // high-level data access
 
 /** @brief Return the entire list of keys of the styles in the registry.
@@ -320,6 +354,15 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 - (nullable DKStyle*)styleForKey:(NSString*)styleID;
 
+/** @brief Return a registered style with the same visual structure as <code>aStyle</code>, if any.
+
+ See <code>+registeredStyleMatchingStructureOfStyle:</code>. The structural index is rebuilt lazily
+ after the registry has changed, then kept until the next change.
+ @param aStyle The style to match. Need not be registered.
+ @return A structurally equal registered style (never \c aStyle itself), or \c nil.
+ */
+- (nullable DKStyle*)styleMatchingStructureOfStyle:(DKStyle*)aStyle;
+
 /** @brief Return the set of styles in the given categories.
 
  Being a set, the result is unordered. The result may be the empty set if the categories are unknown
@@ -433,6 +476,41 @@ typedef NS_ENUM(NSInteger, DKStyleCompare) {
  */
 - (NSMenu*)managedStylesMenuWithItemTarget:(nullable id)target itemAction:(nullable SEL)selector;
 
+// asynchronous swatch service:
+
+/** @brief Returns a swatch for the registered style without ever blocking on rendering.
+
+ If the swatch has already been rendered into the registry's atlas it is returned directly. Otherwise a
+ neutral placeholder image is returned immediately and the real swatch is rendered on a background queue
+ from a snapshot of the style; once it has been stored in the atlas, \c kDKStyleRegistrySwatchDidUpdateNotification
+ is posted on the main thread with the style's key under \c kDKStyleRegistrySwatchStyleKey in the user info.
+ A UI showing many styles can therefore draw placeholders, observe the notification and redraw the affected
+ item, at which point this method returns the finished swatch. Swatches are keyed by the style's
+ \c -swatchCacheKeyForSize:type: so each size/type combination is rendered once.
+ @param styleID The unique key of a registered style.
+ @param size The swatch size required.
+ @param type The swatch type, as for <code>-styleSwatchWithSize:type:</code>.
+ @return The rendered swatch if available, otherwise a placeholder.
+ */
+- (nullable NSImage*)styleSwatchForKey:(NSString*)styleID size:(NSSize)size type:(DKStyleSwatchType)type;
+
+/** @brief Returns the swatch for the style from the atlas if it has been rendered, without triggering generation.
+ */
+- (nullable NSImage*)cachedStyleSwatchForKey:(NSString*)styleID size:(NSSize)size type:(DKStyleSwatchType)type;
+
+/** @brief Writes the swatch atlas to a file so that a subsequent launch can show real swatches immediately.
+
+ \c -writeToFile:atomically: calls this automatically, saving the atlas alongside the registry archive with
+ the extension "swatches" appended to the registry's path.
+ */
+- (BOOL)writeSwatchAtlasToFile:(NSString*)path atomically:(BOOL)atom;
+
+/** @brief Restores a swatch atlas previously saved by <code>-writeSwatchAtlasToFile:atomically:</code>.
+
+ \c -readFromFile:mergeOptions:mergeDelegate: calls this automatically with the companion path.
+ */
+- (BOOL)readSwatchAtlasFromFile:(NSString*)path;
+
 @end
 
 // default registry category names:
@@ -453,6 +531,10 @@ extern NSNotificationName const kDKStyleRegistryDidFlagPossibleUIChange;
 extern NSNotificationName const kDKStyleWasRegisteredNotification;
 extern NSNotificationName const kDKStyleWasRemovedFromRegistryNotification;
 extern NSNotificationName const kDKStyleWasEditedWhileRegisteredNotification;
+extern NSNotificationName const kDKStyleRegistrySwatchDidUpdateNotification;
+
+/** user info key carrying the style's unique key in \c kDKStyleRegistrySwatchDidUpdateNotification */
+extern NSString* const kDKStyleRegistrySwatchStyleKey;
 
 /** @brief Protocol allows the delegate to decide which of a pair of styles should be used
  */
@@ -28,6 +28,13 @@ NSString* const kDKStyleRegistryDidFlagPossibleUIChange = @"kDKStyleRegistryDidF
 NSString* const kDKStyleWasRegisteredNotification = @"kDKDrawingStyleWasRegisteredNotification";
 NSString* const kDKStyleWasRemovedFromRegistryNotification = @"kDKDrawingStyleWasRemovedFromRegistryNotification";
 NSString* const kDKStyleWasEditedWhileRegisteredNotification = @"kDKStyleWasEditedWhileRegisteredNotifcation";
+NSString* const kDKStyleRegistrySwatchDidUpdateNotification = @"kDKStyleRegistrySwatchDidUpdateNotification";
+
+NSString* const kDKStyleRegistrySwatchStyleKey = @"key";
+
+// each atlas sheet is a square bitmap this many pixels on a side; sheets are added as cells fill up
+
+#define kDKSwatchAtlasSheetSize 1024
 
 #pragma mark -
 #pragma mark special private category on DKStyle gives the registry extra privileges.
@@ -46,6 +53,188 @@ NSString* const kDKStyleWasEditedWhileRegisteredNotification = @"kDKStyleWasEdit
 
 @end
 
+#pragma mark -
+#pragma mark swatch atlas
+
+// the atlas packs swatches of one cell size into large shared bitmap sheets, so that thousands of swatches
+// occupy a handful of contiguous bitmaps instead of thousands of small NSImages. Individual swatches are
+// returned as lightweight images backed by a subregion of a sheet. The atlas can round-trip through a
+// dictionary representation so the registry can persist it alongside its own archive.
+
+@interface DKStyleSwatchAtlas : NSObject {
+@private
+	NSMutableArray<NSBitmapImageRep*>* mSheets; // bitmap sheets holding the swatch cells
+	NSMutableDictionary<NSString*, NSArray*>* mCells; // swatch key -> [sheet index, cell rect string]
+	NSSize mCellSize;
+	NSUInteger mColumns; // cells across one sheet
+	NSUInteger mRowsPerSheet;
+	NSUInteger mNextCell; // next unused cell, counted across all sheets
+}
+
+- (instancetype)initWithCellSize:(NSSize)cellSize;
+- (instancetype)initWithDictionary:(NSDictionary*)dict;
+
+- (void)setSwatch:(NSImage*)swatch forKey:(NSString*)key;
+- (NSImage*)swatchForKey:(NSString*)key;
+- (void)removeSwatchesWithKeyPrefix:(NSString*)prefix;
+
+@property (readonly) NSDictionary* dictionaryRepresentation;
+
+@end
+
+@implementation DKStyleSwatchAtlas
+
+- (instancetype)initWithCellSize:(NSSize)cellSize
+{
+	self = [super init];
+	if (self != nil) {
+		mCellSize = cellSize;
+		mColumns = MAX((NSUInteger)1, (NSUInteger)(kDKSwatchAtlasSheetSize / cellSize.width));
+		mRowsPerSheet = MAX((NSUInteger)1, (NSUInteger)(kDKSwatchAtlasSheetSize / cellSize.height));
+		mSheets = [[NSMutableArray alloc] init];
+		mCells = [[NSMutableDictionary alloc] init];
+	}
+	return self;
+}
+
+- (instancetype)initWithDictionary:(NSDictionary*)dict
+{
+	self = [self initWithCellSize:NSSizeFromString([dict objectForKey:@"cellSize"])];
+	if (self != nil) {
+		mNextCell = [[dict objectForKey:@"nextCell"] unsignedIntegerValue];
+		[mCells addEntriesFromDictionary:[dict objectForKey:@"cells"]];
+
+		for (NSData* pngData in [dict objectForKey:@"sheets"]) {
+			NSBitmapImageRep* sheet = [NSBitmapImageRep imageRepWithData:pngData];
+
+			if (sheet == nil)
+				return nil;
+
+			[mSheets addObject:sheet];
+		}
+	}
+	return self;
+}
+
+- (NSBitmapImageRep*)newSheet
+{
+	NSUInteger pixWide = mColumns * (NSUInteger)mCellSize.width;
+	NSUInteger pixHigh = mRowsPerSheet * (NSUInteger)mCellSize.height;
+
+	return [[NSBitmapImageRep alloc] initWithBitmapDataPlanes:NULL
+												   pixelsWide:pixWide
+												   pixelsHigh:pixHigh
+												bitsPerSample:8
+											  samplesPerPixel:4
+													 hasAlpha:YES
+													 isPlanar:NO
+											   colorSpaceName:NSCalibratedRGBColorSpace
+												  bytesPerRow:0
+												 bitsPerPixel:0];
+}
+
+- (void)setSwatch:(NSImage*)swatch forKey:(NSString*)key
+{
+	NSUInteger cellsPerSheet = mColumns * mRowsPerSheet;
+	NSUInteger sheetIndex = mNextCell / cellsPerSheet;
+	NSUInteger cell = mNextCell % cellsPerSheet;
+
+	while (sheetIndex >= [mSheets count])
+		[mSheets addObject:[self newSheet]];
+
+	NSRect cellRect = NSMakeRect((cell % mColumns) * mCellSize.width, (cell / mColumns) * mCellSize.height, mCellSize.width, mCellSize.height);
+
+	NSGraphicsContext* ctx = [NSGraphicsContext graphicsContextWithBitmapImageRep:[mSheets objectAtIndex:sheetIndex]];
+
+	[NSGraphicsContext saveGraphicsState];
+	[NSGraphicsContext setCurrentContext:ctx];
+	[swatch drawInRect:cellRect
+			  fromRect:NSZeroRect
+			 operation:NSCompositeCopy
+			  fraction:1.0];
+	[NSGraphicsContext restoreGraphicsState];
+
+	[mCells setObject:@[@(sheetIndex), NSStringFromRect(cellRect)]
+			   forKey:key];
+	++mNextCell;
+}
+
+- (NSImage*)swatchForKey:(NSString*)key
+{
+	NSArray* entry = [mCells objectForKey:key];
+
+	if (entry == nil)
+		return nil;
+
+	NSBitmapImageRep* sheet = [mSheets objectAtIndex:[[entry objectAtIndex:0] unsignedIntegerValue]];
+	NSRect cellRect = NSRectFromString([entry objectAtIndex:1]);
+
+	// CGImage space puts the origin at the top-left, whereas the cell was drawn with a bottom-left origin
+
+	CGRect cgRect = CGRectMake(NSMinX(cellRect), [sheet pixelsHigh] - NSMaxY(cellRect), NSWidth(cellRect), NSHeight(cellRect));
+	CGImageRef cellImage = CGImageCreateWithImageInRect([sheet CGImage], cgRect);
+
+	if (cellImage == NULL)
+		return nil;
+
+	NSImage* image = [[NSImage alloc] initWithCGImage:cellImage
+												 size:mCellSize];
+	CGImageRelease(cellImage);
+
+	return image;
+}
+
+- (void)removeSwatchesWithKeyPrefix:(NSString*)prefix
+{
+	// unmaps any cells whose key begins with <prefix> (i.e. all size/type variants for one style). The cells
+	// themselves are not reclaimed - a subsequent render for the key occupies a fresh cell - but the mapping
+	// removal is what makes the stale swatch unreachable.
+
+	NSMutableArray* doomedKeys = [NSMutableArray array];
+
+	for (NSString* key in mCells) {
+		if ([key hasPrefix:prefix])
+			[doomedKeys addObject:key];
+	}
+
+	[mCells removeObjectsForKeys:doomedKeys];
+}
+
+- (NSDictionary*)dictionaryRepresentation
+{
+	NSMutableArray* sheetData = [NSMutableArray arrayWithCapacity:[mSheets count]];
+
+	for (NSBitmapImageRep* sheet in mSheets)
+		[sheetData addObject:[sheet representationUsingType:NSPNGFileType
+												 properties:@{}]];
+
+	return @{ @"cellSize": NSStringFromSize(mCellSize),
+		@"nextCell": @(mNextCell),
+		@"cells": mCells,
+		@"sheets": sheetData };
+}
+
+@end
+
+#pragma mark -
+
+@interface DKStyleRegistry () {
+	NSMutableDictionary<NSString*, DKStyleSwatchAtlas*>* mSwatchAtlases; // one atlas per swatch size
+	NSMutableSet<NSString*>* mPendingSwatchKeys; // swatches currently being rendered
+	dispatch_queue_t mSwatchRenderQueue;
+}
+
+- (DKStyleSwatchAtlas*)swatchAtlasForSize:(NSSize)size;
++ (NSImage*)placeholderSwatchWithSize:(NSSize)size;
+
+/** rebuilds the structural hash index over the registered styles if it has been invalidated */
+- (void)rebuildStructuralIndexIfNeeded;
+
+/** marks the structural index stale; called whenever the registry's contents change */
+- (void)invalidateStructuralIndex;
+
+@end
+
 #pragma mark -
 
 @implementation DKStyleRegistry
@@ -118,6 +307,11 @@ static BOOL s_NoDKDefaults = NO;
 	return rs;
 }
 
++ (DKStyle*)registeredStyleMatchingStructureOfStyle:(DKStyle*)aStyle
+{
+	return [[self sharedStyleRegistry] styleMatchingStructureOfStyle:aStyle];
+}
+
 /** @brief Register the style with the registry
 
  This method registers styles in the "All User Styles" category only. If the style is already registered
@@ -211,7 +405,9 @@ static BOOL s_NoDKDefaults = NO;
  See notes for registerStyle:
  if the categories do not exist they are created. Note that the "recently added" list is temporarily
  disabled by this method, reflecting the intention that it is used for pre-registering a number of
- styles in bulk.
+ styles in bulk. The batch is handed to the category manager in a single operation, so the registry's
+ sorted views and any managed menus are updated once for the whole batch, and a single
+ kDKStyleWasRegisteredNotification is posted for it rather than one per style.
  @param styles an array of DKStyle objects to register
  @param styleCategories a list of one or more categories to list the style in (list of NSStrings)
  @param ignoreDupes if YES, styles whose names are already known are skipped.
@@ -220,26 +416,84 @@ static BOOL s_NoDKDefaults = NO;
 {
 	NSAssert(styles != nil, @"array of styles was nil - can't register");
 
-	NSArray* stNames = nil;
+	DKStyleRegistry* reg = [self sharedStyleRegistry];
+	NSAssert(reg != nil, @"cannot continue - registry could not be initialised");
+
+	[reg setRecentlyAddedListEnabled:NO];
+
+	// prepare the whole batch first - resolving name conflicts against both the registry and the
+	// batch itself - then add it in one go
 
-	[[self sharedStyleRegistry] setRecentlyAddedListEnabled:NO];
+	NSSet* preNames = ignoreDupes ? [NSSet setWithArray:[reg styleNames]] : nil;
+	NSMutableSet* usedNames = [NSMutableSet setWithArray:[reg styleNames]];
+	NSMutableArray* batch = [NSMutableArray arrayWithCapacity:[styles count]];
+	NSMutableArray* keys = [NSMutableArray arrayWithCapacity:[styles count]];
 
 	for (DKStyle* style in styles) {
-		if (ignoreDupes) {
-			if (stNames == nil) {
-				stNames = [[self sharedStyleRegistry] styleNames];
-			}
+		NSString* styleID = [style uniqueKey];
 
-			if ([stNames containsObject:[style name]]) {
-				continue;
-			}
+		if ([self styleForKey:styleID] != nil)
+			continue; // already registered, do nothing
+
+		if (ignoreDupes && [preNames containsObject:[style name]])
+			continue;
+
+		// the style needs to be unlocked in case we need to mutate its name - after registering it
+		// will be locked.
+
+		[style setLocked:NO];
+
+		NSString* name = [style name];
+
+		// if name not set or empty, give it a default name
+
+		if (name == nil || [name isEqualToString:@""])
+			name = NSLocalizedString(@"untitled style", @"untitled style name");
+
+		// make the name unique by appending digits, counting the batch as well as the registry
+
+		NSString* temp = name;
+		NSInteger numeral = 0;
+
+		while ([usedNames containsObject:temp])
+			temp = [NSString stringWithFormat:@"%@ %ld", name, (long)++numeral];
+
+		[style setName:temp];
+		[usedNames addObject:temp];
+
+		[batch addObject:style];
+		[keys addObject:styleID];
+	}
+
+	if ([batch count] > 0) {
+		[reg addObjects:batch
+				   forKeys:keys
+				toCategory:[styleCategories firstObject]
+			createCategory:YES];
+
+		// any additional categories are applied per key - multiple categories are rare, and the
+		// dominant costs (the default category and the first) have already been paid once
+
+		if ([styleCategories count] > 1) {
+			NSArray* rest = [styleCategories subarrayWithRange:NSMakeRange(1, [styleCategories count] - 1)];
+
+			for (NSString* key in keys)
+				[reg addKey:key
+						toCategories:rest
+					createCategories:YES];
 		}
 
-		[self registerStyle:style
-			   inCategories:styleCategories];
+		// lock the registered styles to prevent accidental edits, as -registerStyle:inCategories: does
+
+		for (DKStyle* style in batch)
+			[style setLocked:YES];
+
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleWasRegisteredNotification
+															object:reg];
+		[self setNeedsUIUpdate];
 	}
 
-	[[self sharedStyleRegistry] setRecentlyAddedListEnabled:YES];
+	[reg setRecentlyAddedListEnabled:YES];
 }
 
 /** @brief Remove the style from the registry
@@ -349,12 +603,27 @@ static BOOL s_NoDKDefaults = NO;
 				// existing registered styles unaffected but can massively multiply the registry with many duplicates. In general this
 				// options should be used sparingly, if at all.
 
-				// to make these look like new styles, the unique key must be reassigned. Normally this is disallowed, but the style registry
-				// has special privileges (and a special private method) to make it possible:
+				// before multiplying the registry, consult the structural index: if some registered
+				// style (this key's or any other's) already draws exactly what this one draws, a
+				// re-registration under a new key would be a pure duplicate, so it is skipped. The
+				// lookup is a hash hit plus a full comparison only on matching hashes.
+
+				DKStyle* structuralMatch = [[self sharedStyleRegistry] styleMatchingStructureOfStyle:style];
+
+				if (structuralMatch != nil) {
+					LogEvent_(kInfoEvent, @"not re-registering style '%@' - structurally identical to registered style '%@'", [style name], [structuralMatch name]);
+
+					[[self sharedStyleRegistry] addKey:[structuralMatch uniqueKey]
+										  toCategories:styleCategories
+									  createCategories:YES];
+				} else {
+					// to make these look like new styles, the unique key must be reassigned. Normally this is disallowed, but the style registry
+					// has special privileges (and a special private method) to make it possible:
 
-				[style reassignUniqueKey];
-				[self registerStyle:style
-					   inCategories:styleCategories];
+					[style reassignUniqueKey];
+					[self registerStyle:style
+						   inCategories:styleCategories];
+				}
 
 				// there's nothing to return in this case
 			}
@@ -417,6 +686,74 @@ static BOOL s_NoDKDefaults = NO;
 	return info;
 }
 
+/** @brief Substitute already-interned instances for structurally equal styles in the set
+
+ Process-wide dedup of immutable styles across documents. Each document dearchives its own copies of
+ the styles it embeds, every copy carrying a full rasterizer tree and its caches; with many documents
+ open that duplication adds up. A weak table keyed by unique key plus modification timestamp - the
+ same identity that -isEqualToStyle: tests - remembers the first locked instance seen for each
+ identity, and later loads of an exactly equal style get that instance back instead. Only locked
+ styles are interned; an editable style shared across documents would leak mutations between them.
+ @param styles the styles loaded by a document
+ @return the interned instances that should replace equal styles in the caller's structure, or nil
+ */
++ (NSSet*)internStylesInSet:(NSSet*)styles
+{
+	NSAssert(styles != nil, @"cannot intern a nil set of styles");
+
+	// the table holds its values weakly so that interned styles die with the last document using them
+
+	static NSMapTable<NSString*, DKStyle*>* sInternTable = nil;
+
+	if (sInternTable == nil)
+		sInternTable = [NSMapTable strongToWeakObjectsMapTable];
+
+	// a document can legitimately contain two different versions of a style with the same unique key
+	// (e.g. after kDKAddStylesAsNewVersions merges in its history). -replaceMatchingStylesFromSet:
+	// matches on the key alone, so such keys must be left alone entirely or the wrong version could
+	// be substituted somewhere in the document.
+
+	NSMutableDictionary<NSString*, DKStyle*>* byKey = [NSMutableDictionary dictionary];
+	NSMutableSet<NSString*>* ambiguousKeys = [NSMutableSet set];
+
+	for (DKStyle* style in styles) {
+		DKStyle* seen = [byKey objectForKey:[style uniqueKey]];
+
+		if (seen != nil && ![seen isEqualToStyle:style])
+			[ambiguousKeys addObject:[style uniqueKey]];
+		else
+			[byKey setObject:style
+					  forKey:[style uniqueKey]];
+	}
+
+	NSMutableSet* replacements = nil;
+
+	for (DKStyle* style in styles) {
+		if (![style locked] || [ambiguousKeys containsObject:[style uniqueKey]])
+			continue;
+
+		NSString* identity = [NSString stringWithFormat:@"%@_%.6f", [style uniqueKey], [style lastModificationTimestamp]];
+		DKStyle* canonical = [sInternTable objectForKey:identity];
+
+		if (canonical == nil || canonical == style) {
+			// first sighting of this identity (or the canonical instance itself) - record it
+
+			[sInternTable setObject:style
+							 forKey:identity];
+		} else if ([canonical isEqualToStyle:style] && [canonical locked]) {
+			if (replacements == nil)
+				replacements = [NSMutableSet set];
+
+			[replacements addObject:canonical];
+		}
+	}
+
+	if (replacements != nil)
+		LogEvent_(kInfoEvent, @"interning %lu duplicated style(s) across documents", (unsigned long)[replacements count]);
+
+	return replacements;
+}
+
 /** @brief Return the entire list of keys of the styles in the registry
  @return an array listing all of the keys in the registry
  */
@@ -603,6 +940,63 @@ static BOOL s_NoDKDefaults = NO;
 	return [self objectForKey:styleID];
 }
 
+- (DKStyle*)styleMatchingStructureOfStyle:(DKStyle*)aStyle
+{
+	if (aStyle == nil)
+		return nil;
+
+	[self rebuildStructuralIndexIfNeeded];
+
+	// the index narrows the candidates to the styles sharing the hash - almost always none or one.
+	// A full structural comparison confirms the hit, so a chance hash collision cannot match.
+
+	NSSet<NSString*>* candidateKeys = [mStructuralIndex objectForKey:@([aStyle structuralHash])];
+
+	for (NSString* key in candidateKeys) {
+		DKStyle* candidate = [self styleForKey:key];
+
+		if (candidate != nil && candidate != aStyle && [candidate isStructurallyEqualToStyle:aStyle])
+			return candidate;
+	}
+
+	return nil;
+}
+
+- (void)rebuildStructuralIndexIfNeeded
+{
+	if (mStructuralIndexValid && mStructuralIndex != nil)
+		return;
+
+	// one pass over the registered styles. Each style caches its own hash against its change
+	// generation, so rebuilding after a registration does not re-fingerprint the whole registry -
+	// only styles that actually changed recompute.
+
+	mStructuralIndex = [[NSMutableDictionary alloc] init];
+
+	for (DKStyle* style in [self allObjects]) {
+		if (![style isKindOfClass:[DKStyle class]])
+			continue;
+
+		NSNumber* hashKey = @([style structuralHash]);
+		NSMutableSet<NSString*>* keys = [mStructuralIndex objectForKey:hashKey];
+
+		if (keys == nil) {
+			keys = [NSMutableSet set];
+			[mStructuralIndex setObject:keys
+								 forKey:hashKey];
+		}
+
+		[keys addObject:[style uniqueKey]];
+	}
+
+	mStructuralIndexValid = YES;
+}
+
+- (void)invalidateStructuralIndex
+{
+	mStructuralIndexValid = NO;
+}
+
 /** @brief Return the set of styles in the given categories
 
  Being a set, the result is unordered. The result may be the empty set if the categories are unknown
@@ -691,6 +1085,12 @@ static BOOL s_NoDKDefaults = NO;
 		result = [data writeToFile:path
 						atomically:atom];
 
+	// save the swatch atlas alongside, so the next launch can show finished swatches without re-rendering
+
+	if (result)
+		[self writeSwatchAtlasToFile:[path stringByAppendingPathExtension:@"swatches"]
+						  atomically:atom];
+
 	return result;
 }
 
@@ -753,6 +1153,11 @@ static BOOL s_NoDKDefaults = NO;
 		}
 	}
 
+	// restore any swatch atlas that was saved alongside the registry
+
+	if (readOK)
+		[self readSwatchAtlasFromFile:[path stringByAppendingPathExtension:@"swatches"]];
+
 	return readOK;
 }
 
@@ -800,6 +1205,168 @@ static BOOL s_NoDKDefaults = NO;
 	return readOK;
 }
 
+#pragma mark -
+#pragma mark - asynchronous swatch service
+
+- (DKStyleSwatchAtlas*)swatchAtlasForSize:(NSSize)size
+{
+	if (mSwatchAtlases == nil)
+		mSwatchAtlases = [[NSMutableDictionary alloc] init];
+
+	NSString* sizeKey = NSStringFromSize(size);
+	DKStyleSwatchAtlas* atlas = [mSwatchAtlases objectForKey:sizeKey];
+
+	if (atlas == nil) {
+		atlas = [[DKStyleSwatchAtlas alloc] initWithCellSize:size];
+		[mSwatchAtlases setObject:atlas
+						   forKey:sizeKey];
+	}
+
+	return atlas;
+}
+
++ (NSImage*)placeholderSwatchWithSize:(NSSize)size
+{
+	// a neutral image shown while the real swatch is being rendered. One is cached per requested size.
+
+	static NSMutableDictionary* sPlaceholders = nil;
+
+	if (sPlaceholders == nil)
+		sPlaceholders = [[NSMutableDictionary alloc] init];
+
+	NSString* sizeKey = NSStringFromSize(size);
+	NSImage* placeholder = [sPlaceholders objectForKey:sizeKey];
+
+	if (placeholder == nil) {
+		placeholder = [[NSImage alloc] initWithSize:size];
+
+		[placeholder lockFocus];
+		[[NSColor colorWithCalibratedWhite:0.9
+									 alpha:1.0] set];
+		NSRectFill(NSMakeRect(0, 0, size.width, size.height));
+		[[NSColor colorWithCalibratedWhite:0.75
+									 alpha:1.0] set];
+		NSFrameRect(NSMakeRect(0, 0, size.width, size.height));
+		[placeholder unlockFocus];
+
+		[sPlaceholders setObject:placeholder
+						  forKey:sizeKey];
+	}
+
+	return placeholder;
+}
+
+- (NSImage*)styleSwatchForKey:(NSString*)styleID size:(NSSize)size type:(DKStyleSwatchType)type
+{
+	DKStyle* style = [self styleForKey:styleID];
+
+	if (style == nil)
+		return nil;
+
+	NSString* atlasKey = [NSString stringWithFormat:@"%@_%@", styleID, [style swatchCacheKeyForSize:size
+																							   type:type]];
+	NSImage* swatch = [[self swatchAtlasForSize:size] swatchForKey:atlasKey];
+
+	if (swatch != nil)
+		return swatch;
+
+	// not rendered yet - kick off a background render (once per key) and return a placeholder. The style is
+	// snapshotted with a mutable copy so the render never races a mutation of the shared original.
+
+	if (mPendingSwatchKeys == nil)
+		mPendingSwatchKeys = [[NSMutableSet alloc] init];
+
+	if (![mPendingSwatchKeys containsObject:atlasKey]) {
+		[mPendingSwatchKeys addObject:atlasKey];
+
+		if (mSwatchRenderQueue == NULL)
+			mSwatchRenderQueue = dispatch_queue_create("net.apptree.drawkit.swatchrender", DISPATCH_QUEUE_SERIAL);
+
+		DKStyle* snapshot = [style mutableCopy];
+
+		dispatch_async(mSwatchRenderQueue, ^{
+			NSImage* rendered = [snapshot styleSwatchWithSize:size
+														 type:type];
+
+			dispatch_async(dispatch_get_main_queue(), ^{
+				if (rendered != nil)
+					[[self swatchAtlasForSize:size] setSwatch:rendered
+													   forKey:atlasKey];
+
+				[self->mPendingSwatchKeys removeObject:atlasKey];
+
+				[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleRegistrySwatchDidUpdateNotification
+																	object:self
+																  userInfo:@{ kDKStyleRegistrySwatchStyleKey: styleID }];
+			});
+		});
+	}
+
+	return [[self class] placeholderSwatchWithSize:size];
+}
+
+- (NSImage*)cachedStyleSwatchForKey:(NSString*)styleID size:(NSSize)size type:(DKStyleSwatchType)type
+{
+	DKStyle* style = [self styleForKey:styleID];
+
+	if (style == nil)
+		return nil;
+
+	NSString* atlasKey = [NSString stringWithFormat:@"%@_%@", styleID, [style swatchCacheKeyForSize:size
+																							   type:type]];
+	return [[self swatchAtlasForSize:size] swatchForKey:atlasKey];
+}
+
+- (BOOL)writeSwatchAtlasToFile:(NSString*)path atomically:(BOOL)atom
+{
+	NSAssert(path != nil, @"path can't be nil");
+
+	if ([mSwatchAtlases count] == 0)
+		return NO;
+
+	NSMutableDictionary* rep = [NSMutableDictionary dictionaryWithCapacity:[mSwatchAtlases count]];
+
+	[mSwatchAtlases enumerateKeysAndObjectsUsingBlock:^(NSString* sizeKey, DKStyleSwatchAtlas* atlas, BOOL* stop) {
+#pragma unused(stop)
+		[rep setObject:[atlas dictionaryRepresentation]
+				forKey:sizeKey];
+	}];
+
+	NSData* data = [NSKeyedArchiver archivedDataWithRootObject:rep];
+
+	return [data writeToFile:path
+				  atomically:atom];
+}
+
+- (BOOL)readSwatchAtlasFromFile:(NSString*)path
+{
+	NSAssert(path != nil, @"path can't be nil");
+
+	NSData* data = [NSData dataWithContentsOfFile:path];
+
+	if (data == nil)
+		return NO;
+
+	NSDictionary* rep = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+
+	if (![rep isKindOfClass:[NSDictionary class]])
+		return NO;
+
+	if (mSwatchAtlases == nil)
+		mSwatchAtlases = [[NSMutableDictionary alloc] init];
+
+	[rep enumerateKeysAndObjectsUsingBlock:^(NSString* sizeKey, NSDictionary* atlasRep, BOOL* stop) {
+#pragma unused(stop)
+		DKStyleSwatchAtlas* atlas = [[DKStyleSwatchAtlas alloc] initWithDictionary:atlasRep];
+
+		if (atlas != nil)
+			[self->mSwatchAtlases setObject:atlas
+									 forKey:sizeKey];
+	}];
+
+	return YES;
+}
+
 - (DKStyle*)mergeFromStyle:(DKStyle*)aStyle mergeDelegate:(id)aDel
 {
 	NSAssert(aStyle != nil, @"attempting to merge nil style");
@@ -856,6 +1423,10 @@ static BOOL s_NoDKDefaults = NO;
 			// that things haven't gone to plan if this doesn't take place, set the name of the old style to something different
 
 			[aStyle setName:@"Temp style - if you can read this the programmer forgot something!"];
+
+			// the merged style's structure changed under its existing key
+
+			[self invalidateStructuralIndex];
 		}
 	}
 	return existingStyle;
@@ -914,6 +1485,15 @@ static BOOL s_NoDKDefaults = NO;
 	if ([self styleForKey:key] == style) {
 		[self updateMenusForKey:key];
 
+		// the style's structure changed, so its slot in the structural index is stale
+
+		[self invalidateStructuralIndex];
+
+		// drop the style's atlased swatches, which are now stale - they re-render on the next request
+
+		for (DKStyleSwatchAtlas* atlas in [mSwatchAtlases allValues])
+			[atlas removeSwatchesWithKeyPrefix:key];
+
 		NSDictionary* userInfo = @{ @"style": style };
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDKStyleWasEditedWhileRegisteredNotification
 															object:self
@@ -977,6 +1557,48 @@ static BOOL s_NoDKDefaults = NO;
 	return [self styleNamesInCategory:catName];
 }
 
+// the structural index mirrors the registry's contents, so every mutation path marks it stale.
+// It is rebuilt lazily on the next structural lookup.
+
+- (void)addObject:(DKStyle*)obj forKey:(NSString*)name toCategory:(NSString*)catName createCategory:(BOOL)cg
+{
+	[super addObject:obj
+			  forKey:name
+		  toCategory:catName
+	  createCategory:cg];
+	[self invalidateStructuralIndex];
+}
+
+- (void)addObject:(DKStyle*)obj forKey:(NSString*)name toCategories:(NSArray*)catNames createCategories:(BOOL)cg
+{
+	[super addObject:obj
+			  forKey:name
+		toCategories:catNames
+	createCategories:cg];
+	[self invalidateStructuralIndex];
+}
+
+- (void)addObjects:(NSArray*)objects forKeys:(NSArray*)keys toCategory:(NSString*)catName createCategory:(BOOL)cg
+{
+	[super addObjects:objects
+			  forKeys:keys
+		   toCategory:catName
+	   createCategory:cg];
+	[self invalidateStructuralIndex];
+}
+
+- (void)removeObjectForKey:(NSString*)key
+{
+	[super removeObjectForKey:key];
+	[self invalidateStructuralIndex];
+}
+
+- (void)removeAllCategories
+{
+	[super removeAllCategories];
+	[self invalidateStructuralIndex];
+}
+
 /** @brief Return the filetype (for saving, etc)
 
  Subclasses should override to change the filetype used for specific examples of this object
@@ -27,6 +27,7 @@ typedef union pix_int {
 	NSPoint m_sa_centre;
 	CGFloat m_sa_startAngle;
 	NSInteger m_sa_img_width;
+	NSUInteger m_sa_stopsChecksum;
 	BOOL m_ditherColours;
 }
 
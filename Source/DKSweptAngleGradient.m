@@ -6,6 +6,7 @@
 
 #import "DKSweptAngleGradient.h"
 
+#import "DKDiskRenderCache.h"
 #import "DKGeometryUtilities.h"
 #import "DKRandom.h"
 #import "LogEvent.h"
@@ -14,6 +15,60 @@
 - (void)private_colorAtValue:(CGFloat)val components:(CGFloat*)components randomAccess:(BOOL)ra;
 @end
 
+/*
+ * SIMD evaluation support for the gradient image fill loop.
+ *
+ * Building the swept gradient image calls atan2() once per pixel, which dominates the cost of the first
+ * fill at any given size. When the compiler supports GNU vector extensions the non-dithered path instead
+ * evaluates eight pixels per step using a polynomial approximation of atan2 - the result only needs to
+ * resolve one part in m_sa_segments, so the approximation error is far below a segment. Define
+ * DK_SWEPT_GRADIENT_NO_SIMD to force the scalar code path.
+ */
+#if !defined(DK_SWEPT_GRADIENT_NO_SIMD) && (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define DK_SWEPT_GRADIENT_USE_SIMD 1
+#else
+#define DK_SWEPT_GRADIENT_USE_SIMD 0
+#endif
+
+#if DK_SWEPT_GRADIENT_USE_SIMD
+
+typedef float v8sf __attribute__((vector_size(32)));
+typedef int v8si __attribute__((vector_size(32)));
+
+/** Lanewise select: where <mask> is all-ones (a true vector comparison result), take <a>, else <b>. */
+static inline v8sf v8sf_select(v8si mask, v8sf a, v8sf b)
+{
+	return (v8sf)((mask & (v8si)a) | (~mask & (v8si)b));
+}
+
+/** Minimax polynomial for atan(z) on |z| <= 1, accurate to about 1e-6 radians. */
+static inline v8sf v8sf_atan(v8sf z)
+{
+	v8sf z2 = z * z;
+	return z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f + z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+/** atan2(y, x) reconstructed from the polynomial by octant reduction. Results lie in [-pi, pi]. */
+static inline v8sf v8sf_atan2(v8sf y, v8sf x)
+{
+	v8sf ax = (v8sf)((v8si)x & 0x7FFFFFFF);
+	v8sf ay = (v8sf)((v8si)y & 0x7FFFFFFF);
+
+	v8si swap = ay > ax;
+	v8sf num = v8sf_select(swap, ax, ay);
+	v8sf den = v8sf_select(swap, ay, ax) + 1.0e-20f; // keeps the centre pixel finite; its angle is arbitrary anyway
+
+	v8sf a = v8sf_atan(num / den);
+
+	a = v8sf_select(swap, (float)M_PI_2 - a, a);
+	a = v8sf_select(x < 0.f, (float)M_PI - a, a);
+	a = v8sf_select(y < 0.f, -a, a);
+
+	return a;
+}
+
+#endif /* DK_SWEPT_GRADIENT_USE_SIMD */
+
 #pragma mark -
 @implementation DKSweptAngleGradient
 #pragma mark As a DKSweptAngleGradient
@@ -114,23 +169,57 @@
 
 		unsigned int* p = (unsigned int*)buffer;
 
-		for (y = 0; y < height; ++y) {
-			for (x = 0; x < width; ++x) {
-				// need to know angle of x,y relative to centre point which gives us an index into the colour table
+#if DK_SWEPT_GRADIENT_USE_SIMD
+		if (!m_ditherColours) {
+			// process each scan row eight pixels at a time. Dithering stays on the scalar path below because
+			// it draws a fresh random number per pixel.
+
+			float colourScale = (float)((CGFloat)nColours / twopi);
+			const v8sf lane = { 0, 1, 2, 3, 4, 5, 6, 7 };
 
-				angle = atan2((CGFloat)y - cp.y, (CGFloat)x - cp.x) + M_PI;
-				colour = (NSUInteger)((angle * (CGFloat)nColours) / twopi);
+			for (y = 0; y < height; ++y) {
+				float fy = (float)y - (float)cp.y;
+				v8sf vy = { fy, fy, fy, fy, fy, fy, fy, fy };
 
-				// add a bit of random dither to the colour
+				for (x = 0; x + 8 <= width; x += 8) {
+					v8sf vx = lane + ((float)x - (float)cp.x);
+					v8sf vc = (v8sf_atan2(vy, vx) + (float)M_PI) * colourScale;
 
-				if (m_ditherColours)
-					colour = (NSInteger)(colour + [DKRandom randomPositiveOrNegativeNumber] * 2.0) % nColours;
+					for (NSUInteger i = 0; i < 8; ++i) {
+						colour = (NSUInteger)vc[i];
 
-				// write the colour to the image in one fell swoop
+						if (colour >= nColours)
+							colour = nColours - 1;
 
-				*p++ = colours[colour].pixel;
+						*p++ = colours[colour].pixel;
+					}
+				}
+
+				for (; x < width; ++x) {
+					angle = atan2((CGFloat)y - cp.y, (CGFloat)x - cp.x) + M_PI;
+					colour = MIN((NSUInteger)((angle * (CGFloat)nColours) / twopi), nColours - 1);
+					*p++ = colours[colour].pixel;
+				}
+			}
+		} else
+#endif
+			for (y = 0; y < height; ++y) {
+				for (x = 0; x < width; ++x) {
+					// need to know angle of x,y relative to centre point which gives us an index into the colour table
+
+					angle = atan2((CGFloat)y - cp.y, (CGFloat)x - cp.x) + M_PI;
+					colour = (NSUInteger)((angle * (CGFloat)nColours) / twopi);
+
+					// add a bit of random dither to the colour
+
+					if (m_ditherColours)
+						colour = (NSInteger)(colour + [DKRandom randomPositiveOrNegativeNumber] * 2.0) % nColours;
+
+					// write the colour to the image in one fell swoop
+
+					*p++ = colours[colour].pixel;
+				}
 			}
-		}
 
 		// convert to an image.
 
@@ -140,6 +229,26 @@
 	CGColorSpaceRelease(cSpace);
 }
 
+- (NSUInteger)colourStopsChecksum
+{
+	// cheap digest of the colour stops, used to invalidate the cached image when they are edited. Coarse
+	// quantisation is fine - the image only resolves the gradient into m_sa_segments discrete colours anyway.
+
+	NSUInteger sum = [self countOfColorStops];
+
+	for (DKColorStop* stop in [self colorStops]) {
+		NSColor* rgb = [[stop color] colorUsingColorSpaceName:NSCalibratedRGBColorSpace];
+
+		sum = (sum << 5) ^ (sum >> 3) ^ (NSUInteger)lround([stop position] * 8191.0);
+		sum = (sum << 5) ^ (sum >> 3) ^ (NSUInteger)lround([rgb redComponent] * 255.0);
+		sum = (sum << 5) ^ (sum >> 3) ^ (NSUInteger)lround([rgb greenComponent] * 255.0);
+		sum = (sum << 5) ^ (sum >> 3) ^ (NSUInteger)lround([rgb blueComponent] * 255.0);
+		sum = (sum << 5) ^ (sum >> 3) ^ (NSUInteger)lround([rgb alphaComponent] * 255.0);
+	}
+
+	return sum;
+}
+
 - (void)invalidateCache
 {
 	unsigned char* buffer;
@@ -147,6 +256,11 @@
 	if (m_sa_image) {
 		CGImageRelease(m_sa_image);
 		m_sa_image = NULL;
+	}
+
+	// an image restored from the disk render cache has no backing bitmap context
+
+	if (m_sa_bitmap) {
 		buffer = CGBitmapContextGetData(m_sa_bitmap);
 		free(buffer);
 		CGContextRelease(m_sa_bitmap);
@@ -175,6 +289,15 @@
 		inval = YES;
 	}
 
+	// the image bakes in the colour stops, so editing them must also rebuild it
+
+	NSUInteger csum = [self colourStopsChecksum];
+
+	if (csum != m_sa_stopsChecksum) {
+		m_sa_stopsChecksum = csum;
+		inval = YES;
+	}
+
 	if (m_sa_image != NULL && (rect.size.width > CGImageGetWidth(m_sa_image) || rect.size.height > CGImageGetHeight(m_sa_image)))
 		inval = YES;
 
@@ -185,7 +308,28 @@
 		m_sa_centre = p;
 		[self invalidateCache];
 		[self preloadColours];
-		[self createGradientImageWithRect:rect];
+
+		// the image is a pure function of segment count, stops, size and centre offset, so it can
+		// be banked on disk across launches. Dithered gradients draw fresh random numbers per
+		// pixel and are excluded - their output is not reproducible.
+
+		NSString* fingerprint = nil;
+
+		if (!m_ditherColours) {
+			fingerprint = [NSString stringWithFormat:@"DKSweptAngleGradient.%lu.%lu.%.1f.%.1f.%.1f.%.1f",
+													 (unsigned long)m_sa_segments, (unsigned long)csum,
+													 rect.size.width, rect.size.height,
+													 p.x - rect.origin.x, p.y - rect.origin.y];
+			m_sa_image = [[DKDiskRenderCache sharedCache] newImageForFingerprint:fingerprint];
+		}
+
+		if (m_sa_image == NULL) {
+			[self createGradientImageWithRect:rect];
+
+			if (fingerprint != nil && m_sa_image != NULL)
+				[[DKDiskRenderCache sharedCache] storeImage:m_sa_image
+											 forFingerprint:fingerprint];
+		}
 	}
 
 	// centre the image rect on <rect>, rotated to <sa>
@@ -43,6 +43,7 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat mFlowedTextPathInset; // inset the layout path by this much before laying out the text
 	BOOL mAllowIndefiniteWidth; // YES to allow unwrapped text to extend as much as it needs to horizontally
 	BOOL mLastLayoutFittedAllText; // flags whether most recent rendering drew all the text
+	BOOL mLODGreekingActive; // hysteresis state for automatic greeking - transient, not archived
 	CGFloat mVerticalPosition; // for proportional vertical text placement, this is the proportion 0..1 of the height
 	CGFloat mTextKnockoutDistance; // distance to extend path when drawing knockout; 0 = no knockout.
 	CGFloat mTextKnockoutStrokeWidth; // stroke width for text knockout, if any (0 = none)
@@ -62,6 +63,17 @@ NS_ASSUME_NONNULL_BEGIN
 @property (class, readonly, copy) NSString* defaultLabel;
 @property (class) CGFloat defaultMaximumVerticalOffset;
 
+/** @brief view scale below which text is automatically greeked
+
+ when the effective scale of the destination context at render time falls below this value, the adornment substitutes
+ the greeking layout manager for full text layout, so zooming out over a drawing with many labels stays responsive.
+ Full layout resumes only once the scale climbs 25% clear of the threshold (hysteresis), so a zoom animation that
+ straddles the threshold never performs full text layout per frame. The scale is read from the context, so it includes
+ any backing scale in force. A value of 0 disables automatic greeking; the default is 0.25. An explicit \c greeking
+ setting on an instance always takes precedence.
+*/
+@property (class) CGFloat automaticGreekingThreshold;
+
 // the text:
 
 @property (readonly, copy) NSString* string;
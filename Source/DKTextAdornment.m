@@ -28,6 +28,9 @@
 
 - (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path;
 - (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm;
+- (NSSize)layoutText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm;
+- (void)drawLaidOutTextWithLayoutManager:(NSLayoutManager*)lm objectSize:(NSSize)osize;
+- (NSUInteger)layoutChecksumForObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path;
 - (void)drawText:(NSTextStorage*)contents centredAtPoint:(NSPoint)p;
 - (NSAffineTransform*)textTransformForObject:(id<DKRenderable>)obj;
 - (void)drawKnockoutWithObject:(id<DKRenderable>)obj;
@@ -36,6 +39,8 @@
 - (CGFloat)verticalTextOffsetForTextSize:(NSSize)textSize objectSize:(NSSize)osize;
 - (void)applyNonCocoaTextAttributes:(NSDictionary*)attrs;
 - (NSLayoutManager*)layoutManager;
+- (NSLayoutManager*)layoutManagerForGreeking:(DKGreeking)greeking;
+- (DKGreeking)greekingForCurrentContext;
 - (void)masterStringChanged:(NSNotification*)note;
 
 @end
@@ -56,10 +61,15 @@ NSString* const DKTextCapitalizationAttributeName = @"DKTextCapitalizationAttrib
 static NSString* const kDKTextAdornmentMaskPathCacheKey = @"DKTextAdornmentMaskPath";
 static NSString* const kDKTextAdornmentMaskObjectChecksumCacheKey = @"DKTextAdornmentMaskObjectChecksum";
 static NSString* const kDKTextAdornmentMetadataChecksumCacheKey = @"DKTextAdornmentMetadataChecksum";
+static NSString* const kDKTextAdornmentLayoutStorageCacheKey = @"DKTextAdornmentLayoutStorage";
+static NSString* const kDKTextAdornmentLayoutChecksumCacheKey = @"DKTextAdornmentLayoutChecksum";
+static NSString* const kDKTextAdornmentLayoutSizeCacheKey = @"DKTextAdornmentLayoutSize";
+static NSString* const kDKTextAdornmentLayoutFittedCacheKey = @"DKTextAdornmentLayoutFitted";
 
 @implementation DKTextAdornment
 
 static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
+static CGFloat s_automaticGreekingThreshold = 0.25;
 
 #pragma mark As a DKTextAdornment
 
@@ -113,6 +123,16 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	s_maximumVerticalOffset = mvo;
 }
 
++ (CGFloat)automaticGreekingThreshold
+{
+	return s_automaticGreekingThreshold;
+}
+
++ (void)setAutomaticGreekingThreshold:(CGFloat)threshold
+{
+	s_automaticGreekingThreshold = threshold;
+}
+
 - (NSString*)string
 {
 	return [[self textSubstitutor] string];
@@ -205,7 +225,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		return [path bezierPathWithTextOnPath:str
 									  yOffset:baseOffset];
 	} else {
-		DKBezierLayoutManager* captureLM = sharedCaptureLayoutManager();
+		DKBezierLayoutManager* captureLM = checkoutCaptureLayoutManager();
 		[[captureLM textPath] removeAllPoints];
 
 		// by drawing into a temporary flipped image context, text will be right side up with its lines in the right order
@@ -222,6 +242,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		// get the text path and position it aligned with the object
 
 		NSBezierPath* newPath = [[captureLM textPath] copy];
+		checkinLayoutManager(captureLM);
 
 		NSAffineTransform* tfm = [self textTransformForObject:object];
 		[newPath transformUsingAffineTransform:tfm];
@@ -256,7 +277,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		return [path bezierPathsWithGlyphsOnPath:str
 										 yOffset:[self baselineOffset]];
 	} else {
-		DKBezierLayoutManager* captureLM = sharedCaptureLayoutManager();
+		DKBezierLayoutManager* captureLM = checkoutCaptureLayoutManager();
 		NSTextContainer* container = [[captureLM textContainers] lastObject];
 
 		[self drawText:str
@@ -268,6 +289,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		NSArray* glyphs = [captureLM glyphPathsForContainer:container
 												   usedSize:aSize];
 		[str removeLayoutManager:captureLM];
+		checkinLayoutManager(captureLM);
 
 		return glyphs;
 	}
@@ -987,10 +1009,71 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 
 - (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path
 {
+	if ([contents length] == 0)
+		return;
+
+	// the full (non-greeked) layout is cached and reused while the container's geometry is unchanged. Layout is
+	// performed in the object's local coordinates, so pure translation or rotation of the object leaves the cached
+	// glyph positions valid and only the (cheap) glyph drawing is repeated - dragging a text-heavy selection does
+	// not re-lay-out its text every frame. Ghosted objects substitute transient attributes, so they bypass the cache.
+
+	BOOL ghosted = [obj respondsToSelector:@selector(isGhosted)] && [(id)obj isGhosted];
+
+	if (!ghosted) {
+		NSUInteger lcs = [self layoutChecksumForObject:obj
+											  withPath:path];
+		NSTextStorage* cachedStorage = [mTACache objectForKey:kDKTextAdornmentLayoutStorageCacheKey];
+		NSLayoutManager* lm = [[cachedStorage layoutManagers] lastObject];
+
+		if (lm != nil && [[mTACache objectForKey:kDKTextAdornmentLayoutChecksumCacheKey] unsignedIntegerValue] == lcs) {
+			// cached layout is still valid - just redraw the glyphs
+
+			mLastLayoutFittedAllText = [[mTACache objectForKey:kDKTextAdornmentLayoutFittedCacheKey] boolValue];
+			[self drawLaidOutTextWithLayoutManager:lm
+										objectSize:[[mTACache objectForKey:kDKTextAdornmentLayoutSizeCacheKey] sizeValue]];
+			return;
+		}
+
+		// lay out afresh into a dedicated stack. The stack stays in the cache with the text storage still
+		// attached, so the layout manager retains the finished glyph layout for subsequent draws. Note that
+		// any change to the text content or attributes empties the cache, so a stale layout cannot be reused.
+
+		lm = [[NSLayoutManager alloc] init];
+
+		DKBezierTextContainer* bc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
+		[bc setWidthTracksTextView:NO];
+		[bc setHeightTracksTextView:NO];
+		[bc setLineFragmentPadding:0];
+		[lm addTextContainer:bc];
+		[lm setUsesScreenFonts:NO];
+
+		NSSize osize = [self layoutText:contents
+							 withObject:obj
+							   withPath:path
+						  layoutManager:lm];
+
+		[mTACache setObject:contents
+					 forKey:kDKTextAdornmentLayoutStorageCacheKey];
+		[mTACache setObject:@(lcs)
+					 forKey:kDKTextAdornmentLayoutChecksumCacheKey];
+		[mTACache setObject:[NSValue valueWithSize:osize]
+					 forKey:kDKTextAdornmentLayoutSizeCacheKey];
+		[mTACache setObject:@(mLastLayoutFittedAllText)
+					 forKey:kDKTextAdornmentLayoutFittedCacheKey];
+
+		[self drawLaidOutTextWithLayoutManager:lm
+									objectSize:osize];
+		return;
+	}
+
+	NSLayoutManager* lm = [self layoutManager];
+
 	[self drawText:contents
 		   withObject:obj
 			 withPath:path
-		layoutManager:[self layoutManager]];
+		layoutManager:lm];
+
+	checkinLayoutManager(lm);
 }
 
 - (void)drawText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm
@@ -998,81 +1081,133 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	NSAssert(lm != nil, @"there must be a valid layout manager when calling -drawText:withObject:withPath:layoutManager:");
 
 	if ([contents length] > 0) {
-		NSSize osize = obj ? [obj size] : [path bounds].size;
+		NSSize osize = [self layoutText:contents
+							 withObject:obj
+							   withPath:path
+						  layoutManager:lm];
 
-		DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
-
-		if ([self layoutMode] == kDKTextLayoutFlowedInPath) {
-			// if the text angle is rel to the object, the layout path should be the unrotated path
-			// so the the text is laid out unrotated, then transformed into place. So detect that case here
-			// and compensate the path for the angle.
+		[self drawLaidOutTextWithLayoutManager:lm
+									objectSize:osize];
+		[contents removeLayoutManager:lm];
+	}
+}
 
-			NSBezierPath* textLayoutPath = path;
+- (NSSize)layoutText:(NSTextStorage*)contents withObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path layoutManager:(NSLayoutManager*)lm
+{
+	// configures the layout manager's container for the object's geometry, attaches the text and forces layout.
+	// Returns the object size against which the laid-out text should be positioned when drawn.
 
-			if ([self flowedTextPathInset] != 0.0) {
-				[bc setLineFragmentPadding:[self flowedTextPathInset]];
-			}
+	NSSize osize = obj ? [obj size] : [path bounds].size;
 
-			NSAffineTransform* tfm = [self textTransformForObject:obj];
-			[tfm invert];
+	DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
 
-			textLayoutPath = [tfm transformBezierPath:textLayoutPath];
+	if ([self layoutMode] == kDKTextLayoutFlowedInPath) {
+		// if the text angle is rel to the object, the layout path should be the unrotated path
+		// so the the text is laid out unrotated, then transformed into place. So detect that case here
+		// and compensate the path for the angle.
 
-			osize = [textLayoutPath bounds].size;
-			[bc setContainerSize:osize];
-			[bc setBezierPath:textLayoutPath];
-		} else {
-			if ([self allowsTextToExtendHorizontally])
-				osize.width = 50000;
+		NSBezierPath* textLayoutPath = path;
 
-			[bc setBezierPath:nil];
-			[bc setContainerSize:osize];
+		if ([self flowedTextPathInset] != 0.0) {
+			[bc setLineFragmentPadding:[self flowedTextPathInset]];
 		}
 
-		NSRange glyphRange;
-		NSRange grange;
-		NSRect frag;
+		NSAffineTransform* tfm = [self textTransformForObject:obj];
+		[tfm invert];
 
-		[contents addLayoutManager:lm];
+		textLayoutPath = [tfm transformBezierPath:textLayoutPath];
 
-		// Force layout of the text and find out how much of it fits in the container.
+		osize = [textLayoutPath bounds].size;
+		[bc setContainerSize:osize];
+		[bc setBezierPath:textLayoutPath];
+	} else {
+		if ([self allowsTextToExtendHorizontally])
+			osize.width = 50000;
 
-		glyphRange = [lm glyphRangeForTextContainer:bc];
+		[bc setBezierPath:nil];
+		[bc setContainerSize:osize];
+	}
 
-		// flag whether all the text was laid out. This can be queried to see if a "more text" marker should be shown
-		// by the bject that is using this service.
+	[contents addLayoutManager:lm];
 
-		NSRange fullRange = [lm glyphRangeForCharacterRange:NSMakeRange(0, [contents length])
-									   actualCharacterRange:NULL];
-		mLastLayoutFittedAllText = NSEqualRanges(fullRange, glyphRange);
+	// Force layout of the text and find out how much of it fits in the container.
 
-		// because of the object transform applied, draw the text at the origin
+	NSRange glyphRange = [lm glyphRangeForTextContainer:bc];
 
-		if (glyphRange.length > 0) {
-			NSSize textSize = [lm usedRectForTextContainer:bc].size;
+	// flag whether all the text was laid out. This can be queried to see if a "more text" marker should be shown
+	// by the bject that is using this service.
 
-			// if not wrapping lines, draw only the first line
+	NSRange fullRange = [lm glyphRangeForCharacterRange:NSMakeRange(0, [contents length])
+								   actualCharacterRange:NULL];
+	mLastLayoutFittedAllText = NSEqualRanges(fullRange, glyphRange);
 
-			if (![self wrapsLines]) {
-				frag = [lm lineFragmentUsedRectForGlyphAtIndex:0
-												effectiveRange:&grange];
-				textSize.height = frag.size.height;
-			} else
-				grange = glyphRange;
+	return osize;
+}
+
+- (void)drawLaidOutTextWithLayoutManager:(NSLayoutManager*)lm objectSize:(NSSize)osize
+{
+	// draws text already laid out in the manager's container. When the layout is still valid this does no
+	// layout work at all. Because of the object transform applied, the text is drawn at the origin.
 
-			NSPoint textOrigin = [self textOriginForSize:textSize
-											  objectSize:osize];
+	DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
+	NSRange glyphRange = [lm glyphRangeForTextContainer:bc];
+	NSRange grange;
+	NSRect frag;
 
-			if ([self layoutMode] == kDKTextLayoutFlowedInPath && [self flowedTextPathInset] != 0.0)
-				textOrigin.y += [self flowedTextPathInset] * 0.5;
+	if (glyphRange.length > 0) {
+		NSSize textSize = [lm usedRectForTextContainer:bc].size;
 
-			[lm drawBackgroundForGlyphRange:grange
-									atPoint:textOrigin];
-			[lm drawGlyphsForGlyphRange:grange
+		// if not wrapping lines, draw only the first line
+
+		if (![self wrapsLines]) {
+			frag = [lm lineFragmentUsedRectForGlyphAtIndex:0
+											effectiveRange:&grange];
+			textSize.height = frag.size.height;
+		} else
+			grange = glyphRange;
+
+		NSPoint textOrigin = [self textOriginForSize:textSize
+										  objectSize:osize];
+
+		if ([self layoutMode] == kDKTextLayoutFlowedInPath && [self flowedTextPathInset] != 0.0)
+			textOrigin.y += [self flowedTextPathInset] * 0.5;
+
+		[lm drawBackgroundForGlyphRange:grange
 								atPoint:textOrigin];
-		}
-		[contents removeLayoutManager:lm];
+		[lm drawGlyphsForGlyphRange:grange
+							atPoint:textOrigin];
+	}
+}
+
+- (NSUInteger)layoutChecksumForObject:(id<DKRenderable>)obj withPath:(NSBezierPath*)path
+{
+	// checksums everything the glyph layout itself depends on apart from the text content, which is covered by
+	// the cache invalidation wired to the substitutor and the attribute setters. Location and angle are
+	// deliberately excluded - layout happens in the object's local coordinates, so moving or rotating the
+	// object must leave the cached layout valid. Settings that only affect positioning (vertical alignment,
+	// text rect) are also excluded since the text origin is recomputed on every draw.
+
+	NSUInteger cd = 49576327; // arbitrary
+	NSSize osize = obj ? [obj size] : [path bounds].size;
+
+	cd ^= (NSUInteger)lround(osize.width * 16.0) ^ ((NSUInteger)lround(osize.height * 16.0) << 10);
+	cd ^= (NSUInteger)[self layoutMode] << 20;
+
+	if ([self allowsTextToExtendHorizontally])
+		cd ^= 1 << 24;
+
+	if ([self layoutMode] == kDKTextLayoutFlowedInPath && path != nil) {
+		// the local shape of the layout path matters here - element count plus bounds size is a cheap,
+		// conservative signature for it that is still invariant under translation
+
+		NSRect pb = [path bounds];
+
+		cd ^= (NSUInteger)[path elementCount] << 25;
+		cd ^= (NSUInteger)lround(pb.size.width * 16.0) ^ ((NSUInteger)lround(pb.size.height * 16.0) << 5);
+		cd ^= (NSUInteger)lround([self flowedTextPathInset] * 16.0) << 15;
 	}
+
+	return cd;
 }
 
 - (CGFloat)baselineOffset
@@ -1139,7 +1274,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 			return NSZeroRect;
 
 		NSSize oSize = [object size];
-		NSLayoutManager* lm = sharedDrawingLayoutManager();
+		NSLayoutManager* lm = checkoutDrawingLayoutManager();
 		DKBezierTextContainer* bc = (id)[[lm textContainers] lastObject];
 
 		if ([self allowsTextToExtendHorizontally])
@@ -1161,6 +1296,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		tlr.origin.y += offset;
 
 		[str removeLayoutManager:lm];
+		checkinLayoutManager(lm);
 
 		return tlr;
 	}
@@ -1298,22 +1434,55 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 	[self render:shape];
 }
 
+- (DKGreeking)greekingForCurrentContext
+{
+	// returns the greeking mode that rendering should actually use, folding in the automatic level-of-detail
+	// policy. An explicit greeking setting always wins; otherwise, when the current context's scale is below the
+	// class threshold the text is greeked by line rects. The switch back to full layout only happens once the
+	// scale has climbed 25% clear of the threshold, so a zoom animation that straddles the threshold doesn't
+	// flip between full layout and greeking on every frame.
+
+	if (mGreeking != kDKGreekingNone)
+		return mGreeking;
+
+	CGFloat threshold = [[self class] automaticGreekingThreshold];
+
+	if (threshold <= 0.0)
+		return kDKGreekingNone;
+
+	CGContextRef context = [[NSGraphicsContext currentContext] graphicsPort];
+	CGAffineTransform ctm = CGContextGetCTM(context);
+	CGFloat scale = hypot(ctm.a, ctm.b);
+
+	if (mLODGreekingActive) {
+		if (scale > threshold * 1.25)
+			mLODGreekingActive = NO;
+	} else {
+		if (scale < threshold)
+			mLODGreekingActive = YES;
+	}
+
+	return mLODGreekingActive ? kDKGreekingByLineRectangle : kDKGreekingNone;
+}
+
 - (NSLayoutManager*)layoutManager
 {
-	if ([self greeking] == kDKGreekingNone)
-		return sharedDrawingLayoutManager();
-	else {
-		// greeking is implemented using a greeking layout manager
+	return [self layoutManagerForGreeking:[self greeking]];
+}
 
-		DKGreekingLayoutManager* glm = [[DKGreekingLayoutManager alloc] init];
-		[glm setGreeking:[self greeking]];
+- (NSLayoutManager*)layoutManagerForGreeking:(DKGreeking)greeking
+{
+	// the stack comes from the layout stack pool either way and should be returned with
+	// checkinLayoutManager() once the caller is done drawing with it
 
-		DKBezierTextContainer* tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		[tc setWidthTracksTextView:NO];
-		[tc setHeightTracksTextView:NO];
-		[glm addTextContainer:tc];
+	if (greeking == kDKGreekingNone)
+		return checkoutDrawingLayoutManager();
+	else {
+		// greeking is implemented using a greeking layout manager
 
-		[glm setUsesScreenFonts:NO];
+		DKGreekingLayoutManager* glm = (DKGreekingLayoutManager*)checkoutLayoutManagerOfClass([DKGreekingLayoutManager class]);
+		[glm setGreeking:greeking];
+		[[[glm textContainers] lastObject] setContainerSize:NSMakeSize(1.0e6, 1.0e6)];
 
 		return glm;
 	}
@@ -1381,7 +1550,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 		cs = [(id)object metadataChecksum];
 		if (cs != ccs) {
 			[self invalidateCache];
-			[mTACache setObject:@(ccs)
+			[mTACache setObject:@(cs)
 						 forKey:kDKTextAdornmentMetadataChecksumCacheKey];
 		}
 
@@ -1408,6 +1577,11 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 				NSBezierPath* path
 				= [self renderingPathForObject:object];
 
+			// fold in the automatic level-of-detail policy - below the class threshold the text is greeked
+			// rather than fully laid out, regardless of the instance's own greeking setting
+
+			DKGreeking effectiveGreeking = [self greekingForCurrentContext];
+
 			if ([self layoutMode] == kDKTextLayoutAlongReversedPath)
 				path = [path bezierPathByReversingPath];
 
@@ -1415,7 +1589,7 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 				[self layoutMode] == kDKTextLayoutAlongPath) {
 				// draw any knockout behind the text - warning: potentially expensive.
 
-				if ([self greeking] == kDKGreekingNone)
+				if (effectiveGreeking == kDKGreekingNone)
 					[self drawKnockoutWithObject:object];
 
 				// measure the text height for the centring option based on the font of the first character
@@ -1432,8 +1606,8 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 
 				NSLayoutManager* lm = nil;
 
-				if ([self greeking] != kDKGreekingNone)
-					lm = [self layoutManager];
+				if (effectiveGreeking != kDKGreekingNone)
+					lm = [self layoutManagerForGreeking:effectiveGreeking];
 
 				// passing nil as lm causes text on path to be laid out using its own shared lm for the purpose
 
@@ -1441,23 +1615,37 @@ static CGFloat s_maximumVerticalOffset = DEFAULT_BASELINE_OFFSET_MAX;
 														yOffset:baseOffset
 												  layoutManager:lm
 														  cache:mTACache];
+
+				checkinLayoutManager(lm);
 			} else {
 				if ([self clipping] != kDKClippingNone)
 					[path addClip];
 
 				// draw any knockout behind the text - warning: potentially expensive.
 
-				if ([self greeking] == kDKGreekingNone)
+				if (effectiveGreeking == kDKGreekingNone)
 					[self drawKnockoutWithObject:object];
 
 				NSAffineTransform* tfm = [self textTransformForObject:object];
 				[tfm concat];
 
-				// draw the text
+				// draw the text. The non-greeked case goes through the caching path so that a pure move or
+				// rotation of the object reuses the previous glyph layout.
 
-				[self drawText:str
-					withObject:object
-					  withPath:path];
+				if (effectiveGreeking == kDKGreekingNone) {
+					[self drawText:str
+						withObject:object
+						  withPath:path];
+				} else {
+					NSLayoutManager* boxLM = [self layoutManagerForGreeking:effectiveGreeking];
+
+					[self drawText:str
+						   withObject:object
+							 withPath:path
+						layoutManager:boxLM];
+
+					checkinLayoutManager(boxLM);
+				}
 			}
 			RESTORE_GRAPHICS_CONTEXT //[NSGraphicsContext restoreGraphicsState];
 		}
@@ -361,7 +361,7 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 	NSUInteger len = [contents length];
 
 	if (len > 0) {
-		NSLayoutManager* lm = sharedDrawingLayoutManager();
+		NSLayoutManager* lm = checkoutDrawingLayoutManager();
 		NSTextContainer* tc = [[lm textContainers] objectAtIndex:0];
 		NSSize requiredSize = [self size];
 
@@ -384,6 +384,7 @@ static NSString* sDefault_string = @"Double-click to edit this text";
 			requiredSize.height = minsize.height;
 
 		[contents removeLayoutManager:lm];
+		checkinLayoutManager(lm);
 
 		requiredSize.width += 2.0;
 		return requiredSize;
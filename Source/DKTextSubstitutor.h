@@ -23,6 +23,9 @@ NS_ASSUME_NONNULL_BEGIN
 	NSAttributedString* mMasterString;
 	NSMutableArray* mKeys;
 	BOOL mNeedsToEvaluate;
+	NSAttributedString* mCachedResult; // memoized result of the last substitution - see -substitutedStringWithObject:
+	__weak id mCachedResultOwner; // the object the memoized result was evaluated against
+	BOOL mObservingMetadata; // YES once registered for metadata change notifications
 }
 
 @property (class, copy, nullable) NSString* delimiterString;
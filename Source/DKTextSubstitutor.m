@@ -68,6 +68,7 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 		NSString* oldString = [self string];
 
 		mMasterString = master;
+		mCachedResult = nil;
 
 		// for lazy evaluation, do not process the string immediately. Instead this will be done when the substitutor is asked to
 		// perform its first substitution. This is only flagged if the actual string content has changed.
@@ -145,6 +146,7 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 	NSCharacterSet* delimiterSet;
 
 	[mKeys removeAllObjects];
+	mCachedResult = nil;
 	[scanner setCharactersToBeSkipped:nil];
 
 	while (![scanner isAtEnd]) {
@@ -243,6 +245,14 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 	if ([mKeys count] == 0)
 		return [self masterString];
 
+	// the evaluated result is memoized. Metadata lookups are stable between draws, so once the string has been
+	// evaluated for a given object the stored result is returned directly until that object's metadata changes
+	// (signalled by kDKMetadataDidChangeNotification) or the master string is replaced. Templates containing
+	// property keypaths ($...) reflect live object state, so those are never memoized.
+
+	if (mCachedResult != nil && anObject != nil && anObject == mCachedResultOwner)
+		return mCachedResult;
+
 	// apply keys:
 
 	NSMutableAttributedString* newString = [[self masterString] mutableCopy];
@@ -272,9 +282,43 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 		rangeAdjustment += [subString length] - range.length;
 	}
 
+	// memoize the result unless the template depends on live object properties
+
+	BOOL usesPropertyKeys = NO;
+
+	for (DKTextSubstitutionKey* key in mKeys) {
+		if ([key isPropertyKeyPath]) {
+			usesPropertyKeys = YES;
+			break;
+		}
+	}
+
+	if (anObject != nil && !usesPropertyKeys) {
+		mCachedResult = [newString copy];
+		mCachedResultOwner = anObject;
+
+		// any metadata change anywhere discards the memoized result. This is deliberately conservative -
+		// metadata keys can be resolved through the object's container, so observing just the owner would
+		// miss changes made at the layer or drawing level.
+
+		if (!mObservingMetadata) {
+			[[NSNotificationCenter defaultCenter] addObserver:self
+													 selector:@selector(metadataDidChange:)
+														 name:kDKMetadataDidChangeNotification
+													   object:nil];
+			mObservingMetadata = YES;
+		}
+	}
+
 	return newString;
 }
 
+- (void)metadataDidChange:(NSNotification*)note
+{
+#pragma unused(note)
+	mCachedResult = nil;
+}
+
 - (NSString*)metadataStringFromObject:(id)object
 {
 	// given an object returned by metadataObjectForKey, this converts it to a string.
@@ -297,6 +341,12 @@ static NSString* sDelimiter = DEFAULT_DELIMITER_STRING;
 #pragma mark -
 #pragma mark - as a NSObject
 
+- (void)dealloc
+{
+	if (mObservingMetadata)
+		[[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
 - (instancetype)init
 {
 	self = [super init];
@@ -10,7 +10,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
-@class DKDrawingTool, DKUndoManager;
+@class DKDrawingTool, DKUndoManager, DKDrawableObject, DKLayer;
 
 //! This type is used to set the scope of tools within a DK application.
 typedef NS_ENUM(NSInteger, DKDrawingToolScope) {
@@ -62,6 +62,13 @@ typedef NS_ENUM(NSInteger, DKDrawingToolScope) {
 	NSInteger mPartcode; // partcode to pass back during mouse ops
 	BOOL mOpenedUndoGroup; // YES if an undo group was requested by the tool at some point
 	BOOL mAbortiveMouseDown; // YES flagged after exception during mouse down - rejects drag and up events
+	BOOL mBeganInteractiveRender; // YES while a begin/end interactive rendering pair is open on the drawing
+	NSMutableDictionary* mRecyclingPools; // per-class DKObjectPools for transient tool objects, reset per event
+	DKDrawableObject* __weak mWarmHitObject; // speculative hit-test result computed during hover
+	NSPoint mWarmHitPoint; // the drawing-space point the warm result was computed for
+	NSUInteger mWarmHitSequence; // global drawable change sequence at compute time
+	DKLayer* __weak mWarmHitLayerRef; // the layer the warm result was computed against
+	BOOL mWarmHitValid; // YES while the warm result may be consumed by mouseDown
 }
 
 /** @brief Set the operating scope for tools for this application
@@ -158,6 +165,16 @@ typedef NS_ENUM(NSInteger, DKDrawingToolScope) {
  */
 - (void)closeUndoGroup;
 
+/** @brief Draw any tool graphic content into the view's tool overlay
+
+ Called by the view's tool overlay plane when it redraws. The current tool's feedback (marquee,
+ drag images, etc.) is drawn here once the overlay is in use, in which case the normal content
+ drawing pass skips it entirely.
+ @param rect The update rect in the overlay.
+ @param aView The overlay view being drawn.
+ */
+- (void)drawOverlayRect:(NSRect)rect inView:(NSView*)aView;
+
 @end
 
 /** @name Notifications
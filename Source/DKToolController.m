@@ -9,6 +9,7 @@
 #import "DKDrawing.h"
 #import "DKDrawingView.h"
 #import "DKObjectDrawingLayer.h"
+#import "DKObjectPool.h"
 #import "DKSelectAndEditTool.h"
 #import "DKToolRegistry.h"
 #import "DKUndoManager.h"
@@ -28,19 +29,19 @@ NSString* const kDKDrawingToolAutoActivatesLayerDefaultsKey = @"DKDrawingToolAut
 
  This is used when the tool scope is per-document. In that case the tool is associated with the
  drawing, not the individual view.
- @param drawingKey a key for the drawing object
+ @param drawingKey the drawing's integer key
  @return the current tool set for the drawing
  */
-+ (DKDrawingTool*)drawingToolForDrawing:(NSString*)drawingKey;
++ (DKDrawingTool*)drawingToolForDrawing:(uint64_t)drawingKey;
 
 /** @brief Sets the drawing tool for the given drawing
 
  This is used when the tool scope is per-document. In that case the tool is associated with the
  document, not the individual view.
  @param tool the tool to set
- @param drawingKey a key for the drawing object
+ @param drawingKey the drawing's integer key
  */
-+ (void)setDrawingTool:(DKDrawingTool*)tool forDrawing:(NSString*)drawingKey;
++ (void)setDrawingTool:(DKDrawingTool*)tool forDrawing:(uint64_t)drawingKey;
 
 /** @brief Get the tool for the entire application
 
@@ -85,25 +86,21 @@ static DKDrawingTool* sGlobalTool = nil;
 
 #pragma mark - private class methods
 
-+ (DKDrawingTool*)drawingToolForDrawing:(NSString*)drawingKey
++ (DKDrawingTool*)drawingToolForDrawing:(uint64_t)drawingKey
 {
-	NSAssert(drawingKey != nil, @"drawing was nil trying to get per-document tool");
-
 	if (sDrawingToolDict == nil)
 		return nil;
 	else
-		return [sDrawingToolDict objectForKey:drawingKey];
+		return [sDrawingToolDict objectForKey:@(drawingKey)];
 }
 
-+ (void)setDrawingTool:(DKDrawingTool*)tool forDrawing:(NSString*)drawingKey
++ (void)setDrawingTool:(DKDrawingTool*)tool forDrawing:(uint64_t)drawingKey
 {
-	NSAssert(drawingKey != nil, @"attempt to set tool per drawing, but drawing key is nil");
-
 	if (sDrawingToolDict == nil)
 		sDrawingToolDict = [[NSMutableDictionary alloc] init];
 
 	[sDrawingToolDict setObject:tool
-						 forKey:drawingKey];
+						 forKey:@(drawingKey)];
 }
 
 + (DKDrawingTool*)globalDrawingTool
@@ -195,7 +192,7 @@ static DKDrawingTool* sGlobalTool = nil;
 		default:
 		case kDKToolScopeLocalToDocument:
 			[[self class] setDrawingTool:aTool
-							  forDrawing:[[self drawing] uniqueKey]];
+							  forDrawing:[[self drawing] uniqueIntegerKey]];
 			break;
 
 		case kDKToolScopeGlobal:
@@ -251,7 +248,7 @@ static DKDrawingTool* sGlobalTool = nil;
 
 	default:
 	case kDKToolScopeLocalToDocument:
-		return [[self class] drawingToolForDrawing:[[self drawing] uniqueKey]];
+		return [[self class] drawingToolForDrawing:[[self drawing] uniqueIntegerKey]];
 
 	case kDKToolScopeGlobal:
 		return [[self class] globalDrawingTool];
@@ -290,6 +287,12 @@ static DKDrawingTool* sGlobalTool = nil;
  */
 - (void)drawRect:(NSRect)rect
 {
+	// once the view's tool overlay is in use, transient tool feedback is drawn there instead of
+	// as part of the content pass - see drawOverlayRect:inView:
+
+	if ([[self view] isKindOfClass:[DKDrawingView class]] && [(DKDrawingView*)[self view] hasToolOverlay])
+		return;
+
 	DKDrawingTool* ct = [self drawingTool];
 	NSAssert(ct != nil, @"nil drawing tool for drawRect:");
 
@@ -299,6 +302,30 @@ static DKDrawingTool* sGlobalTool = nil;
 			  inView:[self view]];
 }
 
+/** @brief Draw any tool graphic content into the view's tool overlay
+ @param rect the update rect in the overlay
+ @param aView the overlay view that is being drawn
+ */
+- (void)drawOverlayRect:(NSRect)rect inView:(NSView*)aView
+{
+	// the active layer's selection highlights may also live in the overlay plane - draw them
+	// beneath the tool's own feedback
+
+	DKLayer* active = [self activeLayer];
+
+	if ([active respondsToSelector:@selector(drawSelectionOverlayRect:
+																inView:)])
+		[(DKObjectDrawingLayer*)active drawSelectionOverlayRect:rect
+														 inView:aView];
+
+	DKDrawingTool* ct = [self drawingTool];
+
+	if ([ct respondsToSelector:@selector(drawRect:
+										 inView:)])
+		[ct drawRect:rect
+			  inView:aView];
+}
+
 - (IBAction)selectDrawingToolByName:(id)sender
 {
 	NSString* toolName = [sender title];
@@ -454,6 +481,8 @@ static DKDrawingTool* sGlobalTool = nil;
 	mOpenedUndoGroup = NO;
 	mAbortiveMouseDown = NO;
 
+	[self recycleTransientObjects];
+
 	DKDrawableObject* target = nil;
 	DKDrawingTool* ct = [self drawingTool];
 	NSPoint p = [[self view] convertPoint:[event locationInWindow]
@@ -472,6 +501,11 @@ static DKDrawingTool* sGlobalTool = nil;
 	if ([ct isValidTargetLayer:[self activeLayer]]) {
 		[self startAutoscrolling];
 
+		// a tool gesture is starting - hold the fast rendering tier for its duration
+
+		[[self drawing] beginInteractiveRendering];
+		mBeganInteractiveRender = YES;
+
 		BOOL isObjectLayer = [[self activeLayer] isKindOfClass:[DKObjectDrawingLayer class]];
 
 		if (isObjectLayer) {
@@ -480,9 +514,17 @@ static DKDrawingTool* sGlobalTool = nil;
 			[(DKObjectDrawingLayer*)[self activeLayer] recordSelectionForUndo];
 		}
 
-		// see if there is a target object
+		// see if there is a target object. If hover tracking already hit-tested this exact point and
+		// nothing in the drawing has changed since, the warm answer is consumed instead of re-testing -
+		// on dense documents this is what makes tool activation feel instant
+
+		if (mWarmHitValid && NSEqualPoints(p, mWarmHitPoint) && mWarmHitLayerRef == [self activeLayer]
+			&& [DKDrawableObject currentChangeSequence] == mWarmHitSequence)
+			target = mWarmHitObject;
+		else
+			target = [(DKObjectDrawingLayer*)[self activeLayer] hitTest:p];
 
-		target = [(DKObjectDrawingLayer*)[self activeLayer] hitTest:p];
+		mWarmHitValid = NO;
 
 		// start the tool:
 
@@ -503,6 +545,11 @@ static DKDrawingTool* sGlobalTool = nil;
 			[self closeUndoGroup];
 			[self stopAutoscrolling];
 
+			if (mBeganInteractiveRender) {
+				mBeganInteractiveRender = NO;
+				[[self drawing] endInteractiveRendering];
+			}
+
 			// set flag to reject drag and up events - cleared on new mouse down. This prevents an error condition from developing
 			// if the initial mouse down is mishandled.
 
@@ -527,6 +574,8 @@ static DKDrawingTool* sGlobalTool = nil;
 	if (mAbortiveMouseDown)
 		return;
 
+	[self recycleTransientObjects];
+
 	DKDrawingTool* ct = [self drawingTool];
 
 	if (event != mDragEvent) {
@@ -571,6 +620,8 @@ static DKDrawingTool* sGlobalTool = nil;
 
 	LogEvent_(kInfoEvent, @"tool controller mouse up");
 
+	[self recycleTransientObjects];
+
 	DKDrawingTool* ct = [self drawingTool];
 	NSPoint p = [[self view] convertPoint:[event locationInWindow]
 								 fromView:nil];
@@ -608,6 +659,13 @@ static DKDrawingTool* sGlobalTool = nil;
 	} else
 		[super mouseUp:event];
 
+	// the gesture is complete - release the fast rendering tier so the result is redrawn at full quality
+
+	if (mBeganInteractiveRender) {
+		mBeganInteractiveRender = NO;
+		[[self drawing] endInteractiveRendering];
+	}
+
 	// after handling mouse up, we may wish to spring back to the selection tool. This first attempts to
 	// select a registered tool with the name "Select" so if you have replaced it, that is the new default tool.
 	// Otherwise it creates an instance of the standard selection tool and sets that.
@@ -657,6 +715,26 @@ static DKDrawingTool* sGlobalTool = nil;
 			[[self activeLayer] mouseMoved:event
 									inView:[self view]];
 	}
+
+	// speculatively hit-test the hover position so that a subsequent mouse down at the same point
+	// consumes the answer instead of hit-testing after the click lands. The result is tagged with
+	// the global change sequence, so any intervening edit silently discards it.
+
+	DKLayer* layer = [self activeLayer];
+
+	if ([[self drawingTool] isValidTargetLayer:layer] && [layer isKindOfClass:[DKObjectDrawingLayer class]]) {
+		NSPoint p = [[self view] convertPoint:[event locationInWindow]
+									 fromView:nil];
+
+		if (!mWarmHitValid || !NSEqualPoints(p, mWarmHitPoint)) {
+			mWarmHitObject = [(DKObjectDrawingLayer*)layer hitTest:p];
+			mWarmHitPoint = p;
+			mWarmHitLayerRef = layer;
+			mWarmHitSequence = [DKDrawableObject currentChangeSequence];
+			mWarmHitValid = YES;
+		}
+	} else
+		mWarmHitValid = NO;
 }
 
 /** @brief Returns the current tool's cursor
@@ -739,6 +817,38 @@ static DKDrawingTool* sGlobalTool = nil;
 	[self openUndoGroup];
 }
 
+/** @brief Returns the recycling pool maintained for transient objects of the given class
+
+ Pools are created lazily per class and live for the controller's lifetime. A new generation is
+ begun for every pool at each mouse event boundary, so objects acquired while handling one event
+ are recycled for the next rather than returning to the allocator.
+ @param aClass the class of object required
+ @return a pool vending that class */
+- (DKObjectPool*)recyclingPoolForClass:(Class)aClass
+{
+	if (mRecyclingPools == nil)
+		mRecyclingPools = [[NSMutableDictionary alloc] init];
+
+	DKObjectPool* pool = [mRecyclingPools objectForKey:(id<NSCopying>)aClass];
+
+	if (pool == nil) {
+		pool = [[DKObjectPool alloc] initWithObjectClass:aClass];
+		[mRecyclingPools setObject:pool
+							forKey:(id<NSCopying>)aClass];
+	}
+
+	return pool;
+}
+
+/** @brief Begins a new generation in every transient object pool
+
+ Called at each mouse event boundary - everything tools acquired while handling the previous event
+ becomes reusable. */
+- (void)recycleTransientObjects
+{
+	[[mRecyclingPools allValues] makeObjectsPerformSelector:@selector(beginNewGeneration)];
+}
+
 #pragma mark -
 #pragma mark - As an NSObject
 
@@ -18,6 +18,7 @@ NS_ASSUME_NONNULL_BEGIN
 */
 @interface DKToolRegistry : NSObject {
 	NSMutableDictionary<DKToolName, __kindof DKDrawingTool*>* mToolsReg;
+	BOOL mPrewarmScheduled; // YES while a deferred prewarm pass over the registered tools is pending
 }
 
 /** @brief Return the shared tool registry
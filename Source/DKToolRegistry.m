@@ -90,6 +90,24 @@ static DKToolRegistry* s_toolRegistry = nil;
 	[mToolsReg setObject:tool
 				  forKey:name];
 
+	// prewarm the registered tools once the current event has finished, so that expensive one-off work such as
+	// cursor construction and prototype swatch rendering is paid here rather than on the first switch to a tool.
+	// Tool switching - in particular keyboard-driven tool cycling - then does no more than swap a pointer and set
+	// an already-built cursor. One deferred pass covers any number of registrations; prewarming is idempotent,
+	// so tools registered later simply join the next pass. The work stays on the main queue because swatch
+	// rendering goes through shared style state that is not safe to touch from another thread.
+
+	if (!mPrewarmScheduled) {
+		mPrewarmScheduled = YES;
+
+		dispatch_async(dispatch_get_main_queue(), ^{
+			self->mPrewarmScheduled = NO;
+
+			for (DKDrawingTool* t in [self->mToolsReg allValues])
+				[t prewarm];
+		});
+	}
+
 	// for compatibility, notification object is the tool, not the registry
 
 	[[NSNotificationCenter defaultCenter] postNotificationName:kDKDrawingToolWasRegisteredNotification
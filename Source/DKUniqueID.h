@@ -6,9 +6,15 @@
 
 #import <Foundation/Foundation.h>
 
-/** @brief Utility class generates totally unique keys using NSUUID.
+/** @brief Utility class generates totally unique keys.
 
- Utility class generates totally unique keys using NSUUID. The keys are guaranteed unique across time, space and different machines.
+ Utility class generates totally unique keys. The keys are guaranteed unique across time, space and different machines.
+
+ Keys combine a random per-session prefix with a sequential counter, so handing one out costs an
+ atomic increment and a short string format rather than a full UUID formatting pass, and the keys
+ are roughly half the length of a UUID string. Callers that only need in-memory identity
+ (dictionary keys and maps that never hit disk) can use the raw integer form and skip string
+ conversion altogether.
 
  One intended client for this is to assign unique registry keys to styles to solve the registry merge problem.
 */
@@ -18,4 +24,20 @@
 
 + (nonnull NSString*)uniqueKey;
 
+/** @brief Returns the next sequential 64-bit key.
+
+ Unique within the process only - use \c uniqueKey wherever the key may be persisted or may meet
+ keys generated on another machine. Cheaper than \c uniqueKey for purely in-memory maps as no
+ string is ever formed; box the result with <code>\@()</code> for use as a dictionary key.
+ */
++ (uint64_t)uniqueIntegerKey;
+
+/** @brief The highest integer key handed out so far.
+
+ A client that persists integer keys can store this high-water mark and restore it before it
+ resumes generating keys, so new keys continue above the stored ones instead of colliding with
+ them. Setting a value below the current mark has no effect.
+ */
+@property (class) uint64_t highWaterMark;
+
 @end
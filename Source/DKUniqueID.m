@@ -6,14 +6,62 @@
 
 #import "DKUniqueID.h"
 
+#include <stdatomic.h>
+#include <uuid/uuid.h>
+
+// cross-machine uniqueness comes from this 128-bit random session prefix, formatted to a string
+// exactly once per launch; per-key work is then one atomic increment and a short hex format. A
+// key looks like "5f3c9a17d24e80b6c1a8f9d2e4071b3a-1c4" - session prefix, dash, counter.
+
+static NSString* sSessionPrefix = nil;
+static _Atomic(uint64_t) sNextKey = 1;
+
+static NSString* DKUniqueIDSessionPrefix(void)
+{
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		uuid_t uuid;
+		uuid_generate(uuid);
+
+		NSMutableString* prefix = [NSMutableString stringWithCapacity:32];
+
+		for (NSUInteger i = 0; i < sizeof(uuid); ++i)
+			[prefix appendFormat:@"%02x", uuid[i]];
+
+		sSessionPrefix = [prefix copy];
+	});
+
+	return sSessionPrefix;
+}
+
 @implementation DKUniqueID
 
 + (NSString*)uniqueKey
 {
-	NSUUID* uuid = [NSUUID UUID];
-	NSString* str = uuid.UUIDString;
+	return [NSString stringWithFormat:@"%@-%llx", DKUniqueIDSessionPrefix(), (unsigned long long)[self uniqueIntegerKey]];
+}
+
++ (uint64_t)uniqueIntegerKey
+{
+	return atomic_fetch_add_explicit(&sNextKey, 1, memory_order_relaxed);
+}
+
++ (uint64_t)highWaterMark
+{
+	return atomic_load_explicit(&sNextKey, memory_order_relaxed) - 1;
+}
+
++ (void)setHighWaterMark:(uint64_t)mark
+{
+	// raise the counter to just past <mark>, never lower it - keys already handed out this
+	// session must stay out of reach
+
+	uint64_t current = atomic_load_explicit(&sNextKey, memory_order_relaxed);
 
-	return str;
+	while (current < mark + 1) {
+		if (atomic_compare_exchange_weak_explicit(&sNextKey, &current, mark + 1, memory_order_relaxed, memory_order_relaxed))
+			break;
+	}
 }
 
 @end
@@ -51,8 +51,10 @@ NS_ASSUME_NONNULL_BEGIN
 	DKDrawing* __weak mDrawingRef; //!< weak ref to the drawing that owns this
 	BOOL m_autoLayerSelect; //!< YES to allow mouse to activate layers automatically
 	BOOL mEnableDKMenus; //!< YES to enable all standard contextual menus provided by DK.
+	NSArray* mRegisteredDragTypes; //!< the drag types last registered with the view, so re-activation with the same types skips registration
 @protected
 	NSEvent* mDragEvent; //!< cached drag event for autoscroll to use
+	NSTimeInterval mLastAutoscrollTime; //!< time of the previous autoscroll tick, used to scale the scroll distance
 }
 
 - (instancetype)init UNAVAILABLE_ATTRIBUTE;
@@ -252,8 +254,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 /** @brief Start the autoscroll timer
 
- Starts a timer running at 20fps which will cause autscrolling as long as the mouse is outside
- the view. Normally autoscrolling should start on mouse down and stop on mouse up.
+ Starts a timer running at the display's refresh rate which will cause autscrolling as long as
+ the mouse is outside the view. The scroll distance per tick is scaled by the time actually
+ elapsed, so the scroll velocity is independent of the rate the timer achieves. Normally
+ autoscrolling should start on mouse down and stop on mouse up.
  */
 - (void)startAutoscrolling;
 
@@ -402,6 +406,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
-#define kDKAutoscrollRate (1.0 / 20.0)
+#define kDKAutoscrollRate (1.0 / 20.0) // legacy fixed timer interval - the timer now runs at the display's refresh rate
+#define kDKAutoscrollGain 10.0 // scroll velocity in multiples of the pointer's overshoot distance per second
 
 NS_ASSUME_NONNULL_END
@@ -289,7 +289,9 @@ static NSTimer* s_autoscrollTimer = nil;
 	if (s_autoscrollTimer != nil)
 		[self stopAutoscrolling];
 
-	s_autoscrollTimer = [NSTimer timerWithTimeInterval:kDKAutoscrollRate
+	mLastAutoscrollTime = [NSDate timeIntervalSinceReferenceDate];
+
+	s_autoscrollTimer = [NSTimer timerWithTimeInterval:[DKDrawingView displayRefreshPeriod]
 												target:self
 											  selector:@selector(autoscrollTimerCallback:)
 											  userInfo:[self view]
@@ -312,12 +314,39 @@ static NSTimer* s_autoscrollTimer = nil;
 #pragma unused(timer)
 	// this invokes autoscrolling on the source view based on the current mouse point
 
+	NSTimeInterval now = [NSDate timeIntervalSinceReferenceDate];
+	NSTimeInterval dt = now - mLastAutoscrollTime;
+	mLastAutoscrollTime = now;
+
 	NSEvent* event = (mDragEvent ? mDragEvent : [NSApp currentEvent]);
 
 	//NSLog(@"autoscroll, event = %@", event );
 
 	if ([event type] == NSLeftMouseDragged) {
-		if ([[self view] autoscroll:event]) {
+		NSPoint p = [[self view] convertPoint:[event locationInWindow]
+									 fromView:nil];
+		NSRect vr = [[self view] visibleRect];
+
+		if (!NSPointInRect(p, vr)) {
+			// scroll by a distance proportional to the pointer's overshoot beyond the visible rect
+			// and to the time actually elapsed since the last tick, so the scroll velocity is the
+			// same whatever rate the timer achieves
+
+			NSPoint origin = vr.origin;
+			CGFloat gain = dt * kDKAutoscrollGain;
+
+			if (p.x < NSMinX(vr))
+				origin.x += (p.x - NSMinX(vr)) * gain;
+			else if (p.x > NSMaxX(vr))
+				origin.x += (p.x - NSMaxX(vr)) * gain;
+
+			if (p.y < NSMinY(vr))
+				origin.y += (p.y - NSMinY(vr)) * gain;
+			else if (p.y > NSMaxY(vr))
+				origin.y += (p.y - NSMaxY(vr)) * gain;
+
+			[[self view] scrollPoint:origin];
+
 			// call back the drag event so that there is no jerkiness as autscrolling commences - objects
 			// and so forth should continue to work smoothly during the scroll
 
@@ -366,6 +395,14 @@ static NSTimer* s_autoscrollTimer = nil;
 
 	NSArray* types = [aLayer pasteboardTypesForOperation:kDKReadableTypesForDrag];
 
+	// registration round-trips the pasteboard server, so when layers swap frequently (e.g. with
+	// automatic layer activation) re-registering an identical set is skipped
+
+	if (types == mRegisteredDragTypes || [types isEqualToArray:mRegisteredDragTypes])
+		return;
+
+	mRegisteredDragTypes = [types copy];
+
 	[[self view] unregisterDraggedTypes];
 
 	if (types != nil && [types count] > 0)
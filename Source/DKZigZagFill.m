@@ -64,9 +64,19 @@
 
 - (NSBezierPath*)renderingPathForObject:(id<DKRenderable>)object
 {
-	return [[super renderingPathForObject:object] bezierPathWithWavelength:[self wavelength]
-																 amplitude:[self amplitude]
-																	spread:[self spread]];
+	// the zig-zag walks the whole path, so the derived geometry is kept in the container's central
+	// cache and recomputed only when the path or the parameters change
+
+	NSBezierPath* path = [super renderingPathForObject:object];
+	NSString* key = [self derivedPathCacheKeyForPath:path
+										  parameters:[NSString stringWithFormat:@"%.3f_%.3f_%.3f", [self wavelength], [self amplitude], [self spread]]];
+
+	return [self cachedDerivedPathWithKey:key
+								  creator:^NSBezierPath* {
+									  return [path bezierPathWithWavelength:[self wavelength]
+																  amplitude:[self amplitude]
+																	 spread:[self spread]];
+								  }];
 }
 
 - (BOOL)isFill
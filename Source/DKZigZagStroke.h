@@ -14,6 +14,7 @@ NS_ASSUME_NONNULL_BEGIN
 	CGFloat mWavelength;
 	CGFloat mAmplitude;
 	CGFloat mSpread;
+	NSMutableDictionary* __unsafe_unretained mRenderCacheRef; // the rendered object's cache, valid only during -render:
 }
 
 @property (nonatomic) CGFloat wavelength;
@@ -73,12 +73,42 @@
 		return NSZeroSize;
 }
 
+- (void)render:(id<DKRenderable>)object
+{
+	// deriving the zig-zag geometry walks the whole flattened path, which dominates frame time on long polylines, so
+	// the derived path is kept in the object's rendering cache for reuse across draws. The object empties the cache
+	// whenever its geometry changes, and the key carries the parameters so edits to them simply miss.
+
+	if ([object respondsToSelector:@selector(renderingCache)])
+		mRenderCacheRef = [object renderingCache];
+
+	[super render:object];
+	mRenderCacheRef = nil;
+}
+
 - (void)renderPath:(NSBezierPath*)path
 {
 	if ([self amplitude] > 0) {
-		NSBezierPath* rp = [path bezierPathWithWavelength:[self wavelength]
-												amplitude:[self amplitude]
-												   spread:[self spread]];
+		NSBezierPath* rp = nil;
+		NSString* cacheKey = nil;
+
+		if (mRenderCacheRef != nil) {
+			// the element count guards against in-place path edits that happen to leave the bounds unchanged
+
+			cacheKey = [NSString stringWithFormat:@"DKZigZagStroke_%p_%.3f_%.3f_%.3f_%ld", self, [self wavelength], [self amplitude], [self spread], (long)[path elementCount]];
+			rp = [mRenderCacheRef objectForKey:cacheKey];
+		}
+
+		if (rp == nil) {
+			rp = [path bezierPathWithWavelength:[self wavelength]
+									  amplitude:[self amplitude]
+										 spread:[self spread]];
+
+			if (cacheKey != nil && rp != nil)
+				[mRenderCacheRef setObject:rp
+									forKey:cacheKey];
+		}
+
 		[super renderPath:rp];
 	} else
 		[super renderPath:path];
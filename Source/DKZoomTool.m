@@ -162,16 +162,24 @@
  */
 - (NSCursor*)cursor
 {
-	NSImage* img;
+	// built once and cached - this is requested on every tool switch and cursor update
 
-	if (mMode)
-		img = [NSImage imageNamed:@"mag_minus"];
-	else
-		img = [NSImage imageNamed:@"mag_plus"];
+	static NSCursor* sZoomOutCursor = nil;
+	static NSCursor* sZoomInCursor = nil;
 
-	NSCursor* curs = [[NSCursor alloc] initWithImage:img
-											 hotSpot:NSMakePoint(12, 12)];
-	return curs;
+	if (mMode) {
+		if (sZoomOutCursor == nil)
+			sZoomOutCursor = [[NSCursor alloc] initWithImage:[NSImage imageNamed:@"mag_minus"]
+													 hotSpot:NSMakePoint(12, 12)];
+
+		return sZoomOutCursor;
+	} else {
+		if (sZoomInCursor == nil)
+			sZoomInCursor = [[NSCursor alloc] initWithImage:[NSImage imageNamed:@"mag_plus"]
+													hotSpot:NSMakePoint(12, 12)];
+
+		return sZoomInCursor;
+	}
 }
 
 #pragma mark -
@@ -19,6 +19,13 @@ NS_ASSUME_NONNULL_BEGIN
 @private
 	__unsafe_unretained NSControl* m_infoViewRef;
 	NSSize m_wOffset;
+	NSString* mPendingString; // latest content supplied while a flush is pending
+	NSPoint mPendingOrigin; // latest screen origin supplied while a flush is pending
+	BOOL mHasPendingContent; // YES when content awaits the next flush
+	BOOL mHasPendingOrigin; // YES when a window move awaits the next flush
+	NSTimer* mUpdateTimer; // non-nil while a flush is scheduled for the next display refresh
+	NSString* mDisplayedString; // the content currently on screen, used to skip no-op layout
+	NSColor* mCachedTextColor; // contrasting text colour, recomputed when the background changes
 }
 
 /**  */
@@ -5,11 +5,18 @@
 */
 
 #import "GCInfoFloater.h"
+#import "DKDrawingView.h"
 #import "GCOneShotEffectTimer.h"
 #import "NSColor+DKAdditions.h"
 
 @interface GCInfoFloater () <GCOneShotDelegate>
 
+/** @brief Schedule a flush of pending content and position for the next display refresh. */
+- (void)scheduleUpdate;
+
+/** @brief Apply whatever content and position updates accumulated since the last flush. */
+- (void)flushPendingUpdate;
+
 @end
 
 @implementation GCInfoFloater
@@ -93,32 +100,23 @@
 
 - (void)setDoubleValue:(double)val
 {
-	NSColor* textColor = [[self backgroundColor] contrastingColor];
-	[(NSTextField*)m_infoViewRef setTextColor:textColor];
+	// the value is formatted to a string immediately - which is cheap - but layout and display
+	// are deferred to the next flush, so a drag supplying values per mouse event only pays for
+	// the ones that can actually reach the screen
 
-	[m_infoViewRef setDoubleValue:val];
-	[m_infoViewRef sizeToFit];
+	NSString* str = [[m_infoViewRef formatter] stringForObjectValue:@(val)];
 
-	NSRect fr = [m_infoViewRef frame];
-	fr.origin = [self frame].origin;
+	if (str == nil)
+		str = [NSString stringWithFormat:@"%g", val];
 
-	[self setFrame:fr
-		   display:YES];
+	[self setStringValue:str];
 }
 
 - (void)setStringValue:(NSString*)str
 {
-	NSColor* textColor = [[self backgroundColor] contrastingColor];
-	[(NSTextField*)m_infoViewRef setTextColor:textColor];
-
-	[m_infoViewRef setStringValue:str];
-	[m_infoViewRef sizeToFit];
-
-	NSRect fr = [m_infoViewRef frame];
-	fr.origin = [self frame].origin;
-
-	[self setFrame:fr
-		   display:YES];
+	mPendingString = [str copy];
+	mHasPendingContent = YES;
+	[self scheduleUpdate];
 }
 
 #pragma mark -
@@ -159,12 +157,81 @@
 
 - (void)positionAtScreenPoint:(NSPoint)sp
 {
-	[self setFrameOrigin:sp];
+	mPendingOrigin = sp;
+	mHasPendingOrigin = YES;
+	[self scheduleUpdate];
+}
+
+#pragma mark -
+
+- (void)scheduleUpdate
+{
+	// updates are coalesced to the display refresh - however many values and moves arrive during
+	// a drag, the window lays out and moves at most once per frame, with the newest of each. The
+	// timer goes into the common modes so it fires during event tracking.
+
+	if (mUpdateTimer == nil) {
+		mUpdateTimer = [NSTimer timerWithTimeInterval:[DKDrawingView displayRefreshPeriod]
+											   target:self
+											 selector:@selector(updateTimerFired:)
+											 userInfo:nil
+											  repeats:NO];
+		[[NSRunLoop currentRunLoop] addTimer:mUpdateTimer
+									 forMode:NSRunLoopCommonModes];
+	}
+}
+
+- (void)updateTimerFired:(NSTimer*)timer
+{
+#pragma unused(timer)
+	mUpdateTimer = nil;
+	[self flushPendingUpdate];
+}
+
+- (void)flushPendingUpdate
+{
+	NSRect fr = [self frame];
+	BOOL needsDisplay = NO;
+
+	if (mHasPendingContent) {
+		mHasPendingContent = NO;
+
+		// content that hasn't changed does no layout at all - common when a coordinate is
+		// quantised by a grid and many mouse positions map to the same displayed value
+
+		if (![mPendingString isEqualToString:mDisplayedString]) {
+			mDisplayedString = mPendingString;
+
+			if (mCachedTextColor == nil)
+				mCachedTextColor = [[self backgroundColor] contrastingColor];
+
+			[(NSTextField*)m_infoViewRef setTextColor:mCachedTextColor];
+			[m_infoViewRef setStringValue:mDisplayedString];
+			[m_infoViewRef sizeToFit];
+
+			fr.size = [m_infoViewRef frame].size;
+			needsDisplay = YES;
+		}
+	}
+
+	if (mHasPendingOrigin) {
+		mHasPendingOrigin = NO;
+		fr.origin = mPendingOrigin;
+	}
+
+	[self setFrame:fr
+		   display:needsDisplay];
 }
 
 #pragma mark -
 - (void)show
 {
+	// anything pending goes up before the window does
+
+	[mUpdateTimer invalidate];
+	mUpdateTimer = nil;
+	[self flushPendingUpdate];
+
 	[self setAlphaValue:0.95];
 	[self orderFront:self];
 }
@@ -184,6 +251,11 @@
 
 	colour = [colour colorUsingColorSpaceName:NSCalibratedRGBColorSpace];
 	[super setBackgroundColor:colour];
+
+	// the contrasting text colour is cached between updates, so recompute it on the next flush
+
+	mCachedTextColor = nil;
+	mDisplayedString = nil;
 }
 
 #pragma mark -
@@ -35,6 +35,31 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)registerActionName:(NSString*)na forKeyPath:(NSString*)kp objClass:(Class)cl;
 + (nullable NSString*)actionNameForKeyPath:(NSString*)kp objClass:(Class)cl;
 
+/** @brief Begins an observation transaction for a bulk edit.
+
+ While a transaction is open, the \c kDKObserverRelayDidReceiveChange notifications that the undo
+ relay normally posts for every individual property change are withheld; instead the changed
+ keypaths are accumulated in a compact per-object set. When the outermost transaction ends, one
+ consolidated notification is posted per changed object, so an inspector observing a style edit
+ applied to thousands of objects refreshes once instead of once per change. Undo registration is
+ unaffected - only the notification traffic is batched. Transactions nest; only the outermost
+ \c +endObservationTransaction delivers.
+ */
++ (void)beginObservationTransaction;
+
+/** @brief Ends an observation transaction, delivering the consolidated notifications.
+
+ When this closes the outermost transaction, one \c kDKObserverRelayDidReceiveChange notification
+ is posted per object changed during the transaction. Its userInfo carries the full set of changed
+ keypaths under <code>kDKObservableChangedKeyPaths</code> (and one of them under the usual
+ <code>kDKObservableKeyPath</code> key); the per-change old/new values are not retained.
+ */
++ (void)endObservationTransaction;
+
+/** @brief Whether an observation transaction is currently open.
+ */
++ (BOOL)observationTransactionInProgress;
+
 /**
  Subclasses can override to provide a list of observable properties for this class, which can be
  automatically registered with any nominated observer. This returns an empty array by default, allowing
@@ -83,5 +108,6 @@ NS_ASSUME_NONNULL_BEGIN
 
 extern NSNotificationName const kDKObserverRelayDidReceiveChange;
 extern NSString* const kDKObservableKeyPath;
+extern NSString* const kDKObservableChangedKeyPaths;
 
 NS_ASSUME_NONNULL_END
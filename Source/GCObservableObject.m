@@ -10,10 +10,22 @@
 #pragma mark Contants(Non - localized)
 NSString* const kDKObserverRelayDidReceiveChange = @"kDKObserverRelayDidReceiveChange";
 NSString* const kDKObservableKeyPath = @"kDKObservableKeyPath";
+NSString* const kDKObservableChangedKeyPaths = @"kDKObservableChangedKeyPaths";
+
+@interface GCObservableObject ()
++ (void)queueObservationTransactionChange:(NSString*)keypath ofObject:(id)object;
+@end
 
 #pragma mark Static Vars
 static NSMutableDictionary* sActionNameRegistry = nil;
 
+// observation transaction state - the depth counts nested begin/end pairs and the map table
+// accumulates the set of changed keypaths per object while a transaction is open. Keys are held
+// weakly so objects released mid-transaction simply drop out.
+
+static NSUInteger sObservationTransactionDepth = 0;
+static NSMapTable<id, NSMutableSet<NSString*>*>* sObservationTransactionChanges = nil;
+
 #pragma mark -
 @implementation GCObservableObject
 #pragma mark As a GCObservableObject
@@ -46,6 +58,62 @@ static NSMutableDictionary* sActionNameRegistry = nil;
 		return nil;
 }
 
+#pragma mark -
+
++ (void)beginObservationTransaction
+{
+	++sObservationTransactionDepth;
+}
+
++ (void)endObservationTransaction
+{
+	NSAssert(sObservationTransactionDepth > 0, @"unbalanced call to +endObservationTransaction");
+
+	if (sObservationTransactionDepth > 0 && --sObservationTransactionDepth == 0) {
+		NSMapTable* changes = sObservationTransactionChanges;
+		sObservationTransactionChanges = nil;
+
+		// deliver one consolidated notification per changed object. Note that any changes the
+		// delivery itself provokes are posted individually as usual - the transaction is over.
+
+		for (id object in changes) {
+			NSSet* keypaths = [[changes objectForKey:object] copy];
+
+			if ([keypaths count] == 0)
+				continue;
+
+			NSDictionary* info = @{ kDKObservableKeyPath: [keypaths anyObject],
+				kDKObservableChangedKeyPaths: keypaths };
+
+			[[NSNotificationCenter defaultCenter] postNotificationName:kDKObserverRelayDidReceiveChange
+																object:object
+															  userInfo:info];
+		}
+	}
+}
+
++ (BOOL)observationTransactionInProgress
+{
+	return sObservationTransactionDepth > 0;
+}
+
+/** @brief Records a change made while an observation transaction is open (internal). */
++ (void)queueObservationTransactionChange:(NSString*)keypath ofObject:(id)object
+{
+	if (sObservationTransactionChanges == nil)
+		sObservationTransactionChanges = [NSMapTable weakToStrongObjectsMapTable];
+
+	NSMutableSet* keypaths = [sObservationTransactionChanges objectForKey:object];
+
+	if (keypaths == nil) {
+		keypaths = [NSMutableSet set];
+		[sObservationTransactionChanges setObject:keypaths
+										   forKey:object];
+	}
+
+	[keypaths addObject:keypath];
+}
+
 + (NSArray*)observableKeyPaths
 {
 	// subclasses can override to provide a list of observable properties for this class, which can be
@@ -322,15 +390,22 @@ static NSMutableDictionary* sActionNameRegistry = nil;
 																			  objClass:[object class]]];
 	}
 
-	// also broadcast a general notification that one of our observees changed
-
-	NSMutableDictionary* changeDict = [change mutableCopy];
-	[changeDict setObject:keyPath
-				   forKey:kDKObservableKeyPath];
-
-	[[NSNotificationCenter defaultCenter] postNotificationName:kDKObserverRelayDidReceiveChange
-														object:object
-													  userInfo:changeDict];
+	// also broadcast a general notification that one of our observees changed. During an
+	// observation transaction the change key is queued instead, and one consolidated
+	// notification per object is delivered when the transaction commits.
+
+	if ([GCObservableObject observationTransactionInProgress]) {
+		[GCObservableObject queueObservationTransactionChange:keyPath
+													 ofObject:object];
+	} else {
+		NSMutableDictionary* changeDict = [change mutableCopy];
+		[changeDict setObject:keyPath
+					   forKey:kDKObservableKeyPath];
+
+		[[NSNotificationCenter defaultCenter] postNotificationName:kDKObserverRelayDidReceiveChange
+															object:object
+														  userInfo:changeDict];
+	}
 }
 
 @end
@@ -8,17 +8,34 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+/** @brief A bounded thread-safe FIFO queue.
+
+ The queue is multi-producer/multi-consumer and internally lock-free - producers and consumers operate on a
+ ring of slots with atomic sequence counters rather than convoying on a single mutex, so several worker
+ threads can enqueue and dequeue concurrently without serializing each other. The queue is bounded: \c enqueue:
+ blocks while the queue is full, just as \c dequeue blocks while it is empty.
+ */
 @interface GCThreadQueue : NSObject {
 @private
-	NSMutableArray* mQueue;
-	NSConditionLock* mLock;
+	struct GCThreadQueueRing* mRing;
+	dispatch_semaphore_t mItems; // counts objects available to dequeue
+	dispatch_semaphore_t mSpaces; // counts free slots available to enqueue
 }
 
-/**  */
-- (void)enqueue:(id)object;
+/** Designated initializer. \c capacity is rounded up to a power of two; the queue blocks producers once it
+ holds that many objects. \c -init uses a default capacity suitable for render-worker fan-out.
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity NS_DESIGNATED_INITIALIZER;
+
+- (void)enqueue:(id)object; // Blocks while the queue is full
 - (id)dequeue; // Blocks until there is an object to return
 - (nullable id)tryDequeue; // Returns NULL if the queue is empty
 
+/** Dequeues up to \c maxCount objects in one call without blocking, which lets a worker amortise the cost of
+ pulling work when items are plentiful. Returns \c nil if the queue is empty.
+ */
+- (nullable NSArray*)dequeueUpTo:(NSUInteger)maxCount;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -6,49 +6,189 @@
 
 #import "GCThreadQueue.h"
 
+#include <stdatomic.h>
+#include <sched.h>
+
+static const NSUInteger kGCThreadQueueDefaultCapacity = 1024;
+
+// the ring is the bounded MPMC queue described by Dmitry Vyukov: each cell carries a sequence counter that
+// encodes whether the cell is free, holds an object, and which "lap" of the ring it belongs to. Producers and
+// consumers claim cells by advancing the enqueue/dequeue positions with compare-and-swap, so neither side ever
+// takes a lock and producers do not contend with consumers except on a full or empty queue.
+
+typedef struct {
+	_Atomic uintptr_t seq;
+	void* obj;
+} GCThreadQueueCell;
+
+struct GCThreadQueueRing {
+	GCThreadQueueCell* cells;
+	uintptr_t mask; // capacity - 1; capacity is a power of two
+	_Atomic uintptr_t enqueuePos;
+	_Atomic uintptr_t dequeuePos;
+};
+
+static struct GCThreadQueueRing* ringCreate(NSUInteger capacity)
+{
+	// round capacity up to a power of two so that position & mask indexes the ring
+
+	NSUInteger cap = 2;
+	while (cap < capacity)
+		cap <<= 1;
+
+	struct GCThreadQueueRing* r = calloc(1, sizeof(struct GCThreadQueueRing));
+	r->cells = calloc(cap, sizeof(GCThreadQueueCell));
+	r->mask = cap - 1;
+
+	for (NSUInteger i = 0; i < cap; ++i)
+		atomic_store_explicit(&r->cells[i].seq, i, memory_order_relaxed);
+
+	return r;
+}
+
+static BOOL ringTryPush(struct GCThreadQueueRing* r, void* obj)
+{
+	GCThreadQueueCell* cell;
+	uintptr_t pos = atomic_load_explicit(&r->enqueuePos, memory_order_relaxed);
+
+	for (;;) {
+		cell = &r->cells[pos & r->mask];
+		uintptr_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&r->enqueuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if (dif < 0)
+			return NO; // full
+		else
+			pos = atomic_load_explicit(&r->enqueuePos, memory_order_relaxed);
+	}
+
+	cell->obj = obj;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+	return YES;
+}
+
+static BOOL ringTryPop(struct GCThreadQueueRing* r, void** outObj)
+{
+	GCThreadQueueCell* cell;
+	uintptr_t pos = atomic_load_explicit(&r->dequeuePos, memory_order_relaxed);
+
+	for (;;) {
+		cell = &r->cells[pos & r->mask];
+		uintptr_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&r->dequeuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if (dif < 0)
+			return NO; // empty
+		else
+			pos = atomic_load_explicit(&r->dequeuePos, memory_order_relaxed);
+	}
+
+	*outObj = cell->obj;
+	cell->obj = NULL;
+	atomic_store_explicit(&cell->seq, pos + r->mask + 1, memory_order_release);
+	return YES;
+}
+
 @implementation GCThreadQueue
 
 /**  */
 - (void)enqueue:(id)object
 {
-	[mLock lock];
-	[mQueue addObject:object];
-	[mLock unlockWithCondition:1];
+	// the space semaphore bounds the queue, so once it is acquired a slot is guaranteed; the push can still
+	// momentarily collide with a consumer finishing its claim on the same cell, hence the yield loop
+
+	dispatch_semaphore_wait(mSpaces, DISPATCH_TIME_FOREVER);
+
+	void* obj = (__bridge_retained void*)object;
+	while (!ringTryPush(mRing, obj))
+		sched_yield();
+
+	dispatch_semaphore_signal(mItems);
 }
 
 - (id)dequeue
 {
-	[mLock lockWhenCondition:1];
-	id element = [mQueue objectAtIndex:0];
-	[mQueue removeObjectAtIndex:0];
-	NSInteger count = [mQueue count];
-	[mLock unlockWithCondition:(count > 0) ? 1 : 0];
+	dispatch_semaphore_wait(mItems, DISPATCH_TIME_FOREVER);
+
+	void* obj = NULL;
+	while (!ringTryPop(mRing, &obj))
+		sched_yield();
+
+	dispatch_semaphore_signal(mSpaces);
 
-	return element;
+	return (__bridge_transfer id)obj;
 }
 
 - (id)tryDequeue
 {
-	id element = NULL;
-	if ([mLock tryLock]) {
-		if ([mLock condition] == 1) {
-			element = [mQueue objectAtIndex:0];
-			[mQueue removeObjectAtIndex:0];
-		}
-		NSInteger count = [mQueue count];
-		[mLock unlockWithCondition:(count > 0) ? 1 : 0];
+	if (dispatch_semaphore_wait(mItems, DISPATCH_TIME_NOW) != 0)
+		return NULL;
+
+	void* obj = NULL;
+	while (!ringTryPop(mRing, &obj))
+		sched_yield();
+
+	dispatch_semaphore_signal(mSpaces);
+
+	return (__bridge_transfer id)obj;
+}
+
+- (NSArray*)dequeueUpTo:(NSUInteger)maxCount
+{
+	NSMutableArray* batch = nil;
+	NSUInteger i;
+
+	for (i = 0; i < maxCount; ++i) {
+		id element = [self tryDequeue];
+
+		if (element == nil)
+			break;
+
+		if (batch == nil)
+			batch = [NSMutableArray arrayWithCapacity:maxCount];
+
+		[batch addObject:element];
 	}
-	return element;
+
+	return batch;
 }
 
-- (id)init
+- (instancetype)initWithCapacity:(NSUInteger)capacity
 {
 	self = [super init];
 	if (self != nil) {
-		mQueue = [[NSMutableArray alloc] init];
-		mLock = [[NSConditionLock alloc] initWithCondition:0];
+		mRing = ringCreate(capacity);
+		mItems = dispatch_semaphore_create(0);
+		mSpaces = dispatch_semaphore_create((long)(mRing->mask + 1));
 	}
 	return self;
 }
 
+- (id)init
+{
+	return [self initWithCapacity:kGCThreadQueueDefaultCapacity];
+}
+
+- (void)dealloc
+{
+	// release anything still queued. The space semaphore must be restored to its creation value as each
+	// item is drained, otherwise libdispatch traps when destroying a semaphore that is still "in use".
+
+	void* obj;
+	while (ringTryPop(mRing, &obj)) {
+		id element = (__bridge_transfer id)obj;
+		element = nil;
+		dispatch_semaphore_signal(mSpaces);
+	}
+
+	free(mRing->cells);
+	free(mRing);
+}
+
 @end
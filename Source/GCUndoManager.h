@@ -17,7 +17,8 @@ typedef NS_ENUM(NSInteger, GCUndoManagerState) {
 
 typedef NS_ENUM(NSInteger, GCUndoTaskCoalescingKind) {
 	kGCCoalesceLastTask = 0,
-	kGCCoalesceAllMatchingTasks = 1
+	kGCCoalesceAllMatchingTasks = 1,
+	kGCCoalesceFirstAndLastTasks = 2
 };
 
 @class GCUndoGroup, GCUndoManagerProxy, GCConcreteUndoTask;
@@ -69,6 +70,7 @@ The point of this is to provide an undo manager whose source is openly readable,
 	BOOL mAutoDeleteEmptyGroups; // YES if empty groups are automatically removed from the stack
 	BOOL mRetainsTargets; // YES if invocation targets are retained
 	BOOL mIsRemovingTargets; // YES during stack clean-up to prevent re-entrancy
+	NSUInteger mUndoMemoryBudget; // byte budget for retained history, 0 = unlimited
 }
 
 - (instancetype)init;
@@ -97,6 +99,27 @@ The point of this is to provide an undo manager whose source is openly readable,
  */
 @property (nonatomic) NSUInteger levelsOfUndo;
 
+/** @brief byte budget for retained undo history, 0 = unlimited (the default)
+
+ Long editing sessions can accumulate a great deal of retained undo payload (copied paths, styles,
+ metadata) well before any levels-of-undo count is reached. When a budget is set, every task records
+ an estimate of its retained payload as it is submitted and each group keeps a running total, so
+ enforcement only sums the per-group figures rather than walking the tasks. Whenever a top level
+ group closes over budget, the oldest undo actions are discarded first, then the oldest redo
+ actions; the most recent action on each stack is always kept so undo never goes completely dead.
+ The figures are estimates - object graph payloads are costed by class - so the budget is a bound
+ on the estimate, not an exact resident size.
+ */
+@property (nonatomic) NSUInteger undoMemoryBudget;
+
+/** @brief estimated bytes retained by the undo stack; the sum of its groups' running totals
+ */
+@property (readonly) NSUInteger undoStackByteSize;
+
+/** @brief estimated bytes retained by the redo stack; the sum of its groups' running totals
+ */
+@property (readonly) NSUInteger redoStackByteSize;
+
 // performing the undo or redo
 
 @property (readonly) BOOL canUndo;
@@ -158,6 +181,9 @@ The point of this is to provide an undo manager whose source is openly readable,
  \c kGCCoalesceAllMatchingTasks checks all in the current group. Last task is appropriate for property changes such as
  ABBBBBBA > ABA, where the last A needs to be included but the intermediate B's do not. The other kind is better for changes
  such as ABABABAB > AB where a repeated sequence is coalesced into a single example of the sequence.
+ \c kGCCoalesceFirstAndLastTasks keeps the first and most recent matching tasks and discards the intermediates, so
+ BBBBBB > BB. This suits dragging, where the first task captures the state undo must restore and the last captures the
+ state redo must reinstate - the group stays at two tasks per (target, selector) however long the gesture runs.
 */
 @property GCUndoTaskCoalescingKind coalescingKind;
 
@@ -204,6 +230,13 @@ The point of this is to provide an undo manager whose source is openly readable,
 - (void)clearRedoStack;
 - (void)checkpoint;
 
+/** @brief discards the oldest history until the retained payload estimate fits the budget.
+
+ Called automatically whenever a top level group closes and when the budget changes; does nothing
+ when no budget is set. The caller is responsible for the re-entrancy guard around stack clean-up.
+ */
+- (void)enforceMemoryBudget;
+
 /** @abstract sets the current state of the undo manager - set internally, not for client use
  */
 @property GCUndoManagerState undoManagerState;
@@ -231,6 +264,14 @@ The point of this is to provide an undo manager whose source is openly readable,
 @property (assign) GCUndoGroup* parentGroup;
 - (void)perform;
 
+/** @brief estimated bytes of payload this task retains.
+
+ Concrete tasks estimate this once at creation from their invocation's arguments; groups keep a
+ running total of their tasks, maintained through the parent chain as tasks are added, replaced
+ and removed. The base class returns 0.
+ */
+@property (readonly) NSUInteger byteSize;
+
 @end
 
 #pragma mark -
@@ -244,9 +285,14 @@ The point of this is to provide an undo manager whose source is openly readable,
 @private
 	NSString* mActionName;
 	NSMutableArray* mTasks;
+	NSUInteger mByteSize; // running total of the tasks' payload estimates, including subgroups
 }
 
 - (void)addTask:(GCUndoTask*)aTask;
+/** replaces \c oldTask with \c newTask in place, preserving its position within the group. Used by the
+ first-and-last coalescing kind to swap the most recent matching task for the newly submitted one.
+ */
+- (void)replaceTask:(GCUndoTask*)oldTask withTask:(GCUndoTask*)newTask;
 - (GCUndoTask*)taskAtIndex:(NSUInteger)indx;
 @property (readonly, nullable) GCConcreteUndoTask* lastTaskIfConcrete;
 @property (readonly, retain) NSArray<GCUndoTask*>* tasks;
@@ -256,6 +302,12 @@ The point of this is to provide an undo manager whose source is openly readable,
 @property (readonly, getter=isEmpty) BOOL empty;
 
 - (void)removeTasksWithTarget:(id)aTarget undoManager:(GCUndoManager*)um;
+
+/** adjusts the group's running byte total and propagates the adjustment up the parent chain, so
+ top level groups always carry the total for their whole subtree. Called internally as tasks are
+ added, replaced and removed.
+ */
+- (void)adjustByteSize:(NSInteger)delta;
 /** @brief The group's action name.
  
  In general, setting this is automatically handled by the owning undo manager.
@@ -267,13 +319,16 @@ The point of this is to provide an undo manager whose source is openly readable,
 #pragma mark -
 
 // concrete tasks wrap the NSInvocation which embodies the actual method call that is made when an action is undone or redone.
-// Concrete tasks own the invocation, which is set to always retain its target and arguments.
+// Concrete tasks own the invocation, which is set to always retain its target and arguments. Instances are allocated from
+// an internal arena that recycles the memory of deallocated tasks, since interactive sessions create and destroy them at
+// a high rate.
 
 @interface GCConcreteUndoTask : GCUndoTask {
 @private
 	NSInvocation* mInvocation;
 	id mTarget;
 	BOOL mTargetRetained;
+	NSUInteger mByteSize; // estimate of the retained payload, computed once at creation
 }
 
 - (instancetype)init UNAVAILABLE_ATTRIBUTE;
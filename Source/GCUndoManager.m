@@ -5,6 +5,10 @@
 */
 
 #import "GCUndoManager.h"
+#import "DKDrawKitMacros.h"
+
+#include <objc/runtime.h>
+#include <pthread.h>
 
 // this proxy object is returned by -prepareWithInvocationTarget: if GCUM_USE_PROXY is 1. This provides a similar behaviour to NSUndoManager
 // on 10.6 so that a wider range of methods can be submitted as undo tasks. Unlike 10.6 however, it does not bypass um's -forwardInvocation:
@@ -110,16 +114,20 @@
 			@finally {
 				//NSLog(@"top level group closed: %@", mOpenGroupRef);
 
+				DK_SIGNPOST_EVENT("GCUndoManager commit", self, "actions=%lu", (unsigned long)[self numberOfUndoActions]);
+
 				mOpenGroupRef = nil;
 
-				// keep the number of undo tasks at the top level limited to the undoLevels
-				// by discarding the oldest tasks
+				// keep the number of undo tasks at the top level limited to the undoLevels, and
+				// the retained history within the memory budget, by discarding the oldest tasks
 
-				if ([self levelsOfUndo] > 0 && !mIsRemovingTargets) {
+				if (!mIsRemovingTargets) {
 					mIsRemovingTargets = YES;
 
-					while ([self numberOfUndoActions] > [self levelsOfUndo])
-						[mUndoStack removeObjectAtIndex:0];
+					if ([self levelsOfUndo] > 0 && [self numberOfUndoActions] > [self levelsOfUndo])
+						[mUndoStack removeObjectsInRange:NSMakeRange(0, [self numberOfUndoActions] - [self levelsOfUndo])];
+
+					[self enforceMemoryBudget];
 
 					mIsRemovingTargets = NO;
 				}
@@ -224,21 +232,94 @@
 {
 	mLevelsOfUndo = levels;
 
-	// if the new levels are exceeded, trim the stacks accordingly
+	// if the new levels are exceeded, trim the stacks accordingly. The oldest actions are dropped
+	// in a single range removal rather than one at a time.
 
 	if (levels > 0 && !mIsRemovingTargets) {
 		mIsRemovingTargets = YES;
 
-		while ([self numberOfUndoActions] > levels)
-			[mUndoStack removeObjectAtIndex:0];
+		if ([self numberOfUndoActions] > levels)
+			[mUndoStack removeObjectsInRange:NSMakeRange(0, [self numberOfUndoActions] - levels)];
 
-		while ([self numberOfRedoActions] > levels)
-			[mRedoStack removeObjectAtIndex:0];
+		if ([self numberOfRedoActions] > levels)
+			[mRedoStack removeObjectsInRange:NSMakeRange(0, [self numberOfRedoActions] - levels)];
 
 		mIsRemovingTargets = NO;
 	}
 }
 
+- (void)setUndoMemoryBudget:(NSUInteger)budgetBytes
+{
+	mUndoMemoryBudget = budgetBytes;
+
+	// if the existing history exceeds the new budget, trim it right away
+
+	if (!mIsRemovingTargets) {
+		mIsRemovingTargets = YES;
+		[self enforceMemoryBudget];
+		mIsRemovingTargets = NO;
+	}
+}
+
+- (NSUInteger)undoMemoryBudget
+{
+	return mUndoMemoryBudget;
+}
+
+- (NSUInteger)undoStackByteSize
+{
+	// each top level group carries a running total for its subtree, so this is one addition per
+	// action, not a walk over the tasks
+
+	NSUInteger total = 0;
+
+	for (GCUndoGroup* group in mUndoStack)
+		total += [group byteSize];
+
+	return total;
+}
+
+- (NSUInteger)redoStackByteSize
+{
+	NSUInteger total = 0;
+
+	for (GCUndoGroup* group in mRedoStack)
+		total += [group byteSize];
+
+	return total;
+}
+
+- (void)enforceMemoryBudget
+{
+	// discards the oldest history until the retained payload estimate fits the budget. Oldest undo
+	// actions go first, then oldest redo actions; the most recent action on each stack is always
+	// kept, so the budget can never strip undo completely. Caller manages mIsRemovingTargets.
+
+	if (mUndoMemoryBudget == 0)
+		return;
+
+	NSUInteger total = [self undoStackByteSize] + [self redoStackByteSize];
+	NSUInteger dropCount = 0;
+
+	while (total > mUndoMemoryBudget && ([mUndoStack count] - dropCount) > 1) {
+		total -= [[mUndoStack objectAtIndex:dropCount] byteSize];
+		++dropCount;
+	}
+
+	if (dropCount > 0)
+		[mUndoStack removeObjectsInRange:NSMakeRange(0, dropCount)];
+
+	dropCount = 0;
+
+	while (total > mUndoMemoryBudget && ([mRedoStack count] - dropCount) > 1) {
+		total -= [[mRedoStack objectAtIndex:dropCount] byteSize];
+		++dropCount;
+	}
+
+	if (dropCount > 0)
+		[mRedoStack removeObjectsInRange:NSMakeRange(0, dropCount)];
+}
+
 @synthesize groupsByEvent = mGroupsByEvent;
 @synthesize levelsOfUndo = mLevelsOfUndo;
 @synthesize runLoopModes = mRunLoopModes;
@@ -570,6 +651,24 @@
 
 			if ([lastTask target] == [aTask target] && [lastTask selector] == [aTask selector])
 				return NO;
+		} else if ([self coalescingKind] == kGCCoalesceFirstAndLastTasks) {
+			// the first matching task is kept (it records the state undo must restore) and the most recent match is
+			// replaced in place by the new task (which records the state redo must reinstate), so the group holds at
+			// most two tasks per (target, selector) however many are submitted.
+
+			NSArray* matchingTasks = [[self currentGroup] tasksWithTarget:[aTask target]
+																 selector:[aTask selector]];
+
+			if ([matchingTasks count] >= 2) {
+				[[self currentGroup] replaceTask:[matchingTasks lastObject]
+										withTask:aTask];
+				++mChangeCount;
+
+				if ([self undoManagerState] == kGCUndoCollectingTasks)
+					[self clearRedoStack];
+
+				return YES;
+			}
 		} else {
 			NSArray* matchingTasks = [[self currentGroup] tasksWithTarget:[aTask target]
 																 selector:[aTask selector]];
@@ -849,6 +948,13 @@
 	NSAssert(NO, @"-perform must be overridden");
 }
 
+- (NSUInteger)byteSize
+{
+	// abstract - concrete tasks estimate their retained payload, groups total their tasks
+
+	return 0;
+}
+
 @end
 
 #pragma mark -
@@ -861,6 +967,24 @@
 
 	[mTasks addObject:aTask];
 	[aTask setParentGroup:self];
+	[self adjustByteSize:(NSInteger)[aTask byteSize]];
+}
+
+- (void)replaceTask:(GCUndoTask*)oldTask withTask:(GCUndoTask*)newTask
+{
+	// swaps <oldTask> for <newTask> without changing its position in the group. Used by first-and-last coalescing
+	// to keep only the most recent of a run of matching tasks.
+
+	NSUInteger indx = [mTasks indexOfObjectIdenticalTo:oldTask];
+
+	THROW_IF_FALSE1(indx != NSNotFound, @"task to replace was not found in group %@", self);
+
+	NSInteger delta = (NSInteger)[newTask byteSize] - (NSInteger)[oldTask byteSize];
+
+	[mTasks replaceObjectAtIndex:indx
+					  withObject:newTask];
+	[newTask setParentGroup:self];
+	[self adjustByteSize:delta];
 }
 
 - (GCUndoTask*)taskAtIndex:(NSUInteger)indx
@@ -942,17 +1066,30 @@
 			[(GCUndoGroup*)task removeTasksWithTarget:aTarget
 										  undoManager:um];
 
-			if ([(GCUndoGroup*)task isEmpty] && [um currentGroup] != task)
+			if ([(GCUndoGroup*)task isEmpty] && [um currentGroup] != task) {
+				[self adjustByteSize:-(NSInteger)[task byteSize]];
 				[mTasks removeObject:task];
+			}
 		} else if ([task respondsToSelector:@selector(target)]) {
-			if (aTarget == [(GCConcreteUndoTask*)task target])
+			if (aTarget == [(GCConcreteUndoTask*)task target]) {
+				[self adjustByteSize:-(NSInteger)[task byteSize]];
 				[mTasks removeObject:task];
+			}
 		}
 	}
 
 	[temp release];
 }
 
+- (void)adjustByteSize:(NSInteger)delta
+{
+	// keeps the running total for this group and every ancestor current, so a top level group's
+	// figure always covers its whole subtree and stack accounting never needs to walk the tasks
+
+	mByteSize = (NSUInteger)((NSInteger)mByteSize + delta);
+	[[self parentGroup] adjustByteSize:delta];
+}
+
 @synthesize actionName = mActionName;
 
 #pragma mark -
@@ -968,6 +1105,11 @@
 		[[self taskAtIndex:i] perform];
 }
 
+- (NSUInteger)byteSize
+{
+	return mByteSize;
+}
+
 #pragma mark -
 #pragma mark - as a NSObject
 
@@ -999,8 +1141,96 @@
 
 #pragma mark -
 
+// concrete undo tasks are created and destroyed at a very high rate during interactive editing, so their instances
+// are carved out of an arena rather than going through malloc/free individually. The arena grows a chunk of slots at
+// a time and deallocated instances return their slot to a free list for reuse; chunks are retained for the life of
+// the process, so the arena's footprint is bounded by the peak number of live tasks.
+
+#define kGCUndoTaskArenaChunkSlots 64
+
+static pthread_mutex_t sTaskArenaLock = PTHREAD_MUTEX_INITIALIZER;
+static void* sTaskFreeList = NULL;
+static size_t sTaskSlotSize = 0;
+
+// estimates the bytes retained by an invocation argument. Payload classes that commonly appear in
+// undo tasks (data, strings, paths, collections) are costed from their content; anything else gets
+// a nominal per-object figure. The result feeds the memory budget, so it needs to track relative
+// cost, not be exact.
+
+static NSUInteger gcEstimatedObjectSize(id obj)
+{
+	if (obj == nil)
+		return 0;
+
+	if ([obj isKindOfClass:[NSData class]])
+		return [(NSData*)obj length];
+
+	if ([obj isKindOfClass:[NSString class]])
+		return [(NSString*)obj length] * sizeof(unichar);
+
+	if ([obj isKindOfClass:[NSBezierPath class]])
+		return (NSUInteger)[(NSBezierPath*)obj elementCount] * (3 * sizeof(NSPoint) + sizeof(NSInteger));
+
+	if ([obj isKindOfClass:[NSArray class]] || [obj isKindOfClass:[NSSet class]]) {
+		NSUInteger total = 64;
+
+		for (id element in obj)
+			total += gcEstimatedObjectSize(element);
+
+		return total;
+	}
+
+	if ([obj isKindOfClass:[NSDictionary class]]) {
+		NSUInteger total = 64;
+
+		for (id key in obj)
+			total += gcEstimatedObjectSize(key) + gcEstimatedObjectSize([(NSDictionary*)obj objectForKey:key]);
+
+		return total;
+	}
+
+	return 64;
+}
+
 @implementation GCConcreteUndoTask
 
++ (id)allocWithZone:(NSZone*)zone
+{
+	// subclasses may add ivars, so only instances of this exact class are pooled
+
+	if (self != [GCConcreteUndoTask class])
+		return [super allocWithZone:zone];
+
+	void* slot;
+
+	pthread_mutex_lock(&sTaskArenaLock);
+
+	if (sTaskFreeList == NULL) {
+		// grow the arena by one chunk, threading its slots onto the free list. Slots are sized and aligned
+		// to 16 bytes, which satisfies the runtime's alignment requirements for object storage.
+
+		if (sTaskSlotSize == 0)
+			sTaskSlotSize = (class_getInstanceSize(self) + 15) & ~(size_t)15;
+
+		char* chunk = malloc(sTaskSlotSize * kGCUndoTaskArenaChunkSlots);
+		NSUInteger i = kGCUndoTaskArenaChunkSlots;
+
+		while (i-- > 0) {
+			void** p = (void**)(chunk + (i * sTaskSlotSize));
+			*p = sTaskFreeList;
+			sTaskFreeList = p;
+		}
+	}
+
+	slot = sTaskFreeList;
+	sTaskFreeList = *(void**)slot;
+
+	pthread_mutex_unlock(&sTaskArenaLock);
+
+	memset(slot, 0, sTaskSlotSize);
+	return objc_constructInstance(self, slot);
+}
+
 - (instancetype)initWithInvocation:(NSInvocation*)inv
 {
 	// designated initializer.
@@ -1016,6 +1246,24 @@
 			[inv setTarget:nil];
 			[inv retainArguments];
 			mInvocation = [inv retain];
+
+			// estimate the retained payload once, while the arguments are at hand - the task is
+			// immutable after submission, so the figure never needs recomputing
+
+			NSMethodSignature* sig = [inv methodSignature];
+			NSUInteger argIndex;
+
+			mByteSize = 128 + [sig frameLength];
+
+			for (argIndex = 2; argIndex < [sig numberOfArguments]; ++argIndex) {
+				if ([sig getArgumentTypeAtIndex:argIndex][0] == '@') {
+					id arg = nil;
+
+					[inv getArgument:&arg
+							 atIndex:argIndex];
+					mByteSize += gcEstimatedObjectSize(arg);
+				}
+			}
 		} else {
 			[self autorelease];
 			return nil;
@@ -1086,6 +1334,11 @@
 		[mInvocation invokeWithTarget:mTarget];
 }
 
+- (NSUInteger)byteSize
+{
+	return mByteSize;
+}
+
 #pragma mark -
 #pragma mark - as a NSObject
 
@@ -1102,6 +1355,20 @@
 	if (mTargetRetained)
 		[mTarget release];
 
+	if (object_getClass(self) == [GCConcreteUndoTask class]) {
+		// tear the instance down without freeing it, then return its slot to the arena. [super dealloc] is
+		// deliberately not called - it would pass the slot, an interior pointer of a chunk, to free().
+
+		objc_destructInstance(self);
+
+		pthread_mutex_lock(&sTaskArenaLock);
+		*(void**)self = sTaskFreeList;
+		sTaskFreeList = (void*)self;
+		pthread_mutex_unlock(&sTaskArenaLock);
+
+		return;
+	}
+
 	[super dealloc];
 }
 
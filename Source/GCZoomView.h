@@ -29,6 +29,8 @@ NS_ASSUME_NONNULL_BEGIN
 	NSUInteger mScrollwheelModifierMask;
 	BOOL mIsChangingScale;
 	DKRetriggerableTimer* mRT;
+	NSImage* mZoomPreviewCache; // snapshot of the rendered visible area, blitted while the zoom is changing
+	NSRect mZoomPreviewRect; // the area the snapshot covers, in document coordinates
 }
 
 /** @brief Return whether scroll-wheel zooming is enabled
@@ -150,6 +152,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property (readonly, getter=isChangingScale) BOOL changingScale;
 
+/** @brief Draw the zoom preview snapshot if a rapid zoom change is under way
+
+ When the scale starts changing, the view captures a bitmap snapshot of its rendered visible
+ area. While the change continues, drawing that snapshot through the view's transform is a cheap
+ scaled blit (slightly soft) in place of a full content render for every step of the gesture.
+ When the change settles the snapshot is discarded and the view redraws at full quality.
+
+ Subclasses with expensive content should call this first from \c drawRect: and skip their normal
+ drawing when it returns <code>YES</code>.
+ @param rect the update rect being drawn
+ @return YES if the preview was drawn and content drawing should be skipped, NO otherwise
+ */
+- (BOOL)drawZoomPreviewInRect:(NSRect)rect;
+
 /** @brief The minimum permitted view scale (zoom).
  */
 @property CGFloat minimumScale;
@@ -12,6 +12,7 @@
 
 - (void)stopScaleChange;
 - (void)startScaleChange;
+- (void)captureZoomPreview;
 
 @end
 
@@ -423,17 +424,72 @@ NSString* const kDKDrawingScrollwheelSensePrefsKey = @"kDKDrawingcrollwheelSense
 - (void)stopScaleChange
 {
 	mIsChangingScale = NO;
-	[self setNeedsDisplay:YES]; // redraw in high quality?
+	mZoomPreviewCache = nil;
+	[self setNeedsDisplay:YES]; // redraw in high quality
 
 	LogEvent_(kReactiveEvent, @"view stopped changing scale (%f): %@", [self scale], self);
 }
 
 - (void)startScaleChange
 {
+	// on the first step of a zoom gesture, snapshot the rendered visible area so that further
+	// steps can blit it instead of re-rendering the content - see drawZoomPreviewInRect:
+
+	if (!mIsChangingScale)
+		[self captureZoomPreview];
+
 	mIsChangingScale = YES;
 	[mRT retrigger];
 }
 
+- (void)captureZoomPreview
+{
+	NSRect vr = [self visibleRect];
+
+	mZoomPreviewCache = nil;
+
+	if (!NSIsEmptyRect(vr)) {
+		// this renders the content once at the gesture's starting scale - every subsequent step
+		// of the gesture is then just a scaled blit of the bitmap
+
+		NSBitmapImageRep* rep = [self bitmapImageRepForCachingDisplayInRect:vr];
+
+		if (rep != nil) {
+			[self cacheDisplayInRect:vr
+				toBitmapImageRep:rep];
+
+			mZoomPreviewCache = [[NSImage alloc] initWithSize:vr.size];
+			[mZoomPreviewCache addRepresentation:rep];
+			mZoomPreviewRect = vr;
+		}
+	}
+}
+
+- (BOOL)drawZoomPreviewInRect:(NSRect)rect
+{
+	if (![self isChangingScale] || mZoomPreviewCache == nil)
+		return NO;
+
+	// the snapshot covers a fixed document rect, so drawing it back into that rect lets the
+	// view's changed transform do the scaling. Areas newly exposed by zooming out are cleared
+	// to the window background.
+
+	[[NSColor windowBackgroundColor] set];
+	NSRectFill(rect);
+
+	NSImageInterpolation saved = [[NSGraphicsContext currentContext] imageInterpolation];
+	[[NSGraphicsContext currentContext] setImageInterpolation:NSImageInterpolationMedium];
+	[mZoomPreviewCache drawInRect:mZoomPreviewRect
+						 fromRect:NSZeroRect
+						operation:NSCompositeSourceOver
+						 fraction:1.0
+				   respectFlipped:YES
+							hints:nil];
+	[[NSGraphicsContext currentContext] setImageInterpolation:saved];
+
+	return YES;
+}
+
 #pragma mark -
 #pragma mark As an NSResponder
 
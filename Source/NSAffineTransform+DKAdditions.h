@@ -30,6 +30,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (NSAffineTransform*)flipVertical:(NSRect)bounds;
 
+/** @brief Apply the transform to an array of points in place.
+
+ The matrix components are fetched once and applied with simd arithmetic, so mapping a coordinate
+ array (e.g. \c DKShapeGroup repositioning its contents) avoids a message send and struct fetch
+ per point.
+ @param points the points to transform; replaced by their transformed values
+ @param count the number of points in the array
+ */
+- (void)transformPoints:(NSPoint*)points count:(NSUInteger)count;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -6,6 +6,8 @@
 
 #import "NSAffineTransform+DKAdditions.h"
 
+#include <simd/simd.h>
+
 @implementation NSAffineTransform (DKAdditions)
 
 - (NSAffineTransform*)mapFrom:(NSRect)src to:(NSRect)dst
@@ -67,4 +69,29 @@
 	return self;
 }
 
+- (void)transformPoints:(NSPoint*)points count:(NSUInteger)count
+{
+	NSAssert(points != NULL || count == 0, @"cannot transform a NULL point array");
+
+	if (count == 0)
+		return;
+
+	// fetch the matrix once and apply it as two columns plus a translation using simd arithmetic
+
+	NSAffineTransformStruct ts = [self transformStruct];
+
+	simd_double2 colX = simd_make_double2(ts.m11, ts.m12);
+	simd_double2 colY = simd_make_double2(ts.m21, ts.m22);
+	simd_double2 trans = simd_make_double2(ts.tX, ts.tY);
+
+	NSUInteger i;
+
+	for (i = 0; i < count; ++i) {
+		simd_double2 p = colX * points[i].x + colY * points[i].y + trans;
+
+		points[i].x = p.x;
+		points[i].y = p.y;
+	}
+}
+
 @end
@@ -100,14 +100,32 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
-// can be used by text drawers everywhere
+// can be used by text drawers everywhere. Layout stacks come from a checkout/checkin pool keyed by
+// configuration - borrow one for the duration of a layout or drawing pass and return it with
+// \c checkinLayoutManager() so it can be reused. Stacks that are never checked in are simply released,
+// so the legacy shared- functions below remain safe, just less efficient.
 
-/** @brief Supply a layout manager common to all \c DKTextShape instances
- @return the shared layout manager instance */
+/** @brief Borrow a preconfigured layout stack whose layout manager is of the given class
+ @return a checked-out layout manager instance */
+NSLayoutManager* checkoutLayoutManagerOfClass(Class lmClass);
+
+/** @brief Borrow a layout stack for drawing text
+ @return a checked-out layout manager instance */
+NSLayoutManager* checkoutDrawingLayoutManager(void);
+
+/** @brief Borrow a layout stack that captures text layout into a bezier path
+ @return a checked-out layout manager instance */
+DKBezierLayoutManager* checkoutCaptureLayoutManager(void);
+
+/** @brief Return a previously checked-out layout stack to the pool */
+void checkinLayoutManager(NSLayoutManager* lm);
+
+/** @brief Legacy name; identical to \c checkoutDrawingLayoutManager()
+ @return a checked-out layout manager instance */
 NSLayoutManager* sharedDrawingLayoutManager(void);
 
-/** @brief Supply a layout manager that can be used to capture text layout into a bezier path
- @return the shared layout manager instance */
+/** @brief Legacy name; identical to \c checkoutCaptureLayoutManager()
+ @return a checked-out layout manager instance */
 DKBezierLayoutManager* sharedCaptureLayoutManager(void);
 
 NS_ASSUME_NONNULL_END
@@ -11,62 +11,163 @@
 #import "NSAttributedString+DKAdditions.h"
 #import "NSBezierPath+Geometry.h"
 
-/** @brief Supply a layout manager common to all DKTextShape instances
- @return the shared layout manager instance */
-NSLayoutManager* sharedDrawingLayoutManager(void)
+#pragma mark -
+
+/** @brief checkout/checkin pool of preconfigured TextKit layout stacks.
+
+ Text rendering only needs a layout stack transiently - a stack is borrowed for the duration of one layout or
+ drawing pass and then returned - so stacks are pooled by configuration (the layout manager class) rather than
+ owned by text objects or held in per-class singletons. Memory then scales with how many layouts are in flight
+ at once, not with how many text objects exist, and concurrent renders each get their own stack instead of
+ contending for a shared one. A stack that is never checked back in is simply released and replaced.
+*/
+@interface DKTextLayoutStackPool : NSObject {
+	NSMutableDictionary<NSString*, NSMutableArray<NSLayoutManager*>*>* mStacks;
+	NSLock* mLock;
+}
+
++ (DKTextLayoutStackPool*)sharedPool;
+- (NSLayoutManager*)checkoutLayoutManagerOfClass:(Class)lmClass;
+- (void)checkinLayoutManager:(NSLayoutManager*)lm;
+
+@end
+
+// number of idle stacks retained per configuration; checkins beyond this are simply released
+
+#define kDKLayoutStackPoolCapacityPerKey 8
+
+@implementation DKTextLayoutStackPool
+
++ (DKTextLayoutStackPool*)sharedPool
 {
-	// This method returns an NSLayoutManager that can be used to draw the contents of a DKTextShape.
-	// The same layout manager is used for all instances of the class
+	static DKTextLayoutStackPool* sPool = nil;
+	static dispatch_once_t onceToken;
+	dispatch_once(&onceToken, ^{
+		sPool = [[DKTextLayoutStackPool alloc] init];
+	});
 
-	static NSLayoutManager* sharedLM = nil;
-	NSTextContainer* tc = nil;
+	return sPool;
+}
 
-	if (sharedLM == nil) {
-		tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		//NSTextView*	tv = [[NSTextView alloc] initWithFrame:NSZeroRect];
+- (instancetype)init
+{
+	self = [super init];
+	if (self != nil) {
+		mStacks = [[NSMutableDictionary alloc] init];
+		mLock = [[NSLock alloc] init];
+	}
 
-		sharedLM = [[NSLayoutManager alloc] init];
+	return self;
+}
+
+- (NSLayoutManager*)checkoutLayoutManagerOfClass:(Class)lmClass
+{
+	NSString* key = NSStringFromClass(lmClass);
+	NSLayoutManager* lm = nil;
+
+	[mLock lock];
+	NSMutableArray<NSLayoutManager*>* stack = [mStacks objectForKey:key];
+
+	if ([stack count] > 0) {
+		lm = [stack lastObject];
+		[stack removeLastObject];
+	}
+	[mLock unlock];
+
+	if (lm == nil) {
+		// nothing idle for this configuration, so build a fresh stack
+
+		DKBezierTextContainer* tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
 
-		//[tc setTextView:tv];
-		//[tv release];
+		lm = [[lmClass alloc] init];
+
+		// the capture configuration needs a text view attached so that glyph capture has editing metrics
+
+		if (lmClass == [DKBezierLayoutManager class]) {
+			NSTextView* tv = [[NSTextView alloc] initWithFrame:NSZeroRect];
+			[tc setTextView:tv];
+		}
 
 		[tc setWidthTracksTextView:NO];
 		[tc setHeightTracksTextView:NO];
-		[sharedLM addTextContainer:tc];
+		[lm addTextContainer:tc];
 
-		[sharedLM setUsesScreenFonts:NO];
-	} else
-		tc = [[sharedLM textContainers] lastObject];
+		[lm setUsesScreenFonts:NO];
+	}
 
-	[tc setLineFragmentPadding:0];
-	return sharedLM;
+	[[[lm textContainers] lastObject] setLineFragmentPadding:0];
+	return lm;
 }
 
-/** @brief Supply a layout manager that can be used to capture text layout into a bezier path
- @return the shared layout manager instance */
-DKBezierLayoutManager* sharedCaptureLayoutManager(void)
+- (void)checkinLayoutManager:(NSLayoutManager*)lm
 {
-	static DKBezierLayoutManager* sharedLM = nil;
-	NSTextContainer* tc = nil;
+	if (lm == nil)
+		return;
 
-	if (sharedLM == nil) {
-		tc = [[DKBezierTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)];
-		NSTextView* tv = [[NSTextView alloc] initWithFrame:NSZeroRect];
+	// detach from any text storage still holding the stack, and drop any layout path the borrower set
 
-		sharedLM = [[DKBezierLayoutManager alloc] init];
+	[[lm textStorage] removeLayoutManager:lm];
 
-		[tc setTextView:tv];
+	id tc = [[lm textContainers] lastObject];
 
-		[tc setWidthTracksTextView:NO];
-		[tc setHeightTracksTextView:NO];
-		[sharedLM addTextContainer:tc];
+	if ([tc respondsToSelector:@selector(setBezierPath:)])
+		[tc setBezierPath:nil];
 
-		[sharedLM setUsesScreenFonts:NO];
-	} else
-		tc = [[sharedLM textContainers] lastObject];
+	NSString* key = NSStringFromClass([lm class]);
+
+	[mLock lock];
+	NSMutableArray<NSLayoutManager*>* stack = [mStacks objectForKey:key];
+
+	if (stack == nil) {
+		stack = [NSMutableArray array];
+		[mStacks setObject:stack
+					forKey:key];
+	}
+
+	if ([stack count] < kDKLayoutStackPoolCapacityPerKey)
+		[stack addObject:lm];
+	[mLock unlock];
+}
+
+@end
+
+NSLayoutManager* checkoutLayoutManagerOfClass(Class lmClass)
+{
+	return [[DKTextLayoutStackPool sharedPool] checkoutLayoutManagerOfClass:lmClass];
+}
+
+NSLayoutManager* checkoutDrawingLayoutManager(void)
+{
+	return checkoutLayoutManagerOfClass([NSLayoutManager class]);
+}
+
+DKBezierLayoutManager* checkoutCaptureLayoutManager(void)
+{
+	return (DKBezierLayoutManager*)checkoutLayoutManagerOfClass([DKBezierLayoutManager class]);
+}
+
+void checkinLayoutManager(NSLayoutManager* lm)
+{
+	[[DKTextLayoutStackPool sharedPool] checkinLayoutManager:lm];
+}
+
+/** @brief Supply a layout manager for drawing the contents of a DKTextShape
+ @return a checked-out layout manager instance */
+NSLayoutManager* sharedDrawingLayoutManager(void)
+{
+	// legacy name - the result now comes from the layout stack pool and should be returned with
+	// checkinLayoutManager() when the caller is done with it
+
+	return checkoutDrawingLayoutManager();
+}
+
+/** @brief Supply a layout manager that can be used to capture text layout into a bezier path
+ @return a checked-out layout manager instance */
+DKBezierLayoutManager* sharedCaptureLayoutManager(void)
+{
+	// legacy name - see above
 
-	[tc setLineFragmentPadding:0];
-	return sharedLM;
+	return checkoutCaptureLayoutManager();
 }
 
 @implementation NSAttributedString (DKAdditions)
@@ -104,7 +205,7 @@ DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 	if ([contents length] > 0) {
 		NSSize textSize = [layoutPath bounds].size;
 		NSRect srcRect;
-		NSLayoutManager* layoutMgr = sharedDrawingLayoutManager();
+		NSLayoutManager* layoutMgr = checkoutDrawingLayoutManager();
 		DKBezierTextContainer* textContainer = (id)[[layoutMgr textContainers] lastObject];
 
 		srcRect.size = textSize;
@@ -167,6 +268,7 @@ DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 		}
 		[contents removeLayoutManager:layoutMgr];
 		[textContainer setBezierPath:nil];
+		checkinLayoutManager(layoutMgr);
 	}
 }
 
@@ -179,7 +281,7 @@ DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 	NSTextStorage* contents = [[NSTextStorage alloc] initWithAttributedString:self];
 
 	if ([contents length] > 0) {
-		NSLayoutManager* layoutMgr = sharedDrawingLayoutManager();
+		NSLayoutManager* layoutMgr = checkoutDrawingLayoutManager();
 		DKBezierTextContainer* textContainer = (id)[[layoutMgr textContainers] lastObject];
 
 		[textContainer setBezierPath:nil];
@@ -192,6 +294,7 @@ DKBezierLayoutManager* sharedCaptureLayoutManager(void)
 			as = [layoutMgr usedRectForTextContainer:textContainer].size;
 
 		[contents removeLayoutManager:layoutMgr];
+		checkinLayoutManager(layoutMgr);
 	}
 
 	return as;
@@ -62,6 +62,11 @@ optionally maintains colinearity across curve joins, and knows how to maintain c
 - (NSInteger)partcodeHitByPoint:(NSPoint)p tolerance:(CGFloat)t prioritiseOnPathPoints:(BOOL)onpPriority;
 - (NSInteger)partcodeHitByPoint:(NSPoint)p tolerance:(CGFloat)t startingFromElement:(NSInteger)startElement;
 - (NSInteger)partcodeHitByPoint:(NSPoint)p tolerance:(CGFloat)t startingFromElement:(NSInteger)startElement prioritiseOnPathPoints:(BOOL)onpPriority;
+
+/** @brief As <code>partcodeHitByPoint:tolerance:prioritiseOnPathPoints:</code>, but only the listed element
+ indexes are examined. Callers that bucket the control points spatially use this to test just the elements
+ near the point instead of scanning the whole path. */
+- (NSInteger)partcodeHitByPoint:(NSPoint)p tolerance:(CGFloat)t candidateElements:(NSIndexSet*)candidates prioritiseOnPathPoints:(BOOL)onpPriority;
 - (NSInteger)partcodeForLastPoint;
 - (NSPoint)referencePointForConstrainedPartcode:(NSInteger)pc;
 
@@ -96,4 +101,7 @@ optionally maintains colinearity across curve joins, and knows how to maintain c
 NSInteger partcodeForElement(const NSInteger element);
 NSInteger partcodeForElementControlPoint(const NSInteger element, const NSInteger controlPointIndex);
 
+/** @brief Returns the element index a partcode refers to. The inverse of the two functions above. */
+NSInteger elementIndexForPartcode(const NSInteger pc);
+
 NS_ASSUME_NONNULL_END
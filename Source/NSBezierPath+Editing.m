@@ -9,6 +9,7 @@
 #import "DKGeometryUtilities.h"
 #import "LogEvent.h"
 #import "NSBezierPath+Geometry.h"
+#import <objc/runtime.h>
 
 #define USE_OMNI_METHODS 0
 
@@ -22,12 +23,125 @@ static CGFloat sAngleConstraint = 0.261799387799; // 15°
 // simple partcode cracking utils:
 
 static inline NSInteger arrayIndexForPartcode(const NSInteger pc);
-static inline NSInteger elementIndexForPartcode(const NSInteger pc);
+
+@interface NSBezierPath (DKEditingPrivate)
+
+/** tests the control points the full partcode scan examines at element <i> */
+- (NSInteger)partcodeHitAtElement:(NSInteger)i point:(NSPoint)p tolerance:(CGFloat)t prioritiseOnPathPoints:(BOOL)onpPriority;
+
+@end
+
+#pragma mark -
+
+/** @brief Contiguous snapshot of a path's element types and subpath topology.
+
+ Dragging a control point issues several topology queries per mouse move (is the subpath closed, where does
+ it start and end, what type is the neighbouring element), and each one walked the path element-by-element
+ through AppKit, so edit latency grew with path size. Moving control points never changes element types, so
+ the types are captured once into plain C arrays along with the nearest moveto in each direction and whether
+ a closepath lies ahead, making every query a table lookup. The buffer is cached on the path as an associated
+ object and rebuilt when the element count changes.
+*/
+@interface DKPathElementBuffer : NSObject {
+@public
+	NSBezierPathElement* mTypes; // element types, contiguous
+	NSInteger* mPrevMove; // index of nearest moveto at or before each element (-1 if none)
+	NSInteger* mNextMove; // index of nearest moveto at or after each element (count if none)
+	BOOL* mClosedAhead; // whether a closepath exists at or after each element
+	NSInteger mElementCount;
+}
+
++ (DKPathElementBuffer*)bufferForPath:(NSBezierPath*)path;
+- (BOOL)isValidForPath:(NSBezierPath*)path;
+
+@end
+
+@implementation DKPathElementBuffer
+
++ (DKPathElementBuffer*)bufferForPath:(NSBezierPath*)path
+{
+	DKPathElementBuffer* buf = [[DKPathElementBuffer alloc] init];
+	NSInteger i, ec = [path elementCount];
+
+	buf->mElementCount = ec;
+
+	if (ec > 0) {
+		buf->mTypes = (NSBezierPathElement*)malloc((size_t)ec * sizeof(NSBezierPathElement));
+		buf->mPrevMove = (NSInteger*)malloc((size_t)ec * sizeof(NSInteger));
+		buf->mNextMove = (NSInteger*)malloc((size_t)ec * sizeof(NSInteger));
+		buf->mClosedAhead = (BOOL*)malloc((size_t)ec * sizeof(BOOL));
+
+		NSInteger prevMove = -1;
+
+		for (i = 0; i < ec; ++i) {
+			buf->mTypes[i] = [path elementAtIndex:i];
+
+			if (buf->mTypes[i] == NSMoveToBezierPathElement)
+				prevMove = i;
+
+			buf->mPrevMove[i] = prevMove;
+		}
+
+		NSInteger nextMove = ec;
+		BOOL closed = NO;
+
+		for (i = ec - 1; i >= 0; --i) {
+			if (buf->mTypes[i] == NSClosePathBezierPathElement)
+				closed = YES;
+
+			if (buf->mTypes[i] == NSMoveToBezierPathElement)
+				nextMove = i;
+
+			buf->mNextMove[i] = nextMove;
+			buf->mClosedAhead[i] = closed;
+		}
+	}
+
+	return buf;
+}
+
+- (BOOL)isValidForPath:(NSBezierPath*)path
+{
+	// moving control points never changes an element's type, and no public NSBezierPath operation can change
+	// a type without also changing the element count, so the count is a sufficient validity check
+
+	return mElementCount == [path elementCount];
+}
+
+- (void)dealloc
+{
+	if (mTypes)
+		free(mTypes);
+	if (mPrevMove)
+		free(mPrevMove);
+	if (mNextMove)
+		free(mNextMove);
+	if (mClosedAhead)
+		free(mClosedAhead);
+}
+
+@end
+
+static const void* kDKElementBufferKey = &kDKElementBufferKey;
 
 #pragma mark -
 @implementation NSBezierPath (DKEditing)
 #pragma mark As an NSBezierPath
 
+- (DKPathElementBuffer*)elementBuffer
+{
+	// returns the cached element buffer for this path, rebuilding it if the path's structure has changed
+
+	DKPathElementBuffer* buf = objc_getAssociatedObject(self, kDKElementBufferKey);
+
+	if (buf == nil || ![buf isValidForPath:self]) {
+		buf = [DKPathElementBuffer bufferForPath:self];
+		objc_setAssociatedObject(self, kDKElementBufferKey, buf, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	return buf;
+}
+
 + (void)setConstraintAngle:(CGFloat)radians
 {
 	sAngleConstraint = radians;
@@ -396,17 +510,12 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 	// a. there is a closepath command at or higher than element, OR
 	// b. the endpoint of the last element is at the same location as the previous moveto.
 
-	// a - look ahead for a closepath
-
-	NSInteger i, ec = [self elementCount];
-	NSBezierPathElement et;
+	// a - look ahead for a closepath (precomputed by the element buffer, so this is a table lookup)
 
-	for (i = element; i < ec; ++i) {
-		et = [self elementAtIndex:i];
+	DKPathElementBuffer* buf = [self elementBuffer];
 
-		if (et == NSClosePathBezierPathElement)
-			return YES;
-	}
+	if (element >= 0 && element < buf->mElementCount && buf->mClosedAhead[element])
+		return YES;
 
 	// b - look for start and end being the same
 	/*
@@ -437,39 +546,30 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 {
 	// finds the starting element for the subpath containing <element> This will always be a moveto element.
 
-	NSBezierPathElement et;
-	NSInteger i;
-
-	for (i = element; i >= 0; --i) {
-		et = [self elementAtIndex:i];
+	DKPathElementBuffer* buf = [self elementBuffer];
 
-		if (et == NSMoveToBezierPathElement)
-			return i;
-	}
+	if (element < 0 || element >= buf->mElementCount)
+		return -1;
 
-	return -1;
+	return buf->mPrevMove[element];
 }
 
 - (NSInteger)subpathEndingElementForElement:(NSInteger)element
 {
 	// finds the ending element for the subpath containing <element> This may be any type except a moveto.
 
-	NSBezierPathElement et;
-	NSInteger i, ec = [self elementCount];
-
-	et = [self elementAtIndex:element];
+	DKPathElementBuffer* buf = [self elementBuffer];
+	NSInteger ec = buf->mElementCount;
 
-	if (et == NSMoveToBezierPathElement)
+	if (buf->mTypes[element] == NSMoveToBezierPathElement)
 		++element;
 
-	for (i = element; i < ec; ++i) {
-		et = [self elementAtIndex:i];
+	if (element >= ec)
+		return ec - 1;
 
-		if (et == NSMoveToBezierPathElement)
-			return i - 1;
-	}
+	// mNextMove holds ec when no further moveto exists, so this also yields ec - 1 for the last subpath
 
-	return ec - 1;
+	return buf->mNextMove[element] - 1;
 }
 
 #pragma mark -
@@ -490,7 +590,13 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 {
 	// returns the element type given a partcode
 
-	return [self elementAtIndex:elementIndexForPartcode(pc)];
+	DKPathElementBuffer* buf = [self elementBuffer];
+	NSInteger elem = elementIndexForPartcode(pc);
+
+	if (elem >= 0 && elem < buf->mElementCount)
+		return buf->mTypes[elem];
+
+	return [self elementAtIndex:elem]; // out of range - raises, as it always did
 }
 
 - (BOOL)isOnPathPartcode:(NSInteger)pc
@@ -574,16 +680,65 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 	if (!NSPointInRect(p, NSInsetRect(bb, -thalf, -thalf)))
 		return 0;
 
-	// scan through looking for hits in any control point. The test order here looks for curve control points
+	NSInteger pc, i, ec = [self elementCount];
+
+	for (i = startElement + 1; i < ec; ++i) {
+		pc = [self partcodeHitAtElement:i
+								  point:p
+							  tolerance:t
+				 prioritiseOnPathPoints:onpPriority];
+
+		if (pc != 0)
+			return pc;
+	}
+
+	return 0;
+}
+
+- (NSInteger)partcodeHitByPoint:(NSPoint)p tolerance:(CGFloat)t candidateElements:(NSIndexSet*)candidates prioritiseOnPathPoints:(BOOL)onpPriority
+{
+	// as above, but only the listed element indexes are examined. Callers that maintain a spatial index of the
+	// control points use this to test just the handful of elements near the point instead of the whole path.
+	// Candidates are visited in ascending order, so ties resolve identically to the full scan.
+
+	CGFloat thalf = 0.5 * t;
+	NSRect bb = [self controlPointBounds];
+
+	if (!NSPointInRect(p, NSInsetRect(bb, -thalf, -thalf)))
+		return 0;
+
+	NSInteger pc, ec = [self elementCount];
+	NSUInteger i;
+
+	for (i = [candidates firstIndex]; i != NSNotFound; i = [candidates indexGreaterThanIndex:i]) {
+		if (i < 1 || (NSInteger)i >= ec)
+			continue;
+
+		pc = [self partcodeHitAtElement:(NSInteger)i
+								  point:p
+							  tolerance:t
+				 prioritiseOnPathPoints:onpPriority];
+
+		if (pc != 0)
+			return pc;
+	}
+
+	return 0;
+}
+
+- (NSInteger)partcodeHitAtElement:(NSInteger)i point:(NSPoint)p tolerance:(CGFloat)t prioritiseOnPathPoints:(BOOL)onpPriority
+{
+	// tests the control points examined when the full scan reaches element <i> - the element's own points and
+	// the on-path point of the element before it. The test order here looks for curve control points
 	// in preference to on-path points so that if they lie at the same point, the cp is detected. This makes it
 	// possible for the user to drag a cp away from an underlying on-path point. This behaviour is inverted if <onpPriority> is YES
 
 	NSBezierPathElement et, pet;
 	NSPoint ap[3], lp[3];
 
-	NSInteger pc, i, ec = [self elementCount];
+	NSInteger pc, ec = [self elementCount];
 
-	for (i = startElement + 1; i < ec; ++i) {
+	{
 		pet = [self elementAtIndex:i - 1
 				  associatedPoints:lp];
 		et = [self elementAtIndex:i
@@ -789,14 +944,16 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 
 	++depth;
 
+	DKPathElementBuffer* buf = [self elementBuffer];
+
 	prev = MAX(0, element - 1);
 	next = element + 1;
 
 	if (element < (ec - 1))
-		following = [self elementAtIndex:next];
+		following = buf->mTypes[next];
 
 	if (element > 0)
-		previous = [self elementAtIndex:prev];
+		previous = buf->mTypes[prev];
 
 	// refPt is the point that the moved point will be referenced to when constraints are applied.
 
@@ -855,7 +1012,7 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 					// the point being moved is cp2 of the last element in the loop, if it's a curve
 
 					NSInteger le = [self subpathEndingElementForElement:element];
-					previous = [self elementAtIndex:le];
+					previous = buf->mTypes[le];
 
 					if (previous == NSCurveToBezierPathElement) {
 						centre = [self controlPointForPartcode:partcodeForElement(prev)];
@@ -904,7 +1061,7 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 
 					NSInteger e2 = [self subpathStartingElementForElement:element] + 1;
 
-					following = [self elementAtIndex:e2];
+					following = buf->mTypes[e2];
 					if (following == NSCurveToBezierPathElement) {
 						centre = [self controlPointForPartcode:partcodeForElementControlPoint(element, 2)];
 
@@ -975,7 +1132,7 @@ static inline NSInteger elementIndexForPartcode(const NSInteger pc);
 		if (depth == 1 && closedLoop && (et == NSMoveToBezierPathElement) && colin) {
 			NSInteger ee = [self subpathEndingElementForElement:element];
 			//	LogEvent_(kReactiveEvent, @"recursing to adjust element %d", ee );
-			following = [self elementAtIndex:ee];
+			following = buf->mTypes[ee];
 
 			if (following == NSCurveToBezierPathElement)
 				[self moveControlPointPartcode:partcodeForElementControlPoint(ee, 2)
@@ -1589,7 +1746,7 @@ inline NSInteger arrayIndexForPartcode(const NSInteger pc)
 	return (pc & 3);
 }
 
-inline NSInteger elementIndexForPartcode(const NSInteger pc)
+NSInteger elementIndexForPartcode(const NSInteger pc)
 {
 	// returns the element index a partcode is referring to
 
@@ -10,6 +10,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 @protocol DKBezierElementIterationDelegate;
 
+/** @brief Everything the zero-allocation iteration API knows about one path element.
+
+ The \c points list uses the same ordering as <code>DKBezierElementIterationDelegate</code>:
+ 0 = the next on-path point, 1 = cp1 and 2 = cp2 for a curve element, 3 = the last on-path point of the
+ current subpath.
+ */
+typedef struct {
+	NSInteger elementIndex;
+	NSBezierPathElement type;
+	NSPoint points[4];
+	NSInteger subPathIndex;
+	BOOL subPathClosed;
+} DKBezierElementInfo;
+
+/** @brief Per-element callback for <code>-bezierPathByIteratingWithFunction:contextInfo:</code>.
+
+ The function appends whatever output it wants for the element to \c outPath using the plain
+ \c CGPath* functions - no Objective-C dispatch is involved anywhere in the loop.
+ */
+typedef void (*DKBezierElementIterationFunction)(CGMutablePathRef outPath, const DKBezierElementInfo* element, void* _Nullable contextInfo);
+
 @interface NSBezierPath (Geometry)
 
 // simple transformations
@@ -66,6 +87,31 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable NSBezierPath*)bezierPathByIteratingWithDelegate:(id<DKBezierElementIterationDelegate>)delegate contextInfo:(nullable void*)contextInfo;
 
+/** @brief Bulk-extracts the path's elements into caller-supplied C arrays.
+
+ One call fills both arrays, instead of one \c -elementAtIndex:associatedPoints: message per element,
+ so transforms that walk large paths can run as tight C loops over the raw buffers. The point triples
+ use the native ordering of <code>-elementAtIndex:associatedPoints:</code> (cp1, cp2, endpoint for
+ curves; the point in slot 0 otherwise). Either array may be \c NULL if not wanted.
+ @param types an array with capacity for at least \c maxCount element types, or \c NULL
+ @param points an array with capacity for at least \c maxCount point triples, or \c NULL
+ @param maxCount the capacity of the arrays
+ @return the number of elements written
+ */
+- (NSInteger)getElementTypes:(nullable NSBezierPathElement*)types associatedPoints:(NSPoint (*_Nullable)[3])points maxCount:(NSInteger)maxCount;
+
+/** @brief The zero-allocation counterpart of <code>-bezierPathByIteratingWithDelegate:contextInfo:</code>.
+
+ The receiver's elements are extracted once into a flat buffer, the subpath bookkeeping (index, closed
+ flag, final on-path point) is computed in the same pass, and the function is then invoked for each
+ element from a tight loop - no per-element message sends, and the output is accumulated in a Quartz
+ mutable path acting as the element arena, converted to an \c NSBezierPath once at the end.
+ @param function the per-element callback that builds the output path
+ @param contextInfo passed through to the callback
+ @return the built path, or nil if the receiver is empty
+ */
+- (nullable NSBezierPath*)bezierPathByIteratingWithFunction:(DKBezierElementIterationFunction)function contextInfo:(nullable void*)contextInfo;
+
 /** @brief returns a copy of the receiver modified by offsetting all of its control points by \c delta in the direction of the
  normal of the path at the location of the on-path control point.
  
@@ -84,6 +130,14 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSBezierPath*)bezierPathByInterpolatingPath:(CGFloat)amount;
 
+/** @brief Smooths several paths concurrently, returning the results in the input order.
+
+ Convenience for import pipelines that smooth every polyline they read: each path is handed to
+ \c -bezierPathByInterpolatingPath: on its own, spread across the available cores. Blocks until
+ all the paths are done.
+ */
++ (NSArray<NSBezierPath*>*)pathsByInterpolatingPaths:(NSArray<NSBezierPath*>*)paths amount:(CGFloat)amount;
+
 // calculating a fillet
 
 - (NSBezierPath*)filletPathForVertex:(const NSPoint[_Nonnull 3])vp filletSize:(CGFloat)fs;
@@ -121,7 +175,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 // finding path lengths for points and points for lengths
 
+/** @brief Returns the point and slope at a given distance along the path.
+
+ The first call flattens the path once and builds a cumulative arc-length table which is cached with the
+ path, so subsequent lookups (per-glyph placement in text-on-path, motifs at intervals, etc.) are a binary
+ search rather than a trim-and-rewalk of the whole path. The cache is checked against the path's element
+ count and bounds and is rebuilt if the path appears to have been mutated; call
+ -invalidateCachedArcLengthTable after in-place edits that don't change either.
+*/
 - (NSPoint)pointOnPathAtLength:(CGFloat)length slope:(nullable CGFloat*)slope;
+
+/** @brief Discards the cached arc-length table used by -pointOnPathAtLength:slope: and the cached interior map. */
+- (void)invalidateCachedArcLengthTable;
+
+/** @brief Point containment using a cached coarse winding raster.
+
+ Equivalent to -containsPoint: but suited to repeated queries against the same path (hit testing and pattern
+ clipping during editing). The first call rasterizes the path's winding into a coarse cell map cached with the
+ path; thereafter interior/exterior answers are a single cell test and only points in cells crossed by the
+ outline run the exact winding math. The cache validates against element count and bounds like the length tables.
+*/
+- (BOOL)containsPointUsingInteriorMap:(NSPoint)pt;
 @property (readonly) CGFloat slopeStartingPath;
 - (CGFloat)distanceFromStartOfPathAtPoint:(NSPoint)p tolerance:(CGFloat)tol;
 
@@ -187,6 +261,16 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (nullable NSBezierPath*)bezierPathByTrimmingFromLength:(CGFloat)startLength toLength:(CGFloat)newLength withMaximumError:(CGFloat)maxError;
 
+/** @brief Single-pass core for the combined trimming operations.
+
+ Emits the kept portion of the path in one walk over the elements, using the cached per-element
+ length table, where chaining the individual trims rebuilds and re-measures the whole path at each
+ step. With \c invert \c NO the arc-length range from \c startLength to \c endLength is kept (the
+ two-ended trim of an arrow shaft); with \c invert \c YES that range is knocked out and the two
+ flanking pieces are kept, joined by a gap. The convenience trims above route through this.
+ */
+- (NSBezierPath*)trimmedPathFromLength:(CGFloat)startLength toLength:(CGFloat)endLength invert:(BOOL)invert withMaximumError:(CGFloat)maxError;
+
 /** @brief Create an \c NSBezierPath containing an arrowhead for the start of this path
  */
 - (NSBezierPath*)bezierPathWithArrowHeadForStartOfLength:(CGFloat)length angle:(CGFloat)angle closingPath:(BOOL)closeit;
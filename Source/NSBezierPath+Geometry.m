@@ -10,6 +10,8 @@
 #import "LogEvent.h"
 #import "NSBezierPath+Editing.h"
 #import "NSBezierPath+Geometry.h"
+#import <objc/runtime.h>
+#include <simd/simd.h>
 
 // define this to use Omni methods for finding points on paths, etc. Note - I have discovered that these methods, though probably faster, are quite innaccurate
 // and the innaccuracy worsens with longer paths (accumulative rounding error). So if your paths are likely to exceed 1000 points in length, it's better to use
@@ -25,12 +27,14 @@
 static void ConvertPathApplierFunction(void* info, const CGPathElement* element);
 static CGFloat lengthOfBezier(const NSPoint bez[4], CGFloat acceptableError);
 static inline CGFloat distanceBetween(NSPoint a, NSPoint b);
+static inline CGFloat bezierSpeed(const NSPoint bez[4], CGFloat t);
 
-/** given the vertices of the path v0..v2, this calculates \c cp1 and \c cp2 being the control points for the curve segments v0..v1 and v1..v2. i.e. this
- calculates only half of the control points, but does so for two segments. The caller needs to accumulate \c cp1 until it has \c cp2 for the same segment
- before it can add the curve segment.
+/** given the vertices of one subpath run p[0..n-1], these calculate the smoothing control points for every interior vertex in a single
+ pass and append the resulting curve segments to the arena. \c ctrl1[j] is CP1 for the segment p[j]..p[j+1] and \c ctrl2[j] is CP2 for
+ the segment p[j-1]..p[j]; the scratch buffers are preallocated by the caller and shared by all the runs of a path.
  */
-static void InterpolatePoints(const NSPoint pointsIn[3], NSPoint* cp1, NSPoint* cp2, const CGFloat smooth_value);
+static void SmoothVertexRun(const NSPoint* p, NSUInteger n, BOOL closed, CGFloat amount, simd_double2* mids, double* lens, simd_double2* ctrl1, simd_double2* ctrl2);
+static void AppendSmoothedVertexRun(CGMutablePathRef arena, const NSPoint* p, NSUInteger n, BOOL closed, CGFloat amount, simd_double2* mids, double* lens, simd_double2* ctrl1, simd_double2* ctrl2);
 /** given 3 points in <code>pointsIn</code>, this returns the point that bisects the angle between the vertices, and is extended to intercept the \c offset
  parallel up to <code>miterLimit</code>. This is used to compute the correct location of a vertex for a parallel offset path.
  for zero offset, result is simply second point.
@@ -52,6 +56,472 @@ static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath*
 @end
 
 #pragma mark -
+#pragma mark -
+
+/** @brief cumulative arc-length lookup table built from a flattened copy of a path.
+
+ stores each flattened segment's endpoints and the cumulative length at its end, so a point-for-length query is a
+ binary search plus a linear interpolation. The table remembers the element count and bounds of the path it was
+ built from so that a mutated path can be detected and the table rebuilt.
+*/
+@interface DKPathArcLengthTable : NSObject {
+@public
+	NSPoint* mSegStart;
+	NSPoint* mSegEnd;
+	CGFloat* mCumLengths;
+	NSUInteger mCount;
+	NSInteger mElementCount;
+	NSRect mBounds;
+}
+
++ (DKPathArcLengthTable*)tableWithPath:(NSBezierPath*)path;
+- (BOOL)isValidForPath:(NSBezierPath*)path;
+- (NSPoint)pointAtLength:(CGFloat)length slope:(CGFloat*)slope;
+
+@end
+
+@implementation DKPathArcLengthTable
+
++ (DKPathArcLengthTable*)tableWithPath:(NSBezierPath*)path
+{
+	DKPathArcLengthTable* table = [[[DKPathArcLengthTable alloc] init] autorelease];
+
+	table->mElementCount = [path elementCount];
+	table->mBounds = [path bounds];
+
+	NSBezierPath* flat = [path bezierPathByFlatteningPath];
+	NSInteger i, ec = [flat elementCount];
+	NSUInteger capacity = (ec > 0) ? (NSUInteger)ec : 1;
+
+	table->mSegStart = (NSPoint*)malloc(capacity * sizeof(NSPoint));
+	table->mSegEnd = (NSPoint*)malloc(capacity * sizeof(NSPoint));
+	table->mCumLengths = (CGFloat*)malloc(capacity * sizeof(CGFloat));
+
+	NSPoint ap[3];
+	NSPoint current = NSZeroPoint, firstInSubpath = NSZeroPoint;
+	CGFloat total = 0.0;
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement elem = [flat elementAtIndex:i
+									   associatedPoints:ap];
+
+		switch (elem) {
+		case NSMoveToBezierPathElement:
+			current = firstInSubpath = ap[0];
+			break;
+
+		case NSLineToBezierPathElement:
+		case NSClosePathBezierPathElement: {
+			NSPoint next = (elem == NSClosePathBezierPathElement) ? firstInSubpath : ap[0];
+			CGFloat d = hypot(next.x - current.x, next.y - current.y);
+
+			if (d > 0.0) {
+				total += d;
+				table->mSegStart[table->mCount] = current;
+				table->mSegEnd[table->mCount] = next;
+				table->mCumLengths[table->mCount] = total;
+				++table->mCount;
+			}
+			current = next;
+		} break;
+
+		default:
+			break;
+		}
+	}
+
+	return table;
+}
+
+- (BOOL)isValidForPath:(NSBezierPath*)path
+{
+	return mElementCount == [path elementCount] && NSEqualRects(mBounds, [path bounds]);
+}
+
+- (NSPoint)pointAtLength:(CGFloat)length slope:(CGFloat*)slope
+{
+	if (mCount == 0) {
+		if (slope)
+			*slope = 0.0;
+		return NSZeroPoint;
+	}
+
+	if (length < 0.0)
+		length = 0.0;
+	if (length > mCumLengths[mCount - 1])
+		length = mCumLengths[mCount - 1];
+
+	// binary search for the first segment whose cumulative length reaches <length>
+
+	NSUInteger lo = 0, hi = mCount - 1;
+
+	while (lo < hi) {
+		NSUInteger mid = (lo + hi) >> 1;
+
+		if (mCumLengths[mid] < length)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	NSPoint a = mSegStart[lo], b = mSegEnd[lo];
+	CGFloat segStartLen = (lo > 0) ? mCumLengths[lo - 1] : 0.0;
+	CGFloat segLen = mCumLengths[lo] - segStartLen;
+	CGFloat t = (segLen > 0.0) ? (length - segStartLen) / segLen : 0.0;
+
+	if (slope)
+		*slope = Slope(a, b);
+
+	return NSMakePoint(a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t);
+}
+
+- (void)dealloc
+{
+	if (mSegStart)
+		free(mSegStart);
+	if (mSegEnd)
+		free(mSegEnd);
+	if (mCumLengths)
+		free(mCumLengths);
+	[super dealloc];
+}
+
+@end
+
+static const void* kDKArcLengthTableKey = &kDKArcLengthTableKey;
+
+#pragma mark -
+
+/** @brief cumulative per-element length table for a path.
+
+ stores the cumulative length at the end of each path element, with curve elements measured by Gauss-Legendre
+ quadrature rather than flattening. Length queries and trimming then cost one table lookup per element instead of a
+ recursive subdivision, and only the element actually containing a trim point needs any further work. As with
+ \c DKPathArcLengthTable the element count and bounds of the source path are remembered so a stale table is rebuilt.
+*/
+@interface DKPathElementLengthTable : NSObject {
+@public
+	CGFloat* mCumLengths;
+	NSInteger mElementCount;
+	NSRect mBounds;
+}
+
++ (DKPathElementLengthTable*)tableWithPath:(NSBezierPath*)path;
+- (BOOL)isValidForPath:(NSBezierPath*)path;
+- (CGFloat)lengthOfElement:(NSInteger)i;
+- (CGFloat)totalLength;
+
+@end
+
+@implementation DKPathElementLengthTable
+
++ (DKPathElementLengthTable*)tableWithPath:(NSBezierPath*)path
+{
+	DKPathElementLengthTable* table = [[[DKPathElementLengthTable alloc] init] autorelease];
+
+	NSInteger i, ec = [path elementCount];
+
+	table->mElementCount = ec;
+	table->mBounds = [path bounds];
+	table->mCumLengths = (CGFloat*)malloc(((ec > 0) ? (size_t)ec : 1) * sizeof(CGFloat));
+
+	NSPoint ap[3];
+	NSPoint current = NSZeroPoint, firstInSubpath = NSZeroPoint;
+	CGFloat total = 0.0;
+
+	for (i = 0; i < ec; ++i) {
+		NSBezierPathElement elem = [path elementAtIndex:i
+									   associatedPoints:ap];
+
+		switch (elem) {
+		case NSMoveToBezierPathElement:
+			current = firstInSubpath = ap[0];
+			break;
+
+		case NSLineToBezierPathElement:
+			total += distanceBetween(current, ap[0]);
+			current = ap[0];
+			break;
+
+		case NSCurveToBezierPathElement: {
+			NSPoint bez[4] = { current, ap[0], ap[1], ap[2] };
+			total += lengthOfBezier(bez, 0.001);
+			current = ap[2];
+		} break;
+
+		case NSClosePathBezierPathElement:
+			total += distanceBetween(current, firstInSubpath);
+			current = firstInSubpath;
+			break;
+
+		default:
+			break;
+		}
+
+		table->mCumLengths[i] = total;
+	}
+
+	return table;
+}
+
+- (BOOL)isValidForPath:(NSBezierPath*)path
+{
+	return mElementCount == [path elementCount] && NSEqualRects(mBounds, [path bounds]);
+}
+
+- (CGFloat)lengthOfElement:(NSInteger)i
+{
+	if (i < 0 || i >= mElementCount)
+		return -1.0;
+
+	return mCumLengths[i] - ((i > 0) ? mCumLengths[i - 1] : 0.0);
+}
+
+- (CGFloat)totalLength
+{
+	return (mElementCount > 0) ? mCumLengths[mElementCount - 1] : 0.0;
+}
+
+- (void)dealloc
+{
+	if (mCumLengths)
+		free(mCumLengths);
+	[super dealloc];
+}
+
+@end
+
+static const void* kDKElementLengthTableKey = &kDKElementLengthTableKey;
+
+#pragma mark -
+
+/** @brief coarse winding raster for point-in-path queries.
+
+ classifies the path's bounds into cells of roughly \c kDKInteriorMapCellSize points. Cells the outline passes
+ through (or next to) are flagged as boundary; every other cell is uniformly inside or outside the fill, resolved
+ once by a scanline winding pass over the flattened path. A containment query on a clear cell is then a single
+ byte test, and only queries landing in boundary cells fall back to the exact \c -containsPoint: evaluation.
+ As with the length tables, the element count and bounds of the source path are remembered so a stale map is rebuilt.
+*/
+
+#define kDKInteriorMapCellSize 8.0
+#define kDKInteriorMapMaxCells 256
+
+@interface DKPathInteriorMap : NSObject {
+@public
+	uint8_t* mInside; // 1 = cell centre lies inside the fill
+	uint8_t* mBoundary; // 1 = outline passes within a cell of this cell - needs the exact test
+	NSUInteger mWidth;
+	NSUInteger mHeight;
+	CGFloat mCellSize;
+	NSPoint mOrigin;
+	BOOL mEvenOdd;
+	NSInteger mElementCount;
+	NSRect mBounds;
+}
+
++ (DKPathInteriorMap*)mapWithPath:(NSBezierPath*)path;
+- (BOOL)isValidForPath:(NSBezierPath*)path;
+- (BOOL)classifiesPoint:(NSPoint)p inside:(BOOL*)inside;
+
+@end
+
+static void interiorMapAddSegment(DKPathInteriorMap* map, int* winding, NSPoint a, NSPoint b)
+{
+	CGFloat const cell = map->mCellSize;
+	NSPoint const org = map->mOrigin;
+	NSUInteger const w = map->mWidth;
+	NSUInteger const h = map->mHeight;
+
+	// boundary marking: walk the segment at half-cell steps flagging the hit cell and its eight
+	// neighbours, so any cell left clear is at least a full cell away from the outline
+
+	CGFloat len = hypot(b.x - a.x, b.y - a.y);
+	NSUInteger steps = (NSUInteger)ceil(len / (cell * 0.5)) + 1;
+	NSUInteger s;
+
+	for (s = 0; s <= steps; ++s) {
+		CGFloat t = (CGFloat)s / (CGFloat)steps;
+		NSInteger cx = (NSInteger)floor((a.x + (b.x - a.x) * t - org.x) / cell);
+		NSInteger cy = (NSInteger)floor((a.y + (b.y - a.y) * t - org.y) / cell);
+		NSInteger dx, dy;
+
+		for (dy = cy - 1; dy <= cy + 1; ++dy) {
+			if (dy < 0 || dy >= (NSInteger)h)
+				continue;
+
+			for (dx = cx - 1; dx <= cx + 1; ++dx) {
+				if (dx >= 0 && dx < (NSInteger)w)
+					map->mBoundary[dy * w + dx] = 1;
+			}
+		}
+	}
+
+	// winding deltas: for each row whose centre line the segment crosses, bump the delta in the
+	// first column whose centre lies right of the crossing. The span is half-open so a vertex
+	// shared by two segments is never counted twice.
+
+	if (a.y == b.y)
+		return;
+
+	int const dir = (b.y > a.y) ? 1 : -1;
+	CGFloat const y0 = MIN(a.y, b.y), y1 = MAX(a.y, b.y);
+	NSInteger j = (NSInteger)ceil((y0 - org.y) / cell - 0.5);
+
+	if (j < 0)
+		j = 0;
+
+	for (; j < (NSInteger)h; ++j) {
+		CGFloat yc = org.y + ((CGFloat)j + 0.5) * cell;
+
+		if (yc >= y1)
+			break;
+
+		if (yc < y0)
+			continue;
+
+		CGFloat x = a.x + (b.x - a.x) * (yc - a.y) / (b.y - a.y);
+		NSInteger c = (NSInteger)floor((x - org.x) / cell - 0.5) + 1;
+
+		if (c < 0)
+			c = 0;
+
+		if (c <= (NSInteger)w)
+			winding[j * (w + 1) + c] += dir;
+	}
+}
+
+@implementation DKPathInteriorMap
+
++ (DKPathInteriorMap*)mapWithPath:(NSBezierPath*)path
+{
+	DKPathInteriorMap* map = [[[DKPathInteriorMap alloc] init] autorelease];
+
+	map->mElementCount = [path elementCount];
+	map->mBounds = [path bounds];
+	map->mEvenOdd = ([path windingRule] == NSEvenOddWindingRule);
+
+	NSRect br = map->mBounds;
+	CGFloat cell = kDKInteriorMapCellSize;
+
+	cell = MAX(cell, NSWidth(br) / kDKInteriorMapMaxCells);
+	cell = MAX(cell, NSHeight(br) / kDKInteriorMapMaxCells);
+
+	NSUInteger w = MAX((NSUInteger)ceil(NSWidth(br) / cell), (NSUInteger)1);
+	NSUInteger h = MAX((NSUInteger)ceil(NSHeight(br) / cell), (NSUInteger)1);
+
+	map->mWidth = w;
+	map->mHeight = h;
+	map->mCellSize = cell;
+	map->mOrigin = br.origin;
+	map->mInside = (uint8_t*)calloc(w * h, 1);
+	map->mBoundary = (uint8_t*)calloc(w * h, 1);
+
+	if (NSIsEmptyRect(br) || [path isEmpty])
+		return map;
+
+	// gather the flattened segments, treating every subpath as closed just as -fill and
+	// -containsPoint: do, and accumulate winding deltas plus boundary flags in one sweep
+
+	NSBezierPath* flat = [path bezierPathByFlatteningPath];
+	NSInteger i, ec = [flat elementCount];
+	int* winding = (int*)calloc((w + 1) * h, sizeof(int));
+	NSPoint ap[3];
+	NSPoint current = NSZeroPoint, firstInSubpath = NSZeroPoint;
+	BOOL hasSubpath = NO;
+
+	for (i = 0; i <= ec; ++i) {
+		// index == count acts as a sentinel move-to that closes the final subpath
+
+		NSBezierPathElement elem = (i < ec) ? [flat elementAtIndex:i
+												  associatedPoints:ap]
+											: NSMoveToBezierPathElement;
+
+		switch (elem) {
+		case NSMoveToBezierPathElement:
+			if (hasSubpath && !NSEqualPoints(current, firstInSubpath))
+				interiorMapAddSegment(map, winding, current, firstInSubpath);
+
+			if (i < ec) {
+				current = firstInSubpath = ap[0];
+				hasSubpath = YES;
+			}
+			break;
+
+		case NSLineToBezierPathElement:
+			interiorMapAddSegment(map, winding, current, ap[0]);
+			current = ap[0];
+			break;
+
+		case NSClosePathBezierPathElement:
+			interiorMapAddSegment(map, winding, current, firstInSubpath);
+			current = firstInSubpath;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// prefix-sum each row of deltas to get the winding count at every cell centre
+
+	NSUInteger ci, j;
+
+	for (j = 0; j < h; ++j) {
+		int acc = 0;
+
+		for (ci = 0; ci < w; ++ci) {
+			acc += winding[j * (w + 1) + ci];
+
+			BOOL in = map->mEvenOdd ? ((acc & 1) != 0) : (acc != 0);
+			map->mInside[j * w + ci] = in ? 1 : 0;
+		}
+	}
+
+	free(winding);
+
+	return map;
+}
+
+- (BOOL)isValidForPath:(NSBezierPath*)path
+{
+	return mElementCount == [path elementCount] && NSEqualRects(mBounds, [path bounds]);
+}
+
+- (BOOL)classifiesPoint:(NSPoint)p inside:(BOOL*)inside
+{
+	NSInteger cx = (NSInteger)floor((p.x - mOrigin.x) / mCellSize);
+	NSInteger cy = (NSInteger)floor((p.y - mOrigin.y) / mCellSize);
+
+	if (cx < 0 || cy < 0 || cx >= (NSInteger)mWidth || cy >= (NSInteger)mHeight) {
+		*inside = NO;
+		return YES;
+	}
+
+	NSUInteger indx = (NSUInteger)cy * mWidth + (NSUInteger)cx;
+
+	if (mBoundary[indx])
+		return NO;
+
+	*inside = mInside[indx] != 0;
+	return YES;
+}
+
+- (void)dealloc
+{
+	if (mInside)
+		free(mInside);
+	if (mBoundary)
+		free(mBoundary);
+	[super dealloc];
+}
+
+@end
+
+static const void* kDKInteriorMapKey = &kDKInteriorMapKey;
+
+#pragma mark -
+
 @implementation NSBezierPath (Geometry)
 #pragma mark As an NSBezierPath
 
@@ -331,98 +801,211 @@ static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath*
 	return newPath;
 }
 
-#pragma mark -
-- (NSBezierPath*)paralleloidPathWithOffset:(CGFloat)delta
+- (NSInteger)getElementTypes:(NSBezierPathElement*)types associatedPoints:(NSPoint (*)[3])points maxCount:(NSInteger)maxCount
 {
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
+	// bulk extraction of the path's elements into flat C arrays, so that heavy path transforms can
+	// iterate raw buffers instead of paying an accessor message per element.
 
-	if (![self isEmpty]) {
-		NSInteger i, count = [self elementCount];
-		NSPoint ap[3], np[3], p0, p1;
-		NSBezierPathElement kind, nextKind;
-		CGFloat slope, dx, dy, pdx, pdy;
+	NSInteger i, m = MIN([self elementCount], maxCount);
+	NSPoint ap[3];
 
-		pdx = pdy = 0;
+	for (i = 0; i < m; ++i) {
+		NSBezierPathElement kind = [self elementAtIndex:i
+									   associatedPoints:ap];
 
-		for (i = 0; i < count; ++i) {
-			kind = [self elementAtIndex:i
-					   associatedPoints:ap];
+		if (types != NULL)
+			types[i] = kind;
 
-			if (i < count - 1) {
-				[self elementAtIndex:i + 1
-					associatedPoints:np];
+		if (points != NULL) {
+			points[i][0] = ap[0];
+			points[i][1] = ap[1];
+			points[i][2] = ap[2];
+		}
+	}
 
-				// calculate the slope of the on-path point
+	return m;
+}
 
-				if (kind != NSCurveToBezierPathElement) {
-					p0 = ap[0];
-					p1 = np[0];
-				} else {
-					p0 = ap[2];
-					p1 = np[0];
-				}
-			} else {
-				if (kind == NSCurveToBezierPathElement) {
-					p1 = ap[2];
-					p0 = ap[1];
-				} else {
-					p1 = ap[0];
+- (NSBezierPath*)bezierPathByIteratingWithFunction:(DKBezierElementIterationFunction)function contextInfo:(void*)contextInfo
+{
+	NSAssert(function != NULL, @"cannot operate with a NULL iteration function");
 
-					nextKind = [self elementAtIndex:i - 1
-								   associatedPoints:np];
+	if ([self isEmpty])
+		return nil;
 
-					if (nextKind != NSCurveToBezierPathElement)
-						p0 = np[0];
-					else
-						p0 = np[2];
-				}
-			}
+	NSInteger i, m = [self elementCount];
 
-			slope = atan2(p1.y - p0.y, p1.x - p0.x) + (M_PI_2);
+	// one pass extracts every element into a flat buffer; all further work is plain C
 
-			// calculate the position of the modified point
+	NSBezierPathElement* types = malloc(sizeof(NSBezierPathElement) * m);
+	NSPoint(*pts)[3] = malloc(sizeof(NSPoint[3]) * m);
 
-			dx = delta * cos(slope);
-			dy = delta * sin(slope);
+	if (types == NULL || pts == NULL) {
+		if (types)
+			free(types);
+		if (pts)
+			free(pts);
+		return nil;
+	}
 
-			switch (kind) {
-			case NSMoveToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath moveToPoint:ap[0]];
-				break;
+	[self getElementTypes:types
+		 associatedPoints:pts
+				 maxCount:m];
 
-			case NSLineToBezierPathElement:
-				ap[0].x += dx;
-				ap[0].y += dy;
-				[newPath lineToPoint:ap[0]];
-				break;
+	// the output is accumulated in a mutable Quartz path - the element arena - and converted
+	// to an NSBezierPath once at the end
 
-			case NSCurveToBezierPathElement:
-				ap[0].x += pdx;
-				ap[0].y += pdy;
-				ap[1].x += dx;
-				ap[1].y += dy;
-				ap[2].x += dx;
-				ap[2].y += dy;
-				[newPath curveToPoint:ap[2]
-						controlPoint1:ap[0]
-						controlPoint2:ap[1]];
-				break;
+	CGMutablePathRef arena = CGPathCreateMutable();
+	DKBezierElementInfo info;
 
-			case NSClosePathBezierPathElement:
-				[newPath closePath];
-				break;
+	info.subPathIndex = -1;
+	info.subPathClosed = NO;
+	info.points[3] = NSZeroPoint;
+
+	for (i = 0; i < m; ++i) {
+		if (types[i] == NSMoveToBezierPathElement) {
+			// scan ahead for the end of this subpath to fill in the closed flag and final on-path point;
+			// each element is visited at most twice in total, unlike the per-moveTo rescans of the
+			// delegate-based route
+
+			NSInteger e = i + 1;
+
+			while (e < m && types[e] != NSMoveToBezierPathElement)
+				++e;
+
+			++info.subPathIndex;
+			info.subPathClosed = (types[e - 1] == NSClosePathBezierPathElement);
+
+			NSInteger spe = info.subPathClosed ? MAX(i, e - 2) : e - 1;
+
+			if (types[spe] == NSCurveToBezierPathElement)
+				info.points[3] = pts[spe][2];
+			else
+				info.points[3] = pts[spe][0];
+		}
+
+		// reorder the raw points into the delegate protocol's layout
+
+		info.elementIndex = i;
+		info.type = types[i];
+
+		if (types[i] == NSCurveToBezierPathElement) {
+			info.points[0] = pts[i][2];
+			info.points[1] = pts[i][0];
+			info.points[2] = pts[i][1];
+		} else
+			info.points[0] = info.points[1] = info.points[2] = pts[i][0];
+
+		function(arena, &info, contextInfo);
+	}
+
+	NSBezierPath* newPath = [NSBezierPath bezierPathWithCGPath:arena];
+
+	CGPathRelease(arena);
+	free(pts);
+	free(types);
+
+	return newPath;
+}
+
+#pragma mark -
+- (NSBezierPath*)paralleloidPathWithOffset:(CGFloat)delta
+{
+	if ([self isEmpty])
+		return [NSBezierPath bezierPath];
+
+	NSInteger i, count = [self elementCount];
+
+	// extract the elements once into flat buffers - the loop below, which needs to look at the
+	// neighbouring elements of each one, then runs without any per-element message sends
+
+	NSBezierPathElement* types = malloc(sizeof(NSBezierPathElement) * count);
+	NSPoint(*pts)[3] = malloc(sizeof(NSPoint[3]) * count);
+
+	if (types == NULL || pts == NULL) {
+		if (types)
+			free(types);
+		if (pts)
+			free(pts);
+		return [NSBezierPath bezierPath];
+	}
+
+	[self getElementTypes:types
+		 associatedPoints:pts
+				 maxCount:count];
+
+	CGMutablePathRef arena = CGPathCreateMutable();
+	NSPoint p0, p1;
+	NSBezierPathElement kind;
+	CGFloat slope, dx, dy, pdx, pdy;
+
+	pdx = pdy = 0;
+
+	for (i = 0; i < count; ++i) {
+		kind = types[i];
+
+		if (i < count - 1) {
+			// calculate the slope of the on-path point
 
-			default:
-				break;
+			p0 = (kind != NSCurveToBezierPathElement) ? pts[i][0] : pts[i][2];
+			p1 = pts[i + 1][0];
+		} else {
+			if (kind == NSCurveToBezierPathElement) {
+				p1 = pts[i][2];
+				p0 = pts[i][1];
+			} else {
+				p1 = pts[i][0];
+
+				if (i == 0)
+					p0 = p1;
+				else if (types[i - 1] != NSCurveToBezierPathElement)
+					p0 = pts[i - 1][0];
+				else
+					p0 = pts[i - 1][2];
 			}
+		}
 
-			pdx = dx;
-			pdy = dy;
+		slope = atan2(p1.y - p0.y, p1.x - p0.x) + (M_PI_2);
+
+		// calculate the position of the modified point
+
+		dx = delta * cos(slope);
+		dy = delta * sin(slope);
+
+		switch (kind) {
+		case NSMoveToBezierPathElement:
+			CGPathMoveToPoint(arena, NULL, pts[i][0].x + dx, pts[i][0].y + dy);
+			break;
+
+		case NSLineToBezierPathElement:
+			CGPathAddLineToPoint(arena, NULL, pts[i][0].x + dx, pts[i][0].y + dy);
+			break;
+
+		case NSCurveToBezierPathElement:
+			CGPathAddCurveToPoint(arena, NULL,
+				pts[i][0].x + pdx, pts[i][0].y + pdy,
+				pts[i][1].x + dx, pts[i][1].y + dy,
+				pts[i][2].x + dx, pts[i][2].y + dy);
+			break;
+
+		case NSClosePathBezierPathElement:
+			CGPathCloseSubpath(arena);
+			break;
+
+		default:
+			break;
 		}
+
+		pdx = dx;
+		pdy = dy;
 	}
 
+	NSBezierPath* newPath = [NSBezierPath bezierPathWithCGPath:arena];
+
+	CGPathRelease(arena);
+	free(pts);
+	free(types);
+
 	return newPath;
 }
 
@@ -813,175 +1396,190 @@ static BOOL CornerBevel(const NSPoint pointsIn[3], CGFloat offset, NSBezierPath*
 	if (amount == 0.0 || [self isEmpty])
 		return self; // nothing to do
 
-	NSBezierPath* newPath = [NSBezierPath bezierPath];
-	NSInteger i, m = [self elementCount], spc = 0;
-	NSBezierPathElement element;
-	NSPoint ap[3];
-	NSPoint v[3];
-	NSPoint fp = NSZeroPoint, cp1 = NSZeroPoint, cp2 = NSZeroPoint, pcp = NSZeroPoint;
+	// extract the elements once into flat buffers, then smooth each subpath's vertex run in a single
+	// pass with all of its control points computed up front - no per-element message sends and no
+	// incremental appends. All scratch buffers are preallocated here and shared by every subpath.
+
+	NSInteger m = [self elementCount];
+	NSBezierPathElement* types = malloc(sizeof(NSBezierPathElement) * m);
+	NSPoint(*pts)[3] = malloc(sizeof(NSPoint[3]) * m);
+	NSPoint* verts = malloc(sizeof(NSPoint) * (m + 1));
+	simd_double2* mids = malloc(sizeof(simd_double2) * (m + 1));
+	double* lens = malloc(sizeof(double) * (m + 1));
+	simd_double2* ctrl1 = malloc(sizeof(simd_double2) * (m + 1));
+	simd_double2* ctrl2 = malloc(sizeof(simd_double2) * (m + 1));
+
+	if (types == NULL || pts == NULL || verts == NULL || mids == NULL || lens == NULL || ctrl1 == NULL || ctrl2 == NULL) {
+		free(types);
+		free(pts);
+		free(verts);
+		free(mids);
+		free(lens);
+		free(ctrl1);
+		free(ctrl2);
+		return self;
+	}
 
-	fp = cp1 = cp2 = NSZeroPoint;
-	v[0] = v[1] = v[2] = NSZeroPoint;
+	[self getElementTypes:types
+		 associatedPoints:pts
+				 maxCount:m];
 
-	for (i = 0; i < m; ++i) {
-		element = [self elementAtIndex:i
-					  associatedPoints:ap];
+	CGMutablePathRef arena = CGPathCreateMutable();
+	NSInteger i = 0;
 
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			// starting a new subpath
+	while (i < m) {
+		if (types[i] != NSMoveToBezierPathElement) {
+			++i;
+			continue;
+		}
 
-			[newPath moveToPoint:ap[0]];
-			fp = v[0] = ap[0];
-			spc = 0;
-			break;
+		// gather this subpath's on-path vertices. Curve segments contribute their end points only,
+		// as before - the path is smoothed as if straight lines joined the vertices.
 
-		case NSLineToBezierPathElement:
-			if (spc == 0) {
-				// recently started a new subpath, so set 2nd vertex
-				v[1] = ap[0];
-				spc++;
-			} else {
-				v[2] = ap[0];
+		NSUInteger n = 0;
+		BOOL closed = NO;
 
-				// we have three vertices, so we can interpolate
+		verts[n++] = pts[i][0];
+		++i;
 
-				InterpolatePoints(v, &cp1, &cp2, amount);
+		while (i < m && types[i] != NSMoveToBezierPathElement) {
+			if (types[i] == NSLineToBezierPathElement)
+				verts[n++] = pts[i][0];
+			else if (types[i] == NSCurveToBezierPathElement)
+				verts[n++] = pts[i][2];
+			else if (types[i] == NSClosePathBezierPathElement) {
+				closed = YES;
+				++i;
+				break;
+			}
+			++i;
+		}
 
-				// cp2 completes the  curve segment v0..v1 so we can add that to the new path. If it was the first
-				// segment, cp1 == cp2
+		AppendSmoothedVertexRun(arena, verts, n, closed, amount, mids, lens, ctrl1, ctrl2);
+	}
 
-				if (spc == 1)
-					pcp = cp2;
+	NSBezierPath* newPath = [NSBezierPath bezierPathWithCGPath:arena];
 
-				[newPath curveToPoint:v[1]
-						controlPoint1:pcp
-						controlPoint2:cp2];
+	CGPathRelease(arena);
+	free(types);
+	free(pts);
+	free(verts);
+	free(mids);
+	free(lens);
+	free(ctrl1);
+	free(ctrl2);
 
-				// shift vertex array
+	return newPath;
+}
 
-				v[0] = v[1];
-				v[1] = v[2];
-				pcp = cp1;
-				spc++;
-			}
-			break;
++ (NSArray<NSBezierPath*>*)pathsByInterpolatingPaths:(NSArray<NSBezierPath*>*)paths amount:(CGFloat)amount
+{
+	NSUInteger count = [paths count];
 
-		case NSCurveToBezierPathElement:
-			if (spc == 0) {
-				// recently started a new subpath, so set 2nd vertex
-				v[1] = ap[2];
-				spc++;
-			} else {
-				v[2] = ap[2];
+	if (count == 0)
+		return @[];
 
-				// we have three vertices, so we can interpolate
+	// each path is smoothed independently, so a whole import batch can be spread across the cores.
+	// Results keep the input order.
 
-				InterpolatePoints(v, &cp1, &cp2, amount);
+	id* results = calloc(count, sizeof(id));
 
-				// cp2 completes the  curve segment v0..v1 so we can add that to the new path. If it was the first
-				// segment, cp1 == cp2
+	if (results == NULL)
+		return paths;
 
-				if (spc == 1)
-					pcp = cp2;
+	dispatch_apply(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t indx) {
+		@autoreleasepool {
+			results[indx] = [[[paths objectAtIndex:indx] bezierPathByInterpolatingPath:amount] retain];
+		}
+	});
 
-				[newPath curveToPoint:v[1]
-						controlPoint1:pcp
-						controlPoint2:cp2];
+	NSMutableArray* array = [NSMutableArray arrayWithCapacity:count];
+	NSUInteger i;
 
-				// shift vertex array
+	for (i = 0; i < count; ++i) {
+		[array addObject:results[i]];
+		[results[i] release];
+	}
 
-				v[0] = v[1];
-				v[1] = v[2];
-				pcp = cp1;
-				spc++;
-			}
-			break;
+	free(results);
 
-		case NSClosePathBezierPathElement:
-			// close the path by curving back to the first point
-			v[2] = fp;
+	return array;
+}
 
-			InterpolatePoints(v, &cp1, &cp2, amount);
+static void SmoothVertexRun(const NSPoint* p, NSUInteger n, BOOL closed, CGFloat amount, simd_double2* mids, double* lens, simd_double2* ctrl1, simd_double2* ctrl2)
+{
+	// computes the smoothing control points for every interior vertex of the run in one pass over the
+	// buffers. For the vertex at index j, ctrl1[j] is CP1 for the segment p[j]..p[j+1] and ctrl2[j] is
+	// CP2 for the segment p[j-1]..p[j]. For a closed run the wrapping edge p[n-1]..p[0] participates,
+	// so the last centre vertex is n - 1; for an open run it is n - 2.
 
-			// cp2 completes the  curve segment v0..v1 so we can add that to the new path. If it was the first
-			// segment, cp1 == cp2
+	NSUInteger edges = closed ? n : n - 1;
+	NSUInteger e, j;
 
-			if (spc == 1)
-				pcp = cp2;
+	for (e = 0; e < edges; ++e) {
+		NSPoint pb = p[(e + 1 == n) ? 0 : e + 1];
+		simd_double2 a = simd_make_double2(p[e].x, p[e].y);
+		simd_double2 b = simd_make_double2(pb.x, pb.y);
 
-			[newPath curveToPoint:v[1]
-					controlPoint1:pcp
-					controlPoint2:cp2];
+		mids[e] = (a + b) * 0.5;
+		lens[e] = simd_length(b - a);
+	}
 
-			// final segment closes the path
+	NSUInteger lastCentre = closed ? n - 1 : n - 2;
 
-			[newPath curveToPoint:fp
-					controlPoint1:cp1
-					controlPoint2:cp1];
-			[newPath closePath];
-			spc = 0;
-			break;
+	for (j = 1; j <= lastCentre; ++j) {
+		double lsum = lens[j - 1] + lens[j];
+		double k = (lsum > 0.0) ? lens[j - 1] / lsum : 0.0;
 
-		default:
-			break;
-		}
-	}
+		// the pivot divides the line joining the edge midpoints in the ratio of the edge lengths; the
+		// control arms pivot about it, pulled towards the vertex
 
-	if (spc > 1) {
-		// path ended without a closepath, so add in the final curve segment to the end
+		simd_double2 pivot = mids[j - 1] + (mids[j] - mids[j - 1]) * k;
+		simd_double2 off = simd_make_double2(p[j].x, p[j].y) - pivot;
 
-		[newPath curveToPoint:v[1]
-				controlPoint1:pcp
-				controlPoint2:pcp];
+		ctrl1[j] = pivot + (mids[j] - pivot) * amount + off;
+		ctrl2[j] = pivot - (pivot - mids[j - 1]) * amount + off;
 	}
-
-	//NSLog(@"new path = %@", newPath);
-
-	return newPath;
 }
 
-static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, const CGFloat smooth_value)
+static void AppendSmoothedVertexRun(CGMutablePathRef arena, const NSPoint* p, NSUInteger n, BOOL closed, CGFloat amount, simd_double2* mids, double* lens, simd_double2* ctrl1, simd_double2* ctrl2)
 {
-	// calculate the midpoints of the two edges
-
-	CGFloat xc1 = (v[0].x + v[1].x) * 0.5; //(x0 + x1) / 2.0;
-	CGFloat yc1 = (v[0].y + v[1].y) * 0.5; //(y0 + y1) / 2.0;
-	CGFloat xc2 = (v[1].x + v[2].x) * 0.5; //(x1 + x2) / 2.0;
-	CGFloat yc2 = (v[1].y + v[2].y) * 0.5; //(y1 + y2) / 2.0;
+	CGPathMoveToPoint(arena, NULL, p[0].x, p[0].y);
 
-	// calculate the ratio of the two lengths
+	if (n < 2 || (!closed && n < 3)) {
+		// too few vertices to smooth - emit the run unchanged
 
-	CGFloat len1 = hypot(v[1].x - v[0].x, v[1].y - v[0].y); //sqrt((x1-x0) * (x1-x0) + (y1-y0) * (y1-y0));
-	CGFloat len2 = hypot(v[2].x - v[1].x, v[2].y - v[1].y); //sqrt((x2-x1) * (x2-x1) + (y2-y1) * (y2-y1));
-	CGFloat k1;
+		if (!closed && n == 2)
+			CGPathAddLineToPoint(arena, NULL, p[1].x, p[1].y);
 
-	if ((len1 + len2) > 0.0)
-		k1 = len1 / (len1 + len2);
-	else
-		k1 = 0.0;
+		if (closed)
+			CGPathCloseSubpath(arena);
 
-	// calculate the pivot point of the control point "arms" xm1, ym1
-
-	CGFloat xm1 = xc1 + (xc2 - xc1) * k1;
-	CGFloat ym1 = yc1 + (yc2 - yc1) * k1;
+		return;
+	}
 
-	NSPoint ctrl1, ctrl2;
+	SmoothVertexRun(p, n, closed, amount, mids, lens, ctrl1, ctrl2);
 
-	// ctrl1 is CP1 for the segment v1..v2
-	// ctrl2 is CP2 for the segment v0..v1
+	// the first segment has no preceding centre, so it reuses its own CP2 for both control points;
+	// thereafter CP1 comes from the previous centre
 
-	ctrl1.x = (xm1 + (xc2 - xm1) * smooth_value) + v[1].x - xm1;
-	ctrl1.y = (ym1 + (yc2 - ym1) * smooth_value) + v[1].y - ym1;
+	NSUInteger lastCentre = closed ? n - 1 : n - 2;
+	simd_double2 pcp = ctrl2[1];
+	NSUInteger j;
 
-	ctrl2.x = (xm1 - (xm1 - xc1) * smooth_value) + v[1].x - xm1;
-	ctrl2.y = (ym1 - (ym1 - yc1) * smooth_value) + v[1].y - ym1;
+	for (j = 1; j <= lastCentre; ++j) {
+		CGPathAddCurveToPoint(arena, NULL, pcp.x, pcp.y, ctrl2[j].x, ctrl2[j].y, p[j].x, p[j].y);
+		pcp = ctrl1[j];
+	}
 
-	if (cp1)
-		*cp1 = ctrl1;
+	// the final segment likewise has no centre at its far end, so the last centre's CP1 serves as
+	// both control points
 
-	if (cp2)
-		*cp2 = ctrl2;
+	if (closed) {
+		CGPathAddCurveToPoint(arena, NULL, ctrl1[lastCentre].x, ctrl1[lastCentre].y, ctrl1[lastCentre].x, ctrl1[lastCentre].y, p[0].x, p[0].y);
+		CGPathCloseSubpath(arena);
+	} else
+		CGPathAddCurveToPoint(arena, NULL, ctrl1[lastCentre].x, ctrl1[lastCentre].y, ctrl1[lastCentre].x, ctrl1[lastCentre].y, p[n - 1].x, p[n - 1].y);
 }
 
 - (NSBezierPath*)filletPathForVertex:(const NSPoint[3])vp filletSize:(CGFloat)fs
@@ -1595,6 +2193,54 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 }
 
 #pragma mark -
+
+- (void)invalidateCachedArcLengthTable
+{
+	objc_setAssociatedObject(self, kDKArcLengthTableKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	objc_setAssociatedObject(self, kDKElementLengthTableKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	objc_setAssociatedObject(self, kDKInteriorMapKey, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (BOOL)containsPointUsingInteriorMap:(NSPoint)pt
+{
+	// interior/exterior answers for repeated queries against the same path come from a cached
+	// coarse winding raster; only points landing in cells the outline passes through pay for the
+	// exact winding evaluation of -containsPoint:
+
+	if ([self isEmpty])
+		return NO;
+
+	if (!NSPointInRect(pt, [self bounds]))
+		return NO;
+
+	DKPathInteriorMap* map = objc_getAssociatedObject(self, kDKInteriorMapKey);
+
+	if (map == nil || ![map isValidForPath:self]) {
+		map = [DKPathInteriorMap mapWithPath:self];
+		objc_setAssociatedObject(self, kDKInteriorMapKey, map, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	BOOL inside;
+
+	if ([map classifiesPoint:pt
+					  inside:&inside])
+		return inside;
+
+	return [self containsPoint:pt];
+}
+
+- (DKPathElementLengthTable*)elementLengthTable
+{
+	DKPathElementLengthTable* table = objc_getAssociatedObject(self, kDKElementLengthTableKey);
+
+	if (table == nil || ![table isValidForPath:self]) {
+		table = [DKPathElementLengthTable tableWithPath:self];
+		objc_setAssociatedObject(self, kDKElementLengthTableKey, table, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	return table;
+}
+
 - (NSPoint)pointOnPathAtLength:(CGFloat)length slope:(CGFloat*)slope
 {
 	// Given a length in terms of the distance from the path start, this returns the point and slope
@@ -1608,6 +2254,20 @@ static void InterpolatePoints(const NSPoint v[3], NSPoint* cp1, NSPoint* cp2, co
 	if ([self elementCount] < 2)
 		return p;
 
+	// use the cached arc-length table so repeated queries (one per glyph when laying text on a path) are a
+	// binary search instead of trimming and re-walking the whole path each time
+
+	DKPathArcLengthTable* table = objc_getAssociatedObject(self, kDKArcLengthTableKey);
+
+	if (table == nil || ![table isValidForPath:self]) {
+		table = [DKPathArcLengthTable tableWithPath:self];
+		objc_setAssociatedObject(self, kDKArcLengthTableKey, table, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	if (table->mCount > 0)
+		return [table pointAtLength:length
+							  slope:slope];
+
 	if (length <= 0.0) {
 		[self elementAtIndex:0
 			associatedPoints:ap];
@@ -1865,30 +2525,53 @@ static inline CGFloat distanceBetween(NSPoint a, NSPoint b)
 	return hypot(a.x - b.x, a.y - b.y);
 }
 
-// Length of a curve
+// Magnitude of the curve's first derivative at <t>
+
+static inline CGFloat bezierSpeed(const NSPoint bez[4], CGFloat t)
+{
+	CGFloat mt = 1.0 - t;
+	CGFloat dx = 3.0 * (mt * mt * (bez[1].x - bez[0].x) + 2.0 * mt * t * (bez[2].x - bez[1].x) + t * t * (bez[3].x - bez[2].x));
+	CGFloat dy = 3.0 * (mt * mt * (bez[1].y - bez[0].y) + 2.0 * mt * t * (bez[2].y - bez[1].y) + t * t * (bez[3].y - bez[2].y));
+
+	return hypot(dx, dy);
+}
+
+// 8-point Gauss-Legendre estimate of the curve's length, i.e. the integral of the speed over 0..1
+
+static CGFloat gaussLengthOfBezier(const NSPoint bez[4])
+{
+	// abscissae (offsets from the interval midpoint) and weights for n = 8 on 0..1
+
+	static const CGFloat ga[4] = { 0.4801449282487682, 0.3983332387068134, 0.2627662049581645, 0.0917173212478249 };
+	static const CGFloat gw[4] = { 0.0506142681451881, 0.1111905172266872, 0.1568533229389437, 0.1813418916891810 };
+
+	CGFloat len = 0.0;
+	NSUInteger n;
+
+	for (n = 0; n < 4; ++n)
+		len += gw[n] * (bezierSpeed(bez, 0.5 - ga[n]) + bezierSpeed(bez, 0.5 + ga[n]));
+
+	return len;
+}
+
+// Length of a curve. Evaluated by Gauss-Legendre quadrature of the derivative rather than by flattening - the speed of a
+// cubic is a smooth function, so a single 8-point rule is usually exact to well below any tolerance callers pass. Adaptive
+// bisection catches the degenerate cases (cusps, or control points doubling back) where the quadrature disagrees with itself.
+
 static CGFloat lengthOfBezier(const NSPoint bez[4],
 	CGFloat acceptableError)
 {
-	CGFloat polyLen = 0.0;
-	CGFloat chordLen = distanceBetween(bez[0], bez[3]);
-	CGFloat retLen, errLen;
-	NSUInteger n;
+	CGFloat whole = gaussLengthOfBezier(bez);
 
-	for (n = 0; n < 3; ++n)
-		polyLen += distanceBetween(bez[n], bez[n + 1]);
+	NSPoint left[4], right[4];
+	subdivideBezier(bez, left, right);
 
-	errLen = polyLen - chordLen;
+	CGFloat halves = gaussLengthOfBezier(left) + gaussLengthOfBezier(right);
 
-	if (errLen > acceptableError) {
-		NSPoint left[4], right[4];
-		subdivideBezier(bez, left, right);
-		retLen = (lengthOfBezier(left, acceptableError)
-			+ lengthOfBezier(right, acceptableError));
-	} else {
-		retLen = 0.5 * (polyLen + chordLen);
-	}
+	if (fabs(whole - halves) <= acceptableError)
+		return halves;
 
-	return retLen;
+	return lengthOfBezier(left, 0.5 * acceptableError) + lengthOfBezier(right, 0.5 * acceptableError);
 }
 
 // Split a curve at a specific length
@@ -1965,36 +2648,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (CGFloat)lengthOfElement:(NSInteger)i
 {
-	if (i < 0 || i >= [self elementCount])
-		return -1.0;
-
-	if (i == 0)
-		return 0.0;
-	else {
-		NSPoint ap[4];
-		NSBezierPathElement element = [self elementAtIndex:i
-										  associatedPoints:&ap[1]];
-
-		NSPoint pp[3];
-		NSBezierPathElement prev = [self elementAtIndex:i - 1
-									   associatedPoints:pp];
-
-		if (prev == NSCurveToBezierPathElement)
-			ap[0] = pp[2];
-		else
-			ap[0] = pp[0];
-
-		if (element == NSCurveToBezierPathElement)
-			return lengthOfBezier(ap, 0.1);
-		else if (element == NSLineToBezierPathElement)
-			return distanceBetween(ap[1], ap[0]);
-		else if (element == NSClosePathBezierPathElement) {
-			[self elementAtIndex:0
-				associatedPoints:pp];
-			return distanceBetween(pp[0], ap[0]);
-		} else
-			return 0.0;
-	}
+	return [[self elementLengthTable] lengthOfElement:i];
 }
 
 - (CGFloat)lengthOfPathFromElement:(NSInteger)startElement toElement:(NSInteger)endElement
@@ -2034,6 +2688,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 		return self;
 
 	NSBezierPath* newPath = [NSBezierPath bezierPath];
+	DKPathElementLengthTable* lengthTable = [self elementLengthTable];
 	NSInteger elements = [self elementCount];
 	NSInteger n;
 	CGFloat length = 0.0;
@@ -2054,7 +2709,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 			continue;
 
 		case NSLineToBezierPathElement:
-			elementLength = distanceBetween(lastPoint, points[0]);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length + elementLength <= trimLength)
 				[newPath lineToPoint:points[0]];
@@ -2070,7 +2725,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 		case NSCurveToBezierPathElement: {
 			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			elementLength = lengthOfBezier(bezier, maxError);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length + elementLength <= trimLength)
 				[newPath curveToPoint:points[2]
@@ -2091,7 +2746,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 		}
 
 		case NSClosePathBezierPathElement:
-			elementLength = distanceBetween(lastPoint, pointForClose);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length + elementLength <= trimLength) {
 				[newPath closePath];
@@ -2125,6 +2780,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 		return self;
 
 	NSBezierPath* newPath = [NSBezierPath bezierPath];
+	DKPathElementLengthTable* lengthTable = [self elementLengthTable];
 	NSInteger elements = [self elementCount];
 	NSInteger n;
 	CGFloat length = 0.0;
@@ -2146,7 +2802,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 			continue;
 
 		case NSLineToBezierPathElement:
-			elementLength = distanceBetween(lastPoint, points[0]);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length > trimLength)
 				[newPath lineToPoint:points[0]];
@@ -2162,7 +2818,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 		case NSCurveToBezierPathElement: {
 			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			elementLength = lengthOfBezier(bezier, maxError);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length > trimLength)
 				[newPath curveToPoint:points[2]
@@ -2183,7 +2839,7 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 		}
 
 		case NSClosePathBezierPathElement:
-			elementLength = distanceBetween(lastPoint, pointForClose);
+			elementLength = [lengthTable lengthOfElement:n];
 
 			if (length > trimLength) {
 				[newPath lineToPoint:pointForClose];
@@ -2227,16 +2883,12 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (NSBezierPath*)bezierPathByTrimmingFromCentre:(CGFloat)trimLength withMaximumError:(CGFloat)maxError
 {
-	CGFloat centre = [self length] * 0.5;
-
-	NSBezierPath* temp1 = [self bezierPathByTrimmingToLength:centre - (trimLength * 0.5)
-											withMaximumError:maxError];
-	NSBezierPath* temp2 = [self bezierPathByTrimmingFromLength:centre + (trimLength * 0.5)
-											  withMaximumError:maxError];
+	CGFloat centre = [[self elementLengthTable] totalLength] * 0.5;
 
-	[temp1 appendBezierPath:temp2];
-
-	return temp1;
+	return [self trimmedPathFromLength:centre - (trimLength * 0.5)
+							  toLength:centre + (trimLength * 0.5)
+								invert:YES
+					  withMaximumError:maxError];
 }
 
 - (NSBezierPath*)bezierPathByTrimmingFromLength:(CGFloat)startLength toLength:(CGFloat)newLength
@@ -2248,10 +2900,147 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (NSBezierPath*)bezierPathByTrimmingFromLength:(CGFloat)startLength toLength:(CGFloat)newLength withMaximumError:(CGFloat)maxError
 {
-	NSBezierPath* temp = [self bezierPathByTrimmingFromLength:startLength
-											 withMaximumError:maxError];
-	return [temp bezierPathByTrimmingToLength:newLength
-							 withMaximumError:maxError];
+	// <newLength> is the length of the result, measured from <startLength>
+
+	return [self trimmedPathFromLength:startLength
+							  toLength:startLength + newLength
+								invert:NO
+					  withMaximumError:maxError];
+}
+
+- (NSBezierPath*)trimmedPathFromLength:(CGFloat)startLength toLength:(CGFloat)endLength invert:(BOOL)invert withMaximumError:(CGFloat)maxError
+{
+	// single-pass core for the combined trimming operations. One walk over the elements emits the
+	// kept portion(s) directly, where the equivalent chained trims each rebuilt the whole path and
+	// re-measured it. With <invert> NO the arc-length range [startLength, endLength] is kept; with
+	// <invert> YES that range is knocked out and the two flanking pieces are kept, joined by a
+	// moveTo (the in-line dimensioning gap in DKArrowStroke).
+
+	DKPathElementLengthTable* lengthTable = [self elementLengthTable];
+	CGFloat totalLength = [lengthTable totalLength];
+
+	if (startLength < 0.0)
+		startLength = 0.0;
+
+	if (endLength > totalLength)
+		endLength = totalLength;
+
+	if (endLength <= startLength)
+		return invert ? self : [NSBezierPath bezierPath];
+
+	if (!invert && startLength <= 0.0 && endLength >= totalLength)
+		return self;
+
+	// the kept set is one or two arc-length intervals
+
+	CGFloat keep[2][2];
+	NSInteger keepCount;
+
+	if (invert) {
+		keep[0][0] = 0.0;
+		keep[0][1] = startLength;
+		keep[1][0] = endLength;
+		keep[1][1] = totalLength;
+		keepCount = 2;
+	} else {
+		keep[0][0] = startLength;
+		keep[0][1] = endLength;
+		keepCount = 1;
+	}
+
+	NSBezierPath* newPath = [NSBezierPath bezierPath];
+	NSInteger elements = [self elementCount];
+	NSInteger n;
+	CGFloat length = 0.0;
+	CGFloat emittedUpTo = 0.0; // arc length position of the last emitted point
+	NSPoint pointForClose = NSZeroPoint;
+	NSPoint lastPoint = NSZeroPoint;
+	BOOL needsMove = YES; // a moveTo is required before the next emitted piece
+
+	for (n = 0; n < elements; ++n) {
+		NSPoint points[3];
+		NSBezierPathElement element = [self elementAtIndex:n
+										  associatedPoints:points];
+
+		if (element == NSMoveToBezierPathElement) {
+			pointForClose = lastPoint = points[0];
+			needsMove = YES;
+			continue;
+		}
+
+		CGFloat elementLength = [lengthTable lengthOfElement:n];
+		NSPoint target = (element == NSClosePathBezierPathElement) ? pointForClose : ((element == NSCurveToBezierPathElement) ? points[2] : points[0]);
+		NSInteger k;
+
+		for (k = 0; k < keepCount; ++k) {
+			CGFloat lo = MAX(length, keep[k][0]);
+			CGFloat hi = MIN(length + elementLength, keep[k][1]);
+
+			if (hi <= lo)
+				continue;
+
+			// [a, b] is the emitted sub-range in this element's own arc length
+
+			CGFloat a = lo - length;
+			CGFloat b = hi - length;
+
+			if (lo > emittedUpTo)
+				needsMove = YES;
+
+			if (element == NSCurveToBezierPathElement) {
+				NSPoint work[4] = { lastPoint, points[0], points[1], points[2] };
+
+				if (a > 0.0 || b < elementLength) {
+					NSPoint bez1[4], bez2[4];
+
+					if (a > 0.0) {
+						subdivideBezierAtLength(work, bez1, bez2, a, maxError);
+						memcpy(work, bez2, sizeof(work));
+					}
+
+					if (b < elementLength) {
+						subdivideBezierAtLength(work, bez1, bez2, b - a, maxError);
+						memcpy(work, bez1, sizeof(work));
+					}
+				}
+
+				if (needsMove)
+					[newPath moveToPoint:work[0]];
+
+				[newPath curveToPoint:work[3]
+						controlPoint1:work[1]
+						controlPoint2:work[2]];
+			} else if (a <= 0.0 && b >= elementLength && element == NSClosePathBezierPathElement && !needsMove) {
+				[newPath closePath];
+			} else {
+				// lines and close elements trim by linear interpolation
+
+				CGFloat f0 = (elementLength > 0.0) ? (a / elementLength) : 0.0;
+				CGFloat f1 = (elementLength > 0.0) ? (b / elementLength) : 1.0;
+
+				if (needsMove)
+					[newPath moveToPoint:NSMakePoint(lastPoint.x + f0 * (target.x - lastPoint.x), lastPoint.y + f0 * (target.y - lastPoint.y))];
+
+				[newPath lineToPoint:NSMakePoint(lastPoint.x + f1 * (target.x - lastPoint.x), lastPoint.y + f1 * (target.y - lastPoint.y))];
+			}
+
+			needsMove = NO;
+			emittedUpTo = hi;
+
+			if (hi < length + elementLength)
+				needsMove = YES; // the rest of this element is skipped
+		}
+
+		length += elementLength;
+		lastPoint = target;
+
+		// once past the last kept interval there is nothing more to emit
+
+		if (length >= keep[keepCount - 1][1])
+			break;
+	}
+
+	return newPath;
 }
 
 #pragma mark -
@@ -2349,45 +3138,12 @@ static CGFloat subdivideBezierAtLength(const NSPoint bez[4],
 
 - (CGFloat)lengthWithMaximumError:(CGFloat)maxError
 {
-	NSInteger elements = [self elementCount];
-	NSInteger n;
-	CGFloat length = 0.0;
-	NSPoint pointForClose = NSMakePoint(0.0, 0.0);
-	NSPoint lastPoint = NSMakePoint(0.0, 0.0);
-
-	for (n = 0; n < elements; ++n) {
-		NSPoint points[3];
-		NSBezierPathElement element = [self elementAtIndex:n
-										  associatedPoints:points];
-
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			pointForClose = lastPoint = points[0];
-			break;
-
-		case NSLineToBezierPathElement:
-			length += distanceBetween(lastPoint, points[0]);
-			lastPoint = points[0];
-			break;
-
-		case NSCurveToBezierPathElement: {
-			NSPoint bezier[4] = { lastPoint, points[0], points[1], points[2] };
-			length += lengthOfBezier(bezier, maxError);
-			lastPoint = points[2];
-			break;
-		}
+	// the memoized element table is measured to a tighter tolerance than any caller passes, so its total
+	// can be returned directly whatever <maxError> is asked for.
 
-		case NSClosePathBezierPathElement:
-			length += distanceBetween(lastPoint, pointForClose);
-			lastPoint = pointForClose;
-			break;
-
-		default:
-			break;
-		}
-	}
+	(void)maxError;
 
-	return length;
+	return [[self elementLengthTable] totalLength];
 }
 
 @end
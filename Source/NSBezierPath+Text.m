@@ -5,6 +5,7 @@
 */
 
 #import "DKBezierLayoutManager.h"
+#import "DKDrawingView.h"
 #import "DKGeometryUtilities.h"
 #import "NSBezierPath+Editing.h"
 #import "NSBezierPath+Geometry.h"
@@ -28,6 +29,31 @@
 static NSString* kDKTextOnPathGlyphPositionCacheKey = @"DKTextOnPathGlyphPositions";
 static NSString* kDKTextOnPathChecksumCacheKey = @"DKTextOnPathChecksum";
 static NSString* kDKTextOnPathTextFittedCacheKey = @"DKTextOnPathTextFitted";
+static NSString* kDKTextOnPathLayoutManagerCacheKey = @"DKTextOnPathLayoutManager";
+static NSString* kDKTextOnPathTextStorageCacheKey = @"DKTextOnPathTextStorage";
+static NSString* kDKTextOnPathTextChecksumCacheKey = @"DKTextOnPathTextChecksum";
+
+// YES if the string carries underline or strikethrough attributes anywhere. Those are drawn in
+// separate per-frame passes over the text storage, which the retained layout fast path does not
+// attempt to reproduce - such strings take the shared layout manager route instead.
+
+static BOOL DKStringHasLineAttributes(NSAttributedString* str)
+{
+	NSUInteger rangeLimit = 0;
+	NSRange effectiveRange;
+
+	while (rangeLimit < [str length]) {
+		NSDictionary* attrs = [str attributesAtIndex:rangeLimit
+									  effectiveRange:&effectiveRange];
+
+		if ([[attrs objectForKey:NSUnderlineStyleAttributeName] integerValue] > 0 || [[attrs objectForKey:NSStrikethroughStyleAttributeName] integerValue] > 0)
+			return YES;
+
+		rangeLimit = NSMaxRange(effectiveRange);
+	}
+
+	return NO;
+}
 
 @implementation NSBezierPath (TextOnPath)
 
@@ -101,7 +127,9 @@ static NSDictionary* s_TOPTextAttributes = nil;
 /** @brief Renders a string on a path.
 
  Passing nil for the layout manager uses the shared layout manager. If the same cache is passed back
- each time by the client code, certain calculations are cached there which can speed up drawing. The
+ each time by the client code, certain calculations are cached there which can speed up drawing. Where
+ possible the complete glyph layout is retained in the cache as well, so redrawing unchanged text on an
+ unchanged path performs no layout work at all - the cached per-glyph positions are simply replayed. The
  client owns the cache and is responsible for invalidating it (setting it empty) when text content changes.
  However the client code doesn't need to consider path changes - they are handled automatically.
  @param str the attributed string to render
@@ -130,11 +158,48 @@ static NSDictionary* s_TOPTextAttributes = nil;
 				  forKey:kDKTextOnPathChecksumCacheKey];
 	}
 
+	NSUInteger textCS = [str hash];
+
+	// fast path: if a previous draw retained its layout in the cache and neither the path nor the
+	// text has changed since, the cached glyph positions are replayed against the retained layout
+	// manager directly - no text storage rebuild and no layout work at all.
+
+	if (lm == nil && cache != nil) {
+		NSLayoutManager* cachedLM = [cache objectForKey:kDKTextOnPathLayoutManagerCacheKey];
+		NSArray* glyphCache = [cache objectForKey:kDKTextOnPathGlyphPositionCacheKey];
+
+		if (cachedLM != nil && glyphCache != nil && [[cache objectForKey:kDKTextOnPathTextChecksumCacheKey] unsignedIntegerValue] == textCS) {
+			DKTextOnPathGlyphDrawer* gd = [[DKTextOnPathGlyphDrawer alloc] init];
+
+			for (DKPathGlyphInfo* info in glyphCache)
+				[gd layoutManager:cachedLM
+					willPlaceGlyphAtIndex:[info glyphIndex]
+							   atLocation:[info point]
+								pathAngle:[info slope]
+								  yOffset:dy];
+
+			return [[cache objectForKey:kDKTextOnPathTextFittedCacheKey] boolValue];
+		}
+	}
+
 	BOOL usingStandardLM = NO;
+	BOOL retainLayout = NO;
 
 	if (lm == nil) {
-		lm = [[self class] textOnPathLayoutManager];
-		usingStandardLM = YES;
+		// a layout built against a private layout manager can be kept in the cache and replayed by
+		// later draws. The shared manager cannot be retained - any other text on path draw would
+		// invalidate its layout.
+
+		retainLayout = (cache != nil && !DKStringHasLineAttributes(str));
+
+		if (retainLayout) {
+			lm = [[NSLayoutManager alloc] init];
+			[lm addTextContainer:[[NSTextContainer alloc] initWithContainerSize:NSMakeSize(1.0e6, 1.0e6)]];
+			[lm setUsesScreenFonts:NO];
+		} else {
+			lm = [[self class] textOnPathLayoutManager];
+			usingStandardLM = YES;
+		}
 	}
 
 	NSTextStorage* text = [self preadjustedTextStorageWithString:str
@@ -158,6 +223,18 @@ static NSDictionary* s_TOPTextAttributes = nil;
 							 layoutManager:lm
 									 cache:cache];
 
+	if (retainLayout) {
+		// keep the laid-out storage and its manager alongside the glyph positions. The storage is
+		// what keeps the layout manager alive, so both must be cached to retain the layout.
+
+		[cache setObject:lm
+				  forKey:kDKTextOnPathLayoutManagerCacheKey];
+		[cache setObject:text
+				  forKey:kDKTextOnPathTextStorageCacheKey];
+		[cache setObject:@(textCS)
+				  forKey:kDKTextOnPathTextChecksumCacheKey];
+	}
+
 	// draw strikethrough attributes based on the original string
 
 	if (usingStandardLM) {
@@ -871,9 +948,10 @@ static NSDictionary* s_TOPTextAttributes = nil;
 		trimmedPath = [self bezierPathByTrimmingFromLength:sp
 												  toLength:length];
 
-	[trimmedPath setFlatness:0.1];
+	CGFloat lineFlatness = [DKDrawingView flatnessForViewScale:0.1];
+	[trimmedPath setFlatness:lineFlatness];
 	CGFloat savedFlatness = [NSBezierPath defaultFlatness];
-	[NSBezierPath setDefaultFlatness:0.1];
+	[NSBezierPath setDefaultFlatness:lineFlatness];
 
 	// parallel offset has opposite sign to text offset
 
@@ -1283,6 +1361,7 @@ static NSInteger SortPointsHorizontally(NSValue* value1, NSValue* value2, void*
 	hlb.x = NSMaxX(br) + 1;
 
 	// we can use a relatively coarse flatness for more speed - exact precision isn't needed for text layout.
+	// this is deliberately not scaled to the view zoom: layout geometry must not change as the user zooms.
 
 	CGFloat savedFlatness = [self flatness];
 	[self setFlatness:5.0];
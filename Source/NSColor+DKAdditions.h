@@ -197,4 +197,27 @@ NS_ASSUME_NONNULL_BEGIN
 
 @end
 
+// batch colour-space conversion over float arrays:
+
+/** @brief Converts an array of sRGB-encoded component values to linear light, in place.
+
+ Vectorized over the whole array with Accelerate, so thousands of components convert for a small
+ fraction of the cost of per-value \c pow calls. Intended for bulk pixel and palette work where
+ converting through NSColor one colour at a time is far too slow. Components are treated
+ independently, so RGB data may be passed packed or planar; alpha is already linear and must not
+ be routed through this.
+ @param values the component values, each 0..1; converted in place
+ @param count the number of values
+ */
+void DKColourBatchSRGBToLinear(float* values, NSUInteger count);
+
+/** @brief Converts an array of linear-light component values to sRGB encoding, in place.
+
+ The inverse of <code>DKColourBatchSRGBToLinear</code>, with the same vectorization and the same
+ packed-or-planar flexibility.
+ @param values the component values, each 0..1; converted in place
+ @param count the number of values
+ */
+void DKColourBatchLinearToSRGB(float* values, NSUInteger count);
+
 NS_ASSUME_NONNULL_END
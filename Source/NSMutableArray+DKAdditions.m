@@ -11,11 +11,16 @@
 /**  */
 - (void)addUniqueObjectsFromArray:(NSArray*)array
 {
-	// adds objects from <array> to the receiver, but only those not already contained by it
+	// adds objects from <array> to the receiver, but only those not already contained by it.
+	// membership is tested against a set so that bulk merges stay linear rather than quadratic
+
+	NSMutableSet* present = [NSMutableSet setWithArray:self];
 
 	for (id obj in array) {
-		if (![self containsObject:obj])
+		if (![present containsObject:obj]) {
 			[self addObject:obj];
+			[present addObject:obj];
+		}
 	}
 }
 
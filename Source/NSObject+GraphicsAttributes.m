@@ -9,18 +9,143 @@
 #import "DKExpression.h"
 #import "LogEvent.h"
 
+#import <objc/message.h>
+#import <pthread.h>
+
 @interface DKExpression (DKRasterizerHelper)
 
 - (void)applyValuesTo:anObject skippingFirstElement:(BOOL)skipit;
 
 @end
 
+#pragma mark -
+
+/** @brief compiled setter binding for one attribute of one class.
+
+ records the setter selector and its argument type code, resolved once the first time a spec
+ attribute is parsed for a class. Applying the attribute thereafter is a direct message send with
+ the value unboxed to the right scalar type, bypassing KVC's per-call string lookup entirely.
+*/
+@interface DKCompiledAttributeBinding : NSObject {
+@public
+	SEL mSelector;
+	char mArgType; // objc type code of the setter's single argument
+}
+@end
+
+@implementation DKCompiledAttributeBinding
+@end
+
+static DKCompiledAttributeBinding* bindingForAttribute(Class cls, NSString* key)
+{
+	// the table maps "ClassName.key" to a compiled binding, or NSNull where no simple setter
+	// exists so the KVC fallback isn't re-probed on every parse. As with the symbol table, an
+	// immutable snapshot is published for lock-free reads and superseded snapshots are
+	// deliberately left alive rather than released under a concurrent reader.
+
+	static NSMutableDictionary* sBindingMap = nil;
+	static NSDictionary* sBindingSnapshot = nil;
+	static pthread_mutex_t sBindingLock = PTHREAD_MUTEX_INITIALIZER;
+
+	if ([key length] == 0)
+		return nil;
+
+	NSString* mapKey = [NSString stringWithFormat:@"%@.%@", NSStringFromClass(cls), key];
+	id binding = [sBindingSnapshot objectForKey:mapKey];
+
+	if (binding != nil)
+		return (binding == (id)[NSNull null]) ? nil : binding;
+
+	pthread_mutex_lock(&sBindingLock);
+
+	if (sBindingMap == nil)
+		sBindingMap = [[NSMutableDictionary alloc] init];
+
+	binding = [sBindingMap objectForKey:mapKey];
+
+	if (binding == nil) {
+		binding = (id)[NSNull null];
+
+		SEL sel = NSSelectorFromString([NSString stringWithFormat:@"set%@%@:",
+																  [[key substringToIndex:1] uppercaseString],
+																  [key substringFromIndex:1]]);
+		NSMethodSignature* sig = [cls instanceMethodSignatureForSelector:sel];
+
+		if (sig != nil && [sig numberOfArguments] == 3) {
+			char code = [sig getArgumentTypeAtIndex:2][0];
+
+			switch (code) {
+			case '@':
+			case 'd':
+			case 'f':
+			case 'c':
+			case 'B':
+			case 'i':
+			case 'I':
+			case 'l':
+			case 'L':
+			case 'q':
+			case 'Q': {
+				DKCompiledAttributeBinding* b = [[[DKCompiledAttributeBinding alloc] init] autorelease];
+				b->mSelector = sel;
+				b->mArgType = code;
+				binding = b;
+			} break;
+
+			default:
+				// struct and other exotic arguments stay on the KVC path
+				break;
+			}
+		}
+
+		[sBindingMap setObject:binding
+						forKey:mapKey];
+		sBindingSnapshot = [sBindingMap copy];
+	}
+
+	pthread_mutex_unlock(&sBindingLock);
+
+	return (binding == (id)[NSNull null]) ? nil : binding;
+}
+
+static void applyBindingToObject(DKCompiledAttributeBinding* b, id target, id value)
+{
+	switch (b->mArgType) {
+	case '@':
+		((void (*)(id, SEL, id))objc_msgSend)(target, b->mSelector, value);
+		break;
+
+	case 'd':
+		((void (*)(id, SEL, double))objc_msgSend)(target, b->mSelector, [value doubleValue]);
+		break;
+
+	case 'f':
+		((void (*)(id, SEL, float))objc_msgSend)(target, b->mSelector, [value floatValue]);
+		break;
+
+	case 'c':
+	case 'B':
+		((void (*)(id, SEL, char))objc_msgSend)(target, b->mSelector, (char)[value intValue]);
+		break;
+
+	case 'i':
+	case 'I':
+		((void (*)(id, SEL, int))objc_msgSend)(target, b->mSelector, [value intValue]);
+		break;
+
+	default: // 'l', 'L', 'q', 'Q'
+		((void (*)(id, SEL, long long))objc_msgSend)(target, b->mSelector, [value longLongValue]);
+		break;
+	}
+}
+
 #pragma mark -
 @implementation DKExpression (DKRasterizerHelper)
 
 - (void)applyValuesTo:anObject skippingFirstElement:(BOOL)skipit
 {
 	Class PairClass = [DKExpressionPair class];
+	Class objectClass = [anObject class];
 	NSEnumerator* curs = [mValues objectEnumerator];
 	DKExpressionPair* pair;
 	NSInteger position = 0;
@@ -29,10 +154,18 @@
 		[curs nextObject];
 
 	while ((pair = [curs nextObject])) {
-		if ([pair isKindOfClass:PairClass])
-			[anObject setValue:[pair value]
-						forKey:[pair key]];
-		else
+		if ([pair isKindOfClass:PairClass]) {
+			// keyed attributes go through the compiled binding table where possible; only
+			// attributes with no simple setter fall back to the generic KVC path
+
+			DKCompiledAttributeBinding* binding = bindingForAttribute(objectClass, [pair key]);
+
+			if (binding != nil)
+				applyBindingToObject(binding, anObject, [pair value]);
+			else
+				[anObject setValue:[pair value]
+							forKey:[pair key]];
+		} else
 			[anObject setValue:pair
 				forNumericParameter:position];
 
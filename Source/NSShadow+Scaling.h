@@ -8,6 +8,8 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class DKDrawableObject;
+
 typedef NS_OPTIONS(NSUInteger, DKShadowDrawingOperation) {
 	kDKShadowDrawFill = (1 << 0),
 	kDKShadowDrawStroke = (1 << 1)
@@ -39,6 +41,24 @@ typedef NS_OPTIONS(NSUInteger, DKShadowDrawingOperation) {
 
 - (void)drawApproximateShadowWithPath:(NSBezierPath*)path operation:(DKShadowDrawingOperation)op strokeWidth:(NSInteger)sw;
 
+/** @brief Draws the shadow for \c obj from a cached shadow-only bitmap.
+
+ Blurring is the expensive part of a shadow, and it is repeated on every refresh even though the
+ result only changes when the shadowed content does. This renders the blurred shadow alone into an
+ offscreen bitmap once, composites the bitmap behind the object, and reuses it until the object's
+ or style's generation counters, the path complexity or the shadow parameters change. Call this
+ instead of \c setAbsolute and draw the fill or stroke normally afterwards, without a context shadow.
+
+ When \c lowQuality is YES (rapid drawing, live drags) the bitmap is rendered at half scale -
+ a quarter of the pixels to blur - and stretched on compositing, which is barely visible on an
+ already-blurred shadow. Cached entries are dropped automatically when the object is deallocated.
+ */
+- (void)drawCachedShadowWithPath:(NSBezierPath*)path
+					   forObject:(DKDrawableObject*)obj
+					   operation:(DKShadowDrawingOperation)op
+					 strokeWidth:(NSInteger)sw
+					  lowQuality:(BOOL)lowQuality;
+
 @end
 
 NS_ASSUME_NONNULL_END
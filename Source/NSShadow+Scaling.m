@@ -5,10 +5,27 @@
 */
 
 #import "DKDrawKitMacros.h"
+#import "DKRenderCacheKey.h"
 #import "NSColor+DKAdditions.h"
 #import "NSShadow+Scaling.h"
 #include <tgmath.h>
 
+// everything a cached shadow bitmap depends on besides the operation and stroke width - the
+// generation key covers the object, style and path, the rest are the blur parameters
+
+typedef struct {
+	DKRenderCacheKey renderKey;
+	CGFloat offsetWidth;
+	CGFloat offsetHeight;
+	CGFloat blur;
+} DKShadowBitmapStamp;
+
+// cache of shadow-only bitmaps, weakly keyed by the shadowed object so entries vanish with it.
+// each value is a dictionary of slots (one per operation/stroke width) holding a bitmap and the
+// stamp it was built under. Only touched from the drawing thread, like the other render caches.
+
+static NSMapTable* sShadowBitmapCache = nil;
+
 @implementation NSShadow (DKAdditions)
 #pragma mark As a NSShadow
 
@@ -168,4 +185,144 @@
 	}
 }
 
+- (NSImage*)shadowOnlyBitmapWithPath:(NSBezierPath*)path bounds:(NSRect)br operation:(DKShadowDrawingOperation)op strokeWidth:(NSInteger)sw scale:(CGFloat)scale flipped:(BOOL)flipped
+{
+	// renders just the blurred shadow of <path> into a bitmap covering <br> at <scale> pixels per
+	// point. The trick is to draw the path displaced wholly off the bitmap with the shadow offset
+	// displaced back by the same amount, so only the shadow lands on pixels.
+
+	NSSize pixelSize = NSMakeSize(ceil(br.size.width * scale), ceil(br.size.height * scale));
+
+	if (pixelSize.width < 1.0 || pixelSize.height < 1.0 || pixelSize.width > 8192.0 || pixelSize.height > 8192.0)
+		return nil;
+
+	NSImage* image = [[NSImage alloc] initWithSize:pixelSize];
+
+	[image lockFocus];
+
+	CGContextRef cc = [[NSGraphicsContext currentContext] graphicsPort];
+
+	// the bitmap context is unflipped; when the destination is flipped the offset height must be
+	// negated here so the shadow falls the same way it would have under setAbsolute
+
+	NSSize os = [self shadowOffset];
+
+	if (flipped)
+		os.height = -os.height;
+
+	CGFloat displacement = pixelSize.width + (fabs(os.width) + [self shadowBlurRadius] * 2.0) * scale;
+
+	CGColorRef colour = [[self shadowColor] newQuartzColor];
+	CGContextSetShadowWithColor(cc, CGSizeMake(os.width * scale + displacement, os.height * scale), [self shadowBlurRadius] * scale, colour);
+	CGColorRelease(colour);
+
+	CGContextTranslateCTM(cc, -displacement, 0.0);
+	CGContextScaleCTM(cc, scale, scale);
+	CGContextTranslateCTM(cc, -NSMinX(br), -NSMinY(br));
+
+	// the path itself is clipped out, so its colour is immaterial
+
+	[[NSColor blackColor] set];
+
+	if (op & kDKShadowDrawFill)
+		[path fill];
+
+	if (op & kDKShadowDrawStroke) {
+		NSBezierPath* temp = [path copy];
+		[temp setLineWidth:sw];
+		[temp stroke];
+	}
+
+	[image unlockFocus];
+
+	return image;
+}
+
+- (void)drawCachedShadowWithPath:(NSBezierPath*)path forObject:(DKDrawableObject*)obj operation:(DKShadowDrawingOperation)op strokeWidth:(NSInteger)sw lowQuality:(BOOL)lowQuality
+{
+	NSAssert(path != nil, @"path was nil when drawing cached shadow");
+
+	if (obj == nil || [path isEmpty]) {
+		[self setAbsolute];
+		return;
+	}
+
+	// render at the destination's device scale so the shadow stays sharp when zoomed in. The low
+	// quality tier used during rapid drawing halves the scale - a quarter of the pixels to blur
+
+	CGContextRef cc = [[NSGraphicsContext currentContext] graphicsPort];
+	CGSize unit = CGSizeApplyAffineTransform(CGSizeMake(1, 1), CGContextGetCTM(cc));
+	CGFloat scale = fabs(unit.width);
+
+	if (lowQuality)
+		scale *= 0.5;
+
+	scale = LIMIT(scale, 0.1, 8.0);
+
+	CGFloat es = [self extraSpace] + ((op & kDKShadowDrawStroke) ? ABS(sw) * 0.5 : 0.0);
+	NSRect br = NSInsetRect([path bounds], -es, -es);
+
+	DKShadowBitmapStamp stamp;
+	stamp.renderKey = DKRenderCacheKeyForObject(obj, path, scale);
+	stamp.offsetWidth = [self shadowOffset].width;
+	stamp.offsetHeight = [self shadowOffset].height;
+	stamp.blur = [self shadowBlurRadius];
+
+	if (sShadowBitmapCache == nil)
+		sShadowBitmapCache = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality
+													   valueOptions:NSPointerFunctionsStrongMemory
+														   capacity:32];
+
+	NSMutableDictionary* slots = [sShadowBitmapCache objectForKey:obj];
+
+	if (slots == nil) {
+		slots = [NSMutableDictionary dictionary];
+		[sShadowBitmapCache setObject:slots
+							   forKey:obj];
+	}
+
+	NSString* slotKey = [NSString stringWithFormat:@"%lu.%ld", (unsigned long)op, (long)sw];
+	NSDictionary* entry = [slots objectForKey:slotKey];
+	NSImage* bitmap = nil;
+
+	if (entry != nil) {
+		DKShadowBitmapStamp prev;
+		[(NSValue*)[entry objectForKey:@"stamp"] getValue:&prev];
+
+		if (DKRenderCacheKeyEqual(prev.renderKey, stamp.renderKey) && prev.offsetWidth == stamp.offsetWidth && prev.offsetHeight == stamp.offsetHeight && prev.blur == stamp.blur)
+			bitmap = [entry objectForKey:@"bitmap"];
+	}
+
+	BOOL flipped = [[NSGraphicsContext currentContext] isFlipped];
+
+	if (bitmap == nil) {
+		bitmap = [self shadowOnlyBitmapWithPath:path
+										 bounds:br
+									  operation:op
+									strokeWidth:sw
+										  scale:scale
+										flipped:flipped];
+
+		if (bitmap == nil) {
+			// degenerate or oversized - fall back to the live shadow
+
+			[slots removeObjectForKey:slotKey];
+			[self setAbsolute];
+			return;
+		}
+
+		[slots setObject:@{ @"bitmap": bitmap,
+			@"stamp": [NSValue valueWithBytes:&stamp
+									 objCType:@encode(DKShadowBitmapStamp)] }
+				  forKey:slotKey];
+	}
+
+	[bitmap drawInRect:br
+			  fromRect:NSZeroRect
+			 operation:NSCompositeSourceOver
+			  fraction:1.0
+		respectFlipped:YES
+				 hints:nil];
+}
+
 @end
@@ -9,6 +9,7 @@
 #import "NSBezierPath-OAInternal.h"
 
 #import <AppKit/AppKit.h>
+#import <objc/runtime.h>
 //#import <OmniBase/OmniBase.h>
 //#import <OmniBase/assertions.h>
 
@@ -47,6 +48,7 @@ static NSInteger _solveCubic(const double* c, double* roots, NSInteger* multipli
 static BOOL _straightLineIntersectsRect(const NSPoint* a, NSRect rect);
 // static void _splitCurve(const NSPoint *c, NSPoint *left, NSPoint *right);  // Not currently used
 static BOOL _curvedLineIntersectsRect(const NSPoint* c, NSRect rect, CGFloat tolerance);
+static NSRect _boundsOfCurveSegment(const NSPoint startPoint, const NSPoint endPoint, const NSPoint cp1, const NSPoint cp2);
 
 //
 
@@ -95,6 +97,221 @@ static struct pointInfo getLinePoint(const NSPoint* a, CGFloat position)
 	};
 }
 
+#pragma mark -
+
+/* Cached per-path segment index. intersectsRect: and the segment hit queries used to walk every element of the
+   path, recomputing bounds as they went - costly when tools hover these queries continuously over long paths.
+   The index snapshots each drawable segment's geometry and bounding box once and stacks the boxes into a flat
+   implicit binary tree (each node the union of its children), so a query descends only the subtrees whose
+   bounds it touches. It hangs off the path as an associated object and is rebuilt lazily when the path's
+   element count or bounds no longer match, the same scheme the geometry caches in DK proper use. */
+
+struct pathSegmentRecord {
+	NSBezierPathElement what;
+	NSInteger elt; // index of this element in the source path
+	NSPoint pts[4]; // pts[0] is the currentpoint; lines/closepaths use pts[0..1], curves pts[0..3]
+	NSRect bounds;
+};
+
+// marker for tree nodes covering no segments; comparisons are inclusive so degenerate (zero-width) boxes still match
+
+static inline BOOL indexNodeIntersectsRect(NSRect node, NSRect r)
+{
+	return node.size.width >= 0 && NSMaxX(node) >= NSMinX(r) && NSMinX(node) <= NSMaxX(r) && NSMaxY(node) >= NSMinY(r) && NSMinY(node) <= NSMaxY(r);
+}
+
+static inline NSRect indexNodeUnion(NSRect a, NSRect b)
+{
+	// NSUnionRect treats zero-size rects as empty, which would drop the bounds of axis-aligned lines, so do it by hand
+
+	if (a.size.width < 0)
+		return b;
+	if (b.size.width < 0)
+		return a;
+
+	CGFloat minX = MIN(NSMinX(a), NSMinX(b)), maxX = MAX(NSMaxX(a), NSMaxX(b));
+	CGFloat minY = MIN(NSMinY(a), NSMinY(b)), maxY = MAX(NSMaxY(a), NSMaxY(b));
+
+	return NSMakeRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+@interface DKPathSegmentIndex : NSObject {
+@public
+	struct pathSegmentRecord* mSegments;
+	NSRect* mTree; // implicit binary tree; node 1 is the root, leaves start at mLeafBase
+	NSUInteger mCount;
+	NSUInteger mLeafBase;
+	NSInteger mElementCount;
+	NSRect mBounds;
+}
+
++ (DKPathSegmentIndex*)indexWithPath:(NSBezierPath*)path;
+- (BOOL)isValidForPath:(NSBezierPath*)path;
+- (NSUInteger)getCandidates:(NSUInteger*)buffer forRect:(NSRect)rect;
+
+@end
+
+@implementation DKPathSegmentIndex
+
++ (DKPathSegmentIndex*)indexWithPath:(NSBezierPath*)path
+{
+	DKPathSegmentIndex* index = [[[DKPathSegmentIndex alloc] init] autorelease];
+	NSInteger i, ec = [path elementCount];
+
+	index->mElementCount = ec;
+	index->mBounds = [path bounds];
+	index->mSegments = malloc(((ec > 0) ? (size_t)ec : 1) * sizeof(struct pathSegmentRecord));
+
+	NSPoint points[3];
+	NSPoint currentPoint = NSZeroPoint, startPoint = NSZeroPoint;
+	BOOL needANewStartPoint = NO;
+
+	// the walk mirrors _segmentHitByPoint: - a path not starting with a moveto yields an empty index
+
+	if (ec > 0 && [path elementAtIndex:0 associatedPoints:points] == NSMoveToBezierPathElement) {
+		startPoint = currentPoint = points[0];
+
+		for (i = 1; i < ec; ++i) {
+			NSBezierPathElement element = [path elementAtIndex:i associatedPoints:points];
+			struct pathSegmentRecord* r = &index->mSegments[index->mCount];
+
+			switch (element) {
+			case NSMoveToBezierPathElement:
+				currentPoint = points[0];
+				if (needANewStartPoint) {
+					startPoint = currentPoint;
+					needANewStartPoint = NO;
+				}
+				break;
+			case NSClosePathBezierPathElement:
+			case NSLineToBezierPathElement: {
+				NSPoint endPoint = (element == NSClosePathBezierPathElement) ? startPoint : points[0];
+
+				r->what = element;
+				r->elt = i;
+				r->pts[0] = currentPoint;
+				r->pts[1] = endPoint;
+				r->bounds = NSMakeRect(MIN(currentPoint.x, endPoint.x), MIN(currentPoint.y, endPoint.y), fabs(endPoint.x - currentPoint.x), fabs(endPoint.y - currentPoint.y));
+				index->mCount++;
+
+				currentPoint = endPoint;
+				if (element == NSClosePathBezierPathElement)
+					needANewStartPoint = YES;
+				break;
+			}
+			case NSCurveToBezierPathElement:
+				r->what = element;
+				r->elt = i;
+				r->pts[0] = currentPoint;
+				r->pts[1] = points[0];
+				r->pts[2] = points[1];
+				r->pts[3] = points[2];
+				r->bounds = _boundsOfCurveSegment(currentPoint, points[2], points[0], points[1]);
+				index->mCount++;
+
+				currentPoint = points[2];
+				break;
+
+			default:
+				break;
+			}
+		}
+	}
+
+	// stack the leaf boxes into the implicit tree, parents being the union of their children
+
+	NSUInteger leafBase = 1, n;
+
+	while (leafBase < MAX(index->mCount, (NSUInteger)1))
+		leafBase <<= 1;
+
+	index->mLeafBase = leafBase;
+	index->mTree = malloc(2 * leafBase * sizeof(NSRect));
+
+	for (n = 0; n < leafBase; ++n)
+		index->mTree[leafBase + n] = (n < index->mCount) ? index->mSegments[n].bounds : NSMakeRect(0, 0, -1, -1);
+
+	for (n = leafBase - 1; n >= 1; --n)
+		index->mTree[n] = indexNodeUnion(index->mTree[2 * n], index->mTree[2 * n + 1]);
+
+	return index;
+}
+
+- (BOOL)isValidForPath:(NSBezierPath*)path
+{
+	return mElementCount == [path elementCount] && NSEqualRects(mBounds, [path bounds]);
+}
+
+- (NSUInteger)getCandidates:(NSUInteger*)buffer forRect:(NSRect)rect
+{
+	// fills <buffer> (sized for at least mCount entries) with the indexes of segments whose bounds touch
+	// <rect>, in ascending segment order, and returns how many were found
+
+	NSUInteger stack[64];
+	NSUInteger sp = 0, found = 0;
+
+	if (mCount == 0)
+		return 0;
+
+	stack[sp++] = 1;
+
+	while (sp > 0) {
+		NSUInteger node = stack[--sp];
+
+		if (!indexNodeIntersectsRect(mTree[node], rect))
+			continue;
+
+		if (node >= mLeafBase) {
+			NSUInteger leaf = node - mLeafBase;
+
+			if (leaf < mCount)
+				buffer[found++] = leaf;
+		} else {
+			// push the right child first so the left (lower segment indexes) pops first
+
+			stack[sp++] = 2 * node + 1;
+			stack[sp++] = 2 * node;
+		}
+	}
+
+	return found;
+}
+
+- (void)dealloc
+{
+	if (mSegments)
+		free(mSegments);
+	if (mTree)
+		free(mTree);
+	[super dealloc];
+}
+
+@end
+
+static const void* kDKPathSegmentIndexKey = &kDKPathSegmentIndexKey;
+
+@interface NSBezierPath (DKSegmentIndex)
+- (DKPathSegmentIndex*)_segmentIndex;
+@end
+
+@implementation NSBezierPath (DKSegmentIndex)
+
+- (DKPathSegmentIndex*)_segmentIndex
+{
+	DKPathSegmentIndex* index = objc_getAssociatedObject(self, kDKPathSegmentIndexKey);
+
+	if (index == nil || ![index isValidForPath:self]) {
+		index = [DKPathSegmentIndex indexWithPath:self];
+		objc_setAssociatedObject(self, kDKPathSegmentIndexKey, index, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+
+	return index;
+}
+
+@end
+
+#pragma mark -
+
 @implementation NSBezierPath (OAExtensions)
 
 - (NSPoint)currentpointForSegment:(NSInteger)i
@@ -202,66 +419,39 @@ static struct pointInfo getLinePoint(const NSPoint* a, CGFloat position)
 
 - (BOOL)intersectsRect:(NSRect)rect
 {
-	NSInteger count = [self elementCount];
-	NSInteger i;
-	NSPoint points[3];
-	NSPoint startPoint;
-	NSPoint currentPoint;
+	DKPathSegmentIndex* index = [self _segmentIndex];
+	CGFloat tolerance = [self lineWidth] + 1;
 	NSPoint line[2];
 	NSPoint curve[4];
-	NSInteger element;
-	BOOL needANewStartPoint;
+	NSUInteger c, candidateCount;
 
-	if (count == 0)
+	if (index->mCount == 0)
 		return NO;
 
-	element = [self elementAtIndex:0 associatedPoints:points];
-	if (element != NSMoveToBezierPathElement) {
-		return NO; // must start with a moveTo
-	}
+	NSUInteger* candidates = malloc(index->mCount * sizeof(NSUInteger));
 
-	startPoint = currentPoint = points[0];
-	needANewStartPoint = NO;
+	candidateCount = [index getCandidates:candidates
+								  forRect:NSInsetRect(rect, -tolerance, -tolerance)];
 
-	for (i = 1; i < count; i++) {
-		element = [self elementAtIndex:i associatedPoints:points];
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			currentPoint = points[0];
-			if (needANewStartPoint) {
-				startPoint = currentPoint;
-				needANewStartPoint = NO;
-			}
-			break;
-		case NSClosePathBezierPathElement:
-			_parameterizeLine(line, currentPoint, startPoint);
-			if (_straightLineIntersectsRect(line, rect)) {
+	for (c = 0; c < candidateCount; ++c) {
+		const struct pathSegmentRecord* r = &index->mSegments[candidates[c]];
+
+		if (r->what == NSCurveToBezierPathElement) {
+			_parameterizeCurve(curve, r->pts[0], r->pts[3], r->pts[1], r->pts[2]);
+			if (_curvedLineIntersectsRect(curve, rect, tolerance)) {
+				free(candidates);
 				return YES;
 			}
-			currentPoint = startPoint;
-			needANewStartPoint = YES;
-			break;
-		case NSLineToBezierPathElement:
-			_parameterizeLine(line, currentPoint, points[0]);
+		} else {
+			_parameterizeLine(line, r->pts[0], r->pts[1]);
 			if (_straightLineIntersectsRect(line, rect)) {
+				free(candidates);
 				return YES;
 			}
-			currentPoint = points[0];
-			break;
-		case NSCurveToBezierPathElement: {
-			_parameterizeCurve(curve, currentPoint, points[2], points[0], points[1]);
-			if (_curvedLineIntersectsRect(curve, rect, [self lineWidth] + 1)) {
-				return YES;
-			}
-			currentPoint = points[2];
-			break;
-
-		default:
-			break;
-		}
 		}
 	}
 
+	free(candidates);
 	return NO;
 }
 
@@ -387,6 +577,115 @@ static inline void reverseSenseOfIntersection(struct intersectionInfo* intersect
 	SWAP(intersection->leftParameterDistance, intersection->rightParameterDistance);
 }
 
+/* Bucketed intersection engine. The naive algorithm tests every element of one path against every element of the
+   other - O(n*m) curve/curve solves - which dominates boolean operations on paths with many elements. Instead we
+   snapshot both paths once, bin the second path's element bounding boxes into a uniform grid, and only run the
+   expensive pair solves for elements whose (slightly expanded) boxes share a grid cell. The per-element tests are
+   independent, so they are spread across cores with dispatch_apply when there is enough work to cover the cost. */
+
+struct elementSnapshot {
+	NSBezierPathElement what;
+	NSInteger elt; // index of this element in the source path
+	NSPoint coefficients[4];
+	NSRect bounds;
+};
+
+struct elementPairHit {
+	struct intersectionInfo info;
+	NSInteger otherElt;
+};
+
+// margin added to every bounding box so that grazing/tangent contacts are not pruned by the cell test
+
+#define BUCKET_GRAZING_MARGIN 1.0e-3
+
+// walks every drawable segment of a path once, storing its parameterization and a conservative bounding box
+
+static struct elementSnapshot* snapshotPathElements(NSBezierPath* path, NSUInteger* outCount)
+{
+	subpathWalkingState iter;
+	NSUInteger count = 0, capacity = MAX((NSUInteger)[path elementCount], (NSUInteger)1);
+	struct elementSnapshot* records;
+
+	*outCount = 0;
+
+	if (!initializeSubpathWalkingState(&iter, path, 0, NO))
+		return NULL;
+
+	records = malloc(sizeof(*records) * capacity);
+
+	while (nextSubpathElement(&iter)) {
+		struct elementSnapshot* r;
+
+		if (count >= capacity)
+			records = realloc(records, sizeof(*records) * (capacity += (capacity >> 1) + 1));
+
+		r = &records[count++];
+		r->what = iter.what;
+		r->elt = iter.currentElt;
+		parameterizeSubpathElement(&iter, r->coefficients);
+
+		if (iter.what == NSCurveToBezierPathElement)
+			r->bounds = _parameterizedCurveBounds(r->coefficients);
+		else {
+			r->bounds.origin.x = MIN(iter.points[0].x, iter.points[1].x);
+			r->bounds.origin.y = MIN(iter.points[0].y, iter.points[1].y);
+			r->bounds.size.width = fabs(iter.points[1].x - iter.points[0].x);
+			r->bounds.size.height = fabs(iter.points[1].y - iter.points[0].y);
+		}
+
+		r->bounds = NSInsetRect(r->bounds, -BUCKET_GRAZING_MARGIN, -BUCKET_GRAZING_MARGIN);
+	}
+
+	*outCount = count;
+	return records;
+}
+
+// runs the appropriate pair solver for two snapshotted elements, with <a> taking the "left" role
+
+static NSUInteger intersectElementPair(const struct elementSnapshot* a, const struct elementSnapshot* b, struct intersectionInfo* results)
+{
+	NSInteger found, i;
+
+	if (a->what == NSCurveToBezierPathElement) {
+		if (b->what == NSCurveToBezierPathElement)
+			found = intersectionsBetweenCurveAndCurve(a->coefficients, b->coefficients, results);
+		else
+			found = intersectionsBetweenCurveAndLine(a->coefficients, b->coefficients, results);
+	} else {
+		if (b->what == NSCurveToBezierPathElement) {
+			found = intersectionsBetweenCurveAndLine(b->coefficients, a->coefficients, results);
+			for (i = 0; i < found; i++)
+				reverseSenseOfIntersection(&(results[i]));
+		} else
+			found = intersectionsBetweenLineAndLine(a->coefficients, b->coefficients, results);
+	}
+
+	return (found > 0) ? (NSUInteger)found : 0;
+}
+
+// maps a bounding box to the inclusive range of grid cells it covers
+
+static inline void gridCellRange(NSRect box, NSRect gridBounds, CGFloat cellW, CGFloat cellH, NSUInteger gridDim,
+	NSUInteger* cx0, NSUInteger* cx1, NSUInteger* cy0, NSUInteger* cy1)
+{
+	NSInteger x0 = (NSInteger)floor((NSMinX(box) - NSMinX(gridBounds)) / cellW);
+	NSInteger x1 = (NSInteger)floor((NSMaxX(box) - NSMinX(gridBounds)) / cellW);
+	NSInteger y0 = (NSInteger)floor((NSMinY(box) - NSMinY(gridBounds)) / cellH);
+	NSInteger y1 = (NSInteger)floor((NSMaxY(box) - NSMinY(gridBounds)) / cellH);
+
+	*cx0 = (NSUInteger)MIN(MAX(x0, 0), (NSInteger)gridDim - 1);
+	*cx1 = (NSUInteger)MIN(MAX(x1, 0), (NSInteger)gridDim - 1);
+	*cy0 = (NSUInteger)MIN(MAX(y0, 0), (NSInteger)gridDim - 1);
+	*cy1 = (NSUInteger)MIN(MAX(y1, 0), (NSInteger)gridDim - 1);
+}
+
+static int compareElementIndex(const void* a_, const void* b_)
+{
+	NSUInteger a = *(const NSUInteger*)a_, b = *(const NSUInteger*)b_;
+	return (a < b) ? -1 : ((a > b) ? 1 : 0);
+}
+
 #if 0
 static BOOL subsequent(struct OABezierPathIntersectionHalf *one, struct OABezierPathIntersectionHalf *another) {
     if (one->segment == another->segment) {
@@ -400,6 +699,187 @@ static BOOL subsequent(struct OABezierPathIntersectionHalf *one, struct OABezier
 }
 #endif
 
+- (struct OABezierPathIntersectionList)bucketedIntersectionsWithPath:(NSBezierPath*)other
+{
+	NSUInteger selfCount = 0, otherCount = 0;
+	struct elementSnapshot* selfElts = snapshotPathElements(self, &selfCount);
+	struct elementSnapshot* otherElts = snapshotPathElements(other, &otherCount);
+	NSUInteger i, j;
+
+	if (selfCount == 0 || otherCount == 0) {
+		if (selfElts)
+			free(selfElts);
+		if (otherElts)
+			free(otherElts);
+		return (struct OABezierPathIntersectionList){ 0, NULL };
+	}
+
+	// bin the other path's elements into a uniform grid over its overall bounds. Elements spanning several
+	// cells appear in each; a per-query stamp removes the duplicates. The cell lists are laid out as one
+	// contiguous item array indexed by per-cell start offsets, filled in two passes.
+
+	NSRect gridBounds = otherElts[0].bounds;
+
+	for (j = 1; j < otherCount; ++j)
+		gridBounds = NSUnionRect(gridBounds, otherElts[j].bounds);
+
+	NSUInteger gridDim = (NSUInteger)ceil(sqrt((double)otherCount));
+
+	if (gridDim < 1)
+		gridDim = 1;
+	if (gridDim > 64)
+		gridDim = 64;
+
+	CGFloat cellW = MAX(gridBounds.size.width / gridDim, 1.0e-6);
+	CGFloat cellH = MAX(gridBounds.size.height / gridDim, 1.0e-6);
+	NSUInteger cellCount = gridDim * gridDim;
+	NSUInteger* cellStart = calloc(cellCount + 1, sizeof(NSUInteger));
+	NSUInteger cx0, cx1, cy0, cy1, cx, cy;
+
+	for (j = 0; j < otherCount; ++j) {
+		gridCellRange(otherElts[j].bounds, gridBounds, cellW, cellH, gridDim, &cx0, &cx1, &cy0, &cy1);
+		for (cy = cy0; cy <= cy1; ++cy)
+			for (cx = cx0; cx <= cx1; ++cx)
+				cellStart[cy * gridDim + cx + 1]++;
+	}
+
+	for (i = 1; i <= cellCount; ++i)
+		cellStart[i] += cellStart[i - 1];
+
+	NSUInteger* cellItems = malloc(MAX(cellStart[cellCount], (NSUInteger)1) * sizeof(NSUInteger));
+	NSUInteger* cellFill = malloc((cellCount + 1) * sizeof(NSUInteger));
+
+	memcpy(cellFill, cellStart, (cellCount + 1) * sizeof(NSUInteger));
+
+	for (j = 0; j < otherCount; ++j) {
+		gridCellRange(otherElts[j].bounds, gridBounds, cellW, cellH, gridDim, &cx0, &cx1, &cy0, &cy1);
+		for (cy = cy0; cy <= cy1; ++cy)
+			for (cx = cx0; cx <= cx1; ++cx)
+				cellItems[cellFill[cy * gridDim + cx]++] = j;
+	}
+
+	// test each of the receiver's elements against the candidates sharing its cells. Every index writes only
+	// its own slot of <hits>/<hitCounts>, so the work can be fanned out across cores when it is big enough to
+	// be worth the dispatch overhead.
+
+	struct elementPairHit** hits = calloc(selfCount, sizeof(struct elementPairHit*));
+	NSUInteger* hitCounts = calloc(selfCount, sizeof(NSUInteger));
+
+	void (^testOneElement)(size_t) = ^(size_t selfIndex) {
+		const struct elementSnapshot* a = &selfElts[selfIndex];
+
+		if (!NSIntersectsRect(a->bounds, gridBounds))
+			return;
+
+		NSUInteger* candidates = malloc(otherCount * sizeof(NSUInteger));
+		unsigned char* seen = calloc(otherCount, 1);
+		NSUInteger candidateCount = 0;
+		NSUInteger qx0, qx1, qy0, qy1, qx, qy, c;
+
+		gridCellRange(a->bounds, gridBounds, cellW, cellH, gridDim, &qx0, &qx1, &qy0, &qy1);
+
+		for (qy = qy0; qy <= qy1; ++qy) {
+			for (qx = qx0; qx <= qx1; ++qx) {
+				NSUInteger cell = qy * gridDim + qx;
+
+				for (c = cellStart[cell]; c < cellStart[cell + 1]; ++c) {
+					NSUInteger candidate = cellItems[c];
+
+					if (!seen[candidate] && NSIntersectsRect(a->bounds, otherElts[candidate].bounds)) {
+						seen[candidate] = 1;
+						candidates[candidateCount++] = candidate;
+					}
+				}
+			}
+		}
+
+		// candidates must be solved in ascending element order so the merged result matches the
+		// order the exhaustive walk would have produced
+
+		qsort(candidates, candidateCount, sizeof(NSUInteger), compareElementIndex);
+
+		struct elementPairHit* found = NULL;
+		NSUInteger foundCount = 0, foundCapacity = 0;
+
+		for (c = 0; c < candidateCount; ++c) {
+			const struct elementSnapshot* b = &otherElts[candidates[c]];
+			struct intersectionInfo segmentIntersections[MAX_INTERSECTIONS_PER_ELT_PAIR];
+			NSUInteger pairFound = intersectElementPair(a, b, segmentIntersections), pf;
+
+			if (pairFound + foundCount > foundCapacity) {
+				foundCapacity = MAX(foundCapacity * 2, foundCount + pairFound);
+				found = realloc(found, foundCapacity * sizeof(*found));
+			}
+
+			for (pf = 0; pf < pairFound; ++pf) {
+				found[foundCount].info = segmentIntersections[pf];
+				found[foundCount].otherElt = b->elt;
+				foundCount++;
+			}
+		}
+
+		hits[selfIndex] = found;
+		hitCounts[selfIndex] = foundCount;
+
+		free(candidates);
+		free(seen);
+	};
+
+	if (selfCount > 1 && (selfCount * otherCount) >= 1024)
+		dispatch_apply(selfCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), testOneElement);
+	else {
+		for (i = 0; i < selfCount; ++i)
+			testOneElement(i);
+	}
+
+	// merge the per-element results in element order, using the same sorted insertion the exhaustive walk uses
+
+	NSUInteger intersectionCount = 0;
+	NSUInteger listSize = 16;
+	OABezierPathIntersection* intersections = malloc(sizeof(*intersections) * listSize);
+
+	for (i = 0; i < selfCount; ++i) {
+		NSUInteger h;
+
+		for (h = 0; h < hitCounts[i]; ++h) {
+			const struct elementPairHit* ph = &hits[i][h];
+			double t;
+
+			if (intersectionCount + 1 > listSize)
+				intersections = realloc(intersections, sizeof(*intersections) * (listSize += (listSize >> 1)));
+
+			NSUInteger insertionPoint = intersectionCount;
+
+			while (insertionPoint > 0 && intersections[insertionPoint - 1].left.parameter > ph->info.leftParameter && intersections[insertionPoint - 1].left.segment >= selfElts[i].elt)
+				insertionPoint--;
+
+			if (insertionPoint < intersectionCount)
+				memmove(&(intersections[insertionPoint + 1]), &(intersections[insertionPoint]), sizeof(*intersections) * (intersectionCount - insertionPoint));
+
+			copyIntersection(&(intersections[insertionPoint]), &ph->info, selfElts[i].elt, ph->otherElt);
+
+			t = ph->info.leftParameter;
+			intersections[insertionPoint].location.x = ((selfElts[i].coefficients[3].x * t + selfElts[i].coefficients[2].x) * t + selfElts[i].coefficients[1].x) * t + selfElts[i].coefficients[0].x;
+			intersections[insertionPoint].location.y = ((selfElts[i].coefficients[3].y * t + selfElts[i].coefficients[2].y) * t + selfElts[i].coefficients[1].y) * t + selfElts[i].coefficients[0].y;
+
+			intersectionCount++;
+		}
+
+		if (hits[i])
+			free(hits[i]);
+	}
+
+	free(hits);
+	free(hitCounts);
+	free(cellStart);
+	free(cellItems);
+	free(cellFill);
+	free(selfElts);
+	free(otherElts);
+
+	return (struct OABezierPathIntersectionList){ intersectionCount, intersections };
+}
+
 - (struct OABezierPathIntersectionList)allIntersectionsWithPath:(NSBezierPath*)other
 {
 	NSUInteger intersectionCount = 0;
@@ -407,6 +887,12 @@ static BOOL subsequent(struct OABezierPathIntersectionHalf *one, struct OABezier
 	OABezierPathIntersection* intersections;
 	subpathWalkingState selfIter;
 
+	// the two-path case has no dependence on walk adjacency, so it can use the bucketed engine. Finding a
+	// path's self-intersections relies on neighbouring-segment bookkeeping and stays on the exhaustive walk.
+
+	if (self != other)
+		return [self bucketedIntersectionsWithPath:other];
+
 	if (!initializeSubpathWalkingState(&selfIter, self, 0, NO))
 		return (struct OABezierPathIntersectionList){ 0, NULL };
 
@@ -3295,75 +3781,44 @@ static BOOL _curvedLineIntersectsRect(const NSPoint* c, NSRect rect, CGFloat tol
 
 - (NSInteger)_segmentHitByPoint:(NSPoint)point position:(CGFloat*)position padding:(CGFloat)padding
 {
-	NSInteger count = [self elementCount];
-	NSInteger i;
-	NSPoint points[3];
-	NSPoint startPoint;
-	NSPoint currentPoint;
-	NSInteger element;
-	BOOL needANewStartPoint;
+	DKPathSegmentIndex* index = [self _segmentIndex];
+	NSUInteger c, candidateCount;
 
-	if (count == 0)
+	if (index->mCount == 0)
 		return 0;
 
-	element = [self elementAtIndex:0 associatedPoints:points];
-	if (element != NSMoveToBezierPathElement) {
-		return 0; // must start with a moveTo
-	}
+	// segments further than <padding> from the point can't be hit, so only the segments whose bounds touch
+	// this query box are tested. Candidates come back in element order, so the first hit matches the one the
+	// full walk would have returned.
 
-	startPoint = currentPoint = points[0];
-	needANewStartPoint = NO;
+	NSRect query = NSMakeRect(point.x - padding - 1, point.y - padding - 1, 2 * (padding + 1), 2 * (padding + 1));
+	NSUInteger* candidates = malloc(index->mCount * sizeof(NSUInteger));
 
-	for (i = 1; i < count; ++i) {
-		element = [self elementAtIndex:i associatedPoints:points];
-		/*
-        if (NSEqualPoints(points[0], point)) {
-            if (i==0) {
-                i = 1;
-            }
-            return i;
-        }
-        */
-		switch (element) {
-		case NSMoveToBezierPathElement:
-			currentPoint = points[0];
-			if (needANewStartPoint) {
-				startPoint = currentPoint;
-				needANewStartPoint = NO;
-			}
-			break;
-		case NSClosePathBezierPathElement:
-			if ([self _straightLineHit:currentPoint:startPoint:point:position padding:padding]) {
-				return i;
-			}
-			currentPoint = startPoint;
-			needANewStartPoint = YES;
-			break;
-		case NSLineToBezierPathElement:
-			if ([self _straightLineHit:currentPoint:points[0]:point:position padding:padding]) {
-				return i;
-			}
-			currentPoint = points[0];
-			break;
-		case NSCurveToBezierPathElement: {
+	candidateCount = [index getCandidates:candidates
+								  forRect:query];
+
+	for (c = 0; c < candidateCount; ++c) {
+		const struct pathSegmentRecord* r = &index->mSegments[candidates[c]];
+
+		if (r->what == NSCurveToBezierPathElement) {
 			// GPC: reject point if not in segment bounds - without this a bug in the _curvedLineHit method will prevent
 			// proper calculation of the position.
 
-			NSRect cbr = _boundsOfCurveSegment(currentPoint, points[2], points[0], points[1]);
-
-			if (NSPointInRect(point, NSInsetRect(cbr, -1, -1))) {
-				if ([self _curvedLineHit:point startPoint:currentPoint endPoint:points[2] controlPoint1:points[0] controlPoint2:points[1] position:position padding:padding]) {
-					//NSLog(@"curve segemnt hit: %d, position: %f", i, *position );
-					return i;
+			if (NSPointInRect(point, NSInsetRect(r->bounds, -1, -1))) {
+				if ([self _curvedLineHit:point startPoint:r->pts[0] endPoint:r->pts[3] controlPoint1:r->pts[1] controlPoint2:r->pts[2] position:position padding:padding]) {
+					free(candidates);
+					return r->elt;
 				}
 			}
-			currentPoint = points[2];
-		} break;
-
-		default:
-			break;
+		} else {
+			if ([self _straightLineHit:r->pts[0]:r->pts[1]:point:position padding:padding]) {
+				free(candidates);
+				return r->elt;
+			}
 		}
 	}
+
+	free(candidates);
 	return 0;
 }
 
@@ -23,6 +23,12 @@ Unit Test for the BSP storage sub-system. This works by populating a storage ins
 - (void)testBSPStorage;
 - (void)testIndexedBSPStorage;
 
+/** unit test for the spatial index archive. Verifies that an archived index can be adopted back into the
+ storage and answers queries identically, and that the checksum rejects an archive that no longer matches
+ the stored objects.
+ */
+- (void)testSpatialIndexArchiving;
+
 - (void)populateStorage:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize;
 - (void)deletionTest:(id<DKObjectStorage>)storage;
 - (void)insertionTest:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize;
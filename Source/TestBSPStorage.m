@@ -236,6 +236,49 @@ static NSUInteger randomUnsigned(NSUInteger minVal, NSUInteger maxVal)
 	NSLog(@"testIndexedBSPStorage complete.");
 }
 
+- (void)testSpatialIndexArchiving
+{
+	NSLog(@"starting 'testSpatialIndexArchiving'...");
+
+	srandomdev();
+
+	NSSize canvasSize = NSMakeSize(2000, 2000);
+
+	DKBSPObjectStorage* testStorage = [[DKBSPObjectStorage alloc] init];
+
+	[testStorage setCanvasSize:canvasSize];
+	[self populateStorage:testStorage
+			   canvasSize:canvasSize];
+
+	NSData* indexData = [testStorage archivedSpatialIndexData];
+
+	XCTAssertNotNil(indexData, @"failed to archive the spatial index");
+
+	// adopting the archive replaces the live tree with one rebuilt from the archived leaf buffers.
+	// It should validate against the unchanged objects and answer queries identically.
+
+	XCTAssertTrue([testStorage adoptSpatialIndexData:indexData], @"adoption of a valid index archive failed");
+
+	[self verifyIndexedStorageIntegrity:testStorage];
+	[self retrievalTest:testStorage
+			 canvasSize:canvasSize];
+	[self pointRetrievalTest:testStorage
+				  canvasSize:canvasSize];
+
+	// any change to an object's geometry must invalidate the archive via the checksum
+
+	testStorableObject* tso = [testStorage objectInObjectsAtIndex:0];
+	NSRect movedBounds = [tso bounds];
+
+	movedBounds.origin.x += 50.0;
+	[tso setBounds:movedBounds];
+
+	XCTAssertFalse([testStorage adoptSpatialIndexData:indexData], @"a stale index archive was not rejected");
+
+	[testStorage release];
+	NSLog(@"testSpatialIndexArchiving complete.");
+}
+
 - (void)populateStorage:(id<DKObjectStorage>)storage canvasSize:(NSSize)canvasSize
 {
 	NSUInteger i, m = NUMBER_OF_OBJECTS;
@@ -11,8 +11,16 @@
 
 @interface DKEvaluator : NSObject {
 	NSMutableDictionary* mSymbolTable;
+	NSPointerArray* mSymbolValues; // values indexed by interned symbol index, for O(1) dispatch during evaluation
 }
 
+/** @brief Bind a value to a symbol.
+
+ As well as entering the value in the symbol dictionary, the value is filed under the interned
+ symbol's small-integer index so that evaluation resolves it with a plain array lookup. Bindings
+ should be in place before expressions are evaluated concurrently - evaluation itself only reads
+ the tables.
+ */
 - (void)addValue:(id)value forSymbol:(NSString*)symbol;
 
 - (id)evaluateSymbol:(NSString*)symbol;
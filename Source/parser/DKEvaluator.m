@@ -16,11 +16,38 @@
 {
 	[mSymbolTable setValue:value
 					forKey:symbol];
+
+	// also file the value under the interned symbol's index. Key paths are dictionary-only - the
+	// indexed fast path in -evaluateSymbol: falls through for them.
+
+	if ([symbol rangeOfString:@"."].location == NSNotFound) {
+		NSUInteger ndx = (NSUInteger)[[DKSymbol symbolForString:symbol] index];
+
+		if (ndx >= [mSymbolValues count])
+			[mSymbolValues setCount:ndx + 1];
+
+		[mSymbolValues replacePointerAtIndex:ndx
+								 withPointer:value];
+	}
 }
 
 #pragma mark -
 - (id)evaluateSymbol:(NSString*)symbol
 {
+	// interned symbols resolve by array index without hashing or key-path parsing; anything else
+	// (including dotted key paths) takes the dictionary route below.
+
+	if ([symbol isKindOfClass:[DKSymbol class]]) {
+		NSUInteger ndx = (NSUInteger)[(DKSymbol*)symbol index];
+
+		if (ndx < [mSymbolValues count]) {
+			id value = (id)[mSymbolValues pointerAtIndex:ndx];
+
+			if (value != nil)
+				return value;
+		}
+	}
+
 	id sym = [mSymbolTable valueForKeyPath:symbol];
 	return (sym ? sym : symbol);
 }
@@ -50,20 +77,69 @@
 	if ([expr isLiteralValue])
 		return [self evaluateSimpleExpression:expr];
 
-	id value;
+	// run the expression's compiled form: a flat instruction array executed by a tight opcode
+	// switch over a value stack. This does the same work as recursively walking the tree through
+	// -evaluateObject: but without the per-node recursion, enumerators and class checks, which
+	// matters when expressions are evaluated per object per draw.
 
-	NSEnumerator* curs = [expr objectEnumerator];
-	DKExpression* sexpr = [[DKExpression alloc] init];
-	[sexpr setType:[expr type]];
-	id item;
+	NSUInteger length = 0;
+	NSUInteger depth = 0;
+	const DKExpressionInstruction* program = [expr compiledProgram:&length
+														stackDepth:&depth];
+
+	if (program == NULL || length == 0)
+		return [self evaluateSimpleExpression:expr];
+
+	id stackBuf[32];
+	id* stack = (depth <= 32) ? stackBuf : malloc(depth * sizeof(id));
+	NSUInteger sp = 0;
+	NSUInteger pc;
+	id value = nil;
+
+	for (pc = 0; pc < length; ++pc) {
+		const DKExpressionInstruction* ins = &program[pc];
+
+		switch (ins->opcode) {
+		case kDKExpressionOpPushLiteral:
+			stack[sp++] = ins->operand;
+			break;
+
+		case kDKExpressionOpLoadSymbol:
+			stack[sp++] = [self evaluateSymbol:ins->operand];
+			break;
+
+		case kDKExpressionOpMakePair: {
+			DKExpressionPair* pair = [[DKExpressionPair alloc] initWithKey:ins->operand
+																	 value:stack[sp - 1]];
+			stack[sp - 1] = [pair autorelease];
+			break;
+		}
+
+		case kDKExpressionOpReduce: {
+			DKExpression* sexpr = [[DKExpression alloc] init];
+			[sexpr setType:ins->operand];
+
+			NSUInteger base = sp - (NSUInteger)ins->count;
+			NSUInteger i;
+
+			for (i = base; i < sp; ++i)
+				[sexpr addObject:stack[i]];
+
+			sp = base;
+			stack[sp++] = [[[self evaluateSimpleExpression:sexpr] retain] autorelease];
+			[sexpr release];
+			break;
+		}
+		}
+	}
 
-	while ((item = [curs nextObject]))
-		[sexpr addObject:[self evaluateObject:item]];
+	if (sp > 0)
+		value = stack[sp - 1];
 
-	value = [[self evaluateSimpleExpression:sexpr] retain];
-	[sexpr release];
+	if (stack != stackBuf)
+		free(stack);
 
-	return [value autorelease];
+	return value;
 }
 
 - (id)evaluateSimpleExpression:(DKExpression*)expr
@@ -76,6 +152,7 @@
 - (void)dealloc
 {
 	[mSymbolTable release];
+	[mSymbolValues release];
 
 	[super dealloc];
 }
@@ -85,8 +162,10 @@
 	self = [super init];
 	if (self != nil) {
 		mSymbolTable = [[NSMutableDictionary alloc] init];
+		mSymbolValues = [[NSPointerArray strongObjectsPointerArray] retain];
 
-		if (mSymbolTable == nil) {
+		if (mSymbolTable == nil
+			|| mSymbolValues == nil) {
 			[self autorelease];
 			self = nil;
 		}
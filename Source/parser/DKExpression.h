@@ -7,9 +7,28 @@
 
 #import <Foundation/Foundation.h>
 
-@interface DKExpression : NSObject {
+//! Opcodes for the compiled form of an expression - see -compiledProgram:stackDepth:
+typedef NS_ENUM(NSInteger, DKExpressionOpcode) {
+	kDKExpressionOpPushLiteral = 0, //!< push the operand object unchanged
+	kDKExpressionOpLoadSymbol = 1, //!< push the evaluator's binding for the operand symbol
+	kDKExpressionOpMakePair = 2, //!< pop a value, push a pair of it keyed by the operand
+	kDKExpressionOpReduce = 3 //!< pop \c count values into an expression of type \c operand, apply it, push the result
+};
+
+//! One instruction of a compiled expression. Operands are retained by the owning expression's program.
+typedef struct DKExpressionInstruction {
+	DKExpressionOpcode opcode;
+	NSInteger count; //!< for kDKExpressionOpReduce, the number of values to pop
+	id operand;
+} DKExpressionInstruction;
+
+//! Expressions archive their type and contents, so a parse tree can be cached and reloaded without reparsing the source.
+@interface DKExpression : NSObject <NSCoding> {
 	NSString* mType;
 	NSMutableArray* mValues;
+	DKExpressionInstruction* mProgram; // flat compiled form of the tree, built lazily
+	NSUInteger mProgramLength;
+	NSUInteger mProgramStackDepth; // maximum value-stack depth the program requires
 }
 
 - (void)setType:(NSString*)aType;
@@ -41,9 +60,23 @@
 - (NSEnumerator*)keyEnumerator;
 - (NSEnumerator*)objectEnumerator;
 
+/** @brief The expression compiled to a flat instruction array, building it on first request.
+
+ The compiled form is a post-order linearisation of the tree: evaluating it needs only a tight
+ opcode switch and a value stack rather than recursive descent with per-node class checks and
+ enumerators, which matters when styles evaluate expressions per object per draw. The program is
+ cached until this node is mutated; nested expressions are flattened into their parent's program,
+ so trees must not be restructured between evaluations (in practice they never are once parsed).
+ Returns the instructions and their count, plus the maximum value-stack depth evaluation requires.
+ */
+- (const DKExpressionInstruction*)compiledProgram:(NSUInteger*)outLength stackDepth:(NSUInteger*)outDepth;
+
+/** @brief Discards the compiled program. Called automatically when the expression is mutated. */
+- (void)invalidateCompiledProgram;
+
 @end
 
-@interface DKExpressionPair : NSObject {
+@interface DKExpressionPair : NSObject <NSCoding> {
 	NSString* key;
 	id value;
 }
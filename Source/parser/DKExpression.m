@@ -6,7 +6,70 @@
 */
 
 #import "DKExpression.h"
+#import "DKSymbol.h"
 
+#pragma mark Static Functions
+
+typedef struct {
+	DKExpressionInstruction* ins;
+	NSUInteger length;
+	NSUInteger capacity;
+	NSUInteger depth; // simulated stack depth at this point in the program
+	NSUInteger maxDepth;
+} DKExpressionProgramBuilder;
+
+static void DKExpressionEmit(DKExpressionProgramBuilder* b, DKExpressionOpcode opcode, NSInteger count, id operand)
+{
+	if (b->length == b->capacity) {
+		b->capacity = (b->capacity == 0) ? 16 : b->capacity * 2;
+		b->ins = realloc(b->ins, b->capacity * sizeof(DKExpressionInstruction));
+	}
+
+	b->ins[b->length].opcode = opcode;
+	b->ins[b->length].count = count;
+	b->ins[b->length].operand = [operand retain];
+	++b->length;
+
+	// track the stack depth the program will need. MakePair replaces the top of stack, Reduce
+	// pops <count> and pushes one, everything else pushes one.
+
+	if (opcode == kDKExpressionOpReduce)
+		b->depth -= (count - 1);
+	else if (opcode != kDKExpressionOpMakePair)
+		++b->depth;
+
+	if (b->depth > b->maxDepth)
+		b->maxDepth = b->depth;
+}
+
+static void DKExpressionCompileObject(id obj, DKExpressionProgramBuilder* b)
+{
+	// mirrors the dispatch order of -[DKEvaluator evaluateObject:], so the compiled program
+	// evaluates exactly as the recursive walk would
+
+	if ([obj isLiteralValue])
+		DKExpressionEmit(b, kDKExpressionOpPushLiteral, 0, obj);
+	else if ([obj isKindOfClass:[DKSymbol class]])
+		DKExpressionEmit(b, kDKExpressionOpLoadSymbol, 0, obj);
+	else if ([obj isKindOfClass:[DKExpression class]]) {
+		NSEnumerator* curs = [(DKExpression*)obj objectEnumerator];
+		id item;
+		NSInteger count = 0;
+
+		while ((item = [curs nextObject])) {
+			DKExpressionCompileObject(item, b);
+			++count;
+		}
+
+		DKExpressionEmit(b, kDKExpressionOpReduce, count, [(DKExpression*)obj type]);
+	} else if ([obj isKindOfClass:[DKExpressionPair class]]) {
+		DKExpressionCompileObject([(DKExpressionPair*)obj value], b);
+		DKExpressionEmit(b, kDKExpressionOpMakePair, 0, [(DKExpressionPair*)obj key]);
+	} else
+		DKExpressionEmit(b, kDKExpressionOpPushLiteral, 0, obj);
+}
+
+#pragma mark -
 @implementation DKExpression
 #pragma mark As a DKExpression
 - (void)setType:(NSString*)aType
@@ -14,6 +77,8 @@
 	[aType retain];
 	[mType release];
 	mType = aType;
+
+	[self invalidateCompiledProgram];
 }
 
 - (NSString*)type
@@ -101,12 +166,16 @@
 {
 	[mValues replaceObjectAtIndex:ndx
 					   withObject:obj];
+
+	[self invalidateCompiledProgram];
 }
 
 #pragma mark -
 - (void)addObject:(id)aValue
 {
 	[mValues addObject:aValue];
+
+	[self invalidateCompiledProgram];
 }
 
 - (void)addObject:(id)aValue forKey:(NSString*)key
@@ -116,6 +185,8 @@
 
 	[mValues addObject:pair];
 	[pair release];
+
+	[self invalidateCompiledProgram];
 }
 
 #pragma mark -
@@ -165,10 +236,54 @@
 	return [mValues objectEnumerator];
 }
 
+#pragma mark -
+- (const DKExpressionInstruction*)compiledProgram:(NSUInteger*)outLength stackDepth:(NSUInteger*)outDepth
+{
+	if (mProgram == NULL) {
+		DKExpressionProgramBuilder b = { NULL, 0, 0, 0, 0 };
+
+		NSEnumerator* curs = [mValues objectEnumerator];
+		id item;
+
+		while ((item = [curs nextObject]))
+			DKExpressionCompileObject(item, &b);
+
+		DKExpressionEmit(&b, kDKExpressionOpReduce, [mValues count], mType);
+
+		mProgram = b.ins;
+		mProgramLength = b.length;
+		mProgramStackDepth = b.maxDepth;
+	}
+
+	if (outLength != NULL)
+		*outLength = mProgramLength;
+
+	if (outDepth != NULL)
+		*outDepth = mProgramStackDepth;
+
+	return mProgram;
+}
+
+- (void)invalidateCompiledProgram
+{
+	if (mProgram != NULL) {
+		NSUInteger i;
+
+		for (i = 0; i < mProgramLength; ++i)
+			[mProgram[i].operand release];
+
+		free(mProgram);
+		mProgram = NULL;
+		mProgramLength = 0;
+		mProgramStackDepth = 0;
+	}
+}
+
 #pragma mark -
 #pragma mark As an NSObject
 - (void)dealloc
 {
+	[self invalidateCompiledProgram];
 	[mValues release];
 	[mType release];
 
@@ -223,6 +338,32 @@
 	return self;
 }
 
+#pragma mark -
+#pragma mark As part of NSCoding Protocol
+- (void)encodeWithCoder:(NSCoder*)coder
+{
+	[coder encodeObject:mType
+				 forKey:@"DKExpression_type"];
+	[coder encodeObject:mValues
+				 forKey:@"DKExpression_values"];
+}
+
+- (id)initWithCoder:(NSCoder*)coder
+{
+	self = [super init];
+	if (self != nil) {
+		mType = [[coder decodeObjectForKey:@"DKExpression_type"] retain];
+		mValues = [[coder decodeObjectForKey:@"DKExpression_values"] mutableCopy];
+
+		if (mType == nil
+			|| mValues == nil) {
+			[self autorelease];
+			self = nil;
+		}
+	}
+	return self;
+}
+
 @end
 
 #pragma mark -
@@ -273,6 +414,26 @@
 	return [NSString stringWithFormat:@"%@: %@", key, value];
 }
 
+#pragma mark -
+#pragma mark As part of NSCoding Protocol
+- (void)encodeWithCoder:(NSCoder*)coder
+{
+	[coder encodeObject:key
+				 forKey:@"DKExpressionPair_key"];
+	[coder encodeObject:value
+				 forKey:@"DKExpressionPair_value"];
+}
+
+- (id)initWithCoder:(NSCoder*)coder
+{
+	self = [super init];
+	if (self != nil) {
+		key = [[coder decodeObjectForKey:@"DKExpressionPair_key"] retain];
+		value = [[coder decodeObjectForKey:@"DKExpressionPair_value"] retain];
+	}
+	return self;
+}
+
 @end
 
 #pragma mark -
@@ -7,8 +7,12 @@
 
 #import "DKSymbol.h"
 
+#import <pthread.h>
+
 #pragma mark Static Vars
-static NSMutableDictionary* sSymbolMap;
+static NSMutableDictionary* sSymbolMap; // master map, only touched while holding sSymbolLock
+static NSDictionary* sSymbolSnapshot; // immutable copy of the master map, read without locking
+static pthread_mutex_t sSymbolLock = PTHREAD_MUTEX_INITIALIZER;
 static NSInteger sSymCounter = 0;
 
 #pragma mark -
@@ -24,7 +28,17 @@ static NSInteger sSymCounter = 0;
 
 + (DKSymbol*)symbolForString:(NSString*)str
 {
-	DKSymbol* sym = [[DKSymbol symbolMap] valueForKey:str];
+	// fast path - a previously interned symbol is found in the immutable snapshot without taking
+	// the lock, so concurrent lookups never serialize against each other.
+
+	DKSymbol* sym = [sSymbolSnapshot objectForKey:str];
+
+	if (sym != nil)
+		return sym;
+
+	pthread_mutex_lock(&sSymbolLock);
+
+	sym = [[DKSymbol symbolMap] valueForKey:str];
 
 	if (sym == nil) {
 		sym = [[DKSymbol alloc] initWithString:str
@@ -32,8 +46,16 @@ static NSInteger sSymCounter = 0;
 		[[DKSymbol symbolMap] setValue:sym
 								forKey:[sym string]];
 		[sym release];
+
+		// publish a fresh snapshot for the lock-free readers. The table is grow-only and symbol
+		// counts are small, so superseded snapshots are deliberately left alive rather than being
+		// released out from under a reader part-way through a lookup.
+
+		sSymbolSnapshot = [sSymbolMap copy];
 	}
 
+	pthread_mutex_unlock(&sSymbolLock);
+
 	return sym;
 }
 
@@ -140,4 +162,30 @@ static NSInteger sSymCounter = 0;
 	return [self retain];
 }
 
+#pragma mark -
+#pragma mark As part of NSCoding Protocol
+
+// symbols archive only their string - decoding funnels through +symbolForString: so that the interned
+// instance in the symbol map is returned, preserving identity comparisons after a cached parse tree is reloaded.
+
+- (Class)classForCoder
+{
+	return [DKSymbol class];
+}
+
+- (void)encodeWithCoder:(NSCoder*)coder
+{
+	[coder encodeObject:mString
+				 forKey:@"DKSymbol_string"];
+}
+
+- (id)initWithCoder:(NSCoder*)coder
+{
+	NSString* str = [coder decodeObjectForKey:@"DKSymbol_string"];
+	DKSymbol* sym = [[DKSymbol symbolForString:str] retain];
+
+	[self release];
+	return sym;
+}
+
 @end
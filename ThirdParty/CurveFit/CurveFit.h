@@ -27,6 +27,13 @@ extern "C" {
  */
 extern NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon);
 
+/** As DKCurveFitPath(), but takes the samples as a raw C array of points instead of a flattened
+ NSBezierPath, so callers that already hold contiguous point data (including the Swift overlay)
+ can fit it without building an intermediate path or boxing each point. Fewer than three points
+ are returned as a straight polyline.
+ */
+extern NSBezierPath* DKCurveFitPoints(const NSPoint* points, NSUInteger count, CGFloat epsilon) NS_REFINED_FOR_SWIFT;
+
 /** This curve fits a flattened path, but is much smarter about which parts of the path to curve fit and which to leave alone. It
  also properly deals with separate subpaths within the original path (holes).
 
@@ -39,6 +46,51 @@ extern NSBezierPath* DKSmartCurveFitPath(NSBezierPath* inPath, CGFloat epsilon,
 }
 #endif
 
+/** This maintains the state of an ongoing freehand curve fit so that a stroke can be fitted incrementally as
+ points are sampled, instead of refitting the entire accumulated point list on every new sample (which makes the
+ cost of a long stroke quadratic in its length).
+
+ Points are buffered into a trailing window. Once the window fills, the leading portion of it is fitted and the
+ resulting segments are committed to the output path; only the unfitted tail is ever refitted after that, so the
+ cost of adding a sample is bounded by the window size regardless of how long the stroke becomes. The tangent at
+ each commit boundary is estimated from the samples and carried over to the next fit, preserving smoothness
+ across commits in the same way that the fitter's own recursive splitting does.
+ */
+@interface DKIncrementalCurveFitter : NSObject {
+@private
+	NSBezierPath* mCommittedPath; // stable leading segments, never refitted
+	NSPoint* mPendingPoints; // trailing window of raw samples awaiting fitting
+	NSUInteger mPendingCount;
+	NSUInteger mPendingCapacity;
+	NSPoint mStartTangent; // forward tangent at the start of the pending window, NSZeroPoint = unconstrained
+	CGFloat mEpsilon;
+}
+
+/** Designated initializer. \c startPoint is the first sample of the stroke; \c epsilon is the same fitting
+ tolerance passed to DKCurveFitPath().
+ */
+- (instancetype)initWithStartPoint:(NSPoint)startPoint epsilon:(CGFloat)epsilon;
+
+/** Appends a sample to the stroke. Adjacent duplicate points are ignored. This may commit further leading
+ segments internally, but performs at most one fit over the (bounded) pending window.
+ */
+- (void)addPoint:(NSPoint)p;
+
+/** Appends a contiguous run of samples; equivalent to adding each point in turn with
+ <code>-addPoint:</code>, including the deduplication and incremental commits.
+ */
+- (void)addPoints:(const NSPoint*)points count:(NSUInteger)count NS_REFINED_FOR_SWIFT;
+
+/** The fitted path so far - the committed segments plus a fit of the pending tail. Suitable for live display
+ while the stroke is still being drawn; the leading segments are stable between calls.
+ */
+@property (readonly, copy) NSBezierPath* fittedPath;
+
+/** The fitting tolerance, as passed to the initializer. */
+@property (readonly) CGFloat epsilon;
+
+@end
+
 // curve fit vector path using poTrace smoothing algorithm:
 
 #ifndef SIGN
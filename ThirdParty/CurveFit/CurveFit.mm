@@ -16,33 +16,247 @@
 
 
 
+// sizing of the incremental fitter's sample window. Once kDKIncrementalFitWindowSize samples have accumulated,
+// the leading kDKIncrementalFitCommitSamples of them are fitted and committed, and the boundary sample is retained
+// as the start of the next window. Larger windows give the fitter more context at higher per-sample cost.
+
+static const NSUInteger kDKIncrementalFitWindowSize = 128;
+static const NSUInteger kDKIncrementalFitCommitSamples = 96;
+static const unsigned kDKIncrementalFitMaxSegments = 64;
+
+
+@interface DKIncrementalCurveFitter ()
+
+- (void)commitLeadingSegments;
+
+@end
+
+
+/// fits <data> with bezier_fit_cubic_full and appends the resulting curve segments to <path>, which must already be
+/// positioned at data[0]. The tangent arguments follow the fitter's conventions - tHat1 points forward from the first
+/// sample, tHat2 points backward from the last, and a zero tangent is unconstrained. If fitting fails outright the
+/// samples are appended as line segments so that no input is ever lost.
+
+static void appendFittedGeomPoints(NSBezierPath* path, Geom::Point const* data, NSInteger len, Geom::Point const& tHat1, Geom::Point const& tHat2, CGFloat epsilon)
+{
+	if ( len < 2 )
+		return;
+
+	Geom::Point*	segBuffer;
+	NSInteger		segments, i;
+
+	segBuffer = (Geom::Point*) malloc( sizeof( Geom::Point ) * kDKIncrementalFitMaxSegments * 4 );
+	segments = Geom::bezier_fit_cubic_full( segBuffer, NULL, data, (int)len, tHat1, tHat2, epsilon, kDKIncrementalFitMaxSegments );
+
+	if ( segments > 0 )
+	{
+		NSPoint temp[3];
+		NSInteger segElement;
+
+		for( i = 0; i < segments; ++i )
+		{
+			segElement = ( i * 4 ) + 1;
+
+			temp[0].x = segBuffer[segElement][Geom::X];
+			temp[0].y = segBuffer[segElement++][Geom::Y];
+			temp[1].x = segBuffer[segElement][Geom::X];
+			temp[1].y = segBuffer[segElement++][Geom::Y];
+			temp[2].x = segBuffer[segElement][Geom::X];
+			temp[2].y = segBuffer[segElement][Geom::Y];
+
+			[path curveToPoint:temp[2] controlPoint1:temp[0] controlPoint2:temp[1]];
+		}
+	}
+	else
+	{
+		for( i = 1; i < len; ++i )
+			[path lineToPoint:NSMakePoint( data[i][Geom::X], data[i][Geom::Y] )];
+	}
+
+	free( segBuffer );
+}
+
+
+@implementation DKIncrementalCurveFitter
+
+@synthesize epsilon = mEpsilon;
+
+- (instancetype)initWithStartPoint:(NSPoint)startPoint epsilon:(CGFloat)epsilon
+{
+	self = [super init];
+	if (self != nil)
+	{
+		mEpsilon = epsilon;
+		mCommittedPath = [NSBezierPath bezierPath];
+		[mCommittedPath moveToPoint:startPoint];
+
+		mPendingCapacity = kDKIncrementalFitWindowSize;
+		mPendingPoints = (NSPoint*) malloc( sizeof( NSPoint ) * mPendingCapacity );
+		mPendingPoints[0] = startPoint;
+		mPendingCount = 1;
+		mStartTangent = NSZeroPoint;
+	}
+
+	return self;
+}
+
+- (instancetype)init
+{
+	return [self initWithStartPoint:NSZeroPoint epsilon:1.0];
+}
+
+- (void)dealloc
+{
+	free( mPendingPoints );
+}
+
+- (void)addPoint:(NSPoint)p
+{
+	// the fitter requires uniqued data, so adjacent duplicates are dropped here
+
+	if ( NSEqualPoints( p, mPendingPoints[mPendingCount - 1] ))
+		return;
+
+	if ( mPendingCount == mPendingCapacity )
+	{
+		mPendingCapacity *= 2;
+		mPendingPoints = (NSPoint*) reallocf( mPendingPoints, sizeof( NSPoint ) * mPendingCapacity );
+	}
+
+	mPendingPoints[mPendingCount++] = p;
+
+	if ( mPendingCount >= kDKIncrementalFitWindowSize )
+		[self commitLeadingSegments];
+}
+
+- (void)addPoints:(const NSPoint*)points count:(NSUInteger)count
+{
+	NSUInteger i;
+
+	for( i = 0; i < count; ++i )
+		[self addPoint:points[i]];
+}
+
+- (NSBezierPath*)fittedPath
+{
+	NSBezierPath* result = [mCommittedPath copy];
+
+	if ( mPendingCount >= 2 )
+	{
+		Geom::Point*	data;
+		NSUInteger		i;
+
+		data = (Geom::Point*) malloc( sizeof( Geom::Point ) * mPendingCount );
+
+		for( i = 0; i < mPendingCount; ++i )
+			data[i] = Geom::Point((Geom::Coord)mPendingPoints[i].x, (Geom::Coord)mPendingPoints[i].y);
+
+		appendFittedGeomPoints( result, data, mPendingCount, Geom::Point( mStartTangent.x, mStartTangent.y ), Geom::Point( 0, 0 ), mEpsilon );
+		free( data );
+	}
+
+	return result;
+}
+
+#pragma mark -
+
+- (void)commitLeadingSegments
+{
+	// fits the leading samples of the pending window and appends the result to the committed path. The boundary
+	// sample is retained as the first sample of the new window, and the estimated tangent there is carried over
+	// so that the next fit continues smoothly from the committed segments.
+
+	NSUInteger		len = kDKIncrementalFitCommitSamples + 1;
+	Geom::Point*	data;
+	NSUInteger		i;
+
+	NSAssert( mPendingCount > len, @"too few pending samples to commit");
+
+	data = (Geom::Point*) malloc( sizeof( Geom::Point ) * len );
+
+	for( i = 0; i < len; ++i )
+		data[i] = Geom::Point((Geom::Coord)mPendingPoints[i].x, (Geom::Coord)mPendingPoints[i].y);
+
+	// the backward tangent at the cut is estimated from the samples, exactly as the fitter's recursive splitting
+	// does at an interior split point
+
+	Geom::Point const tHat2 = Geom::darray_right_tangent( data, (unsigned)len, mEpsilon );
+
+	appendFittedGeomPoints( mCommittedPath, data, len, Geom::Point( mStartTangent.x, mStartTangent.y ), tHat2, mEpsilon );
+	free( data );
+
+	mStartTangent = NSMakePoint( -tHat2[Geom::X], -tHat2[Geom::Y] );
+
+	memmove( mPendingPoints, mPendingPoints + kDKIncrementalFitCommitSamples, sizeof( NSPoint ) * ( mPendingCount - kDKIncrementalFitCommitSamples ));
+	mPendingCount -= kDKIncrementalFitCommitSamples;
+}
+
+@end
+
+
 NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon)
 {
-	// given an input path in vector form (flattened), this converts it to the C++ data structure list of points and processes it via the
-	// curve fit method in the bezier-utils lib. It then converts the result back to NSBezierPath form. Note - the caller is responsible for passing
-	// a flattened path.
+	// given an input path in vector form (flattened), this extracts its points and fits them via
+	// DKCurveFitPoints(). Note - the caller is responsible for passing a flattened path.
 	
-	Geom::Point*	pd;
 	NSInteger		ec, i;
 	NSPoint			p[3];
-	NSBezierPath*	result = [NSBezierPath bezierPath];
+	NSPoint*		pts;
+	NSBezierPath*	result;
 	
 	ec = [inPath elementCount];
 	
 	if ( ec < 3 )
 	{
+		result = [NSBezierPath bezierPath];
 		[result appendBezierPath:inPath];
 		return result;
 	}
 	
-	pd = (Geom::Point*) malloc( sizeof( Geom::Point ) * ec );
+	pts = (NSPoint*) malloc( sizeof( NSPoint ) * ec );
 	
 	for( i = 0; i < ec; ++i )
 	{
 		[inPath elementAtIndex:i associatedPoints:p];
-		pd[i] = Geom::Point((Geom::Coord)p[0].x, (Geom::Coord)p[0].y);
+		pts[i] = p[0];
 	}
 	
+	result = DKCurveFitPoints( pts, ec, epsilon );
+	free( pts );
+	
+	return result;
+}
+
+
+NSBezierPath* DKCurveFitPoints(const NSPoint* points, NSUInteger count, CGFloat epsilon)
+{
+	// fits a raw list of sample points with bezier curves - the working form of DKCurveFitPath(),
+	// usable directly by callers that already hold their samples in contiguous storage.
+	
+	Geom::Point*	pd;
+	NSUInteger		i;
+	NSBezierPath*	result = [NSBezierPath bezierPath];
+	
+	if ( count == 0 )
+		return result;
+	
+	if ( count < 3 )
+	{
+		// too few samples to fit - return them as a polyline so no input is ever lost
+		
+		[result moveToPoint:points[0]];
+		
+		for( i = 1; i < count; ++i )
+			[result lineToPoint:points[i]];
+		
+		return result;
+	}
+	
+	pd = (Geom::Point*) malloc( sizeof( Geom::Point ) * count );
+	
+	for( i = 0; i < count; ++i )
+		pd[i] = Geom::Point((Geom::Coord)points[i].x, (Geom::Coord)points[i].y);
+	
 	// converted, now try the curve fit. Note that we don't know how much space we need to store the result, and the code doesn't give
 	// us a way to find out, so we just create a big buffer and hope for the best.
 	
@@ -54,7 +268,7 @@ NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon)
 	
 	// do the fitting:
 	
-	segments = bezier_fit_cubic_r( segBuffer, pd, (int)ec, epsilon, (int)maxSegments );
+	segments = bezier_fit_cubic_r( segBuffer, pd, (int)count, epsilon, (int)maxSegments );
 	
 	if ( segments > 0 )
 	{
@@ -64,15 +278,15 @@ NSBezierPath* DKCurveFitPath(NSBezierPath* inPath, CGFloat epsilon)
 		// there is a lot of duplication).
 		
 		NSPoint temp[3];
-		NSInteger segElement;
+		NSInteger segElement, j;
 		
 		temp[0].x = segBuffer[0][Geom::X];
 		temp[0].y = segBuffer[0][Geom::Y];
 		[result moveToPoint:temp[0]];
 		
-		for( i = 0; i < segments; ++i )
+		for( j = 0; j < segments; ++j )
 		{
-			segElement = ( i * 4 ) + 1;
+			segElement = ( j * 4 ) + 1;
 			
 			temp[0].x = segBuffer[segElement][Geom::X];
 			temp[0].y = segBuffer[segElement++][Geom::Y];
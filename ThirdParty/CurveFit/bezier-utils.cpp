@@ -79,10 +79,61 @@ static double compute_max_error_ratio(Point const d[], double const u[], unsigne
                                       unsigned *splitPoint);
 static double compute_hook(Point const &a, Point const &b, double const u, BezierCurve const bezCurve,
                            double const tolerance);
+static double compute_hook_pt(Point const &a, Point const &b, Point const &P, double tolerance);
 
 
 static Point const unconstrained_tangent(0, 0);
 
+/*
+ * SIMD evaluation support.
+ *
+ * The Newton-Raphson reparameterization loop and the max-error scan evaluate the fitted cubic at one
+ * parameter value at a time through bezier_pt(), which dominates the cost of fitting long freehand
+ * strokes.  When the compiler supports GNU vector extensions (SSE2/NEON and anything newer) we instead
+ * convert the curve to power basis once and evaluate four parameter values per step with Horner's rule.
+ * Define BEZIER_UTILS_NO_SIMD to force the scalar code paths.
+ */
+#if !defined(BEZIER_UTILS_NO_SIMD) && ( defined(__clang__) || ( defined(__GNUC__) && __GNUC__ >= 5 ) )
+# define BEZIER_UTILS_USE_SIMD 1
+#else
+# define BEZIER_UTILS_USE_SIMD 0
+#endif
+
+#if BEZIER_UTILS_USE_SIMD
+
+typedef double v4df __attribute__ (( vector_size (32) ));
+
+/** Convert one coordinate of a cubic Bezier to power basis: P(t) = ((c[3]*t + c[2])*t + c[1])*t + c[0]. */
+static inline void
+bezier_power_coeffs(BezierCurve const Q, Dim2 const dim, double c[4])
+{
+    double const p0 = Q[0][dim], p1 = Q[1][dim], p2 = Q[2][dim], p3 = Q[3][dim];
+    c[0] = p0;
+    c[1] = 3.0 * ( p1 - p0 );
+    c[2] = 3.0 * ( p0 - 2.0 * p1 + p2 );
+    c[3] = p3 - p0 + 3.0 * ( p1 - p2 );
+}
+
+static inline v4df
+poly3_eval(double const c[4], v4df const t)
+{
+    return ( ( c[3] * t + c[2] ) * t + c[1] ) * t + c[0];
+}
+
+static inline v4df
+poly3_eval_d1(double const c[4], v4df const t)
+{
+    return ( 3.0 * c[3] * t + 2.0 * c[2] ) * t + c[1];
+}
+
+static inline v4df
+poly3_eval_d2(double const c[4], v4df const t)
+{
+    return 6.0 * c[3] * t + 2.0 * c[2];
+}
+
+#endif /* BEZIER_UTILS_USE_SIMD */
+
 
 /*
  *  B0, B1, B2, B3 : Bezier multipliers
@@ -107,6 +158,42 @@ static Point const unconstrained_tangent(0, 0);
 #endif
 
 
+/**
+ * Fixed-size scratch buffer with heap fallback.
+ *
+ * The freehand smoothing path calls the fitter with short windows of points, so the
+ * working buffers (the uniqued copy of the data and the parameter values) almost always
+ * fit in a small stack array; only pathological inputs pay for a heap allocation.
+ */
+#define BEZIER_SCRATCH_STACK_LEN 256
+
+template <typename T>
+class ScratchBuffer {
+    T _stack[BEZIER_SCRATCH_STACK_LEN];
+    T *_p;
+
+  public:
+    explicit ScratchBuffer(unsigned const len) {
+        _p = ( len <= BEZIER_SCRATCH_STACK_LEN
+               ? _stack
+               : new T[len] );
+    }
+
+    ~ScratchBuffer() {
+        if ( _p != _stack ) {
+            delete[] _p;
+        }
+    }
+
+    operator T*() { return _p; }
+
+  private:
+    /* not copyable */
+    ScratchBuffer(ScratchBuffer const &);
+    ScratchBuffer &operator=(ScratchBuffer const &);
+};
+
+
 /**
  * Fit a single-segment Bezier curve to a set of digitized points.
  *
@@ -136,20 +223,17 @@ bezier_fit_cubic_r(Point bezier[], Point const data[], int const len, double con
        max_beziers >= (1ul << (31 - 2 - 1 - 3))) 
         return -1;
     
-    Point *uniqued_data = new Point[len];
+    ScratchBuffer<Point> uniqued_data(len);
     unsigned uniqued_len = copy_without_nans_or_adjacent_duplicates(data, len, uniqued_data);
 
     if ( uniqued_len < 2 ) {
-        delete[] uniqued_data;
         return 0;
     }
 
     /* Call fit-cubic function with recursion. */
-    int const ret = bezier_fit_cubic_full(bezier, NULL, uniqued_data, uniqued_len,
-                                          unconstrained_tangent, unconstrained_tangent,
-                                          error, max_beziers);
-    delete[] uniqued_data;
-    return ret;
+    return bezier_fit_cubic_full(bezier, NULL, uniqued_data, uniqued_len,
+                                 unconstrained_tangent, unconstrained_tangent,
+                                 error, max_beziers);
 }
 
 /** 
@@ -238,7 +322,7 @@ bezier_fit_cubic_full(Point bezier[], int split_points[],
     unsigned splitPoint = 0;   /* Point to split point set at. */
     bool is_corner;
     {
-        double *u = new double[len];
+        ScratchBuffer<double> u(len);
         chord_length_parameterize(data, u, len);
         if ( u[len - 1] == 0.0 ) {
             /* Zero-length path: every point in data[] is the same.
@@ -246,7 +330,6 @@ bezier_fit_cubic_full(Point bezier[], int split_points[],
              * (Clients aren't allowed to pass such data; handling the case is defensive
              * programming.)
              */
-            delete[] u;
             return 0;
         }
 
@@ -259,7 +342,6 @@ bezier_fit_cubic_full(Point bezier[], int split_points[],
 
         if ( fabs(maxErrorRatio) <= 1.0 ) {
             BEZIER_ASSERT(bezier);
-            delete[] u;
             return 1;
         }
 
@@ -271,12 +353,10 @@ bezier_fit_cubic_full(Point bezier[], int split_points[],
                 maxErrorRatio = compute_max_error_ratio(data, u, len, bezier, tolerance, &splitPoint);
                 if ( fabs(maxErrorRatio) <= 1.0 ) {
                     BEZIER_ASSERT(bezier);
-                    delete[] u;
                     return 1;
                 }
             }
         }
-        delete[] u;
         is_corner = (maxErrorRatio < 0);
     }
 
@@ -560,7 +640,69 @@ reparameterize(Point const d[],
     assert( u[last] == 1.0 );
     /* Otherwise, consider including 0 and last in the below loop. */
 
-    for (unsigned i = 1; i < last; i++) {
+    unsigned i = 1;
+
+#if BEZIER_UTILS_USE_SIMD
+    /* Evaluate the Newton step for four points per iteration using the power-basis form of the curve.
+       Lanes where the fast step is inapplicable (non-positive denominator, non-finite result, or a step
+       that would move the point further from the curve) fall back to the scalar routine, which keeps the
+       safeguarded semantics of NewtonRaphsonRootFind() exactly. */
+
+    double cx[4], cy[4];
+    bezier_power_coeffs(bezCurve, X, cx);
+    bezier_power_coeffs(bezCurve, Y, cy);
+
+    for (; i + 4 <= last; i += 4) {
+        v4df const t = { u[i], u[i+1], u[i+2], u[i+3] };
+        v4df const px = { d[i][X], d[i+1][X], d[i+2][X], d[i+3][X] };
+        v4df const py = { d[i][Y], d[i+1][Y], d[i+2][Y], d[i+3][Y] };
+
+        v4df const dx = poly3_eval(cx, t) - px;
+        v4df const dy = poly3_eval(cy, t) - py;
+        v4df const q1x = poly3_eval_d1(cx, t);
+        v4df const q1y = poly3_eval_d1(cy, t);
+        v4df const q2x = poly3_eval_d2(cx, t);
+        v4df const q2y = poly3_eval_d2(cy, t);
+
+        v4df const numerator = dx * q1x + dy * q1y;
+        v4df const denominator = q1x * q1x + q1y * q1y + dx * q2x + dy * q2y;
+        v4df const old_distsq = dx * dx + dy * dy;
+        v4df improved = t - numerator / denominator;
+        bool lane_ok[4];
+
+        for (unsigned k = 0; k < 4; k++) {
+            double nu = improved[k];
+            lane_ok[k] = ( denominator[k] > 0. ) && isFinite(nu);
+
+            if (lane_ok[k]) {
+                if ( nu < 0.0 ) {
+                    nu = 0.0;
+                } else if ( nu > 1.0 ) {
+                    nu = 1.0;
+                }
+                improved[k] = nu;
+            } else {
+                improved[k] = t[k]; /* neutralize the lane for the batched distance check */
+            }
+        }
+
+        v4df const ndx = poly3_eval(cx, improved) - px;
+        v4df const ndy = poly3_eval(cy, improved) - py;
+        v4df const new_distsq = ndx * ndx + ndy * ndy;
+
+        for (unsigned k = 0; k < 4; k++) {
+            if ( lane_ok[k] && new_distsq[k] <= old_distsq[k] ) {
+                u[i + k] = improved[k];
+            } else {
+                /* zero/negative denominator, non-finite step, or a step that made things worse:
+                   take the safeguarded scalar path for this point. */
+                u[i + k] = NewtonRaphsonRootFind(bezCurve, d[i + k], u[i + k]);
+            }
+        }
+    }
+#endif /* BEZIER_UTILS_USE_SIMD */
+
+    for (; i < last; i++) {
         u[i] = NewtonRaphsonRootFind(bezCurve, d[i], u[i]);
     }
 }
@@ -925,7 +1067,44 @@ compute_max_error_ratio(Point const d[], double const u[], unsigned const len,
     double max_hook_ratio = 0.0;
     unsigned snap_end = 0;
     Point prev = bezCurve[0];
-    for (unsigned i = 1; i <= last; i++) {
+    unsigned i = 1;
+
+#if BEZIER_UTILS_USE_SIMD
+    /* Batch the curve evaluations: for each group of four data points, evaluate the curve at the
+       four parameters and at the four hook midpoints in one pass over the power-basis polynomials,
+       then run the unchanged max/split bookkeeping over the buffered points. */
+
+    double cx[4], cy[4];
+    bezier_power_coeffs(bezCurve, X, cx);
+    bezier_power_coeffs(bezCurve, Y, cy);
+
+    for (; i + 4 <= last + 1; i += 4) {
+        v4df const t = { u[i], u[i+1], u[i+2], u[i+3] };
+        v4df const tmid = { .5 * (u[i-1] + u[i]), .5 * (u[i] + u[i+1]),
+                            .5 * (u[i+1] + u[i+2]), .5 * (u[i+2] + u[i+3]) };
+        v4df const qx = poly3_eval(cx, t);
+        v4df const qy = poly3_eval(cy, t);
+        v4df const mx = poly3_eval(cx, tmid);
+        v4df const my = poly3_eval(cy, tmid);
+
+        for (unsigned k = 0; k < 4; k++) {
+            Point const curr(qx[k], qy[k]);
+            double const distsq = lensq( curr - d[i + k] );
+            if ( distsq > maxDistsq ) {
+                maxDistsq = distsq;
+                *splitPoint = i + k;
+            }
+            double const hook_ratio = compute_hook_pt(prev, curr, Point(mx[k], my[k]), tolerance);
+            if (max_hook_ratio < hook_ratio) {
+                max_hook_ratio = hook_ratio;
+                snap_end = i + k;
+            }
+            prev = curr;
+        }
+    }
+#endif /* BEZIER_UTILS_USE_SIMD */
+
+    for (; i <= last; i++) {
         Point const curr = bezier_pt(3, bezCurve, u[i]);
         double const distsq = lensq( curr - d[i] );
         if ( distsq > maxDistsq ) {
@@ -980,7 +1159,16 @@ static double
 compute_hook(Point const &a, Point const &b, double const u, BezierCurve const bezCurve,
              double const tolerance)
 {
-    Point const P = bezier_pt(3, bezCurve, u);
+    return compute_hook_pt(a, b, bezier_pt(3, bezCurve, u), tolerance);
+}
+
+/**
+ * The body of compute_hook() for a precomputed curve point \a P, allowing callers that batch
+ * their curve evaluations to reuse the criterion without re-evaluating the curve.
+ */
+static double
+compute_hook_pt(Point const &a, Point const &b, Point const &P, double const tolerance)
+{
     Point const diff = .5 * (a + b) - P;
     double const dist = L2(diff);
     if (dist < tolerance) {